@@ -0,0 +1,235 @@
+/**
+ * @file BuildModuleService.hpp
+ * @brief Process-wide access to the build module's exported functions
+ *
+ * Loads build.so once per process and resolves the functions other modules
+ * call into a typed function table, so callers no longer pay for a
+ * dlopen/dlsym/dlclose cycle on every operation.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#pragma once
+
+#include <string>
+#include <filesystem>
+#include <vector>
+#include <cstdint>
+#include <mutex>
+#include <dlfcn.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief Callback used by the build module's checksum_memory_loaded_archive_entries
+ *
+ * Must match archive_entry_checksum_callback in the build module.
+ */
+typedef int (*ArchiveEntryChecksumCallback)(const char* entry_path, const char* checksum, void* user_data);
+
+/**
+ * @brief Callback used by the build module's _multi checksum walks
+ *
+ * Must match archive_entry_checksums_callback in the build module.
+ */
+typedef int (*ArchiveEntryChecksumsCallback)(const char* entry_path, const char* const* checksums,
+                                             size_t checksum_count, void* user_data);
+
+/**
+ * @brief Callback used by the build module's read_memory_loaded_archive_entries
+ *
+ * Must match archive_entry_data_callback in the build module.
+ */
+typedef int (*ArchiveEntryDataCallback)(const char* entry_path, const unsigned char* data,
+                                        size_t data_size, void* user_data);
+
+/**
+ * @brief Callback used by the build module's take_memory_loaded_archive_entries
+ *
+ * Must match archive_entry_buffer_callback in the build module.  The callback
+ * owns the data it is given and releases it with free().
+ */
+typedef int (*ArchiveEntryBufferCallback)(const char* entry_path, unsigned char* data,
+                                          size_t data_size, void* user_data);
+
+/**
+ * @brief Allocator used by the build module's _into extraction functions
+ *
+ * Must match archive_entry_allocator in the build module.  Buffers it hands
+ * out belong to the allocator, not to the callback they are passed to.
+ */
+typedef unsigned char* (*ArchiveEntryAllocator)(size_t size, void* allocator_data);
+
+/**
+ * @brief Largest binary digest dpm_digest_buffer produces, in bytes
+ */
+#define DPM_DIGEST_MAX_SIZE 64
+
+/**
+ * @brief Entry reported by archive_iterator_next, laid out as in the build module
+ *
+ * The strings stay valid until the iterator moves on or is closed.
+ */
+struct ArchiveIteratorEntry {
+    const char* path;           ///< Path with the component directory prefix removed
+    const char* archive_path;   ///< Path as stored in the archive
+    const char* link_target;    ///< Target of a symlink or hard link, NULL for other entries
+    uint64_t size;              ///< Size of the entry data
+    uint32_t mode;              ///< File type and permission bits, as in st_mode
+    int64_t mtime;              ///< Modification time, in seconds since the epoch
+};
+
+/**
+ * @brief Typed pointers to the functions exported by the build module
+ *
+ * Every member is resolved when the build module is first loaded; a table is
+ * only handed out once all of them have been found.
+ */
+struct BuildModuleFunctions {
+    bool (*get_file_from_package_file)(const char* package_file_path, const char* file_path_in_archive,
+                                       unsigned char** data, size_t* data_size);
+    bool (*get_file_from_memory_loaded_archive)(const unsigned char* archive_data, const size_t archive_data_size,
+                                                const char* file_path_in_archive,
+                                                unsigned char** result_data, size_t* result_data_size);
+    bool (*checksum_memory_loaded_archive_entries)(const unsigned char* archive_data, const size_t archive_data_size,
+                                                   ArchiveEntryChecksumCallback callback, void* user_data);
+    bool (*read_memory_loaded_archive_entries)(const unsigned char* archive_data, const size_t archive_data_size,
+                                               ArchiveEntryDataCallback callback, void* user_data);
+    std::string (*get_configured_hash_algorithm)();
+    std::string (*generate_file_checksum)(const std::filesystem::path& file_path);
+    std::string (*generate_string_checksum)(const std::string& input_string);
+    int (*unseal_package)(const std::string& package_path, const std::string& output_dir, bool force);
+    int (*unseal_stage_components)(const std::filesystem::path& stage_dir);
+    void* (*package_reader_open)(const char* package_path);
+    bool (*package_reader_get_member)(void* reader, const char* member_name,
+                                      const unsigned char** data, size_t* data_size);
+    void (*package_reader_close)(void* reader);
+    bool (*checksum_package_component_entries)(const char* package_path, const char* component_name,
+                                               ArchiveEntryChecksumCallback callback, void* user_data);
+    bool (*read_package_component_entries)(const char* package_path, const char* component_name,
+                                           size_t max_entry_size,
+                                           ArchiveEntryDataCallback callback, void* user_data);
+    int (*verify_detached_signature_memory)(const unsigned char* data, size_t data_size,
+                                            const unsigned char* signature, size_t signature_size,
+                                            char* signer_fpr, size_t signer_fpr_size);
+    bool (*hash_algorithm_supported)(const std::string& algorithm);
+    std::vector<std::string> (*generate_file_checksums)(const std::filesystem::path& file_path,
+                                                        const std::vector<std::string>& algorithms);
+    std::vector<std::string> (*generate_buffer_checksums)(const unsigned char* data, size_t data_size,
+                                                          const std::vector<std::string>& algorithms);
+    bool (*checksum_memory_loaded_archive_entries_multi)(const unsigned char* archive_data, const size_t archive_data_size,
+                                                         const std::vector<std::string>& algorithms,
+                                                         ArchiveEntryChecksumsCallback callback, void* user_data);
+    bool (*checksum_package_component_entries_multi)(const char* package_path, const char* component_name,
+                                                     const std::vector<std::string>& algorithms,
+                                                     ArchiveEntryChecksumsCallback callback, void* user_data);
+    std::string (*generate_file_chunk_checksum)(const std::filesystem::path& file_path, uint64_t offset,
+                                                uint64_t length, const std::string& algorithm);
+    std::string (*generate_chunk_merkle_root)(const std::vector<std::string>& chunk_checksums,
+                                              const std::string& algorithm);
+    int (*digest_buffer)(const void* data, size_t size, uint8_t* out, size_t* out_len);
+    bool (*take_memory_loaded_archive_entries)(const unsigned char* archive_data, const size_t archive_data_size,
+                                               ArchiveEntryBufferCallback callback, void* user_data);
+    bool (*get_file_from_memory_loaded_archive_into)(const unsigned char* archive_data, const size_t archive_data_size,
+                                                     const char* file_path_in_archive,
+                                                     ArchiveEntryAllocator allocator, void* allocator_data,
+                                                     unsigned char** result_data, size_t* result_data_size);
+    bool (*take_memory_loaded_archive_entries_into)(const unsigned char* archive_data, const size_t archive_data_size,
+                                                    ArchiveEntryAllocator allocator, void* allocator_data,
+                                                    ArchiveEntryBufferCallback callback, void* user_data);
+    void* (*archive_iterator_open_memory)(const unsigned char* archive_data, size_t archive_data_size);
+    void* (*archive_iterator_open_file)(const char* archive_path);
+    void* (*archive_iterator_open_fd)(int fd);
+    void* (*archive_iterator_open_package_component)(const char* package_path, const char* component_name);
+    int (*archive_iterator_next)(void* iterator, ArchiveIteratorEntry* entry);
+    long long (*archive_iterator_read)(void* iterator, void* buffer, size_t buffer_size);
+    int (*archive_iterator_read_block)(void* iterator, const void** block, size_t* block_size, uint64_t* offset);
+    bool (*archive_iterator_skip)(void* iterator);
+    void (*archive_iterator_close)(void* iterator);
+    int (*install_package)(const std::string& package_path, const std::string& root_dir, bool force);
+    bool (*package_reader_get_member_size)(void* reader, const char* member_name, size_t* data_size);
+};
+
+/**
+ * @brief Checks whether a package path is the URL of a package on an HTTP or HTTPS server
+ *
+ * The build module reads such packages by byte range, so they are passed
+ * through as they are instead of being checked for on disk.
+ *
+ * @param package_path Package path or URL
+ * @return true if the path starts with http:// or https://
+ */
+inline bool dpm_package_is_url(const std::string& package_path)
+{
+    return package_path.rfind("http://", 0) == 0 || package_path.rfind("https://", 0) == 0;
+}
+
+/**
+ * @brief Loads the build module once and shares its function table
+ *
+ * The module is loaded on first use and stays loaded until the process (or
+ * the module using the service) is unloaded.  A failed load is remembered so
+ * that repeated callers do not retry and repeat the same errors.
+ */
+class BuildModuleService {
+public:
+    /**
+     * @brief Gets the process-wide service instance
+     *
+     * @return Reference to the shared service
+     */
+    static BuildModuleService& instance();
+
+    /**
+     * @brief Gets the resolved build module function table
+     *
+     * Loads the build module and resolves its symbols on the first call.
+     *
+     * @return Pointer to the function table, or nullptr if the module or any symbol could not be loaded
+     */
+    const BuildModuleFunctions* functions();
+
+    /**
+     * @brief Gets the raw handle of the loaded build module
+     *
+     * @return The dlopen handle, or nullptr if the module has not been loaded
+     */
+    void* handle();
+
+    ~BuildModuleService();
+
+    BuildModuleService(const BuildModuleService&) = delete;
+    BuildModuleService& operator=(const BuildModuleService&) = delete;
+
+private:
+    BuildModuleService();
+
+    bool load();
+
+    std::mutex _mutex;
+    void* _handle;
+    bool _attempted;
+    bool _loaded;
+    BuildModuleFunctions _functions;
+};
+
+/**
+ * @brief Convenience accessor for the build module function table
+ *
+ * @return Pointer to the function table, or nullptr if the build module is unavailable
+ */
+const BuildModuleFunctions* dpm_build_module();
+
+/**
+ * @brief Digests a buffer with the configured algorithm through the build module, in hex
+ *
+ * Hashes the data where it lies, through the build module's dpm_digest_buffer.
+ *
+ * @param build_module The build module function table
+ * @param data Data to be hashed
+ * @param size Size of the data in bytes
+ * @return Hexadecimal digest, or an empty string on error
+ */
+std::string dpm_digest_buffer_hex(const BuildModuleFunctions* build_module, const void* data, size_t size);
@@ -29,7 +29,10 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <sys/stat.h>
 #include <dlfcn.h>
@@ -109,6 +112,17 @@ extern "C" {
      * @return A string containing the module's description
      */
     const char* dpm_get_description(void);
+
+    /**
+     * @brief Optional module preload function
+     *
+     * Modules may implement this to prepare what they keep between the
+     * invocations of a resident dpmd, such as hash engines or GPGME.  dpmd
+     * calls it once after loading the module.
+     *
+     * @return 0 on success, non-zero on failure
+     */
+    int dpm_module_preload(void);
 }
 
 // DPM core functions available for modules to call
@@ -124,6 +138,19 @@ extern "C" {
      */
     const char* dpm_get_config(const char* section, const char* key);
 
+    /**
+     * @brief Configuration key resolution function
+     *
+     * Resolves a section and key once to a handle that reads the key's
+     * current value with no lookup, for configuration read on hot paths.
+     * The handle stays valid for the life of the process.
+     *
+     * @param section The configuration section name
+     * @param key The configuration key within the section
+     * @return Handle to the value, or NULL if key is NULL
+     */
+    const char* const* dpm_config_resolve(const char* section, const char* key);
+
     /**
      * @brief Logging function
      *
@@ -145,6 +172,17 @@ extern "C" {
      */
     void dpm_con(int level, const char* message);
 
+    /**
+     * @brief Checks whether messages of a log level are logged
+     *
+     * Lets modules skip building a message that the configured log level
+     * would discard.  DPM_LOG and DPM_CON check it before they build one.
+     *
+     * @param level The log level (LOG_FATAL, LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG)
+     * @return 1 if messages of the level are logged, 0 otherwise
+     */
+    int dpm_log_enabled(int level);
+
     /**
      * @brief Sets the logging level
      *
@@ -164,8 +202,339 @@ extern "C" {
      * @return The module path
      */
     const char* dpm_get_module_path(void);
+
+    /**
+     * @brief Loads a module through the DPM core's module registry
+     *
+     * Returns the handle the DPM core already holds for the module, opening
+     * and validating it first if nothing has loaded it yet this run.  The
+     * handle carries a reference of its own, released with dpm_unload_module.
+     *
+     * @param module_name Name of the module to load
+     * @param module_handle Pointer to store the module handle
+     * @return 0 on success, non-zero on failure
+     */
+    int dpm_acquire_module(const char* module_name, void** module_handle);
+
+    /**
+     * @brief Set of tasks on the shared worker pool that are waited for together
+     */
+    typedef struct dpm_task_group dpm_task_group;
+
+    /**
+     * @brief Function run as a task, with the context it was submitted with
+     */
+    typedef void (*dpm_task_function)(void* context);
+
+    /**
+     * @brief Function run over a part of a range by dpm_parallel_for
+     */
+    typedef void (*dpm_range_function)(void* context, size_t begin, size_t end);
+
+    /**
+     * @brief Creates a group to submit tasks to the shared worker pool under
+     *
+     * The DPM core owns one pool of worker threads, sized by
+     * [performance] worker_threads, that every module shares.
+     *
+     * @return The new group, released with dpm_task_group_destroy
+     */
+    dpm_task_group* dpm_task_group_create(void);
+
+    /**
+     * @brief Waits for a group's tasks and releases the group
+     *
+     * @param group Group from dpm_task_group_create
+     */
+    void dpm_task_group_destroy(dpm_task_group* group);
+
+    /**
+     * @brief Queues a task on the shared worker pool
+     *
+     * @param group Group to wait for the task with, or NULL to not wait for it
+     * @param function Function to run on a worker thread
+     * @param context Argument to pass to the function
+     */
+    void dpm_submit_task(dpm_task_group* group, dpm_task_function function, void* context);
+
+    /**
+     * @brief Waits until every task submitted to a group has finished
+     *
+     * The calling thread runs queued tasks while it waits, so tasks may
+     * submit tasks of their own and wait for them.
+     *
+     * @param group Group to wait for
+     */
+    void dpm_wait_group(dpm_task_group* group);
+
+    /**
+     * @brief Runs a function over a range on the shared worker pool
+     *
+     * Returns once the whole range has been run.  The calling thread runs
+     * parts of the range too.
+     *
+     * @param begin First index of the range
+     * @param end One past the last index of the range
+     * @param grain Smallest number of indices given to one call, 0 picks one
+     * @param function Function to run over each part of the range
+     * @param context Argument to pass to the function
+     */
+    void dpm_parallel_for(size_t begin, size_t end, size_t grain, dpm_range_function function, void* context);
+
+    /**
+     * @brief Gets the number of threads of the shared worker pool
+     *
+     * Modules use it as their default degree of parallelism.
+     *
+     * @return [performance] worker_threads when set, otherwise the CPUs available to the process
+     */
+    size_t dpm_worker_threads(void);
+
+    /**
+     * @brief Checks whether the invocation is being profiled with --profile
+     *
+     * @return 1 if phases are being collected, 0 otherwise
+     */
+    int dpm_profile_enabled(void);
+
+    /**
+     * @brief Opens a profiled phase on the calling thread
+     *
+     * A phase opened while another is open on the same thread is reported
+     * inside it.  Modules normally use DpmProfileScope instead.
+     *
+     * @param name Name of the phase, a string literal
+     * @return Scope to close the phase with, -1 when profiling is disabled
+     */
+    int dpm_profile_begin(const char* name);
+
+    /**
+     * @brief Closes a profiled phase
+     *
+     * @param scope Scope returned by dpm_profile_begin on the same thread
+     * @param bytes Bytes handled by the phase
+     * @param files Files handled by the phase
+     */
+    void dpm_profile_end(int scope, uint64_t bytes, uint64_t files);
+
+    /**
+     * @brief Adds to a counter exported with --metrics-file
+     *
+     * Each thread adds to a total of its own, so counting from hot loops
+     * takes no lock.  Does nothing unless the invocation exports metrics.
+     *
+     * @param name Name of the counter, a Prometheus metric name such as DPM_METRIC_BYTES_HASHED
+     * @param value Amount to add
+     */
+    void dpm_metric_add(const char* name, uint64_t value);
+
+    /**
+     * @brief Records one value of an observation exported with --metrics-file
+     *
+     * The count, sum and largest of the observed values are exported.
+     *
+     * @param name Name of the observation, a Prometheus metric name
+     * @param value The observed value
+     */
+    void dpm_metric_observe(const char* name, double value);
 }
 
+/**
+ * @brief Bytes hashed, counted once however many algorithms hash them
+ */
+#define DPM_METRIC_BYTES_HASHED "dpm_bytes_hashed_total"
+
+/**
+ * @brief Bytes of file data written into compressed archives
+ */
+#define DPM_METRIC_BYTES_COMPRESSED "dpm_bytes_compressed_total"
+
+/**
+ * @brief Bytes of entry data read out of compressed archives
+ */
+#define DPM_METRIC_BYTES_DECOMPRESSED "dpm_bytes_decompressed_total"
+
+/**
+ * @brief Archive entries whose headers were read
+ */
+#define DPM_METRIC_ARCHIVE_ENTRIES "dpm_archive_entries_scanned_total"
+
+/**
+ * @brief Files whose checksums were taken from the stat cache instead of hashing them
+ */
+#define DPM_METRIC_STAT_CACHE_HITS "dpm_stat_cache_hits_total"
+
+/**
+ * @brief Files hashed because the stat cache had no usable checksum for them
+ */
+#define DPM_METRIC_STAT_CACHE_MISSES "dpm_stat_cache_misses_total"
+
+/**
+ * @brief Packages skipped because the verify cache recorded them as verified
+ */
+#define DPM_METRIC_VERIFY_CACHE_HITS "dpm_verify_cache_hits_total"
+
+/**
+ * @brief Packages verified because the verify cache had no entry for them
+ */
+#define DPM_METRIC_VERIFY_CACHE_MISSES "dpm_verify_cache_misses_total"
+
+/**
+ * @brief Packages and stages that failed verification
+ */
+#define DPM_METRIC_VERIFY_FAILURES "dpm_verification_failures_total"
+
+/**
+ * @brief Seconds taken to verify each package, an observation
+ */
+#define DPM_METRIC_VERIFY_SECONDS "dpm_verify_package_seconds"
+
+/**
+ * @brief Handle to a configuration value, from dpm_config_resolve
+ */
+typedef const char* const* dpm_config_handle;
+
+/**
+ * @brief Reads the current value behind a configuration handle
+ *
+ * @param handle Handle from dpm_config_resolve
+ * @return The configuration value, or NULL if the key is not set
+ */
+inline const char* dpm_config_value(dpm_config_handle handle) {
+    return handle ? *handle : nullptr;
+}
+
+/**
+ * @brief Builds a log message from its parts
+ *
+ * Each part is written as it would be to a std::ostream, so strings,
+ * numbers and paths can be mixed without converting them first.
+ *
+ * @param parts The parts of the message, in order
+ * @return The message
+ */
+template <typename... Parts>
+std::string dpm_log_message(const Parts&... parts) {
+    std::ostringstream message;
+    (message << ... << parts);
+    return message.str();
+}
+
+/**
+ * @brief Logs a message built from its parts, if its level is logged
+ *
+ * The parts are neither evaluated nor joined when the configured log
+ * level discards the message, so DEBUG messages cost one call to
+ * dpm_log_enabled when debugging is off:
+ *
+ *     DPM_LOG(LOG_DEBUG, "Read ", size, " bytes of ", path);
+ *
+ * @param level The log level (LOG_FATAL, LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG)
+ */
+#define DPM_LOG(level, ...) \
+    do { \
+        if (dpm_log_enabled(level)) { \
+            dpm_log((level), dpm_log_message(__VA_ARGS__).c_str()); \
+        } \
+    } while (0)
+
+/**
+ * @brief Logs a message built from its parts to the console only, if its level is logged
+ *
+ * @param level The log level (LOG_FATAL, LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG)
+ */
+#define DPM_CON(level, ...) \
+    do { \
+        if (dpm_log_enabled(level)) { \
+            dpm_con((level), dpm_log_message(__VA_ARGS__).c_str()); \
+        } \
+    } while (0)
+
+/**
+ * @brief Runs a callable over a range on the shared worker pool
+ *
+ * The callable is called as body(begin, end) for parts of the range, from
+ * several threads at once, and must not throw.
+ *
+ * @param begin First index of the range
+ * @param end One past the last index of the range
+ * @param grain Smallest number of indices given to one call, 0 picks one
+ * @param body Callable run over each part of the range
+ */
+template <typename Body>
+void dpm_parallel_for_each(size_t begin, size_t end, size_t grain, Body&& body) {
+    auto* target = &body;
+    dpm_parallel_for(begin, end, grain, [](void* context, size_t part_begin, size_t part_end) {
+        (*static_cast<decltype(target)>(context))(part_begin, part_end);
+    }, const_cast<void*>(static_cast<const void*>(target)));
+}
+
+/**
+ * @class DpmProfileScope
+ * @brief Profiled phase that lasts as long as the object
+ *
+ *     DpmProfileScope profile("generate_file_checksum");
+ *     if (profile.active()) {
+ *         profile.add_bytes(file_size);
+ *     }
+ *
+ * Counts are only worth gathering when active() is true; when the
+ * invocation is not profiled the phase costs one call into the core.
+ */
+class DpmProfileScope {
+public:
+    /**
+     * @brief Opens the phase
+     *
+     * @param name Name of the phase, a string literal
+     */
+    explicit DpmProfileScope(const char* name)
+        : _scope(dpm_profile_begin(name)), _bytes(0), _files(0) {
+    }
+
+    /**
+     * @brief Closes the phase with the counts added to it
+     */
+    ~DpmProfileScope() {
+        dpm_profile_end(_scope, _bytes, _files);
+    }
+
+    DpmProfileScope(const DpmProfileScope&) = delete;
+    DpmProfileScope& operator=(const DpmProfileScope&) = delete;
+
+    /**
+     * @brief Checks whether the phase is being collected
+     *
+     * @return true when the invocation is profiled
+     */
+    bool active() const {
+        return _scope >= 0;
+    }
+
+    /**
+     * @brief Adds to the bytes handled by the phase
+     *
+     * @param bytes Number of bytes
+     */
+    void add_bytes(uint64_t bytes) {
+        _bytes += bytes;
+    }
+
+    /**
+     * @brief Adds to the files handled by the phase
+     *
+     * @param files Number of files
+     */
+    void add_files(uint64_t files) {
+        _files += files;
+    }
+
+private:
+    int _scope;
+    uint64_t _bytes;
+    uint64_t _files;
+};
+
 /**
  * @brief DPM core version definition
  *
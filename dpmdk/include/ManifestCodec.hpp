@@ -0,0 +1,185 @@
+/**
+ * @file ManifestCodec.hpp
+ * @brief Reader and writer of CONTENTS_MANIFEST_DIGEST and HOOKS_DIGEST lines
+ *
+ * A contents manifest line is "C checksum permissions owner:group /path":
+ * a control designation, the hex digest of the file, its octal permission
+ * bits, its owner and group, and its path.  A HOOKS_DIGEST line is
+ * "checksum name".  Every module reading or writing either file goes
+ * through this codec, so they cannot drift apart on the format.
+ *
+ * Lines are parsed into views of the line itself without allocating.  A
+ * line in the form the codec writes, single spaces, a hex digest of the
+ * expected length and four octal permission digits, is split at fixed
+ * offsets; anything else falls back to splitting on whitespace, which
+ * accepts every line the stream extraction used before accepted and splits
+ * it the same way.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Characters of the permissions field the codec writes, four octal digits
+ */
+#define MANIFEST_PERMISSIONS_LENGTH 4
+
+/**
+ * @brief Hex digest length of a digest algorithm
+ */
+struct ManifestDigestLength {
+    std::string_view algorithm;     ///< Name of the algorithm, lower case
+    size_t hex_length;              ///< Characters of its hex digest
+};
+
+/**
+ * @brief Hex digest lengths of the algorithms manifests are commonly written with
+ */
+inline constexpr ManifestDigestLength MANIFEST_DIGEST_LENGTHS[] = {
+    { "md5", 32 },
+    { "sha1", 40 },
+    { "ripemd160", 40 },
+    { "sha224", 56 },
+    { "sha256", 64 },
+    { "sha384", 96 },
+    { "sha512", 128 },
+    { "sha512-224", 56 },
+    { "sha512-256", 64 },
+    { "sha3-224", 56 },
+    { "sha3-256", 64 },
+    { "sha3-384", 96 },
+    { "sha3-512", 128 },
+    { "blake2s256", 64 },
+    { "blake2b512", 128 },
+    { "blake3", 64 },
+    { "sm3", 64 },
+};
+
+/**
+ * @brief Gets the hex digest length of an algorithm
+ *
+ * @param algorithm Name of the algorithm, in any case
+ * @return Characters of its hex digest, or 0 for an algorithm not in the table
+ */
+constexpr size_t manifest_digest_length(std::string_view algorithm)
+{
+    for (const ManifestDigestLength& known : MANIFEST_DIGEST_LENGTHS) {
+        if (known.algorithm.size() != algorithm.size()) {
+            continue;
+        }
+        bool same = true;
+        for (size_t i = 0; i < algorithm.size() && same; i++) {
+            char c = algorithm[i];
+            same = (c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c) == known.algorithm[i];
+        }
+        if (same) {
+            return known.hex_length;
+        }
+    }
+    return 0;
+}
+
+static_assert(manifest_digest_length("sha256") == 64, "sha256 digests are 64 hex characters");
+static_assert(manifest_digest_length("SHA512") == 128, "algorithm names match in any case");
+static_assert(manifest_digest_length("unknown") == 0, "unknown algorithms have no fixed length");
+
+/**
+ * @brief One line of a contents manifest, as views into the line
+ */
+struct ManifestLine {
+    char control = 0;                   ///< Control designation, 'C' for controlled files
+    std::string_view checksum;          ///< Hexadecimal checksum
+    std::string_view permissions;       ///< Octal permission bits
+    std::string_view ownership;         ///< owner:group
+    std::string_view path;              ///< Rest of the line, the path with its leading slash
+};
+
+/**
+ * @brief Takes the next line off a buffer, as std::getline would
+ *
+ * @param remaining Rest of the buffer, advanced past the line and its newline
+ * @param line Receives the line without its newline
+ * @return true if a line was taken, false at the end of the buffer
+ */
+bool manifest_next_line(std::string_view& remaining, std::string_view& line);
+
+/**
+ * @brief Splits a line of the contents manifest into its fields
+ *
+ * @param line Manifest line, "C checksum permissions owner:group /path"
+ * @param entry Receives views of the fields into line
+ * @param digest_length Expected length of the checksum, 0 when it is not known
+ * @return true if every field is present, false if the line is malformed
+ */
+bool manifest_parse_line(std::string_view line, ManifestLine& entry, size_t digest_length = 0);
+
+/**
+ * @brief Gets the path of a manifest line without its leading slash
+ *
+ * @param path Path field of a manifest line
+ * @return The path relative to the contents directory
+ */
+inline std::string_view manifest_relative_path(std::string_view path)
+{
+    return !path.empty() && path[0] == '/' ? path.substr(1) : path;
+}
+
+/**
+ * @brief Reads the permission bits of a manifest line
+ *
+ * @param permissions Permissions field of a manifest line
+ * @param mode Receives the permission bits
+ * @return true if the field is an octal number of at most 07777, false otherwise
+ */
+bool manifest_parse_permissions(std::string_view permissions, uint32_t& mode);
+
+/**
+ * @brief Formats permission bits as the permissions field of a manifest line
+ *
+ * @param mode Mode of the file, only its permission bits are kept
+ * @param buffer Receives the four octal digits
+ * @return View of the digits in buffer
+ */
+std::string_view manifest_format_permissions(uint32_t mode, char (&buffer)[MANIFEST_PERMISSIONS_LENGTH + 1]);
+
+/**
+ * @brief Appends a line to a contents manifest
+ *
+ * @param manifest Manifest being written
+ * @param control Control designation
+ * @param checksum Hexadecimal checksum
+ * @param permissions Octal permission bits
+ * @param ownership owner:group
+ * @param relative_path Path relative to the contents directory, written with a leading slash
+ */
+void manifest_append_line(std::string& manifest, char control, std::string_view checksum,
+                          std::string_view permissions, std::string_view ownership, std::string_view relative_path);
+
+/**
+ * @brief Splits a HOOKS_DIGEST line into its fields
+ *
+ * @param line Digest line, "checksum name"
+ * @param checksum Receives a view of the checksum
+ * @param name Receives a view of the hook file name
+ * @return true if both fields are present, false if the line is malformed
+ */
+bool hooks_digest_parse_line(std::string_view line, std::string_view& checksum, std::string_view& name);
+
+/**
+ * @brief Appends a line to a HOOKS_DIGEST
+ *
+ * @param digest Digest being written
+ * @param checksum Hexadecimal checksum of the hook
+ * @param name File name of the hook
+ */
+void hooks_digest_append_line(std::string& digest, std::string_view checksum, std::string_view name);
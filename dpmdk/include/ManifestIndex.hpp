@@ -0,0 +1,211 @@
+/**
+ * @file ManifestIndex.hpp
+ * @brief Binary index of CONTENTS_MANIFEST_DIGEST
+ *
+ * The text manifest stays the canonical, signed record of a package's
+ * contents.  Next to it the build module writes CONTENTS_MANIFEST_INDEX, the
+ * same entries in a form that can be mapped into memory and searched
+ * without parsing: a fixed-width record per entry sorted by path, a string
+ * pool holding the paths and owners, and every digest as raw bytes.  The
+ * index records the size and digest of the manifest it was built from, and
+ * readers only use it when those match the manifest they hold, so a stale
+ * or altered index is ignored instead of trusted.
+ *
+ * All integers are little-endian and strings are an offset and length in
+ * the pool, which is not terminated.  The file is laid out as:
+ *
+ *     header      "DPMMIDX1", u32 entry_count, u32 digest_size, u64 manifest_size,
+ *                 u64 pool_size, string algorithm, string manifest digest, zero padding
+ *     records     entry_count records, sorted by path bytes:
+ *                 string path, string owner:group, u32 mode, u32 line number, u8 control, zero padding
+ *     digests     entry_count digests of digest_size bytes, in record order
+ *     pool        the strings
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dpmdk/include/ManifestCodec.hpp>
+
+/**
+ * @brief Name of the metadata file holding the binary manifest index
+ */
+#define CONTENTS_MANIFEST_INDEX_FILENAME "CONTENTS_MANIFEST_INDEX"
+
+/**
+ * @brief Size of the index header, in bytes
+ */
+#define MANIFEST_INDEX_HEADER_SIZE 64
+
+/**
+ * @brief Size of one index record, in bytes
+ */
+#define MANIFEST_INDEX_RECORD_SIZE 32
+
+/**
+ * @brief Largest digest the index holds, in bytes
+ */
+#define MANIFEST_INDEX_MAX_DIGEST_SIZE 64
+
+/**
+ * @brief One manifest entry handed to manifest_index_build
+ */
+struct ManifestIndexSource {
+    char control;               ///< Control designation, 'C' for controlled files
+    std::string checksum;       ///< Hexadecimal checksum
+    std::string permissions;    ///< Octal permission bits
+    std::string ownership;      ///< owner:group
+    std::string path;           ///< Path relative to the contents directory, without the leading slash
+    uint32_t line_number;       ///< Line of the entry in the manifest, counting from 1
+};
+
+/**
+ * @brief One entry of a mapped index, pointing into the index data
+ */
+struct ManifestIndexEntry {
+    std::string_view path;          ///< Path relative to the contents directory
+    std::string_view ownership;     ///< owner:group
+    const unsigned char* digest;    ///< Raw digest of digest_size bytes
+    size_t digest_size;             ///< Size of digest in bytes
+    uint32_t mode;                  ///< Permission bits
+    uint32_t line_number;           ///< Line of the entry in the manifest, counting from 1
+    char control;                   ///< Control designation
+
+    /**
+     * @brief Formats the digest as the manifest records it
+     *
+     * @return Lowercase hexadecimal digest
+     */
+    std::string checksum() const;
+};
+
+/**
+ * @brief Builds the index of a manifest
+ *
+ * @param entries Entries in manifest order
+ * @param algorithm Algorithm of the checksums
+ * @param manifest_size Size of the manifest text in bytes
+ * @param manifest_digest Checksum of the manifest text with the same algorithm
+ * @param index Receives the index
+ * @return true on success, false if the entries cannot be indexed (malformed or duplicate)
+ */
+bool manifest_index_build(const std::vector<ManifestIndexSource>& entries, const std::string& algorithm,
+                          uint64_t manifest_size, const std::string& manifest_digest, std::string& index);
+
+/**
+ * @brief Read-only view of an index in memory or mapped from a file
+ */
+class ManifestIndex {
+public:
+    ManifestIndex();
+    ~ManifestIndex();
+
+    ManifestIndex(const ManifestIndex&) = delete;
+    ManifestIndex& operator=(const ManifestIndex&) = delete;
+
+    /**
+     * @brief Maps an index file
+     *
+     * @param path Path of the index file
+     * @return true if the file was mapped and is a valid index, false otherwise
+     */
+    bool open(const std::filesystem::path& path);
+
+    /**
+     * @brief Uses an index already in memory, which must outlive the view
+     *
+     * @param data Index data
+     * @param size Size of the index data in bytes
+     * @return true if the data is a valid index, false otherwise
+     */
+    bool attach(const void* data, size_t size);
+
+    /**
+     * @brief Checks whether the index was built from a manifest
+     *
+     * @param manifest_size Size of the manifest text in bytes
+     * @param manifest_digest Checksum of the manifest text with algorithm()
+     * @return true if the index describes exactly that manifest
+     */
+    bool matches(uint64_t manifest_size, const std::string& manifest_digest) const;
+
+    /**
+     * @brief Gets the algorithm of the digests
+     *
+     * @return Algorithm name, empty if no index is loaded
+     */
+    std::string_view algorithm() const;
+
+    /**
+     * @brief Gets the number of entries
+     *
+     * @return Number of entries, 0 if no index is loaded
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets an entry by its position in path order
+     *
+     * @param position Position, less than size()
+     * @return The entry
+     */
+    ManifestIndexEntry entry(size_t position) const;
+
+    /**
+     * @brief Looks up an entry by path with a binary search
+     *
+     * @param path Path relative to the contents directory, with or without a leading slash
+     * @param entry Receives the entry
+     * @return true if the path is in the index, false otherwise
+     */
+    bool find(std::string_view path, ManifestIndexEntry& entry) const;
+
+    /**
+     * @brief Finds the first entry whose path is not less than a path, for walking a subtree
+     *
+     * @param path Path relative to the contents directory, with or without a leading slash
+     * @return Position of the entry, size() if every path is less
+     */
+    size_t lower_bound(std::string_view path) const;
+
+    /**
+     * @brief Gets the size of the manifest the index was built from
+     *
+     * @return Size of the manifest text in bytes, 0 if no index is loaded
+     */
+    uint64_t manifest_size() const;
+
+private:
+    void close();
+
+    const unsigned char* _data;
+    size_t _size;
+    void* _mapping;
+    size_t _mapping_size;
+    uint32_t _entry_count;
+    uint32_t _digest_size;
+    uint64_t _manifest_size;
+    uint64_t _records_offset;
+    uint64_t _digests_offset;
+    uint64_t _pool_offset;
+    uint64_t _pool_size;
+    std::string_view _algorithm;
+    std::string_view _manifest_digest;
+};
@@ -0,0 +1,82 @@
+/**
+ * @file MetadataModel.hpp
+ * @brief In-memory view of the metadata of a package stage
+ *
+ * Each file in a stage's metadata directory is one field, named after the
+ * file and holding its whole content.  The model reads the fields once so
+ * that the code sealing, refreshing and verifying a stage can share them
+ * instead of each opening the same files again.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#pragma once
+
+#include <string>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief Metadata fields of a package stage, keyed by file name
+ */
+class MetadataModel {
+public:
+    /**
+     * @brief Reads every field in a metadata directory
+     *
+     * Replaces whatever the model held.  Temporary files left by an
+     * interrupted write end in ".tmp" and are not fields.
+     *
+     * @param metadata_dir Metadata directory of the stage
+     * @return true on success, false if the directory or one of its files could not be read
+     */
+    bool load(const std::filesystem::path& metadata_dir);
+
+    /**
+     * @brief Reads one field from a metadata directory into the model
+     *
+     * @param metadata_dir Metadata directory of the stage
+     * @param key Name of the field
+     * @return true if the field was read, false if it does not exist or could not be read
+     */
+    bool load_field(const std::filesystem::path& metadata_dir, const std::string& key);
+
+    /**
+     * @brief Looks up a field
+     *
+     * @param key Name of the field
+     * @return The content of the field, or NULL if the model does not hold it
+     */
+    const std::string* find(const std::string& key) const;
+
+    /**
+     * @brief Sets a field in the model only, nothing is written
+     *
+     * @param key Name of the field
+     * @param value New content of the field
+     */
+    void set(const std::string& key, const std::string& value);
+
+    /**
+     * @brief Drops a field from the model only, nothing is removed
+     *
+     * @param key Name of the field
+     */
+    void remove(const std::string& key);
+
+    /**
+     * @brief Gets every field held by the model
+     *
+     * @return Fields keyed by name
+     */
+    const std::map<std::string, std::string>& fields() const;
+
+private:
+    std::map<std::string, std::string> _fields;
+};
@@ -29,7 +29,9 @@ bool dpm_module_exists(const char* module_name);
 /**
  * @brief Loads a DPM module
  *
- * Attempts to load a module from the configured module path.
+ * Attempts to load a module from the configured module path.  The core's
+ * module registry opens and validates each module once per run, so this
+ * returns the handle the core already holds when the module is loaded.
  *
  * @param module_name Name of the module to load
  * @param module_handle Pointer to store the loaded module handle
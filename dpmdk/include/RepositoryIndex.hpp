@@ -0,0 +1,176 @@
+/**
+ * @file RepositoryIndex.hpp
+ * @brief Binary catalog of the packages in a repository directory
+ *
+ * A repository serving many packages needs their names, versions,
+ * architectures and digests without opening each package for every query.
+ * The repository index records them once per package in a form that can be
+ * mapped into memory and searched without parsing: a fixed-width record per
+ * package sorted by path, and a string pool holding the text fields.  Each
+ * record also keeps the size, modification time and inode of the package
+ * file it was read from, so an update only reads the packages that are new
+ * or have changed since.
+ *
+ * All integers are little-endian and strings are an offset and length in
+ * the pool, which is not terminated.  The file is laid out as:
+ *
+ *     header      "DPMRIDX1", u32 package_count, u32 record_size, u64 pool_size, zero padding
+ *     records     package_count records, sorted by path bytes:
+ *                 string path, string name, string version, string architecture,
+ *                 string package digest, string dependencies,
+ *                 u64 file size, u64 mtime in nanoseconds, u64 inode,
+ *                 u64 contents size, u64 hooks size, u64 metadata size
+ *     pool        the strings
+ *
+ * Paths are relative to the directory the index describes.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Name of the index file written into a repository directory by default
+ */
+#define REPOSITORY_INDEX_FILENAME "DPM_REPOSITORY_INDEX"
+
+/**
+ * @brief Size of the index header, in bytes
+ */
+#define REPOSITORY_INDEX_HEADER_SIZE 32
+
+/**
+ * @brief Size of one index record, in bytes
+ */
+#define REPOSITORY_INDEX_RECORD_SIZE 96
+
+/**
+ * @brief One package handed to repository_index_build
+ */
+struct RepositoryIndexSource {
+    std::string path;           ///< Path of the package file relative to the repository directory
+    std::string name;           ///< NAME from the package metadata
+    std::string version;        ///< VERSION from the package metadata
+    std::string architecture;   ///< ARCHITECTURE from the package metadata
+    std::string package_digest; ///< PACKAGE_DIGEST from the package metadata
+    std::string dependencies;   ///< DEPENDENCIES from the package metadata, as recorded
+    uint64_t file_size;         ///< Size of the package file in bytes
+    uint64_t mtime_ns;          ///< Modification time of the package file, in nanoseconds since the epoch
+    uint64_t inode;             ///< Inode of the package file
+    uint64_t contents_size;     ///< Size of the sealed contents component in bytes
+    uint64_t hooks_size;        ///< Size of the sealed hooks component in bytes
+    uint64_t metadata_size;     ///< Size of the sealed metadata component in bytes
+};
+
+/**
+ * @brief One package of a mapped index, pointing into the index data
+ */
+struct RepositoryIndexEntry {
+    std::string_view path;              ///< Path of the package file relative to the repository directory
+    std::string_view name;              ///< Package name
+    std::string_view version;           ///< Package version
+    std::string_view architecture;      ///< Package architecture
+    std::string_view package_digest;    ///< PACKAGE_DIGEST of the package
+    std::string_view dependencies;      ///< DEPENDENCIES of the package
+    uint64_t file_size;                 ///< Size of the package file in bytes
+    uint64_t mtime_ns;                  ///< Modification time of the package file, in nanoseconds
+    uint64_t inode;                     ///< Inode of the package file
+    uint64_t contents_size;             ///< Size of the sealed contents component in bytes
+    uint64_t hooks_size;                ///< Size of the sealed hooks component in bytes
+    uint64_t metadata_size;             ///< Size of the sealed metadata component in bytes
+
+    /**
+     * @brief Copies the entry out of the index
+     *
+     * @return The same package as a source for repository_index_build
+     */
+    RepositoryIndexSource source() const;
+};
+
+/**
+ * @brief Builds a repository index
+ *
+ * @param packages Packages in any order
+ * @param index Receives the index
+ * @return true on success, false if the packages cannot be indexed (empty or duplicate paths)
+ */
+bool repository_index_build(const std::vector<RepositoryIndexSource>& packages, std::string& index);
+
+/**
+ * @brief Read-only view of a repository index mapped from a file
+ */
+class RepositoryIndex {
+public:
+    RepositoryIndex();
+    ~RepositoryIndex();
+
+    RepositoryIndex(const RepositoryIndex&) = delete;
+    RepositoryIndex& operator=(const RepositoryIndex&) = delete;
+
+    /**
+     * @brief Maps an index file
+     *
+     * @param path Path of the index file
+     * @return true if the file was mapped and is a valid index, false otherwise
+     */
+    bool open(const std::filesystem::path& path);
+
+    /**
+     * @brief Uses an index already in memory, which must outlive the view
+     *
+     * @param data Index data
+     * @param size Size of the index data in bytes
+     * @return true if the data is a valid index, false otherwise
+     */
+    bool attach(const void* data, size_t size);
+
+    /**
+     * @brief Gets the number of packages
+     *
+     * @return Number of packages, 0 if no index is loaded
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets a package by its position in path order
+     *
+     * @param position Position, less than size()
+     * @return The package
+     */
+    RepositoryIndexEntry entry(size_t position) const;
+
+    /**
+     * @brief Looks up a package by path with a binary search
+     *
+     * @param path Path of the package file relative to the repository directory
+     * @param entry Receives the package
+     * @return true if the path is in the index, false otherwise
+     */
+    bool find(std::string_view path, RepositoryIndexEntry& entry) const;
+
+private:
+    void close();
+
+    const unsigned char* _data;
+    size_t _size;
+    void* _mapping;
+    size_t _mapping_size;
+    uint32_t _package_count;
+    uint64_t _pool_offset;
+};
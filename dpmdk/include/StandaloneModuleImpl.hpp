@@ -33,6 +33,9 @@
 #include <iostream>
 #include <string>
 #include <cstdlib>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <sys/stat.h>
 #include <dlfcn.h>
 
@@ -69,6 +72,14 @@ inline void dpm_con(int level, const char* message) {
     std::cout << "[" << level_str << "] " << message << std::endl;
 }
 
+/**
+ * @brief Standalone implementation of dpm_log_enabled
+ */
+inline int dpm_log_enabled(int level) {
+    // standalone executions have maximum verbosity
+    return 1;
+}
+
 /**
  * @brief Standalone implementation of dpm_get_config
  */
@@ -83,6 +94,24 @@ inline const char* dpm_get_config(const char* section, const char* key) {
     return env_value; // Will be null if env var doesn't exist
 }
 
+/**
+ * @brief Standalone implementation of dpm_config_resolve
+ */
+inline const char* const* dpm_config_resolve(const char* section, const char* key) {
+    if (!key) return nullptr;
+
+    // one slot per key, holding the environment variable's value when first resolved
+    static std::mutex slots_mutex;
+    static std::map<std::string, const char*> slots;
+    std::lock_guard<std::mutex> lock(slots_mutex);
+    std::string env_name = std::string(section ? section : "MAIN") + "_" + std::string(key);
+    auto inserted = slots.emplace(env_name, nullptr);
+    if (inserted.second) {
+        inserted.first->second = getenv(env_name.c_str());
+    }
+    return &inserted.first->second;
+}
+
 /**
  * @brief Standalone implementation of dpm_set_logging_level
  */
@@ -99,6 +128,16 @@ inline const char* dpm_get_module_path(void) {
     return env_path ? env_path : "/usr/lib/dpm/modules/";
 }
 
+/**
+ * @brief Standalone implementation of dpm_acquire_module
+ */
+inline int dpm_acquire_module(const char* module_name, void** module_handle) {
+    // there is no core registry, so open the module directly
+    std::string module_file = std::string(dpm_get_module_path()) + "/" + module_name + ".so";
+    *module_handle = dlopen(module_file.c_str(), RTLD_LAZY);
+    return *module_handle ? 0 : 1;
+}
+
 /**
  * @brief Standalone module main function
  *
@@ -120,4 +159,90 @@ int main(int argc, char** argv) { \
     \
     return dpm_module_execute(command, argc, argv); \
 }
-/* End of file */
\ No newline at end of file
+/* End of file */
+
+/**
+ * @brief Standalone definition of a task group, whose tasks have always finished
+ */
+struct dpm_task_group {
+    int unused;
+};
+
+/**
+ * @brief Standalone implementation of dpm_task_group_create
+ */
+inline dpm_task_group* dpm_task_group_create(void) {
+    return new dpm_task_group();
+}
+
+/**
+ * @brief Standalone implementation of dpm_task_group_destroy
+ */
+inline void dpm_task_group_destroy(dpm_task_group* group) {
+    delete group;
+}
+
+/**
+ * @brief Standalone implementation of dpm_submit_task
+ */
+inline void dpm_submit_task(dpm_task_group* group, dpm_task_function function, void* context) {
+    // there is no core pool, so the task runs on the calling thread
+    if (function) {
+        function(context);
+    }
+}
+
+/**
+ * @brief Standalone implementation of dpm_wait_group
+ */
+inline void dpm_wait_group(dpm_task_group* group) {
+}
+
+/**
+ * @brief Standalone implementation of dpm_parallel_for
+ */
+inline void dpm_parallel_for(size_t begin, size_t end, size_t grain, dpm_range_function function, void* context) {
+    if (function && end > begin) {
+        function(context, begin, end);
+    }
+}
+
+/**
+ * @brief Standalone implementation of dpm_worker_threads
+ */
+inline size_t dpm_worker_threads(void) {
+    unsigned int hardware_threads = std::thread::hardware_concurrency();
+    return hardware_threads > 0 ? hardware_threads : 1;
+}
+
+/**
+ * @brief Standalone implementation of dpm_profile_enabled
+ */
+inline int dpm_profile_enabled(void) {
+    return 0;
+}
+
+/**
+ * @brief Standalone implementation of dpm_profile_begin, which profiles nothing
+ */
+inline int dpm_profile_begin(const char* name) {
+    return -1;
+}
+
+/**
+ * @brief Standalone implementation of dpm_profile_end
+ */
+inline void dpm_profile_end(int scope, uint64_t bytes, uint64_t files) {
+}
+
+/**
+ * @brief Standalone implementation of dpm_metric_add, which records nothing
+ */
+inline void dpm_metric_add(const char* name, uint64_t value) {
+}
+
+/**
+ * @brief Standalone implementation of dpm_metric_observe, which records nothing
+ */
+inline void dpm_metric_observe(const char* name, double value) {
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+/**
+ * @file BuildModuleService.cpp
+ * @brief Implementation of the process-wide build module function table
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "BuildModuleService.hpp"
+
+BuildModuleService::BuildModuleService()
+    : _handle(nullptr), _attempted(false), _loaded(false), _functions{}
+{
+}
+
+BuildModuleService::~BuildModuleService()
+{
+    if (_handle) {
+        dpm_unload_module(_handle);
+        _handle = nullptr;
+    }
+}
+
+BuildModuleService& BuildModuleService::instance()
+{
+    static BuildModuleService service;
+    return service;
+}
+
+const BuildModuleFunctions* BuildModuleService::functions()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_attempted) {
+        _attempted = true;
+        _loaded = load();
+    }
+
+    return _loaded ? &_functions : nullptr;
+}
+
+void* BuildModuleService::handle()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _handle;
+}
+
+// resolves a single symbol into a typed function pointer, logging if it is missing
+template<typename FunctionPtr>
+static bool resolve_symbol(void* module_handle, const char* symbol_name, FunctionPtr& target)
+{
+    dlerror();
+    void* symbol = dlsym(module_handle, symbol_name);
+
+    const char* error = dlerror();
+    if (error || !symbol) {
+        dpm_log(LOG_ERROR, ("Build module is missing required symbol '" + std::string(symbol_name) + "'" +
+                           (error ? ": " + std::string(error) : "")).c_str());
+        return false;
+    }
+
+    target = reinterpret_cast<FunctionPtr>(symbol);
+    return true;
+}
+
+bool BuildModuleService::load()
+{
+    if (!dpm_module_exists("build")) {
+        dpm_log(LOG_ERROR, "Build module not found");
+        return false;
+    }
+
+    if (dpm_load_module("build", &_handle) != 0 || !_handle) {
+        const char* error = dlerror();
+        dpm_log(LOG_ERROR, ("Failed to load build module: " + std::string(error ? error : "unknown error")).c_str());
+        _handle = nullptr;
+        return false;
+    }
+
+    bool resolved = true;
+    resolved &= resolve_symbol(_handle, "get_file_from_package_file", _functions.get_file_from_package_file);
+    resolved &= resolve_symbol(_handle, "get_file_from_memory_loaded_archive", _functions.get_file_from_memory_loaded_archive);
+    resolved &= resolve_symbol(_handle, "checksum_memory_loaded_archive_entries", _functions.checksum_memory_loaded_archive_entries);
+    resolved &= resolve_symbol(_handle, "read_memory_loaded_archive_entries", _functions.read_memory_loaded_archive_entries);
+    resolved &= resolve_symbol(_handle, "get_configured_hash_algorithm", _functions.get_configured_hash_algorithm);
+    resolved &= resolve_symbol(_handle, "generate_file_checksum", _functions.generate_file_checksum);
+    resolved &= resolve_symbol(_handle, "generate_string_checksum", _functions.generate_string_checksum);
+    resolved &= resolve_symbol(_handle, "unseal_package", _functions.unseal_package);
+    resolved &= resolve_symbol(_handle, "unseal_stage_components", _functions.unseal_stage_components);
+    resolved &= resolve_symbol(_handle, "package_reader_open", _functions.package_reader_open);
+    resolved &= resolve_symbol(_handle, "package_reader_get_member", _functions.package_reader_get_member);
+    resolved &= resolve_symbol(_handle, "package_reader_close", _functions.package_reader_close);
+    resolved &= resolve_symbol(_handle, "checksum_package_component_entries", _functions.checksum_package_component_entries);
+    resolved &= resolve_symbol(_handle, "read_package_component_entries", _functions.read_package_component_entries);
+    resolved &= resolve_symbol(_handle, "verify_detached_signature_memory", _functions.verify_detached_signature_memory);
+    resolved &= resolve_symbol(_handle, "hash_algorithm_supported", _functions.hash_algorithm_supported);
+    resolved &= resolve_symbol(_handle, "generate_file_checksums", _functions.generate_file_checksums);
+    resolved &= resolve_symbol(_handle, "generate_buffer_checksums", _functions.generate_buffer_checksums);
+    resolved &= resolve_symbol(_handle, "checksum_memory_loaded_archive_entries_multi",
+                               _functions.checksum_memory_loaded_archive_entries_multi);
+    resolved &= resolve_symbol(_handle, "checksum_package_component_entries_multi",
+                               _functions.checksum_package_component_entries_multi);
+    resolved &= resolve_symbol(_handle, "generate_file_chunk_checksum", _functions.generate_file_chunk_checksum);
+    resolved &= resolve_symbol(_handle, "generate_chunk_merkle_root", _functions.generate_chunk_merkle_root);
+    resolved &= resolve_symbol(_handle, "dpm_digest_buffer", _functions.digest_buffer);
+    resolved &= resolve_symbol(_handle, "take_memory_loaded_archive_entries",
+                               _functions.take_memory_loaded_archive_entries);
+    resolved &= resolve_symbol(_handle, "get_file_from_memory_loaded_archive_into",
+                               _functions.get_file_from_memory_loaded_archive_into);
+    resolved &= resolve_symbol(_handle, "take_memory_loaded_archive_entries_into",
+                               _functions.take_memory_loaded_archive_entries_into);
+    resolved &= resolve_symbol(_handle, "archive_iterator_open_memory", _functions.archive_iterator_open_memory);
+    resolved &= resolve_symbol(_handle, "archive_iterator_open_file", _functions.archive_iterator_open_file);
+    resolved &= resolve_symbol(_handle, "archive_iterator_open_fd", _functions.archive_iterator_open_fd);
+    resolved &= resolve_symbol(_handle, "archive_iterator_open_package_component",
+                               _functions.archive_iterator_open_package_component);
+    resolved &= resolve_symbol(_handle, "archive_iterator_next", _functions.archive_iterator_next);
+    resolved &= resolve_symbol(_handle, "archive_iterator_read", _functions.archive_iterator_read);
+    resolved &= resolve_symbol(_handle, "archive_iterator_read_block", _functions.archive_iterator_read_block);
+    resolved &= resolve_symbol(_handle, "archive_iterator_skip", _functions.archive_iterator_skip);
+    resolved &= resolve_symbol(_handle, "archive_iterator_close", _functions.archive_iterator_close);
+    resolved &= resolve_symbol(_handle, "install_package", _functions.install_package);
+    resolved &= resolve_symbol(_handle, "package_reader_get_member_size", _functions.package_reader_get_member_size);
+
+    if (!resolved) {
+        dpm_unload_module(_handle);
+        _handle = nullptr;
+        _functions = {};
+        return false;
+    }
+
+    dpm_log(LOG_DEBUG, "Build module loaded and symbols resolved");
+    return true;
+}
+
+const BuildModuleFunctions* dpm_build_module()
+{
+    return BuildModuleService::instance().functions();
+}
+
+std::string dpm_digest_buffer_hex(const BuildModuleFunctions* build_module, const void* data, size_t size)
+{
+    uint8_t digest[DPM_DIGEST_MAX_SIZE];
+    size_t digest_size = sizeof(digest);
+    if (!build_module || build_module->digest_buffer(data, size, digest, &digest_size) != 0) {
+        return "";
+    }
+
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(digest_size * 2, '0');
+    for (size_t i = 0; i < digest_size; i++) {
+        hex[i * 2] = digits[digest[i] >> 4];
+        hex[i * 2 + 1] = digits[digest[i] & 0x0f];
+    }
+    return hex;
+}
@@ -0,0 +1,216 @@
+/**
+ * @file ManifestCodec.cpp
+ * @brief Implementation of the contents manifest and hooks digest line codec
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "ManifestCodec.hpp"
+
+/**
+ * @brief Character classes used by the parser, one table lookup per character
+ */
+enum ManifestCharClass : unsigned char {
+    MANIFEST_CHAR_SPACE = 1,    ///< Whitespace as the classic locale's isspace sees it
+    MANIFEST_CHAR_HEX = 2,      ///< Hexadecimal digit, either case
+    MANIFEST_CHAR_OCTAL = 4     ///< Octal digit
+};
+
+// builds the character class table at compile time
+static constexpr auto manifest_char_classes()
+{
+    struct Table {
+        unsigned char classes[256] = {};
+    } table;
+
+    for (char c : { ' ', '\t', '\n', '\v', '\f', '\r' }) {
+        table.classes[static_cast<unsigned char>(c)] |= MANIFEST_CHAR_SPACE;
+    }
+    for (int c = '0'; c <= '9'; c++) {
+        table.classes[c] |= MANIFEST_CHAR_HEX;
+    }
+    for (int c = 'a'; c <= 'f'; c++) {
+        table.classes[c] |= MANIFEST_CHAR_HEX;
+        table.classes[c - 'a' + 'A'] |= MANIFEST_CHAR_HEX;
+    }
+    for (int c = '0'; c <= '7'; c++) {
+        table.classes[c] |= MANIFEST_CHAR_OCTAL;
+    }
+    return table;
+}
+
+static constexpr auto MANIFEST_CHAR_CLASSES = manifest_char_classes();
+
+static inline bool manifest_is_space(char c)
+{
+    return MANIFEST_CHAR_CLASSES.classes[static_cast<unsigned char>(c)] & MANIFEST_CHAR_SPACE;
+}
+
+// checks that every character of a range has a class, without branching per character
+static inline bool manifest_all_of(const char* data, size_t size, unsigned char char_class)
+{
+    unsigned char all = char_class;
+    for (size_t i = 0; i < size; i++) {
+        all &= MANIFEST_CHAR_CLASSES.classes[static_cast<unsigned char>(data[i])];
+    }
+    return all != 0;
+}
+
+// position of the first non-whitespace character at or after position
+static inline size_t manifest_skip_space(std::string_view line, size_t position)
+{
+    while (position < line.size() && manifest_is_space(line[position])) {
+        position++;
+    }
+    return position;
+}
+
+// takes the next whitespace separated field, as extracting a string from a stream would
+static inline bool manifest_next_field(std::string_view line, size_t& position, std::string_view& field)
+{
+    position = manifest_skip_space(line, position);
+    size_t start = position;
+    while (position < line.size() && !manifest_is_space(line[position])) {
+        position++;
+    }
+    field = line.substr(start, position - start);
+    return !field.empty();
+}
+
+bool manifest_next_line(std::string_view& remaining, std::string_view& line)
+{
+    if (remaining.empty()) {
+        return false;
+    }
+
+    size_t end = remaining.find('\n');
+    if (end == std::string_view::npos) {
+        line = remaining;
+        remaining = std::string_view();
+    } else {
+        line = remaining.substr(0, end);
+        remaining.remove_prefix(end + 1);
+    }
+    return true;
+}
+
+// splits a line written by manifest_append_line at its fixed offsets
+static bool manifest_parse_fixed_line(std::string_view line, ManifestLine& entry, size_t digest_length)
+{
+    const size_t permissions_start = 2 + digest_length + 1;
+    const size_t ownership_start = permissions_start + MANIFEST_PERMISSIONS_LENGTH + 1;
+    if (line.size() <= ownership_start) {
+        return false;
+    }
+
+    const char* data = line.data();
+    if (manifest_is_space(data[0]) || data[1] != ' ' || data[permissions_start - 1] != ' ' ||
+        data[ownership_start - 1] != ' ' ||
+        !manifest_all_of(data + 2, digest_length, MANIFEST_CHAR_HEX) ||
+        !manifest_all_of(data + permissions_start, MANIFEST_PERMISSIONS_LENGTH, MANIFEST_CHAR_OCTAL)) {
+        return false;
+    }
+
+    size_t position = ownership_start;
+    std::string_view ownership;
+    if (!manifest_next_field(line, position, ownership)) {
+        return false;
+    }
+    position = manifest_skip_space(line, position);
+    if (position >= line.size()) {
+        return false;
+    }
+
+    entry.control = data[0];
+    entry.checksum = line.substr(2, digest_length);
+    entry.permissions = line.substr(permissions_start, MANIFEST_PERMISSIONS_LENGTH);
+    entry.ownership = ownership;
+    entry.path = line.substr(position);
+    return true;
+}
+
+bool manifest_parse_line(std::string_view line, ManifestLine& entry, size_t digest_length)
+{
+    if (digest_length > 0 && manifest_parse_fixed_line(line, entry, digest_length)) {
+        return true;
+    }
+
+    size_t position = manifest_skip_space(line, 0);
+    if (position >= line.size()) {
+        return false;
+    }
+    entry.control = line[position++];
+
+    if (!manifest_next_field(line, position, entry.checksum) ||
+        !manifest_next_field(line, position, entry.permissions) ||
+        !manifest_next_field(line, position, entry.ownership)) {
+        return false;
+    }
+
+    position = manifest_skip_space(line, position);
+    entry.path = line.substr(position);
+    return !entry.path.empty();
+}
+
+bool manifest_parse_permissions(std::string_view permissions, uint32_t& mode)
+{
+    uint32_t value = 0;
+    const char* end = permissions.data() + permissions.size();
+    auto [parsed, error] = std::from_chars(permissions.data(), end, value, 8);
+    if (permissions.empty() || error != std::errc() || parsed != end || value > 07777) {
+        return false;
+    }
+    mode = value;
+    return true;
+}
+
+std::string_view manifest_format_permissions(uint32_t mode, char (&buffer)[MANIFEST_PERMISSIONS_LENGTH + 1])
+{
+    char digits[MANIFEST_PERMISSIONS_LENGTH];
+    auto [end, error] = std::to_chars(digits, digits + sizeof(digits), mode & 07777, 8);
+    (void)error;
+
+    // zero padded to four digits, as "%04o" would
+    size_t length = static_cast<size_t>(end - digits);
+    size_t padding = MANIFEST_PERMISSIONS_LENGTH - length;
+    for (size_t i = 0; i < padding; i++) {
+        buffer[i] = '0';
+    }
+    for (size_t i = 0; i < length; i++) {
+        buffer[padding + i] = digits[i];
+    }
+    buffer[MANIFEST_PERMISSIONS_LENGTH] = '\0';
+    return std::string_view(buffer, MANIFEST_PERMISSIONS_LENGTH);
+}
+
+void manifest_append_line(std::string& manifest, char control, std::string_view checksum,
+                          std::string_view permissions, std::string_view ownership, std::string_view relative_path)
+{
+    manifest.push_back(control);
+    manifest.push_back(' ');
+    manifest.append(checksum);
+    manifest.push_back(' ');
+    manifest.append(permissions);
+    manifest.push_back(' ');
+    manifest.append(ownership);
+    manifest.append(" /");
+    manifest.append(relative_path);
+    manifest.push_back('\n');
+}
+
+bool hooks_digest_parse_line(std::string_view line, std::string_view& checksum, std::string_view& name)
+{
+    size_t position = 0;
+    return manifest_next_field(line, position, checksum) && manifest_next_field(line, position, name);
+}
+
+void hooks_digest_append_line(std::string& digest, std::string_view checksum, std::string_view name)
+{
+    digest.append(checksum);
+    digest.push_back(' ');
+    digest.append(name);
+    digest.push_back('\n');
+}
@@ -0,0 +1,382 @@
+/**
+ * @file ManifestIndex.cpp
+ * @brief Implementation of the binary manifest index
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "ManifestIndex.hpp"
+
+static const char MANIFEST_INDEX_MAGIC[8] = { 'D', 'P', 'M', 'M', 'I', 'D', 'X', '1' };
+
+static void manifest_index_put_u32(std::string& out, size_t offset, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+static void manifest_index_put_u64(std::string& out, size_t offset, uint64_t value)
+{
+    for (int i = 0; i < 8; i++) {
+        out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+static uint32_t manifest_index_get_u32(const unsigned char* in)
+{
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+static uint64_t manifest_index_get_u64(const unsigned char* in)
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+static int manifest_index_hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// appends a string to the pool, sharing repeated strings such as owners
+static bool manifest_index_pool_add(std::string& pool, std::unordered_map<std::string, uint32_t>& shared,
+                                    const std::string& text, bool share, uint32_t& offset)
+{
+    if (share) {
+        auto existing = shared.find(text);
+        if (existing != shared.end()) {
+            offset = existing->second;
+            return true;
+        }
+    }
+    if (pool.size() + text.size() > UINT32_MAX) {
+        return false;
+    }
+
+    offset = static_cast<uint32_t>(pool.size());
+    pool += text;
+    if (share) {
+        shared[text] = offset;
+    }
+    return true;
+}
+
+bool manifest_index_build(const std::vector<ManifestIndexSource>& entries, const std::string& algorithm,
+                          uint64_t manifest_size, const std::string& manifest_digest, std::string& index)
+{
+    index.clear();
+    if (entries.size() > UINT32_MAX) {
+        return false;
+    }
+
+    // every digest has the same width, that of the manifest's own digest
+    size_t digest_size = manifest_digest.size() / 2;
+    if (digest_size == 0 || digest_size > MANIFEST_INDEX_MAX_DIGEST_SIZE || manifest_digest.size() % 2 != 0) {
+        return false;
+    }
+
+    std::vector<size_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&entries](size_t a, size_t b) {
+        return entries[a].path < entries[b].path;
+    });
+
+    std::string pool;
+    std::unordered_map<std::string, uint32_t> shared;
+    uint32_t algorithm_offset = 0;
+    uint32_t manifest_digest_offset = 0;
+    if (!manifest_index_pool_add(pool, shared, algorithm, false, algorithm_offset) ||
+        !manifest_index_pool_add(pool, shared, manifest_digest, false, manifest_digest_offset)) {
+        return false;
+    }
+
+    std::string records(entries.size() * MANIFEST_INDEX_RECORD_SIZE, '\0');
+    std::string digests(entries.size() * digest_size, '\0');
+    for (size_t position = 0; position < order.size(); position++) {
+        const ManifestIndexSource& entry = entries[order[position]];
+
+        // a duplicate path could not be looked up, and the manifest would be rejected by readers anyway
+        if (entry.path.empty() || (position > 0 && entries[order[position - 1]].path == entry.path)) {
+            return false;
+        }
+
+        if (entry.checksum.size() != digest_size * 2) {
+            return false;
+        }
+        for (size_t i = 0; i < digest_size; i++) {
+            int high = manifest_index_hex_value(entry.checksum[2 * i]);
+            int low = manifest_index_hex_value(entry.checksum[2 * i + 1]);
+            if (high < 0 || low < 0) {
+                return false;
+            }
+            digests[position * digest_size + i] = static_cast<char>((high << 4) | low);
+        }
+
+        uint32_t mode = 0;
+        if (!manifest_parse_permissions(entry.permissions, mode)) {
+            return false;
+        }
+
+        uint32_t path_offset = 0;
+        uint32_t ownership_offset = 0;
+        if (!manifest_index_pool_add(pool, shared, entry.path, false, path_offset) ||
+            !manifest_index_pool_add(pool, shared, entry.ownership, true, ownership_offset)) {
+            return false;
+        }
+
+        size_t record = position * MANIFEST_INDEX_RECORD_SIZE;
+        manifest_index_put_u32(records, record, path_offset);
+        manifest_index_put_u32(records, record + 4, static_cast<uint32_t>(entry.path.size()));
+        manifest_index_put_u32(records, record + 8, ownership_offset);
+        manifest_index_put_u32(records, record + 12, static_cast<uint32_t>(entry.ownership.size()));
+        manifest_index_put_u32(records, record + 16, static_cast<uint32_t>(mode));
+        manifest_index_put_u32(records, record + 20, entry.line_number);
+        records[record + 24] = entry.control;
+    }
+
+    std::string header(MANIFEST_INDEX_HEADER_SIZE, '\0');
+    memcpy(&header[0], MANIFEST_INDEX_MAGIC, sizeof(MANIFEST_INDEX_MAGIC));
+    manifest_index_put_u32(header, 8, static_cast<uint32_t>(entries.size()));
+    manifest_index_put_u32(header, 12, static_cast<uint32_t>(digest_size));
+    manifest_index_put_u64(header, 16, manifest_size);
+    manifest_index_put_u64(header, 24, pool.size());
+    manifest_index_put_u32(header, 32, algorithm_offset);
+    manifest_index_put_u32(header, 36, static_cast<uint32_t>(algorithm.size()));
+    manifest_index_put_u32(header, 40, manifest_digest_offset);
+    manifest_index_put_u32(header, 44, static_cast<uint32_t>(manifest_digest.size()));
+
+    index.reserve(header.size() + records.size() + digests.size() + pool.size());
+    index = header + records + digests + pool;
+    return true;
+}
+
+std::string ManifestIndexEntry::checksum() const
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string text(digest_size * 2, '0');
+    for (size_t i = 0; i < digest_size; i++) {
+        text[2 * i] = hex[digest[i] >> 4];
+        text[2 * i + 1] = hex[digest[i] & 0x0f];
+    }
+    return text;
+}
+
+ManifestIndex::ManifestIndex()
+    : _data(nullptr), _size(0), _mapping(nullptr), _mapping_size(0), _entry_count(0), _digest_size(0),
+      _manifest_size(0), _records_offset(0), _digests_offset(0), _pool_offset(0), _pool_size(0)
+{
+}
+
+ManifestIndex::~ManifestIndex()
+{
+    close();
+}
+
+void ManifestIndex::close()
+{
+    if (_mapping) {
+        munmap(_mapping, _mapping_size);
+    }
+    _mapping = nullptr;
+    _mapping_size = 0;
+    _data = nullptr;
+    _size = 0;
+    _entry_count = 0;
+    _algorithm = std::string_view();
+    _manifest_digest = std::string_view();
+}
+
+bool ManifestIndex::open(const std::filesystem::path& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < MANIFEST_INDEX_HEADER_SIZE) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    if (!attach(mapping, static_cast<size_t>(st.st_size))) {
+        munmap(mapping, static_cast<size_t>(st.st_size));
+        return false;
+    }
+    _mapping = mapping;
+    _mapping_size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+bool ManifestIndex::attach(const void* data, size_t size)
+{
+    close();
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    if (!bytes || size < MANIFEST_INDEX_HEADER_SIZE ||
+        memcmp(bytes, MANIFEST_INDEX_MAGIC, sizeof(MANIFEST_INDEX_MAGIC)) != 0) {
+        return false;
+    }
+
+    uint64_t entry_count = manifest_index_get_u32(bytes + 8);
+    uint64_t digest_size = manifest_index_get_u32(bytes + 12);
+    uint64_t pool_size = manifest_index_get_u64(bytes + 24);
+    if (digest_size == 0 || digest_size > MANIFEST_INDEX_MAX_DIGEST_SIZE) {
+        return false;
+    }
+
+    // the sections have to fill the data exactly
+    uint64_t records_offset = MANIFEST_INDEX_HEADER_SIZE;
+    uint64_t digests_offset = records_offset + entry_count * MANIFEST_INDEX_RECORD_SIZE;
+    uint64_t pool_offset = digests_offset + entry_count * digest_size;
+    if (pool_size > size || pool_offset != size - pool_size) {
+        return false;
+    }
+
+    auto pool_string = [&](const unsigned char* reference, std::string_view& text) {
+        uint64_t offset = manifest_index_get_u32(reference);
+        uint64_t length = manifest_index_get_u32(reference + 4);
+        if (offset + length > pool_size) {
+            return false;
+        }
+        text = std::string_view(reinterpret_cast<const char*>(bytes + pool_offset + offset), length);
+        return true;
+    };
+
+    std::string_view algorithm;
+    std::string_view manifest_digest;
+    if (!pool_string(bytes + 32, algorithm) || !pool_string(bytes + 40, manifest_digest) ||
+        manifest_digest.size() != digest_size * 2) {
+        return false;
+    }
+
+    // check every reference and the order once, so lookups need no checks
+    std::string_view previous;
+    for (uint64_t position = 0; position < entry_count; position++) {
+        const unsigned char* record = bytes + records_offset + position * MANIFEST_INDEX_RECORD_SIZE;
+        std::string_view path;
+        std::string_view ownership;
+        if (!pool_string(record, path) || !pool_string(record + 8, ownership) || path.empty() ||
+            (position > 0 && previous >= path)) {
+            return false;
+        }
+        previous = path;
+    }
+
+    _data = bytes;
+    _size = size;
+    _entry_count = static_cast<uint32_t>(entry_count);
+    _digest_size = static_cast<uint32_t>(digest_size);
+    _manifest_size = manifest_index_get_u64(bytes + 16);
+    _records_offset = records_offset;
+    _digests_offset = digests_offset;
+    _pool_offset = pool_offset;
+    _pool_size = pool_size;
+    _algorithm = algorithm;
+    _manifest_digest = manifest_digest;
+    return true;
+}
+
+bool ManifestIndex::matches(uint64_t manifest_size, const std::string& manifest_digest) const
+{
+    return _data && manifest_size == _manifest_size && manifest_digest == _manifest_digest;
+}
+
+std::string_view ManifestIndex::algorithm() const
+{
+    return _algorithm;
+}
+
+size_t ManifestIndex::size() const
+{
+    return _entry_count;
+}
+
+ManifestIndexEntry ManifestIndex::entry(size_t position) const
+{
+    const unsigned char* record = _data + _records_offset + position * MANIFEST_INDEX_RECORD_SIZE;
+    const char* pool = reinterpret_cast<const char*>(_data + _pool_offset);
+
+    ManifestIndexEntry entry;
+    entry.path = std::string_view(pool + manifest_index_get_u32(record), manifest_index_get_u32(record + 4));
+    entry.ownership = std::string_view(pool + manifest_index_get_u32(record + 8), manifest_index_get_u32(record + 12));
+    entry.digest = _data + _digests_offset + position * _digest_size;
+    entry.digest_size = _digest_size;
+    entry.mode = manifest_index_get_u32(record + 16);
+    entry.line_number = manifest_index_get_u32(record + 20);
+    entry.control = static_cast<char>(record[24]);
+    return entry;
+}
+
+bool ManifestIndex::find(std::string_view path, ManifestIndexEntry& entry) const
+{
+    if (!path.empty() && path[0] == '/') {
+        path.remove_prefix(1);
+    }
+
+    size_t low = 0;
+    size_t high = _entry_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        ManifestIndexEntry candidate = this->entry(middle);
+        int order = candidate.path.compare(path);
+        if (order == 0) {
+            entry = candidate;
+            return true;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return false;
+}
+
+size_t ManifestIndex::lower_bound(std::string_view path) const
+{
+    if (!path.empty() && path[0] == '/') {
+        path.remove_prefix(1);
+    }
+
+    size_t low = 0;
+    size_t high = _entry_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (entry(middle).path < path) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+uint64_t ManifestIndex::manifest_size() const
+{
+    return _data ? _manifest_size : 0;
+}
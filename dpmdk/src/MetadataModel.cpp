@@ -0,0 +1,87 @@
+/**
+ * @file MetadataModel.cpp
+ * @brief Implementation of the in-memory stage metadata model
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "MetadataModel.hpp"
+
+// reads a whole metadata file
+static bool metadata_model_read_file(const std::filesystem::path& path, std::string& content)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    if (file.bad()) {
+        return false;
+    }
+    content = buffer.str();
+    return true;
+}
+
+bool MetadataModel::load(const std::filesystem::path& metadata_dir)
+{
+    _fields.clear();
+
+    std::error_code ec;
+    std::filesystem::directory_iterator entries(metadata_dir, ec);
+    if (ec) {
+        dpm_log(LOG_ERROR, ("Failed to read metadata directory " + metadata_dir.string() + ": " + ec.message()).c_str());
+        return false;
+    }
+
+    for (const auto& entry : entries) {
+        std::string key = entry.path().filename().string();
+        if (!entry.is_regular_file(ec) || key.ends_with(".tmp")) {
+            continue;
+        }
+
+        std::string content;
+        if (!metadata_model_read_file(entry.path(), content)) {
+            dpm_log(LOG_ERROR, ("Failed to read metadata file: " + entry.path().string()).c_str());
+            _fields.clear();
+            return false;
+        }
+        _fields[key] = std::move(content);
+    }
+    return true;
+}
+
+bool MetadataModel::load_field(const std::filesystem::path& metadata_dir, const std::string& key)
+{
+    std::string content;
+    if (!metadata_model_read_file(metadata_dir / key, content)) {
+        return false;
+    }
+    _fields[key] = std::move(content);
+    return true;
+}
+
+const std::string* MetadataModel::find(const std::string& key) const
+{
+    auto field = _fields.find(key);
+    return field == _fields.end() ? nullptr : &field->second;
+}
+
+void MetadataModel::set(const std::string& key, const std::string& value)
+{
+    _fields[key] = value;
+}
+
+void MetadataModel::remove(const std::string& key)
+{
+    _fields.erase(key);
+}
+
+const std::map<std::string, std::string>& MetadataModel::fields() const
+{
+    return _fields;
+}
@@ -29,18 +29,8 @@ bool dpm_module_exists(const char* module_name) {
 int dpm_load_module(const char* module_name, void** module_handle) {
     if (!module_name || !module_handle) return 1;
 
-    // Get the module path
-    const char* module_path = dpm_get_module_path();
-    if (!module_path) return 1;
-
-    // Build path to the module
-    std::string module_file = std::string(module_path) + "/" + module_name + ".so";
-
-    // Check if the file exists
-    if (!dpm_module_exists(module_name)) return 1;
-
-    // Load the module
-    *module_handle = dlopen(module_file.c_str(), RTLD_LAZY);
+    // Share the handle the core already holds for the module, if any
+    if (dpm_acquire_module(module_name, module_handle) != 0) return 1;
     if (!*module_handle) return 1;
 
     return 0;
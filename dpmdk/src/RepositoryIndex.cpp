@@ -0,0 +1,284 @@
+/**
+ * @file RepositoryIndex.cpp
+ * @brief Implementation of the binary repository index
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "RepositoryIndex.hpp"
+
+static const char REPOSITORY_INDEX_MAGIC[8] = { 'D', 'P', 'M', 'R', 'I', 'D', 'X', '1' };
+
+// number of string references at the start of each record
+static const size_t REPOSITORY_INDEX_STRING_COUNT = 6;
+
+static void repository_index_put_u32(std::string& out, size_t offset, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+static void repository_index_put_u64(std::string& out, size_t offset, uint64_t value)
+{
+    for (int i = 0; i < 8; i++) {
+        out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+static uint32_t repository_index_get_u32(const unsigned char* in)
+{
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+static uint64_t repository_index_get_u64(const unsigned char* in)
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+// appends a string to the pool, sharing the repeated ones such as names and architectures
+static bool repository_index_pool_add(std::string& pool, std::unordered_map<std::string, uint32_t>& shared,
+                                      const std::string& text, uint32_t& offset)
+{
+    auto existing = shared.find(text);
+    if (existing != shared.end()) {
+        offset = existing->second;
+        return true;
+    }
+    if (pool.size() + text.size() > UINT32_MAX) {
+        return false;
+    }
+
+    offset = static_cast<uint32_t>(pool.size());
+    pool += text;
+    shared[text] = offset;
+    return true;
+}
+
+bool repository_index_build(const std::vector<RepositoryIndexSource>& packages, std::string& index)
+{
+    index.clear();
+    if (packages.size() > UINT32_MAX) {
+        return false;
+    }
+
+    std::vector<size_t> order(packages.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&packages](size_t a, size_t b) {
+        return packages[a].path < packages[b].path;
+    });
+
+    std::string pool;
+    std::unordered_map<std::string, uint32_t> shared;
+    std::string records(packages.size() * REPOSITORY_INDEX_RECORD_SIZE, '\0');
+    for (size_t position = 0; position < order.size(); position++) {
+        const RepositoryIndexSource& package = packages[order[position]];
+        if (package.path.empty() || (position > 0 && packages[order[position - 1]].path == package.path)) {
+            return false;
+        }
+
+        const std::string* strings[REPOSITORY_INDEX_STRING_COUNT] = {
+            &package.path, &package.name, &package.version,
+            &package.architecture, &package.package_digest, &package.dependencies
+        };
+
+        size_t record = position * REPOSITORY_INDEX_RECORD_SIZE;
+        for (size_t i = 0; i < REPOSITORY_INDEX_STRING_COUNT; i++) {
+            uint32_t offset = 0;
+            if (!repository_index_pool_add(pool, shared, *strings[i], offset)) {
+                return false;
+            }
+            repository_index_put_u32(records, record + 8 * i, offset);
+            repository_index_put_u32(records, record + 8 * i + 4, static_cast<uint32_t>(strings[i]->size()));
+        }
+
+        repository_index_put_u64(records, record + 48, package.file_size);
+        repository_index_put_u64(records, record + 56, package.mtime_ns);
+        repository_index_put_u64(records, record + 64, package.inode);
+        repository_index_put_u64(records, record + 72, package.contents_size);
+        repository_index_put_u64(records, record + 80, package.hooks_size);
+        repository_index_put_u64(records, record + 88, package.metadata_size);
+    }
+
+    std::string header(REPOSITORY_INDEX_HEADER_SIZE, '\0');
+    memcpy(&header[0], REPOSITORY_INDEX_MAGIC, sizeof(REPOSITORY_INDEX_MAGIC));
+    repository_index_put_u32(header, 8, static_cast<uint32_t>(packages.size()));
+    repository_index_put_u32(header, 12, REPOSITORY_INDEX_RECORD_SIZE);
+    repository_index_put_u64(header, 16, pool.size());
+
+    index.reserve(header.size() + records.size() + pool.size());
+    index = header + records + pool;
+    return true;
+}
+
+RepositoryIndexSource RepositoryIndexEntry::source() const
+{
+    return {
+        std::string(path), std::string(name), std::string(version), std::string(architecture),
+        std::string(package_digest), std::string(dependencies),
+        file_size, mtime_ns, inode, contents_size, hooks_size, metadata_size
+    };
+}
+
+RepositoryIndex::RepositoryIndex()
+    : _data(nullptr), _size(0), _mapping(nullptr), _mapping_size(0), _package_count(0), _pool_offset(0)
+{
+}
+
+RepositoryIndex::~RepositoryIndex()
+{
+    close();
+}
+
+void RepositoryIndex::close()
+{
+    if (_mapping) {
+        munmap(_mapping, _mapping_size);
+    }
+    _mapping = nullptr;
+    _mapping_size = 0;
+    _data = nullptr;
+    _size = 0;
+    _package_count = 0;
+}
+
+bool RepositoryIndex::open(const std::filesystem::path& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < REPOSITORY_INDEX_HEADER_SIZE) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    if (!attach(mapping, static_cast<size_t>(st.st_size))) {
+        munmap(mapping, static_cast<size_t>(st.st_size));
+        return false;
+    }
+    _mapping = mapping;
+    _mapping_size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+bool RepositoryIndex::attach(const void* data, size_t size)
+{
+    close();
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    if (!bytes || size < REPOSITORY_INDEX_HEADER_SIZE ||
+        memcmp(bytes, REPOSITORY_INDEX_MAGIC, sizeof(REPOSITORY_INDEX_MAGIC)) != 0) {
+        return false;
+    }
+
+    uint64_t package_count = repository_index_get_u32(bytes + 8);
+    uint64_t record_size = repository_index_get_u32(bytes + 12);
+    uint64_t pool_size = repository_index_get_u64(bytes + 16);
+    if (record_size != REPOSITORY_INDEX_RECORD_SIZE) {
+        return false;
+    }
+
+    // the sections have to fill the data exactly
+    uint64_t pool_offset = REPOSITORY_INDEX_HEADER_SIZE + package_count * REPOSITORY_INDEX_RECORD_SIZE;
+    if (pool_size > size || pool_offset != size - pool_size) {
+        return false;
+    }
+
+    // check every reference and the order once, so lookups need no checks
+    std::string_view previous;
+    for (uint64_t position = 0; position < package_count; position++) {
+        const unsigned char* record = bytes + REPOSITORY_INDEX_HEADER_SIZE + position * REPOSITORY_INDEX_RECORD_SIZE;
+        for (size_t i = 0; i < REPOSITORY_INDEX_STRING_COUNT; i++) {
+            uint64_t offset = repository_index_get_u32(record + 8 * i);
+            uint64_t length = repository_index_get_u32(record + 8 * i + 4);
+            if (offset + length > pool_size) {
+                return false;
+            }
+        }
+
+        std::string_view path(reinterpret_cast<const char*>(bytes + pool_offset + repository_index_get_u32(record)),
+                              repository_index_get_u32(record + 4));
+        if (path.empty() || (position > 0 && previous >= path)) {
+            return false;
+        }
+        previous = path;
+    }
+
+    _data = bytes;
+    _size = size;
+    _package_count = static_cast<uint32_t>(package_count);
+    _pool_offset = pool_offset;
+    return true;
+}
+
+size_t RepositoryIndex::size() const
+{
+    return _package_count;
+}
+
+RepositoryIndexEntry RepositoryIndex::entry(size_t position) const
+{
+    const unsigned char* record = _data + REPOSITORY_INDEX_HEADER_SIZE + position * REPOSITORY_INDEX_RECORD_SIZE;
+    const char* pool = reinterpret_cast<const char*>(_data + _pool_offset);
+    auto pool_string = [&](size_t i) {
+        return std::string_view(pool + repository_index_get_u32(record + 8 * i),
+                                repository_index_get_u32(record + 8 * i + 4));
+    };
+
+    RepositoryIndexEntry entry;
+    entry.path = pool_string(0);
+    entry.name = pool_string(1);
+    entry.version = pool_string(2);
+    entry.architecture = pool_string(3);
+    entry.package_digest = pool_string(4);
+    entry.dependencies = pool_string(5);
+    entry.file_size = repository_index_get_u64(record + 48);
+    entry.mtime_ns = repository_index_get_u64(record + 56);
+    entry.inode = repository_index_get_u64(record + 64);
+    entry.contents_size = repository_index_get_u64(record + 72);
+    entry.hooks_size = repository_index_get_u64(record + 80);
+    entry.metadata_size = repository_index_get_u64(record + 88);
+    return entry;
+}
+
+bool RepositoryIndex::find(std::string_view path, RepositoryIndexEntry& entry) const
+{
+    size_t low = 0;
+    size_t high = _package_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        RepositoryIndexEntry candidate = this->entry(middle);
+        int order = candidate.path.compare(path);
+        if (order == 0) {
+            entry = candidate;
+            return true;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return false;
+}
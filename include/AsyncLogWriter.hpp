@@ -0,0 +1,154 @@
+/**
+ * @file AsyncLogWriter.hpp
+ * @brief Background writer for the log file
+ *
+ * Defines the AsyncLogWriter class, which takes log records from any
+ * thread without locking and appends them to the log file from a
+ * background thread in batches, so that logging does not open, write
+ * and close the log file for every message.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+*/
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "LoggingLevels.hpp"
+
+/**
+ * @brief Number of records the ring holds before producers wait for the writer
+ */
+#define DPM_LOG_RING_CAPACITY 4096
+
+/**
+ * @class AsyncLogWriter
+ * @brief Appends log records to a file from a background thread
+ *
+ * Records are placed in a bounded multi-producer ring without taking a
+ * lock, and a single writer thread formats them with a timestamp cached
+ * per second and appends them to a persistent file descriptor, one write
+ * per batch.  A producer that finds the ring full wakes the writer and
+ * waits for room, so no record is dropped.  flush() returns once every
+ * record submitted before it has been written, and close() drains the
+ * ring before stopping the writer.
+ *
+ * The writer thread is started on the first submission, and again in a
+ * child process after fork(), which starts with an empty ring.
+ */
+class AsyncLogWriter {
+public:
+    AsyncLogWriter();
+
+    /**
+     * @brief Destructor, drains the ring and closes the file
+     */
+    ~AsyncLogWriter();
+
+    /**
+     * @brief Opens the log file, closing any file opened before
+     *
+     * @param path Path to the log file, which is created if it does not exist
+     * @return true if the file is open for appending, false otherwise
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Drains the ring, stops the writer and closes the file
+     */
+    void close();
+
+    /**
+     * @brief Checks whether a log file is open
+     *
+     * @return true if records are being written to a file
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Queues a record for the log file
+     *
+     * @param level The severity level of the message
+     * @param timestamp Time the message was logged at
+     * @param message The message to log
+     */
+    void submit(LoggingLevels level, std::time_t timestamp, std::string message);
+
+    /**
+     * @brief Waits until every record submitted so far has been written
+     */
+    void flush();
+
+private:
+    struct Record {
+        std::atomic<size_t> sequence;
+        LoggingLevels level;
+        std::time_t timestamp;
+        std::string message;
+    };
+
+    bool try_push(LoggingLevels level, std::time_t timestamp, std::string& message);
+    void reset_ring();
+    void ensure_writer();
+    void writer_loop();
+    size_t drain(std::string& batch);
+    void format(const Record& record, std::string& batch);
+
+    static void prepare_fork();
+    static void parent_after_fork();
+    static void child_after_fork();
+
+    std::unique_ptr<Record[]> _ring;
+    std::atomic<size_t> _head;
+    size_t _tail;
+
+    std::atomic<size_t> _written;
+
+    std::atomic<int> _fd;
+    std::atomic<bool> _running;
+    bool _stopping;
+    std::unique_ptr<std::thread> _writer;
+    std::mutex _writer_mutex;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _drained;
+
+    std::time_t _cached_second;
+    char _cached_timestamp[32];
+};
\ No newline at end of file
@@ -32,7 +32,11 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <map>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
 #include <vector>
 #include <filesystem>
 #include <fstream>
@@ -44,6 +48,57 @@
 #include <dirent.h>
 
 #include "dpm_interface_helpers.hpp"
+#include "ConfigSnapshot.hpp"
+
+/**
+ * @struct ConfigKeyView
+ * @brief A section and key pair as looked up, without owning either
+ */
+struct ConfigKeyView {
+    std::string_view section;  /**< Section name */
+    std::string_view key;      /**< Key within the section */
+
+    bool operator==(const ConfigKeyView& other) const
+    {
+        return section == other.section && key == other.key;
+    }
+};
+
+/**
+ * @struct ConfigKeyHash
+ * @brief Hashes a section and key pair in place
+ */
+struct ConfigKeyHash {
+    size_t operator()(const ConfigKeyView& view) const
+    {
+        size_t section_hash = std::hash<std::string_view>()(view.section);
+        size_t key_hash = std::hash<std::string_view>()(view.key);
+        return section_hash ^ (key_hash + 0x9e3779b97f4a7c15ULL + (section_hash << 6) + (section_hash >> 2));
+    }
+};
+
+/**
+ * @struct ConfigEntry
+ * @brief One configuration value, in the flat store
+ */
+struct ConfigEntry {
+    std::string_view section;  /**< Interned section name */
+    std::string_view key;      /**< Key within the section */
+    std::string_view value;    /**< Value as written in the file, NUL-terminated */
+};
+
+/**
+ * @struct ConfigSlot
+ * @brief A pre-resolved configuration key, read by modules through its value pointer
+ *
+ * Slots outlive reloads of the configuration, which point them at the new
+ * values, so a module may resolve a key once and keep the slot.
+ */
+struct ConfigSlot {
+    std::string section;              /**< Section name */
+    std::string key;                  /**< Key within the section */
+    const char* value = nullptr;      /**< Current value, or NULL when the key is not set */
+};
 
 /**
  * @class ConfigManager
@@ -52,6 +107,12 @@
  * This class handles loading, parsing, and providing access to configuration
  * values from INI-style files. It supports sections, key-value pairs, and
  * provides type-conversion methods for different value types.
+ *
+ * Values are kept in one flat hash table keyed by section and key, with
+ * section names interned, and are looked up by string_view so that no
+ * lookup allocates.  Values do not move until the configuration is loaded
+ * again.  Loading a directory that is unchanged since it was last parsed
+ * maps its compiled snapshot instead of parsing it, see ConfigSnapshot.
  */
 class ConfigManager {
     public:
@@ -156,6 +217,20 @@ class ConfigManager {
          */
         bool hasConfigKey(const char* section, const char* key) const;
 
+        /**
+         * @brief Resolves a configuration key to a slot holding its value
+         *
+         * The slot stays valid for the life of the process, and follows
+         * reloads of the configuration, so reading a value through it costs
+         * a single pointer read.  Resolving the same key again returns the
+         * same slot.
+         *
+         * @param section The section name (uses DEFAULT_SECTION if NULL)
+         * @param key The configuration key
+         * @return Pointer to the value pointer, which is NULL while the key is not set; NULL if key is NULL
+         */
+        const char* const* resolveConfigValue(const char* section, const char* key);
+
         // getter for _module_path
         void setModulePath(const char * module_path);
 
@@ -192,9 +267,34 @@ class ConfigManager {
          *
          * @param section The section name
          * @param key The configuration key
-         * @return Optional reference to the configuration value if found, empty optional otherwise
+         * @return The configuration value if found, NULL otherwise
+         */
+        const char* findConfigValue(std::string_view section, std::string_view key) const;
+
+        /**
+         * @brief Stores a configuration value, replacing any earlier value of the key
+         *
+         * @param section The section name
+         * @param key The configuration key
+         * @param value The configuration value
+         */
+        void setConfigValue(std::string_view section, const std::string& key, const std::string& value);
+
+        /**
+         * @brief Interns a section name
+         *
+         * Configurations hold a handful of sections, so they are kept in a
+         * short list rather than a table of their own.
+         *
+         * @param section The section name
+         * @return A view of the interned name, valid until the configuration is loaded again
+         */
+        std::string_view internSection(std::string_view section);
+
+        /**
+         * @brief Points every resolved slot at the current value of its key
          */
-        std::optional<std::reference_wrapper<const std::string>> findConfigValue(const std::string& section, const std::string& key) const;
+        void refreshSlots();
 
         /**
          * @brief Configuration directory path
@@ -202,9 +302,44 @@ class ConfigManager {
         std::string _config_dir;
 
         /**
-         * @brief Configuration data structure: section -> key -> value
+         * @brief Interned section names
+         */
+        std::deque<std::string> _sections;
+
+        /**
+         * @brief Strings of the parsed configuration, which keep their addresses as strings are added
+         */
+        std::deque<std::string> _storage;
+
+        /**
+         * @brief Snapshot the configuration was loaded from, when it was not parsed
+         */
+        ConfigSnapshot _snapshot;
+
+        /**
+         * @brief Configuration values, which keep their addresses as entries are added
+         */
+        std::deque<ConfigEntry> _entries;
+
+        /**
+         * @brief Flat index of the configuration values by section and key
+         */
+        std::unordered_map<ConfigKeyView, ConfigEntry*, ConfigKeyHash> _index;
+
+        /**
+         * @brief Slots handed out by resolveConfigValue
+         */
+        std::deque<ConfigSlot> _slots;
+
+        /**
+         * @brief Slots by section and key
+         */
+        std::unordered_map<ConfigKeyView, ConfigSlot*, ConfigKeyHash> _slot_index;
+
+        /**
+         * @brief Guards the slots, which modules may resolve from several threads
          */
-        std::map<std::string, std::map<std::string, std::string>> _config_data;
+        std::mutex _slot_mutex;
 
         std::string _module_path;
 };
@@ -0,0 +1,236 @@
+/**
+ * @file ConfigSnapshot.hpp
+ * @brief Compiled snapshot of a configuration directory, loaded with one mmap
+ *
+ * Parsing every .conf file of the configuration directory dominates the
+ * start of a short dpm invocation.  After parsing a directory, DPM writes
+ * the resulting table to a snapshot under DPMDefaults::CONFIG_SNAPSHOT_DIR,
+ * named after the directory.  Later invocations map the snapshot and use
+ * its strings in place, as long as the directory and every file recorded in
+ * the snapshot keep the modification time and size they had when it was
+ * written.  Adding, removing or editing a .conf file changes one of them, so
+ * the next invocation parses the directory again and replaces the snapshot.
+ *
+ * The snapshot is laid out as a ConfigSnapshotHeader, the file records, the
+ * entry records and a string table.  Every string in the table is
+ * NUL-terminated, so values are handed out as C strings straight from the
+ * mapping.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+*/
+
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <climits>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "DPMDefaults.hpp"
+
+/**
+ * @brief Magic bytes that open a configuration snapshot
+ */
+#define CONFIG_SNAPSHOT_MAGIC "DPMCONF1"
+
+/**
+ * @struct ConfigSnapshotHeader
+ * @brief Fixed-size start of a configuration snapshot
+ */
+struct ConfigSnapshotHeader {
+    char magic[8];               /**< CONFIG_SNAPSHOT_MAGIC, without its NUL */
+    uint32_t file_count;         /**< Number of file records */
+    uint32_t entry_count;        /**< Number of entry records */
+    int64_t directory_mtime;     /**< Modification time of the configuration directory, in nanoseconds */
+    uint32_t directory_offset;   /**< Configuration directory path in the string table */
+    uint32_t strings_size;       /**< Size of the string table, in bytes */
+};
+
+/**
+ * @struct ConfigSnapshotFileRecord
+ * @brief A .conf file the snapshot was compiled from
+ */
+struct ConfigSnapshotFileRecord {
+    int64_t mtime;               /**< Modification time of the file, in nanoseconds */
+    uint64_t size;               /**< Size of the file, in bytes */
+    uint32_t name_offset;        /**< File name in the string table */
+    uint32_t reserved;           /**< Zero */
+};
+
+/**
+ * @struct ConfigSnapshotEntryRecord
+ * @brief One configuration value of the snapshot
+ */
+struct ConfigSnapshotEntryRecord {
+    uint32_t section_offset;     /**< Section name in the string table */
+    uint32_t key_offset;         /**< Key in the string table */
+    uint32_t value_offset;       /**< Value in the string table */
+    uint32_t reserved;           /**< Zero */
+};
+
+/**
+ * @struct ConfigSnapshotFile
+ * @brief A .conf file as recorded when compiling a snapshot
+ */
+struct ConfigSnapshotFile {
+    std::string name;            /**< File name within the configuration directory */
+    int64_t mtime;               /**< Modification time, in nanoseconds */
+    uint64_t size;               /**< Size, in bytes */
+};
+
+/**
+ * @struct ConfigSnapshotValue
+ * @brief One configuration value, as written to or read from a snapshot
+ */
+struct ConfigSnapshotValue {
+    std::string_view section;    /**< Section name */
+    std::string_view key;        /**< Key within the section */
+    std::string_view value;      /**< Value, NUL-terminated when read from a snapshot */
+};
+
+/**
+ * @class ConfigSnapshot
+ * @brief A mapped configuration snapshot
+ */
+class ConfigSnapshot {
+    public:
+        ConfigSnapshot() = default;
+        ~ConfigSnapshot();
+
+        ConfigSnapshot(const ConfigSnapshot&) = delete;
+        ConfigSnapshot& operator=(const ConfigSnapshot&) = delete;
+
+        /**
+         * @brief Gets the snapshot path for a configuration directory
+         *
+         * @param config_dir The configuration directory, ending with a slash
+         * @return Path of its snapshot
+         */
+        static std::string pathFor(const std::string& config_dir);
+
+        /**
+         * @brief Gets the modification time of a file, in nanoseconds
+         *
+         * @param st Result of stat on the file
+         * @return Modification time in nanoseconds since the epoch
+         */
+        static int64_t mtimeOf(const struct stat& st);
+
+        /**
+         * @brief Maps the snapshot of a configuration directory, if it is current
+         *
+         * @param config_dir The configuration directory, ending with a slash
+         * @return true if the snapshot is mapped and matches the directory, false otherwise
+         */
+        bool open(const std::string& config_dir);
+
+        /**
+         * @brief Unmaps the snapshot, invalidating every value read from it
+         */
+        void close();
+
+        /**
+         * @brief Gets the values of the mapped snapshot
+         *
+         * @return Values in the order they were written, viewing the mapping
+         */
+        const std::vector<ConfigSnapshotValue>& values() const;
+
+        /**
+         * @brief Compiles a snapshot of a parsed configuration directory
+         *
+         * Writes beside the snapshot and renames over it, so readers never see
+         * a partial snapshot.  Other snapshots of the same directory, under
+         * another spelling of its path, snapshots of directories that no
+         * longer exist and temporary files left by writers that died are
+         * removed, so the snapshot directory does not keep growing.
+         *
+         * @param config_dir The configuration directory, ending with a slash
+         * @param directory_mtime Modification time of the directory before it was read, in nanoseconds
+         * @param files The .conf files parsed
+         * @param values The resulting configuration values
+         * @return true if the snapshot was written, false otherwise
+         */
+        static bool write(const std::string& config_dir, int64_t directory_mtime,
+                          const std::vector<ConfigSnapshotFile>& files,
+                          const std::vector<ConfigSnapshotValue>& values);
+
+    private:
+        /**
+         * @brief Reads a NUL-terminated string of the string table, checking its bounds
+         */
+        bool stringAt(uint32_t offset, std::string_view& value) const;
+
+        /**
+         * @brief Reads the configuration directory a snapshot file was compiled from
+         *
+         * @param path Path of the snapshot file
+         * @param config_dir Receives the directory recorded in it
+         * @return true if the file is a snapshot, false otherwise
+         */
+        static bool directoryOf(const std::string& path, std::string& config_dir);
+
+        /**
+         * @brief Removes the snapshots and temporary files superseded by a new snapshot
+         *
+         * @param config_dir The configuration directory the new snapshot was compiled from
+         * @param current Path of the new snapshot, which is kept
+         */
+        static void removeStale(const std::string& config_dir, const std::string& current);
+
+        /**
+         * @brief Start of the mapping, nullptr when nothing is mapped
+         */
+        void* _mapping = nullptr;
+
+        /**
+         * @brief Size of the mapping, in bytes
+         */
+        size_t _mapping_size = 0;
+
+        /**
+         * @brief Start of the string table within the mapping
+         */
+        const char* _strings = nullptr;
+
+        /**
+         * @brief Size of the string table, in bytes
+         */
+        size_t _strings_size = 0;
+
+        /**
+         * @brief Values of the mapped snapshot
+         */
+        std::vector<ConfigSnapshotValue> _values;
+};
@@ -49,6 +49,14 @@ struct DPMDefaults {
      */
     static const char* const    MODULE_PATH;
 
+    /**
+     * @brief Default path to the module metadata index
+     *
+     * File where DPM records the version, description and interface of each
+     * module, so listing modules does not need to load them.
+     */
+    static const char* const    MODULE_INDEX_PATH;
+
     /**
      * @brief Default path to the directory containing configuration files
      *
@@ -57,6 +65,14 @@ struct DPMDefaults {
      */
     static const char* const    CONFIG_DIR;
 
+    /**
+     * @brief Default directory of compiled configuration snapshots
+     *
+     * Directory where DPM keeps a snapshot of each configuration directory
+     * it has parsed, so unchanged configuration is mapped instead of parsed.
+     */
+    static const char* const    CONFIG_SNAPSHOT_DIR;
+
     /**
      * @brief Default path to the log file
      *
@@ -65,6 +81,14 @@ struct DPMDefaults {
      */
     static const char* const    LOG_FILE;
 
+    /**
+     * @brief Default path to the dpmd socket
+     *
+     * Unix socket dpmd serves on, and dpm hands invocations to, when the
+     * DPMD_SOCKET environment variable is not set.
+     */
+    static const char* const    DAEMON_SOCKET;
+
     /**
      * @brief Default setting for whether to write to log file
      *
@@ -89,6 +113,13 @@ struct DPMDefaults {
  */
 inline const char * const   DPMDefaults::MODULE_PATH    = "/usr/lib/dpm/modules/";
 
+/**
+ * @brief Default module index path initialization
+ *
+ * Sets the default module index path to the standard system cache location.
+ */
+inline const char * const   DPMDefaults::MODULE_INDEX_PATH  = "/var/cache/dpm/modules.index";
+
 /**
  * @brief Default configuration directory initialization
  *
@@ -96,6 +127,13 @@ inline const char * const   DPMDefaults::MODULE_PATH    = "/usr/lib/dpm/modules/
  */
 inline const char * const   DPMDefaults::CONFIG_DIR     = "/etc/dpm/conf.d/";
 
+/**
+ * @brief Default configuration snapshot directory initialization
+ *
+ * Sets the default snapshot directory to the standard system cache location.
+ */
+inline const char * const   DPMDefaults::CONFIG_SNAPSHOT_DIR = "/var/cache/dpm/";
+
 /**
  * @brief Default log file path initialization
  *
@@ -103,6 +141,13 @@ inline const char * const   DPMDefaults::CONFIG_DIR     = "/etc/dpm/conf.d/";
  */
 inline const char * const   DPMDefaults::LOG_FILE       = "/var/log/dpm.log";
 
+/**
+ * @brief Default dpmd socket path initialization
+ *
+ * Sets the default dpmd socket to the standard runtime location.
+ */
+inline const char * const   DPMDefaults::DAEMON_SOCKET  = "/run/dpm/dpmd.sock";
+
 /**
  * @brief Default write to log setting initialization
  *
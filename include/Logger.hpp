@@ -37,9 +37,11 @@
 #include <filesystem>
 #include <stdexcept>
 #include <cstdlib>
+#include <mutex>
 
 #include "LoggingLevels.hpp"
 #include "DPMDefaults.hpp"
+#include "AsyncLogWriter.hpp"
 
 /**
  * @class Logger
@@ -48,7 +50,9 @@
  * Implements a configurable logging system that can write messages to
  * both console and file outputs. Supports different log levels to
  * control verbosity and includes automatic timestamp generation for
- * log file entries.
+ * log file entries.  Log file entries are appended by an AsyncLogWriter
+ * in the background; FATAL messages and the end of the process wait for
+ * them to reach the file.
  */
 class Logger {
 public:
@@ -61,6 +65,8 @@ public:
 
     /**
      * @brief Destructor
+     *
+     * Writes out any log file entries still queued.
      */
     ~Logger();
 
@@ -70,7 +76,9 @@ public:
      * Writes a log message to the console and optionally to a log file
      * if the message level is less than or equal to the configured log level.
      * Messages with levels FATAL, ERROR, or WARN are written to stderr,
-     * while others go to stdout. File logging includes timestamps.
+     * while others go to stdout. File logging includes timestamps, and is
+     * queued for the background writer unless the message is FATAL, which
+     * waits until everything logged so far is in the file.
      * 
      * @param log_level The severity level of the message
      * @param message The message to log
@@ -89,6 +97,14 @@ public:
      */
     void log_console(LoggingLevels level, const std::string& message);
 
+    /**
+     * @brief Writes out everything logged so far
+     *
+     * Flushes the console streams and waits for the log file entries
+     * queued so far.  Needed before a process leaves through _exit().
+     */
+    void flush();
+
     /**
      * @brief Sets the log file path
      * 
@@ -119,6 +135,14 @@ public:
      */
     void setLogLevel(LoggingLevels log_level);
 
+    /**
+     * @brief Checks whether messages of a log level are processed
+     *
+     * @param level The severity level to check
+     * @return true if the level is within the configured log level threshold
+     */
+    bool isEnabled(LoggingLevels level) const;
+
     /**
      * @brief Converts a log level string to the corresponding enum value
      * 
@@ -157,6 +181,16 @@ private:
      * @brief The path to the log file
      */
     std::string log_file;
+
+    /**
+     * @brief Serialises output so that modules may log from worker threads
+     */
+    std::mutex log_mutex;
+
+    /**
+     * @brief Appends log file entries in the background
+     */
+    AsyncLogWriter file_writer;
 };
 
 /**
@@ -0,0 +1,170 @@
+/**
+ * @file Metrics.hpp
+ * @brief Counters and observations of a DPM invocation, exported with --metrics-file
+ *
+ * Defines the Metrics class, which sums the counters and observations the
+ * core and its modules record through dpm_metric_add and
+ * dpm_metric_observe, and writes them out in the Prometheus text format or
+ * as JSON when the invocation ends.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+*/
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Logger.hpp"
+
+/**
+ * @brief Most distinct metrics an invocation can record
+ */
+#define METRICS_MAX 128
+
+/**
+ * @class Metrics
+ * @brief Named counters and observations, summed across threads
+ *
+ * A counter is a running total, such as bytes hashed.  An observation
+ * keeps the count, sum and largest of the values observed, such as the
+ * seconds taken by each package verified.  A metric is a counter or an
+ * observation by the first call that records it.
+ *
+ * Each thread records into slots of its own, with no lock and no atomic
+ * read-modify-write, and finds a metric it has recorded before by the
+ * address of its name, so metrics are best named by string literals.  The
+ * slots of all threads are added together when the metrics are written.
+ * When metrics are disabled recording costs one atomic load.
+ */
+class Metrics {
+public:
+    Metrics();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    /**
+     * @brief Starts recording metrics
+     */
+    void enable();
+
+    /**
+     * @brief Checks whether metrics are being recorded
+     *
+     * @return true once enable has been called
+     */
+    bool enabled() const;
+
+    /**
+     * @brief Adds to a counter
+     *
+     * @param name Name of the counter, a Prometheus metric name such as "dpm_bytes_hashed_total"
+     * @param value Amount to add
+     */
+    void add(const char* name, uint64_t value);
+
+    /**
+     * @brief Records one value of an observation
+     *
+     * @param name Name of the observation, a Prometheus metric name such as "dpm_verify_package_seconds"
+     * @param value The observed value
+     */
+    void observe(const char* name, double value);
+
+    /**
+     * @brief Writes the metrics in the Prometheus text exposition format
+     *
+     * Counters are written as counters, observations as summaries with
+     * _sum and _count, and a _max gauge beside them.
+     *
+     * @param out Stream to write to
+     */
+    void write_prometheus(std::ostream& out);
+
+    /**
+     * @brief Writes the metrics as a JSON object of "counters" and "observations"
+     *
+     * @param out Stream to write to
+     */
+    void write_json(std::ostream& out);
+
+    /**
+     * @brief Writes the metrics to a file, as JSON when its name ends in .json and as Prometheus text otherwise
+     *
+     * @param path File to write
+     * @return true if the file was written, false otherwise
+     */
+    bool write_file(const std::string& path);
+
+private:
+    enum Kind {
+        COUNTER,
+        OBSERVATION
+    };
+
+    struct Slot {
+        std::atomic<uint64_t> count{0};
+        std::atomic<double> sum{0.0};
+        std::atomic<double> max{0.0};
+    };
+
+    struct ThreadSlots {
+        Slot slots[METRICS_MAX];
+        std::unordered_map<const char*, int> known;
+    };
+
+    struct Total {
+        uint64_t count = 0;
+        double sum = 0.0;
+        double max = 0.0;
+    };
+
+    static ThreadSlots& thread_slots();
+    int find(ThreadSlots& slots, const char* name, Kind kind);
+    void collect(std::vector<Total>& totals);
+
+    std::string _names[METRICS_MAX];
+    Kind _kinds[METRICS_MAX];
+    std::vector<ThreadSlots*> _threads;
+    size_t _count;
+    bool _full_warned;
+    std::mutex _mutex;
+    std::atomic<bool> _enabled;
+};
+
+/**
+ * @brief Global metrics instance
+ *
+ * Enabled by --metrics-file, and shared through the dpmdk with every module.
+ */
+extern Metrics g_metrics;
@@ -0,0 +1,187 @@
+/**
+ * @file ModuleIndex.hpp
+ * @brief Persistent index of module metadata for listing modules without loading them
+ *
+ * Defines the ModuleIndex class which keeps the name, path, modification
+ * time, size, version, description and exported interface symbols of every
+ * module in a module path, in the file named by [modules] index_path.  An
+ * entry is used only while the module's file keeps the same modification
+ * time and size, and is refreshed by loading the module otherwise, so
+ * "dpm -l" opens no module whose file is unchanged since the last listing.
+ *
+ * The index is a text file with one module per line, its fields separated
+ * by tabs:
+ *
+ *     # dpm module index v1
+ *     # module_path: /usr/lib/dpm/modules/
+ *     <name> <path> <mtime ns> <size> <valid 0|1> <symbols,...> <version> <description>
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <cstdint>
+#include <unistd.h>
+
+/**
+ * @brief Version line that opens a module index file
+ */
+#define MODULE_INDEX_HEADER "# dpm module index v1"
+
+/**
+ * @struct ModuleIndexEntry
+ * @brief What the index records about one module
+ */
+struct ModuleIndexEntry {
+    /**
+     * @brief Name of the module, its file name without .so
+     */
+    std::string name;
+
+    /**
+     * @brief Full path to the module's shared object
+     */
+    std::string path;
+
+    /**
+     * @brief Modification time of the shared object, in nanoseconds since the epoch
+     */
+    int64_t mtime = 0;
+
+    /**
+     * @brief Size of the shared object, in bytes
+     */
+    uint64_t size = 0;
+
+    /**
+     * @brief Whether the module loaded and exports every required symbol
+     */
+    bool valid = false;
+
+    /**
+     * @brief Required interface symbols the module exports
+     */
+    std::vector<std::string> symbols;
+
+    /**
+     * @brief Version string reported by the module
+     */
+    std::string version;
+
+    /**
+     * @brief Description reported by the module
+     */
+    std::string description;
+};
+
+/**
+ * @class ModuleIndex
+ * @brief Reads, refreshes and writes the module index file
+ */
+class ModuleIndex {
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param index_path Path of the index file
+         */
+        explicit ModuleIndex(std::string index_path);
+
+        /**
+         * @brief Reads the index recorded for a module path
+         *
+         * An index missing, unreadable, of another version or recorded for
+         * another module path is treated as empty.
+         *
+         * @param module_path Module path the caller lists
+         * @return true if entries were read, false if the index starts empty
+         */
+        bool load(const std::string& module_path);
+
+        /**
+         * @brief Looks up an entry that still describes a module's file
+         *
+         * @param name Name of the module
+         * @param path Full path to the module's shared object
+         * @param mtime Current modification time of the shared object, in nanoseconds
+         * @param size Current size of the shared object, in bytes
+         * @return The entry, or nullptr if there is none or the file changed since it was recorded
+         */
+        const ModuleIndexEntry* find(const std::string& name, const std::string& path,
+                                     int64_t mtime, uint64_t size) const;
+
+        /**
+         * @brief Records an entry, replacing any previous entry of the module
+         *
+         * @param entry The entry to record
+         */
+        void update(const ModuleIndexEntry& entry);
+
+        /**
+         * @brief Drops the entries of modules no longer in the module path
+         *
+         * @param names Names of the modules present
+         */
+        void retain(const std::vector<std::string>& names);
+
+        /**
+         * @brief Writes the index if it changed since it was loaded
+         *
+         * The file is written beside the index and renamed over it, so readers
+         * never see a partial index.
+         *
+         * @return true if the index is up to date on disk, false if writing it failed
+         */
+        bool save();
+
+    private:
+        /**
+         * @brief Replaces the tabs and line breaks of a field with spaces
+         */
+        static std::string sanitize(const std::string& value);
+
+        /**
+         * @brief Path of the index file
+         */
+        std::string _index_path;
+
+        /**
+         * @brief Module path the index describes
+         */
+        std::string _module_path;
+
+        /**
+         * @brief Entries by module name
+         */
+        std::map<std::string, ModuleIndexEntry> _entries;
+
+        /**
+         * @brief Whether the entries differ from the file
+         */
+        bool _changed = false;
+};
@@ -41,6 +41,7 @@
 
 #include "error.hpp"
 #include "module_interface.hpp"
+#include "ModuleRegistry.hpp"
 
 /**
  * @class ModuleLoader
@@ -48,7 +49,9 @@
  *
  * Provides functionality for discovering, loading, validating, and executing
  * DPM modules from shared object files. Ensures that modules conform to the
- * required interface before allowing their execution.
+ * required interface before allowing their execution.  The module path is
+ * scanned and each module opened at most once per run, through the shared
+ * g_module_registry.
  */
 class ModuleLoader {
     public:
@@ -86,6 +89,9 @@ class ModuleLoader {
          * @brief Loads a module by name
          *
          * Attempts to dynamically load a module from the configured module path.
+         * The handle belongs to the module registry and remains valid for the
+         * rest of the run, so callers must not close it.  Loading the same
+         * module again returns the same handle, or the same error.
          *
          * @param module_name Name of the module to load
          * @param module_handle Reference to store the loaded module handle
@@ -93,6 +99,19 @@ class ModuleLoader {
          */
         DPMErrorCategory load_module(const std::string& module_name, void*& module_handle) const;
 
+        /**
+         * @brief Loads a module by name and takes a reference on it
+         *
+         * Like load_module, but the handle carries a reference of its own that
+         * the caller releases with dlclose, leaving the registry's handle open.
+         * This is how modules loading other modules share the core's handles.
+         *
+         * @param module_name Name of the module to load
+         * @param module_handle Reference to store the module handle
+         * @return DPMErrorCategory indicating success or failure
+         */
+        DPMErrorCategory acquire_module(const std::string& module_name, void*& module_handle) const;
+
         /**
          * @brief Executes a module with the specified command
          *
@@ -104,6 +123,18 @@ class ModuleLoader {
          */
         DPMErrorCategory execute_module(const std::string& module_name, const std::string& command) const;
 
+        /**
+         * @brief Executes a module with arguments that are already split
+         *
+         * The arguments reach the module as they are, without being joined or
+         * split again, so arguments holding spaces or quotes arrive intact.
+         *
+         * @param module_name Name of the module to execute
+         * @param args Arguments to pass to the module, the first being its command
+         * @return DPMErrorCategory indicating success or failure
+         */
+        DPMErrorCategory execute_module(const std::string& module_name, const std::vector<std::string>& args) const;
+
         /**
          * @brief Gets a module's version information
          *
@@ -0,0 +1,145 @@
+/**
+ * @file ModuleRegistry.hpp
+ * @brief In-process registry of the modules found in the module path
+ *
+ * Defines the ModuleRegistry class which scans the module path once per run
+ * and remembers every module found there, along with the handle of each
+ * module once it has been loaded and validated.  Every lookup after the scan
+ * is a hash table lookup, and a module is opened at most once per run no
+ * matter how many times the core, or another module through
+ * dpm_acquire_module, asks for it.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "error.hpp"
+
+/**
+ * @struct ModuleRegistryEntry
+ * @brief A module found in the module path
+ */
+struct ModuleRegistryEntry {
+    /**
+     * @brief Full path to the module's shared object
+     */
+    std::string path;
+
+    /**
+     * @brief Modification time of the shared object when scanned, in nanoseconds since the epoch
+     */
+    int64_t mtime = 0;
+
+    /**
+     * @brief Size of the shared object when scanned, in bytes
+     */
+    uint64_t size = 0;
+
+    /**
+     * @brief Handle of the module once loaded and validated, nullptr until then
+     */
+    void* handle = nullptr;
+
+    /**
+     * @brief Whether loading the module has been attempted
+     */
+    bool attempted = false;
+
+    /**
+     * @brief Result of the load attempt, returned again to later callers
+     */
+    DPMErrorCategory status = DPMErrorCategory::SUCCESS;
+};
+
+/**
+ * @class ModuleRegistry
+ * @brief Caches the contents of the module path and the handles of loaded modules
+ *
+ * Handles held by the registry stay open until the process exits, so a
+ * module's code and state remain valid for every caller that was given it.
+ */
+class ModuleRegistry {
+    public:
+        /**
+         * @brief Scans a module path into the registry
+         *
+         * The directory is only read the first time a path is scanned.  Scanning
+         * a different path replaces the registry's view of the modules, but keeps
+         * the handles of modules already loaded open.
+         *
+         * @param module_path Directory path where DPM modules are located, ending with a slash
+         * @return DPMErrorCategory indicating success or failure
+         */
+        DPMErrorCategory scan(const std::string& module_path);
+
+        /**
+         * @brief Gets the names of the modules found by the last scan
+         *
+         * @return Module names in directory order
+         */
+        const std::vector<std::string>& names() const;
+
+        /**
+         * @brief Looks up a module by name
+         *
+         * @param module_name Name of the module
+         * @return The module's entry, or nullptr if the module path holds no such module
+         */
+        ModuleRegistryEntry* find(const std::string& module_name);
+
+    private:
+        /**
+         * @brief Module path the registry was last scanned from
+         */
+        std::string _module_path;
+
+        /**
+         * @brief Whether _module_path has been scanned
+         */
+        bool _scanned = false;
+
+        /**
+         * @brief Module names in directory order
+         */
+        std::vector<std::string> _names;
+
+        /**
+         * @brief Module entries by name
+         */
+        std::unordered_map<std::string, ModuleRegistryEntry> _entries;
+};
+
+/**
+ * @brief Global module registry instance
+ *
+ * Shared by every ModuleLoader and by the module interface functions, so all
+ * of them see the same scan and the same handles.
+ */
+extern ModuleRegistry g_module_registry;
@@ -0,0 +1,177 @@
+/**
+ * @file Profiler.hpp
+ * @brief Per-phase timing of a DPM invocation, reported with --profile
+ *
+ * Defines the Profiler class, which collects the time spent in named
+ * phases of an invocation, together with the bytes and files each phase
+ * handled, and reports them as a tree when the invocation ends.  Modules
+ * open and close phases through dpm_profile_begin and dpm_profile_end.
+ * With --trace-file every phase is also kept as an event of the thread
+ * that ran it, and written as Chrome trace-event JSON for Perfetto.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class Profiler
+ * @brief Tree of timed phases, collected when profiling is enabled
+ *
+ * A phase opened while another is open on the same thread is kept as a
+ * child of it, so the report shows where the time of each phase went.
+ * Phases opened on worker threads of the shared pool have no open parent
+ * and are reported at the top level, with the time of every thread added
+ * together, so their totals can exceed the wall time of the invocation.
+ *
+ * Phases are identified by name under their parent.  Each thread remembers
+ * the phases it has opened by the address of their name, so a phase named
+ * by a string literal is found again without taking the profiler's lock.
+ * When profiling is disabled opening a phase costs one atomic load.
+ *
+ * When tracing, closing a phase also appends an event to a buffer of the
+ * thread's own, so a trace shows how the work of each phase was spread
+ * over the threads and where they waited.
+ */
+class Profiler {
+public:
+    Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    /**
+     * @brief Starts collecting phases, and the wall time reported with them
+     */
+    void enable();
+
+    /**
+     * @brief Starts collecting phases as trace events of their threads too
+     */
+    void enable_trace();
+
+    /**
+     * @brief Checks whether phases are being collected
+     *
+     * @return true once enable has been called
+     */
+    bool enabled() const;
+
+    /**
+     * @brief Opens a phase on the calling thread
+     *
+     * @param name Name of the phase, copied the first time it is seen under the open phase
+     * @return Scope to close the phase with, or -1 when profiling is disabled
+     */
+    int begin(const char* name);
+
+    /**
+     * @brief Closes a phase, and any phase opened inside it and left open
+     *
+     * @param scope Scope returned by begin on the same thread, ignored when negative
+     * @param bytes Bytes handled by the phase
+     * @param files Files handled by the phase
+     */
+    void end(int scope, uint64_t bytes, uint64_t files);
+
+    /**
+     * @brief Writes the collected phases as an indented table
+     *
+     * @param out Stream to write the report to
+     */
+    void report(std::ostream& out);
+
+    /**
+     * @brief Writes the collected trace events as Chrome trace-event JSON
+     *
+     * Each phase is a complete ("X") event of its thread, with its bytes
+     * and files as arguments.  The file loads in Perfetto or chrome://tracing.
+     *
+     * @param out Stream to write the trace to
+     */
+    void write_trace(std::ostream& out);
+
+private:
+    struct Node {
+        std::string name;
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> nanoseconds{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> files{0};
+        std::vector<Node*> children;
+    };
+
+    struct Frame {
+        Node* node;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    struct TraceEvent {
+        const Node* node;
+        int64_t start;
+        int64_t duration;
+        uint64_t bytes;
+        uint64_t files;
+    };
+
+    struct TraceBuffer {
+        std::mutex mutex;
+        std::vector<TraceEvent> events;
+        size_t thread;
+    };
+
+    Node* child(Node* parent, const char* name);
+    void report_node(std::ostream& out, const Node* node, int depth);
+    TraceBuffer& trace_buffer();
+
+    static thread_local std::vector<Frame> _stack;
+    static thread_local std::map<std::pair<const Node*, const char*>, Node*> _known;
+
+    std::vector<std::unique_ptr<Node>> _nodes;
+    Node _root;
+    std::mutex _mutex;
+    std::vector<TraceBuffer*> _traces;
+    std::atomic<bool> _enabled;
+    std::atomic<bool> _tracing;
+    std::chrono::steady_clock::time_point _started;
+};
+
+/**
+ * @brief Global profiler instance
+ *
+ * Enabled by --profile, and shared through the dpmdk with every module.
+ */
+extern Profiler g_profiler;
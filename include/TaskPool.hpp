@@ -0,0 +1,198 @@
+/**
+ * @file TaskPool.hpp
+ * @brief Worker thread pool shared by the DPM core and its modules
+ *
+ * Defines the TaskPool class, a work-stealing pool of worker threads
+ * owned by the DPM core.  Modules reach it through dpm_submit_task,
+ * dpm_wait_group and dpm_parallel_for, so that every module running in
+ * a process shares one set of threads sized for the machine, instead
+ * of each starting threads of its own.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <new>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ConfigManager.hpp"
+#include "Logger.hpp"
+
+/**
+ * @brief Function run as a task, with the context it was submitted with
+ */
+typedef void (*dpm_task_function)(void* context);
+
+/**
+ * @brief Function run over a part of a range by dpm_parallel_for
+ */
+typedef void (*dpm_range_function)(void* context, size_t begin, size_t end);
+
+/**
+ * @struct dpm_task_group
+ * @brief Set of submitted tasks that can be waited for together
+ */
+struct dpm_task_group {
+    /**
+     * @brief Number of tasks submitted to the group that have not finished
+     */
+    std::atomic<size_t> outstanding{0};
+
+    /**
+     * @brief Guards waiting for the group
+     */
+    std::mutex mutex;
+
+    /**
+     * @brief Signalled when the last outstanding task of the group finishes
+     */
+    std::condition_variable finished;
+};
+
+/**
+ * @class TaskPool
+ * @brief Work-stealing pool of worker threads
+ *
+ * Each worker keeps a queue of its own.  Tasks submitted from a worker go
+ * to that worker's queue and are taken newest first, so nested work stays
+ * on the thread whose caches hold it; tasks submitted from other threads
+ * go to a shared queue.  A worker with nothing to do takes from the shared
+ * queue, then steals the oldest task of another worker.
+ *
+ * A thread waiting for a group runs queued tasks until the group is done,
+ * so tasks may submit tasks and wait for them without starving the pool.
+ * The workers are started on the first submission, sized by
+ * [performance] worker_threads or else by the CPUs the process may run on.
+ */
+class TaskPool {
+public:
+    TaskPool();
+
+    /**
+     * @brief Destructor, stops and joins the worker threads
+     */
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /**
+     * @brief Queues a task
+     *
+     * @param group Group the task belongs to, or nullptr to wait for it with no group
+     * @param function Function to run on a worker thread
+     * @param context Argument to pass to the function
+     */
+    void submit(dpm_task_group* group, dpm_task_function function, void* context);
+
+    /**
+     * @brief Runs queued tasks until every task of the group has finished
+     *
+     * @param group Group to wait for
+     */
+    void wait(dpm_task_group* group);
+
+    /**
+     * @brief Runs a function over a range split into parts of at least grain items
+     *
+     * Returns once every part has been run.  The calling thread runs parts too.
+     *
+     * @param begin First index of the range
+     * @param end One past the last index of the range
+     * @param grain Smallest number of indices given to one call, 0 picks one
+     * @param function Function to run over each part
+     * @param context Argument to pass to the function
+     */
+    void parallel_for(size_t begin, size_t end, size_t grain, dpm_range_function function, void* context);
+
+    /**
+     * @brief Gets the number of worker threads the pool runs
+     *
+     * @return [performance] worker_threads when set, otherwise the CPUs available to the process
+     */
+    size_t worker_count();
+
+    /**
+     * @brief Counts the CPUs the process may use
+     *
+     * Takes the CPU affinity mask of the process, limited by the CPU quota
+     * of its cgroup when one is set.
+     *
+     * @return Number of CPUs, at least one
+     */
+    static size_t available_cpus();
+
+private:
+    struct Task {
+        dpm_task_function function;
+        void* context;
+        dpm_task_group* group;
+    };
+
+    struct WorkerQueue {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+    };
+
+    size_t configured_count();
+    void start();
+    void worker_loop(size_t worker_index);
+    bool take(Task& task);
+    void run(const Task& task);
+
+    static void prepare_fork();
+    static void parent_after_fork();
+    static void child_after_fork();
+
+    std::vector<std::unique_ptr<WorkerQueue>> _queues;
+    std::vector<std::unique_ptr<std::thread>> _workers;
+    std::deque<Task> _shared;
+    std::mutex _mutex;
+    std::condition_variable _task_available;
+    std::atomic<size_t> _queued;
+    std::atomic<bool> _started;
+    size_t _worker_count;
+    bool _stopping;
+};
+
+/**
+ * @brief Global task pool instance
+ *
+ * Shared by the DPM core and, through the dpmdk, by every module.
+ */
+extern TaskPool g_task_pool;
\ No newline at end of file
@@ -0,0 +1,140 @@
+/**
+ * @file dpm_daemon.hpp
+ * @brief Resident dpmd serving dpm invocations over a Unix socket
+ *
+ * "dpm --daemon" loads the configuration once, scans the module path, loads
+ * and validates every module and lets each warm itself through its optional
+ * dpm_module_preload export, then serves invocations on a Unix socket.  A
+ * plain dpm invocation that finds the socket hands its arguments, working
+ * directory and standard streams to the daemon instead of doing any of that
+ * itself, and exits with the code the invocation produced.
+ *
+ * Each invocation runs in a process forked from the daemon, so it starts
+ * from the warm state, writes straight to the caller's terminal or pipes,
+ * and cannot disturb the daemon or other invocations.  The request is read
+ * in that process too, so a client that stalls holds up nobody else.  It
+ * runs with the caller's environment and umask but the daemon's
+ * credentials, so the daemon only serves callers of its own user, and an
+ * invocation naming another --config-dir loads that configuration for
+ * itself.
+ *
+ * The protocol is one request per connection:
+ *
+ *     client -> daemon   DpmdRequestHeader, with stdin, stdout and stderr as SCM_RIGHTS
+ *     client -> daemon   payload: working directory, arguments and environment, each NUL-terminated
+ *     daemon -> client   int32 exit code, once the invocation finished
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "dpm_interface.hpp"
+#include "dpm_interface_helpers.hpp"
+#include "ModuleLoader.hpp"
+#include "ConfigManager.hpp"
+#include "Logger.hpp"
+#include "DPMDefaults.hpp"
+
+/**
+ * @brief Version of the dpmd protocol, checked on every request
+ */
+#define DPMD_PROTOCOL_VERSION 2
+
+/**
+ * @brief Largest request payload dpmd accepts, in bytes
+ */
+#define DPMD_MAX_PAYLOAD (1024 * 1024)
+
+/**
+ * @brief Seconds a client may take to send its request before the invocation is dropped
+ */
+#define DPMD_REQUEST_TIMEOUT 30
+
+/**
+ * @struct DpmdRequestHeader
+ * @brief Fixed-size start of a dpmd request
+ */
+struct DpmdRequestHeader {
+    uint32_t version;           /**< DPMD_PROTOCOL_VERSION */
+    uint32_t payload_size;      /**< Size of the payload that follows, in bytes */
+    uint32_t argument_count;    /**< Arguments after the working directory, the environment follows them */
+    uint32_t umask;             /**< umask of the client */
+};
+
+/**
+ * @struct DpmdRequest
+ * @brief A request as received by dpmd
+ */
+struct DpmdRequest {
+    int streams[3];                         /**< stdin, stdout and stderr of the client */
+    std::string working_directory;          /**< Working directory of the client */
+    std::vector<std::string> arguments;     /**< Arguments, without the program name */
+    std::vector<std::string> environment;   /**< Environment of the client, as NAME=value */
+    mode_t umask;                           /**< umask of the client */
+};
+
+/**
+ * @brief Gets the socket dpmd serves on
+ *
+ * @return DPMD_SOCKET when set, DPMDefaults::DAEMON_SOCKET otherwise, empty if DPMD_SOCKET is set but empty
+ */
+std::string dpmd_socket_path();
+
+/**
+ * @brief Hands an invocation to a running dpmd
+ *
+ * Does nothing, and returns false, when no daemon answers on the socket,
+ * so the caller runs the invocation itself.
+ *
+ * @param argc Number of command-line arguments
+ * @param argv Array of C-style strings containing the arguments
+ * @param exit_code Receives the exit code of the invocation
+ * @return true if the daemon ran the invocation, false otherwise
+ */
+bool dpmd_forward(int argc, char* argv[], int& exit_code);
+
+/**
+ * @brief Runs as dpmd until SIGTERM or SIGINT
+ *
+ * Expects the configuration to be loaded already.
+ *
+ * @param args Parsed command-line arguments of the daemon
+ * @return 0 once stopped, 1 if the daemon could not start
+ */
+int dpmd_serve(const CommandArgs& args);
@@ -30,16 +30,22 @@
 
 #pragma once
 #include <iostream>
+#include <chrono>
 #include <vector>
 #include <iomanip>
 #include <filesystem>
 #include <dlfcn.h>
 #include <getopt.h>
+#include <fstream>
 
 #include "error.hpp"
 #include "ModuleLoader.hpp"
+#include "ModuleIndex.hpp"
+#include "DPMDefaults.hpp"
 #include "dpm_interface_helpers.hpp"
 #include "Logger.hpp"
+#include "Profiler.hpp"
+#include "Metrics.hpp"
 
 #include <handlers.hpp>
 
@@ -98,10 +104,81 @@ int main_show_help();
  *
  * @param loader Reference to a ModuleLoader object that provides access to modules
  * @param module_name Name of the module to execute
- * @param command Command string to pass to the module
+ * @param args Arguments to pass to the module, the first being its command
  * @return 0 on successful execution, appropriate error code otherwise
  */
-int main_execute_module( const ModuleLoader& loader, std::string module_name, std::string command );
+int main_execute_module( const ModuleLoader& loader, std::string module_name, const std::vector<std::string>& args );
 
+/**
+ * @brief Executes a batch of module invocations in one process
+ *
+ * Reads one invocation per line, the module name followed by its arguments
+ * as split by split_batch_line, and runs them in order.  Modules stay loaded
+ * from one invocation to the next.  The batch stops at the first invocation
+ * that fails.
+ *
+ * @param loader Reference to a ModuleLoader object that provides access to modules
+ * @param batch_file Path of the batch file, "-" for stdin
+ * @return 0 if every invocation succeeded, the exit code of the one that failed otherwise
+ */
+int main_execute_batch(const ModuleLoader& loader, const std::string& batch_file);
+
+/**
+ * @brief Loads the configuration and configures the logger for an invocation
+ *
+ * Uses the configuration directory from the arguments, or the default one,
+ * and applies the [logging] settings to the global logger.
+ *
+ * @param args Parsed command-line arguments
+ */
+void main_configure(const CommandArgs& args);
+
+/**
+ * @brief Determines the module path for an invocation
+ *
+ * The module path comes from the command line, then the configuration,
+ * then the default, in that order of precedence.
+ *
+ * @param args Parsed command-line arguments
+ * @return The module path
+ */
+std::string main_resolve_module_path(const CommandArgs& args);
+
+/**
+ * @brief Carries out a configured invocation
+ *
+ * Shows help, lists modules or executes a module, as the arguments ask.
+ *
+ * @param args Parsed command-line arguments
+ * @return Exit code indicating success (0) or failure (non-zero)
+ */
+int main_dispatch(const CommandArgs& args);
+
+
+/** @} */ // end of dpm_interface group
 
-/** @} */ // end of dpm_interface group
\ No newline at end of file
+/**
+ * @brief Writes the --profile report of an invocation
+ *
+ * Writes to the --profile-file given, or to stderr.
+ *
+ * @param args Parsed command-line arguments
+ * @return 0 on success, 1 if the report file cannot be written
+ */
+int main_write_profile(const CommandArgs& args);
+
+/**
+ * @brief Writes the metrics of an invocation to its --metrics-file
+ *
+ * @param args Parsed command-line arguments
+ * @return 0 on success, 1 if the metrics file cannot be written
+ */
+int main_write_metrics(const CommandArgs& args);
+
+/**
+ * @brief Writes the trace events of an invocation to its --trace-file
+ *
+ * @param args Parsed command-line arguments
+ * @return 0 on success, 1 if the trace file cannot be written
+ */
+int main_write_trace(const CommandArgs& args);
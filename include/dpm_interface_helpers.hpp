@@ -34,6 +34,7 @@
 #include <iostream>
 #include <getopt.h>
 #include <cstring>
+#include <vector>
 
 #include "Logger.hpp"
 #include "LoggingLevels.hpp"
@@ -52,8 +53,15 @@ struct CommandArgs {
     std::string config_dir;   /**< Path to the directory containing configuration files */
     std::string module_name;  /**< Name of the module to execute */
     std::string command;      /**< Command string to pass to the module */
+    std::vector<std::string> module_args; /**< Arguments to pass to the module, exactly as given */
+    std::string batch_file;   /**< File of module invocations to run in one process, "-" for stdin */
     bool list_modules;        /**< Flag to indicate if modules should be listed */
     bool show_help;           /**< Flag to indicate if help message should be shown */
+    bool daemon;              /**< Flag to indicate if DPM should run as the dpmd daemon */
+    bool profile;             /**< Flag to indicate if the phases of the invocation should be timed and reported */
+    std::string profile_file; /**< File to write the profile report to, stderr when empty */
+    std::string metrics_file; /**< File to export the invocation's metrics to, none when empty */
+    std::string trace_file;   /**< File to write the invocation's trace events to, none when empty */
 };
 
 /**
@@ -61,11 +69,28 @@ struct CommandArgs {
  *
  * Processes the arguments provided to DPM and organizes them into a
  * CommandArgs structure for easier access. Handles options like
- * --module-path, --config-dir, --list-modules, and --help, as well as module names
+ * --module-path, --config-dir, --list-modules, --batch, --daemon, --profile,
+ * --profile-file, --metrics-file, --trace-file and --help, as well as module names
  * and module-specific arguments.
  *
  * @param argc Number of command-line arguments
  * @param argv Array of C-style strings containing the arguments
  * @return A CommandArgs structure containing the parsed arguments
  */
-CommandArgs parse_args(int argc, char* argv[]);
\ No newline at end of file
+CommandArgs parse_args(int argc, char* argv[]);
+
+/**
+ * @brief Splits a line of a batch file into words
+ *
+ * Words are separated by blanks, as in a shell.  Single quotes keep
+ * everything up to the next single quote, double quotes keep everything up
+ * to the next unescaped double quote with backslash escaping " and \, and a
+ * backslash outside quotes escapes the next character.  A # at the start of
+ * a word begins a comment that runs to the end of the line.
+ *
+ * @param line The line to split
+ * @param words Receives the words of the line, none for a blank or comment line
+ * @param error Receives a description of the problem when the line cannot be split
+ * @return true if the line was split, false if a quote is left open
+ */
+bool split_batch_line(const std::string& line, std::vector<std::string>& words, std::string& error);
@@ -37,6 +37,9 @@
 #include "ConfigManager.hpp"
 #include "LoggingLevels.hpp"
 #include "Logger.hpp"
+#include "TaskPool.hpp"
+#include "Profiler.hpp"
+#include "Metrics.hpp"
 
 /**
  * @namespace module_interface
@@ -56,6 +59,16 @@ namespace module_interface {
         "dpm_module_get_version",
         "dpm_get_description"
     };
+
+    /**
+     * @brief Optional symbol a module may export to prepare for serving many invocations
+     *
+     * dpmd calls it once after loading the module, before serving any
+     * invocation, so the module can set up what it keeps from one invocation
+     * to the next, such as hash engines or a GPGME session.  It takes no
+     * arguments and returns 0 on success.
+     */
+    static const char* const preload_symbol = "dpm_module_preload";
 }
 
 /**
@@ -110,6 +123,21 @@ extern "C" {
      */
     const char* dpm_get_config(const char* section, const char* key);
 
+    /**
+     * @brief Resolves a configuration key once, for reading its value many times
+     *
+     * Returns a pointer to a slot holding the key's current value, NULL while
+     * the key is not set.  The slot stays valid for the life of the process
+     * and follows reloads of the configuration, so a module can resolve a key
+     * once and read it on hot paths with a single pointer read.  Implemented
+     * by the DPM core and available to all modules.
+     *
+     * @param section The configuration section name
+     * @param key The configuration key within the section
+     * @return Pointer to the value slot, or NULL if key is NULL
+     */
+    const char* const* dpm_config_resolve(const char* section, const char* key);
+
     /**
      * @brief Logs messages through the DPM logging system
      *
@@ -132,6 +160,17 @@ extern "C" {
      */
     void dpm_con(int level, const char* message);
 
+    /**
+     * @brief Checks whether messages of a log level are logged
+     *
+     * Allows modules to skip building messages the configured log level
+     * would discard. Implemented by the DPM core and available to all modules.
+     *
+     * @param level The log level as an integer (0=FATAL, 1=ERROR, 2=WARN, 3=INFO, 4=DEBUG)
+     * @return 1 if messages of the level are logged, 0 otherwise
+     */
+    int dpm_log_enabled(int level);
+
     /**
      * @brief Sets the logging level
      *
@@ -152,5 +191,112 @@ extern "C" {
      * @return The module path as a string
      */
     const char* dpm_get_module_path(void);
+
+    /**
+     * @brief Loads a module through the DPM core's module registry
+     *
+     * Allows modules to load other modules without opening or validating them
+     * a second time.  The handle is the one the core uses for the module, with
+     * a reference of its own that the caller releases with dlclose.
+     *
+     * @param module_name Name of the module to load
+     * @param module_handle Pointer to store the module handle
+     * @return 0 on success, non-zero on failure
+     */
+    int dpm_acquire_module(const char* module_name, void** module_handle);
+
+    /**
+     * @brief Creates a group to submit tasks to the shared worker pool under
+     *
+     * Implemented by the DPM core, whose worker threads are shared by every
+     * module so that modules running together do not oversubscribe the CPUs.
+     *
+     * @return The new group, released with dpm_task_group_destroy
+     */
+    dpm_task_group* dpm_task_group_create(void);
+
+    /**
+     * @brief Waits for a group's tasks and releases the group
+     *
+     * @param group Group from dpm_task_group_create
+     */
+    void dpm_task_group_destroy(dpm_task_group* group);
+
+    /**
+     * @brief Queues a task on the shared worker pool
+     *
+     * @param group Group to wait for the task with, or NULL to not wait for it
+     * @param function Function to run on a worker thread
+     * @param context Argument to pass to the function
+     */
+    void dpm_submit_task(dpm_task_group* group, dpm_task_function function, void* context);
+
+    /**
+     * @brief Waits until every task submitted to a group has finished
+     *
+     * The calling thread runs queued tasks while it waits, so tasks may
+     * submit tasks of their own and wait for them.
+     *
+     * @param group Group to wait for
+     */
+    void dpm_wait_group(dpm_task_group* group);
+
+    /**
+     * @brief Runs a function over a range on the shared worker pool
+     *
+     * @param begin First index of the range
+     * @param end One past the last index of the range
+     * @param grain Smallest number of indices given to one call, 0 picks one
+     * @param function Function to run over each part of the range
+     * @param context Argument to pass to the function
+     */
+    void dpm_parallel_for(size_t begin, size_t end, size_t grain, dpm_range_function function, void* context);
+
+    /**
+     * @brief Gets the number of threads of the shared worker pool
+     *
+     * @return [performance] worker_threads when set, otherwise the CPUs available to the process
+     */
+    size_t dpm_worker_threads(void);
+
+    /**
+     * @brief Checks whether the invocation is being profiled with --profile
+     *
+     * @return 1 if phases are being collected, 0 otherwise
+     */
+    int dpm_profile_enabled(void);
+
+    /**
+     * @brief Opens a profiled phase on the calling thread
+     *
+     * @param name Name of the phase, a string literal
+     * @return Scope to close the phase with, -1 when profiling is disabled
+     */
+    int dpm_profile_begin(const char* name);
+
+    /**
+     * @brief Closes a profiled phase
+     *
+     * @param scope Scope returned by dpm_profile_begin on the same thread
+     * @param bytes Bytes handled by the phase
+     * @param files Files handled by the phase
+     */
+    void dpm_profile_end(int scope, uint64_t bytes, uint64_t files);
+
+    /**
+     * @brief Adds to a counter exported with --metrics-file
+     *
+     * @param name Name of the counter, a Prometheus metric name
+     * @param value Amount to add
+     */
+    void dpm_metric_add(const char* name, uint64_t value);
+
+    /**
+     * @brief Records one value of an observation exported with --metrics-file
+     *
+     * @param name Name of the observation, a Prometheus metric name
+     * @param value The observed value
+     */
+    void dpm_metric_observe(const char* name, double value);
 }
 /** @} */
\ No newline at end of file
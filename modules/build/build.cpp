@@ -34,6 +34,8 @@
 #include "include/helpers.hpp"
 #include "include/commands.hpp"
 #include "include/cli_parsers.hpp"
+#include "include/checksums.hpp"
+#include "include/hash_backend.hpp"
 
 /**
  * @def MODULE_VERSION
@@ -67,6 +69,32 @@ extern "C" const char* dpm_get_description(void) {
     return "Creates DPM packages according to specification.";
 }
 
+/**
+ * @brief Prepares the module for serving many invocations from one process
+ *
+ * Optional implementation of the DPM module interface, called by dpmd once
+ * after loading the module.  Looks up the configured hash algorithms and
+ * initialises GPGME, so the invocations dpmd serves start with both done.
+ *
+ * @return 0 on success, non-zero on failure
+ */
+extern "C" int dpm_module_preload(void) {
+    int result = 0;
+    for (const auto& algorithm : get_configured_hash_algorithms()) {
+        if (!hash_backend_find_algorithm(algorithm)) {
+            dpm_log(LOG_WARN, ("Configured hash algorithm is not available: " + algorithm).c_str());
+            result = 1;
+        }
+    }
+
+    // a host without an OpenPGP engine still builds unsigned packages
+    if (!signing_preload()) {
+        dpm_log(LOG_DEBUG, "GPGME is not available, signatures will not be preloaded");
+    }
+
+    return result;
+}
+
 /**
  * @brief Main entry point for the build module
  *
@@ -104,6 +132,15 @@ extern "C" int dpm_module_execute(const char* command, int argc, char** argv) {
         case CMD_UNSEAL:
             return cmd_unseal(argc, argv);
 
+        case CMD_BENCH_IO:
+            return cmd_bench_io(argc, argv);
+
+        case CMD_DELTA:
+            return cmd_delta(argc, argv);
+
+        case CMD_INSTALL:
+            return cmd_install(argc, argv);
+
         case CMD_UNKNOWN:
             default:
                 return cmd_unknown(command, argc, argv);
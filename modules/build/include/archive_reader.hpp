@@ -7,13 +7,144 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <algorithm>
 #include <archive.h>
 #include <archive_entry.h>
 #include <unistd.h>
 #include <cstring>
 #include <cstdlib>
+#include <cstdint>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include "checksums.hpp"
+#include "compression.hpp"
+
+/**
+ * Size of the fixed read buffer used when streaming components out of a package file
+ */
+#define PACKAGE_STREAM_BLOCK_SIZE (64 * 1024)
+
+/**
+ * Size of the blocks a package file is read from disk in when its components are streamed
+ */
+#define PACKAGE_READ_BLOCK_SIZE (1024 * 1024)
+
+/**
+ * Returns the portion of an archive entry path after its leading directory
+ *
+ * @param entry_path Path of the entry as stored in the archive
+ * @return Pointer into entry_path past the first '/', or an empty string if there is none
+ */
+const char* strip_archive_parent(const char* entry_path);
+
+/**
+ * Checks whether package reads should ask the kernel to read ahead in the background
+ *
+ * On unless the package_readahead key of the build section is 0, false, no or off.
+ *
+ * @return true if readahead hints are issued
+ */
+bool package_readahead_enabled();
+
+/**
+ * Opens a package file for sequential reading
+ *
+ * @param package_path Path to the package file (.dpm)
+ * @return The descriptor, hinted for sequential access, or -1 on failure with errno set
+ */
+int package_file_open(const char* package_path);
+
+/**
+ * Starts reading a byte range of an open package file in the background
+ *
+ * Does nothing when readahead is disabled.
+ *
+ * @param fd Descriptor of the package file
+ * @param offset Offset of the range
+ * @param length Length of the range, 0 for everything from offset on
+ */
+void package_file_readahead(int fd, uint64_t offset, uint64_t length);
+
+/**
+ * Starts faulting in a range of a mapped package in the background
+ *
+ * Does nothing when readahead is disabled.
+ *
+ * @param data Start of the range, inside a mapping
+ * @param size Size of the range
+ */
+void package_memory_readahead(const unsigned char* data, size_t size);
+
+/**
+ * Callback invoked for each entry visited by checksum_memory_loaded_archive_entries
+ *
+ * @param entry_path Path of the entry with the component directory prefix removed
+ * @param checksum Hexadecimal checksum of the entry data, or NULL for non-regular files
+ * @param user_data Caller supplied context pointer
+ * @return 0 to continue walking the archive, non-zero to stop
+ */
+typedef int (*archive_entry_checksum_callback)(const char* entry_path, const char* checksum, void* user_data);
+
+/**
+ * Callback invoked for each entry visited by the _multi checksum walks
+ *
+ * @param entry_path Path of the entry with the component directory prefix removed
+ * @param checksums Hexadecimal checksums in the order of the requested algorithms, or NULL for non-regular files
+ * @param checksum_count Number of checksums, 0 for non-regular files
+ * @param user_data Caller supplied context pointer
+ * @return 0 to continue walking the archive, non-zero to stop
+ */
+typedef int (*archive_entry_checksums_callback)(const char* entry_path, const char* const* checksums,
+                                                size_t checksum_count, void* user_data);
+
+/**
+ * Callback invoked for each entry visited by read_memory_loaded_archive_entries
+ *
+ * @param entry_path Path of the entry with the component directory prefix removed
+ * @param data Entry data, only valid for the duration of the call, or NULL for non-regular files
+ * @param data_size Size of the entry data
+ * @param user_data Caller supplied context pointer
+ * @return 0 to continue walking the archive, non-zero to stop
+ */
+typedef int (*archive_entry_data_callback)(const char* entry_path, const unsigned char* data, size_t data_size, void* user_data);
+
+/**
+ * Callback invoked for each entry visited by take_memory_loaded_archive_entries
+ *
+ * @param entry_path Path of the entry with the component directory prefix removed
+ * @param data Entry data allocated with malloc, which the callback must free, or NULL for non-regular files
+ * @param data_size Size of the entry data
+ * @param user_data Caller supplied context pointer
+ * @return 0 to continue walking the archive, non-zero to stop
+ */
+typedef int (*archive_entry_buffer_callback)(const char* entry_path, unsigned char* data, size_t data_size, void* user_data);
+
+/**
+ * Allocator handing out the buffers entries are decompressed into
+ *
+ * Lets a caller keep extracted entries in storage of its own, such as a pool
+ * that is released all at once, instead of one malloc per entry.
+ *
+ * @param size Number of bytes needed, which may be 0
+ * @param allocator_data Caller supplied context pointer
+ * @return Buffer of at least size bytes, or NULL if none could be allocated
+ */
+typedef unsigned char* (*archive_entry_allocator)(size_t size, void* allocator_data);
+
+/**
+ * Entry reported by archive_iterator_next
+ *
+ * The strings point into the iterator and stay valid until the next call to
+ * archive_iterator_next or archive_iterator_close.
+ */
+struct archive_iterator_entry {
+    const char* path;           ///< Path with the component directory prefix removed
+    const char* archive_path;   ///< Path as stored in the archive
+    const char* link_target;    ///< Target of a symlink or hard link, NULL for other entries
+    uint64_t size;              ///< Size of the entry data
+    uint32_t mode;              ///< File type and permission bits, as in st_mode
+    int64_t mtime;              ///< Modification time, in seconds since the epoch
+};
 
 extern "C" {
     /**
@@ -40,4 +171,256 @@ extern "C" {
     bool get_file_from_memory_loaded_archive(const unsigned char* archive_data, const size_t archive_data_size,
                                             const char* file_path_in_archive,
                                             unsigned char** result_data, size_t* result_data_size);
-}
\ No newline at end of file
+
+    /**
+     * Like get_file_from_memory_loaded_archive, but extracts into a buffer from the caller's allocator
+     *
+     * @param archive_data Pointer to the archive data in memory
+     * @param archive_data_size Size of the archive data in memory
+     * @param file_path_in_archive Path of the file to extract within the archive
+     * @param allocator Allocator the file is extracted into, which owns the result
+     * @param allocator_data Context pointer passed through to the allocator
+     * @param result_data Pointer to buffer pointer - will be set to the allocated buffer
+     * @param result_data_size Pointer to size variable that will receive file size
+     * @return true on success, false on failure
+     */
+    bool get_file_from_memory_loaded_archive_into(const unsigned char* archive_data, const size_t archive_data_size,
+                                                  const char* file_path_in_archive,
+                                                  archive_entry_allocator allocator, void* allocator_data,
+                                                  unsigned char** result_data, size_t* result_data_size);
+
+    /**
+     * Walks an in-memory archive (gzipped tarball) once, hashing each entry as it is read
+     *
+     * Every regular file is streamed through the configured hash algorithm as its data
+     * blocks are decompressed, so no entry is ever buffered in full.  Directory entries
+     * are skipped; other non-regular entries (such as symlinks) are reported with a
+     * NULL checksum.  Entry paths have their leading component directory stripped so
+     * that they line up with the paths in CONTENTS_MANIFEST_DIGEST.
+     *
+     * @param archive_data Pointer to the archive data in memory
+     * @param archive_data_size Size of the archive data in memory
+     * @param callback Function invoked once per visited entry
+     * @param user_data Context pointer passed through to the callback
+     * @return true if the whole archive was walked, false on read errors or if the callback stopped the walk
+     */
+    bool checksum_memory_loaded_archive_entries(const unsigned char* archive_data, const size_t archive_data_size,
+                                                archive_entry_checksum_callback callback, void* user_data);
+
+    /**
+     * Like checksum_memory_loaded_archive_entries, but hashes each entry with several algorithms
+     *
+     * Every data block is fed to one digest per algorithm, so an entry is
+     * only decompressed once however many algorithms it is checked with.
+     *
+     * @param archive_data Pointer to the archive data in memory
+     * @param archive_data_size Size of the archive data in memory
+     * @param algorithms Names of the algorithms to hash with
+     * @param callback Function invoked once per visited entry
+     * @param user_data Context pointer passed through to the callback
+     * @return true if the whole archive was walked, false on read errors or if the callback stopped the walk
+     */
+    bool checksum_memory_loaded_archive_entries_multi(const unsigned char* archive_data, const size_t archive_data_size,
+                                                      const std::vector<std::string>& algorithms,
+                                                      archive_entry_checksums_callback callback, void* user_data);
+
+    /**
+     * Walks an in-memory archive (gzipped tarball) once, handing each entry's data to a callback
+     *
+     * Each regular file is decompressed into a reusable buffer and passed to the
+     * callback, which may copy it elsewhere (for instance to hash on another thread).
+     * Directory entries are skipped; other non-regular entries are reported with
+     * NULL data.  Entry paths have their leading component directory stripped.
+     *
+     * @param archive_data Pointer to the archive data in memory
+     * @param archive_data_size Size of the archive data in memory
+     * @param callback Function invoked once per visited entry
+     * @param user_data Context pointer passed through to the callback
+     * @return true if the whole archive was walked, false on read errors or if the callback stopped the walk
+     */
+    bool read_memory_loaded_archive_entries(const unsigned char* archive_data, const size_t archive_data_size,
+                                            archive_entry_data_callback callback, void* user_data);
+
+    /**
+     * Walks an in-memory archive (gzipped tarball) once, handing over each entry's data to a callback
+     *
+     * Like read_memory_loaded_archive_entries, but each regular file is
+     * decompressed into a buffer of its own that the callback keeps, so a
+     * caller that works on entries after the callback returns (for instance
+     * hashing them on other threads) never copies them.
+     *
+     * @param archive_data Pointer to the archive data in memory
+     * @param archive_data_size Size of the archive data in memory
+     * @param callback Function invoked once per visited entry, owning the data it is given
+     * @param user_data Context pointer passed through to the callback
+     * @return true if the whole archive was walked, false on read errors or if the callback stopped the walk
+     */
+    bool take_memory_loaded_archive_entries(const unsigned char* archive_data, const size_t archive_data_size,
+                                            archive_entry_buffer_callback callback, void* user_data);
+
+    /**
+     * Like take_memory_loaded_archive_entries, but decompresses into buffers from the caller's allocator
+     *
+     * The callback is handed each buffer the allocator returned; it belongs to
+     * the allocator, so the callback must not free it.
+     *
+     * @param archive_data Pointer to the archive data in memory
+     * @param archive_data_size Size of the archive data in memory
+     * @param allocator Allocator each regular file is decompressed into
+     * @param allocator_data Context pointer passed through to the allocator
+     * @param callback Function invoked once per visited entry
+     * @param user_data Context pointer passed through to the callback
+     * @return true if the whole archive was walked, false on read errors, failed allocations, or if the callback stopped the walk
+     */
+    bool take_memory_loaded_archive_entries_into(const unsigned char* archive_data, const size_t archive_data_size,
+                                                 archive_entry_allocator allocator, void* allocator_data,
+                                                 archive_entry_buffer_callback callback, void* user_data);
+
+    /**
+     * Streams a component out of a package file, hashing each entry as it is read
+     *
+     * The package is read with a fixed-size buffer and the component member is
+     * decompressed and untarred as it streams past, so memory use stays bounded
+     * regardless of the size of the package or of any entry within it.  Entries
+     * are reported exactly as by checksum_memory_loaded_archive_entries.
+     *
+     * @param package_path Path to the package file (.dpm)
+     * @param component_name Name of the component member, e.g. "contents"
+     * @param callback Function invoked once per visited entry
+     * @param user_data Context pointer passed through to the callback
+     * @return true if the whole component was walked, false on read errors or if the callback stopped the walk
+     */
+    bool checksum_package_component_entries(const char* package_path, const char* component_name,
+                                            archive_entry_checksum_callback callback, void* user_data);
+
+    /**
+     * Like checksum_package_component_entries, but hashes each entry with several algorithms
+     *
+     * @param package_path Path to the package file (.dpm)
+     * @param component_name Name of the component member, e.g. "contents"
+     * @param algorithms Names of the algorithms to hash with
+     * @param callback Function invoked once per visited entry
+     * @param user_data Context pointer passed through to the callback
+     * @return true if the whole component was walked, false on read errors or if the callback stopped the walk
+     */
+    bool checksum_package_component_entries_multi(const char* package_path, const char* component_name,
+                                                  const std::vector<std::string>& algorithms,
+                                                  archive_entry_checksums_callback callback, void* user_data);
+
+    /**
+     * Streams a component out of a package file, handing each entry's data to a callback
+     *
+     * Like read_memory_loaded_archive_entries, but reads the component straight
+     * out of the package file.  Each entry is buffered in full, so max_entry_size
+     * should be set when the entries are not known to be small.
+     *
+     * @param package_path Path to the package file (.dpm)
+     * @param component_name Name of the component member, e.g. "metadata"
+     * @param max_entry_size Largest entry that will be buffered, or 0 for no limit
+     * @param callback Function invoked once per visited entry
+     * @param user_data Context pointer passed through to the callback
+     * @return true if the whole component was walked, false on read errors, oversized entries, or if the callback stopped the walk
+     */
+    bool read_package_component_entries(const char* package_path, const char* component_name,
+                                        size_t max_entry_size,
+                                        archive_entry_data_callback callback, void* user_data);
+
+    /**
+     * Opens an iterator over an in-memory archive (compressed tarball)
+     *
+     * An iterator visits the entries of an archive in one forward pass: each
+     * call to archive_iterator_next moves to the next entry, whose data may
+     * then be read in chunks with archive_iterator_read or
+     * archive_iterator_read_block.  Data that is not read is skipped when the
+     * iterator moves on, so a caller can look at many entries of a component
+     * without rescanning it or buffering any entry in full.
+     *
+     * @param archive_data Pointer to the archive data, which must outlive the iterator
+     * @param archive_data_size Size of the archive data
+     * @return Opaque iterator handle, or NULL on failure
+     */
+    void* archive_iterator_open_memory(const unsigned char* archive_data, size_t archive_data_size);
+
+    /**
+     * Opens an iterator over an archive file, read with a fixed-size buffer
+     *
+     * @param archive_path Path to the archive file
+     * @return Opaque iterator handle, or NULL on failure
+     */
+    void* archive_iterator_open_file(const char* archive_path);
+
+    /**
+     * Opens an iterator over an archive read from a file descriptor
+     *
+     * The descriptor is read from its current position and is not closed by
+     * the iterator.
+     *
+     * @param fd Open file descriptor positioned at the start of the archive
+     * @return Opaque iterator handle, or NULL on failure
+     */
+    void* archive_iterator_open_fd(int fd);
+
+    /**
+     * Opens an iterator over a component streamed out of a package file
+     *
+     * Neither the package nor the component is held in memory, as with
+     * checksum_package_component_entries.
+     *
+     * @param package_path Path to the package file (.dpm)
+     * @param component_name Name of the component member, e.g. "contents"
+     * @return Opaque iterator handle, or NULL on failure
+     */
+    void* archive_iterator_open_package_component(const char* package_path, const char* component_name);
+
+    /**
+     * Moves an iterator to the next entry of its archive
+     *
+     * Every entry is reported, directories included; whatever is left of the
+     * previous entry's data is skipped.
+     *
+     * @param iterator Handle returned by one of the archive_iterator_open functions
+     * @param entry Receives the entry
+     * @return 1 if an entry was read, 0 at the end of the archive, -1 on read errors
+     */
+    int archive_iterator_next(void* iterator, archive_iterator_entry* entry);
+
+    /**
+     * Reads the next chunk of the current entry's data into a buffer
+     *
+     * @param iterator Handle returned by one of the archive_iterator_open functions
+     * @param buffer Buffer to read into
+     * @param buffer_size Size of the buffer
+     * @return Number of bytes read, 0 at the end of the entry data, -1 on read errors
+     */
+    long long archive_iterator_read(void* iterator, void* buffer, size_t buffer_size);
+
+    /**
+     * Gets the next block of the current entry's data without copying it
+     *
+     * The block points into the iterator and stays valid until the iterator
+     * is next used.  Blocks of a sparse entry may leave holes, which the
+     * offsets show; archive_iterator_read fills them with zeros instead.
+     *
+     * @param iterator Handle returned by one of the archive_iterator_open functions
+     * @param block Receives a pointer to the block
+     * @param block_size Receives the size of the block
+     * @param offset Receives the offset of the block within the entry, may be NULL
+     * @return 1 if a block was read, 0 at the end of the entry data, -1 on read errors
+     */
+    int archive_iterator_read_block(void* iterator, const void** block, size_t* block_size, uint64_t* offset);
+
+    /**
+     * Skips the rest of the current entry's data
+     *
+     * @param iterator Handle returned by one of the archive_iterator_open functions
+     * @return true on success, false on read errors
+     */
+    bool archive_iterator_skip(void* iterator);
+
+    /**
+     * Closes an iterator and releases its archive
+     *
+     * @param iterator Handle returned by one of the archive_iterator_open functions, may be NULL
+     */
+    void archive_iterator_close(void* iterator);
+}
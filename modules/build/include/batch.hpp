@@ -0,0 +1,170 @@
+/**
+ * @file batch.hpp
+ * @brief Sealing and signing of many stages or packages in a single run
+ *
+ * A release builds hundreds of packages; sealing and signing them one
+ * invocation at a time reloads the configuration, the modules and the
+ * signing key for every one.  A batch takes a list of stages or packages
+ * and runs them as tasks on the DPM core's shared worker pool, largest
+ * first, while keeping the bytes of the stages in flight within the
+ * batch_memory budget of the [build] section, so a few large stages are
+ * not sealed at once on top of each other.  The budget is charged by the
+ * size of each stage or package on disk; it bounds the working set, not
+ * the rate of reads and writes.  While a batch runs, the thread counts of
+ * hashing, walking, compressing, copying and extracting are shared between
+ * the items running at once, so the batch stays about as wide as the
+ * shared worker pool.  A failure is recorded and the batch carries on with
+ * the rest; one machine-readable result line is written per item, in
+ * input order, followed by a summary line.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "sealing.hpp"
+#include "signing.hpp"
+#include "helpers.hpp"
+#include "tree_walk.hpp"
+
+/**
+ * @brief Bytes of stages a batch keeps in flight when [build] batch_memory is not set
+ */
+#define BATCH_DEFAULT_MEMORY_BUDGET (4ULL * 1024 * 1024 * 1024)
+
+/**
+ * @brief How each stage of a batch seal is sealed
+ */
+enum class BatchSealMode {
+    COMPONENTS,     ///< Seal the components in place, as "dpm build seal"
+    FINAL,          ///< Also seal the stage as a final package, as --finalize
+    STREAM          ///< Write the final package in one pass, as --stream
+};
+
+/**
+ * @brief Outcome of one stage or package in a batch
+ */
+struct BatchResult {
+    std::string path;           ///< Stage directory or package file
+    uintmax_t size;             ///< Bytes of the stage or package, as charged to the budget
+    std::string status;         ///< "ok", "failed" or "missing"
+    double seconds;             ///< Wall time spent on the item, waiting for the budget excluded
+};
+
+/**
+ * @brief Bytes of work a batch lets run at once
+ *
+ * An item is admitted while the bytes already admitted and its own fit in
+ * the budget.  An item larger than the whole budget is charged the whole
+ * budget, so it runs alone rather than never.
+ */
+class BatchBudget {
+public:
+    /**
+     * @brief Creates a budget
+     *
+     * @param limit Bytes that may be in flight at once, 0 for no limit
+     */
+    explicit BatchBudget(uint64_t limit);
+
+    /**
+     * @brief Blocks until an item fits in the budget and charges it
+     *
+     * @param bytes Size of the item
+     * @return Bytes charged, to hand back to release
+     */
+    uint64_t acquire(uint64_t bytes);
+
+    /**
+     * @brief Returns the bytes charged for an item that has finished
+     *
+     * @param charged Value returned by acquire
+     */
+    void release(uint64_t charged);
+
+private:
+    uint64_t _limit;
+    uint64_t _in_flight;
+    std::mutex _mutex;
+    std::condition_variable _released;
+};
+
+/**
+ * @brief Reads stage or package paths from a list file
+ *
+ * One path per line; blank lines and lines starting with '#' are ignored.
+ * A list file of "-" is read from standard input.
+ *
+ * @param list_path Path of the list file, or "-"
+ * @param paths Receives the listed paths in order, expanded with expand_path
+ * @return 0 on success, non-zero if the list could not be read
+ */
+int read_batch_list(const std::string& list_path, std::vector<std::string>& paths);
+
+/**
+ * @brief Gets the number of items a batch works on at once
+ *
+ * Uses the "batch_jobs" key in the [build] configuration section, falling
+ * back to the number of threads of the shared worker pool when it is unset
+ * or 0.
+ *
+ * @return Number of items, always at least 1
+ */
+size_t batch_worker_count();
+
+/**
+ * @brief Gets the bytes of stages or packages a batch may have in flight
+ *
+ * Uses the "batch_memory" key in the [build] configuration section, where
+ * 0 lifts the limit, falling back to BATCH_DEFAULT_MEMORY_BUDGET.
+ *
+ * @return Budget in bytes, 0 for no limit
+ */
+uint64_t batch_memory_budget();
+
+/**
+ * @brief Seals many stages concurrently
+ *
+ * @param stages Stage directories to seal
+ * @param mode How to seal each stage
+ * @param output_dir Output directory for final packages, empty to write each next to its stage
+ * @param force Whether to force each seal even if warnings occur
+ * @param worker_count Number of stages to seal at once
+ * @param summary_path File to write the results to, or empty for standard output
+ * @return 0 if every stage was sealed, non-zero otherwise
+ */
+int seal_stages_batch(const std::vector<std::string>& stages, BatchSealMode mode, const std::string& output_dir,
+                      bool force, size_t worker_count, const std::string& summary_path);
+
+/**
+ * @brief Signs many stages or packages concurrently with one signing session
+ *
+ * The key is looked up once and every signature of the batch is made with it.
+ *
+ * @param paths Stage directories or package files to sign
+ * @param packages Whether the paths are package files rather than stage directories
+ * @param key_id GPG key ID or email to sign with
+ * @param force Whether to force each signing even if warnings occur
+ * @param worker_count Number of items to sign at once
+ * @param summary_path File to write the results to, or empty for standard output
+ * @return 0 if every item was signed, non-zero otherwise
+ */
+int sign_batch(const std::vector<std::string>& paths, bool packages, const std::string& key_id,
+               bool force, size_t worker_count, const std::string& summary_path);
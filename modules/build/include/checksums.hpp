@@ -3,7 +3,8 @@
  * @brief Functions for generating cryptographic checksums
  *
  * Provides functionality for generating checksums of files using
- * configurable cryptographic hash algorithms via OpenSSL.
+ * configurable cryptographic hash algorithms provided by the hash
+ * backends (OpenSSL, and BLAKE3 when available).
  *
  * @copyright Copyright (c) 2025 SILO GROUP LLC
  * @author Chris Punches <chris.punches@silogroup.org>
@@ -20,25 +21,54 @@
 #include <sstream>
 #include <iomanip>
 #include <dpmdk/include/CommonModuleAPI.hpp>
+#include "hash_backend.hpp"
 #include <vector>
 #include <cstring>
+#include <cstdint>
+#include <cerrno>
 #include <algorithm>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 /**
  * @brief Gets the configured hash algorithm or defaults to SHA-256
  *
  * Retrieves the hash algorithm configured in the cryptography section
- * or defaults to SHA-256 if not specified.
+ * or defaults to SHA-256 if not specified.  When a list of algorithms is
+ * configured this is the first one, which every digest file is built with.
  *
  * @return String containing the name of the hash algorithm to use
  */
 extern "C" std::string get_configured_hash_algorithm();
 
 /**
- * @brief Gets a list of available digest algorithms from OpenSSL
+ * @brief Gets every configured hash algorithm
  *
- * Retrieves a list of supported digest algorithms from OpenSSL's
- * internal algorithms list.
+ * checksum_algorithm may list several algorithms separated by commas or
+ * spaces, e.g. "sha256, sha512".  The first is the primary algorithm; the
+ * others are additionally recorded for every contents file so packages can
+ * carry digests for more than one algorithm while migrating between them.
+ *
+ * @return Configured algorithm names, primary first, never empty
+ */
+extern "C" std::vector<std::string> get_configured_hash_algorithms();
+
+/**
+ * @brief Checks whether any hash backend provides a digest algorithm
+ *
+ * @param algorithm Name of the algorithm
+ * @return true if the algorithm can be used for checksums, false otherwise
+ */
+extern "C" bool hash_algorithm_supported(const std::string& algorithm);
+
+/**
+ * @brief Gets a list of available digest algorithms
+ *
+ * Retrieves the supported digest algorithms of every hash backend, such as
+ * OpenSSL's internal algorithms list and blake3 when it is built in.
  *
  * @return String containing comma-separated list of available algorithms
  */
@@ -47,7 +77,7 @@ extern "C" std::string get_available_algorithms();
 /**
  * @brief Generates a file checksum using the configured hashing algorithm
  *
- * Uses OpenSSL to calculate a cryptographic hash of a file's contents
+ * Uses the hash backends to calculate a cryptographic hash of a file's contents
  * based on the algorithm specified in the configuration.
  * This method reads the file in chunks to handle large files efficiently.
  *
@@ -59,10 +89,314 @@ extern "C" std::string generate_file_checksum(const std::filesystem::path& file_
 /**
  * @brief Generates a checksum of a string using the configured hashing algorithm
  *
- * Uses OpenSSL to calculate a cryptographic hash of a string's contents
+ * Uses the hash backends to calculate a cryptographic hash of a string's contents
  * based on the algorithm specified in the configuration.
  *
  * @param input_string The string to be hashed
  * @return String containing the hexadecimal representation of the checksum, or empty string on error
  */
 extern "C" std::string generate_string_checksum(const std::string& input_string);
+
+/**
+ * @brief Digests a buffer with the configured hashing algorithm, in binary form
+ *
+ * A C interface for other modules that hash data they already hold, without
+ * first copying it into a std::string for generate_string_checksum.
+ *
+ * @param data Data to be hashed
+ * @param size Size of the data in bytes
+ * @param out Receives the binary digest, at least CHECKSUM_MAX_DIGEST_SIZE bytes
+ * @param out_len On input the size of out, on output the size of the digest
+ * @return 0 on success, non-zero if the algorithm is unavailable or out is too small
+ */
+extern "C" int dpm_digest_buffer(const void* data, size_t size, uint8_t* out, size_t* out_len);
+
+/**
+ * @brief Generates checksums of a file with several algorithms in a single read
+ *
+ * @param file_path Path to the file to be hashed
+ * @param algorithms Names of the algorithms to hash with
+ * @return Hexadecimal checksums in the order of algorithms, or an empty vector on error
+ */
+extern "C" std::vector<std::string> generate_file_checksums(const std::filesystem::path& file_path,
+                                                             const std::vector<std::string>& algorithms);
+
+/**
+ * @brief Generates checksums of a buffer with several algorithms in a single pass
+ *
+ * @param data Data to be hashed
+ * @param data_size Size of the data in bytes
+ * @param algorithms Names of the algorithms to hash with
+ * @return Hexadecimal checksums in the order of algorithms, or an empty vector on error
+ */
+extern "C" std::vector<std::string> generate_buffer_checksums(const unsigned char* data, size_t data_size,
+                                                               const std::vector<std::string>& algorithms);
+
+
+/**
+ * @brief Largest binary digest any supported algorithm produces, in bytes
+ */
+#define CHECKSUM_MAX_DIGEST_SIZE EVP_MAX_MD_SIZE
+
+/**
+ * @brief Default size up to which a file is hashed with a single read, in bytes
+ */
+#define CHECKSUM_DEFAULT_SMALL_FILE_MAX (256 * 1024)
+
+/**
+ * @brief Default size from which a file is hashed through a memory map, in bytes
+ */
+#define CHECKSUM_DEFAULT_MMAP_MIN (64 * 1024 * 1024)
+
+/**
+ * @brief Size of the aligned buffer used for positional reads, in bytes
+ */
+#define CHECKSUM_READ_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * @brief How a file is read while it is hashed
+ */
+enum ChecksumIoStrategy {
+    CHECKSUM_IO_AUTO,       /**< Pick a strategy from the file size */
+    CHECKSUM_IO_READ,       /**< Read the whole file in a single read */
+    CHECKSUM_IO_PREAD,      /**< Positional reads into an aligned buffer */
+    CHECKSUM_IO_MMAP        /**< Map the file and hash it in place */
+};
+
+/**
+ * @brief Receives the data of a file as it is read, returning false to stop reading
+ */
+typedef std::function<bool(const void* data, size_t size)> ChecksumDataSink;
+
+/**
+ * @brief Gets the printable name of an I/O strategy
+ *
+ * @param strategy Strategy to name
+ * @return Name of the strategy
+ */
+const char* checksum_io_strategy_name(ChecksumIoStrategy strategy);
+
+/**
+ * @brief Process-wide hashing engine for the configured checksum algorithm
+ *
+ * Resolves the configured algorithm once and keeps one reusable digest
+ * context per thread, so hashing many small inputs does not pay for a
+ * configuration lookup, an algorithm lookup and a context allocation every
+ * time.  Digests are returned in binary form; to_hex converts them with a
+ * lookup table when a textual checksum is needed.
+ *
+ * The begin/update/finish calls work on the calling thread's context, so
+ * each thread can only compute one digest at a time.
+ *
+ * Files are read with a strategy chosen from their size: small files in a
+ * single read, medium files with positional reads into a large aligned
+ * buffer and large files through a sequentially advised memory map.  The
+ * thresholds come from the checksum_small_file_max and checksum_mmap_min
+ * keys of the build section.
+ */
+class ChecksumEngine {
+public:
+    /**
+     * @brief Gets the engine, resolving the configured algorithm on first use
+     *
+     * @return Reference to the shared engine
+     */
+    static ChecksumEngine& instance();
+
+    /**
+     * @brief Checks whether the configured algorithm could be resolved
+     *
+     * @return true if the engine can hash, false otherwise
+     */
+    bool valid() const;
+
+    /**
+     * @brief Gets the name of the algorithm the engine hashes with
+     *
+     * @return Algorithm name as configured
+     */
+    const std::string& algorithm() const;
+
+    /**
+     * @brief Gets the size of the digests the engine produces
+     *
+     * @return Digest size in bytes, or 0 if the engine is not valid
+     */
+    size_t digest_size() const;
+
+    /**
+     * @brief Starts a new digest on the calling thread's context
+     *
+     * @return true on success, false on failure
+     */
+    bool begin();
+
+    /**
+     * @brief Feeds data into the digest started by begin
+     *
+     * @param data Data to hash
+     * @param size Size of the data in bytes
+     * @return true on success, false on failure
+     */
+    bool update(const void* data, size_t size);
+
+    /**
+     * @brief Completes the digest started by begin
+     *
+     * @param digest Receives the binary digest, at least CHECKSUM_MAX_DIGEST_SIZE bytes
+     * @param digest_size Receives the size of the digest in bytes
+     * @return true on success, false on failure
+     */
+    bool finish(unsigned char* digest, size_t* digest_size);
+
+    /**
+     * @brief Hashes a buffer in one call
+     *
+     * @param data Data to hash
+     * @param size Size of the data in bytes
+     * @param digest Receives the binary digest, at least CHECKSUM_MAX_DIGEST_SIZE bytes
+     * @param digest_size Receives the size of the digest in bytes
+     * @return true on success, false on failure
+     */
+    bool digest_buffer(const void* data, size_t size, unsigned char* digest, size_t* digest_size);
+
+    /**
+     * @brief Hashes the contents of a file
+     *
+     * @param file_path Path to the file to hash
+     * @param digest Receives the binary digest, at least CHECKSUM_MAX_DIGEST_SIZE bytes
+     * @param digest_size Receives the size of the digest in bytes
+     * @param strategy How to read the file, CHECKSUM_IO_AUTO picks one from its size
+     * @return true on success, false on failure
+     */
+    bool digest_file(const std::filesystem::path& file_path, unsigned char* digest, size_t* digest_size,
+                     ChecksumIoStrategy strategy = CHECKSUM_IO_AUTO);
+
+    /**
+     * @brief Reads a file with the I/O strategy chosen for its size
+     *
+     * Used by digest_file, and by callers that feed the same data to more
+     * than one digest.
+     *
+     * @param file_path Path to the file to read
+     * @param consume Receives the file data in order
+     * @param strategy How to read the file, CHECKSUM_IO_AUTO picks one from its size
+     * @return true if the whole file was read and consumed, false otherwise
+     */
+    bool read_file(const std::filesystem::path& file_path, const ChecksumDataSink& consume,
+                   ChecksumIoStrategy strategy = CHECKSUM_IO_AUTO);
+
+    /**
+     * @brief Picks the I/O strategy for a regular file of the given size
+     *
+     * @param file_size Size of the file in bytes
+     * @return CHECKSUM_IO_READ, CHECKSUM_IO_PREAD or CHECKSUM_IO_MMAP
+     */
+    ChecksumIoStrategy select_io_strategy(uint64_t file_size) const;
+
+    /**
+     * @brief Gets the size up to which files are hashed with a single read
+     *
+     * @return Threshold in bytes
+     */
+    uint64_t small_file_max() const;
+
+    /**
+     * @brief Gets the size from which files are hashed through a memory map
+     *
+     * @return Threshold in bytes
+     */
+    uint64_t mmap_min() const;
+
+    /**
+     * @brief Converts a binary digest to lowercase hexadecimal
+     *
+     * @param digest Binary digest
+     * @param size Size of the digest in bytes
+     * @param hex Receives the NUL-terminated hexadecimal text, at least size * 2 + 1 bytes
+     */
+    static void to_hex(const unsigned char* digest, size_t size, char* hex);
+
+    /**
+     * @brief Converts a binary digest to a lowercase hexadecimal string
+     *
+     * @param digest Binary digest
+     * @param size Size of the digest in bytes
+     * @return Hexadecimal representation of the digest
+     */
+    static std::string to_hex(const unsigned char* digest, size_t size);
+
+    ChecksumEngine(const ChecksumEngine&) = delete;
+    ChecksumEngine& operator=(const ChecksumEngine&) = delete;
+
+private:
+    ChecksumEngine();
+
+    DigestContext* thread_context();
+
+    bool read_descriptor_whole(int fd, const std::string& file_path, uint64_t file_size,
+                               const ChecksumDataSink& consume);
+    bool read_descriptor_pread(int fd, const std::string& file_path, const ChecksumDataSink& consume);
+    bool read_descriptor_mmap(int fd, const std::string& file_path, uint64_t file_size,
+                              const ChecksumDataSink& consume);
+
+    std::string _algorithm;
+    const DigestAlgorithm* _digest;
+    uint64_t _small_file_max;
+    uint64_t _mmap_min;
+};
+
+/**
+ * @brief Computes digests of the same data with several algorithms at once
+ *
+ * Every block handed to update is fed to one digest context per algorithm,
+ * so data that has to be hashed with more than one algorithm is only read
+ * once.
+ */
+class MultiChecksum {
+public:
+    /**
+     * @brief Resolves the algorithms and creates a digest context for each
+     *
+     * @param algorithms Names of the algorithms to hash with
+     */
+    explicit MultiChecksum(const std::vector<std::string>& algorithms);
+
+    /**
+     * @brief Checks whether every algorithm was resolved
+     *
+     * @return true if the digests can be computed, false otherwise
+     */
+    bool valid() const;
+
+    /**
+     * @brief Starts a new set of digests
+     *
+     * @return true on success, false on failure
+     */
+    bool begin();
+
+    /**
+     * @brief Feeds data into every digest
+     *
+     * @param data Data to hash
+     * @param size Size of the data in bytes
+     * @return true on success, false on failure
+     */
+    bool update(const void* data, size_t size);
+
+    /**
+     * @brief Completes every digest
+     *
+     * @param hex_digests Receives the hexadecimal digests in the order of the algorithms
+     * @return true on success, false on failure
+     */
+    bool finish(std::vector<std::string>& hex_digests);
+
+    MultiChecksum(const MultiChecksum&) = delete;
+    MultiChecksum& operator=(const MultiChecksum&) = delete;
+
+private:
+    std::vector<std::unique_ptr<DigestContext>> _contexts;
+    bool _valid;
+};
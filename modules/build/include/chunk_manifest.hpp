@@ -0,0 +1,163 @@
+/**
+ * @file chunk_manifest.hpp
+ * @brief Per-chunk digests and Merkle roots of large contents files
+ *
+ * A single digest over a whole file can only be computed by one core and
+ * can only be checked by reading the whole file.  For files of at least
+ * [build] contents_chunk_min bytes the manifest is extended with the
+ * digests of fixed-size chunks ([build] contents_chunk_size) and the
+ * Merkle root over them, which lets a verifier hash the chunks of one file
+ * on several cores and check a byte range without reading the rest.
+ *
+ * The chunks are recorded in a separate metadata file so that the
+ * "C checksum perms owner:group path" lines of CONTENTS_MANIFEST_DIGEST,
+ * and every verifier reading them, are unchanged.
+ *
+ * The tree uses the primary checksum algorithm with domain separation:
+ * a leaf is H(0x00 || chunk) and an inner node is H(0x01 || left || right).
+ * A level with an odd number of nodes carries its last node up unchanged.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "checksums.hpp"
+#include "hash_backend.hpp"
+
+/**
+ * @brief Name of the metadata file holding the chunk digests of large contents files
+ *
+ * Format:
+ *   # dpm chunk manifest v1
+ *   # algorithm: sha256
+ *   # chunk_size: 4194304
+ *   <merkle root> <file size> <chunk count> /path
+ *   <chunk digest>          (chunk count lines, in file order)
+ *
+ * The file is only written when at least one file is large enough to be chunked.
+ */
+#define CONTENTS_CHUNKS_FILENAME "CONTENTS_MANIFEST_CHUNKS"
+
+/**
+ * @brief Default size of a chunk, in bytes
+ */
+#define CHUNK_MANIFEST_DEFAULT_CHUNK_SIZE (4 * 1024 * 1024)
+
+/**
+ * @brief Default size from which a file is chunked, in bytes
+ */
+#define CHUNK_MANIFEST_DEFAULT_MIN_SIZE (64ULL * 1024 * 1024)
+
+/**
+ * @brief Chunk digests of a single contents file
+ */
+struct ChunkedFileRecord {
+    std::string relative_path;          ///< Path relative to the contents directory
+    uint64_t file_size;                 ///< Size of the file when it was chunked
+    std::string root;                   ///< Merkle root over the chunk digests
+    std::vector<std::string> chunks;    ///< Leaf digest of every chunk, in file order
+};
+
+/**
+ * @brief Parsed contents of CONTENTS_CHUNKS_FILENAME
+ */
+struct ChunkManifest {
+    std::string algorithm;                      ///< Algorithm of every digest in the file
+    uint64_t chunk_size;                        ///< Size of every chunk but the last, in bytes
+    std::vector<ChunkedFileRecord> files;       ///< Chunked files in manifest order
+};
+
+/**
+ * @brief Computes the leaf digest of one chunk of a file
+ *
+ * @param file_path File to read
+ * @param offset Offset of the chunk in the file
+ * @param length Length of the chunk in bytes
+ * @param algorithm Hash algorithm to use
+ * @return Hexadecimal leaf digest, or empty string on error
+ */
+extern "C" std::string generate_file_chunk_checksum(const std::filesystem::path& file_path, uint64_t offset,
+                                                    uint64_t length, const std::string& algorithm);
+
+/**
+ * @brief Computes the Merkle root over a file's chunk digests
+ *
+ * @param chunk_checksums Hexadecimal leaf digests in file order
+ * @param algorithm Hash algorithm the leaves were computed with
+ * @return Hexadecimal root, or empty string on error
+ */
+extern "C" std::string generate_chunk_merkle_root(const std::vector<std::string>& chunk_checksums,
+                                                  const std::string& algorithm);
+
+/**
+ * @brief Gets the configured chunk size
+ *
+ * Uses the "contents_chunk_size" key in the [build] configuration section.
+ *
+ * @return Chunk size in bytes, never 0
+ */
+uint64_t chunk_manifest_chunk_size();
+
+/**
+ * @brief Gets the configured size from which files are chunked
+ *
+ * Uses the "contents_chunk_min" key in the [build] configuration section.
+ *
+ * @return Minimum size in bytes, 0 if chunking is disabled
+ */
+uint64_t chunk_manifest_min_size();
+
+/**
+ * @brief Hashes every chunk of a file on the shared worker pool and computes the root
+ *
+ * @param file_path File to hash
+ * @param algorithm Hash algorithm to use
+ * @param chunk_size Size of a chunk in bytes
+ * @param worker_count Number of chunks to hash at once
+ * @param record Receives the file size, chunk digests and root; the path is left alone
+ * @return true on success, false on failure
+ */
+bool chunk_manifest_hash_file(const std::filesystem::path& file_path, const std::string& algorithm,
+                              uint64_t chunk_size, size_t worker_count, ChunkedFileRecord& record);
+
+/**
+ * @brief Loads the chunk manifest of a stage
+ *
+ * @param package_dir Root directory of the package stage
+ * @param manifest Receives the parsed manifest
+ * @return true if a well-formed chunk manifest was loaded, false otherwise
+ */
+bool chunk_manifest_load(const std::filesystem::path& package_dir, ChunkManifest& manifest);
+
+/**
+ * @brief Rewrites the chunk manifest of a stage after the contents manifest changed
+ *
+ * Every file of at least the configured minimum size is chunked with the
+ * configured chunk size.  Files marked reusable keep their previous record
+ * if it was made with the same algorithm, chunk size and file size.  When no
+ * file qualifies any existing chunk manifest is removed.
+ *
+ * @param package_dir Root directory of the package stage
+ * @param algorithm Primary hash algorithm
+ * @param files Path relative to the contents directory of every manifest entry, in manifest order,
+ *              paired with whether the file is unchanged since it was last hashed
+ * @param worker_count Number of threads to hash each file with
+ * @return true on success, false if a file could not be hashed or the manifest could not be written
+ */
+bool chunk_manifest_update(const std::filesystem::path& package_dir, const std::string& algorithm,
+                           const std::vector<std::pair<std::string, bool>>& files, size_t worker_count);
@@ -19,6 +19,9 @@ enum Command {
     CMD_SIGN,        /**< Sign a package or stage directory       */
     CMD_SEAL,        /**< Seal a package stage directory          */
     CMD_UNSEAL,      /**< Unseal a package stage directory        */
+    CMD_BENCH_IO,    /**< Benchmark checksum I/O strategies       */
+    CMD_DELTA,       /**< Build a delta between two packages      */
+    CMD_INSTALL,     /**< Install a package into a root directory */
 };
 
 /**
@@ -34,6 +37,7 @@ struct BuildOptions {
     std::string architecture;      /**< Architecture of the package (e.g., x86_64, aarch64) */
     std::string os;                /**< Optional OS of the package (e.g., dhl2) */
     bool force;                    /**< Flag to force package creation even if warnings occur */
+    bool link;                     /**< Flag to hard link the contents into the stage instead of copying */
     bool verbose;                  /**< Flag for verbose output */
     bool show_help;                /**< Flag to show help information */
 
@@ -47,6 +51,7 @@ struct BuildOptions {
         architecture(""),
         os(""),
         force(false),
+        link(false),
         verbose(false),
         show_help(false) {}
 };
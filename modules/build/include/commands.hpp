@@ -6,6 +6,10 @@
 #include "staging.hpp"
 #include "signing.hpp"
 #include "sealing.hpp"  // Added this include
+#include "io_bench.hpp"
+#include "delta.hpp"
+#include "install.hpp"
+#include "batch.hpp"
 #include <map>
 #include <sstream>
 
@@ -144,3 +148,71 @@ int cmd_unseal(int argc, char** argv);
  */
 int cmd_unseal_help(int argc, char** argv);
 
+/**
+ * @brief Handler for the bench-io command
+ *
+ * Benchmarks the I/O strategies used to hash files on a given storage and
+ * suggests the thresholds at which each should be used.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_bench_io(int argc, char** argv);
+
+/**
+ * @brief Handler for the bench-io help command
+ *
+ * Displays information about bench-io command options.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_bench_io_help(int argc, char** argv);
+
+/**
+ * @brief Handler for the delta command
+ *
+ * Builds a delta package holding only the files that changed between two
+ * versions of a package, see delta.hpp.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_delta(int argc, char** argv);
+
+/**
+ * @brief Handler for the delta help command
+ *
+ * Displays information about delta command options.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_delta_help(int argc, char** argv);
+
+/**
+ * @brief Handler for the install command
+ *
+ * Installs the contents of a package into a root directory, verifying
+ * every file as it is written, see install.hpp.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_install(int argc, char** argv);
+
+/**
+ * @brief Handler for the install help command
+ *
+ * Displays information about install command options.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_install_help(int argc, char** argv);
@@ -0,0 +1,129 @@
+/**
+ * @file compression.hpp
+ * @brief Compression codecs for sealed package components
+ *
+ * Each component of a sealed stage is a tarball compressed with one of the
+ * codecs below.  The codec and level are chosen per component from the
+ * [build] configuration section, e.g.
+ *
+ *   compression = gzip
+ *   compression_contents = zstd:3
+ *   compression_hooks = none
+ *
+ * so that contents can favour fast decompression on install while tiny
+ * components skip compression entirely.  Readers never need to be told the
+ * codec: it is detected from the magic number of the component.
+ *
+ * "gzip-seekable" writes contents as independently compressed frames, so
+ * a single file can be read out of a large component by inflating only the
+ * frame holding it.  It stays readable by anything that reads gzip.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <cstdlib>
+#include <archive.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief Codecs a component tarball can be compressed with
+ */
+enum class CompressionCodec {
+    NONE,       ///< Plain tar
+    GZIP,
+    GZIP_SEEKABLE,  ///< gzip in independent frames with a frame index, see frame_index.hpp
+    ZSTD,
+    XZ,
+    UNKNOWN     ///< Not a component archive
+};
+
+/**
+ * @brief Codec and level used to compress one archive
+ */
+struct CompressionSettings {
+    CompressionCodec codec;     ///< Codec to compress with
+    int level;                  ///< Codec specific level, 0 for the codec's default
+};
+
+/**
+ * @brief Gets the configuration name of a codec, e.g. "zstd"
+ *
+ * @param codec Codec to name
+ * @return Name of the codec
+ */
+const char* compression_codec_name(CompressionCodec codec);
+
+/**
+ * @brief Parses a "codec" or "codec:level" configuration value
+ *
+ * @param value Value to parse, e.g. "zstd:3"
+ * @param settings Receives the codec and level
+ * @return true if the value names a known codec and a valid level, false otherwise
+ */
+bool compression_parse_settings(const std::string& value, CompressionSettings& settings);
+
+/**
+ * @brief Gets the compression configured for a component
+ *
+ * Uses the "compression_<component>" key in the [build] configuration
+ * section, then the "compression" key, and falls back to gzip at its
+ * default level.  Invalid values are logged and ignored.
+ *
+ * @param component Component name, e.g. "contents"
+ * @return Settings to compress the component with
+ */
+CompressionSettings compression_for_component(const std::string& component);
+
+/**
+ * @brief Detects the codec of a component archive from its magic number
+ *
+ * A seekable gzip component is reported as GZIP, its footer is at the end.
+ *
+ * @param data Start of the archive
+ * @param size Number of bytes available at data
+ * @return Detected codec, UNKNOWN if the data is not a tarball in a supported codec
+ */
+CompressionCodec compression_detect(const unsigned char* data, size_t size);
+
+/**
+ * @brief Detects the codec of a component archive file
+ *
+ * Unlike compression_detect, also tells seekable gzip apart from gzip.
+ *
+ * @param path File to inspect
+ * @return Detected codec, UNKNOWN if the file cannot be read or is not a supported archive
+ */
+CompressionCodec compression_detect_file(const std::filesystem::path& path);
+
+/**
+ * @brief Enables every component codec on a libarchive reader
+ *
+ * libarchive picks the matching decompressor from the stream itself, so
+ * readers only have to enable the codecs they accept.
+ *
+ * @param a Archive opened with archive_read_new
+ */
+void compression_read_support(struct archive* a);
+
+/**
+ * @brief Adds the libarchive write filter for a codec and applies its options
+ *
+ * Sets the compression level and, for zstd and xz, the number of threads.
+ * Options the linked libarchive does not understand are logged and skipped.
+ * Gzip on several threads is done by ParallelGzipWriter instead, see
+ * parallel_gzip.hpp.
+ *
+ * @param a Archive opened with archive_write_new
+ * @param settings Codec and level to use
+ * @param thread_count Number of threads the codec may use
+ * @return true on success, false if the filter could not be added
+ */
+bool compression_write_filter(struct archive* a, const CompressionSettings& settings, size_t thread_count);
@@ -0,0 +1,148 @@
+/**
+ * @file content_store.hpp
+ * @brief Content-addressed store shared by the stages and seals of many packages
+ *
+ * Packages often carry large files that are identical from one package, or
+ * one version, to the next.  When [build] content_store names a directory,
+ * every file of at least [build] content_store_min bytes that is staged is
+ * kept there under its checksum, and staging places the stage's copy from
+ * the store: reflinked where the filesystem allows it, or hard linked when
+ * the stage is staged with hard links, so identical files share their data
+ * on disk however many stages hold them.  A contents component sealed with
+ * "gzip-seekable" keeps each such file's data in a gzip frame of its own,
+ * which the store also keeps, so sealing identical content again copies the
+ * stored frame instead of compressing it anew.
+ *
+ * The store is laid out as:
+ *
+ *     objects/<algorithm>/<first two digits>/<checksum>-<mode>     file data, with the file's permissions
+ *     frames/<codec>/<algorithm>/<first two digits>/<checksum>.gz  gzip member holding the file data
+ *                                                                 and its tar padding
+ *
+ * Entries are written beside their final name and renamed into place, so
+ * several builds can share a store, and a store can be deleted at any time.
+ * A hard linked stage shares its files with the store exactly as it would
+ * share them with the staged source tree, and must not be edited in place.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <functional>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "checksums.hpp"
+
+/**
+ * @brief Default size from which files go through the content store, in bytes
+ */
+#define CONTENT_STORE_DEFAULT_MIN_SIZE (1024 * 1024)
+
+/**
+ * @brief The content store configured for this build, if any
+ */
+class ContentStore {
+public:
+    ContentStore();
+
+    /**
+     * @brief Uses the store named by [build] content_store
+     *
+     * @return true if a store is configured, false if the key is unset or empty
+     */
+    bool open_configured();
+
+    /**
+     * @brief Checks whether a store is in use
+     *
+     * @return true once open_configured found a store
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Gets the size from which files go through the store, [build] content_store_min
+     *
+     * @return Size in bytes
+     */
+    uint64_t min_size() const;
+
+    /**
+     * @brief Gets the algorithm the store's checksums are taken with
+     *
+     * @return The primary configured hash algorithm
+     */
+    const std::string& algorithm() const;
+
+    /**
+     * @brief Gets the path of the object holding a file's data
+     *
+     * @param checksum Checksum of the file with algorithm()
+     * @param mode Permission bits of the file
+     * @return Path of the object, which may not exist yet
+     */
+    std::filesystem::path object_path(const std::string& checksum, mode_t mode) const;
+
+    /**
+     * @brief Gets a path beside an entry to write it to before renaming it into place
+     *
+     * Creates the directory of the entry.
+     *
+     * @param entry Path of the entry
+     * @return Temporary path unique to this process and thread, empty if the directory could not be created
+     */
+    std::filesystem::path temporary_path(const std::filesystem::path& entry) const;
+
+    /**
+     * @brief Reads the stored frame of a file's data
+     *
+     * The frame must be a single gzip member whose trailer records the
+     * expected size, anything else is ignored.
+     *
+     * @param codec Codec and level the frame was compressed with, e.g. "gzip-6"
+     * @param checksum Checksum of the file with algorithm()
+     * @param size Size the frame decompresses to, the file data with its tar padding
+     * @param member Receives the gzip member
+     * @return true if a usable frame is stored, false otherwise
+     */
+    bool load_frame(const std::string& codec, const std::string& checksum, uint64_t size,
+                    std::vector<unsigned char>& member) const;
+
+    /**
+     * @brief Stores the frame of a file's data
+     *
+     * @param codec Codec and level the frame was compressed with
+     * @param checksum Checksum of the file with algorithm()
+     * @param member The gzip member
+     * @return true if the frame was stored, false otherwise
+     */
+    bool save_frame(const std::string& codec, const std::string& checksum,
+                    const std::vector<unsigned char>& member) const;
+
+    /**
+     * @brief Removes a stored frame that turned out not to match its key
+     *
+     * @param codec Codec and level the frame was compressed with
+     * @param checksum Checksum of the file with algorithm()
+     */
+    void discard_frame(const std::string& codec, const std::string& checksum) const;
+
+private:
+    std::filesystem::path frame_path(const std::string& codec, const std::string& checksum) const;
+
+    std::filesystem::path _root;
+    std::string _algorithm;
+    uint64_t _min_size;
+};
@@ -0,0 +1,77 @@
+/**
+ * @file delta.hpp
+ * @brief Delta packages carrying only what changed between two versions of a package
+ *
+ * A delta is built from two sealed packages by comparing their contents
+ * manifests.  It is an ordinary package: its contents component holds only
+ * the files that are new or changed in the target, its CONTENTS_MANIFEST_DIGEST
+ * lists exactly those files, and it is sealed and verified with the same
+ * digest machinery as any other package.  The metadata describes the
+ * transition on top of that:
+ *
+ *     DELTA_BASE_PACKAGE_DIGEST      PACKAGE_DIGEST of the package the delta applies to
+ *     DELTA_TARGET_PACKAGE_DIGEST    PACKAGE_DIGEST of the package it produces
+ *     DELTA_TARGET_MANIFEST          CONTENTS_MANIFEST_DIGEST of the target, in full
+ *     DELTA_REMOVED                  paths present in the base but not in the target, one per line
+ *
+ * Applying a delta to a stage of the base removes the listed paths, adds
+ * the delta's contents and installs DELTA_TARGET_MANIFEST as the contents
+ * manifest, after which the stage verifies against the target's digests.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <filesystem>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/ManifestIndex.hpp>
+#include "archive_reader.hpp"
+#include "package_reader.hpp"
+#include "chunk_manifest.hpp"
+#include "metadata.hpp"
+#include "metadata_transaction.hpp"
+#include "sealing.hpp"
+
+/**
+ * @brief Name of the metadata file holding the PACKAGE_DIGEST of the base package
+ */
+#define DELTA_BASE_DIGEST_FILENAME "DELTA_BASE_PACKAGE_DIGEST"
+
+/**
+ * @brief Name of the metadata file holding the PACKAGE_DIGEST of the target package
+ */
+#define DELTA_TARGET_DIGEST_FILENAME "DELTA_TARGET_PACKAGE_DIGEST"
+
+/**
+ * @brief Name of the metadata file holding the full contents manifest of the target package
+ */
+#define DELTA_TARGET_MANIFEST_FILENAME "DELTA_TARGET_MANIFEST"
+
+/**
+ * @brief Name of the metadata file listing the paths removed by the delta
+ */
+#define DELTA_REMOVED_FILENAME "DELTA_REMOVED"
+
+/**
+ * @brief Builds a delta package between two versions of a package
+ *
+ * The target package is unsealed into a work directory, every file its
+ * manifest shares unchanged with the base package is pruned from it, and
+ * what is left is sealed as "<target stage>.delta-<base version>.dpm".
+ * The work directory is removed afterwards whether or not this succeeds.
+ *
+ * @param from_package Path to the base package file
+ * @param to_package Path to the target package file
+ * @param output_dir Directory to write the delta to, the target's directory when empty
+ * @param force Whether to overwrite an existing delta
+ * @return 0 on success, non-zero on failure
+ */
+extern "C" int build_delta_package(const std::string& from_package, const std::string& to_package,
+                                   const std::string& output_dir, bool force);
@@ -0,0 +1,127 @@
+/**
+ * @file disk_write_pool.hpp
+ * @brief Writes extracted archive entries to disk on worker threads
+ *
+ * Extracting a component of many small files is bound by creating,
+ * writing and closing each file as much as by decompressing it.  The pool
+ * separates the two: the thread reading the archive decompresses entries
+ * into memory and queues them, and workers that each own an
+ * archive_write_disk handle place them on disk.  How much decompressed
+ * data waits in the queue is bounded by a memory limit.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <archive.h>
+#include <archive_entry.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "helpers.hpp"
+
+/**
+ * @brief Largest file, in bytes, that is decompressed into memory and handed to a worker
+ *
+ * Larger files are written by the reading thread as they are decompressed.
+ */
+#define DISK_WRITE_POOL_MAX_FILE_SIZE (1024ULL * 1024)
+
+/**
+ * @brief Amount of decompressed data, in bytes, that may wait for a worker
+ */
+#define DISK_WRITE_POOL_MEMORY_LIMIT (32ULL * 1024 * 1024)
+
+/**
+ * @brief Worker threads writing archive entries to disk
+ */
+class DiskWritePool {
+public:
+    /**
+     * @brief Starts the workers
+     *
+     * @param worker_count Number of workers, at least one is started
+     * @param flags archive_write_disk options every worker extracts with
+     */
+    DiskWritePool(size_t worker_count, int flags);
+
+    /**
+     * @brief Stops the workers, discarding entries that were not written
+     */
+    ~DiskWritePool();
+
+    DiskWritePool(const DiskWritePool&) = delete;
+    DiskWritePool& operator=(const DiskWritePool&) = delete;
+
+    /**
+     * @brief Queues an entry to be written
+     *
+     * Waits while the queue holds more than the memory limit.
+     *
+     * @param entry Entry to write, the pool takes ownership of it
+     * @param data Complete contents of the entry, empty for anything but a regular file
+     * @return true if the entry was queued, false if a worker has already failed
+     */
+    bool submit(struct archive_entry* entry, std::vector<unsigned char> data);
+
+    /**
+     * @brief Waits until every queued entry has been written
+     *
+     * Needed before writing an entry, such as a hard link, that depends on
+     * an earlier one being on disk.
+     *
+     * @return true if every entry so far was written, false if a worker failed
+     */
+    bool drain();
+
+    /**
+     * @brief Writes what is left, stops the workers and closes their handles
+     *
+     * Closing applies the deferred directory permissions and times, so it
+     * must happen before any other handle extracting the same tree is
+     * closed.
+     *
+     * @return true if every entry was written, false otherwise
+     */
+    bool finish();
+
+private:
+    struct Job {
+        struct archive_entry* entry;
+        std::vector<unsigned char> data;
+    };
+
+    void worker_loop(struct archive* ext);
+    void stop(bool discard);
+
+    std::vector<struct archive*> _writers;
+    std::vector<std::thread> _workers;
+    std::deque<Job> _queue;
+    uint64_t _queued_bytes;
+    size_t _busy;
+    bool _stopping;
+    bool _failed;
+    std::mutex _mutex;
+    std::condition_variable _state_changed;
+};
+
+/**
+ * @brief Gets the number of disk writer threads used to extract an archive
+ *
+ * Uses the "extract_threads" key in the [build] configuration section,
+ * falling back to the number of threads of the shared worker pool when it
+ * is unset or 0.
+ *
+ * @return Number of writers, always at least 1
+ */
+size_t disk_write_pool_worker_count();
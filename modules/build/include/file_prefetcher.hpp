@@ -0,0 +1,118 @@
+/**
+ * @file file_prefetcher.hpp
+ * @brief Reads small files ahead of the archive writer
+ *
+ * Archiving a tree of many small files spends most of its time waiting on
+ * open and read.  The prefetcher loads the files the archive writer needs
+ * next on a reader thread, in the order they will be asked for, so that the
+ * writer finds them already in memory.  How much is read ahead is bounded
+ * by a memory limit.  Where io_uring is supported, the files are read in
+ * batches kept in flight together through a UringFileReader.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "uring_reader.hpp"
+
+/**
+ * @brief Largest file, in bytes, that is worth reading ahead in full
+ */
+#define FILE_PREFETCH_MAX_FILE_SIZE (256ULL * 1024)
+
+/**
+ * @brief Amount of file data, in bytes, the prefetcher may hold at once
+ */
+#define FILE_PREFETCH_MEMORY_LIMIT (16ULL * 1024 * 1024)
+
+/**
+ * @brief Size of the buffer files are read with, in bytes
+ */
+#define FILE_READ_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * @brief A file loaded by the prefetcher
+ */
+struct PrefetchedFile {
+    /// 0 when the file was read, otherwise the errno of the failure
+    int error;
+    /// Contents of the file
+    std::vector<unsigned char> data;
+};
+
+/**
+ * @brief Reads a list of files, in order, on a background thread
+ */
+class FilePrefetcher {
+public:
+    /**
+     * @brief Starts reading the files
+     *
+     * @param paths Files to read, in the order next() hands them out
+     * @param sizes Sizes of the files as last seen, each read as a whole through io_uring when it still has it,
+     *              or empty to read every file with plain reads
+     * @param memory_limit Number of bytes read ahead before the reader waits
+     */
+    FilePrefetcher(std::vector<std::string> paths, std::vector<uint64_t> sizes, uint64_t memory_limit);
+
+    /**
+     * @brief Stops the reader thread, discarding what was not handed out
+     */
+    ~FilePrefetcher();
+
+    FilePrefetcher(const FilePrefetcher&) = delete;
+    FilePrefetcher& operator=(const FilePrefetcher&) = delete;
+
+    /**
+     * @brief Takes the next file in the list, waiting for it to be read
+     *
+     * @param file Receives the file
+     * @return true if a file was taken, false once the list is exhausted
+     */
+    bool next(PrefetchedFile& file);
+
+private:
+    void reader_loop();
+
+    std::vector<std::string> _paths;
+    std::vector<uint64_t> _sizes;
+    uint64_t _memory_limit;
+    std::deque<PrefetchedFile> _ready;
+    uint64_t _ready_bytes;
+    size_t _taken;
+    bool _stop;
+    std::mutex _mutex;
+    std::condition_variable _state_changed;
+    std::thread _reader;
+};
+
+/**
+ * @brief Reads an open file sequentially with a large buffer
+ *
+ * Advises the kernel of the sequential access so that it reads ahead
+ * aggressively, and hands the data to consume as it arrives.
+ *
+ * @param fd Descriptor of the file, positioned at its start
+ * @param buffer Buffer to read with, resized to FILE_READ_BUFFER_SIZE if it is empty
+ * @param consume Receives each piece of the file, returning false to stop
+ * @return 0 on success, the errno of a failed read, or -1 if consume stopped the read
+ */
+int file_read_sequential(int fd, std::vector<unsigned char>& buffer,
+                         const std::function<bool(const void* data, size_t size)>& consume);
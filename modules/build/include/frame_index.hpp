@@ -0,0 +1,112 @@
+/**
+ * @file frame_index.hpp
+ * @brief Frame index of a seekable gzip component
+ *
+ * A component sealed with the "gzip-seekable" codec is a series of
+ * independent gzip members, or frames, each starting on a tar header, so
+ * decompression can begin at any frame without inflating what comes before
+ * it.  After the last frame come two more members: the index, a gzip member
+ * whose text lists every frame and the frame holding each entry, and a
+ * fixed-size empty member whose extra field records where the index lies.
+ * Both decompress to data after the end of the tar, which tar readers never
+ * look at, so to gunzip, zlib and libarchive the component is an ordinary
+ * multi-member gzip tarball.
+ *
+ * The index text has a version line, then one line per frame and one per
+ * entry:
+ *
+ *     DPM_FRAME_INDEX 1
+ *     frame <compressed offset> <uncompressed offset>
+ *     entry <frame number> <path in archive>
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <zlib.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief Uncompressed size after which a seekable component starts a new frame, in bytes
+ */
+#define FRAME_INDEX_FRAME_SIZE (1024 * 1024)
+
+/**
+ * @brief Size of the empty gzip member that ends a seekable component, in bytes
+ */
+#define FRAME_INDEX_FOOTER_SIZE 42
+
+/**
+ * @brief Largest index accepted when reading one, in bytes
+ */
+#define FRAME_INDEX_MAX_SIZE (256 * 1024 * 1024)
+
+/**
+ * @brief Where one frame starts
+ */
+struct FrameIndexFrame {
+    uint64_t compressed_offset;     ///< Offset of the frame's gzip member in the component
+    uint64_t uncompressed_offset;   ///< Offset of the frame's data in the tar stream
+};
+
+/**
+ * @brief The frame holding the header of one archive entry
+ */
+struct FrameIndexEntry {
+    std::string path;   ///< Path of the entry as stored in the archive
+    uint64_t frame;     ///< Number of the frame, counting from 0
+};
+
+/**
+ * @brief Frames of a seekable component and the entries in them
+ */
+struct FrameIndex {
+    std::vector<FrameIndexFrame> frames;
+    std::vector<FrameIndexEntry> entries;
+};
+
+/**
+ * @brief Encodes the index and footer members that end a seekable component
+ *
+ * @param index Frames and entries to record
+ * @param index_offset Offset in the component at which the members will be written
+ * @param trailer Receives the index member followed by the footer member
+ * @return true on success, false if the index could not be compressed
+ */
+bool frame_index_encode(const FrameIndex& index, uint64_t index_offset, std::vector<unsigned char>& trailer);
+
+/**
+ * @brief Reads the frame index at the end of a component
+ *
+ * @param data Whole component
+ * @param size Size of the component in bytes
+ * @param index Receives the frames and entries
+ * @return true if the component is seekable and its index is valid, false otherwise
+ */
+bool frame_index_find(const unsigned char* data, size_t size, FrameIndex& index);
+
+/**
+ * @brief Checks whether the last bytes of a component are a frame index footer
+ *
+ * @param tail Last FRAME_INDEX_FOOTER_SIZE bytes of the component
+ * @param size Number of bytes in tail
+ * @return true if tail is a footer, false otherwise
+ */
+bool frame_index_has_footer(const unsigned char* tail, size_t size);
+
+/**
+ * @brief Looks up the frame holding an entry
+ *
+ * @param index Parsed index
+ * @param path Entry path, with or without the component directory prefix
+ * @return The frame, or NULL if the entry is not indexed
+ */
+const FrameIndexFrame* frame_index_lookup(const FrameIndex& index, const char* path);
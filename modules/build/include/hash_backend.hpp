@@ -0,0 +1,146 @@
+/**
+ * @file hash_backend.hpp
+ * @brief Pluggable hash backends behind the checksum functions
+ *
+ * Checksums are computed through a small interface so that algorithms can
+ * come from more than one library.  OpenSSL's EVP digests are always
+ * available; BLAKE3 is provided by the official libblake3, which picks the
+ * fastest SIMD implementation for the running CPU (SSE2, SSE4.1, AVX2,
+ * AVX-512 or NEON) at runtime, when the build module is built against it.
+ *
+ * Backends are searched in a fixed order and the first one that knows an
+ * algorithm name provides it.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief Running digest computation of a single algorithm
+ *
+ * A context can be reused: every init starts a new digest.
+ */
+class DigestContext {
+public:
+    virtual ~DigestContext() = default;
+
+    /**
+     * @brief Starts a new digest
+     *
+     * @return true on success, false on failure
+     */
+    virtual bool init() = 0;
+
+    /**
+     * @brief Feeds data into the digest
+     *
+     * @param data Data to hash
+     * @param size Size of the data in bytes
+     * @return true on success, false on failure
+     */
+    virtual bool update(const void* data, size_t size) = 0;
+
+    /**
+     * @brief Completes the digest
+     *
+     * @param digest Receives the binary digest, at least digest_size() bytes of the algorithm
+     * @param digest_size Receives the size of the digest in bytes
+     * @return true on success, false on failure
+     */
+    virtual bool finish(unsigned char* digest, size_t* digest_size) = 0;
+};
+
+/**
+ * @brief A hash algorithm provided by a backend
+ */
+class DigestAlgorithm {
+public:
+    virtual ~DigestAlgorithm() = default;
+
+    /**
+     * @brief Gets the size of the digests the algorithm produces
+     *
+     * @return Digest size in bytes
+     */
+    virtual size_t digest_size() const = 0;
+
+    /**
+     * @brief Creates a new context for computing digests with the algorithm
+     *
+     * @return The context, or nullptr if it could not be created
+     */
+    virtual std::unique_ptr<DigestContext> create_context() const = 0;
+};
+
+/**
+ * @brief A library providing hash algorithms
+ */
+class HashBackend {
+public:
+    virtual ~HashBackend() = default;
+
+    /**
+     * @brief Gets the name of the backend, used in log messages
+     *
+     * @return Backend name
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Looks up an algorithm by name
+     *
+     * @param algorithm Name of the algorithm, e.g. "sha256"
+     * @return The algorithm, owned by the backend, or nullptr if the backend does not provide it
+     */
+    virtual const DigestAlgorithm* find_algorithm(const std::string& algorithm) const = 0;
+
+    /**
+     * @brief Lists the algorithms the backend provides
+     *
+     * @return Names of the working algorithms
+     */
+    virtual std::vector<std::string> list_algorithms() const = 0;
+};
+
+/**
+ * @brief Gets the OpenSSL EVP backend
+ *
+ * @return The process-wide backend instance
+ */
+const HashBackend* hash_backend_openssl();
+
+#ifdef DPM_HAVE_BLAKE3
+/**
+ * @brief Gets the BLAKE3 backend
+ *
+ * @return The process-wide backend instance
+ */
+const HashBackend* hash_backend_blake3();
+#endif // DPM_HAVE_BLAKE3
+
+/**
+ * @brief Finds an algorithm in the first backend that provides it
+ *
+ * @param algorithm Name of the algorithm
+ * @return The algorithm, or nullptr if no backend provides it
+ */
+const DigestAlgorithm* hash_backend_find_algorithm(const std::string& algorithm);
+
+/**
+ * @brief Lists the algorithms of every backend
+ *
+ * @return Names of every working algorithm, in backend order
+ */
+std::vector<std::string> hash_backend_list_algorithms();
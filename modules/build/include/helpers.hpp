@@ -18,6 +18,8 @@
 #include <getopt.h>
 #include <cstdlib>
 #include <wordexp.h>
+#include <atomic>
+#include <algorithm>
 #include <dpmdk/include/CommonModuleAPI.hpp>
 
 /**
@@ -31,5 +33,33 @@
  */
 std::string expand_path(const std::string& path);
 
+/**
+ * @brief Reads a thread or job count from the [build] configuration section
+ *
+ * A positive value is used as it is.  When the key is unset or 0 the
+ * fallback is used; any other value is warned about and ignored.
+ *
+ * @param key Name of the key in the [build] section
+ * @param fallback Count to use when the key does not give one
+ * @return The configured count, or fallback
+ */
+size_t build_config_thread_count(const char* key, size_t fallback);
 
+/**
+ * @brief Sets how many stages or packages a batch works on at once
+ *
+ * Every per-operation thread count of the module, hashing, walking,
+ * compressing, copying and extracting, is divided by it, so a batch of N
+ * items does not start N full-width pools on top of each other.
+ *
+ * @param items Items running at once, 1 outside of a batch
+ */
+void set_build_concurrent_items(size_t items);
 
+/**
+ * @brief Gets the share of a thread count left to one of the items running at once
+ *
+ * @param threads Threads one operation would use on its own
+ * @return threads divided by the items set with set_build_concurrent_items, at least 1
+ */
+size_t build_thread_share(size_t threads);
@@ -0,0 +1,67 @@
+/**
+ * @file install.hpp
+ * @brief Installs the contents of a sealed package in a single verified pass
+ *
+ * The contents component is streamed once.  Every file is hashed as it is
+ * decompressed and written, so the digest is known when the last byte
+ * lands, and it is compared with the package's CONTENTS_MANIFEST_DIGEST
+ * before the file is given a name.  Data is written to an unnamed file
+ * (O_TMPFILE) in its destination directory and linked under a temporary
+ * name with linkat only once it matches; filesystems without O_TMPFILE get
+ * a named temporary file that is removed on a mismatch.
+ *
+ * Nothing replaces an installed file until the whole package has been
+ * streamed and verified.  Only then are the temporary names renamed over
+ * their destinations, so a corrupt or tampered package leaves the root as
+ * it was, and no byte is read more than once: there is no stage to unseal,
+ * verify and copy from.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <sstream>
+#include <filesystem>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pwd.h>
+#include <grp.h>
+#include <sys/stat.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "archive_reader.hpp"
+#include "checksums.hpp"
+#include "metadata.hpp"
+
+/**
+ * @brief Prefix of the temporary names verified files are linked under before they are committed
+ */
+#define INSTALL_TEMP_PREFIX ".dpm-install-"
+
+/**
+ * @brief Installs the contents of a package into a root directory
+ *
+ * The package digest is checked against the manifest and hooks digest
+ * recorded in its metadata, then every entry of the contents component is
+ * written and hashed in one pass.  An entry that is not in the manifest,
+ * a file whose digest does not match and a manifest entry missing from the
+ * contents all fail the install before anything is committed.  Files get
+ * the permissions recorded in the manifest, and its ownership when running
+ * as root.  Each file a commit replaces is first linked to a backup name;
+ * if a rename fails part way, the files already committed are put back as
+ * they were, and the backups are removed once every file is in place.
+ *
+ * @param package_path Path to the package file
+ * @param root_dir Directory to install into, created if it does not exist
+ * @param force Whether to replace files that already exist in the root
+ * @return 0 on success, non-zero on failure
+ */
+extern "C" int install_package(const std::string& package_path, const std::string& root_dir, bool force);
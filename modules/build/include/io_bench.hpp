@@ -0,0 +1,60 @@
+/**
+ * @file io_bench.hpp
+ * @brief Benchmark of the I/O strategies used for file checksums
+ *
+ * Hashes generated files of increasing size with every I/O strategy the
+ * checksum engine supports, on the storage the benchmark is pointed at, and
+ * reports the throughput of each so the single read, positional read and
+ * memory map thresholds can be tuned for that storage.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "checksums.hpp"
+
+/**
+ * @brief File sizes benchmarked when none are given, in bytes
+ */
+#define IO_BENCH_DEFAULT_SIZES "4K,16K,64K,256K,1M,4M,16M,64M,256M"
+
+/**
+ * @brief Parses a comma separated list of sizes such as "64K,1M,1G"
+ *
+ * @param size_list List of sizes, each optionally suffixed with K, M or G
+ * @param sizes Receives the sizes in bytes
+ * @return true on success, false if any size is invalid
+ */
+bool io_bench_parse_sizes(const std::string& size_list, std::vector<uint64_t>& sizes);
+
+/**
+ * @brief Runs the checksum I/O strategy benchmark
+ *
+ * For each size a file of random data is written to the benchmark
+ * directory, hashed with every strategy and removed again.  Unless warm
+ * runs are requested the file is dropped from the page cache before every
+ * pass so the storage itself is measured.
+ *
+ * @param bench_dir Directory on the storage to benchmark
+ * @param sizes File sizes to benchmark, in bytes
+ * @param repeat Number of timed passes per size and strategy, the best is kept
+ * @param warm Keep the file in the page cache between passes
+ * @return 0 on success, non-zero on failure
+ */
+int run_checksum_io_benchmark(const std::filesystem::path& bench_dir, const std::vector<uint64_t>& sizes,
+                              int repeat, bool warm);
@@ -14,21 +14,50 @@
 #include <filesystem>
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <sys/stat.h>
 #include <pwd.h>
 #include <grp.h>
 #include <map>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
 
 #include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/ManifestIndex.hpp>
+#include <dpmdk/include/ManifestCodec.hpp>
 #include "checksums.hpp"
+#include "stat_cache.hpp"
+#include "chunk_manifest.hpp"
+#include "tree_walk.hpp"
+#include "metadata_transaction.hpp"
+#include "file_prefetcher.hpp"
+#include "helpers.hpp"
+
+/**
+ * @brief Owner and group names already resolved during a run, keyed by id
+ */
+struct OwnershipNameCache {
+    std::unordered_map<uid_t, std::string> users;     ///< uid to user name
+    std::unordered_map<gid_t, std::string> groups;    ///< gid to group name
+};
 
 // generates the initial entries for the stage - does not populate data!
 bool metadata_generate_skeleton(const std::filesystem::path& stage_dir);
 
+// stages the initial entries for the stage in a transaction
+void metadata_generate_skeleton(MetadataTransaction& transaction);
+
 // sets values in metadata files
 bool metadata_set_simple_value(const std::filesystem::path& stage_dir, const std::string& key, const std::string& value);
 
+// stages a value in a transaction
+void metadata_set_simple_value(MetadataTransaction& transaction, const std::string& key, const std::string& value);
+
 // sets initial known values in metadata
 bool metadata_set_initial_known_values(
     const std::filesystem::path& stage_dir,
@@ -37,30 +66,101 @@ bool metadata_set_initial_known_values(
     const std::string& architecture
 );
 
+// stages initial known values in a transaction
+void metadata_set_initial_known_values(
+    MetadataTransaction& transaction,
+    const std::string& package_name,
+    const std::string& package_version,
+    const std::string& architecture
+);
+
+/**
+ * @brief Name of the metadata file holding contents digests for additional algorithms
+ *
+ * Written alongside CONTENTS_MANIFEST_DIGEST when more than one checksum
+ * algorithm is configured.  The first line names the additional algorithms
+ * ("# algorithms: sha512 blake2b512"); every following line holds one digest
+ * per named algorithm followed by the file path, in manifest order.
+ */
+#define CONTENTS_EXTRA_DIGESTS_FILENAME "CONTENTS_MANIFEST_EXTRA_DIGESTS"
+
 /**
  * @brief Updates the contents manifest file for a package stage
  *
  * Creates the CONTENTS_MANIFEST_DIGEST file by scanning the contents directory
  * and generating a line for each file with control designation,
- * checksum, permissions, ownership, and path information.
+ * checksum, permissions, ownership, and path information.  Files are hashed
+ * by [build] threads workers on the shared worker pool, then the lines are
+ * written in directory walk order, so the output does not depend on the
+ * number of workers.  When several checksum algorithms are configured each
+ * file is read once for all of them; the primary digest goes into the
+ * manifest and the others into CONTENTS_EXTRA_DIGESTS_FILENAME.  Files of
+ * at least [build] contents_chunk_min bytes also get their chunk digests
+ * recorded in CONTENTS_CHUNKS_FILENAME, see chunk_manifest.hpp, and the
+ * manifest gets a binary index in CONTENTS_MANIFEST_INDEX_FILENAME, see
+ * ManifestIndex.hpp.
  *
  * @param package_dir Root directory of the package stage
  * @return true if contents manifest generation was successful, false otherwise
  */
 bool metadata_generate_contents_manifest_digest(const std::filesystem::path& package_dir);
 
+/**
+ * @brief Generates the contents manifest of a stage into a metadata transaction
+ *
+ * As metadata_generate_contents_manifest_digest, but the manifest and the
+ * additional digests are only written when the transaction is committed.
+ * The chunk digests and the stat cache are written right away.
+ *
+ * @param transaction Metadata transaction of the package stage
+ * @return true if contents manifest generation was successful, false otherwise
+ */
+bool metadata_generate_contents_manifest_digest(MetadataTransaction& transaction);
+
 /**
  * @brief Refreshes the contents manifest file by updating checksums
  *
- * Iterates through the existing CONTENTS_MANIFEST_DIGEST file, rereads each file,
- * recalculates its checksum, and updates the file with new checksums while
- * preserving all other fields.
+ * Iterates through the existing CONTENTS_MANIFEST_DIGEST file, recalculates the
+ * checksum of each file, and updates the file with new checksums while
+ * preserving all other fields.  Files whose size, modification time, inode
+ * and change time are unchanged since they were last hashed keep the digest
+ * recorded in the stage's stat cache instead of being reread.  The chunk
+ * digests of large files and the binary manifest index are refreshed the
+ * same way.
+ *
+ * Digests calculated while the files were read for another purpose, such as
+ * archiving them, can be passed in known_digests; they are trusted exactly
+ * like the stat cache, only while the file's stat tuple still matches.
+ * Likewise a walk of the contents directory made for the same purpose can
+ * be passed in contents_walk instead of walking it again.
  *
  * @param stage_dir Directory path of the package stage
  * @param force Whether to force the operation even if warnings occur
+ * @param full_rehash Ignore the stat cache and rehash every file
+ * @param known_digests Freshly calculated digests keyed by path relative to the contents directory, or NULL
+ * @param contents_walk Current walk of the contents directory, or NULL to walk it here
+ * @return 0 on success, non-zero on failure
+ */
+int metadata_refresh_contents_manifest_digest(const std::string& stage_dir, bool force, bool full_rehash = false,
+                                              const StatCache* known_digests = nullptr,
+                                              const TreeWalk* contents_walk = nullptr);
+
+/**
+ * @brief Refreshes the contents manifest of a stage into a metadata transaction
+ *
+ * As the path based overload, but the existing manifest is taken from the
+ * transaction and the refreshed one is only written when it is committed.
+ *
+ * @param transaction Metadata transaction of the package stage
+ * @param force Whether to force the operation even if warnings occur
+ * @param full_rehash Ignore the stat cache and rehash every file
+ * @param known_digests Freshly calculated digests keyed by path relative to the contents directory, or NULL
+ * @param contents_walk Current walk of the contents directory, or NULL to walk it here
  * @return 0 on success, non-zero on failure
  */
-int metadata_refresh_contents_manifest_digest(const std::string& stage_dir, bool force);
+int metadata_refresh_contents_manifest_digest(MetadataTransaction& transaction, bool force, bool full_rehash = false,
+                                              const StatCache* known_digests = nullptr,
+                                              const TreeWalk* contents_walk = nullptr);
 
 /**
  * @brief Generates the HOOKS_DIGEST file for a package stage
@@ -69,22 +169,34 @@ int metadata_refresh_contents_manifest_digest(const std::string& stage_dir, bool
  * and generating a line for each hook file with its checksum and filename.
  *
  * @param stage_dir Root directory of the package stage
+ * @param known_checksums Checksums of hook files already calculated, keyed by filename, or NULL
  * @return true if hooks digest generation was successful, false otherwise
  */
-bool metadata_generate_hooks_digest(const std::filesystem::path& stage_dir);
+bool metadata_generate_hooks_digest(const std::filesystem::path& stage_dir,
+                                    const std::unordered_map<std::string, std::string>* known_checksums = nullptr);
+
+// generates the HOOKS_DIGEST of a stage into a metadata transaction
+bool metadata_generate_hooks_digest(MetadataTransaction& transaction,
+                                    const std::unordered_map<std::string, std::string>* known_checksums = nullptr);
 
 // generates the dynamic entries for the stage
 bool metadata_generate_dynamic_files( const std::filesystem::path& stage_dir );
 
-// refreshes the dynamic entries for the stage
-bool metadata_refresh_dynamic_files( const std::filesystem::path& stage_dir );
+// generates the dynamic entries for the stage into a metadata transaction
+bool metadata_generate_dynamic_files( MetadataTransaction& transaction );
+
+// refreshes the dynamic entries for the stage, rehashing only changed files unless full_rehash is set
+bool metadata_refresh_dynamic_files( const std::filesystem::path& stage_dir, bool full_rehash = false );
+
+// refreshes the dynamic entries for the stage into a metadata transaction
+bool metadata_refresh_dynamic_files( MetadataTransaction& transaction, bool full_rehash = false );
 
 /**
  * @brief Generates basic metadata files for a package stage
  *
- * Creates the necessary metadata files for a package stage with the provided information.
- * Does not generate the CONTENTS_MANIFEST_DIGEST which requires a separate call
- * to update_contents_manifest().
+ * Creates the necessary metadata files for a package stage with the provided information,
+ * including the dynamic digests.  Every field is collected in one metadata
+ * transaction and written in a single pass at the end.
  *
  * @param package_dir Root directory of the package stage
  * @param package_name Name of the package
@@ -109,4 +221,16 @@ bool metadata_generate_new(
  * @param stage_dir Root directory of the package stage
  * @return true if package digest generation was successful, false otherwise
  */
-bool metadata_generate_package_digest(const std::filesystem::path& stage_dir);
\ No newline at end of file
+bool metadata_generate_package_digest(const std::filesystem::path& stage_dir);
+
+/**
+ * @brief Generates the PACKAGE_DIGEST of a stage into a metadata transaction
+ *
+ * The two digests are taken from the transaction, so digests generated in
+ * the same transaction are used without being written and read back.
+ *
+ * @param transaction Metadata transaction of the package stage
+ * @return true if package digest generation was successful, false otherwise
+ */
+bool metadata_generate_package_digest(MetadataTransaction& transaction);
+
@@ -0,0 +1,100 @@
+/**
+ * @file metadata_transaction.hpp
+ * @brief Batched writes of the metadata fields of a package stage
+ *
+ * Metadata used to be written one field at a time, each with its own open,
+ * write and close of a file in the stage's metadata directory, which on a
+ * network filesystem costs a round trip per field.  A transaction instead
+ * collects the fields in memory and writes them all in one pass when it is
+ * committed: every field is first written next to its final place as
+ * <field>.tmp, and only once all of them have been written are they renamed
+ * over the old files, so a failed commit leaves the stage as it was.
+ *
+ * Fields staged in a transaction can be read back from it, and fields it
+ * does not hold are read from the stage once and then kept in its model,
+ * so the steps generating the metadata of a stage share what the earlier
+ * ones produced instead of reading the files again.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/MetadataModel.hpp>
+
+/**
+ * @brief Metadata field writes of one stage, written together on commit
+ *
+ * All methods may be called from several threads at once.
+ */
+class MetadataTransaction {
+public:
+    /**
+     * @brief Starts a transaction on the metadata of a stage
+     *
+     * @param stage_dir Root directory of the package stage
+     */
+    explicit MetadataTransaction(const std::filesystem::path& stage_dir);
+
+    /**
+     * @brief Gets the stage the transaction writes to
+     *
+     * @return Root directory of the package stage
+     */
+    const std::filesystem::path& stage_dir() const;
+
+    /**
+     * @brief Stages the new content of a field
+     *
+     * @param key Name of the field
+     * @param value Whole new content of the field
+     */
+    void set(const std::string& key, const std::string& value);
+
+    /**
+     * @brief Stages the removal of a field, a field that does not exist is not an error
+     *
+     * @param key Name of the field
+     */
+    void remove(const std::string& key);
+
+    /**
+     * @brief Gets the content of a field as it will be after the commit
+     *
+     * @param key Name of the field
+     * @param value Receives the content of the field
+     * @return true if the field exists or is staged, false otherwise
+     */
+    bool get(const std::string& key, std::string& value);
+
+    /**
+     * @brief Writes every staged field in one pass
+     *
+     * The transaction is empty again afterwards, whether or not the commit
+     * succeeded; the fields it has read or written stay in its model.
+     *
+     * @return true if every field was written, false otherwise
+     */
+    bool commit();
+
+private:
+    // discards the temporary files of a failed commit
+    void remove_temporary_files(const std::vector<std::filesystem::path>& temporary_files);
+
+    std::filesystem::path _stage_dir;
+    std::filesystem::path _metadata_dir;
+    std::mutex _mutex;
+    MetadataModel _model;                           ///< Fields read from the stage or staged here
+    std::map<std::string, std::string> _pending;    ///< Fields to write, in name order
+    std::set<std::string> _removed;                 ///< Fields to remove
+};
@@ -0,0 +1,101 @@
+/**
+ * @file package_index.hpp
+ * @brief Index of the components of a package file
+ *
+ * A sealed package starts with a small PACKAGE_INDEX member, right after
+ * the stage directory entry, recording where each component member's data
+ * lies in the package file along with its size, codec and digest.  Readers
+ * that find it go straight to the component they need instead of walking
+ * the outer tar header by header, so reading only the metadata of a package
+ * costs one small read at its start and one at the metadata.
+ *
+ * The index is text, one component per line after a version line:
+ *
+ *     DPM_PACKAGE_INDEX 1
+ *     <component> <offset> <size> <codec> <algorithm> <digest>
+ *
+ * Offsets and sizes are zero padded to a fixed width so the index can be
+ * written before the components and filled in once their offsets are known.
+ * Packages without an index, and packages with a compressed outer tar, are
+ * still read by walking the tar.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <archive.h>
+#include <archive_entry.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief Name of the index member of a package, below the stage directory
+ */
+#define PACKAGE_INDEX_MEMBER "PACKAGE_INDEX"
+
+/**
+ * @brief Number of bytes at the start of a package searched for the index
+ */
+#define PACKAGE_INDEX_SEARCH_SIZE (64 * 1024)
+
+/**
+ * @brief Where one component lies in a package file
+ */
+struct PackageIndexEntry {
+    std::string component;      ///< Component name, e.g. "contents"
+    uint64_t offset;            ///< Offset of the member data in the package file
+    uint64_t size;              ///< Size of the member data in bytes
+    std::string codec;          ///< Codec the component is compressed with
+    std::string algorithm;      ///< Hash algorithm of digest
+    std::string digest;         ///< Digest of the member data
+};
+
+/**
+ * @brief Formats an index
+ *
+ * The length of the result does not depend on the offsets and sizes, so
+ * an index formatted with placeholders can be overwritten in place.
+ *
+ * @param entries Components to record
+ * @return Index member contents
+ */
+std::string package_index_format(const std::vector<PackageIndexEntry>& entries);
+
+/**
+ * @brief Parses an index
+ *
+ * @param data Index member contents
+ * @param size Size of the contents in bytes
+ * @param entries Receives the components
+ * @return true if the index is well formed, false otherwise
+ */
+bool package_index_parse(const unsigned char* data, size_t size, std::vector<PackageIndexEntry>& entries);
+
+/**
+ * @brief Finds and parses the index at the start of a package
+ *
+ * @param prefix First bytes of the package file, up to PACKAGE_INDEX_SEARCH_SIZE
+ * @param prefix_size Number of bytes in prefix
+ * @param package_size Size of the whole package file, to bound the entries
+ * @param entries Receives the components
+ * @return true if the package has a valid index, false if it has none or it is unusable
+ */
+bool package_index_find(const unsigned char* prefix, size_t prefix_size, uint64_t package_size,
+                        std::vector<PackageIndexEntry>& entries);
+
+/**
+ * @brief Looks up a component in an index
+ *
+ * @param entries Parsed index
+ * @param component Component name, with or without the stage directory prefix
+ * @return The entry, or NULL if the component is not indexed
+ */
+const PackageIndexEntry* package_index_lookup(const std::vector<PackageIndexEntry>& entries, const char* component);
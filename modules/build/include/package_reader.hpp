@@ -0,0 +1,113 @@
+/**
+ * @file package_reader.hpp
+ * @brief Memory-mapped, zero-copy access to the components of a package file
+ *
+ * Maps a .dpm package into memory once and indexes its members, handing out
+ * views (pointer and length) onto the component archives instead of copying
+ * them to the heap.  Packages sealed with an uncompressed outer tar are served
+ * directly from the mapping, located through the package index when there
+ * is one; older packages with a gzipped outer tar are decompressed once into
+ * buffers owned by the reader.
+ *
+ * A package named by an http:// or https:// URL is read through a
+ * RemotePackage instead of a mapping: only the package index is fetched
+ * when the reader is opened, and each member's byte range the first time
+ * it is asked for, so looking at the metadata or signatures of a remote
+ * package never transfers its contents.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <archive.h>
+#include <archive_entry.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "archive_reader.hpp"
+#include "package_index.hpp"
+#include "remote_package.hpp"
+
+/**
+ * @brief A read-only view onto a member of a package
+ */
+struct PackageMemberView {
+    const unsigned char* data;  ///< Start of the member data
+    size_t size;                ///< Length of the member data in bytes
+    bool mapped;                ///< True if data points into the package mapping itself
+    bool remote = false;        ///< True while the member still has to be fetched from the remote package
+    uint64_t offset = 0;        ///< Offset of the member in the package, for remote members
+};
+
+/**
+ * @brief An open, memory-mapped package and the index of its members
+ */
+struct PackageReader {
+    std::string path;                                   ///< Path the package was opened from
+    int fd;                                             ///< Descriptor backing the mapping
+    unsigned char* map_base;                            ///< Start of the mapping
+    size_t map_size;                                    ///< Length of the mapping
+    std::map<std::string, PackageMemberView> members;   ///< Member name (without stage prefix) to view
+    std::deque<std::vector<unsigned char>> owned;       ///< Storage for members that could not be mapped
+    std::unique_ptr<RemotePackage> remote;              ///< Source of a remote package, NULL for local files
+    std::mutex remote_mutex;                            ///< Serializes fetches from the remote package
+};
+
+extern "C" {
+    /**
+     * Opens a package file, maps it into memory and indexes its members
+     *
+     * @param package_path Path to the package file (.dpm), or its http:// or https:// URL
+     * @return Opaque reader handle, or NULL on failure
+     */
+    void* package_reader_open(const char* package_path);
+
+    /**
+     * Gets a view of a package member such as "metadata" or "contents"
+     *
+     * The returned pointer stays valid until package_reader_close is called and
+     * must not be freed by the caller.
+     *
+     * @param reader Handle returned by package_reader_open
+     * @param member_name Name of the member, with or without the stage directory prefix
+     * @param data Receives a pointer to the member data
+     * @param data_size Receives the size of the member data
+     * @return true if the member exists, false otherwise
+     */
+    bool package_reader_get_member(void* reader, const char* member_name,
+                                   const unsigned char** data, size_t* data_size);
+
+    /**
+     * Gets the size of a package member without reading it
+     *
+     * Unlike package_reader_get_member this never fetches a member of a
+     * remote package.
+     *
+     * @param reader Handle returned by package_reader_open
+     * @param member_name Name of the member, with or without the stage directory prefix
+     * @param data_size Receives the size of the member data
+     * @return true if the member exists, false otherwise
+     */
+    bool package_reader_get_member_size(void* reader, const char* member_name, size_t* data_size);
+
+    /**
+     * Unmaps the package and releases all resources held by a reader
+     *
+     * @param reader Handle returned by package_reader_open, may be NULL
+     */
+    void package_reader_close(void* reader);
+}
@@ -0,0 +1,244 @@
+/**
+ * @file parallel_gzip.hpp
+ * @brief Block-parallel gzip writer used when sealing components
+ *
+ * Splits the data written to it into fixed-size blocks and deflates the
+ * blocks on several threads, the way pigz does.  Every block is primed with
+ * the last 32 KiB of the block before it, so the compression ratio stays
+ * close to that of a single deflate stream, and ends on a byte boundary
+ * with a sync flush so the compressed blocks can be joined in order.  The
+ * result is one ordinary gzip member that gunzip, zlib and libarchive read
+ * like any other.
+ *
+ * With frames enabled the output is instead cut into independent gzip
+ * members at entry boundaries the caller marks, and ends with a frame index
+ * so readers can start decompressing at any frame, see frame_index.hpp.
+ * The data of an entry can also be given a member of its own, either
+ * compressed as usual and handed back to the caller, or copied from a
+ * member the caller kept from an earlier archive, see content_store.hpp.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "frame_index.hpp"
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "helpers.hpp"
+
+/**
+ * @brief Size of the blocks compressed independently, in bytes
+ */
+#define PARALLEL_GZIP_BLOCK_SIZE (128 * 1024)
+
+/**
+ * @brief Amount of the previous block used as the dictionary of the next, in bytes
+ */
+#define PARALLEL_GZIP_DICTIONARY_SIZE (32 * 1024)
+
+/**
+ * @brief Writes a gzip file, compressing blocks of it on several threads
+ */
+class ParallelGzipWriter {
+public:
+    /**
+     * @brief Prepares a writer; nothing is created until open is called
+     *
+     * @param output_path Path of the gzip file to create
+     * @param thread_count Number of compression threads (at least one)
+     * @param level zlib compression level, Z_DEFAULT_COMPRESSION for the default
+     */
+    ParallelGzipWriter(const std::string& output_path, size_t thread_count, int level);
+
+    /**
+     * @brief Prepares a writer that hands its output to a function instead of a file
+     *
+     * @param output Receives the gzip data in order, returning false to abort
+     * @param thread_count Number of compression threads (at least one)
+     * @param level zlib compression level, Z_DEFAULT_COMPRESSION for the default
+     */
+    ParallelGzipWriter(std::function<bool(const void* data, size_t size)> output, size_t thread_count, int level);
+
+    /**
+     * @brief Stops the compression threads, discarding unfinished output
+     */
+    ~ParallelGzipWriter();
+
+    ParallelGzipWriter(const ParallelGzipWriter&) = delete;
+    ParallelGzipWriter& operator=(const ParallelGzipWriter&) = delete;
+
+    /**
+     * @brief Creates the output file if there is one, writes the gzip header and starts the threads
+     *
+     * @return true on success, false on failure
+     */
+    bool open();
+
+    /**
+     * @brief Queues data for compression
+     *
+     * Blocks while too many blocks are waiting to be written.
+     *
+     * @param data Data to compress
+     * @param size Size of the data in bytes
+     * @return true on success, false if compressing or writing failed
+     */
+    bool write(const void* data, size_t size);
+
+    /**
+     * @brief Cuts the output into independent gzip members and indexes them
+     *
+     * Must be called before open.
+     *
+     * @param frame_size Uncompressed size after which the next marked entry starts a new member
+     */
+    void enable_frames(uint64_t frame_size);
+
+    /**
+     * @brief Records that an archive entry starts at an offset of the uncompressed stream
+     *
+     * Starts a new frame at the entry once the current one has reached the
+     * frame size.  Entries must be marked in order, and the offset may lie
+     * beyond the data written so far.  Does nothing unless frames are enabled.
+     *
+     * @param offset Uncompressed offset of the entry's first header
+     * @param path Path of the entry as stored in the archive
+     */
+    void mark_entry(uint64_t offset, const std::string& path);
+
+    /**
+     * @brief Gives the data of an entry a frame of its own, copied from a gzip member
+     *
+     * The bytes written in the range are not compressed but checked against
+     * the CRC-32 in the member's trailer, and the member is written in their
+     * place.  If they differ, mismatch is called and the writer fails.  Must
+     * be called after the entry is marked and before its data is written.
+     * Does nothing unless frames are enabled.
+     *
+     * @param offset Uncompressed offset of the entry's data
+     * @param size Size of the data with its tar padding
+     * @param member A gzip member decompressing to exactly that data
+     * @param mismatch Called if the data written is not that of the member
+     */
+    void reuse_frame(uint64_t offset, uint64_t size, std::vector<unsigned char> member,
+                     std::function<void()> mismatch);
+
+    /**
+     * @brief Gives the data of an entry a frame of its own and hands the compressed frame to a function
+     *
+     * Called like reuse_frame.  The frame is compressed as usual, and capture
+     * receives the complete gzip member once it is written.
+     *
+     * @param offset Uncompressed offset of the entry's data
+     * @param size Size of the data with its tar padding
+     * @param capture Receives the gzip member
+     */
+    void capture_frame(uint64_t offset, uint64_t size,
+                       std::function<void(const std::vector<unsigned char>& member)> capture);
+
+    /**
+     * @brief Compresses the remaining data, writes the gzip trailer and closes the file
+     *
+     * @return true on success, false on failure
+     */
+    bool close();
+
+private:
+    /**
+     * @brief One block of input and its compressed form
+     */
+    struct Block {
+        std::vector<unsigned char> input;       ///< Uncompressed data
+        std::vector<unsigned char> dictionary;  ///< Tail of the previous block's input
+        std::vector<unsigned char> output;      ///< Raw deflate data, filled by a worker
+        uLong crc;                              ///< CRC-32 of the input, filled by a worker
+        bool last;                              ///< Ends the deflate stream and its gzip member
+        bool done;                              ///< Set once output and crc are final
+        bool failed;                            ///< Set if the block could not be compressed
+        uint64_t member_size;                   ///< Uncompressed size if output is a whole stored member, else 0
+    };
+
+    /**
+     * @brief Entry data given a frame of its own
+     */
+    struct FrameSpan {
+        uint64_t start;                         ///< Uncompressed offset of the data
+        uint64_t end;                           ///< Uncompressed offset just past its padding
+        std::vector<unsigned char> member;      ///< Member to copy in, empty if the frame is compressed
+        std::function<void()> mismatch;         ///< Called if the data is not that of member
+        std::function<void(const std::vector<unsigned char>&)> capture;    ///< Receives a compressed frame
+        uLong crc;                              ///< CRC-32 of the data seen so far, when copying member
+        bool started;                           ///< Set once the input has reached start
+    };
+
+    void worker_loop();
+    bool compress_block(Block& block);
+    bool dispatch(bool last);
+    bool write_completed(size_t keep_pending);
+    bool write_all(const void* data, size_t size);
+    bool add_span(FrameSpan span);
+    bool advance_span(bool& advanced);
+    bool finish_span();
+    void stop_workers();
+
+    std::string _output_path;
+    std::function<bool(const void* data, size_t size)> _output;    ///< Used instead of a file when set
+    size_t _thread_count;
+    int _level;
+    int _fd;
+    bool _failed;
+
+    std::vector<unsigned char> _current;        ///< Block being filled by write
+    std::vector<unsigned char> _previous_tail;  ///< Dictionary for the block being filled
+    uLong _crc;                                 ///< CRC-32 of the current member so far
+    uLong _total_in;                            ///< Bytes in the current member, modulo 2^32 as gzip records it
+    bool _member_open;                          ///< Set once the current member's header is written
+    uint64_t _input_offset;                     ///< Uncompressed bytes accepted by write
+    uint64_t _written_in;                       ///< Uncompressed bytes whose compressed form is written
+    uint64_t _written_out;                      ///< Compressed bytes written
+
+    uint64_t _frame_size;                       ///< 0 for a single member
+    uint64_t _last_cut;                         ///< Uncompressed offset of the last frame requested
+    uint64_t _cut_count;                        ///< Number of frames requested after the first
+    std::deque<uint64_t> _frame_cuts;           ///< Offsets at which write still has to start a frame
+    FrameIndex _frame_index;
+    std::deque<FrameSpan> _spans;               ///< Frames of entry data write has not finished
+    std::deque<FrameSpan> _captures;            ///< Compressed span frames not yet written out
+    bool _capturing;                            ///< Set while the member being written is captured
+    std::vector<unsigned char> _capture_buffer; ///< The captured member so far
+
+    std::deque<std::shared_ptr<Block>> _pending;    ///< Dispatched blocks in output order
+    std::deque<std::shared_ptr<Block>> _queue;      ///< Blocks waiting for a worker
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _work_available;
+    std::condition_variable _block_done;
+    bool _stopping;
+};
+
+/**
+ * @brief Gets the number of threads used to compress components
+ *
+ * Uses the "compression_threads" key in the [build] configuration section,
+ * falling back to the number of threads of the shared worker pool when it
+ * is unset or 0.
+ * A value of 1 keeps libarchive's single-threaded gzip filter.
+ *
+ * @return Number of compression threads, always at least 1
+ */
+size_t parallel_gzip_thread_count();
@@ -0,0 +1,195 @@
+/**
+ * @file remote_package.hpp
+ * @brief Byte range access to packages served over HTTP and HTTPS
+ *
+ * A package named by an http:// or https:// URL is read with Range
+ * requests over one kept-alive connection.  The package reader fetches the
+ * first PACKAGE_INDEX_SEARCH_SIZE bytes to find the package index and then
+ * only the byte ranges of the members it is asked for, so the metadata and
+ * signatures of a package can be checked without transferring its contents
+ * component.  Servers that ignore Range get the package downloaded once and
+ * served from memory.
+ *
+ * HTTPS certificates are verified against the system trust store, or the
+ * CA file set by the remote_ca_file key of the build section.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <unistd.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief Redirects followed before a fetch is given up
+ */
+#define REMOTE_PACKAGE_MAX_REDIRECTS 5
+
+/**
+ * @brief Size of the receive buffer of a connection
+ */
+#define REMOTE_PACKAGE_BUFFER_SIZE (64 * 1024)
+
+/**
+ * @brief Seconds a connect, send or receive may block when [build] remote_timeout is not set
+ */
+#define REMOTE_PACKAGE_DEFAULT_TIMEOUT 30
+
+/**
+ * @brief Largest response body accepted when the package size is not known yet
+ *
+ * Bodies are otherwise limited to the range asked for, or to the package
+ * size reported by an earlier Content-Range, so a broken or hostile server
+ * cannot make the reader allocate without bound.
+ */
+#define REMOTE_PACKAGE_MAX_BODY (4ULL * 1024 * 1024 * 1024)
+
+/**
+ * @brief Checks whether a package path names a remote package
+ *
+ * @param path Package path or URL
+ * @return true if the path starts with http:// or https://
+ */
+bool remote_package_is_url(const char* path);
+
+/**
+ * @brief A package on an HTTP or HTTPS server, read by byte range
+ *
+ * Requests reuse one connection for as long as the server keeps it open,
+ * and a request that finds a kept-alive connection closed is retried once
+ * on a new one.  A source is not safe for concurrent use.
+ */
+class RemotePackage {
+public:
+    /**
+     * @brief Prepares a source for a URL without connecting
+     *
+     * @param url http:// or https:// URL of the package
+     */
+    explicit RemotePackage(const std::string& url);
+
+    ~RemotePackage();
+
+    /**
+     * @brief Checks whether the URL could be parsed
+     *
+     * @return true if the source can fetch, false otherwise
+     */
+    bool valid() const;
+
+    /**
+     * @brief Fetches a byte range of the package
+     *
+     * A range running past the end of the package is cut short at it.
+     *
+     * @param offset Offset of the first byte
+     * @param length Number of bytes to fetch, 0 for everything from offset on
+     * @param data Receives the bytes
+     * @return true on success, false on connection, HTTP or TLS errors
+     */
+    bool fetch(uint64_t offset, uint64_t length, std::vector<unsigned char>& data);
+
+    /**
+     * @brief Gets the size of the package
+     *
+     * @return Size in bytes, or 0 until a response has reported it
+     */
+    uint64_t size() const;
+
+    /**
+     * @brief Gets the URL the package is read from, after any redirect
+     *
+     * @return URL of the package
+     */
+    const std::string& url() const;
+
+    /**
+     * @brief Gets the number of body bytes received
+     *
+     * @return Bytes received
+     */
+    uint64_t bytes_received() const;
+
+    /**
+     * @brief Gets the number of requests sent and connections opened
+     *
+     * @param requests Receives the number of requests
+     * @param connections Receives the number of connections
+     */
+    void request_counts(size_t& requests, size_t& connections) const;
+
+    RemotePackage(const RemotePackage&) = delete;
+    RemotePackage& operator=(const RemotePackage&) = delete;
+
+private:
+    /**
+     * @brief A parsed response head
+     */
+    struct Response {
+        int status = 0;
+        bool keep_alive = true;
+        bool chunked = false;
+        bool has_length = false;
+        uint64_t content_length = 0;
+        std::string content_range;
+        std::string location;
+    };
+
+    bool parse_url(const std::string& url);
+    bool connect();
+    void disconnect();
+    bool send_all(const std::string& data);
+    long read_some(char* buffer, size_t size);
+    bool fill();
+    bool read_line(std::string& line);
+    bool read_body(uint64_t length, std::vector<unsigned char>& body, uint64_t limit);
+    bool read_chunked(std::vector<unsigned char>& body, uint64_t limit);
+    bool read_to_close(std::vector<unsigned char>& body, uint64_t limit);
+    bool exchange(const std::string& range, uint64_t range_limit, uint64_t whole_limit,
+                  Response& response, std::vector<unsigned char>& body, bool& stale);
+    bool fetch_range(uint64_t offset, uint64_t length, const std::string& range, std::vector<unsigned char>& data);
+    bool slice(uint64_t offset, uint64_t length, std::vector<unsigned char>& data) const;
+
+    std::string _url;
+    bool _valid;
+    bool _tls;
+    std::string _host;
+    std::string _port;
+    std::string _target;
+    int _timeout;
+
+    int _fd;
+    SSL* _ssl;
+    std::vector<char> _buffer;
+    size_t _buffer_start;
+    size_t _buffer_end;
+
+    uint64_t _size;
+    bool _whole;                        ///< Set once the server ignored a Range and sent the whole package
+    std::vector<unsigned char> _data;   ///< The whole package, when _whole is set
+    uint64_t _bytes_received;
+    size_t _requests;
+    size_t _connections;
+};
@@ -0,0 +1,70 @@
+/**
+ * @file seal_fingerprint.hpp
+ * @brief Fingerprint of a package stage, to skip sealing a stage that has not changed
+ *
+ * The fingerprint is a digest of the stat tuple of every entry in every
+ * component of a stage, or of the archive of a sealed component, together
+ * with the compression settings and hash algorithms in effect.  Computing
+ * it only walks the stage, so it costs a small fraction of a seal.
+ *
+ * After a final package is written, the fingerprint of the stage is stored
+ * in the stage root along with the kind of seal and the path, size and
+ * modification time of the package.  A later seal of the same kind of the
+ * same stage into the same package is skipped while both the fingerprint
+ * and the package are unchanged.  The record is local build state, never
+ * part of a package.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <cstdint>
+#include <sys/stat.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "checksums.hpp"
+#include "compression.hpp"
+#include "tree_walk.hpp"
+
+/**
+ * @brief Name of the seal fingerprint record in the stage root
+ */
+#define SEAL_FINGERPRINT_FILENAME ".dpm_seal_fingerprint"
+
+/**
+ * @brief Computes the fingerprint of a stage
+ *
+ * @param stage_path Root directory of the package stage
+ * @param fingerprint Receives the hexadecimal fingerprint
+ * @return true on success, false if the stage could not be walked
+ */
+bool seal_fingerprint_compute(const std::filesystem::path& stage_path, std::string& fingerprint);
+
+/**
+ * @brief Checks whether a package was sealed from the stage as it is now
+ *
+ * @param stage_path Root directory of the package stage
+ * @param package_path Final package the stage would be sealed into
+ * @param seal_kind Kind of seal about to run, e.g. "stream"
+ * @return true if the stored record matches the current fingerprint, kind and package, false otherwise
+ */
+bool seal_fingerprint_unchanged(const std::filesystem::path& stage_path, const std::filesystem::path& package_path,
+                                const std::string& seal_kind);
+
+/**
+ * @brief Records that a package was sealed from the stage as it is now
+ *
+ * A failure is logged and only means the next seal is not skipped.
+ *
+ * @param stage_path Root directory of the package stage
+ * @param package_path Final package that was written
+ * @param seal_kind Kind of seal that wrote it
+ */
+void seal_fingerprint_store(const std::filesystem::path& stage_path, const std::filesystem::path& package_path,
+                            const std::string& seal_kind);
@@ -26,12 +26,99 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <metadata.hpp>
+#include "parallel_gzip.hpp"
+#include "compression.hpp"
+#include "task_graph.hpp"
+#include "spill_buffer.hpp"
+#include "file_prefetcher.hpp"
+#include "disk_write_pool.hpp"
+#include "tree_walk.hpp"
+#include "package_index.hpp"
+#include "seal_fingerprint.hpp"
+#include "content_store.hpp"
+#include "checksums.hpp"
+#include <functional>
+#include <memory>
+#include <ctime>
+#include <stdexcept>
+#include <sys/stat.h>
+
+/**
+ * @brief Receives the bytes of an archive as compress_directory_to_sink produces them
+ *
+ * Returns false to abort the archive.
+ */
+typedef std::function<bool(const void* data, size_t size)> ArchiveOutputSink;
+
+/**
+ * @brief Receives the contents of every regular file as it is archived
+ *
+ * Lets whatever needs the files' bytes, such as their digests, share the
+ * single read done to archive them.  Returning false aborts the archive.
+ */
+class ArchiveFileObserver {
+public:
+    virtual ~ArchiveFileObserver() = default;
+
+    /**
+     * @brief Called before the first byte of a file
+     *
+     * @param relative_path Path of the file relative to the archived directory
+     * @param st Result of stat() on the file, taken before it was read
+     * @return true to continue, false to abort
+     */
+    virtual bool begin_file(const std::string& relative_path, const struct stat& st) = 0;
+
+    /**
+     * @brief Called with each block of the file, in order
+     *
+     * @param data File data
+     * @param size Size of the data in bytes
+     * @return true to continue, false to abort
+     */
+    virtual bool file_data(const void* data, size_t size) = 0;
+
+    /**
+     * @brief Called after the last byte of a file
+     *
+     * @return true to continue, false to abort
+     */
+    virtual bool end_file() = 0;
+};
+
+/**
+ * @brief Optional consumers of the data passing through an archive being written
+ */
+struct ArchiveTee {
+    ArchiveOutputSink output;       ///< Receives the compressed archive as well, if set
+    ArchiveFileObserver* files;     ///< Receives the bytes of each file read, if set
+    const TreeWalk* walk;           ///< Sorted walk of the directory to archive, walked anew if not set
+};
+
+/**
+ * @brief Turns a directory into a compressed tarball streamed to a function
+ *
+ * Produces the same archive compress_directory writes to a file, entries
+ * prefixed with the name of the directory.
+ *
+ * @param source_dir Directory to archive
+ * @param compression Codec and level to compress with
+ * @param sink Receives the archive, in order
+ * @param tee Additional consumers of the archive and the files' bytes, or NULL
+ * @return true on success, false on failure
+ */
+bool compress_directory_to_sink( const std::string& source_dir, const CompressionSettings& compression,
+                                 const ArchiveOutputSink& sink, const ArchiveTee* tee = nullptr );
 
 /**
  * @brief First phase of sealing a package stage directory
  *
  * Replaces contents, metadata, hooks, and signatures directories with
- * gzipped tarballs, creating the intermediate package format.
+ * tarballs compressed with the codec configured for each component (see
+ * compression.hpp), creating the intermediate package format.  The
+ * components are compressed concurrently, and the contents manifest and
+ * hooks digest are written from digests taken while the files were being
+ * compressed, so every source file is read exactly once.
  *
  * @param stage_dir Path to the package stage directory
  * @param force Whether to force the operation even if warnings occur
@@ -44,19 +131,40 @@ extern "C" int seal_stage_components( const std::string& stage_dir, bool force )
  *
  * Ensures all components are already sealed (compressed), then
  * creates a final package by compressing the entire stage directory.
+ * Nothing is done when the stage and the package are unchanged since the
+ * package was last sealed from it, see seal_fingerprint.hpp.
  *
  * @param stage_dir Path to the package stage directory
  * @param output_dir Path to directory where final package should be placed (optional)
- * @param force Whether to force the operation even if warnings occur
+ * @param force Whether to force the operation even if warnings occur or nothing changed
  * @return 0 on success, non-zero on failure
  */
 extern "C" int seal_final_package(const std::string &stage_dir, const std::string &output_dir, bool force);
 
+/**
+ * @brief Seals a package stage directly into the final package in one pass
+ *
+ * Produces the same package as seal_final_package, but compresses every
+ * component straight into a buffer that becomes a member of the package,
+ * held in memory up to [build] stream_seal_memory bytes per component and
+ * spilled to an unlinked temporary file next to the package beyond that.
+ * The compressed bytes are hashed as they are produced.  Nothing is
+ * written into the stage apart from the refreshed metadata, so the stage
+ * stays unsealed and ready for the next build.  As with seal_final_package,
+ * an unchanged stage is not sealed again into an unchanged package.
+ *
+ * @param stage_dir Path to the package stage directory
+ * @param output_dir Path to directory where final package should be placed (optional)
+ * @param force Whether to force the operation even if warnings occur or nothing changed
+ * @return 0 on success, non-zero on failure
+ */
+extern "C" int seal_final_package_streaming(const std::string& stage_dir, const std::string& output_dir, bool force);
+
 /**
  * @brief Unseals a package file back to stage format
  *
  * Extracts a sealed package file back to its original stage directory structure
- * by expanding the gzipped tarballs.
+ * by expanding the compressed tarballs, whatever their codec.
  *
  * @param package_path Path to the sealed package file
  * @param output_dir Path to extract the package stage to
@@ -15,16 +15,79 @@
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <mutex>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <gpgme.h>
 #include <dpmdk/include/CommonModuleAPI.hpp>
 #include "helpers.hpp"
 #include "sealing.hpp"
+#include "task_graph.hpp"
+
+/**
+ * @brief GPGME set up and a signing key resolved once, for making several signatures
+ *
+ * Looking the key up can mean a round trip to gpg-agent or a smartcard, so
+ * a session does it once in open.  Every signature is then made in a
+ * context of its own, so sign_buffer and sign_file may be called from
+ * several threads at once.
+ */
+class SigningSession {
+public:
+    SigningSession();
+
+    /**
+     * @brief Releases the signing key
+     */
+    ~SigningSession();
+
+    SigningSession(const SigningSession&) = delete;
+    SigningSession& operator=(const SigningSession&) = delete;
+
+    /**
+     * @brief Initializes GPGME and looks up the signing key
+     *
+     * @param key_id GPG key ID or email to sign with
+     * @return true on success, false if GPGME is unavailable or the key was not found
+     */
+    bool open(const std::string& key_id);
+
+    /**
+     * @brief Makes an ASCII-armored detached signature of a buffer
+     *
+     * The buffer is handed to GPGME without copying, so it may be a mapped file.
+     *
+     * @param data Data to sign
+     * @param size Size of the data in bytes
+     * @param signature Receives the signature
+     * @return true on success, false on failure
+     */
+    bool sign_buffer(const unsigned char* data, size_t size, std::string& signature);
+
+    /**
+     * @brief Signs a file by mapping it and writes the detached signature to its own file
+     *
+     * @param path File to sign
+     * @param signature_path Signature file to create or replace
+     * @return true on success, false on failure
+     */
+    bool sign_file(const std::filesystem::path& path, const std::filesystem::path& signature_path);
+
+private:
+    std::string _key_id;
+    gpgme_key_t _key;
+};
 
 /**
  * @brief Signs a package stage directory
  *
  * Creates detached GPG signatures for the contents, hooks, and metadata
- * components of a package stage directory.
+ * components of a package stage directory, concurrently and with a single
+ * key lookup.
  *
  * @param stage_dir Path to the package stage directory
  * @param key_id GPG key ID or email to use for signing
@@ -33,6 +96,18 @@
  */
 int sign_stage_directory(const std::string& stage_dir, const std::string& key_id, bool force);
 
+/**
+ * @brief Signs a package stage directory with a session that is already open
+ *
+ * Lets a batch sign many stages with a single key lookup.
+ *
+ * @param stage_dir Path to the package stage directory
+ * @param session Open signing session, may be shared with other threads
+ * @param force Whether to force the operation even if warnings occur
+ * @return 0 on success, non-zero on failure
+ */
+int sign_stage_directory(const std::string& stage_dir, SigningSession& session, bool force);
+
 /**
  * @brief Signs a package file
  *
@@ -43,4 +118,47 @@ int sign_stage_directory(const std::string& stage_dir, const std::string& key_id
  * @param force Whether to force the operation even if warnings occur
  * @return 0 on success, non-zero on failure
  */
-int sign_package_file(const std::string& package_path, const std::string& key_id, bool force);
\ No newline at end of file
+int sign_package_file(const std::string& package_path, const std::string& key_id, bool force);
+
+/**
+ * @brief Signs a package file with a session that is already open
+ *
+ * @param package_path Path to the package file
+ * @param session Open signing session, may be shared with other threads
+ * @param force Whether to force the operation even if warnings occur
+ * @return 0 on success, non-zero on failure
+ */
+int sign_package_file(const std::string& package_path, SigningSession& session, bool force);
+
+/**
+ * @brief Initialises GPGME and the keyring location ahead of the first signature
+ *
+ * Signing and verification do this themselves on first use; a resident
+ * process calls it up front so every invocation it serves starts with it done.
+ *
+ * @return true if GPGME and the OpenPGP engine are usable, false otherwise
+ */
+bool signing_preload();
+
+extern "C" {
+    /**
+     * @brief Verifies a detached signature over a buffer already in memory
+     *
+     * Both the signed data and the signature are handed to GPGME with
+     * gpgme_data_new_from_mem without copying, so mapped package members can be
+     * checked in place.  GPGME and the keyring location are set up once per
+     * process; each call uses its own context, so calls may run concurrently
+     * from different threads.
+     *
+     * @param data Pointer to the signed data
+     * @param data_size Size of the signed data
+     * @param signature Pointer to the detached (armored or binary) signature
+     * @param signature_size Size of the signature
+     * @param signer_fpr Optional buffer that receives the signing key fingerprint
+     * @param signer_fpr_size Size of the signer_fpr buffer
+     * @return 0 if the signature is good, non-zero otherwise
+     */
+    int verify_detached_signature_memory(const unsigned char* data, size_t data_size,
+                                         const unsigned char* signature, size_t signature_size,
+                                         char* signer_fpr, size_t signer_fpr_size);
+}
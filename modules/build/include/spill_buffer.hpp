@@ -0,0 +1,97 @@
+/**
+ * @file spill_buffer.hpp
+ * @brief Memory buffer that spills to an anonymous temporary file
+ *
+ * Holds a stream of bytes whose final size is needed before it can be
+ * written out, such as a compressed component that becomes a member of the
+ * outer package tar.  Data stays in memory up to a limit and moves to an
+ * already unlinked temporary file beyond it, so nothing is left behind on
+ * failure and a small component never touches the disk.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief Default amount of data a spill buffer keeps in memory, in bytes
+ */
+#define SPILL_BUFFER_DEFAULT_MEMORY_LIMIT (64ULL * 1024 * 1024)
+
+/**
+ * @brief Append-only byte buffer, in memory up to a limit and in a temporary file beyond it
+ */
+class SpillBuffer {
+public:
+    /**
+     * @brief Creates an empty buffer
+     *
+     * @param spill_dir Directory the temporary file is created in if the limit is exceeded
+     * @param memory_limit Number of bytes kept in memory before spilling
+     */
+    SpillBuffer(const std::filesystem::path& spill_dir, uint64_t memory_limit);
+
+    /**
+     * @brief Closes the temporary file, which the system then discards
+     */
+    ~SpillBuffer();
+
+    SpillBuffer(const SpillBuffer&) = delete;
+    SpillBuffer& operator=(const SpillBuffer&) = delete;
+
+    /**
+     * @brief Appends data to the buffer
+     *
+     * @param data Data to append
+     * @param size Size of the data in bytes
+     * @return true on success, false if the temporary file could not be created or written
+     */
+    bool write(const void* data, size_t size);
+
+    /**
+     * @brief Gets the number of bytes written so far
+     *
+     * @return Size of the buffered data in bytes
+     */
+    uint64_t size() const;
+
+    /**
+     * @brief Hands the buffered data, in order, to a function
+     *
+     * @param consume Receives each piece of data, returning false to stop
+     * @return true if all the data was read and consumed, false otherwise
+     */
+    bool replay(const std::function<bool(const void* data, size_t size)>& consume);
+
+private:
+    bool spill();
+
+    std::filesystem::path _spill_dir;
+    uint64_t _memory_limit;
+    std::vector<unsigned char> _memory;
+    uint64_t _size;
+    int _fd;
+};
+
+/**
+ * @brief Gets the configured per-component memory limit of a streaming seal
+ *
+ * Uses the "stream_seal_memory" key in the [build] configuration section.
+ *
+ * @return Memory limit in bytes
+ */
+uint64_t spill_buffer_memory_limit();
@@ -21,6 +21,7 @@
 #include <grp.h>
 #include "checksums.hpp"
 #include "metadata.hpp"
+#include "tree_copy.hpp"
 
 /**
  * @brief Stages a DPM package
@@ -35,6 +36,7 @@
  * @param architecture Package architecture
  * @param os Package OS (optional)
  * @param force Force package staging even if warnings occur
+ * @param link Hard link the contents files instead of copying them
  * @return 0 on success, non-zero on failure
  */
 int build_package_stage(
@@ -45,5 +47,6 @@ int build_package_stage(
     const std::string& package_version,
     const std::string& architecture,
     const std::string& os,
-    bool force
+    bool force,
+    bool link
 );
\ No newline at end of file
@@ -0,0 +1,122 @@
+/**
+ * @file stat_cache.hpp
+ * @brief Sidecar cache of file stat information and digests for a package stage
+ *
+ * Remembers, for every file in a stage's contents directory, the stat tuple
+ * (size, modification time, inode and change time) it had when it was last
+ * hashed along with the resulting digest.  Refreshing the contents manifest
+ * then only rehashes files whose stat tuple, or the configured algorithm,
+ * has changed since.
+ *
+ * The cache lives in the stage root and is never sealed into a package.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "checksums.hpp"
+
+/**
+ * @brief Name of the stat cache file in the stage root
+ */
+#define STAT_CACHE_FILENAME ".dpm_stat_cache"
+
+/**
+ * @brief Cached stat tuple and digest of a single contents file
+ */
+struct StatCacheEntry {
+    uint64_t size;              ///< File size in bytes
+    int64_t mtime_ns;           ///< Modification time in nanoseconds since the epoch
+    uint64_t inode;             ///< Inode number
+    int64_t ctime_ns;           ///< Status change time in nanoseconds since the epoch
+    std::string algorithm;      ///< Hash algorithms the digests were calculated with, comma separated
+    std::string digest;         ///< Hexadecimal digests of the file contents, comma separated
+};
+
+/**
+ * @brief Stat cache keyed by path relative to the contents directory
+ */
+typedef std::unordered_map<std::string, StatCacheEntry> StatCache;
+
+/**
+ * @brief Loads the stat cache of a stage
+ *
+ * A missing, unreadable or malformed cache simply yields an empty cache so
+ * that every file is hashed.
+ *
+ * @param stage_dir Root directory of the package stage
+ * @param cache Cache to populate
+ */
+void stat_cache_load(const std::filesystem::path& stage_dir, StatCache& cache);
+
+/**
+ * @brief Writes the stat cache of a stage, replacing any previous cache
+ *
+ * @param stage_dir Root directory of the package stage
+ * @param cache Cache to write
+ * @return true on success, false if the cache could not be written
+ */
+bool stat_cache_save(const std::filesystem::path& stage_dir, const StatCache& cache);
+
+/**
+ * @brief Builds the cache entry of a file hashed elsewhere, e.g. while it was being archived
+ *
+ * @param st Result of stat() on the file, taken before it was read
+ * @param algorithms Hash algorithms the digests were calculated with, primary first
+ * @param digests Hexadecimal digests in the order of algorithms
+ * @return Cache entry recording the stat tuple and digests
+ */
+StatCacheEntry stat_cache_make_entry(const struct stat& st, const std::vector<std::string>& algorithms,
+                                     const std::vector<std::string>& digests);
+
+/**
+ * @brief Looks up the primary digest of a file that has not changed since it was last hashed
+ *
+ * @param cache Cache loaded from the stage
+ * @param relative_path Path of the file relative to the contents directory
+ * @param st Result of stat() on the file
+ * @param algorithm Primary hash algorithm the digest must have been calculated with
+ * @param digest Receives the hexadecimal digest
+ * @return true if the cache holds a digest for the file as it is now, false otherwise
+ */
+bool stat_cache_lookup(const StatCache& cache, const std::string& relative_path, const struct stat& st,
+                       const std::string& algorithm, std::string& digest);
+
+/**
+ * @brief Gets the checksums of a contents file, reusing the cached digests when possible
+ *
+ * The cached digests are reused only if the file's size, modification time,
+ * inode and change time all match the cache and they were calculated with
+ * the same algorithms.  Otherwise the file is hashed, once for all of the
+ * algorithms.  Either way the result is recorded in the updated cache.
+ *
+ * @param previous Cache loaded before the refresh
+ * @param updated Cache being built for the files seen during this refresh
+ * @param relative_path Path of the file relative to the contents directory
+ * @param full_path Path of the file on disk
+ * @param algorithms Configured hash algorithms, primary first
+ * @param full_rehash Ignore the cache and hash the file regardless
+ * @param reused Set to true if the cached digests were used
+ * @return Hexadecimal checksums in the order of algorithms, or an empty vector on failure
+ */
+std::vector<std::string> stat_cache_file_checksums(
+    const StatCache& previous,
+    StatCache& updated,
+    const std::string& relative_path,
+    const std::filesystem::path& full_path,
+    const std::vector<std::string>& algorithms,
+    bool full_rehash,
+    bool& reused);
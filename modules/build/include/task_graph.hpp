@@ -0,0 +1,75 @@
+/**
+ * @file task_graph.hpp
+ * @brief Runs dependent build steps concurrently
+ *
+ * A small dependency graph of named tasks.  Every task is queued on the
+ * DPM core's shared worker pool as soon as all the tasks it depends on
+ * have succeeded, with at most a fixed number running at once; when a task
+ * fails, everything that depends on it is skipped while unrelated tasks
+ * still run to completion.  No thread blocks waiting for a dependency, so
+ * the steps themselves may use the shared pool.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief A set of tasks and the order they must respect
+ */
+class TaskGraph {
+public:
+    /**
+     * @brief Adds a task to the graph
+     *
+     * @param name Name used in log messages
+     * @param work Function doing the work, returning true on success
+     * @param dependencies Tasks, as returned by add, that must succeed first
+     * @return Identifier of the new task
+     */
+    size_t add(const std::string& name, std::function<bool()> work, const std::vector<size_t>& dependencies = {});
+
+    /**
+     * @brief Runs every task, at most worker_count at a time
+     *
+     * @param worker_count Number of tasks to run at once, at least one is used
+     * @return true if every task succeeded, false if any failed or was skipped
+     */
+    bool run(size_t worker_count);
+
+private:
+    enum class State { WAITING, RUNNING, SUCCEEDED, FAILED, SKIPPED };
+
+    struct Task {
+        std::string name;
+        std::function<bool()> work;
+        std::vector<size_t> dependencies;
+        State state;
+    };
+
+    // finds a task whose dependencies all succeeded, and skips those that can no longer run
+    bool next_ready(size_t& task_id);
+    // marks ready tasks running while fewer than the limit are, called with _mutex held
+    std::vector<size_t> take_ready();
+    // queues tasks taken by take_ready on the shared worker pool
+    void launch(const std::vector<size_t>& task_ids);
+    void run_task(size_t task_id);
+    static void task_entry(void* context);
+
+    std::vector<Task> _tasks;
+    std::vector<std::pair<TaskGraph*, size_t>> _entries;    ///< Context of each task on the pool
+    dpm_task_group* _group = nullptr;
+    size_t _limit = 1;
+    size_t _running = 0;
+    std::mutex _mutex;
+};
@@ -0,0 +1,75 @@
+/**
+ * @file tree_copy.hpp
+ * @brief Copies a directory tree into a package stage
+ *
+ * Copies every file of a tree from several tasks on the shared worker pool,
+ * sharing data with the source where the filesystem allows it: a reflink
+ * (FICLONE) on btrfs and XFS, copy_file_range where the kernel can copy
+ * without the data passing through user space, and a plain read and write
+ * otherwise.  A hard link mode makes the stage share the source files
+ * outright.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "file_prefetcher.hpp"
+#include "tree_walk.hpp"
+#include "content_store.hpp"
+
+/**
+ * @brief How files are placed in the destination tree
+ */
+enum class TreeCopyMode {
+    /// Independent copies, reflinked when the filesystem supports it
+    COPY,
+    /// Hard links to the source files, copied where linking is not possible
+    HARDLINK
+};
+
+/**
+ * @brief Copies the contents of a directory into another
+ *
+ * Directories are created in the order they are walked and the files are
+ * then copied concurrently.  Symlinks are followed, as the stage holds the
+ * files they point to.  With a content store, regular files of at least
+ * its minimum size are placed from the store, see content_store.hpp.
+ *
+ * @param source_path Directory to copy the contents of
+ * @param dest_path Existing directory to copy into, existing files are overwritten
+ * @param mode Whether to copy or hard link the files
+ * @param worker_count Number of files to copy at once, at least one is used
+ * @param store Content store to place large files through, or NULL
+ * @return true if every entry was copied, false otherwise
+ */
+bool tree_copy(const std::filesystem::path& source_path, const std::filesystem::path& dest_path,
+               TreeCopyMode mode, size_t worker_count, const ContentStore* store = nullptr);
+
+/**
+ * @brief Gets the number of threads used to copy files into a stage
+ *
+ * Uses the "stage_threads" key in the [build] configuration section,
+ * falling back to the number of threads of the shared worker pool when it
+ * is unset or 0.
+ *
+ * @return Number of threads, always at least 1
+ */
+size_t tree_copy_worker_count();
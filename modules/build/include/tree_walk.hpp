@@ -0,0 +1,82 @@
+/**
+ * @file tree_walk.hpp
+ * @brief Parallel directory tree walker
+ *
+ * Lists every entry below a directory with the lstat of each, reading
+ * directories from several tasks on the DPM core's shared worker pool.
+ * Directories are read with openat and
+ * getdents64 and stat'ed with fstatat relative to their open directory, so
+ * no path is resolved from the root more than once; each walker works
+ * through the subdirectories it found itself and steals from the others
+ * when it runs out.  On network filesystems, where every call waits on the
+ * server, this overlaps the round trips.
+ *
+ * The result is sorted by relative path, which puts every directory before
+ * its contents and makes anything built from the walk reproducible.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "helpers.hpp"
+
+/**
+ * @brief One entry found by a tree walk
+ */
+struct TreeWalkEntry {
+    /// Path relative to the walked directory, without a leading slash
+    std::string relative_path;
+    /// lstat of the entry, so a symlink describes the link itself
+    struct stat st;
+    /// Whether the entry is a directory or a symlink to one; symlinked directories are not descended into
+    bool is_directory;
+};
+
+/**
+ * @brief Every entry below a directory, the directory itself excluded
+ */
+typedef std::vector<TreeWalkEntry> TreeWalk;
+
+/**
+ * @brief Walks a directory tree
+ *
+ * @param root Directory to walk
+ * @param walk Receives the entries, sorted by relative path when sorted is set
+ * @param worker_count Number of walkers to read directories with, at least one is used
+ * @param sorted Whether to sort the entries, otherwise they are in no particular order
+ * @return true if every directory could be read, false otherwise
+ */
+bool tree_walk(const std::filesystem::path& root, TreeWalk& walk, size_t worker_count, bool sorted = true);
+
+/**
+ * @brief Gets the number of threads used to walk a directory tree
+ *
+ * Uses the "walk_threads" key in the [build] configuration section.  When
+ * it is unset or 0 the thread count of the shared worker pool is used, but
+ * at least 4, as a walk spends its time waiting on the filesystem.  A batch
+ * shares the count between the items it runs at once, down to a single
+ * thread each.
+ *
+ * @return Number of threads, always at least 1
+ */
+size_t tree_walk_worker_count();
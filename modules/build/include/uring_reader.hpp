@@ -0,0 +1,154 @@
+/**
+ * @file uring_reader.hpp
+ * @brief Reads batches of small files through io_uring
+ *
+ * Reading a tree of small files one open/read/close at a time leaves fast
+ * storage idle between requests.  The uring reader keeps up to a queue depth
+ * of files in flight at once, each moving through an openat, a read and a
+ * close submitted to an io_uring, so the device sees many requests at a time
+ * while a single thread drives them.
+ *
+ * The ring is set up with raw system calls, so no liburing is needed.
+ * Whether the running kernel supports it, with every operation used, is
+ * probed once per process; [build] io_uring = false turns it off.  Callers
+ * always keep their plain read path and use it for whatever the uring
+ * reader did not read.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <mutex>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief Number of files a uring reader keeps in flight by default
+ */
+#define URING_READER_DEFAULT_DEPTH 64
+
+/**
+ * @brief Largest file, in bytes, the uring reader reads in one request
+ */
+#define URING_READER_MAX_FILE_SIZE (64ULL * 1024 * 1024)
+
+/**
+ * @brief A file to read through the uring reader
+ */
+struct UringReadRequest {
+    /// Path of the file
+    const char* path;
+    /// Size the file is expected to have, a file of any other size is not read
+    uint64_t size;
+};
+
+/**
+ * @brief A file being read by UringFileReader::read_files
+ */
+struct UringSlot;
+
+/**
+ * @brief Reads whole files through an io_uring of its own
+ *
+ * A reader is used by one thread at a time.
+ */
+class UringFileReader {
+public:
+    /**
+     * @brief Checks whether io_uring can be used in this process
+     *
+     * Probes the kernel on the first call, and checks [build] io_uring.
+     *
+     * @return true if the kernel supports the operations used and io_uring is not disabled
+     */
+    static bool supported();
+
+    /**
+     * @brief Sets up a ring, if io_uring is supported
+     *
+     * @param depth Number of files kept in flight
+     */
+    explicit UringFileReader(unsigned int depth = URING_READER_DEFAULT_DEPTH);
+
+    /**
+     * @brief Tears down the ring
+     */
+    ~UringFileReader();
+
+    UringFileReader(const UringFileReader&) = delete;
+    UringFileReader& operator=(const UringFileReader&) = delete;
+
+    /**
+     * @brief Checks whether the ring was set up and is still usable
+     *
+     * @return true if read_files can read files
+     */
+    bool active() const;
+
+    /**
+     * @brief Gets the number of files kept in flight
+     *
+     * @return The queue depth
+     */
+    unsigned int depth() const;
+
+    /**
+     * @brief Reads a batch of files
+     *
+     * Files are read in any order.  Only files that were read whole, at
+     * their expected size, are handed to the callback, which may take the
+     * data but must not throw; a file that could not be opened, or whose
+     * size changed, is left to the caller to read another way, as is every
+     * file not yet read when the ring fails.
+     *
+     * @param requests Files to read
+     * @param read Receives the index of each file read in requests and its contents
+     * @return true if every request was attempted, false if the ring failed and is no longer active
+     */
+    bool read_files(const std::vector<UringReadRequest>& requests,
+                    const std::function<void(size_t index, std::vector<unsigned char>& data)>& read);
+
+private:
+    bool setup(unsigned int entries);
+    void teardown();
+    io_uring_sqe* next_sqe();
+    void push_sqe();
+    bool submit(unsigned int to_submit, unsigned int wait_for);
+    // settles the slots of a read_files call whose submission failed, before teardown
+    void abandon_slots(std::vector<UringSlot>& slots);
+
+    int _ring_fd;
+    unsigned int _depth;
+    void* _sq_ring;
+    size_t _sq_ring_size;
+    void* _cq_ring;
+    size_t _cq_ring_size;
+    io_uring_sqe* _sqes;
+    size_t _sqes_size;
+    unsigned int* _sq_head;
+    unsigned int* _sq_tail;
+    unsigned int* _sq_mask;
+    unsigned int* _sq_array;
+    unsigned int* _cq_head;
+    unsigned int* _cq_tail;
+    unsigned int* _cq_mask;
+    io_uring_cqe* _cqes;
+    /// Files still open under reads the kernel may finish after a failed submission, closed by teardown
+    std::vector<int> _abandoned_fds;
+    /// Buffers of those reads, freed by teardown once the ring is closed
+    std::vector<std::vector<unsigned char>> _abandoned_buffers;
+};
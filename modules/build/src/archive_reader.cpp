@@ -5,6 +5,9 @@
 
 #include "archive_reader.hpp"
 #include "checksums.hpp"
+#include "package_index.hpp"
+#include "frame_index.hpp"
+#include "remote_package.hpp"
 #include <vector>
 #include <map>
 #include <archive.h>
@@ -13,10 +16,227 @@
 #include <cstring>
 #include <cstdlib>
 #include <fcntl.h>
+#include <cerrno>
+#include <sys/stat.h>
 
+/**
+ * Returns the portion of an archive entry path after its leading directory
+ *
+ * Archives produced by compress_directory prefix every entry with the name of
+ * the directory that was compressed (e.g. "contents/usr/bin/foo").  This mirrors
+ * the prefix stripping done by uncompress_archive.
+ *
+ * @param entry_path Path of the entry as stored in the archive
+ * @return Pointer into entry_path past the first '/', or an empty string if there is none
+ */
+const char* strip_archive_parent(const char* entry_path)
+{
+    const char* first_slash = strchr(entry_path, '/');
+    if (!first_slash) {
+        return "";
+    }
+
+    return first_slash + 1;
+}
+
+bool package_readahead_enabled()
+{
+    const char* configured = dpm_get_config("build", "package_readahead");
+    if (configured) {
+        std::string value = configured;
+        if (value == "0" || value == "false" || value == "no" || value == "off") {
+            return false;
+        }
+    }
+    return true;
+}
+
+int package_file_open(const char* package_path)
+{
+    int fd = open(package_path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    return fd;
+}
+
+void package_file_readahead(int fd, uint64_t offset, uint64_t length)
+{
+    if (fd >= 0 && package_readahead_enabled()) {
+        posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+    }
+}
+
+void package_memory_readahead(const unsigned char* data, size_t size)
+{
+    if (!data || size == 0 || !package_readahead_enabled()) {
+        return;
+    }
+
+    // madvise wants a page aligned start
+    uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+    madvise(reinterpret_cast<void*>(start), reinterpret_cast<uintptr_t>(data) + size - start, MADV_WILLNEED);
+}
+
+/**
+ * Checks whether an archive entry refers to the requested file
+ *
+ * Matches either the full entry path or the entry path with its leading
+ * component directory removed, so callers can ask for "metadata" or
+ * "CONTENTS_MANIFEST_DIGEST" without knowing the name of the parent directory.
+ *
+ * @param entry_path Path of the entry as stored in the archive
+ * @param file_path_in_archive Path the caller is looking for
+ * @return true if the entry matches
+ */
+static bool archive_entry_matches(const char* entry_path, const char* file_path_in_archive)
+{
+    if (strcmp(entry_path, file_path_in_archive) == 0) {
+        return true;
+    }
+
+    return strcmp(strip_archive_parent(entry_path), file_path_in_archive) == 0;
+}
+
+/**
+ * Allocator used when the caller takes ownership of each buffer and frees it
+ */
+static unsigned char* archive_entry_malloc(size_t size, void* allocator_data)
+{
+    (void)allocator_data;
+
+    // malloc(0) may return NULL, so an empty entry still gets a byte
+    return static_cast<unsigned char*>(malloc(size > 0 ? size : 1));
+}
+
+/**
+ * Reads a component of a package through the package index
+ *
+ * @param package_file_path Path to the package file (.dpm)
+ * @param component Component to read, with or without the stage directory prefix
+ * @param data Pointer to buffer pointer - will be allocated by function
+ * @param data_size Pointer to size variable that will receive file size
+ * @return true if the package has an index listing the component and it was read, false otherwise
+ */
+static bool get_file_from_package_index(const char* package_file_path, const char* component,
+                                        unsigned char** data, size_t* data_size)
+{
+    int fd = package_file_open(package_file_path);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    std::vector<unsigned char> prefix(PACKAGE_INDEX_SEARCH_SIZE);
+    ssize_t prefix_size = fstat(fd, &st) == 0 ? pread(fd, prefix.data(), prefix.size(), 0) : -1;
+
+    std::vector<PackageIndexEntry> index;
+    const PackageIndexEntry* indexed = nullptr;
+    if (prefix_size > 0 && package_index_find(prefix.data(), static_cast<size_t>(prefix_size),
+                                              static_cast<uint64_t>(st.st_size), index)) {
+        indexed = package_index_lookup(index, component);
+    }
+    if (!indexed) {
+        close(fd);
+        return false;
+    }
+
+    package_file_readahead(fd, indexed->offset, indexed->size);
+
+    // malloc(0) may return NULL, so an empty member still gets a byte
+    unsigned char* buffer = (unsigned char*)malloc(indexed->size > 0 ? indexed->size : 1);
+    size_t done = 0;
+    while (buffer && done < indexed->size) {
+        ssize_t got = pread(fd, buffer + done, indexed->size - done, static_cast<off_t>(indexed->offset + done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        done += static_cast<size_t>(got);
+    }
+    close(fd);
+
+    if (!buffer || done != indexed->size) {
+        dpm_log(LOG_WARN, ("Failed to read " + indexed->component + " through the package index, scanning the package instead").c_str());
+        free(buffer);
+        return false;
+    }
+
+    DPM_LOG(LOG_DEBUG, "Read ", indexed->component, " through the package index");
+    *data = buffer;
+    *data_size = indexed->size;
+    return true;
+}
+
+/**
+ * Fetches one member of a package served over HTTP or HTTPS
+ *
+ * Only the start of the package and the member's own byte range are
+ * transferred when the package has an index; an older package without
+ * one is downloaded whole and the member is read out of it.
+ *
+ * @param package_url URL of the package
+ * @param component Member to fetch, with or without the stage directory prefix
+ * @param member Receives the member data
+ * @return true on success, false on failure
+ */
+static bool fetch_remote_package_member(const char* package_url, const char* component,
+                                        std::vector<unsigned char>& member)
+{
+    RemotePackage remote(package_url);
+    if (!remote.valid()) {
+        return false;
+    }
+
+    std::vector<unsigned char> package;
+    if (!remote.fetch(0, PACKAGE_INDEX_SEARCH_SIZE, package) || package.empty()) {
+        dpm_log(LOG_ERROR, ("Failed to fetch package: " + std::string(package_url)).c_str());
+        return false;
+    }
+
+    std::vector<PackageIndexEntry> index;
+    if (remote.size() > 0 && package_index_find(package.data(), package.size(), remote.size(), index)) {
+        const PackageIndexEntry* indexed = package_index_lookup(index, component);
+        if (!indexed) {
+            dpm_log(LOG_ERROR, ("Component not found in package: " + std::string(component)).c_str());
+            return false;
+        }
+        if (!remote.fetch(indexed->offset, indexed->size, member) || member.size() != indexed->size) {
+            dpm_log(LOG_ERROR, ("Failed to fetch " + indexed->component + " from package: " +
+                              std::string(package_url)).c_str());
+            return false;
+        }
+        DPM_LOG(LOG_DEBUG, "Fetched ", indexed->component, " (", indexed->size, " bytes) through the package index");
+        return true;
+    }
+
+    dpm_log(LOG_INFO, ("Package has no index, downloading all of it: " + std::string(package_url)).c_str());
+    if (remote.size() == 0 || package.size() < remote.size()) {
+        std::vector<unsigned char> rest;
+        if (!remote.fetch(package.size(), 0, rest)) {
+            dpm_log(LOG_ERROR, ("Failed to fetch package: " + std::string(package_url)).c_str());
+            return false;
+        }
+        package.insert(package.end(), rest.begin(), rest.end());
+    }
+
+    unsigned char* data = NULL;
+    size_t data_size = 0;
+    if (!get_file_from_memory_loaded_archive(package.data(), package.size(), component, &data, &data_size)) {
+        return false;
+    }
+    member.assign(data, data + data_size);
+    free(data);
+    return true;
+}
 
 /**
- * Extracts a specific file from a package file (gzipped tarball)
+ * Extracts a specific file from a package file (compressed tarball)
+ *
+ * A package named by an http:// or https:// URL is fetched by byte range.
  *
  * @param package_file_path Path to the package file (.dpm)
  * @param file_path_in_archive Path of the file to extract within the archive
@@ -35,6 +255,28 @@ extern "C" bool get_file_from_package_file(const char* package_file_path, const
     *data = NULL;
     *data_size = 0;
 
+    if (remote_package_is_url(package_file_path)) {
+        std::vector<unsigned char> member;
+        if (!fetch_remote_package_member(package_file_path, file_path_in_archive, member)) {
+            return false;
+        }
+
+        // malloc(0) may return NULL, so an empty member still gets a byte
+        *data = (unsigned char*)malloc(member.empty() ? 1 : member.size());
+        if (!*data) {
+            dpm_log(LOG_ERROR, "Failed to allocate memory for file contents");
+            return false;
+        }
+        memcpy(*data, member.data(), member.size());
+        *data_size = member.size();
+        return true;
+    }
+
+    // A component listed in the package index is read straight from its offset
+    if (get_file_from_package_index(package_file_path, file_path_in_archive, data, data_size)) {
+        return true;
+    }
+
     // Create a new archive for reading
     struct archive* a = archive_read_new();
     if (!a) {
@@ -42,16 +284,26 @@ extern "C" bool get_file_from_package_file(const char* package_file_path, const
         return false;
     }
 
-    // Enable support for gzipped tarballs
-    archive_read_support_filter_gzip(a);
+    // Enable support for tarballs in every component codec
+    compression_read_support(a);
     archive_read_support_format_tar(a);
 
-    // Open the package file - using 0 for block size lets libarchive choose the optimal size
-    int r = archive_read_open_filename(a, package_file_path, 0);
+    // Without an index the package is scanned from the start, so all of it is read ahead in large blocks
+    int fd = package_file_open(package_file_path);
+    if (fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to open package file: " + std::string(package_file_path) +
+                           " - " + strerror(errno)).c_str());
+        archive_read_free(a);
+        return false;
+    }
+    package_file_readahead(fd, 0, 0);
+
+    int r = archive_read_open_fd(a, fd, PACKAGE_READ_BLOCK_SIZE);
     if (r != ARCHIVE_OK) {
         dpm_log(LOG_ERROR, ("Failed to open package file: " + std::string(package_file_path) +
                            " - " + std::string(archive_error_string(a))).c_str());
         archive_read_free(a);
+        close(fd);
         return false;
     }
 
@@ -62,7 +314,7 @@ extern "C" bool get_file_from_package_file(const char* package_file_path, const
         const char* current_path = archive_entry_pathname(entry);
 
         // Check if this is the file we're looking for
-        if (strcmp(current_path, file_path_in_archive) == 0) {
+        if (archive_entry_matches(current_path, file_path_in_archive)) {
             // Get the file size
             size_t file_size = archive_entry_size(entry);
             *data_size = file_size;
@@ -72,6 +324,7 @@ extern "C" bool get_file_from_package_file(const char* package_file_path, const
             if (!*data) {
                 dpm_log(LOG_ERROR, "Failed to allocate memory for file contents");
                 archive_read_free(a);
+                close(fd);
                 return false;
             }
 
@@ -84,6 +337,7 @@ extern "C" bool get_file_from_package_file(const char* package_file_path, const
                 *data = NULL;
                 *data_size = 0;
                 archive_read_free(a);
+                close(fd);
                 return false;
             }
 
@@ -97,6 +351,7 @@ extern "C" bool get_file_from_package_file(const char* package_file_path, const
 
     // Clean up
     archive_read_free(a);
+    close(fd);
 
     if (!found) {
         dpm_log(LOG_ERROR, ("File not found in package: " +
@@ -108,28 +363,24 @@ extern "C" bool get_file_from_package_file(const char* package_file_path, const
 }
 
 /**
- * Extracts a specific file from an in-memory archive (gzipped tarball)
+ * Reads the first entry matching a path out of an in-memory archive
  *
- * @param archive_data Pointer to the archive data in memory
+ * @param archive_data Pointer to the archive data in memory, which may start at a seekable frame
  * @param archive_data_size Size of the archive data in memory
  * @param file_path_in_archive Path of the file to extract within the archive
- * @param result_data Pointer to buffer pointer - will be allocated by function
+ * @param allocator Allocator the file is extracted into
+ * @param allocator_data Context pointer passed through to the allocator
+ * @param result_data Pointer to buffer pointer - will be set to the allocated buffer
  * @param result_data_size Pointer to size variable that will receive file size
- * @return true on success, false on failure
+ * @param found Set to whether the entry was found
+ * @return true if the archive was read without errors, false otherwise
  */
-extern "C" bool get_file_from_memory_loaded_archive(const unsigned char* archive_data, const size_t archive_data_size,
-                                         const char* file_path_in_archive,
-                                         unsigned char** result_data, size_t* result_data_size)
+static bool read_memory_archive_entry(const unsigned char* archive_data, size_t archive_data_size,
+                                      const char* file_path_in_archive,
+                                      archive_entry_allocator allocator, void* allocator_data,
+                                      unsigned char** result_data, size_t* result_data_size, bool& found)
 {
-    if (!archive_data || archive_data_size == 0 || !file_path_in_archive ||
-        !result_data || !result_data_size) {
-        dpm_log(LOG_ERROR, "Invalid parameters passed to get_file_from_memory_loaded_archive");
-        return false;
-    }
-
-    // Initialize output parameters
-    *result_data = NULL;
-    *result_data_size = 0;
+    found = false;
 
     // Create a new archive for reading
     struct archive* a = archive_read_new();
@@ -138,8 +389,8 @@ extern "C" bool get_file_from_memory_loaded_archive(const unsigned char* archive
         return false;
     }
 
-    // Enable support for gzipped tarballs
-    archive_read_support_filter_gzip(a);
+    // Enable support for tarballs in every component codec
+    compression_read_support(a);
     archive_read_support_format_tar(a);
 
     // Open the archive from memory
@@ -152,19 +403,19 @@ extern "C" bool get_file_from_memory_loaded_archive(const unsigned char* archive
     }
 
     // Iterate through archive entries
-    bool found = false;
     struct archive_entry* entry;
     while (archive_read_next_header(a, &entry) == ARCHIVE_OK) {
         const char* current_path = archive_entry_pathname(entry);
+        dpm_metric_add(DPM_METRIC_ARCHIVE_ENTRIES, 1);
 
         // Check if this is the file we're looking for
-        if (strcmp(current_path, file_path_in_archive) == 0) {
+        if (archive_entry_matches(current_path, file_path_in_archive)) {
             // Get the file size
             size_t file_size = archive_entry_size(entry);
             *result_data_size = file_size;
 
             // Allocate buffer of appropriate size
-            *result_data = (unsigned char*)malloc(file_size);
+            *result_data = allocator(file_size, allocator_data);
             if (!*result_data) {
                 dpm_log(LOG_ERROR, "Failed to allocate memory for file contents");
                 archive_read_free(a);
@@ -173,10 +424,14 @@ extern "C" bool get_file_from_memory_loaded_archive(const unsigned char* archive
 
             // Read the file content into the buffer
             ssize_t bytes_read = archive_read_data(a, *result_data, file_size);
+            dpm_metric_add(DPM_METRIC_BYTES_DECOMPRESSED, bytes_read > 0 ? static_cast<uint64_t>(bytes_read) : 0);
             if (bytes_read < 0 || (size_t)bytes_read != file_size) {
                 dpm_log(LOG_ERROR, ("Failed to read file data from memory archive: " +
                                   std::string(archive_error_string(a))).c_str());
-                free(*result_data);
+                // a caller's allocator keeps its buffers until it is released
+                if (allocator == archive_entry_malloc) {
+                    free(*result_data);
+                }
                 *result_data = NULL;
                 *result_data_size = 0;
                 archive_read_free(a);
@@ -193,6 +448,78 @@ extern "C" bool get_file_from_memory_loaded_archive(const unsigned char* archive
 
     // Clean up
     archive_read_free(a);
+    return true;
+}
+
+/**
+ * Extracts a specific file from an in-memory archive (compressed tarball)
+ *
+ * A seekable gzip archive is read from the frame holding the file, so only
+ * that part of it is decompressed.
+ *
+ * @param archive_data Pointer to the archive data in memory
+ * @param archive_data_size Size of the archive data in memory
+ * @param file_path_in_archive Path of the file to extract within the archive
+ * @param result_data Pointer to buffer pointer - will be allocated by function
+ * @param result_data_size Pointer to size variable that will receive file size
+ * @return true on success, false on failure
+ */
+extern "C" bool get_file_from_memory_loaded_archive(const unsigned char* archive_data, const size_t archive_data_size,
+                                         const char* file_path_in_archive,
+                                         unsigned char** result_data, size_t* result_data_size)
+{
+    return get_file_from_memory_loaded_archive_into(archive_data, archive_data_size, file_path_in_archive,
+                                                    archive_entry_malloc, NULL, result_data, result_data_size);
+}
+
+/**
+ * Extracts a specific file from an in-memory archive into a buffer from the caller's allocator
+ *
+ * @param archive_data Pointer to the archive data in memory
+ * @param archive_data_size Size of the archive data in memory
+ * @param file_path_in_archive Path of the file to extract within the archive
+ * @param allocator Allocator the file is extracted into, which owns the result
+ * @param allocator_data Context pointer passed through to the allocator
+ * @param result_data Pointer to buffer pointer - will be set to the allocated buffer
+ * @param result_data_size Pointer to size variable that will receive file size
+ * @return true on success, false on failure
+ */
+extern "C" bool get_file_from_memory_loaded_archive_into(const unsigned char* archive_data, const size_t archive_data_size,
+                                                         const char* file_path_in_archive,
+                                                         archive_entry_allocator allocator, void* allocator_data,
+                                                         unsigned char** result_data, size_t* result_data_size)
+{
+    if (!archive_data || archive_data_size == 0 || !file_path_in_archive || !allocator ||
+        !result_data || !result_data_size) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to get_file_from_memory_loaded_archive_into");
+        return false;
+    }
+
+    // Initialize output parameters
+    *result_data = NULL;
+    *result_data_size = 0;
+
+    bool found = false;
+    FrameIndex frames;
+    const FrameIndexFrame* frame = nullptr;
+    if (frame_index_find(archive_data, archive_data_size, frames)) {
+        frame = frame_index_lookup(frames, file_path_in_archive);
+    }
+    if (frame) {
+        size_t offset = static_cast<size_t>(frame->compressed_offset);
+        if (read_memory_archive_entry(archive_data + offset, archive_data_size - offset, file_path_in_archive,
+                                      allocator, allocator_data, result_data, result_data_size, found) && found) {
+            DPM_LOG(LOG_DEBUG, "Read ", file_path_in_archive, " from the seekable frame at offset ", offset);
+            return true;
+        }
+        dpm_log(LOG_WARN, ("Failed to read " + std::string(file_path_in_archive) +
+                          " from its seekable frame, scanning the archive instead").c_str());
+    }
+
+    if (!read_memory_archive_entry(archive_data, archive_data_size, file_path_in_archive,
+                                   allocator, allocator_data, result_data, result_data_size, found)) {
+        return false;
+    }
 
     if (!found) {
         dpm_log(LOG_ERROR, ("File not found in memory archive: " +
@@ -203,3 +530,1012 @@ extern "C" bool get_file_from_memory_loaded_archive(const unsigned char* archive
     return true;
 }
 
+/**
+ * Walks an opened archive once, hashing each entry as it is read
+ *
+ * Shared by the in-memory and streaming entry points; the caller owns the
+ * archive and is responsible for freeing it.  Entries are hashed with the
+ * configured algorithm and reported to callback, or, when digests is given,
+ * with each of its algorithms and reported to multi_callback.
+ *
+ * @param a Archive opened for reading
+ * @param digests Digests to compute for each entry, or NULL for the configured algorithm only
+ * @param callback Function invoked once per visited entry when digests is NULL
+ * @param multi_callback Function invoked once per visited entry when digests is given
+ * @param user_data Context pointer passed through to the callback
+ * @return true if the whole archive was walked, false on read errors or if the callback stopped the walk
+ */
+static bool checksum_archive_entries(struct archive* a, MultiChecksum* digests,
+                                     archive_entry_checksum_callback callback,
+                                     archive_entry_checksums_callback multi_callback, void* user_data)
+{
+    // The engine resolves the algorithm once and reuses this thread's digest context
+    ChecksumEngine& engine = ChecksumEngine::instance();
+    if (digests ? !digests->valid() : !engine.valid()) {
+        return false;
+    }
+
+    std::vector<std::string> hex_digests;
+    std::vector<const char*> hex_pointers;
+
+    bool success = true;
+    struct archive_entry* entry;
+    while (success) {
+        int r = archive_read_next_header(a, &entry);
+        if (r == ARCHIVE_EOF) {
+            break;
+        }
+        if (r != ARCHIVE_OK) {
+            dpm_log(LOG_ERROR, ("Archive read error: " + std::string(archive_error_string(a))).c_str());
+            success = false;
+            break;
+        }
+        dpm_metric_add(DPM_METRIC_ARCHIVE_ENTRIES, 1);
+
+        // Directories carry no content to verify
+        if (archive_entry_filetype(entry) == AE_IFDIR) {
+            archive_read_data_skip(a);
+            continue;
+        }
+
+        const char* entry_path = strip_archive_parent(archive_entry_pathname(entry));
+        if (entry_path[0] == '\0') {
+            archive_read_data_skip(a);
+            continue;
+        }
+
+        // Only regular files have content that can be hashed
+        if (archive_entry_filetype(entry) != AE_IFREG) {
+            archive_read_data_skip(a);
+            int stop = digests ? multi_callback(entry_path, NULL, 0, user_data) : callback(entry_path, NULL, user_data);
+            if (stop != 0) {
+                success = false;
+            }
+            continue;
+        }
+
+        if (digests ? !digests->begin() : !engine.begin()) {
+            success = false;
+            break;
+        }
+
+        // Feed each decompressed block straight into the digest
+        const void* block;
+        size_t block_size;
+        la_int64_t offset;
+        while (true) {
+            r = archive_read_data_block(a, &block, &block_size, &offset);
+            if (r == ARCHIVE_EOF) {
+                break;
+            }
+            if (r != ARCHIVE_OK) {
+                dpm_log(LOG_ERROR, ("Archive read data error: " + std::string(archive_error_string(a))).c_str());
+                success = false;
+                break;
+            }
+            dpm_metric_add(DPM_METRIC_BYTES_DECOMPRESSED, block_size);
+
+            if (digests ? !digests->update(block, block_size) : !engine.update(block, block_size)) {
+                success = false;
+                break;
+            }
+        }
+
+        if (!success) {
+            break;
+        }
+
+        if (digests) {
+            if (!digests->finish(hex_digests)) {
+                success = false;
+                break;
+            }
+
+            hex_pointers.clear();
+            for (const auto& hex_digest : hex_digests) {
+                hex_pointers.push_back(hex_digest.c_str());
+            }
+
+            if (multi_callback(entry_path, hex_pointers.data(), hex_pointers.size(), user_data) != 0) {
+                success = false;
+            }
+            continue;
+        }
+
+        unsigned char hash[CHECKSUM_MAX_DIGEST_SIZE];
+        size_t hash_len = 0;
+        if (!engine.finish(hash, &hash_len)) {
+            success = false;
+            break;
+        }
+
+        // Convert binary hash to hexadecimal string
+        char hex[CHECKSUM_MAX_DIGEST_SIZE * 2 + 1];
+        ChecksumEngine::to_hex(hash, hash_len, hex);
+
+        if (callback(entry_path, hex, user_data) != 0) {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+/**
+ * Walks an opened archive once, handing each entry's data to a callback
+ *
+ * Shared by the in-memory and streaming entry points; the caller owns the
+ * archive and is responsible for freeing it.
+ *
+ * @param a Archive opened for reading
+ * @param max_entry_size Largest entry that will be buffered, or 0 for no limit
+ * @param callback Function invoked once per visited entry with a reused buffer, or NULL
+ * @param buffer_callback Function handed a buffer of its own per entry, used when callback is NULL
+ * @param allocator Allocator the buffers handed to buffer_callback come from
+ * @param allocator_data Context pointer passed through to the allocator
+ * @param user_data Context pointer passed through to the callback
+ * @return true if the whole archive was walked, false on read errors or if the callback stopped the walk
+ */
+static bool read_archive_entries(struct archive* a, size_t max_entry_size,
+                                 archive_entry_data_callback callback,
+                                 archive_entry_buffer_callback buffer_callback,
+                                 archive_entry_allocator allocator, void* allocator_data, void* user_data)
+{
+    // Reused for every entry so large archives don't churn the allocator
+    std::vector<unsigned char> buffer;
+
+    bool success = true;
+    struct archive_entry* entry;
+    while (success) {
+        int r = archive_read_next_header(a, &entry);
+        if (r == ARCHIVE_EOF) {
+            break;
+        }
+        if (r != ARCHIVE_OK) {
+            dpm_log(LOG_ERROR, ("Archive read error: " + std::string(archive_error_string(a))).c_str());
+            success = false;
+            break;
+        }
+        dpm_metric_add(DPM_METRIC_ARCHIVE_ENTRIES, 1);
+
+        // Directories carry no content to verify
+        if (archive_entry_filetype(entry) == AE_IFDIR) {
+            archive_read_data_skip(a);
+            continue;
+        }
+
+        const char* entry_path = strip_archive_parent(archive_entry_pathname(entry));
+        if (entry_path[0] == '\0') {
+            archive_read_data_skip(a);
+            continue;
+        }
+
+        // Only regular files have content
+        if (archive_entry_filetype(entry) != AE_IFREG) {
+            archive_read_data_skip(a);
+            int stop = callback ? callback(entry_path, NULL, 0, user_data)
+                                : buffer_callback(entry_path, NULL, 0, user_data);
+            if (stop != 0) {
+                success = false;
+            }
+            continue;
+        }
+
+        size_t file_size = archive_entry_size(entry);
+        if (max_entry_size > 0 && file_size > max_entry_size) {
+            dpm_log(LOG_ERROR, ("Archive entry " + std::string(entry_path) + " is " + std::to_string(file_size) +
+                              " bytes, larger than the " + std::to_string(max_entry_size) + " byte limit").c_str());
+            success = false;
+            break;
+        }
+
+        // The callback keeps an owned buffer, so it is decompressed into directly
+        unsigned char* data = nullptr;
+        if (callback) {
+            buffer.resize(file_size);
+            data = buffer.data();
+        } else {
+            data = allocator(file_size, allocator_data);
+            if (!data) {
+                dpm_log(LOG_ERROR, ("Failed to allocate " + std::to_string(file_size) + " bytes for " +
+                                  std::string(entry_path)).c_str());
+                success = false;
+                break;
+            }
+        }
+
+        if (file_size > 0) {
+            ssize_t bytes_read = archive_read_data(a, data, file_size);
+            dpm_metric_add(DPM_METRIC_BYTES_DECOMPRESSED, bytes_read > 0 ? static_cast<uint64_t>(bytes_read) : 0);
+            if (bytes_read < 0 || (size_t)bytes_read != file_size) {
+                dpm_log(LOG_ERROR, ("Failed to read file data from archive: " +
+                                  std::string(archive_error_string(a))).c_str());
+                if (!callback && allocator == archive_entry_malloc) {
+                    free(data);
+                }
+                success = false;
+                break;
+            }
+        }
+
+        int stop = callback ? callback(entry_path, data, file_size, user_data)
+                            : buffer_callback(entry_path, data, file_size, user_data);
+        if (stop != 0) {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+/**
+ * Walks an in-memory archive (compressed tarball) once, hashing each entry as it is read
+ *
+ * @param archive_data Pointer to the archive data in memory
+ * @param archive_data_size Size of the archive data in memory
+ * @param callback Function invoked once per visited entry
+ * @param user_data Context pointer passed through to the callback
+ * @return true if the whole archive was walked, false on read errors or if the callback stopped the walk
+ */
+extern "C" bool checksum_memory_loaded_archive_entries(const unsigned char* archive_data, const size_t archive_data_size,
+                                                       archive_entry_checksum_callback callback, void* user_data)
+{
+    if (!archive_data || archive_data_size == 0 || !callback) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to checksum_memory_loaded_archive_entries");
+        return false;
+    }
+
+    // Create a new archive for reading
+    struct archive* a = archive_read_new();
+    if (!a) {
+        dpm_log(LOG_ERROR, "Failed to create archive object");
+        return false;
+    }
+
+    // Enable support for tarballs in every component codec
+    compression_read_support(a);
+    archive_read_support_format_tar(a);
+
+    // Open the archive from memory
+    int r = archive_read_open_memory(a, (void*)archive_data, archive_data_size);
+    if (r != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Failed to open archive from memory: " +
+                          std::string(archive_error_string(a))).c_str());
+        archive_read_free(a);
+        return false;
+    }
+
+    bool success = checksum_archive_entries(a, nullptr, callback, nullptr, user_data);
+
+    // Clean up
+    archive_read_free(a);
+
+    return success;
+}
+
+/**
+ * Walks an in-memory archive (compressed tarball) once, hashing each entry with several algorithms
+ *
+ * @param archive_data Pointer to the archive data in memory
+ * @param archive_data_size Size of the archive data in memory
+ * @param algorithms Names of the algorithms to hash with
+ * @param callback Function invoked once per visited entry
+ * @param user_data Context pointer passed through to the callback
+ * @return true if the whole archive was walked, false on read errors or if the callback stopped the walk
+ */
+extern "C" bool checksum_memory_loaded_archive_entries_multi(const unsigned char* archive_data, const size_t archive_data_size,
+                                                             const std::vector<std::string>& algorithms,
+                                                             archive_entry_checksums_callback callback, void* user_data)
+{
+    if (!archive_data || archive_data_size == 0 || !callback) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to checksum_memory_loaded_archive_entries_multi");
+        return false;
+    }
+
+    MultiChecksum digests(algorithms);
+    if (!digests.valid()) {
+        return false;
+    }
+
+    struct archive* a = archive_read_new();
+    if (!a) {
+        dpm_log(LOG_ERROR, "Failed to create archive object");
+        return false;
+    }
+
+    compression_read_support(a);
+    archive_read_support_format_tar(a);
+
+    int r = archive_read_open_memory(a, (void*)archive_data, archive_data_size);
+    if (r != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Failed to open archive from memory: " +
+                          std::string(archive_error_string(a))).c_str());
+        archive_read_free(a);
+        return false;
+    }
+
+    bool success = checksum_archive_entries(a, &digests, nullptr, callback, user_data);
+
+    archive_read_free(a);
+
+    return success;
+}
+
+/**
+ * Walks an in-memory archive (compressed tarball) once, handing each entry's data to a callback
+ *
+ * @param archive_data Pointer to the archive data in memory
+ * @param archive_data_size Size of the archive data in memory
+ * @param callback Function invoked once per visited entry
+ * @param user_data Context pointer passed through to the callback
+ * @return true if the whole archive was walked, false on read errors or if the callback stopped the walk
+ */
+extern "C" bool read_memory_loaded_archive_entries(const unsigned char* archive_data, const size_t archive_data_size,
+                                                   archive_entry_data_callback callback, void* user_data)
+{
+    if (!archive_data || archive_data_size == 0 || !callback) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to read_memory_loaded_archive_entries");
+        return false;
+    }
+
+    // Create a new archive for reading
+    struct archive* a = archive_read_new();
+    if (!a) {
+        dpm_log(LOG_ERROR, "Failed to create archive object");
+        return false;
+    }
+
+    // Enable support for tarballs in every component codec
+    compression_read_support(a);
+    archive_read_support_format_tar(a);
+
+    // Open the archive from memory
+    int r = archive_read_open_memory(a, (void*)archive_data, archive_data_size);
+    if (r != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Failed to open archive from memory: " +
+                          std::string(archive_error_string(a))).c_str());
+        archive_read_free(a);
+        return false;
+    }
+
+    bool success = read_archive_entries(a, 0, callback, nullptr, nullptr, nullptr, user_data);
+
+    // Clean up
+    archive_read_free(a);
+
+    return success;
+}
+
+/**
+ * Walks an in-memory archive (compressed tarball) once, handing over each entry's data to a callback
+ *
+ * @param archive_data Pointer to the archive data in memory
+ * @param archive_data_size Size of the archive data in memory
+ * @param callback Function invoked once per visited entry, owning the data it is given
+ * @param user_data Context pointer passed through to the callback
+ * @return true if the whole archive was walked, false on read errors or if the callback stopped the walk
+ */
+extern "C" bool take_memory_loaded_archive_entries(const unsigned char* archive_data, const size_t archive_data_size,
+                                                   archive_entry_buffer_callback callback, void* user_data)
+{
+    return take_memory_loaded_archive_entries_into(archive_data, archive_data_size, archive_entry_malloc, NULL,
+                                                   callback, user_data);
+}
+
+/**
+ * Walks an in-memory archive (compressed tarball) once, decompressing each entry into a buffer from an allocator
+ *
+ * @param archive_data Pointer to the archive data in memory
+ * @param archive_data_size Size of the archive data in memory
+ * @param allocator Allocator each regular file is decompressed into
+ * @param allocator_data Context pointer passed through to the allocator
+ * @param callback Function invoked once per visited entry
+ * @param user_data Context pointer passed through to the callback
+ * @return true if the whole archive was walked, false on read errors, failed allocations, or if the callback stopped the walk
+ */
+extern "C" bool take_memory_loaded_archive_entries_into(const unsigned char* archive_data, const size_t archive_data_size,
+                                                        archive_entry_allocator allocator, void* allocator_data,
+                                                        archive_entry_buffer_callback callback, void* user_data)
+{
+    if (!archive_data || archive_data_size == 0 || !allocator || !callback) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to take_memory_loaded_archive_entries_into");
+        return false;
+    }
+
+    struct archive* a = archive_read_new();
+    if (!a) {
+        dpm_log(LOG_ERROR, "Failed to create archive object");
+        return false;
+    }
+
+    compression_read_support(a);
+    archive_read_support_format_tar(a);
+
+    int r = archive_read_open_memory(a, (void*)archive_data, archive_data_size);
+    if (r != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Failed to open archive from memory: " +
+                          std::string(archive_error_string(a))).c_str());
+        archive_read_free(a);
+        return false;
+    }
+
+    bool success = read_archive_entries(a, 0, nullptr, callback, allocator, allocator_data, user_data);
+
+    archive_read_free(a);
+
+    return success;
+}
+
+/**
+ * State for reading a component archive straight out of the package archive
+ */
+struct PackageComponentStream {
+    struct archive* package = NULL;     ///< Outer package archive positioned at the component, NULL when read by offset
+    int fd = -1;                        ///< Descriptor of the package file
+    uint64_t offset = 0;                ///< Offset of the next byte of an indexed component
+    uint64_t remaining = 0;             ///< Bytes of an indexed component not read yet
+    std::vector<unsigned char> buffer;  ///< Transfer buffer between the package file and the component archive
+    std::vector<unsigned char> remote;  ///< Component fetched from a remote package, read from memory
+};
+
+/**
+ * libarchive read callback feeding the component archive from the package archive
+ *
+ * An indexed component is read by offset straight from the package file,
+ * any other out of the outer package archive.
+ */
+static la_ssize_t package_component_stream_read(struct archive* a, void* client_data, const void** buffer)
+{
+    PackageComponentStream* stream = static_cast<PackageComponentStream*>(client_data);
+
+    if (!stream->package) {
+        size_t wanted = static_cast<size_t>(std::min<uint64_t>(stream->remaining, stream->buffer.size()));
+        ssize_t got;
+        do {
+            got = wanted > 0 ? pread(stream->fd, stream->buffer.data(), wanted, static_cast<off_t>(stream->offset)) : 0;
+        } while (got < 0 && errno == EINTR);
+        if (got < 0 || (got == 0 && wanted > 0)) {
+            int error = got < 0 ? errno : EIO;
+            archive_set_error(a, error, "Failed to read component from package: %s",
+                              got < 0 ? strerror(error) : "unexpected end of file");
+            return -1;
+        }
+
+        stream->offset += static_cast<uint64_t>(got);
+        stream->remaining -= static_cast<uint64_t>(got);
+        *buffer = stream->buffer.data();
+        return got;
+    }
+
+    la_ssize_t bytes_read = archive_read_data(stream->package, stream->buffer.data(), stream->buffer.size());
+    if (bytes_read < 0) {
+        int error = archive_errno(stream->package);
+        archive_set_error(a, error > 0 ? error : EIO, "Failed to read component from package: %s",
+                          archive_error_string(stream->package));
+        return -1;
+    }
+
+    *buffer = stream->buffer.data();
+    return bytes_read;
+}
+
+/**
+ * Releases a component archive together with the package stream it reads from
+ *
+ * @param component Component archive, may be NULL
+ * @param stream Stream state of the component
+ */
+static void close_package_component_stream(struct archive* component, PackageComponentStream* stream)
+{
+    if (component) {
+        archive_read_free(component);
+    }
+    if (stream->package) {
+        archive_read_free(stream->package);
+        stream->package = NULL;
+    }
+    if (stream->fd >= 0) {
+        close(stream->fd);
+        stream->fd = -1;
+    }
+}
+
+/**
+ * Positions a package stream at a component through the package index
+ *
+ * @param stream Stream state with the package file open
+ * @param component_name Name of the component member, e.g. "contents"
+ * @return true if the package has an index listing the component, false otherwise
+ */
+static bool seek_package_component_index(PackageComponentStream* stream, const char* component_name)
+{
+    struct stat st;
+    if (fstat(stream->fd, &st) != 0) {
+        return false;
+    }
+
+    ssize_t prefix_size = pread(stream->fd, stream->buffer.data(),
+                                std::min<size_t>(stream->buffer.size(), PACKAGE_INDEX_SEARCH_SIZE), 0);
+
+    std::vector<PackageIndexEntry> index;
+    if (prefix_size <= 0 || !package_index_find(stream->buffer.data(), static_cast<size_t>(prefix_size),
+                                                static_cast<uint64_t>(st.st_size), index)) {
+        return false;
+    }
+
+    const PackageIndexEntry* indexed = package_index_lookup(index, component_name);
+    if (!indexed) {
+        return false;
+    }
+
+    stream->offset = indexed->offset;
+    stream->remaining = indexed->size;
+    package_file_readahead(stream->fd, indexed->offset, indexed->size);
+    DPM_LOG(LOG_DEBUG, "Streaming ", indexed->component, " through the package index");
+    return true;
+}
+
+/**
+ * Opens a component archive by streaming it out of a package file
+ *
+ * A component listed in the package index is read by offset from the
+ * package file, so the other members are never touched.  Otherwise the
+ * package is read in large blocks until the named component member is
+ * found, then a second archive is opened whose input is that member's data,
+ * so neither the package nor the component is ever held in memory.  Either
+ * way the range about to be read is hinted to the kernel for readahead.
+ * The component of a remote package is fetched into the stream by byte
+ * range and read from there, with no outer package archive.
+ *
+ * @param package_path Path to the package file (.dpm)
+ * @param component_name Name of the component member, e.g. "contents"
+ * @param stream Stream state that lives for as long as the component archive
+ * @return The opened component archive, or NULL on failure (the package stream is closed)
+ */
+static struct archive* open_package_component_stream(const char* package_path, const char* component_name,
+                                                     PackageComponentStream* stream)
+{
+    stream->package = NULL;
+    stream->fd = -1;
+    if (remote_package_is_url(package_path)) {
+        if (!fetch_remote_package_member(package_path, component_name, stream->remote)) {
+            return NULL;
+        }
+
+        struct archive* component = archive_read_new();
+        if (!component) {
+            dpm_log(LOG_ERROR, "Failed to create archive object");
+            return NULL;
+        }
+
+        compression_read_support(component);
+        archive_read_support_format_tar(component);
+
+        if (archive_read_open_memory(component, stream->remote.data(), stream->remote.size()) != ARCHIVE_OK) {
+            dpm_log(LOG_ERROR, ("Failed to open component archive " + std::string(component_name) + ": " +
+                              std::string(archive_error_string(component))).c_str());
+            archive_read_free(component);
+            return NULL;
+        }
+        return component;
+    }
+
+    stream->fd = package_file_open(package_path);
+    if (stream->fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to open package file: " + std::string(package_path) + " - " +
+                          strerror(errno)).c_str());
+        return NULL;
+    }
+    stream->buffer.resize(PACKAGE_READ_BLOCK_SIZE);
+
+    if (!seek_package_component_index(stream, component_name)) {
+        stream->package = archive_read_new();
+        if (!stream->package) {
+            dpm_log(LOG_ERROR, "Failed to create archive object");
+            close_package_component_stream(NULL, stream);
+            return NULL;
+        }
+
+        // Current packages are plain tar; older ones are gzipped
+        compression_read_support(stream->package);
+        archive_read_support_format_tar(stream->package);
+
+        // The whole package is scanned, so all of it is read ahead
+        package_file_readahead(stream->fd, 0, 0);
+        if (archive_read_open_fd(stream->package, stream->fd, PACKAGE_READ_BLOCK_SIZE) != ARCHIVE_OK) {
+            dpm_log(LOG_ERROR, ("Failed to open package file: " + std::string(package_path) + " - " +
+                              std::string(archive_error_string(stream->package))).c_str());
+            close_package_component_stream(NULL, stream);
+            return NULL;
+        }
+
+        // Skip forward to the component member
+        bool found = false;
+        struct archive_entry* entry;
+        int r;
+        while ((r = archive_read_next_header(stream->package, &entry)) == ARCHIVE_OK) {
+            if (archive_entry_filetype(entry) == AE_IFREG &&
+                archive_entry_matches(archive_entry_pathname(entry), component_name)) {
+                found = true;
+                break;
+            }
+            archive_read_data_skip(stream->package);
+        }
+
+        if (!found) {
+            if (r != ARCHIVE_EOF) {
+                dpm_log(LOG_ERROR, ("Package read error: " + std::string(archive_error_string(stream->package))).c_str());
+            } else {
+                dpm_log(LOG_ERROR, ("Component not found in package: " + std::string(component_name)).c_str());
+            }
+            close_package_component_stream(NULL, stream);
+            return NULL;
+        }
+    }
+
+    struct archive* component = archive_read_new();
+    if (!component) {
+        dpm_log(LOG_ERROR, "Failed to create archive object");
+        close_package_component_stream(NULL, stream);
+        return NULL;
+    }
+
+    // Components are tarballs in any of the component codecs
+    compression_read_support(component);
+    archive_read_support_format_tar(component);
+
+    if (archive_read_open(component, stream, NULL, package_component_stream_read, NULL) != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Failed to open component archive " + std::string(component_name) + ": " +
+                          std::string(archive_error_string(component))).c_str());
+        close_package_component_stream(component, stream);
+        return NULL;
+    }
+
+    return component;
+}
+
+/**
+ * Streams a component out of a package file, hashing each entry as it is read
+ *
+ * @param package_path Path to the package file (.dpm)
+ * @param component_name Name of the component member, e.g. "contents"
+ * @param callback Function invoked once per visited entry
+ * @param user_data Context pointer passed through to the callback
+ * @return true if the whole component was walked, false on read errors or if the callback stopped the walk
+ */
+extern "C" bool checksum_package_component_entries(const char* package_path, const char* component_name,
+                                                   archive_entry_checksum_callback callback, void* user_data)
+{
+    if (!package_path || !component_name || !callback) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to checksum_package_component_entries");
+        return false;
+    }
+
+    PackageComponentStream stream;
+    struct archive* component = open_package_component_stream(package_path, component_name, &stream);
+    if (!component) {
+        return false;
+    }
+
+    bool success = checksum_archive_entries(component, nullptr, callback, nullptr, user_data);
+
+    // Clean up
+    close_package_component_stream(component, &stream);
+
+    return success;
+}
+
+/**
+ * Streams a component out of a package file, hashing each entry with several algorithms
+ *
+ * @param package_path Path to the package file (.dpm)
+ * @param component_name Name of the component member, e.g. "contents"
+ * @param algorithms Names of the algorithms to hash with
+ * @param callback Function invoked once per visited entry
+ * @param user_data Context pointer passed through to the callback
+ * @return true if the whole component was walked, false on read errors or if the callback stopped the walk
+ */
+extern "C" bool checksum_package_component_entries_multi(const char* package_path, const char* component_name,
+                                                         const std::vector<std::string>& algorithms,
+                                                         archive_entry_checksums_callback callback, void* user_data)
+{
+    if (!package_path || !component_name || !callback) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to checksum_package_component_entries_multi");
+        return false;
+    }
+
+    MultiChecksum digests(algorithms);
+    if (!digests.valid()) {
+        return false;
+    }
+
+    PackageComponentStream stream;
+    struct archive* component = open_package_component_stream(package_path, component_name, &stream);
+    if (!component) {
+        return false;
+    }
+
+    bool success = checksum_archive_entries(component, &digests, nullptr, callback, user_data);
+
+    close_package_component_stream(component, &stream);
+
+    return success;
+}
+
+/**
+ * Streams a component out of a package file, handing each entry's data to a callback
+ *
+ * @param package_path Path to the package file (.dpm)
+ * @param component_name Name of the component member, e.g. "metadata"
+ * @param max_entry_size Largest entry that will be buffered, or 0 for no limit
+ * @param callback Function invoked once per visited entry
+ * @param user_data Context pointer passed through to the callback
+ * @return true if the whole component was walked, false on read errors or if the callback stopped the walk
+ */
+extern "C" bool read_package_component_entries(const char* package_path, const char* component_name,
+                                               size_t max_entry_size,
+                                               archive_entry_data_callback callback, void* user_data)
+{
+    if (!package_path || !component_name || !callback) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to read_package_component_entries");
+        return false;
+    }
+
+    PackageComponentStream stream;
+    struct archive* component = open_package_component_stream(package_path, component_name, &stream);
+    if (!component) {
+        return false;
+    }
+
+    bool success = read_archive_entries(component, max_entry_size, callback, nullptr, nullptr, nullptr, user_data);
+
+    // Clean up
+    close_package_component_stream(component, &stream);
+
+    return success;
+}
+
+/**
+ * State of an open archive iterator
+ */
+struct ArchiveIterator {
+    struct archive* archive;            ///< Archive being iterated
+    PackageComponentStream* stream;     ///< Package the archive is streamed out of, NULL when read directly
+    struct archive_entry* entry;        ///< Current entry, NULL before the first and after the last
+};
+
+/**
+ * Releases an iterator together with its archive and package stream
+ */
+static void archive_iterator_destroy(ArchiveIterator* iterator)
+{
+    if (iterator->stream) {
+        close_package_component_stream(iterator->archive, iterator->stream);
+        delete iterator->stream;
+    } else if (iterator->archive) {
+        archive_read_free(iterator->archive);
+    }
+    delete iterator;
+}
+
+/**
+ * Creates an iterator whose archive reads tarballs in every component codec, ready to be opened
+ */
+static ArchiveIterator* archive_iterator_create()
+{
+    ArchiveIterator* iterator = new ArchiveIterator();
+    iterator->stream = NULL;
+    iterator->entry = NULL;
+    iterator->archive = archive_read_new();
+    if (!iterator->archive) {
+        dpm_log(LOG_ERROR, "Failed to create archive object");
+        delete iterator;
+        return NULL;
+    }
+
+    compression_read_support(iterator->archive);
+    archive_read_support_format_tar(iterator->archive);
+    return iterator;
+}
+
+/**
+ * Checks that an iterator is positioned on an entry whose data can be read
+ */
+static ArchiveIterator* archive_iterator_current(void* iterator, const char* caller)
+{
+    ArchiveIterator* current = static_cast<ArchiveIterator*>(iterator);
+    if (!current || !current->entry) {
+        dpm_log(LOG_ERROR, ("Archive iterator has no current entry in " + std::string(caller)).c_str());
+        return NULL;
+    }
+    return current;
+}
+
+extern "C" void* archive_iterator_open_memory(const unsigned char* archive_data, size_t archive_data_size)
+{
+    if (!archive_data || archive_data_size == 0) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to archive_iterator_open_memory");
+        return NULL;
+    }
+
+    ArchiveIterator* iterator = archive_iterator_create();
+    if (!iterator) {
+        return NULL;
+    }
+
+    if (archive_read_open_memory(iterator->archive, (void*)archive_data, archive_data_size) != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Failed to open archive from memory: " +
+                          std::string(archive_error_string(iterator->archive))).c_str());
+        archive_iterator_destroy(iterator);
+        return NULL;
+    }
+
+    return iterator;
+}
+
+extern "C" void* archive_iterator_open_file(const char* archive_path)
+{
+    if (!archive_path) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to archive_iterator_open_file");
+        return NULL;
+    }
+
+    ArchiveIterator* iterator = archive_iterator_create();
+    if (!iterator) {
+        return NULL;
+    }
+
+    if (archive_read_open_filename(iterator->archive, archive_path, PACKAGE_STREAM_BLOCK_SIZE) != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Failed to open archive file: " + std::string(archive_path) + " - " +
+                          std::string(archive_error_string(iterator->archive))).c_str());
+        archive_iterator_destroy(iterator);
+        return NULL;
+    }
+
+    return iterator;
+}
+
+extern "C" void* archive_iterator_open_fd(int fd)
+{
+    if (fd < 0) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to archive_iterator_open_fd");
+        return NULL;
+    }
+
+    ArchiveIterator* iterator = archive_iterator_create();
+    if (!iterator) {
+        return NULL;
+    }
+
+    if (archive_read_open_fd(iterator->archive, fd, PACKAGE_STREAM_BLOCK_SIZE) != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Failed to open archive from file descriptor: " +
+                          std::string(archive_error_string(iterator->archive))).c_str());
+        archive_iterator_destroy(iterator);
+        return NULL;
+    }
+
+    return iterator;
+}
+
+extern "C" void* archive_iterator_open_package_component(const char* package_path, const char* component_name)
+{
+    if (!package_path || !component_name) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to archive_iterator_open_package_component");
+        return NULL;
+    }
+
+    ArchiveIterator* iterator = new ArchiveIterator();
+    iterator->entry = NULL;
+    iterator->stream = new PackageComponentStream;
+    iterator->archive = open_package_component_stream(package_path, component_name, iterator->stream);
+    if (!iterator->archive) {
+        archive_iterator_destroy(iterator);
+        return NULL;
+    }
+
+    return iterator;
+}
+
+extern "C" int archive_iterator_next(void* iterator, archive_iterator_entry* entry)
+{
+    ArchiveIterator* current = static_cast<ArchiveIterator*>(iterator);
+    if (!current || !entry) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to archive_iterator_next");
+        return -1;
+    }
+
+    // libarchive skips whatever is left of the previous entry's data
+    int r = archive_read_next_header(current->archive, &current->entry);
+    if (r == ARCHIVE_EOF) {
+        current->entry = NULL;
+        return 0;
+    }
+    if (r != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Archive read error: " + std::string(archive_error_string(current->archive))).c_str());
+        current->entry = NULL;
+        return -1;
+    }
+    dpm_metric_add(DPM_METRIC_ARCHIVE_ENTRIES, 1);
+
+    const char* archive_path = archive_entry_pathname(current->entry);
+    if (!archive_path) {
+        archive_path = "";
+    }
+
+    const char* link_target = archive_entry_hardlink(current->entry);
+    if (!link_target) {
+        link_target = archive_entry_symlink(current->entry);
+    }
+
+    entry->path = strip_archive_parent(archive_path);
+    entry->archive_path = archive_path;
+    entry->link_target = link_target;
+    entry->size = archive_entry_size_is_set(current->entry) ? static_cast<uint64_t>(archive_entry_size(current->entry)) : 0;
+    entry->mode = static_cast<uint32_t>(archive_entry_mode(current->entry));
+    entry->mtime = static_cast<int64_t>(archive_entry_mtime(current->entry));
+    return 1;
+}
+
+extern "C" long long archive_iterator_read(void* iterator, void* buffer, size_t buffer_size)
+{
+    ArchiveIterator* current = archive_iterator_current(iterator, "archive_iterator_read");
+    if (!current || !buffer) {
+        return -1;
+    }
+
+    la_ssize_t bytes_read = archive_read_data(current->archive, buffer, buffer_size);
+    if (bytes_read < 0) {
+        dpm_log(LOG_ERROR, ("Archive read data error: " + std::string(archive_error_string(current->archive))).c_str());
+        return -1;
+    }
+    dpm_metric_add(DPM_METRIC_BYTES_DECOMPRESSED, static_cast<uint64_t>(bytes_read));
+
+    return static_cast<long long>(bytes_read);
+}
+
+extern "C" int archive_iterator_read_block(void* iterator, const void** block, size_t* block_size, uint64_t* offset)
+{
+    ArchiveIterator* current = archive_iterator_current(iterator, "archive_iterator_read_block");
+    if (!current || !block || !block_size) {
+        return -1;
+    }
+
+    la_int64_t block_offset = 0;
+    int r = archive_read_data_block(current->archive, block, block_size, &block_offset);
+    if (r == ARCHIVE_EOF) {
+        *block = NULL;
+        *block_size = 0;
+        return 0;
+    }
+    if (r != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Archive read data error: " + std::string(archive_error_string(current->archive))).c_str());
+        return -1;
+    }
+
+    if (offset) {
+        *offset = static_cast<uint64_t>(block_offset);
+    }
+    dpm_metric_add(DPM_METRIC_BYTES_DECOMPRESSED, *block_size);
+    return 1;
+}
+
+extern "C" bool archive_iterator_skip(void* iterator)
+{
+    ArchiveIterator* current = archive_iterator_current(iterator, "archive_iterator_skip");
+    if (!current) {
+        return false;
+    }
+
+    if (archive_read_data_skip(current->archive) != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Archive read error: " + std::string(archive_error_string(current->archive))).c_str());
+        return false;
+    }
+    return true;
+}
+
+extern "C" void archive_iterator_close(void* iterator)
+{
+    if (iterator) {
+        archive_iterator_destroy(static_cast<ArchiveIterator*>(iterator));
+    }
+}
@@ -0,0 +1,353 @@
+/**
+ * @file batch.cpp
+ * @brief Implementation of batch sealing and signing
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "batch.hpp"
+
+BatchBudget::BatchBudget(uint64_t limit) : _limit(limit), _in_flight(0)
+{
+}
+
+uint64_t BatchBudget::acquire(uint64_t bytes)
+{
+    if (_limit == 0) {
+        return 0;
+    }
+
+    uint64_t charged = std::min(bytes, _limit);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _released.wait(lock, [this, charged] { return _in_flight == 0 || _in_flight + charged <= _limit; });
+    _in_flight += charged;
+    return charged;
+}
+
+void BatchBudget::release(uint64_t charged)
+{
+    if (_limit == 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _in_flight -= charged;
+    }
+    _released.notify_all();
+}
+
+/**
+ * @brief Escapes a string for use inside a JSON string literal
+ *
+ * @param value Raw string
+ * @return Escaped string, without surrounding quotes
+ */
+static std::string json_escape(const std::string& value)
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    escaped += buffer;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+
+    return escaped;
+}
+
+int read_batch_list(const std::string& list_path, std::vector<std::string>& paths)
+{
+    std::ifstream list_file;
+    std::istream* input = &std::cin;
+
+    if (list_path != "-") {
+        list_file.open(expand_path(list_path));
+        if (!list_file.is_open()) {
+            dpm_log(LOG_ERROR, ("Could not open batch list: " + list_path).c_str());
+            return 1;
+        }
+        input = &list_file;
+    }
+
+    std::string line;
+    while (std::getline(*input, line)) {
+        // Trim surrounding whitespace
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos) {
+            continue;
+        }
+        size_t end = line.find_last_not_of(" \t\r");
+        line = line.substr(start, end - start + 1);
+
+        if (line[0] == '#') {
+            continue;
+        }
+
+        paths.push_back(expand_path(line));
+    }
+
+    return 0;
+}
+
+size_t batch_worker_count()
+{
+    return build_config_thread_count("batch_jobs", dpm_worker_threads());
+}
+
+uint64_t batch_memory_budget()
+{
+    const char* configured = dpm_get_config("build", "batch_memory");
+    if (configured && strlen(configured) > 0) {
+        char* end = nullptr;
+        unsigned long long value = strtoull(configured, &end, 10);
+        if (end != configured && *end == '\0') {
+            return static_cast<uint64_t>(value);
+        }
+        dpm_log(LOG_WARN, ("Ignoring invalid [build] batch_memory value: " + std::string(configured)).c_str());
+    }
+    return BATCH_DEFAULT_MEMORY_BUDGET;
+}
+
+/**
+ * @brief Everything the tasks of one batch share
+ */
+struct BatchRun {
+    std::vector<BatchResult>* results;
+    std::vector<size_t> order;                  ///< Indices into results, largest first
+    std::atomic<size_t> next;                   ///< Position in order of the next item to take
+    BatchBudget* budget;
+    bool directories;                           ///< Whether the items are stage directories
+    std::function<int(const std::string&)> work;
+};
+
+// one task on the shared worker pool, working through the items until none are left
+static void batch_worker_task(void* context)
+{
+    BatchRun* run = static_cast<BatchRun*>(context);
+
+    for (;;) {
+        size_t position = run->next.fetch_add(1);
+        if (position >= run->order.size()) {
+            return;
+        }
+        BatchResult& result = (*run->results)[run->order[position]];
+
+        std::error_code ec;
+        bool present = run->directories ? std::filesystem::is_directory(result.path, ec)
+                                        : std::filesystem::is_regular_file(result.path, ec);
+        if (!present) {
+            dpm_log(LOG_ERROR, ((run->directories ? "Stage directory does not exist: " : "Package file does not exist: ")
+                                + result.path).c_str());
+            result.status = "missing";
+            continue;
+        }
+
+        uint64_t charged = run->budget->acquire(result.size);
+        auto started = std::chrono::steady_clock::now();
+
+        int rc = 1;
+        try {
+            rc = run->work(result.path);
+        } catch (const std::exception& e) {
+            dpm_log(LOG_ERROR, ("Error processing " + result.path + ": " + std::string(e.what())).c_str());
+        }
+
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        run->budget->release(charged);
+
+        result.status = rc == 0 ? "ok" : "failed";
+        if (rc != 0) {
+            dpm_log(LOG_ERROR, ("Batch item failed, continuing with the rest: " + result.path).c_str());
+        }
+    }
+}
+
+// sizes one item by the bytes of the files it is made of
+static void batch_size_range(void* context, size_t begin, size_t end)
+{
+    BatchRun* run = static_cast<BatchRun*>(context);
+
+    for (size_t i = begin; i < end; i++) {
+        BatchResult& result = (*run->results)[i];
+        std::error_code ec;
+        result.size = 0;
+
+        if (!run->directories) {
+            result.size = std::filesystem::file_size(result.path, ec);
+            if (ec) {
+                result.size = 0;
+            }
+            continue;
+        }
+
+        // the batch already runs many items at once, so each is walked on a single thread
+        TreeWalk walk;
+        if (std::filesystem::is_directory(result.path, ec) && tree_walk(result.path, walk, 1, false)) {
+            for (const auto& entry : walk) {
+                if (S_ISREG(entry.st.st_mode)) {
+                    result.size += static_cast<uintmax_t>(entry.st.st_size);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs work over every item of a batch and writes the report
+ *
+ * @param paths Items of the batch
+ * @param directories Whether the items are stage directories rather than package files
+ * @param item_key Name of the field holding the path in each result line
+ * @param worker_count Number of items to work on at once
+ * @param summary_path File to write the results to, or empty for standard output
+ * @param work Function processing one item, returning 0 on success
+ * @return 0 if every item succeeded, non-zero otherwise
+ */
+static int run_batch(const std::vector<std::string>& paths, bool directories, const char* item_key,
+                     size_t worker_count, const std::string& summary_path,
+                     std::function<int(const std::string&)> work)
+{
+    std::ofstream summary_file;
+    std::ostream* summary = &std::cout;
+    if (!summary_path.empty()) {
+        summary_file.open(summary_path, std::ios::trunc);
+        if (!summary_file.is_open()) {
+            dpm_log(LOG_ERROR, ("Could not open summary file for writing: " + summary_path).c_str());
+            return 1;
+        }
+        summary = &summary_file;
+    }
+
+    std::vector<BatchResult> results(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        results[i].path = paths[i];
+        results[i].size = 0;
+        results[i].seconds = 0;
+    }
+
+    BatchBudget budget(batch_memory_budget());
+    BatchRun run;
+    run.results = &results;
+    run.next = 0;
+    run.budget = &budget;
+    run.directories = directories;
+    run.work = std::move(work);
+
+    dpm_parallel_for(0, results.size(), 1, &batch_size_range, &run);
+
+    // Largest items first so no worker is left with a big one at the end
+    run.order.resize(results.size());
+    for (size_t i = 0; i < run.order.size(); i++) {
+        run.order[i] = i;
+    }
+    std::stable_sort(run.order.begin(), run.order.end(), [&results](size_t a, size_t b) {
+        return results[a].size > results[b].size;
+    });
+
+    size_t total_workers = std::max<size_t>(1, std::min(worker_count, results.size()));
+    DPM_LOG(LOG_DEBUG, "Processing ", results.size(), " batch items with ", total_workers,
+            " workers and a budget of ", batch_memory_budget(), " bytes");
+
+    // every item gets its share of the module's thread counts, rather than all of them each
+    set_build_concurrent_items(total_workers);
+
+    auto started = std::chrono::steady_clock::now();
+    dpm_task_group* group = dpm_task_group_create();
+    for (size_t i = 0; i < total_workers; i++) {
+        dpm_submit_task(group, &batch_worker_task, &run);
+    }
+    dpm_task_group_destroy(group);
+    set_build_concurrent_items(1);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    // Report in input order so successive runs can be diffed
+    size_t passed = 0, failed = 0, missing = 0;
+    for (const auto& result : results) {
+        if (result.status == "ok") {
+            passed++;
+        } else if (result.status == "missing") {
+            missing++;
+        } else {
+            failed++;
+        }
+
+        char seconds[32];
+        snprintf(seconds, sizeof(seconds), "%.6f", result.seconds);
+        *summary << "{\"" << item_key << "\":\"" << json_escape(result.path) << "\","
+                 << "\"status\":\"" << result.status << "\","
+                 << "\"size\":" << result.size << ","
+                 << "\"seconds\":" << seconds << "}\n";
+    }
+
+    char elapsed_str[32];
+    snprintf(elapsed_str, sizeof(elapsed_str), "%.6f", elapsed);
+    *summary << "{\"summary\":{\"total\":" << results.size()
+             << ",\"ok\":" << passed
+             << ",\"failed\":" << failed
+             << ",\"missing\":" << missing
+             << ",\"workers\":" << total_workers
+             << ",\"memory_budget\":" << batch_memory_budget()
+             << ",\"seconds\":" << elapsed_str << "}}\n";
+    summary->flush();
+
+    return (failed == 0 && missing == 0) ? 0 : 1;
+}
+
+int seal_stages_batch(const std::vector<std::string>& stages, BatchSealMode mode, const std::string& output_dir,
+                      bool force, size_t worker_count, const std::string& summary_path)
+{
+    if (stages.empty()) {
+        dpm_log(LOG_ERROR, "No stages to seal");
+        return 1;
+    }
+
+    return run_batch(stages, true, "stage", worker_count, summary_path,
+        [mode, output_dir, force](const std::string& stage_dir) {
+            switch (mode) {
+                case BatchSealMode::STREAM:
+                    return seal_final_package_streaming(stage_dir, output_dir, force);
+                case BatchSealMode::FINAL:
+                    return seal_final_package(stage_dir, output_dir, force);
+                default:
+                    return seal_stage_components(stage_dir, force);
+            }
+        });
+}
+
+int sign_batch(const std::vector<std::string>& paths, bool packages, const std::string& key_id,
+               bool force, size_t worker_count, const std::string& summary_path)
+{
+    if (paths.empty()) {
+        dpm_log(LOG_ERROR, packages ? "No packages to sign" : "No stages to sign");
+        return 1;
+    }
+
+    // GPGME is set up and the key looked up once for the whole batch
+    SigningSession session;
+    if (!session.open(key_id)) {
+        return 1;
+    }
+
+    return run_batch(paths, !packages, packages ? "package" : "stage", worker_count, summary_path,
+        [&session, packages, force](const std::string& path) {
+            return packages ? sign_package_file(path, session, force)
+                            : sign_stage_directory(path, session, force);
+        });
+}
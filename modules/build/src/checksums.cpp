@@ -3,7 +3,8 @@
  * @brief Implementation of cryptographic checksum functions
  *
  * Implements functionality for generating checksums of files using
- * configurable cryptographic hash algorithms via OpenSSL.
+ * configurable cryptographic hash algorithms provided by the hash
+ * backends (OpenSSL, and BLAKE3 when available).
  *
  * @copyright Copyright (c) 2025 SILO GROUP LLC
  * @author Chris Punches <chris.punches@silogroup.org>
@@ -15,63 +16,46 @@
 
 extern "C" std::string get_configured_hash_algorithm()
 {
-    const char* algorithm = dpm_get_config("cryptography", "checksum_algorithm");
-    if (algorithm && strlen(algorithm) > 0) {
-        return std::string(algorithm);
-    }
-
-    // Default to SHA-256 if not specified or empty
-    return "sha256";
+    return get_configured_hash_algorithms().front();
 }
 
-extern "C" std::string get_available_algorithms()
+extern "C" std::vector<std::string> get_configured_hash_algorithms()
 {
     std::vector<std::string> algorithms;
-    std::vector<std::string> working_algorithms;
 
-    // Initialize OpenSSL
-    OpenSSL_add_all_digests();
-
-    // Use OBJ_NAME_do_all to get all message digest algorithms
-    struct AllDigestsCallback {
-        static void callback(const OBJ_NAME* obj, void* arg) {
-            if (obj->type == OBJ_NAME_TYPE_MD_METH) {
-                std::vector<std::string>* algs = static_cast<std::vector<std::string>*>(arg);
-                algs->push_back(obj->name);
+    // read for every file hashed, so the key is resolved once
+    static const dpm_config_handle algorithm_handle = dpm_config_resolve("cryptography", "checksum_algorithm");
+    const char* configured = dpm_config_value(algorithm_handle);
+    if (configured) {
+        // Algorithms may be separated by commas, spaces or both
+        std::string list(configured);
+        std::replace(list.begin(), list.end(), ',', ' ');
+
+        std::istringstream iss(list);
+        std::string algorithm;
+        while (iss >> algorithm) {
+            if (std::find(algorithms.begin(), algorithms.end(), algorithm) == algorithms.end()) {
+                algorithms.push_back(algorithm);
             }
         }
-    };
-
-    // Get all algorithm names
-    OBJ_NAME_do_all(OBJ_NAME_TYPE_MD_METH, AllDigestsCallback::callback, &algorithms);
-
-    // Test each algorithm with a complete hashing process
-    for (const auto& algo_name : algorithms) {
-        const EVP_MD* md = EVP_get_digestbyname(algo_name.c_str());
-        if (!md) continue;
-
-        // Create context
-        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-        if (!ctx) continue;
+    }
 
-        // Test full hashing sequence with dummy data
-        unsigned char dummy_data[] = "test";
-        unsigned char out_buf[EVP_MAX_MD_SIZE];
-        unsigned int out_len = 0;
+    // Default to SHA-256 if not specified or empty
+    if (algorithms.empty()) {
+        algorithms.push_back("sha256");
+    }
 
-        bool success = false;
-        if (EVP_DigestInit_ex(ctx, md, NULL) == 1 &&
-            EVP_DigestUpdate(ctx, dummy_data, sizeof(dummy_data)) == 1 &&
-            EVP_DigestFinal_ex(ctx, out_buf, &out_len) == 1) {
-            success = true;
-            }
+    return algorithms;
+}
 
-        EVP_MD_CTX_free(ctx);
+extern "C" bool hash_algorithm_supported(const std::string& algorithm)
+{
+    return hash_backend_find_algorithm(algorithm) != nullptr;
+}
 
-        if (success) {
-            working_algorithms.push_back(algo_name);
-        }
-    }
+extern "C" std::string get_available_algorithms()
+{
+    std::vector<std::string> working_algorithms = hash_backend_list_algorithms();
 
     // Format the list as a comma-separated string
     std::stringstream result;
@@ -83,147 +67,525 @@ extern "C" std::string get_available_algorithms()
     return result.str();
 }
 
-extern "C" std::string generate_file_checksum(const std::filesystem::path& file_path)
+/**
+ * @brief Pairs of hexadecimal digits for every byte value
+ */
+struct HexTable {
+    char digits[256][2];
+
+    constexpr HexTable() : digits()
+    {
+        const char hex_digits[] = "0123456789abcdef";
+        for (int i = 0; i < 256; i++) {
+            digits[i][0] = hex_digits[i >> 4];
+            digits[i][1] = hex_digits[i & 0x0f];
+        }
+    }
+};
+
+static constexpr HexTable HEX_TABLE;
+
+const char* checksum_io_strategy_name(ChecksumIoStrategy strategy)
 {
-    // Get configured algorithm
-    std::string algorithm_name = get_configured_hash_algorithm();
+    switch (strategy) {
+        case CHECKSUM_IO_READ:
+            return "read";
+        case CHECKSUM_IO_PREAD:
+            return "pread";
+        case CHECKSUM_IO_MMAP:
+            return "mmap";
+        case CHECKSUM_IO_AUTO:
+        default:
+            return "auto";
+    }
+}
 
-    // Initialize OpenSSL
-    OpenSSL_add_all_digests();
+/**
+ * @brief Reads a byte threshold from the build section of the configuration
+ *
+ * @param key Configuration key to read
+ * @param default_value Value used when the key is missing or invalid
+ * @return Threshold in bytes
+ */
+static uint64_t checksum_configured_threshold(const char* key, uint64_t default_value)
+{
+    const char* configured = dpm_get_config("build", key);
+    if (!configured || strlen(configured) == 0) {
+        return default_value;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long value = strtoull(configured, &end, 10);
+    if (errno != 0 || end == configured || *end != '\0') {
+        dpm_log(LOG_WARN, ("Ignoring invalid [build] " + std::string(key) + " value: " + configured).c_str());
+        return default_value;
+    }
 
-    // Get the digest
-    const EVP_MD* md = EVP_get_digestbyname(algorithm_name.c_str());
-    if (!md) {
+    return static_cast<uint64_t>(value);
+}
+
+ChecksumEngine::ChecksumEngine()
+    : _algorithm(get_configured_hash_algorithm()), _digest(nullptr),
+      _small_file_max(checksum_configured_threshold("checksum_small_file_max", CHECKSUM_DEFAULT_SMALL_FILE_MAX)),
+      _mmap_min(checksum_configured_threshold("checksum_mmap_min", CHECKSUM_DEFAULT_MMAP_MIN))
+{
+    _digest = hash_backend_find_algorithm(_algorithm);
+    if (!_digest) {
         std::string available_algorithms = get_available_algorithms();
-        dpm_log(LOG_FATAL, ("Hash algorithm not supported: " + algorithm_name +
+        dpm_log(LOG_FATAL, ("Hash algorithm not supported: " + _algorithm +
                 ". Available algorithms: " + available_algorithms).c_str());
-        return "";
     }
+}
 
-    // Initialize OpenSSL EVP context
-    EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
-    if (!mdctx) {
-        dpm_log(LOG_ERROR, "Failed to create OpenSSL EVP context");
-        return "";
+ChecksumEngine& ChecksumEngine::instance()
+{
+    static ChecksumEngine engine;
+    return engine;
+}
+
+bool ChecksumEngine::valid() const
+{
+    return _digest != nullptr;
+}
+
+const std::string& ChecksumEngine::algorithm() const
+{
+    return _algorithm;
+}
+
+size_t ChecksumEngine::digest_size() const
+{
+    return _digest ? _digest->digest_size() : 0;
+}
+
+DigestContext* ChecksumEngine::thread_context()
+{
+    // the engine's algorithm never changes, so each thread keeps one context for it
+    static thread_local std::unique_ptr<DigestContext> thread_digest;
+
+    if (!thread_digest) {
+        thread_digest = _digest->create_context();
     }
 
-    if (EVP_DigestInit_ex(mdctx, md, nullptr) != 1) {
-        dpm_log(LOG_ERROR, "Failed to initialize digest context");
-        EVP_MD_CTX_free(mdctx);
-        return "";
+    return thread_digest.get();
+}
+
+bool ChecksumEngine::begin()
+{
+    if (!_digest) {
+        dpm_log(LOG_ERROR, ("Hash algorithm not supported: " + _algorithm).c_str());
+        return false;
     }
 
-    // Check if the file exists
-    if (!std::filesystem::exists(file_path)) {
-        dpm_log(LOG_ERROR, ("File does not exist: " + file_path.string()).c_str());
-        EVP_MD_CTX_free(mdctx);
-        return "";
+    DigestContext* context = thread_context();
+    return context && context->init();
+}
+
+bool ChecksumEngine::update(const void* data, size_t size)
+{
+    dpm_metric_add(DPM_METRIC_BYTES_HASHED, size);
+    return thread_context()->update(data, size);
+}
+
+bool ChecksumEngine::finish(unsigned char* digest, size_t* digest_size)
+{
+    return thread_context()->finish(digest, digest_size);
+}
+
+bool ChecksumEngine::digest_buffer(const void* data, size_t size, unsigned char* digest, size_t* digest_size)
+{
+    return begin() && update(data, size) && finish(digest, digest_size);
+}
+
+ChecksumIoStrategy ChecksumEngine::select_io_strategy(uint64_t file_size) const
+{
+    if (file_size <= _small_file_max) {
+        return CHECKSUM_IO_READ;
     }
 
-    // Open the file for reading in binary mode
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file) {
-        dpm_log(LOG_ERROR, ("Failed to open file for checksum: " + file_path.string()).c_str());
-        EVP_MD_CTX_free(mdctx);
-        return "";
+    if (file_size >= _mmap_min) {
+        return CHECKSUM_IO_MMAP;
     }
 
-    // Buffer for reading file chunks
-    const size_t buffer_size = 8192;  // 8KB chunks
-    unsigned char buffer[buffer_size];
+    return CHECKSUM_IO_PREAD;
+}
 
-    // Read and update digest
-    while (file) {
-        file.read(reinterpret_cast<char*>(buffer), buffer_size);
-        size_t bytes_read = file.gcount();
+uint64_t ChecksumEngine::small_file_max() const
+{
+    return _small_file_max;
+}
 
-        if (bytes_read > 0) {
-            if (EVP_DigestUpdate(mdctx, buffer, bytes_read) != 1) {
-                dpm_log(LOG_ERROR, "Failed to update digest");
-                EVP_MD_CTX_free(mdctx);
-                file.close();
-                return "";
+uint64_t ChecksumEngine::mmap_min() const
+{
+    return _mmap_min;
+}
+
+bool ChecksumEngine::read_descriptor_whole(int fd, const std::string& file_path, uint64_t file_size,
+                                           const ChecksumDataSink& consume)
+{
+    static thread_local std::vector<unsigned char> small_buffer;
+
+    // one byte more than expected, so a file that grew since fstat is noticed
+    if (small_buffer.size() < file_size + 1) {
+        small_buffer.resize(file_size + 1);
+    }
+
+    size_t total = 0;
+    while (total < small_buffer.size()) {
+        ssize_t bytes_read = read(fd, small_buffer.data() + total, small_buffer.size() - total);
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            dpm_log(LOG_ERROR, ("Failed to read file for checksum: " + file_path + ": " + strerror(errno)).c_str());
+            return false;
+        }
+        if (bytes_read == 0) {
+            break;
         }
+        total += static_cast<size_t>(bytes_read);
     }
 
-    file.close();
+    bool success = total == 0 || consume(small_buffer.data(), total);
+    bool grew = total == small_buffer.size();
 
-    // Finalize the digest
-    unsigned char hash[EVP_MAX_MD_SIZE];
-    unsigned int hash_len = 0;
+    // don't keep a buffer around that was only sized up for one large file
+    if (file_size > _small_file_max) {
+        std::vector<unsigned char>().swap(small_buffer);
+    }
 
-    if (EVP_DigestFinal_ex(mdctx, hash, &hash_len) != 1) {
-        dpm_log(LOG_ERROR, "Failed to finalize digest");
-        EVP_MD_CTX_free(mdctx);
-        return "";
+    if (!success) {
+        return false;
+    }
+
+    // the file grew past its stat size, hash the remainder with positional reads
+    if (grew) {
+        return read_descriptor_pread(fd, file_path, consume);
     }
 
-    EVP_MD_CTX_free(mdctx);
+    return true;
+}
 
-    // Convert binary hash to hexadecimal string
-    std::stringstream ss;
-    for (unsigned int i = 0; i < hash_len; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+/**
+ * @brief Owns the calling thread's aligned read buffer and frees it when the thread exits
+ */
+struct ThreadReadBuffer {
+    unsigned char* data = nullptr;
+
+    ~ThreadReadBuffer()
+    {
+        free(data);
+    }
+};
+
+bool ChecksumEngine::read_descriptor_pread(int fd, const std::string& file_path, const ChecksumDataSink& consume)
+{
+    static thread_local ThreadReadBuffer read_buffer;
+
+    if (!read_buffer.data) {
+        void* aligned = nullptr;
+        if (posix_memalign(&aligned, 4096, CHECKSUM_READ_BUFFER_SIZE) != 0) {
+            dpm_log(LOG_ERROR, "Failed to allocate checksum read buffer");
+            return false;
+        }
+        read_buffer.data = static_cast<unsigned char*>(aligned);
+    }
+
+    // continue from wherever the descriptor currently is
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset < 0) {
+        offset = 0;
     }
 
-    return ss.str();
+    posix_fadvise(fd, offset, 0, POSIX_FADV_SEQUENTIAL);
+
+    while (true) {
+        ssize_t bytes_read = pread(fd, read_buffer.data, CHECKSUM_READ_BUFFER_SIZE, offset);
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            dpm_log(LOG_ERROR, ("Failed to read file for checksum: " + file_path + ": " + strerror(errno)).c_str());
+            return false;
+        }
+        if (bytes_read == 0) {
+            break;
+        }
+
+        if (!consume(read_buffer.data, static_cast<size_t>(bytes_read))) {
+            return false;
+        }
+        offset += bytes_read;
+    }
+
+    return true;
 }
 
-extern "C" std::string generate_string_checksum(const std::string& input_string)
+bool ChecksumEngine::read_descriptor_mmap(int fd, const std::string& file_path, uint64_t file_size,
+                                          const ChecksumDataSink& consume)
 {
-    // Get configured algorithm
-    std::string algorithm_name = get_configured_hash_algorithm();
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        DPM_LOG(LOG_DEBUG, "Falling back to positional reads, mmap failed for: ", file_path);
+        return read_descriptor_pread(fd, file_path, consume);
+    }
 
-    // Initialize OpenSSL
-    OpenSSL_add_all_digests();
+    madvise(mapping, file_size, MADV_SEQUENTIAL);
 
-    // Get the digest
-    const EVP_MD* md = EVP_get_digestbyname(algorithm_name.c_str());
-    if (!md) {
-        std::string available_algorithms = get_available_algorithms();
-        dpm_log(LOG_FATAL, ("Hash algorithm not supported: " + algorithm_name +
-                ". Available algorithms: " + available_algorithms).c_str());
-        return "";
+    // hand the mapping over in buffer-sized steps rather than one giant update
+    const unsigned char* data = static_cast<const unsigned char*>(mapping);
+    bool success = true;
+    for (uint64_t offset = 0; offset < file_size && success; offset += CHECKSUM_READ_BUFFER_SIZE) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(CHECKSUM_READ_BUFFER_SIZE, file_size - offset));
+        success = consume(data + offset, chunk);
     }
 
-    // Initialize OpenSSL EVP context
-    EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
-    if (!mdctx) {
-        dpm_log(LOG_ERROR, "Failed to create OpenSSL EVP context");
-        return "";
+    munmap(mapping, file_size);
+
+    // anything appended after fstat is picked up from the end of the mapping
+    if (success && lseek(fd, static_cast<off_t>(file_size), SEEK_SET) >= 0) {
+        success = read_descriptor_pread(fd, file_path, consume);
     }
 
-    if (EVP_DigestInit_ex(mdctx, md, nullptr) != 1) {
-        dpm_log(LOG_ERROR, "Failed to initialize digest context");
-        EVP_MD_CTX_free(mdctx);
-        return "";
+    return success;
+}
+
+bool ChecksumEngine::read_file(const std::filesystem::path& file_path, const ChecksumDataSink& consume,
+                               ChecksumIoStrategy strategy)
+{
+    int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            dpm_log(LOG_ERROR, ("File does not exist: " + file_path.string()).c_str());
+        } else {
+            dpm_log(LOG_ERROR, ("Failed to open file for checksum: " + file_path.string()).c_str());
+        }
+        return false;
     }
 
-    // Update digest with the string contents
-    if (EVP_DigestUpdate(mdctx, input_string.c_str(), input_string.length()) != 1) {
-        dpm_log(LOG_ERROR, "Failed to update digest");
-        EVP_MD_CTX_free(mdctx);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        dpm_log(LOG_ERROR, ("Failed to stat file for checksum: " + file_path.string()).c_str());
+        close(fd);
+        return false;
+    }
+
+    // only regular files have a size worth planning around
+    uint64_t file_size = S_ISREG(st.st_mode) ? static_cast<uint64_t>(st.st_size) : 0;
+    if (!S_ISREG(st.st_mode)) {
+        strategy = CHECKSUM_IO_PREAD;
+    } else if (strategy == CHECKSUM_IO_AUTO) {
+        strategy = select_io_strategy(file_size);
+    }
+
+    bool success = false;
+    switch (strategy) {
+        case CHECKSUM_IO_READ:
+            success = read_descriptor_whole(fd, file_path.string(), file_size, consume);
+            break;
+
+        case CHECKSUM_IO_MMAP:
+            success = file_size > 0 ? read_descriptor_mmap(fd, file_path.string(), file_size, consume)
+                                    : read_descriptor_pread(fd, file_path.string(), consume);
+            break;
+
+        case CHECKSUM_IO_PREAD:
+        case CHECKSUM_IO_AUTO:
+        default:
+            success = read_descriptor_pread(fd, file_path.string(), consume);
+            break;
+    }
+
+    close(fd);
+    return success;
+}
+
+bool ChecksumEngine::digest_file(const std::filesystem::path& file_path, unsigned char* digest, size_t* digest_size,
+                                 ChecksumIoStrategy strategy)
+{
+    if (!begin()) {
+        return false;
+    }
+
+    auto consume = [this](const void* data, size_t size) { return update(data, size); };
+    return read_file(file_path, consume, strategy) && finish(digest, digest_size);
+}
+
+void ChecksumEngine::to_hex(const unsigned char* digest, size_t size, char* hex)
+{
+    for (size_t i = 0; i < size; i++) {
+        hex[i * 2] = HEX_TABLE.digits[digest[i]][0];
+        hex[i * 2 + 1] = HEX_TABLE.digits[digest[i]][1];
+    }
+    hex[size * 2] = '\0';
+}
+
+std::string ChecksumEngine::to_hex(const unsigned char* digest, size_t size)
+{
+    std::string hex(size * 2, '\0');
+    for (size_t i = 0; i < size; i++) {
+        hex[i * 2] = HEX_TABLE.digits[digest[i]][0];
+        hex[i * 2 + 1] = HEX_TABLE.digits[digest[i]][1];
+    }
+    return hex;
+}
+
+extern "C" std::string generate_file_checksum(const std::filesystem::path& file_path)
+{
+    DpmProfileScope profile("generate_file_checksum");
+
+    unsigned char hash[CHECKSUM_MAX_DIGEST_SIZE];
+    size_t hash_len = 0;
+
+    if (!ChecksumEngine::instance().digest_file(file_path, hash, &hash_len)) {
         return "";
     }
 
-    // Finalize the digest
-    unsigned char hash[EVP_MAX_MD_SIZE];
-    unsigned int hash_len = 0;
+    if (profile.active()) {
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(file_path, ec);
+        profile.add_bytes(ec ? 0 : size);
+        profile.add_files(1);
+    }
+
+    return ChecksumEngine::to_hex(hash, hash_len);
+}
+
+extern "C" std::string generate_string_checksum(const std::string& input_string)
+{
+    unsigned char hash[CHECKSUM_MAX_DIGEST_SIZE];
+    size_t hash_len = 0;
 
-    if (EVP_DigestFinal_ex(mdctx, hash, &hash_len) != 1) {
-        dpm_log(LOG_ERROR, "Failed to finalize digest");
-        EVP_MD_CTX_free(mdctx);
+    if (!ChecksumEngine::instance().digest_buffer(input_string.data(), input_string.size(), hash, &hash_len)) {
         return "";
     }
 
-    EVP_MD_CTX_free(mdctx);
+    return ChecksumEngine::to_hex(hash, hash_len);
+}
+
+extern "C" int dpm_digest_buffer(const void* data, size_t size, uint8_t* out, size_t* out_len)
+{
+    if ((!data && size > 0) || !out || !out_len) {
+        return 1;
+    }
+
+    unsigned char hash[CHECKSUM_MAX_DIGEST_SIZE];
+    size_t hash_len = 0;
+    if (!ChecksumEngine::instance().digest_buffer(data, size, hash, &hash_len) || hash_len > *out_len) {
+        return 1;
+    }
+
+    memcpy(out, hash, hash_len);
+    *out_len = hash_len;
+    return 0;
+}
+
+MultiChecksum::MultiChecksum(const std::vector<std::string>& algorithms)
+    : _valid(!algorithms.empty())
+{
+    for (const auto& algorithm : algorithms) {
+        const DigestAlgorithm* digest = hash_backend_find_algorithm(algorithm);
+        if (!digest) {
+            dpm_log(LOG_ERROR, ("Hash algorithm not supported: " + algorithm).c_str());
+            _valid = false;
+            continue;
+        }
+
+        std::unique_ptr<DigestContext> context = digest->create_context();
+        if (!context) {
+            _valid = false;
+            continue;
+        }
+
+        _contexts.push_back(std::move(context));
+    }
+}
+
+bool MultiChecksum::valid() const
+{
+    return _valid;
+}
 
-    // Convert binary hash to hexadecimal string
-    std::stringstream ss;
-    for (unsigned int i = 0; i < hash_len; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+bool MultiChecksum::begin()
+{
+    if (!_valid) {
+        return false;
+    }
+
+    for (auto& context : _contexts) {
+        if (!context->init()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool MultiChecksum::update(const void* data, size_t size)
+{
+    dpm_metric_add(DPM_METRIC_BYTES_HASHED, size);
+    for (auto& context : _contexts) {
+        if (!context->update(data, size)) {
+            return false;
+        }
     }
 
-    return ss.str();
-}
\ No newline at end of file
+    return true;
+}
+
+bool MultiChecksum::finish(std::vector<std::string>& hex_digests)
+{
+    hex_digests.clear();
+
+    for (auto& context : _contexts) {
+        unsigned char hash[CHECKSUM_MAX_DIGEST_SIZE];
+        size_t hash_len = 0;
+
+        if (!context->finish(hash, &hash_len)) {
+            hex_digests.clear();
+            return false;
+        }
+
+        hex_digests.push_back(ChecksumEngine::to_hex(hash, hash_len));
+    }
+
+    return true;
+}
+
+extern "C" std::vector<std::string> generate_file_checksums(const std::filesystem::path& file_path,
+                                                             const std::vector<std::string>& algorithms)
+{
+    DpmProfileScope profile("generate_file_checksum");
+    std::vector<std::string> checksums;
+
+    MultiChecksum digests(algorithms);
+    if (!digests.begin()) {
+        return checksums;
+    }
+
+    auto consume = [&digests, &profile](const void* data, size_t size) {
+        profile.add_bytes(size);
+        return digests.update(data, size);
+    };
+    if (!ChecksumEngine::instance().read_file(file_path, consume)) {
+        return checksums;
+    }
+
+    digests.finish(checksums);
+    profile.add_files(1);
+    return checksums;
+}
+
+extern "C" std::vector<std::string> generate_buffer_checksums(const unsigned char* data, size_t data_size,
+                                                               const std::vector<std::string>& algorithms)
+{
+    std::vector<std::string> checksums;
+
+    MultiChecksum digests(algorithms);
+    if (digests.begin() && digests.update(data, data_size)) {
+        digests.finish(checksums);
+    }
+
+    return checksums;
+}
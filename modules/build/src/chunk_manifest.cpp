@@ -0,0 +1,427 @@
+/**
+ * @file chunk_manifest.cpp
+ * @brief Implementation of per-chunk digests and Merkle roots of large contents files
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "chunk_manifest.hpp"
+
+// first line of every chunk manifest, bumped whenever the format changes
+static const char* CHUNK_MANIFEST_HEADER = "# dpm chunk manifest v1";
+
+// prefixes separating leaf digests from inner node digests in the tree
+static const unsigned char CHUNK_MERKLE_LEAF_PREFIX = 0x00;
+static const unsigned char CHUNK_MERKLE_NODE_PREFIX = 0x01;
+
+/**
+ * @brief Reads a size in bytes from the build section of the configuration
+ *
+ * @param key Configuration key to read
+ * @param default_value Value used when the key is missing or invalid
+ * @return Size in bytes
+ */
+static uint64_t chunk_manifest_configured_size(const char* key, uint64_t default_value)
+{
+    const char* configured = dpm_get_config("build", key);
+    if (!configured || strlen(configured) == 0) {
+        return default_value;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long value = strtoull(configured, &end, 10);
+    if (errno != 0 || end == configured || *end != '\0') {
+        dpm_log(LOG_WARN, ("Ignoring invalid [build] " + std::string(key) + " value: " + configured).c_str());
+        return default_value;
+    }
+
+    return static_cast<uint64_t>(value);
+}
+
+uint64_t chunk_manifest_chunk_size()
+{
+    uint64_t chunk_size = chunk_manifest_configured_size("contents_chunk_size", CHUNK_MANIFEST_DEFAULT_CHUNK_SIZE);
+    return chunk_size > 0 ? chunk_size : CHUNK_MANIFEST_DEFAULT_CHUNK_SIZE;
+}
+
+uint64_t chunk_manifest_min_size()
+{
+    return chunk_manifest_configured_size("contents_chunk_min", CHUNK_MANIFEST_DEFAULT_MIN_SIZE);
+}
+
+/**
+ * @brief Converts a lowercase or uppercase hexadecimal digest to binary
+ *
+ * @param hex Hexadecimal digest
+ * @param digest Receives the binary digest
+ * @return true on success, false if the text is not an even number of hexadecimal digits
+ */
+static bool chunk_manifest_from_hex(const std::string& hex, std::vector<unsigned char>& digest)
+{
+    if (hex.empty() || hex.size() % 2 != 0) {
+        return false;
+    }
+
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    digest.resize(hex.size() / 2);
+    for (size_t i = 0; i < digest.size(); i++) {
+        int high = nibble(hex[i * 2]);
+        int low = nibble(hex[i * 2 + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        digest[i] = static_cast<unsigned char>((high << 4) | low);
+    }
+
+    return true;
+}
+
+extern "C" std::string generate_file_chunk_checksum(const std::filesystem::path& file_path, uint64_t offset,
+                                                    uint64_t length, const std::string& algorithm)
+{
+    const DigestAlgorithm* digest = hash_backend_find_algorithm(algorithm);
+    if (!digest) {
+        dpm_log(LOG_ERROR, ("Hash algorithm not supported: " + algorithm).c_str());
+        return "";
+    }
+
+    std::unique_ptr<DigestContext> context = digest->create_context();
+    if (!context || !context->init() || !context->update(&CHUNK_MERKLE_LEAF_PREFIX, 1)) {
+        return "";
+    }
+
+    int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to open file for checksum: " + file_path.string() + ": " + strerror(errno)).c_str());
+        return "";
+    }
+
+    static thread_local std::vector<unsigned char> buffer;
+    buffer.resize(CHECKSUM_READ_BUFFER_SIZE);
+
+    uint64_t remaining = length;
+    off_t position = static_cast<off_t>(offset);
+    while (remaining > 0) {
+        size_t wanted = static_cast<size_t>(std::min<uint64_t>(buffer.size(), remaining));
+        ssize_t result = pread(fd, buffer.data(), wanted, position);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            dpm_log(LOG_ERROR, ("Failed to read file: " + file_path.string() + ": " + strerror(errno)).c_str());
+            close(fd);
+            return "";
+        }
+        if (result == 0) {
+            dpm_log(LOG_ERROR, ("File is shorter than the chunk being hashed: " + file_path.string()).c_str());
+            close(fd);
+            return "";
+        }
+
+        dpm_metric_add(DPM_METRIC_BYTES_HASHED, static_cast<uint64_t>(result));
+        if (!context->update(buffer.data(), static_cast<size_t>(result))) {
+            close(fd);
+            return "";
+        }
+
+        remaining -= static_cast<uint64_t>(result);
+        position += result;
+    }
+    close(fd);
+
+    unsigned char hash[CHECKSUM_MAX_DIGEST_SIZE];
+    size_t hash_len = 0;
+    if (!context->finish(hash, &hash_len)) {
+        return "";
+    }
+
+    return ChecksumEngine::to_hex(hash, hash_len);
+}
+
+extern "C" std::string generate_chunk_merkle_root(const std::vector<std::string>& chunk_checksums,
+                                                  const std::string& algorithm)
+{
+    const DigestAlgorithm* digest = hash_backend_find_algorithm(algorithm);
+    if (!digest) {
+        dpm_log(LOG_ERROR, ("Hash algorithm not supported: " + algorithm).c_str());
+        return "";
+    }
+
+    if (chunk_checksums.empty()) {
+        dpm_log(LOG_ERROR, "Cannot compute a Merkle root without chunks");
+        return "";
+    }
+
+    std::vector<std::vector<unsigned char>> level(chunk_checksums.size());
+    for (size_t i = 0; i < chunk_checksums.size(); i++) {
+        if (!chunk_manifest_from_hex(chunk_checksums[i], level[i])) {
+            dpm_log(LOG_ERROR, ("Invalid chunk digest: " + chunk_checksums[i]).c_str());
+            return "";
+        }
+    }
+
+    std::unique_ptr<DigestContext> context = digest->create_context();
+    if (!context) {
+        return "";
+    }
+
+    while (level.size() > 1) {
+        std::vector<std::vector<unsigned char>> next;
+        next.reserve((level.size() + 1) / 2);
+
+        for (size_t i = 0; i < level.size(); i += 2) {
+            // an unpaired node moves up a level as it is
+            if (i + 1 == level.size()) {
+                next.push_back(std::move(level[i]));
+                continue;
+            }
+
+            unsigned char hash[CHECKSUM_MAX_DIGEST_SIZE];
+            size_t hash_len = 0;
+            if (!context->init() ||
+                !context->update(&CHUNK_MERKLE_NODE_PREFIX, 1) ||
+                !context->update(level[i].data(), level[i].size()) ||
+                !context->update(level[i + 1].data(), level[i + 1].size()) ||
+                !context->finish(hash, &hash_len)) {
+                return "";
+            }
+            next.emplace_back(hash, hash + hash_len);
+        }
+
+        level = std::move(next);
+    }
+
+    return ChecksumEngine::to_hex(level.front().data(), level.front().size());
+}
+
+bool chunk_manifest_hash_file(const std::filesystem::path& file_path, const std::string& algorithm,
+                              uint64_t chunk_size, size_t worker_count, ChunkedFileRecord& record)
+{
+    struct stat st;
+    if (stat(file_path.c_str(), &st) != 0) {
+        dpm_log(LOG_ERROR, ("Failed to get file stats for: " + file_path.string()).c_str());
+        return false;
+    }
+
+    uint64_t file_size = static_cast<uint64_t>(st.st_size);
+    size_t chunk_count = static_cast<size_t>((file_size + chunk_size - 1) / chunk_size);
+    if (chunk_count == 0) {
+        dpm_log(LOG_ERROR, ("Cannot chunk an empty file: " + file_path.string()).c_str());
+        return false;
+    }
+
+    std::vector<std::string> chunks(chunk_count);
+    std::atomic<size_t> next_chunk(0);
+
+    // worker_count tasks on the shared worker pool take chunks until none are left
+    size_t task_count = std::min(std::max<size_t>(worker_count, 1), chunk_count);
+    dpm_parallel_for_each(0, task_count, 1, [&](size_t, size_t) {
+        while (true) {
+            size_t i = next_chunk++;
+            if (i >= chunk_count) {
+                return;
+            }
+
+            uint64_t offset = static_cast<uint64_t>(i) * chunk_size;
+            uint64_t length = std::min<uint64_t>(chunk_size, file_size - offset);
+            chunks[i] = generate_file_chunk_checksum(file_path, offset, length, algorithm);
+
+            // stop handing out chunks once one has failed
+            if (chunks[i].empty()) {
+                next_chunk = chunk_count;
+            }
+        }
+    });
+
+    for (const auto& chunk : chunks) {
+        if (chunk.empty()) {
+            return false;
+        }
+    }
+
+    std::string root = generate_chunk_merkle_root(chunks, algorithm);
+    if (root.empty()) {
+        return false;
+    }
+
+    record.file_size = file_size;
+    record.root = root;
+    record.chunks = std::move(chunks);
+    return true;
+}
+
+bool chunk_manifest_load(const std::filesystem::path& package_dir, ChunkManifest& manifest)
+{
+    manifest.algorithm.clear();
+    manifest.chunk_size = 0;
+    manifest.files.clear();
+
+    std::ifstream chunk_file(package_dir / "metadata" / CONTENTS_CHUNKS_FILENAME);
+    if (!chunk_file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    const std::string algorithm_prefix = "# algorithm: ";
+    const std::string chunk_size_prefix = "# chunk_size: ";
+
+    if (!std::getline(chunk_file, line) || line != CHUNK_MANIFEST_HEADER) {
+        return false;
+    }
+    if (!std::getline(chunk_file, line) || line.rfind(algorithm_prefix, 0) != 0) {
+        return false;
+    }
+    manifest.algorithm = line.substr(algorithm_prefix.size());
+    if (!std::getline(chunk_file, line) || line.rfind(chunk_size_prefix, 0) != 0) {
+        return false;
+    }
+    manifest.chunk_size = strtoull(line.c_str() + chunk_size_prefix.size(), nullptr, 10);
+    if (manifest.algorithm.empty() || manifest.chunk_size == 0) {
+        return false;
+    }
+
+    while (std::getline(chunk_file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        std::istringstream iss(line);
+        ChunkedFileRecord record;
+        size_t chunk_count = 0;
+        if (!(iss >> record.root >> record.file_size >> chunk_count)) {
+            return false;
+        }
+
+        std::getline(iss >> std::ws, record.relative_path);
+        if (record.relative_path.empty()) {
+            return false;
+        }
+        if (record.relative_path[0] == '/') {
+            record.relative_path = record.relative_path.substr(1);
+        }
+
+        record.chunks.resize(chunk_count);
+        for (auto& chunk : record.chunks) {
+            if (!std::getline(chunk_file, chunk) || chunk.empty()) {
+                return false;
+            }
+        }
+
+        manifest.files.push_back(std::move(record));
+    }
+
+    return true;
+}
+
+bool chunk_manifest_update(const std::filesystem::path& package_dir, const std::string& algorithm,
+                           const std::vector<std::pair<std::string, bool>>& files, size_t worker_count)
+{
+    std::filesystem::path chunk_path = package_dir / "metadata" / CONTENTS_CHUNKS_FILENAME;
+    std::filesystem::path contents_dir = package_dir / "contents";
+    uint64_t min_size = chunk_manifest_min_size();
+
+    ChunkManifest updated;
+    updated.algorithm = algorithm;
+    updated.chunk_size = chunk_manifest_chunk_size();
+
+    // Records of unchanged files are kept if they were made the same way
+    ChunkManifest previous;
+    std::unordered_map<std::string, const ChunkedFileRecord*> previous_records;
+    if (chunk_manifest_load(package_dir, previous) &&
+        previous.algorithm == updated.algorithm &&
+        previous.chunk_size == updated.chunk_size) {
+        for (const auto& record : previous.files) {
+            previous_records[record.relative_path] = &record;
+        }
+    }
+
+    size_t reused_records = 0;
+    if (min_size > 0) {
+        for (const auto& [relative_path, reusable] : files) {
+            std::filesystem::path full_path = contents_dir / relative_path;
+
+            struct stat st;
+            if (stat(full_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) ||
+                static_cast<uint64_t>(st.st_size) < min_size) {
+                continue;
+            }
+
+            auto it = previous_records.find(relative_path);
+            if (reusable && it != previous_records.end() &&
+                it->second->file_size == static_cast<uint64_t>(st.st_size)) {
+                updated.files.push_back(*it->second);
+                reused_records++;
+                continue;
+            }
+
+            ChunkedFileRecord record;
+            record.relative_path = relative_path;
+            if (!chunk_manifest_hash_file(full_path, algorithm, updated.chunk_size, worker_count, record)) {
+                dpm_log(LOG_ERROR, ("Failed to generate chunk digests for: " + full_path.string()).c_str());
+                return false;
+            }
+            updated.files.push_back(std::move(record));
+        }
+    }
+
+    // Nothing large enough to chunk, so make sure no stale chunk digests are left behind
+    if (updated.files.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(chunk_path, ec);
+        return true;
+    }
+
+    dpm_log(LOG_INFO, ("Recorded chunk digests for " + std::to_string(updated.files.size()) + " large file(s) in " +
+                      CONTENTS_CHUNKS_FILENAME + " (" + std::to_string(reused_records) + " unchanged)").c_str());
+
+    std::filesystem::path temp_path = chunk_path.string() + ".tmp";
+    {
+        std::ofstream chunk_file(temp_path, std::ios::trunc);
+        if (!chunk_file.is_open()) {
+            dpm_log(LOG_ERROR, ("Failed to open chunk manifest for writing: " + temp_path.string()).c_str());
+            return false;
+        }
+
+        chunk_file << CHUNK_MANIFEST_HEADER << "\n";
+        chunk_file << "# algorithm: " << updated.algorithm << "\n";
+        chunk_file << "# chunk_size: " << updated.chunk_size << "\n";
+
+        // Format: root size chunk_count /path, then one chunk digest per line
+        for (const auto& record : updated.files) {
+            chunk_file << record.root << " "
+                       << record.file_size << " "
+                       << record.chunks.size() << " "
+                       << "/" << record.relative_path << "\n";
+            for (const auto& chunk : record.chunks) {
+                chunk_file << chunk << "\n";
+            }
+        }
+
+        if (!chunk_file.good()) {
+            dpm_log(LOG_ERROR, ("Failed to write chunk manifest: " + temp_path.string()).c_str());
+            chunk_file.close();
+            std::filesystem::remove(temp_path);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, chunk_path, ec);
+    if (ec) {
+        dpm_log(LOG_ERROR, ("Failed to update chunk manifest: " + ec.message()).c_str());
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+
+    return true;
+}
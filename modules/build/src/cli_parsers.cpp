@@ -19,6 +19,7 @@ int parse_create_options(int argc, char** argv, BuildOptions& options) {
     bool architecture_provided = false;
     bool os_provided = false;
     bool force_provided = false;
+    bool link_provided = false;
     bool verbose_provided = false;
     bool help_provided = false;
 
@@ -66,6 +67,10 @@ int parse_create_options(int argc, char** argv, BuildOptions& options) {
                 // Parse the boolean value
                 options.force = (value == "true" || value == "1" || value == "yes");
                 force_provided = true;
+            } else if (option == "--link") {
+                // Parse the boolean value
+                options.link = (value == "true" || value == "1" || value == "yes");
+                link_provided = true;
             } else if (option == "--verbose") {
                 // Parse the boolean value
                 options.verbose = (value == "true" || value == "1" || value == "yes");
@@ -90,6 +95,7 @@ int parse_create_options(int argc, char** argv, BuildOptions& options) {
         {"architecture", required_argument, 0, 'a'},
         {"os", required_argument, 0, 'O'},
         {"force", no_argument, 0, 'f'},
+        {"link", no_argument, 0, 'L'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {"dummy", no_argument, 0, 0},  // Add dummy option to prevent getopt errors
@@ -103,7 +109,7 @@ int parse_create_options(int argc, char** argv, BuildOptions& options) {
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long(argc, argv, "o:c:H:n:V:a:O:fvh", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "o:c:H:n:V:a:O:fLvh", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'o':
                 options.output_dir = optarg;
@@ -137,6 +143,10 @@ int parse_create_options(int argc, char** argv, BuildOptions& options) {
                 options.force = true;
                 force_provided = true;
                 break;
+            case 'L':
+                options.link = true;
+                link_provided = true;
+                break;
             case 'v':
                 options.verbose = true;
                 verbose_provided = true;
@@ -171,52 +181,57 @@ int parse_create_options(int argc, char** argv, BuildOptions& options) {
     bool any_options_provided = false;
 
     if (output_dir_provided) {
-        dpm_log(LOG_DEBUG, ("  output_dir=" + options.output_dir).c_str());
+        DPM_LOG(LOG_DEBUG, "  output_dir=", options.output_dir);
         any_options_provided = true;
     }
 
     if (contents_dir_provided) {
-        dpm_log(LOG_DEBUG, ("  contents_dir=" + options.contents_dir).c_str());
+        DPM_LOG(LOG_DEBUG, "  contents_dir=", options.contents_dir);
         any_options_provided = true;
     }
 
     if (hooks_dir_provided) {
-        dpm_log(LOG_DEBUG, ("  hooks_dir=" + options.hooks_dir).c_str());
+        DPM_LOG(LOG_DEBUG, "  hooks_dir=", options.hooks_dir);
         any_options_provided = true;
     }
 
     if (package_name_provided) {
-        dpm_log(LOG_DEBUG, ("  package_name=" + options.package_name).c_str());
+        DPM_LOG(LOG_DEBUG, "  package_name=", options.package_name);
         any_options_provided = true;
     }
 
     if (package_version_provided) {
-        dpm_log(LOG_DEBUG, ("  package_version=" + options.package_version).c_str());
+        DPM_LOG(LOG_DEBUG, "  package_version=", options.package_version);
         any_options_provided = true;
     }
 
     if (architecture_provided) {
-        dpm_log(LOG_DEBUG, ("  architecture=" + options.architecture).c_str());
+        DPM_LOG(LOG_DEBUG, "  architecture=", options.architecture);
         any_options_provided = true;
     }
 
     if (os_provided) {
-        dpm_log(LOG_DEBUG, ("  os=" + options.os).c_str());
+        DPM_LOG(LOG_DEBUG, "  os=", options.os);
         any_options_provided = true;
     }
 
     if (force_provided) {
-        dpm_log(LOG_DEBUG, ("  force=" + std::string(options.force ? "true" : "false")).c_str());
+        DPM_LOG(LOG_DEBUG, "  force=", (options.force ? "true" : "false"));
+        any_options_provided = true;
+    }
+
+    if (link_provided) {
+        DPM_LOG(LOG_DEBUG, "  link=", (options.link ? "true" : "false"));
         any_options_provided = true;
     }
 
     if (verbose_provided) {
-        dpm_log(LOG_DEBUG, ("  verbose=" + std::string(options.verbose ? "true" : "false")).c_str());
+        DPM_LOG(LOG_DEBUG, "  verbose=", (options.verbose ? "true" : "false"));
         any_options_provided = true;
     }
 
     if (help_provided) {
-        dpm_log(LOG_DEBUG, ("  help=" + std::string(options.show_help ? "true" : "false")).c_str());
+        DPM_LOG(LOG_DEBUG, "  help=", (options.show_help ? "true" : "false"));
         any_options_provided = true;
     }
 
@@ -257,6 +272,21 @@ Command parse_command(const char* cmd_str) {
         return CMD_UNSEAL;
     }
 
+    // Check for bench-io command, including when it has additional arguments
+    if (strncmp(cmd_str, "bench-io", 8) == 0) {
+        return CMD_BENCH_IO;
+    }
+
+    // Check for delta command, including when it has additional arguments
+    if (strncmp(cmd_str, "delta", 5) == 0) {
+        return CMD_DELTA;
+    }
+
+    // Check for install command, including when it has additional arguments
+    if (strncmp(cmd_str, "install", 7) == 0) {
+        return CMD_INSTALL;
+    }
+
     // Check if cmd_str is a help option
     if (strcmp(cmd_str, "-h") == 0 || strcmp(cmd_str, "--help") == 0) {
         return CMD_HELP;
@@ -4,6 +4,7 @@ int cmd_metadata(int argc, char** argv) {
     // Parse command line options
     bool force = false;
     bool refresh = false;
+    bool full_rehash = false;
     bool verbose = false;
     bool show_help = false;
     std::string stage_dir = "";
@@ -19,6 +20,8 @@ int cmd_metadata(int argc, char** argv) {
             force = true;
         } else if (arg == "-r" || arg == "--refresh") {
             refresh = true;
+        } else if (arg == "-F" || arg == "--full") {
+            full_rehash = true;
         } else if (arg == "-v" || arg == "--verbose") {
             verbose = true;
         } else if (arg == "-h" || arg == "--help" || arg == "help") {
@@ -66,7 +69,7 @@ int cmd_metadata(int argc, char** argv) {
     // Call the appropriate function based on the refresh flag
     if (refresh) {
         // For refresh mode, we only need the stage directory
-        bool success = metadata_refresh_dynamic_files(stage_dir);
+        bool success = metadata_refresh_dynamic_files(stage_dir, full_rehash);
         if (!success) {
             dpm_log(LOG_ERROR, "Failed to refresh metadata files.");
             return 1;
@@ -136,7 +139,7 @@ int cmd_stage(int argc, char** argv) {
         const char* config_os = dpm_get_config("build", "os");
         if (config_os != nullptr) {
             options.os = config_os;
-            dpm_log(LOG_DEBUG, ("Using build.os from config: " + options.os).c_str());
+            DPM_LOG(LOG_DEBUG, "Using build.os from config: ", options.os);
         } else {
             dpm_log(LOG_ERROR, "Target OS not specified and not found as build.os in configuration.");
             dpm_log(LOG_ERROR, "Please specify OS with --os or set a default at build.os in '/etc/dpm/conf.d/'.");
@@ -153,15 +156,15 @@ int cmd_stage(int argc, char** argv) {
 
     // Log detailed options (only visible in verbose mode)
     dpm_log(LOG_DEBUG, "Staging DPM package with the following options:");
-    dpm_log(LOG_DEBUG, ("  Output directory: " + options.output_dir).c_str());
-    dpm_log(LOG_DEBUG, ("  Contents directory: " + options.contents_dir).c_str());
-    dpm_log(LOG_DEBUG, ("  Package name: " + options.package_name).c_str());
-    dpm_log(LOG_DEBUG, ("  Package version: " + options.package_version).c_str());
-    dpm_log(LOG_DEBUG, ("  Architecture: " + options.architecture).c_str());
-    dpm_log(LOG_DEBUG, ("  OS: " + options.os).c_str());
+    DPM_LOG(LOG_DEBUG, "  Output directory: ", options.output_dir);
+    DPM_LOG(LOG_DEBUG, "  Contents directory: ", options.contents_dir);
+    DPM_LOG(LOG_DEBUG, "  Package name: ", options.package_name);
+    DPM_LOG(LOG_DEBUG, "  Package version: ", options.package_version);
+    DPM_LOG(LOG_DEBUG, "  Architecture: ", options.architecture);
+    DPM_LOG(LOG_DEBUG, "  OS: ", options.os);
 
     if (!options.hooks_dir.empty()) {
-        dpm_log(LOG_DEBUG, ("  Hooks directory: " + options.hooks_dir).c_str());
+        DPM_LOG(LOG_DEBUG, "  Hooks directory: ", options.hooks_dir);
     } else {
         dpm_log(LOG_DEBUG, "  Hooks directory: N/A");
     }
@@ -170,6 +173,10 @@ int cmd_stage(int argc, char** argv) {
         dpm_log(LOG_DEBUG, "  Force: Yes");
     }
 
+    if (options.link) {
+        dpm_log(LOG_DEBUG, "  Link: Yes");
+    }
+
     // Call the build_package_stage function with individual parameters
     return build_package_stage(
         options.output_dir,
@@ -179,7 +186,8 @@ int cmd_stage(int argc, char** argv) {
         options.package_version,
         options.architecture,
         options.os,
-        options.force
+        options.force,
+        options.link
     );
 }
 
@@ -188,6 +196,10 @@ int cmd_sign(int argc, char** argv) {
     std::string key_id = "";
     std::string stage_dir = "";
     std::string package_path = "";
+    std::vector<std::string> stage_lists;
+    std::vector<std::string> package_lists;
+    std::string summary_path = "";
+    int jobs = 0;
     bool force = false;
     bool verbose = false;
     bool show_help = false;
@@ -211,6 +223,26 @@ int cmd_sign(int argc, char** argv) {
                 package_path = argv[i + 1];
                 i++; // Skip the next argument
             }
+        } else if (arg == "-l" || arg == "--stages") {
+            if (i + 1 < argc) {
+                stage_lists.push_back(argv[i + 1]);
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-P" || arg == "--packages") {
+            if (i + 1 < argc) {
+                package_lists.push_back(argv[i + 1]);
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-r" || arg == "--summary") {
+            if (i + 1 < argc) {
+                summary_path = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 < argc) {
+                jobs = atoi(argv[i + 1]);
+                i++; // Skip the next argument
+            }
         } else if (arg == "-f" || arg == "--force") {
             force = true;
         } else if (arg == "-v" || arg == "--verbose") {
@@ -225,6 +257,11 @@ int cmd_sign(int argc, char** argv) {
         return cmd_sign_help(argc, argv);
     }
 
+    if (jobs < 0) {
+        dpm_con(LOG_ERROR, "--jobs must be a positive number");
+        return cmd_sign_help(argc, argv);
+    }
+
     // Set verbose logging if requested
     if (verbose) {
         dpm_set_logging_level(LOG_DEBUG);
@@ -236,6 +273,30 @@ int cmd_sign(int argc, char** argv) {
         return cmd_sign_help(argc, argv);
     }
 
+    // Batch mode signs every listed stage or package with a single key lookup
+    bool batch = !stage_lists.empty() || !package_lists.empty();
+    if (batch) {
+        if (!stage_dir.empty() || !package_path.empty()) {
+            dpm_log(LOG_ERROR, "Cannot combine batch mode (--stages/--packages) with --stage or --package");
+            return cmd_sign_help(argc, argv);
+        }
+        if (!stage_lists.empty() && !package_lists.empty()) {
+            dpm_log(LOG_ERROR, "Cannot specify both a stage list (--stages/-l) and a package list (--packages/-P)");
+            return cmd_sign_help(argc, argv);
+        }
+
+        bool packages = !package_lists.empty();
+        std::vector<std::string> paths;
+        for (const auto& list : packages ? package_lists : stage_lists) {
+            if (read_batch_list(list, paths) != 0) {
+                return 1;
+            }
+        }
+
+        size_t worker_count = jobs > 0 ? static_cast<size_t>(jobs) : batch_worker_count();
+        return sign_batch(paths, packages, key_id, force, worker_count, summary_path);
+    }
+
     // Validate that either stage or package is provided, but not both
     if (stage_dir.empty() && package_path.empty()) {
         dpm_log(LOG_ERROR, "Either a package stage directory (--stage/-s) or a package file (--package/-p) must be specified");
@@ -280,6 +341,9 @@ int cmd_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "  sign       - Sign a package or package stage directory");
     dpm_con(LOG_INFO, "  seal       - Seal a package stage directory into final format");
     dpm_con(LOG_INFO, "  unseal     - Unseal a package back to stage format");
+    dpm_con(LOG_INFO, "  bench-io   - Benchmark checksum I/O strategies on a storage");
+    dpm_con(LOG_INFO, "  delta      - Build a delta package between two package versions");
+    dpm_con(LOG_INFO, "  install    - Install a package into a root directory, verifying as it extracts");
     dpm_con(LOG_INFO, "  help       - Display this help message");
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Usage: dpm build <command>");
@@ -304,6 +368,8 @@ int cmd_metadata_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "Options:");
     dpm_con(LOG_INFO, "  -s, --stage DIR           Package stage directory path (required)");
     dpm_con(LOG_INFO, "  -r, --refresh             Refresh existing metadata (use for updating)");
+    dpm_con(LOG_INFO, "  -F, --full                With --refresh, rehash every file instead of only");
+    dpm_con(LOG_INFO, "                            files changed since the last refresh");
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "For new metadata generation (when not using --refresh):");
     dpm_con(LOG_INFO, "  -n, --name NAME           Package name (required for new generation)");
@@ -319,6 +385,9 @@ int cmd_metadata_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "  # Refresh metadata in an existing package stage:");
     dpm_con(LOG_INFO, "  dpm build metadata --stage=./my-package-1.0.x86_64 --refresh");
     dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "  # Refresh metadata, rehashing every file:");
+    dpm_con(LOG_INFO, "  dpm build metadata --stage=./my-package-1.0.x86_64 --refresh --full");
+    dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "  # Generate new metadata for a package stage:");
     dpm_con(LOG_INFO, "  dpm build metadata --stage=./my-package-1.0.x86_64 --name=my-package --version=1.0 --architecture=x86_64");
     return 0;
@@ -336,6 +405,8 @@ int cmd_stage_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "  -a, --architecture ARCH    Package architecture (required, e.g., x86_64)");
     dpm_con(LOG_INFO, "  -O, --os OS                Package OS (optional, e.g., dhl2)");
     dpm_con(LOG_INFO, "  -f, --force                Force package staging even if warnings occur");
+    dpm_con(LOG_INFO, "  -L, --link                 Hard link the contents into the stage instead of copying them;");
+    dpm_con(LOG_INFO, "                             editing a staged file then edits the source too");
     dpm_con(LOG_INFO, "  -v, --verbose              Enable verbose output");
     dpm_con(LOG_INFO, "  -h, --help                 Display this help message");
     return 0;
@@ -350,15 +421,23 @@ int cmd_sign_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "  -k, --key-id ID          GPG key ID or email to use for signing (required)");
     dpm_con(LOG_INFO, "  -s, --stage DIR          Package stage directory to sign");
     dpm_con(LOG_INFO, "  -p, --package FILE       Package file to sign");
+    dpm_con(LOG_INFO, "  -l, --stages FILE        Sign every stage directory listed in FILE (\"-\" for stdin)");
+    dpm_con(LOG_INFO, "  -P, --packages FILE      Sign every package file listed in FILE (\"-\" for stdin)");
+    dpm_con(LOG_INFO, "  -j, --jobs N             Number of stages or packages signed at once in batch mode");
+    dpm_con(LOG_INFO, "  -r, --summary FILE       Write the batch results to FILE instead of stdout");
     dpm_con(LOG_INFO, "  -f, --force              Force signing even if warnings occur");
     dpm_con(LOG_INFO, "  -v, --verbose            Enable verbose output");
     dpm_con(LOG_INFO, "  -h, --help               Display this help message");
     dpm_con(LOG_INFO, "");
-    dpm_con(LOG_INFO, "Either --stage or --package must be specified, but not both.");
+    dpm_con(LOG_INFO, "Exactly one of --stage, --package, --stages or --packages must be specified.");
+    dpm_con(LOG_INFO, "In batch mode the key is looked up once for every item, items are signed");
+    dpm_con(LOG_INFO, "concurrently within the [build] batch_memory budget, a failure does not stop");
+    dpm_con(LOG_INFO, "the others, and one JSON result line is written per item followed by a summary.");
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Examples:");
     dpm_con(LOG_INFO, "  dpm build sign --key-id=\"user@example.com\" --stage=./my-package-1.0.x86_64");
     dpm_con(LOG_INFO, "  dpm build sign --key-id=\"AB123CD456\" --package=./my-package-1.0.x86_64.dpm");
+    dpm_con(LOG_INFO, "  dpm build sign --key-id=\"AB123CD456\" --packages=release.list --summary=sign.jsonl");
     return 0;
 }
 
@@ -479,9 +558,13 @@ int cmd_seal(int argc, char** argv) {
     // Parse command line options
     std::string stage_dir = "";
     std::string output_dir = "";
+    std::vector<std::string> stage_lists;
+    std::string summary_path = "";
+    int jobs = 0;
     bool force = false;
     bool verbose = false;
     bool finalize = false;
+    bool stream = false;
     bool show_help = false;
 
     // Process command-line arguments
@@ -498,10 +581,27 @@ int cmd_seal(int argc, char** argv) {
                 output_dir = argv[i + 1];
                 i++; // Skip the next argument
             }
+        } else if (arg == "-l" || arg == "--stages") {
+            if (i + 1 < argc) {
+                stage_lists.push_back(argv[i + 1]);
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-r" || arg == "--summary") {
+            if (i + 1 < argc) {
+                summary_path = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 < argc) {
+                jobs = atoi(argv[i + 1]);
+                i++; // Skip the next argument
+            }
         } else if (arg == "-f" || arg == "--force") {
             force = true;
         } else if (arg == "-z" || arg == "--finalize") {
             finalize = true;
+        } else if (arg == "-S" || arg == "--stream") {
+            stream = true;
         } else if (arg == "-v" || arg == "--verbose") {
             verbose = true;
         } else if (arg == "-h" || arg == "--help" || arg == "help") {
@@ -514,6 +614,38 @@ int cmd_seal(int argc, char** argv) {
         return cmd_seal_help(argc, argv);
     }
 
+    if (jobs < 0) {
+        dpm_con(LOG_ERROR, "--jobs must be a positive number");
+        return cmd_seal_help(argc, argv);
+    }
+
+    // Batch mode seals every listed stage in one invocation
+    if (!stage_lists.empty()) {
+        if (!stage_dir.empty()) {
+            dpm_con(LOG_ERROR, "Cannot specify both a stage directory (--stage/-s) and a stage list (--stages/-l)");
+            return cmd_seal_help(argc, argv);
+        }
+
+        if (verbose) {
+            dpm_set_logging_level(LOG_DEBUG);
+        }
+
+        std::vector<std::string> stages;
+        for (const auto& list : stage_lists) {
+            if (read_batch_list(list, stages) != 0) {
+                return 1;
+            }
+        }
+
+        BatchSealMode mode = stream ? BatchSealMode::STREAM
+                                    : (finalize ? BatchSealMode::FINAL : BatchSealMode::COMPONENTS);
+        if (!output_dir.empty()) {
+            output_dir = expand_path(output_dir);
+        }
+        size_t worker_count = jobs > 0 ? static_cast<size_t>(jobs) : batch_worker_count();
+        return seal_stages_batch(stages, mode, output_dir, force, worker_count, summary_path);
+    }
+
     // Validate that stage directory is provided
     if (stage_dir.empty()) {
         dpm_con(LOG_ERROR, "Stage directory is required (--stage/-s)");
@@ -534,8 +666,10 @@ int cmd_seal(int argc, char** argv) {
         dpm_set_logging_level(LOG_DEBUG);
     }
 
-    // Call the appropriate sealing function based on the finalize flag
-    if (finalize) {
+    // Call the appropriate sealing function based on the finalize and stream flags
+    if (stream) {
+        return seal_final_package_streaming(stage_dir, output_dir, force);
+    } else if (finalize) {
         return seal_final_package(stage_dir, output_dir, force);
     } else {
         return seal_stage_components(stage_dir, force);
@@ -546,19 +680,308 @@ int cmd_seal_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "Usage: dpm build seal [options]");
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Seals a package stage directory by replacing contents, metadata,");
-    dpm_con(LOG_INFO, "hooks, and signatures directories with gzipped tarballs.");
+    dpm_con(LOG_INFO, "hooks, and signatures directories with compressed tarballs.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Each component is compressed with the codec set by \"compression_<component>\"");
+    dpm_con(LOG_INFO, "or \"compression\" in the [build] configuration section: none, gzip, gzip-seekable,");
+    dpm_con(LOG_INFO, "zstd or xz, optionally followed by a level, e.g. \"zstd:3\".  The default is gzip.");
+    dpm_con(LOG_INFO, "gzip-seekable lets a single file be read without decompressing the whole component.");
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Options:");
     dpm_con(LOG_INFO, "  -s, --stage DIR         Package stage directory to seal (required)");
     dpm_con(LOG_INFO, "  -o, --output DIR        Output directory for the finalized package (optional)");
-    dpm_con(LOG_INFO, "  -f, --force             Force sealing even if warnings occur");
+    dpm_con(LOG_INFO, "  -f, --force             Force sealing even if warnings occur, and seal a final");
+    dpm_con(LOG_INFO, "                          package again even if its stage is unchanged");
     dpm_con(LOG_INFO, "  -z, --finalize          Also compress the entire stage as a final package");
+    dpm_con(LOG_INFO, "  -S, --stream            Write the final package in one pass, compressing each");
+    dpm_con(LOG_INFO, "                          component straight into it and leaving the stage unsealed");
+    dpm_con(LOG_INFO, "                          (implies --finalize)");
+    dpm_con(LOG_INFO, "  -l, --stages FILE       Seal every stage listed in FILE, one per line (\"-\" for stdin)");
+    dpm_con(LOG_INFO, "  -j, --jobs N            Number of stages sealed at once in batch mode");
+    dpm_con(LOG_INFO, "  -r, --summary FILE      Write the batch results to FILE instead of stdout");
     dpm_con(LOG_INFO, "  -v, --verbose           Enable verbose output");
     dpm_con(LOG_INFO, "  -h, --help              Display this help message");
     dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "In batch mode the stages are sealed concurrently on the shared worker pool,");
+    dpm_con(LOG_INFO, "largest first, with at most [build] batch_memory bytes of stages in flight.");
+    dpm_con(LOG_INFO, "A stage that fails does not stop the others; one JSON result line is written");
+    dpm_con(LOG_INFO, "per stage, in list order, followed by a summary line.");
+    dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Examples:");
     dpm_con(LOG_INFO, "  dpm build seal --stage=./my-package-1.0.x86_64");
     dpm_con(LOG_INFO, "  dpm build seal --stage=./my-package-1.0.x86_64 --finalize");
+    dpm_con(LOG_INFO, "  dpm build seal --stage=./my-package-1.0.x86_64 --stream");
     dpm_con(LOG_INFO, "  dpm build seal --stage=./my-package-1.0.x86_64 --finalize --output=/tmp");
+    dpm_con(LOG_INFO, "  dpm build seal --stages=release.list --stream --output=/srv/repo --summary=seal.jsonl");
+    return 0;
+}
+
+int cmd_bench_io(int argc, char** argv) {
+    // Parse command line options
+    std::string bench_dir = "";
+    std::string size_list = IO_BENCH_DEFAULT_SIZES;
+    int repeat = 3;
+    bool warm = false;
+    bool verbose = false;
+    bool show_help = false;
+
+    // Process command-line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-d" || arg == "--directory") {
+            if (i + 1 < argc) {
+                bench_dir = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-s" || arg == "--sizes") {
+            if (i + 1 < argc) {
+                size_list = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-r" || arg == "--repeat") {
+            if (i + 1 < argc) {
+                repeat = atoi(argv[i + 1]);
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-w" || arg == "--warm") {
+            warm = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "-h" || arg == "--help" || arg == "help") {
+            show_help = true;
+        }
+    }
+
+    // If help was requested, show it and return
+    if (show_help) {
+        return cmd_bench_io_help(argc, argv);
+    }
+
+    // Validate that the benchmark directory is provided
+    if (bench_dir.empty()) {
+        dpm_con(LOG_ERROR, "Benchmark directory is required (--directory/-d)");
+        return cmd_bench_io_help(argc, argv);
+    }
+
+    if (repeat < 1) {
+        dpm_con(LOG_ERROR, "Repeat count must be at least 1 (--repeat/-r)");
+        return cmd_bench_io_help(argc, argv);
+    }
+
+    std::vector<uint64_t> sizes;
+    if (!io_bench_parse_sizes(size_list, sizes)) {
+        dpm_con(LOG_ERROR, ("Invalid size list: " + size_list).c_str());
+        return cmd_bench_io_help(argc, argv);
+    }
+
+    // Expand path if needed
+    bench_dir = expand_path(bench_dir);
+
+    // Set verbose logging if requested
+    if (verbose) {
+        dpm_set_logging_level(LOG_DEBUG);
+    }
+
+    return run_checksum_io_benchmark(bench_dir, sizes, repeat, warm);
+}
+
+int cmd_bench_io_help(int argc, char** argv) {
+    dpm_con(LOG_INFO, "Usage: dpm build bench-io [options]");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Hashes generated files of increasing size with each checksum I/O strategy");
+    dpm_con(LOG_INFO, "(single read, positional reads, memory map) and reports their throughput");
+    dpm_con(LOG_INFO, "along with suggested [build] checksum_small_file_max and checksum_mmap_min");
+    dpm_con(LOG_INFO, "values for the storage benchmarked.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Options:");
+    dpm_con(LOG_INFO, "  -d, --directory DIR     Directory on the storage to benchmark (required)");
+    dpm_con(LOG_INFO, "  -s, --sizes LIST        Comma separated file sizes, K/M/G suffixes allowed");
+    dpm_con(LOG_INFO, "                          (default: " IO_BENCH_DEFAULT_SIZES ")");
+    dpm_con(LOG_INFO, "  -r, --repeat N          Timed passes per size and strategy, best is kept (default: 3)");
+    dpm_con(LOG_INFO, "  -w, --warm              Keep files in the page cache instead of dropping them");
+    dpm_con(LOG_INFO, "  -v, --verbose           Enable verbose output");
+    dpm_con(LOG_INFO, "  -h, --help              Display this help message");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Examples:");
+    dpm_con(LOG_INFO, "  dpm build bench-io --directory /var/tmp");
+    dpm_con(LOG_INFO, "  dpm build bench-io --directory /srv/build --sizes 64K,1M,16M,256M,1G --repeat 5");
+    return 0;
+}
+
+int cmd_delta(int argc, char** argv) {
+    // Parse command line options
+    std::string from_package = "";
+    std::string to_package = "";
+    std::string output_dir = "";
+    bool force = false;
+    bool verbose = false;
+    bool show_help = false;
+
+    // Process command-line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--from") {
+            if (i + 1 < argc) {
+                from_package = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "--to") {
+            if (i + 1 < argc) {
+                to_package = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-o" || arg == "--output") {
+            if (i + 1 < argc) {
+                output_dir = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-f" || arg == "--force") {
+            force = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "-h" || arg == "--help" || arg == "help") {
+            show_help = true;
+        }
+    }
+
+    // If help was requested, show it and return
+    if (show_help) {
+        return cmd_delta_help(argc, argv);
+    }
+
+    // Validate that both packages are provided
+    if (from_package.empty() || to_package.empty()) {
+        dpm_con(LOG_ERROR, "Both packages are required (--from and --to)");
+        return cmd_delta_help(argc, argv);
+    }
+
+    // Expand paths if needed
+    from_package = expand_path(from_package);
+    to_package = expand_path(to_package);
+    if (!output_dir.empty()) {
+        output_dir = expand_path(output_dir);
+    }
+
+    // Check that both packages exist
+    for (const std::string& package : { from_package, to_package }) {
+        if (!std::filesystem::is_regular_file(package)) {
+            dpm_con(LOG_ERROR, ("Package does not exist: " + package).c_str());
+            return 1;
+        }
+    }
+
+    // Set verbose logging if requested
+    if (verbose) {
+        dpm_set_logging_level(LOG_DEBUG);
+    }
+
+    return build_delta_package(from_package, to_package, output_dir, force);
+}
+
+int cmd_delta_help(int argc, char** argv) {
+    dpm_con(LOG_INFO, "Usage: dpm build delta --from OLD.dpm --to NEW.dpm [options]");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Builds a delta package from two versions of a package by comparing their");
+    dpm_con(LOG_INFO, "contents manifests.  The delta holds only the files that are new or changed in");
+    dpm_con(LOG_INFO, "NEW, lists the files removed since OLD, and records the digests of both packages");
+    dpm_con(LOG_INFO, "and the full manifest of NEW.  It is written as NEW's name followed by");
+    dpm_con(LOG_INFO, "\".delta-<OLD version>.dpm\" and is verified like any other package.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Options:");
+    dpm_con(LOG_INFO, "  --from FILE             Package the delta applies to (required)");
+    dpm_con(LOG_INFO, "  --to FILE               Package the delta produces (required)");
+    dpm_con(LOG_INFO, "  -o, --output DIR        Output directory for the delta (default: NEW's directory)");
+    dpm_con(LOG_INFO, "  -f, --force             Overwrite an existing delta");
+    dpm_con(LOG_INFO, "  -v, --verbose           Enable verbose output");
+    dpm_con(LOG_INFO, "  -h, --help              Display this help message");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Examples:");
+    dpm_con(LOG_INFO, "  dpm build delta --from ./my-package-1.0.x86_64.dpm --to ./my-package-1.1.x86_64.dpm");
+    dpm_con(LOG_INFO, "  dpm build delta --from ./old.dpm --to ./new.dpm --output /tmp --force");
+    return 0;
+}
+
+int cmd_install(int argc, char** argv) {
+    // Parse command line options
+    std::string package_path = "";
+    std::string root_dir = "";
+    bool force = false;
+    bool verbose = false;
+    bool show_help = false;
+
+    // Process command-line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-p" || arg == "--package") {
+            if (i + 1 < argc) {
+                package_path = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-r" || arg == "--root") {
+            if (i + 1 < argc) {
+                root_dir = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-f" || arg == "--force") {
+            force = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "-h" || arg == "--help" || arg == "help") {
+            show_help = true;
+        }
+    }
+
+    // If help was requested, show it and return
+    if (show_help) {
+        return cmd_install_help(argc, argv);
+    }
+
+    // Validate that the package and root are provided
+    if (package_path.empty() || root_dir.empty()) {
+        dpm_con(LOG_ERROR, "Both a package (--package) and a root directory (--root) are required");
+        return cmd_install_help(argc, argv);
+    }
+
+    // Expand paths if needed
+    package_path = expand_path(package_path);
+    root_dir = expand_path(root_dir);
+
+    if (!std::filesystem::is_regular_file(package_path)) {
+        dpm_con(LOG_ERROR, ("Package does not exist: " + package_path).c_str());
+        return 1;
+    }
+
+    // Set verbose logging if requested
+    if (verbose) {
+        dpm_set_logging_level(LOG_DEBUG);
+    }
+
+    return install_package(package_path, root_dir, force);
+}
+
+int cmd_install_help(int argc, char** argv) {
+    dpm_con(LOG_INFO, "Usage: dpm build install --package FILE --root DIR [options]");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Installs the contents of a package into DIR in a single pass.  Every file is hashed");
+    dpm_con(LOG_INFO, "while it is extracted and only given a name once it matches the contents manifest,");
+    dpm_con(LOG_INFO, "and nothing in DIR is replaced until the whole package has been verified.  The");
+    dpm_con(LOG_INFO, "package digest is checked against the manifest first; signatures are checked by");
+    dpm_con(LOG_INFO, "\"dpm verify\".");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Options:");
+    dpm_con(LOG_INFO, "  -p, --package FILE      Package to install (required)");
+    dpm_con(LOG_INFO, "  -r, --root DIR          Directory to install into (required)");
+    dpm_con(LOG_INFO, "  -f, --force             Replace files that already exist in DIR");
+    dpm_con(LOG_INFO, "  -v, --verbose           Enable verbose output");
+    dpm_con(LOG_INFO, "  -h, --help              Display this help message");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Files get the permissions the manifest records, and its ownership when run as root.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Examples:");
+    dpm_con(LOG_INFO, "  dpm build install --package ./my-package-1.0.x86_64.dpm --root /");
+    dpm_con(LOG_INFO, "  dpm build install --package ./my-package-1.0.x86_64.dpm --root /mnt/sysroot --force");
     return 0;
 }
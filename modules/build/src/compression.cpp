@@ -0,0 +1,218 @@
+/**
+ * @file compression.cpp
+ * @brief Implementation of the component compression codecs
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "compression.hpp"
+#include "frame_index.hpp"
+
+// highest level each codec accepts, zstd's ultra levels need extra memory to decompress
+static int compression_max_level(CompressionCodec codec)
+{
+    switch (codec) {
+        case CompressionCodec::GZIP:
+        case CompressionCodec::GZIP_SEEKABLE:
+            return 9;
+        case CompressionCodec::ZSTD:
+            return 19;
+        case CompressionCodec::XZ:
+            return 9;
+        default:
+            return 0;
+    }
+}
+
+const char* compression_codec_name(CompressionCodec codec)
+{
+    switch (codec) {
+        case CompressionCodec::NONE:
+            return "none";
+        case CompressionCodec::GZIP:
+            return "gzip";
+        case CompressionCodec::GZIP_SEEKABLE:
+            return "gzip-seekable";
+        case CompressionCodec::ZSTD:
+            return "zstd";
+        case CompressionCodec::XZ:
+            return "xz";
+        default:
+            return "unknown";
+    }
+}
+
+bool compression_parse_settings(const std::string& value, CompressionSettings& settings)
+{
+    std::string name = value;
+    std::string level;
+    size_t colon = value.find(':');
+    if (colon != std::string::npos) {
+        name = value.substr(0, colon);
+        level = value.substr(colon + 1);
+    }
+
+    CompressionSettings parsed = { CompressionCodec::UNKNOWN, 0 };
+    if (name == "none") {
+        parsed.codec = CompressionCodec::NONE;
+    } else if (name == "gzip") {
+        parsed.codec = CompressionCodec::GZIP;
+    } else if (name == "gzip-seekable") {
+        parsed.codec = CompressionCodec::GZIP_SEEKABLE;
+    } else if (name == "zstd") {
+        parsed.codec = CompressionCodec::ZSTD;
+    } else if (name == "xz") {
+        parsed.codec = CompressionCodec::XZ;
+    } else {
+        return false;
+    }
+
+    if (colon != std::string::npos) {
+        char* end = nullptr;
+        long number = strtol(level.c_str(), &end, 10);
+        if (level.empty() || *end != '\0' || number < 1 || number > compression_max_level(parsed.codec)) {
+            return false;
+        }
+        parsed.level = static_cast<int>(number);
+    }
+
+    settings = parsed;
+    return true;
+}
+
+CompressionSettings compression_for_component(const std::string& component)
+{
+    const std::string keys[] = { "compression_" + component, "compression" };
+    for (const auto& key : keys) {
+        const char* configured = dpm_get_config("build", key.c_str());
+        if (!configured || strlen(configured) == 0) {
+            continue;
+        }
+
+        CompressionSettings settings;
+        if (compression_parse_settings(configured, settings)) {
+            return settings;
+        }
+        dpm_log(LOG_WARN, ("Ignoring invalid [build] " + key + " value: " + std::string(configured)).c_str());
+    }
+
+    return { CompressionCodec::GZIP, 0 };
+}
+
+CompressionCodec compression_detect(const unsigned char* data, size_t size)
+{
+    static const unsigned char zstd_magic[] = { 0x28, 0xB5, 0x2F, 0xFD };
+    static const unsigned char xz_magic[] = { 0xFD, '7', 'z', 'X', 'Z', 0x00 };
+
+    if (size >= 2 && data[0] == 0x1F && data[1] == 0x8B) {
+        return CompressionCodec::GZIP;
+    }
+    if (size >= sizeof(zstd_magic) && memcmp(data, zstd_magic, sizeof(zstd_magic)) == 0) {
+        return CompressionCodec::ZSTD;
+    }
+    if (size >= sizeof(xz_magic) && memcmp(data, xz_magic, sizeof(xz_magic)) == 0) {
+        return CompressionCodec::XZ;
+    }
+
+    // an uncompressed tar carries "ustar" in the first header block
+    if (size >= 262 && memcmp(data + 257, "ustar", 5) == 0) {
+        return CompressionCodec::NONE;
+    }
+
+    return CompressionCodec::UNKNOWN;
+}
+
+CompressionCodec compression_detect_file(const std::filesystem::path& path)
+{
+    if (!std::filesystem::is_regular_file(path)) {
+        return CompressionCodec::UNKNOWN;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return CompressionCodec::UNKNOWN;
+    }
+
+    unsigned char header[512];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    CompressionCodec codec = compression_detect(header, static_cast<size_t>(file.gcount()));
+
+    // a seekable gzip component is told apart by the footer at its end
+    if (codec == CompressionCodec::GZIP) {
+        unsigned char footer[FRAME_INDEX_FOOTER_SIZE];
+        file.clear();
+        file.seekg(-static_cast<std::streamoff>(sizeof(footer)), std::ios::end);
+        file.read(reinterpret_cast<char*>(footer), sizeof(footer));
+        if (file.gcount() == static_cast<std::streamsize>(sizeof(footer)) &&
+            frame_index_has_footer(footer, sizeof(footer))) {
+            codec = CompressionCodec::GZIP_SEEKABLE;
+        }
+    }
+    return codec;
+}
+
+void compression_read_support(struct archive* a)
+{
+    archive_read_support_filter_gzip(a);
+    archive_read_support_filter_zstd(a);
+    archive_read_support_filter_xz(a);
+}
+
+// applies an option to the filter just added, an old libarchive without it still compresses correctly
+static void compression_set_option(struct archive* a, const char* option, const std::string& value)
+{
+    if (archive_write_set_filter_option(a, NULL, option, value.c_str()) < ARCHIVE_WARN) {
+        const char* error = archive_error_string(a);
+        DPM_LOG(LOG_DEBUG, "Compression option ", option, "=", value, " not supported: ",
+                (error ? error : "unknown error"));
+    }
+}
+
+bool compression_write_filter(struct archive* a, const CompressionSettings& settings, size_t thread_count)
+{
+    int result;
+    switch (settings.codec) {
+        case CompressionCodec::NONE:
+            result = archive_write_add_filter_none(a);
+            break;
+        case CompressionCodec::GZIP:
+        case CompressionCodec::GZIP_SEEKABLE:
+            // frames are only cut by ParallelGzipWriter, libarchive writes one member
+            result = archive_write_add_filter_gzip(a);
+            break;
+        case CompressionCodec::ZSTD:
+            result = archive_write_add_filter_zstd(a);
+            break;
+        case CompressionCodec::XZ:
+            result = archive_write_add_filter_xz(a);
+            break;
+        default:
+            dpm_log(LOG_ERROR, "Unknown compression codec");
+            return false;
+    }
+
+    // ARCHIVE_WARN means libarchive falls back to the codec's external program
+    if (result < ARCHIVE_WARN) {
+        const char* error = archive_error_string(a);
+        dpm_log(LOG_ERROR, ("Failed to enable " + std::string(compression_codec_name(settings.codec)) +
+                           " compression: " + std::string(error ? error : "unknown error")).c_str());
+        return false;
+    }
+
+    if (settings.codec == CompressionCodec::NONE) {
+        return true;
+    }
+
+    if (settings.level > 0) {
+        compression_set_option(a, "compression-level", std::to_string(settings.level));
+    }
+
+    if ((settings.codec == CompressionCodec::ZSTD || settings.codec == CompressionCodec::XZ) && thread_count > 1) {
+        compression_set_option(a, "threads", std::to_string(thread_count));
+    }
+
+    return true;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file content_store.cpp
+ * @brief Implementation of the content-addressed store
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "content_store.hpp"
+
+ContentStore::ContentStore()
+    : _min_size(CONTENT_STORE_DEFAULT_MIN_SIZE)
+{
+}
+
+bool ContentStore::open_configured()
+{
+    const char* configured = dpm_get_config("build", "content_store");
+    if (!configured || strlen(configured) == 0) {
+        return false;
+    }
+
+    _root = configured;
+    _algorithm = get_configured_hash_algorithm();
+
+    const char* min_size = dpm_get_config("build", "content_store_min");
+    if (min_size && strlen(min_size) > 0) {
+        char* end = nullptr;
+        errno = 0;
+        unsigned long long value = strtoull(min_size, &end, 10);
+        if (errno != 0 || end == min_size || *end != '\0') {
+            dpm_log(LOG_WARN, ("Ignoring invalid [build] content_store_min value: " + std::string(min_size)).c_str());
+        } else {
+            _min_size = static_cast<uint64_t>(value);
+        }
+    }
+
+    DPM_LOG(LOG_DEBUG, "Using the content store at ", _root.string());
+    return true;
+}
+
+bool ContentStore::is_open() const
+{
+    return !_root.empty();
+}
+
+uint64_t ContentStore::min_size() const
+{
+    return _min_size;
+}
+
+const std::string& ContentStore::algorithm() const
+{
+    return _algorithm;
+}
+
+std::filesystem::path ContentStore::object_path(const std::string& checksum, mode_t mode) const
+{
+    char mode_text[8];
+    snprintf(mode_text, sizeof(mode_text), "%04o", static_cast<unsigned int>(mode & 07777));
+    return _root / "objects" / _algorithm / checksum.substr(0, 2) / (checksum + "-" + mode_text);
+}
+
+std::filesystem::path ContentStore::frame_path(const std::string& codec, const std::string& checksum) const
+{
+    return _root / "frames" / codec / _algorithm / checksum.substr(0, 2) / (checksum + ".gz");
+}
+
+std::filesystem::path ContentStore::temporary_path(const std::filesystem::path& entry) const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(entry.parent_path(), ec);
+    if (ec) {
+        dpm_log(LOG_WARN, ("Failed to create content store directory " + entry.parent_path().string() + ": " +
+                           ec.message()).c_str());
+        return {};
+    }
+
+    size_t thread_id = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return entry.string() + ".tmp." + std::to_string(getpid()) + "." + std::to_string(thread_id);
+}
+
+bool ContentStore::load_frame(const std::string& codec, const std::string& checksum, uint64_t size,
+                              std::vector<unsigned char>& member) const
+{
+    std::ifstream file(frame_path(codec, checksum), std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::streamsize frame_size = file.tellg();
+    if (frame_size < 18) {
+        return false;
+    }
+
+    member.resize(static_cast<size_t>(frame_size));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(member.data()), frame_size)) {
+        return false;
+    }
+
+    // a gzip member whose trailer records the size it decompresses to, modulo 2^32
+    uint32_t recorded_size = 0;
+    for (int i = 0; i < 4; i++) {
+        recorded_size |= static_cast<uint32_t>(member[member.size() - 4 + i]) << (8 * i);
+    }
+    return member[0] == 0x1f && member[1] == 0x8b && recorded_size == static_cast<uint32_t>(size);
+}
+
+bool ContentStore::save_frame(const std::string& codec, const std::string& checksum,
+                              const std::vector<unsigned char>& member) const
+{
+    std::filesystem::path path = frame_path(codec, checksum);
+    std::filesystem::path temporary = temporary_path(path);
+    if (temporary.empty()) {
+        return false;
+    }
+
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(member.data()), static_cast<std::streamsize>(member.size()));
+        if (!file) {
+            dpm_log(LOG_WARN, ("Failed to write content store frame: " + temporary.string()).c_str());
+            file.close();
+            std::filesystem::remove(temporary);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        dpm_log(LOG_WARN, ("Failed to store content store frame " + path.string() + ": " + ec.message()).c_str());
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
+
+void ContentStore::discard_frame(const std::string& codec, const std::string& checksum) const
+{
+    std::error_code ec;
+    std::filesystem::remove(frame_path(codec, checksum), ec);
+}
@@ -0,0 +1,346 @@
+/**
+ * @file delta.cpp
+ * @brief Implementation of delta packages between two versions of a package
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "delta.hpp"
+
+/**
+ * @brief One entry of a contents manifest, as compared between packages
+ */
+struct DeltaManifestEntry {
+    std::string line;           ///< Manifest line as written
+    char control;               ///< Control designation
+    std::string checksum;       ///< Checksum of the file
+    std::string permissions;    ///< Octal permission bits
+    std::string ownership;      ///< owner:group
+};
+
+/**
+ * @brief The metadata fields of a package a delta is built from
+ */
+struct DeltaPackageMetadata {
+    std::string manifest;       ///< CONTENTS_MANIFEST_DIGEST
+    std::string package_digest; ///< PACKAGE_DIGEST
+    std::string version;        ///< VERSION, empty if the package has none
+};
+
+static std::string delta_trim(const std::string& value)
+{
+    size_t start = value.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(" \t\r\n");
+    return value.substr(start, end - start + 1);
+}
+
+// reads the rest of the current entry of an archive iterator
+static bool delta_read_entry(void* iterator, std::string& value)
+{
+    value.clear();
+    char buffer[PACKAGE_STREAM_BLOCK_SIZE];
+    long long bytes_read;
+    while ((bytes_read = archive_iterator_read(iterator, buffer, sizeof(buffer))) > 0) {
+        value.append(buffer, static_cast<size_t>(bytes_read));
+    }
+    return bytes_read == 0;
+}
+
+// reads the metadata fields a delta needs in one pass over the package's metadata component
+static bool delta_read_package_metadata(const std::string& package_path, DeltaPackageMetadata& metadata)
+{
+    void* iterator = archive_iterator_open_package_component(package_path.c_str(), "metadata");
+    if (!iterator) {
+        dpm_log(LOG_ERROR, ("Failed to read the metadata component of package: " + package_path).c_str());
+        return false;
+    }
+
+    bool has_manifest = false;
+    bool has_package_digest = false;
+    bool result = true;
+    archive_iterator_entry entry;
+    int r = 0;
+    while (result && (r = archive_iterator_next(iterator, &entry)) == 1) {
+        if ((entry.mode & S_IFMT) != S_IFREG) {
+            continue;
+        }
+
+        std::string* field = nullptr;
+        if (strcmp(entry.path, "CONTENTS_MANIFEST_DIGEST") == 0) {
+            field = &metadata.manifest;
+            has_manifest = true;
+        } else if (strcmp(entry.path, "PACKAGE_DIGEST") == 0) {
+            field = &metadata.package_digest;
+            has_package_digest = true;
+        } else if (strcmp(entry.path, "VERSION") == 0) {
+            field = &metadata.version;
+        }
+
+        if (field && !delta_read_entry(iterator, *field)) {
+            result = false;
+        }
+    }
+    archive_iterator_close(iterator);
+
+    if (!result || r < 0) {
+        dpm_log(LOG_ERROR, ("Failed to read the metadata component of package: " + package_path).c_str());
+        return false;
+    }
+    if (!has_manifest) {
+        dpm_log(LOG_ERROR, ("Package has no CONTENTS_MANIFEST_DIGEST: " + package_path).c_str());
+        return false;
+    }
+    if (!has_package_digest) {
+        dpm_log(LOG_ERROR, ("Package has no PACKAGE_DIGEST: " + package_path).c_str());
+        return false;
+    }
+
+    metadata.version = delta_trim(metadata.version);
+    return true;
+}
+
+// parses a manifest into its entries keyed by path without the leading slash
+static bool delta_parse_manifest(const std::string& manifest, const std::string& package_path,
+                                 std::vector<std::string>& order,
+                                 std::map<std::string, DeltaManifestEntry>& entries)
+{
+    std::string_view remaining(manifest);
+    std::string_view line;
+    size_t line_number = 0;
+    size_t digest_length = manifest_digest_length(get_configured_hash_algorithm());
+    while (manifest_next_line(remaining, line)) {
+        line_number++;
+        if (line.empty()) {
+            continue;
+        }
+
+        ManifestLine manifest_line;
+        if (!manifest_parse_line(line, manifest_line, digest_length)) {
+            dpm_log(LOG_ERROR, ("Malformed line " + std::to_string(line_number) + " in the manifest of " +
+                                package_path).c_str());
+            return false;
+        }
+        std::string path(manifest_relative_path(manifest_line.path));
+
+        DeltaManifestEntry entry;
+        entry.line = line;
+        entry.control = manifest_line.control;
+        entry.checksum = manifest_line.checksum;
+        entry.permissions = manifest_line.permissions;
+        entry.ownership = manifest_line.ownership;
+
+        if (!entries.emplace(path, std::move(entry)).second) {
+            dpm_log(LOG_ERROR, ("Duplicate path " + path + " in the manifest of " + package_path).c_str());
+            return false;
+        }
+        order.push_back(path);
+    }
+    return true;
+}
+
+static bool delta_entry_unchanged(const DeltaManifestEntry& from, const DeltaManifestEntry& to)
+{
+    return from.control == to.control && from.checksum == to.checksum &&
+           from.permissions == to.permissions && from.ownership == to.ownership;
+}
+
+// removes every file of the contents directory that is not kept, and the directories this empties
+static bool delta_prune_contents(const std::filesystem::path& contents_dir, const std::set<std::string>& kept)
+{
+    std::vector<std::filesystem::path> pruned;
+    std::set<std::filesystem::path> touched_directories;
+
+    try {
+        for (auto it = std::filesystem::recursive_directory_iterator(contents_dir);
+             it != std::filesystem::recursive_directory_iterator(); ++it) {
+            if (it->is_directory() && !it->is_symlink()) {
+                continue;
+            }
+
+            std::string relative_path = std::filesystem::relative(it->path(), contents_dir).generic_string();
+            if (kept.count(relative_path) == 0) {
+                pruned.push_back(it->path());
+            }
+        }
+
+        for (const auto& path : pruned) {
+            std::filesystem::remove(path);
+            for (auto parent = path.parent_path(); parent != contents_dir && parent.has_relative_path();
+                 parent = parent.parent_path()) {
+                touched_directories.insert(parent);
+            }
+        }
+
+        // deepest first, so a directory is only looked at once its subdirectories are gone
+        std::vector<std::filesystem::path> directories(touched_directories.begin(), touched_directories.end());
+        std::sort(directories.begin(), directories.end(), [](const auto& a, const auto& b) {
+            return a.string().size() > b.string().size();
+        });
+        for (const auto& directory : directories) {
+            if (std::filesystem::is_empty(directory)) {
+                std::filesystem::remove(directory);
+            }
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        dpm_log(LOG_ERROR, ("Failed to prune delta contents: " + std::string(e.what())).c_str());
+        return false;
+    }
+
+    DPM_LOG(LOG_DEBUG, "Pruned ", pruned.size(), " unchanged file(s) from the delta");
+    return true;
+}
+
+// builds the delta stage from an unsealed copy of the target
+static int delta_prepare_stage(const std::filesystem::path& stage_path, const DeltaPackageMetadata& from,
+                               const DeltaPackageMetadata& to, const std::string& from_package,
+                               const std::string& to_package)
+{
+    std::vector<std::string> from_order;
+    std::vector<std::string> to_order;
+    std::map<std::string, DeltaManifestEntry> from_entries;
+    std::map<std::string, DeltaManifestEntry> to_entries;
+    if (!delta_parse_manifest(from.manifest, from_package, from_order, from_entries) ||
+        !delta_parse_manifest(to.manifest, to_package, to_order, to_entries)) {
+        return 1;
+    }
+
+    std::set<std::string> kept;
+    std::string delta_manifest;
+    size_t added = 0;
+    size_t changed = 0;
+    for (const auto& path : to_order) {
+        const DeltaManifestEntry& entry = to_entries.at(path);
+        auto previous = from_entries.find(path);
+        if (previous != from_entries.end() && delta_entry_unchanged(previous->second, entry)) {
+            continue;
+        }
+
+        if (previous == from_entries.end()) {
+            added++;
+        } else {
+            changed++;
+        }
+        kept.insert(path);
+        delta_manifest += entry.line + "\n";
+    }
+
+    std::string removed;
+    size_t removed_count = 0;
+    for (const auto& path : from_order) {
+        if (to_entries.count(path) == 0) {
+            removed += "/" + path + "\n";
+            removed_count++;
+        }
+    }
+
+    dpm_log(LOG_INFO, ("Delta carries " + std::to_string(added) + " added and " + std::to_string(changed) +
+                       " changed file(s), removes " + std::to_string(removed_count) + " and leaves " +
+                       std::to_string(to_order.size() - added - changed) + " unchanged").c_str());
+
+    if (!delta_prune_contents(stage_path / "contents", kept)) {
+        return 1;
+    }
+
+    // the signatures of the target do not cover the delta's components, it is signed on its own
+    try {
+        std::filesystem::remove_all(stage_path / "signatures");
+        std::filesystem::create_directory(stage_path / "signatures");
+    } catch (const std::filesystem::filesystem_error& e) {
+        dpm_log(LOG_ERROR, ("Failed to clear delta signatures: " + std::string(e.what())).c_str());
+        return 1;
+    }
+
+    MetadataTransaction transaction(stage_path);
+    transaction.set("CONTENTS_MANIFEST_DIGEST", delta_manifest);
+    transaction.set(DELTA_BASE_DIGEST_FILENAME, from.package_digest);
+    transaction.set(DELTA_TARGET_DIGEST_FILENAME, to.package_digest);
+    transaction.set(DELTA_TARGET_MANIFEST_FILENAME, to.manifest);
+    transaction.set(DELTA_REMOVED_FILENAME, removed);
+
+    // these describe files that are no longer in the stage, sealing writes them again for the delta
+    transaction.remove(CONTENTS_MANIFEST_INDEX_FILENAME);
+    transaction.remove(CONTENTS_CHUNKS_FILENAME);
+    transaction.remove(CONTENTS_EXTRA_DIGESTS_FILENAME);
+
+    return transaction.commit() ? 0 : 1;
+}
+
+extern "C" int build_delta_package(const std::string& from_package, const std::string& to_package,
+                                   const std::string& output_dir, bool force)
+{
+    dpm_log(LOG_INFO, ("Building delta from " + from_package + " to " + to_package).c_str());
+
+    const std::string dpm_extension = ".dpm";
+    std::string to_filename = std::filesystem::path(to_package).filename().string();
+    if (!to_filename.ends_with(dpm_extension) ||
+        !std::filesystem::path(from_package).filename().string().ends_with(dpm_extension)) {
+        dpm_log(LOG_ERROR, "Refusing to build delta: packages must have .dpm extension");
+        return 1;
+    }
+
+    DeltaPackageMetadata from;
+    DeltaPackageMetadata to;
+    if (!delta_read_package_metadata(from_package, from) || !delta_read_package_metadata(to_package, to)) {
+        return 1;
+    }
+
+    // name the delta after the target and the version it applies to
+    std::string base_name = from.version;
+    if (base_name.empty()) {
+        base_name = delta_trim(from.package_digest).substr(0, 12);
+    }
+    std::string to_stage_name = to_filename.substr(0, to_filename.length() - dpm_extension.length());
+    std::string delta_name = to_stage_name + ".delta-" + base_name;
+
+    std::filesystem::path output_directory = output_dir.empty()
+        ? std::filesystem::path(to_package).parent_path()
+        : std::filesystem::path(output_dir);
+    if (output_directory.empty()) {
+        output_directory = ".";
+    }
+
+    std::filesystem::path delta_package = output_directory / (delta_name + dpm_extension);
+    if (std::filesystem::exists(delta_package) && !force) {
+        dpm_log(LOG_ERROR, ("Delta package already exists: " + delta_package.string() +
+                            ". Use --force to overwrite.").c_str());
+        return 1;
+    }
+
+    std::filesystem::path work_dir = output_directory / ("." + delta_name + ".work");
+    std::filesystem::path stage_path = work_dir / delta_name;
+    int result = unseal_package(to_package, work_dir.string(), true);
+    if (result == 0) {
+        result = unseal_stage_components(work_dir / to_stage_name);
+    }
+    if (result == 0) {
+        std::error_code ec;
+        std::filesystem::rename(work_dir / to_stage_name, stage_path, ec);
+        if (ec) {
+            dpm_log(LOG_ERROR, ("Failed to prepare delta stage: " + ec.message()).c_str());
+            result = 1;
+        }
+    }
+    if (result == 0) {
+        result = delta_prepare_stage(stage_path, from, to, from_package, to_package);
+    }
+    if (result == 0) {
+        result = seal_final_package_streaming(stage_path.string(), output_directory.string(), true);
+    }
+
+    std::error_code cleanup_error;
+    std::filesystem::remove_all(work_dir, cleanup_error);
+
+    if (result != 0) {
+        dpm_log(LOG_ERROR, "Failed to build delta package");
+        return result;
+    }
+
+    dpm_log(LOG_INFO, ("Delta package written to: " + delta_package.string()).c_str());
+    return 0;
+}
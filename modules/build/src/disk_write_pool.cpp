@@ -0,0 +1,142 @@
+/**
+ * @file disk_write_pool.cpp
+ * @brief Implementation of the archive extraction writer pool
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "disk_write_pool.hpp"
+
+size_t disk_write_pool_worker_count()
+{
+    return build_thread_share(build_config_thread_count("extract_threads", dpm_worker_threads()));
+}
+
+DiskWritePool::DiskWritePool(size_t worker_count, int flags)
+    : _queued_bytes(0), _busy(0), _stopping(false), _failed(false)
+{
+    worker_count = std::max<size_t>(1, worker_count);
+    for (size_t i = 0; i < worker_count; i++) {
+        struct archive* ext = archive_write_disk_new();
+        archive_write_disk_set_options(ext, flags);
+        archive_write_disk_set_standard_lookup(ext);
+        _writers.push_back(ext);
+    }
+    for (struct archive* ext : _writers) {
+        _workers.emplace_back(&DiskWritePool::worker_loop, this, ext);
+    }
+}
+
+DiskWritePool::~DiskWritePool()
+{
+    stop(true);
+    for (auto& job : _queue) {
+        archive_entry_free(job.entry);
+    }
+    for (struct archive* ext : _writers) {
+        archive_write_free(ext);
+    }
+}
+
+void DiskWritePool::stop(bool discard)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+
+        // workers give up on whatever is still queued when they see a failure
+        if (discard) {
+            _failed = true;
+        }
+    }
+    _state_changed.notify_all();
+    for (auto& worker : _workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+bool DiskWritePool::submit(struct archive_entry* entry, std::vector<unsigned char> data)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // an empty queue always takes the next entry, however large
+    _state_changed.wait(lock, [&] {
+        return _failed || _queue.empty() || _queued_bytes + data.size() <= DISK_WRITE_POOL_MEMORY_LIMIT;
+    });
+    if (_failed) {
+        archive_entry_free(entry);
+        return false;
+    }
+
+    _queued_bytes += data.size();
+    _queue.push_back({ entry, std::move(data) });
+    lock.unlock();
+
+    _state_changed.notify_all();
+    return true;
+}
+
+bool DiskWritePool::drain()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _state_changed.wait(lock, [&] { return _failed || (_queue.empty() && _busy == 0); });
+    return !_failed;
+}
+
+bool DiskWritePool::finish()
+{
+    bool written = drain();
+    stop(false);
+
+    for (struct archive* ext : _writers) {
+        if (archive_write_close(ext) != ARCHIVE_OK) {
+            dpm_log(LOG_ERROR, ("Archive close error: " + std::string(archive_error_string(ext))).c_str());
+            written = false;
+        }
+    }
+    return written;
+}
+
+void DiskWritePool::worker_loop(struct archive* ext)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _state_changed.wait(lock, [&] { return _stopping || _failed || !_queue.empty(); });
+        if (_failed || _queue.empty()) {
+            return;
+        }
+
+        Job job = std::move(_queue.front());
+        _queue.pop_front();
+        _queued_bytes -= job.data.size();
+        _busy++;
+        lock.unlock();
+        _state_changed.notify_all();
+
+        std::string error;
+        if (archive_write_header(ext, job.entry) != ARCHIVE_OK) {
+            error = "Archive write error: " + std::string(archive_error_string(ext));
+        } else if (!job.data.empty() &&
+                   archive_write_data_block(ext, job.data.data(), job.data.size(), 0) != ARCHIVE_OK) {
+            error = "Archive write data error: " + std::string(archive_error_string(ext));
+        } else if (archive_write_finish_entry(ext) != ARCHIVE_OK) {
+            error = "Archive finish entry error: " + std::string(archive_error_string(ext));
+        }
+        archive_entry_free(job.entry);
+        if (!error.empty()) {
+            dpm_log(LOG_ERROR, error.c_str());
+        }
+
+        lock.lock();
+        _busy--;
+        if (!error.empty()) {
+            _failed = true;
+        }
+        _state_changed.notify_all();
+    }
+}
@@ -0,0 +1,162 @@
+/**
+ * @file file_prefetcher.cpp
+ * @brief Implementation of the small file prefetcher
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "file_prefetcher.hpp"
+
+int file_read_sequential(int fd, std::vector<unsigned char>& buffer,
+                         const std::function<bool(const void* data, size_t size)>& consume)
+{
+    if (buffer.empty()) {
+        buffer.resize(FILE_READ_BUFFER_SIZE);
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    while (true) {
+        ssize_t got = ::read(fd, buffer.data(), buffer.size());
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        if (got == 0) {
+            return 0;
+        }
+        if (!consume(buffer.data(), static_cast<size_t>(got))) {
+            return -1;
+        }
+    }
+}
+
+// reads a whole file with plain reads
+static void file_prefetch_read(const std::string& path, std::vector<unsigned char>& buffer, PrefetchedFile& file)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        file.error = errno;
+        return;
+    }
+
+    file.error = file_read_sequential(fd, buffer, [&](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        file.data.insert(file.data.end(), bytes, bytes + size);
+        return true;
+    });
+    ::close(fd);
+}
+
+FilePrefetcher::FilePrefetcher(std::vector<std::string> paths, std::vector<uint64_t> sizes, uint64_t memory_limit)
+    : _paths(std::move(paths)), _sizes(std::move(sizes)), _memory_limit(memory_limit), _ready_bytes(0), _taken(0), _stop(false)
+{
+    if (!_paths.empty()) {
+        _reader = std::thread(&FilePrefetcher::reader_loop, this);
+    }
+}
+
+FilePrefetcher::~FilePrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _state_changed.notify_all();
+    if (_reader.joinable()) {
+        _reader.join();
+    }
+}
+
+void FilePrefetcher::reader_loop()
+{
+    // small files fit in one read, so a buffer of the largest prefetched size does
+    std::vector<unsigned char> buffer(FILE_PREFETCH_MAX_FILE_SIZE);
+
+    // without io_uring every batch is a single file
+    std::unique_ptr<UringFileReader> uring;
+    if (_sizes.size() == _paths.size() && UringFileReader::supported()) {
+        uring = std::make_unique<UringFileReader>();
+        if (uring->active()) {
+            DPM_LOG(LOG_DEBUG, "Reading ahead ", _paths.size(), " files through io_uring, ", uring->depth(), " at a time");
+        }
+    }
+
+    size_t next_path = 0;
+    while (next_path < _paths.size()) {
+        uint64_t room = 0;
+        {
+            // always allow one file ahead, otherwise the writer could wait on an empty queue forever
+            std::unique_lock<std::mutex> lock(_mutex);
+            _state_changed.wait(lock, [&] { return _stop || _ready.empty() || _ready_bytes < _memory_limit; });
+            if (_stop) {
+                return;
+            }
+            room = _ready_bytes < _memory_limit ? _memory_limit - _ready_bytes : 0;
+        }
+
+        // a batch fills the queue depth as far as the memory limit allows
+        size_t batch_end = next_path + 1;
+        if (uring && uring->active()) {
+            uint64_t batch_bytes = _sizes[next_path];
+            while (batch_end < _paths.size() && batch_end - next_path < uring->depth() &&
+                   batch_bytes + _sizes[batch_end] <= room) {
+                batch_bytes += _sizes[batch_end];
+                batch_end++;
+            }
+        }
+
+        std::vector<PrefetchedFile> batch(batch_end - next_path, PrefetchedFile{ 0, {} });
+        std::vector<bool> read(batch.size(), false);
+        if (uring && uring->active()) {
+            std::vector<UringReadRequest> requests;
+            requests.reserve(batch.size());
+            for (size_t i = next_path; i < batch_end; i++) {
+                requests.push_back({ _paths[i].c_str(), _sizes[i] });
+            }
+            uring->read_files(requests, [&](size_t index, std::vector<unsigned char>& data) {
+                batch[index].data = std::move(data);
+                read[index] = true;
+            });
+        }
+
+        // whatever io_uring did not read, including every error, is read again the plain way
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (!read[i]) {
+                file_prefetch_read(_paths[next_path + i], buffer, batch[i]);
+            }
+        }
+        next_path = batch_end;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto& file : batch) {
+                _ready_bytes += file.data.size();
+                _ready.push_back(std::move(file));
+            }
+        }
+        _state_changed.notify_all();
+    }
+}
+
+bool FilePrefetcher::next(PrefetchedFile& file)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_taken >= _paths.size()) {
+        return false;
+    }
+
+    _state_changed.wait(lock, [&] { return !_ready.empty(); });
+    file = std::move(_ready.front());
+    _ready.pop_front();
+    _ready_bytes -= file.data.size();
+    _taken++;
+    lock.unlock();
+
+    _state_changed.notify_all();
+    return true;
+}
@@ -0,0 +1,216 @@
+/**
+ * @file frame_index.cpp
+ * @brief Implementation of the seekable gzip frame index
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "frame_index.hpp"
+#include "archive_reader.hpp"
+
+// subfield identifier of the footer's extra field
+static const unsigned char FRAME_INDEX_SUBFIELD[2] = { 'D', 'X' };
+
+static void frame_index_put_u64(unsigned char* out, uint64_t value)
+{
+    for (int i = 0; i < 8; i++) {
+        out[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+static uint64_t frame_index_get_u64(const unsigned char* in)
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+bool frame_index_encode(const FrameIndex& index, uint64_t index_offset, std::vector<unsigned char>& trailer)
+{
+    std::string text = "DPM_FRAME_INDEX 1\n";
+    for (const auto& frame : index.frames) {
+        text += "frame " + std::to_string(frame.compressed_offset) + " " + std::to_string(frame.uncompressed_offset) + "\n";
+    }
+    for (const auto& entry : index.entries) {
+        // a path the line format cannot hold is simply not indexed, readers then scan for it
+        if (entry.path.find('\n') != std::string::npos) {
+            continue;
+        }
+        text += "entry " + std::to_string(entry.frame) + " " + entry.path + "\n";
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        dpm_log(LOG_ERROR, "Failed to initialize deflate stream for the frame index");
+        return false;
+    }
+
+    std::vector<unsigned char> member(deflateBound(&stream, text.size()) + 32);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+    stream.avail_in = static_cast<uInt>(text.size());
+    stream.next_out = member.data();
+    stream.avail_out = static_cast<uInt>(member.size());
+    int result = deflate(&stream, Z_FINISH);
+    member.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        dpm_log(LOG_ERROR, "Failed to compress the frame index");
+        return false;
+    }
+
+    // Footer: a gzip header with an extra field, an empty final block and a zero trailer
+    unsigned char footer[FRAME_INDEX_FOOTER_SIZE] = {
+        0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+        20, 0, FRAME_INDEX_SUBFIELD[0], FRAME_INDEX_SUBFIELD[1], 16, 0
+    };
+    frame_index_put_u64(footer + 16, index_offset);
+    frame_index_put_u64(footer + 24, member.size());
+    footer[32] = 0x03;
+    footer[33] = 0x00;
+
+    trailer.swap(member);
+    trailer.insert(trailer.end(), footer, footer + sizeof(footer));
+    return true;
+}
+
+bool frame_index_has_footer(const unsigned char* tail, size_t size)
+{
+    static const unsigned char expected[16] = {
+        0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+        20, 0, FRAME_INDEX_SUBFIELD[0], FRAME_INDEX_SUBFIELD[1], 16, 0
+    };
+    static const unsigned char end[10] = { 0x03, 0x00, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    return size == FRAME_INDEX_FOOTER_SIZE && memcmp(tail, expected, sizeof(expected)) == 0 &&
+           memcmp(tail + 32, end, sizeof(end)) == 0;
+}
+
+// parses the index text, leaving index empty if it is malformed
+static bool frame_index_parse(const std::string& text, FrameIndex& index)
+{
+    index.frames.clear();
+    index.entries.clear();
+    std::istringstream input(text);
+
+    std::string line;
+    if (!std::getline(input, line) || line != "DPM_FRAME_INDEX 1") {
+        dpm_log(LOG_DEBUG, "Frame index has an unknown version, ignoring it");
+        return false;
+    }
+
+    while (std::getline(input, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string kind;
+        bool parsed = false;
+        fields >> kind;
+        if (kind == "frame") {
+            FrameIndexFrame frame;
+            parsed = static_cast<bool>(fields >> frame.compressed_offset >> frame.uncompressed_offset);
+            if (parsed) {
+                index.frames.push_back(frame);
+            }
+        } else if (kind == "entry") {
+            FrameIndexEntry entry;
+            parsed = static_cast<bool>(fields >> entry.frame) && fields.get() == ' ' &&
+                     std::getline(fields, entry.path) && !entry.path.empty();
+            if (parsed) {
+                index.entries.push_back(entry);
+            }
+        }
+
+        if (!parsed) {
+            DPM_LOG(LOG_DEBUG, "Malformed frame index line: ", line);
+            index.frames.clear();
+            index.entries.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool frame_index_find(const unsigned char* data, size_t size, FrameIndex& index)
+{
+    index.frames.clear();
+    index.entries.clear();
+
+    if (!data || size < FRAME_INDEX_FOOTER_SIZE ||
+        !frame_index_has_footer(data + size - FRAME_INDEX_FOOTER_SIZE, FRAME_INDEX_FOOTER_SIZE)) {
+        return false;
+    }
+
+    const unsigned char* footer = data + size - FRAME_INDEX_FOOTER_SIZE;
+    uint64_t index_offset = frame_index_get_u64(footer + 16);
+    uint64_t index_size = frame_index_get_u64(footer + 24);
+    uint64_t footer_offset = size - FRAME_INDEX_FOOTER_SIZE;
+    if (index_offset > footer_offset || index_size != footer_offset - index_offset) {
+        dpm_log(LOG_WARN, "Frame index footer points outside the component, ignoring the index");
+        return false;
+    }
+
+    // the index member is small, so inflate it whole
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        return false;
+    }
+
+    std::string text;
+    std::vector<unsigned char> buffer(64 * 1024);
+    stream.next_in = const_cast<Bytef*>(data + index_offset);
+    stream.avail_in = static_cast<uInt>(index_size);
+    int result = Z_OK;
+    while (result == Z_OK && text.size() <= FRAME_INDEX_MAX_SIZE) {
+        stream.next_out = buffer.data();
+        stream.avail_out = static_cast<uInt>(buffer.size());
+        result = inflate(&stream, Z_NO_FLUSH);
+        text.append(reinterpret_cast<const char*>(buffer.data()), buffer.size() - stream.avail_out);
+    }
+    inflateEnd(&stream);
+
+    if (result != Z_STREAM_END || !frame_index_parse(text, index)) {
+        dpm_log(LOG_WARN, "Frame index of the component is unreadable, ignoring it");
+        index.frames.clear();
+        index.entries.clear();
+        return false;
+    }
+
+    // frames start at the beginning, in order, before the index; entries name existing frames
+    bool valid = !index.frames.empty() && index.frames.front().compressed_offset == 0 &&
+                 index.frames.front().uncompressed_offset == 0;
+    for (size_t i = 1; valid && i < index.frames.size(); i++) {
+        valid = index.frames[i].compressed_offset > index.frames[i - 1].compressed_offset &&
+                index.frames[i].uncompressed_offset > index.frames[i - 1].uncompressed_offset;
+    }
+    valid = valid && index.frames.back().compressed_offset < index_offset;
+    for (size_t i = 0; valid && i < index.entries.size(); i++) {
+        valid = index.entries[i].frame < index.frames.size();
+    }
+
+    if (!valid) {
+        dpm_log(LOG_WARN, "Frame index of the component is inconsistent, ignoring it");
+        index.frames.clear();
+        index.entries.clear();
+        return false;
+    }
+    return true;
+}
+
+const FrameIndexFrame* frame_index_lookup(const FrameIndex& index, const char* path)
+{
+    for (const auto& entry : index.entries) {
+        if (entry.path == path || strcmp(strip_archive_parent(entry.path.c_str()), path) == 0) {
+            return &index.frames[entry.frame];
+        }
+    }
+    return nullptr;
+}
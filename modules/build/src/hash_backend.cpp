@@ -0,0 +1,221 @@
+/**
+ * @file hash_backend.cpp
+ * @brief Hash backend registry and the OpenSSL EVP backend
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "hash_backend.hpp"
+
+/**
+ * @brief Digest context backed by an OpenSSL EVP_MD_CTX
+ */
+class OpenSSLDigestContext : public DigestContext {
+public:
+    OpenSSLDigestContext(const EVP_MD* md, EVP_MD_CTX* context)
+        : _md(md), _context(context)
+    {
+    }
+
+    ~OpenSSLDigestContext() override
+    {
+        EVP_MD_CTX_free(_context);
+    }
+
+    bool init() override
+    {
+        if (EVP_DigestInit_ex(_context, _md, nullptr) != 1) {
+            dpm_log(LOG_ERROR, "Failed to initialize digest context");
+            return false;
+        }
+        return true;
+    }
+
+    bool update(const void* data, size_t size) override
+    {
+        if (EVP_DigestUpdate(_context, data, size) != 1) {
+            dpm_log(LOG_ERROR, "Failed to update digest");
+            return false;
+        }
+        return true;
+    }
+
+    bool finish(unsigned char* digest, size_t* digest_size) override
+    {
+        unsigned int hash_len = 0;
+        if (EVP_DigestFinal_ex(_context, digest, &hash_len) != 1) {
+            dpm_log(LOG_ERROR, "Failed to finalize digest");
+            return false;
+        }
+        *digest_size = hash_len;
+        return true;
+    }
+
+private:
+    const EVP_MD* _md;
+    EVP_MD_CTX* _context;
+};
+
+/**
+ * @brief Hash algorithm backed by an OpenSSL EVP_MD
+ */
+class OpenSSLDigestAlgorithm : public DigestAlgorithm {
+public:
+    explicit OpenSSLDigestAlgorithm(const EVP_MD* md)
+        : _md(md)
+    {
+    }
+
+    size_t digest_size() const override
+    {
+        return static_cast<size_t>(EVP_MD_size(_md));
+    }
+
+    std::unique_ptr<DigestContext> create_context() const override
+    {
+        EVP_MD_CTX* context = EVP_MD_CTX_new();
+        if (!context) {
+            dpm_log(LOG_ERROR, "Failed to create OpenSSL EVP context");
+            return nullptr;
+        }
+        return std::make_unique<OpenSSLDigestContext>(_md, context);
+    }
+
+private:
+    const EVP_MD* _md;
+};
+
+/**
+ * @brief Backend providing every digest algorithm OpenSSL knows
+ *
+ * Algorithm objects are created on first lookup and kept for the lifetime
+ * of the process.
+ */
+class OpenSSLHashBackend : public HashBackend {
+public:
+    OpenSSLHashBackend()
+    {
+        // Initialize OpenSSL
+        OpenSSL_add_all_digests();
+    }
+
+    const char* name() const override
+    {
+        return "openssl";
+    }
+
+    const DigestAlgorithm* find_algorithm(const std::string& algorithm) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _algorithms.find(algorithm);
+        if (it != _algorithms.end()) {
+            return it->second.get();
+        }
+
+        const EVP_MD* md = EVP_get_digestbyname(algorithm.c_str());
+        if (!md) {
+            return nullptr;
+        }
+
+        auto inserted = _algorithms.emplace(algorithm, std::make_unique<OpenSSLDigestAlgorithm>(md));
+        return inserted.first->second.get();
+    }
+
+    std::vector<std::string> list_algorithms() const override
+    {
+        std::vector<std::string> algorithms;
+        std::vector<std::string> working_algorithms;
+
+        // Use OBJ_NAME_do_all to get all message digest algorithms
+        struct AllDigestsCallback {
+            static void callback(const OBJ_NAME* obj, void* arg) {
+                if (obj->type == OBJ_NAME_TYPE_MD_METH) {
+                    std::vector<std::string>* algs = static_cast<std::vector<std::string>*>(arg);
+                    algs->push_back(obj->name);
+                }
+            }
+        };
+
+        // Get all algorithm names
+        OBJ_NAME_do_all(OBJ_NAME_TYPE_MD_METH, AllDigestsCallback::callback, &algorithms);
+
+        // Test each algorithm with a complete hashing process
+        for (const auto& algo_name : algorithms) {
+            const EVP_MD* md = EVP_get_digestbyname(algo_name.c_str());
+            if (!md) continue;
+
+            // Create context
+            EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+            if (!ctx) continue;
+
+            // Test full hashing sequence with dummy data
+            unsigned char dummy_data[] = "test";
+            unsigned char out_buf[EVP_MAX_MD_SIZE];
+            unsigned int out_len = 0;
+
+            bool success = EVP_DigestInit_ex(ctx, md, NULL) == 1 &&
+                           EVP_DigestUpdate(ctx, dummy_data, sizeof(dummy_data)) == 1 &&
+                           EVP_DigestFinal_ex(ctx, out_buf, &out_len) == 1;
+
+            EVP_MD_CTX_free(ctx);
+
+            if (success) {
+                working_algorithms.push_back(algo_name);
+            }
+        }
+
+        return working_algorithms;
+    }
+
+private:
+    mutable std::mutex _mutex;
+    mutable std::unordered_map<std::string, std::unique_ptr<OpenSSLDigestAlgorithm>> _algorithms;
+};
+
+const HashBackend* hash_backend_openssl()
+{
+    static OpenSSLHashBackend backend;
+    return &backend;
+}
+
+/**
+ * @brief Gets the backends in the order they are searched
+ *
+ * @return Every backend compiled into the module
+ */
+static const std::vector<const HashBackend*>& hash_backends()
+{
+    static const std::vector<const HashBackend*> backends = {
+#ifdef DPM_HAVE_BLAKE3
+        hash_backend_blake3(),
+#endif // DPM_HAVE_BLAKE3
+        hash_backend_openssl()
+    };
+    return backends;
+}
+
+const DigestAlgorithm* hash_backend_find_algorithm(const std::string& algorithm)
+{
+    for (const HashBackend* backend : hash_backends()) {
+        const DigestAlgorithm* found = backend->find_algorithm(algorithm);
+        if (found) {
+            return found;
+        }
+    }
+
+    return nullptr;
+}
+
+std::vector<std::string> hash_backend_list_algorithms()
+{
+    std::vector<std::string> algorithms;
+    for (const HashBackend* backend : hash_backends()) {
+        std::vector<std::string> provided = backend->list_algorithms();
+        algorithms.insert(algorithms.end(), provided.begin(), provided.end());
+    }
+    return algorithms;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file hash_backend_blake3.cpp
+ * @brief BLAKE3 hash backend
+ *
+ * Provides the "blake3" algorithm through the official libblake3.  The
+ * library detects the CPU features at runtime and dispatches to its SSE2,
+ * SSE4.1, AVX2, AVX-512 or NEON implementation, falling back to portable
+ * code, so the same module binary runs at full speed on any machine.
+ *
+ * Only compiled in when the build module is configured with libblake3.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "hash_backend.hpp"
+
+#ifdef DPM_HAVE_BLAKE3
+
+#include <blake3.h>
+
+/**
+ * @brief Digest context wrapping a blake3_hasher
+ */
+class Blake3DigestContext : public DigestContext {
+public:
+    bool init() override
+    {
+        blake3_hasher_init(&_hasher);
+        return true;
+    }
+
+    bool update(const void* data, size_t size) override
+    {
+        blake3_hasher_update(&_hasher, data, size);
+        return true;
+    }
+
+    bool finish(unsigned char* digest, size_t* digest_size) override
+    {
+        blake3_hasher_finalize(&_hasher, digest, BLAKE3_OUT_LEN);
+        *digest_size = BLAKE3_OUT_LEN;
+        return true;
+    }
+
+private:
+    blake3_hasher _hasher;
+};
+
+/**
+ * @brief The BLAKE3 algorithm with its default 256-bit output
+ */
+class Blake3DigestAlgorithm : public DigestAlgorithm {
+public:
+    size_t digest_size() const override
+    {
+        return BLAKE3_OUT_LEN;
+    }
+
+    std::unique_ptr<DigestContext> create_context() const override
+    {
+        return std::make_unique<Blake3DigestContext>();
+    }
+};
+
+/**
+ * @brief Backend providing the blake3 algorithm
+ */
+class Blake3HashBackend : public HashBackend {
+public:
+    const char* name() const override
+    {
+        return "blake3";
+    }
+
+    const DigestAlgorithm* find_algorithm(const std::string& algorithm) const override
+    {
+        return algorithm == "blake3" ? &_algorithm : nullptr;
+    }
+
+    std::vector<std::string> list_algorithms() const override
+    {
+        return { "blake3" };
+    }
+
+private:
+    Blake3DigestAlgorithm _algorithm;
+};
+
+const HashBackend* hash_backend_blake3()
+{
+    static Blake3HashBackend backend;
+    return &backend;
+}
+
+#endif // DPM_HAVE_BLAKE3
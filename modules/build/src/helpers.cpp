@@ -13,6 +13,9 @@
 
 #include "helpers.hpp"
 
+// items of a batch running at once, every per-operation thread count is shared between them
+static std::atomic<size_t> g_concurrent_items{1};
+
 std::string expand_path(const std::string& path) {
     wordexp_t exp_result;
     std::string expanded_path = path;
@@ -27,3 +30,33 @@ std::string expand_path(const std::string& path) {
 
     return expanded_path;
 }
+
+void set_build_concurrent_items(size_t items)
+{
+    g_concurrent_items = std::max<size_t>(items, 1);
+}
+
+size_t build_config_thread_count(const char* key, size_t fallback)
+{
+    const char* configured = dpm_get_config("build", key);
+    if (!configured || strlen(configured) == 0) {
+        return fallback;
+    }
+
+    char* end = nullptr;
+    long value = strtol(configured, &end, 10);
+    if (end != configured && *end == '\0' && value > 0) {
+        return static_cast<size_t>(value);
+    }
+
+    // 0 explicitly asks for automatic detection
+    if (end == configured || *end != '\0' || value < 0) {
+        dpm_log(LOG_WARN, ("Ignoring invalid [build] " + std::string(key) + " value: " + std::string(configured)).c_str());
+    }
+    return fallback;
+}
+
+size_t build_thread_share(size_t threads)
+{
+    return std::max<size_t>(1, threads / g_concurrent_items.load());
+}
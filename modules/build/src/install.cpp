@@ -0,0 +1,633 @@
+/**
+ * @file install.cpp
+ * @brief Implementation of the single pass verified installer
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "install.hpp"
+
+/**
+ * @brief What the manifest records for one contents path
+ */
+struct InstallManifestEntry {
+    std::string checksum;       ///< Digest in the configured algorithm
+    std::string ownership;      ///< owner:group
+    mode_t permissions;         ///< Permission bits
+    bool seen;                  ///< Set once the contents held the path
+};
+
+/**
+ * @brief A verified entry linked under a temporary name, waiting to be committed
+ */
+struct InstallPendingEntry {
+    std::string temp_path;      ///< Temporary name beside the destination
+    std::string final_path;     ///< Destination in the root
+    std::string backup_path;    ///< Name the replaced destination is kept under while committing, empty if none
+};
+
+/**
+ * @brief A link entry of the contents, placed once every file is written
+ */
+struct InstallDeferredLink {
+    std::string path;           ///< Path relative to the root
+    std::string target;         ///< Symlink target, or contents path of a hard link's file
+    bool hard;                  ///< Whether the entry is a hard link
+};
+
+/**
+ * @brief State of one install, removed again unless it is committed
+ */
+struct InstallState {
+    std::filesystem::path root;
+    std::unordered_map<std::string, InstallManifestEntry> manifest;
+    std::unordered_map<std::string, size_t> pending_index;     ///< Relative path to position in pending
+    std::vector<InstallPendingEntry> pending;
+    std::vector<std::string> created_directories;               ///< In creation order
+    std::vector<unsigned char> buffer;
+    bool as_root;
+    uint64_t temp_counter;
+};
+
+static std::string install_trim(const std::string& value)
+{
+    size_t start = value.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(" \t\r\n");
+    return value.substr(start, end - start + 1);
+}
+
+// reads the rest of the current entry of an archive iterator
+static bool install_read_entry(void* iterator, std::string& value)
+{
+    value.clear();
+    char buffer[PACKAGE_STREAM_BLOCK_SIZE];
+    long long bytes_read;
+    while ((bytes_read = archive_iterator_read(iterator, buffer, sizeof(buffer))) > 0) {
+        value.append(buffer, static_cast<size_t>(bytes_read));
+    }
+    return bytes_read == 0;
+}
+
+// reads the manifest and checks it against the package digest, in one pass over the metadata component
+static bool install_read_manifest(const std::string& package_path, std::string& manifest)
+{
+    void* iterator = archive_iterator_open_package_component(package_path.c_str(), "metadata");
+    if (!iterator) {
+        dpm_log(LOG_ERROR, ("Failed to read the metadata component of package: " + package_path).c_str());
+        return false;
+    }
+
+    std::string hooks_digest;
+    std::string package_digest;
+    bool has_manifest = false;
+    bool has_hooks_digest = false;
+    bool has_package_digest = false;
+    bool result = true;
+    archive_iterator_entry entry;
+    int r = 0;
+    while (result && (r = archive_iterator_next(iterator, &entry)) == 1) {
+        if ((entry.mode & S_IFMT) != S_IFREG) {
+            continue;
+        }
+
+        std::string* field = nullptr;
+        if (strcmp(entry.path, "CONTENTS_MANIFEST_DIGEST") == 0) {
+            field = &manifest;
+            has_manifest = true;
+        } else if (strcmp(entry.path, "HOOKS_DIGEST") == 0) {
+            field = &hooks_digest;
+            has_hooks_digest = true;
+        } else if (strcmp(entry.path, "PACKAGE_DIGEST") == 0) {
+            field = &package_digest;
+            has_package_digest = true;
+        }
+
+        if (field && !install_read_entry(iterator, *field)) {
+            result = false;
+        }
+    }
+    archive_iterator_close(iterator);
+
+    if (!result || r < 0) {
+        dpm_log(LOG_ERROR, ("Failed to read the metadata component of package: " + package_path).c_str());
+        return false;
+    }
+    if (!has_manifest || !has_hooks_digest || !has_package_digest) {
+        dpm_log(LOG_ERROR, ("Package has no CONTENTS_MANIFEST_DIGEST, HOOKS_DIGEST or PACKAGE_DIGEST: " +
+                            package_path).c_str());
+        return false;
+    }
+
+    // the package digest covers the manifest, so every digest checked against the manifest is covered by it
+    std::string expected = install_trim(package_digest);
+    std::string actual = generate_string_checksum(generate_string_checksum(manifest) +
+                                                  generate_string_checksum(hooks_digest));
+    if (actual.empty() || actual != expected) {
+        dpm_log(LOG_ERROR, ("Package digest does not match the manifest of package: " + package_path).c_str());
+        return false;
+    }
+    return true;
+}
+
+// parses the manifest into its entries keyed by path without the leading slash
+static bool install_parse_manifest(const std::string& manifest, const std::string& package_path,
+                                   std::unordered_map<std::string, InstallManifestEntry>& entries)
+{
+    std::string_view remaining(manifest);
+    std::string_view line;
+    size_t line_number = 0;
+    size_t digest_length = manifest_digest_length(get_configured_hash_algorithm());
+    while (manifest_next_line(remaining, line)) {
+        line_number++;
+        if (line.empty()) {
+            continue;
+        }
+
+        ManifestLine manifest_line;
+        uint32_t mode = 0;
+        if (!manifest_parse_line(line, manifest_line, digest_length) ||
+            !manifest_parse_permissions(manifest_line.permissions, mode)) {
+            dpm_log(LOG_ERROR, ("Malformed line " + std::to_string(line_number) + " in the manifest of " +
+                                package_path).c_str());
+            return false;
+        }
+        std::string path(manifest_relative_path(manifest_line.path));
+
+        InstallManifestEntry entry;
+        entry.checksum = manifest_line.checksum;
+        entry.ownership = manifest_line.ownership;
+        entry.permissions = static_cast<mode_t>(mode);
+        entry.seen = false;
+        if (!entries.emplace(path, std::move(entry)).second) {
+            dpm_log(LOG_ERROR, ("Duplicate path " + path + " in the manifest of " + package_path).c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// checks that a contents path stays inside the root
+static bool install_safe_path(const std::string& path)
+{
+    if (path.empty() || path[0] == '/') {
+        return false;
+    }
+    for (const auto& part : std::filesystem::path(path)) {
+        if (part == "..") {
+            return false;
+        }
+    }
+    return true;
+}
+
+// creates a directory and any missing parents, remembering the ones it created
+static bool install_make_directories(InstallState& state, const std::filesystem::path& directory, mode_t mode)
+{
+    // a symlink to a directory, such as /lib on merged systems, is followed
+    struct stat st;
+    if (stat(directory.c_str(), &st) == 0) {
+        if (S_ISDIR(st.st_mode)) {
+            return true;
+        }
+        dpm_log(LOG_ERROR, ("Refusing to replace a non-directory with a directory: " + directory.string()).c_str());
+        return false;
+    }
+
+    if (directory.has_parent_path() && directory.parent_path() != directory &&
+        !install_make_directories(state, directory.parent_path(), 0755)) {
+        return false;
+    }
+
+    if (mkdir(directory.c_str(), mode) != 0 && errno != EEXIST) {
+        dpm_log(LOG_ERROR, ("Failed to create directory " + directory.string() + ": " + strerror(errno)).c_str());
+        return false;
+    }
+    state.created_directories.push_back(directory.string());
+    return true;
+}
+
+// gives a file the permissions and, as root, the ownership the manifest records
+static bool install_set_attributes(const InstallState& state, int fd, const InstallManifestEntry& expected,
+                                   int64_t mtime, const std::string& path)
+{
+    if (state.as_root) {
+        size_t separator = expected.ownership.find(':');
+        std::string owner = expected.ownership.substr(0, separator);
+        std::string group = separator == std::string::npos ? "" : expected.ownership.substr(separator + 1);
+        struct passwd* pw = getpwnam(owner.c_str());
+        struct group* gr = group.empty() ? nullptr : getgrnam(group.c_str());
+        if (!pw || (!group.empty() && !gr)) {
+            dpm_log(LOG_ERROR, ("Unknown owner " + expected.ownership + " for " + path).c_str());
+            return false;
+        }
+        if (fchown(fd, pw->pw_uid, gr ? gr->gr_gid : pw->pw_gid) != 0) {
+            dpm_log(LOG_ERROR, ("Failed to set ownership of " + path + ": " + strerror(errno)).c_str());
+            return false;
+        }
+    }
+
+    // after fchown, which would clear setuid and setgid bits set before it
+    if (fchmod(fd, expected.permissions) != 0) {
+        dpm_log(LOG_ERROR, ("Failed to set permissions of " + path + ": " + strerror(errno)).c_str());
+        return false;
+    }
+
+    struct timespec times[2];
+    times[0].tv_sec = mtime;
+    times[0].tv_nsec = 0;
+    times[1] = times[0];
+    if (futimens(fd, times) != 0) {
+        dpm_log(LOG_ERROR, ("Failed to set modification time of " + path + ": " + strerror(errno)).c_str());
+        return false;
+    }
+    return true;
+}
+
+static std::string install_temp_path(InstallState& state, const std::filesystem::path& final_path)
+{
+    return (final_path.parent_path() / (INSTALL_TEMP_PREFIX + std::to_string(getpid()) + "-" +
+                                        std::to_string(state.temp_counter++))).string();
+}
+
+// writes the current entry of the iterator to an unnamed file, hashing it on the way, and names it once it matches
+static bool install_write_file(InstallState& state, void* iterator, const std::string& path,
+                               const InstallManifestEntry& expected, int64_t mtime, std::string& temp_path)
+{
+    std::filesystem::path final_path = state.root / path;
+    std::string directory = final_path.parent_path().string();
+    temp_path = install_temp_path(state, final_path);
+
+    bool named = false;
+    int fd = open(directory.c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0600);
+    if (fd < 0 && (errno == EOPNOTSUPP || errno == EISDIR || errno == EINVAL)) {
+        // no O_TMPFILE on this filesystem, a mismatch removes the named file instead
+        fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        named = true;
+    }
+    if (fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to create a file in " + directory + ": " + strerror(errno)).c_str());
+        return false;
+    }
+
+    auto fail = [&]() {
+        close(fd);
+        if (named) {
+            unlink(temp_path.c_str());
+        }
+        return false;
+    };
+
+    ChecksumEngine& engine = ChecksumEngine::instance();
+    if (!engine.begin()) {
+        return fail();
+    }
+
+    long long bytes_read;
+    while ((bytes_read = archive_iterator_read(iterator, state.buffer.data(), state.buffer.size())) > 0) {
+        engine.update(state.buffer.data(), static_cast<size_t>(bytes_read));
+
+        const unsigned char* data = state.buffer.data();
+        size_t remaining = static_cast<size_t>(bytes_read);
+        while (remaining > 0) {
+            ssize_t written = write(fd, data, remaining);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                dpm_log(LOG_ERROR, ("Failed to write /" + path + ": " + strerror(errno)).c_str());
+                return fail();
+            }
+            data += written;
+            remaining -= static_cast<size_t>(written);
+        }
+    }
+    if (bytes_read < 0) {
+        dpm_log(LOG_ERROR, ("Failed to read /" + path + " from the contents component").c_str());
+        return fail();
+    }
+
+    unsigned char digest[CHECKSUM_MAX_DIGEST_SIZE];
+    size_t digest_size = 0;
+    if (!engine.finish(digest, &digest_size)) {
+        return fail();
+    }
+    std::string actual = ChecksumEngine::to_hex(digest, digest_size);
+    if (actual != expected.checksum) {
+        dpm_log(LOG_ERROR, ("Checksum mismatch for /" + path + ": expected " + expected.checksum +
+                            ", got " + actual).c_str());
+        return fail();
+    }
+
+    if (!install_set_attributes(state, fd, expected, mtime, "/" + path)) {
+        return fail();
+    }
+
+    // the data matches, so it may have a name now
+    if (!named) {
+        std::string fd_path = "/proc/self/fd/" + std::to_string(fd);
+        if (linkat(AT_FDCWD, fd_path.c_str(), AT_FDCWD, temp_path.c_str(), AT_SYMLINK_FOLLOW) != 0) {
+            dpm_log(LOG_ERROR, ("Failed to link " + temp_path + ": " + strerror(errno)).c_str());
+            return fail();
+        }
+        named = true;
+    }
+
+    if (close(fd) != 0) {
+        dpm_log(LOG_ERROR, ("Failed to write /" + path + ": " + strerror(errno)).c_str());
+        unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// finds the checksum of what a symlink resolves to, in the package where it points into it or in the root
+static bool install_link_checksum(const InstallState& state, const std::string& path, std::string target,
+                                  std::string& checksum)
+{
+    std::filesystem::path current(path);
+    for (int hops = 0; hops < 40; hops++) {
+        std::filesystem::path resolved = target[0] == '/' ? std::filesystem::path(target).relative_path()
+                                                          : (current.parent_path() / target).lexically_normal();
+        std::string key = resolved.string();
+
+        auto pending = state.pending_index.find(key);
+        if (pending == state.pending_index.end()) {
+            checksum = generate_file_checksum(state.root / resolved);
+            return !checksum.empty();
+        }
+
+        // another link of the package is followed, a file is taken from the manifest it was verified against
+        std::error_code ec;
+        const std::string& temp_path = state.pending[pending->second].temp_path;
+        if (!std::filesystem::is_symlink(std::filesystem::symlink_status(temp_path, ec))) {
+            checksum = state.manifest.at(key).checksum;
+            return true;
+        }
+        target = std::filesystem::read_symlink(temp_path, ec).string();
+        if (ec || target.empty()) {
+            return false;
+        }
+        current = resolved;
+    }
+    return false;
+}
+
+// places the symlinks and hard links under temporary names once the files they refer to are written
+static bool install_place_link(InstallState& state, InstallDeferredLink& link)
+{
+    auto expected = state.manifest.find(link.path);
+    std::string final_path = (state.root / link.path).string();
+    std::string temp_path = install_temp_path(state, final_path);
+
+    if (link.hard) {
+        auto target = state.pending_index.find(link.target);
+        if (target == state.pending_index.end() ||
+            state.manifest.at(link.target).checksum != expected->second.checksum) {
+            dpm_log(LOG_ERROR, ("Hard link /" + link.path + " does not match the manifest").c_str());
+            return false;
+        }
+        if (linkat(AT_FDCWD, state.pending[target->second].temp_path.c_str(), AT_FDCWD, temp_path.c_str(), 0) != 0) {
+            dpm_log(LOG_ERROR, ("Failed to link " + temp_path + ": " + strerror(errno)).c_str());
+            return false;
+        }
+    } else if (symlink(link.target.c_str(), temp_path.c_str()) != 0) {
+        dpm_log(LOG_ERROR, ("Failed to create symlink " + temp_path + ": " + strerror(errno)).c_str());
+        return false;
+    }
+
+    state.pending_index[link.path] = state.pending.size();
+    state.pending.push_back({ temp_path, final_path });
+    return true;
+}
+
+// checks every symlink against the manifest once all links are placed, as links may point at each other
+static bool install_check_symlinks(const InstallState& state, const std::vector<InstallDeferredLink>& links)
+{
+    bool result = true;
+    for (const auto& link : links) {
+        if (link.hard) {
+            continue;
+        }
+        std::string checksum;
+        const std::string& expected = state.manifest.at(link.path).checksum;
+        if (!install_link_checksum(state, link.path, link.target, checksum)) {
+            dpm_log(LOG_ERROR, ("Symlink /" + link.path + " does not resolve to a file").c_str());
+            result = false;
+        } else if (checksum != expected) {
+            dpm_log(LOG_ERROR, ("Checksum mismatch for /" + link.path + ": expected " + expected +
+                                ", got " + checksum).c_str());
+            result = false;
+        }
+    }
+    return result;
+}
+
+// removes everything an install that is not committed has created
+static void install_discard(InstallState& state)
+{
+    for (const auto& entry : state.pending) {
+        unlink(entry.temp_path.c_str());
+    }
+    for (auto it = state.created_directories.rbegin(); it != state.created_directories.rend(); ++it) {
+        rmdir(it->c_str());
+    }
+}
+
+// puts back what the first committed entries replaced, newest first, then discards the rest as install_discard
+static void install_roll_back(InstallState& state, size_t committed)
+{
+    for (size_t i = committed; i-- > 0; ) {
+        InstallPendingEntry& entry = state.pending[i];
+        int restored = entry.backup_path.empty() ? unlink(entry.final_path.c_str())
+                                                 : rename(entry.backup_path.c_str(), entry.final_path.c_str());
+        if (restored != 0) {
+            dpm_log(LOG_ERROR, ("Failed to restore " + entry.final_path + ": " + strerror(errno)).c_str());
+        }
+    }
+
+    for (size_t i = committed; i < state.pending.size(); i++) {
+        unlink(state.pending[i].temp_path.c_str());
+        if (!state.pending[i].backup_path.empty()) {
+            unlink(state.pending[i].backup_path.c_str());
+        }
+    }
+    for (auto it = state.created_directories.rbegin(); it != state.created_directories.rend(); ++it) {
+        rmdir(it->c_str());
+    }
+}
+
+// moves every verified entry into place, keeping each file it replaces until all of them are
+static bool install_commit(InstallState& state)
+{
+    for (size_t i = 0; i < state.pending.size(); i++) {
+        InstallPendingEntry& entry = state.pending[i];
+
+        // a second name for the file being replaced, which the rename then leaves behind
+        struct stat st;
+        if (lstat(entry.final_path.c_str(), &st) == 0) {
+            std::string backup_path = install_temp_path(state, entry.final_path);
+            if (linkat(AT_FDCWD, entry.final_path.c_str(), AT_FDCWD, backup_path.c_str(), 0) != 0) {
+                dpm_log(LOG_ERROR, ("Failed to keep a backup of " + entry.final_path + ": " + strerror(errno)).c_str());
+                install_roll_back(state, i);
+                return false;
+            }
+            entry.backup_path = backup_path;
+        }
+
+        if (rename(entry.temp_path.c_str(), entry.final_path.c_str()) != 0) {
+            dpm_log(LOG_ERROR, ("Failed to install " + entry.final_path + ": " + strerror(errno)).c_str());
+            install_roll_back(state, i);
+            return false;
+        }
+    }
+
+    for (const auto& entry : state.pending) {
+        if (!entry.backup_path.empty() && unlink(entry.backup_path.c_str()) != 0) {
+            dpm_log(LOG_WARN, ("Failed to remove backup " + entry.backup_path + ": " + strerror(errno)).c_str());
+        }
+    }
+    return true;
+}
+
+// streams the contents component, writing and verifying every entry under a temporary name
+static bool install_stream_contents(InstallState& state, const std::string& package_path)
+{
+    void* iterator = archive_iterator_open_package_component(package_path.c_str(), "contents");
+    if (!iterator) {
+        dpm_log(LOG_ERROR, ("Failed to read the contents component of package: " + package_path).c_str());
+        return false;
+    }
+
+    std::vector<InstallDeferredLink> links;
+    bool result = true;
+    archive_iterator_entry entry;
+    int r = 0;
+    while (result && (r = archive_iterator_next(iterator, &entry)) == 1) {
+        std::string path = entry.path;
+        while (!path.empty() && path.back() == '/') {
+            path.pop_back();
+        }
+        if (path.empty()) {
+            continue;
+        }
+        if (!install_safe_path(path)) {
+            dpm_log(LOG_ERROR, ("Refusing to install a path outside the root: " + path).c_str());
+            result = false;
+            break;
+        }
+
+        uint32_t type = entry.mode & S_IFMT;
+        if (type == S_IFDIR) {
+            result = install_make_directories(state, state.root / path, entry.mode & 07777);
+            continue;
+        }
+
+        auto expected = state.manifest.find(path);
+        if (expected == state.manifest.end()) {
+            dpm_log(LOG_ERROR, ("Contents entry is not in the manifest: /" + path).c_str());
+            result = false;
+            break;
+        }
+        if (expected->second.seen) {
+            dpm_log(LOG_ERROR, ("Contents entry appears more than once: /" + path).c_str());
+            result = false;
+            break;
+        }
+        expected->second.seen = true;
+
+        if (!install_make_directories(state, (state.root / path).parent_path(), 0755)) {
+            result = false;
+            break;
+        }
+
+        if (type == S_IFLNK && entry.link_target) {
+            links.push_back({ path, entry.link_target, false });
+        } else if (type == S_IFREG && entry.link_target) {
+            links.push_back({ path, strip_archive_parent(entry.link_target), true });
+        } else if (type == S_IFREG) {
+            std::string temp_path;
+            result = install_write_file(state, iterator, path, expected->second, entry.mtime, temp_path);
+            if (result) {
+                state.pending_index[path] = state.pending.size();
+                state.pending.push_back({ temp_path, (state.root / path).string() });
+            }
+        } else {
+            dpm_log(LOG_ERROR, ("Unsupported file type in the contents component: /" + path).c_str());
+            result = false;
+        }
+    }
+    archive_iterator_close(iterator);
+
+    if (result && r < 0) {
+        dpm_log(LOG_ERROR, ("Failed to read the contents component of package: " + package_path).c_str());
+        result = false;
+    }
+
+    for (size_t i = 0; result && i < links.size(); i++) {
+        result = install_place_link(state, links[i]);
+    }
+    return result && install_check_symlinks(state, links);
+}
+
+extern "C" int install_package(const std::string& package_path, const std::string& root_dir, bool force)
+{
+    DpmProfileScope profile("install_package");
+    dpm_log(LOG_INFO, ("Installing package " + package_path + " into " + root_dir).c_str());
+
+    if (!ChecksumEngine::instance().valid()) {
+        dpm_log(LOG_ERROR, "The configured hash algorithm is not available");
+        return 1;
+    }
+
+    std::string manifest;
+    InstallState state;
+    if (!install_read_manifest(package_path, manifest) ||
+        !install_parse_manifest(manifest, package_path, state.manifest)) {
+        return 1;
+    }
+
+    state.root = std::filesystem::absolute(root_dir).lexically_normal();
+    state.buffer.resize(PACKAGE_STREAM_BLOCK_SIZE * 4);
+    state.as_root = geteuid() == 0;
+    state.temp_counter = 0;
+
+    bool result = install_make_directories(state, state.root, 0755) && install_stream_contents(state, package_path);
+
+    for (const auto& entry : state.manifest) {
+        if (result && !entry.second.seen) {
+            dpm_log(LOG_ERROR, ("Manifest entry is missing from the contents component: /" + entry.first).c_str());
+            result = false;
+        }
+    }
+
+    // existing files are only replaced when asked, checked before any of them is
+    for (size_t i = 0; result && !force && i < state.pending.size(); i++) {
+        struct stat st;
+        if (lstat(state.pending[i].final_path.c_str(), &st) == 0) {
+            dpm_log(LOG_ERROR, ("File already exists: " + state.pending[i].final_path + ". Use --force to replace it.").c_str());
+            result = false;
+        }
+    }
+
+    if (!result) {
+        install_discard(state);
+        dpm_log(LOG_ERROR, ("Failed to install package: " + package_path).c_str());
+        return 1;
+    }
+
+    // every entry is verified, commit them
+    if (!install_commit(state)) {
+        dpm_log(LOG_ERROR, ("Failed to install package, the root was left as it was: " + package_path).c_str());
+        return 1;
+    }
+    profile.add_files(state.pending.size());
+
+    DPM_CON(LOG_INFO, "Installed ", state.pending.size(), " files from ", package_path, " into ", state.root.string());
+    return 0;
+}
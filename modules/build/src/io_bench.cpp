@@ -0,0 +1,306 @@
+/**
+ * @file io_bench.cpp
+ * @brief Implementation of the checksum I/O strategy benchmark
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "io_bench.hpp"
+
+// strategies compared by the benchmark, in table column order
+static const ChecksumIoStrategy IO_BENCH_STRATEGIES[] = {
+    CHECKSUM_IO_READ,
+    CHECKSUM_IO_PREAD,
+    CHECKSUM_IO_MMAP
+};
+
+static const size_t IO_BENCH_STRATEGY_COUNT = sizeof(IO_BENCH_STRATEGIES) / sizeof(IO_BENCH_STRATEGIES[0]);
+
+// strategies within this fraction of the fastest are treated as equally fast
+static const double IO_BENCH_TOLERANCE = 0.05;
+
+// small files are hashed repeatedly per pass until at least this much data has been read
+static const uint64_t IO_BENCH_MIN_PASS_BYTES = 16 * 1024 * 1024;
+
+bool io_bench_parse_sizes(const std::string& size_list, std::vector<uint64_t>& sizes)
+{
+    sizes.clear();
+
+    std::stringstream ss(size_list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+
+        uint64_t multiplier = 1;
+        char suffix = item.back();
+        if (suffix == 'K' || suffix == 'k') {
+            multiplier = 1024ULL;
+        } else if (suffix == 'M' || suffix == 'm') {
+            multiplier = 1024ULL * 1024;
+        } else if (suffix == 'G' || suffix == 'g') {
+            multiplier = 1024ULL * 1024 * 1024;
+        }
+
+        std::string number = multiplier == 1 ? item : item.substr(0, item.size() - 1);
+        if (number.empty() || number.find_first_not_of("0123456789") != std::string::npos) {
+            dpm_log(LOG_ERROR, ("Invalid benchmark size: " + item).c_str());
+            return false;
+        }
+
+        uint64_t size = std::stoull(number) * multiplier;
+        if (size == 0) {
+            dpm_log(LOG_ERROR, ("Benchmark sizes must be greater than zero: " + item).c_str());
+            return false;
+        }
+
+        sizes.push_back(size);
+    }
+
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+
+    return !sizes.empty();
+}
+
+/**
+ * @brief Formats a byte count with a binary unit suffix
+ *
+ * @param size Size in bytes
+ * @return Human readable size, e.g. "64K"
+ */
+static std::string io_bench_format_size(uint64_t size)
+{
+    const char* units[] = { "", "K", "M", "G", "T" };
+    int unit = 0;
+    while (unit < 4 && size >= 1024 && size % 1024 == 0) {
+        size /= 1024;
+        unit++;
+    }
+
+    return std::to_string(size) + units[unit];
+}
+
+/**
+ * @brief Writes a file of random data and flushes it to the storage
+ *
+ * @param file_path Path of the file to write
+ * @param size Size of the file in bytes
+ * @return true on success, false on failure
+ */
+static bool io_bench_write_file(const std::filesystem::path& file_path, uint64_t size)
+{
+    std::vector<unsigned char> block(CHECKSUM_READ_BUFFER_SIZE);
+    std::mt19937_64 generator(size);
+    for (size_t i = 0; i + sizeof(uint64_t) <= block.size(); i += sizeof(uint64_t)) {
+        uint64_t value = generator();
+        memcpy(block.data() + i, &value, sizeof(value));
+    }
+
+    int fd = open(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to create benchmark file: " + file_path.string() + ": " + strerror(errno)).c_str());
+        return false;
+    }
+
+    uint64_t written = 0;
+    while (written < size) {
+        // perturb every block so no two blocks of the file are identical
+        block[0] = static_cast<unsigned char>(written / block.size());
+
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(block.size(), size - written));
+        ssize_t result = write(fd, block.data(), chunk);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            dpm_log(LOG_ERROR, ("Failed to write benchmark file: " + file_path.string() + ": " + strerror(errno)).c_str());
+            close(fd);
+            return false;
+        }
+        written += static_cast<uint64_t>(result);
+    }
+
+    // the data has to be on the storage before it can be dropped from the page cache
+    bool success = fsync(fd) == 0;
+    if (!success) {
+        dpm_log(LOG_ERROR, ("Failed to flush benchmark file: " + file_path.string()).c_str());
+    }
+
+    close(fd);
+    return success;
+}
+
+/**
+ * @brief Asks the kernel to drop a file's pages from the page cache
+ *
+ * @param file_path Path of the file
+ */
+static void io_bench_drop_cache(const std::filesystem::path& file_path)
+{
+    int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+/**
+ * @brief Times one pass of hashing a file with a strategy
+ *
+ * @param file_path File to hash
+ * @param strategy I/O strategy to use
+ * @param iterations Number of times to hash the file in this pass
+ * @param warm Keep the file in the page cache between iterations
+ * @param seconds Receives the time spent hashing, excluding cache drops
+ * @return true on success, false if hashing failed
+ */
+static bool io_bench_time_pass(const std::filesystem::path& file_path, ChecksumIoStrategy strategy,
+                               uint64_t iterations, bool warm, double& seconds)
+{
+    ChecksumEngine& engine = ChecksumEngine::instance();
+    unsigned char digest[CHECKSUM_MAX_DIGEST_SIZE];
+    size_t digest_size = 0;
+
+    std::chrono::steady_clock::duration elapsed(0);
+    for (uint64_t i = 0; i < iterations; i++) {
+        if (!warm) {
+            io_bench_drop_cache(file_path);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bool success = engine.digest_file(file_path, digest, &digest_size, strategy);
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        if (!success) {
+            return false;
+        }
+    }
+
+    seconds = std::chrono::duration<double>(elapsed).count();
+    return true;
+}
+
+int run_checksum_io_benchmark(const std::filesystem::path& bench_dir, const std::vector<uint64_t>& sizes,
+                              int repeat, bool warm)
+{
+    ChecksumEngine& engine = ChecksumEngine::instance();
+    if (!engine.valid()) {
+        return 1;
+    }
+
+    if (!std::filesystem::is_directory(bench_dir)) {
+        dpm_log(LOG_ERROR, ("Benchmark directory does not exist: " + bench_dir.string()).c_str());
+        return 1;
+    }
+
+    dpm_con(LOG_INFO, ("Benchmarking checksum I/O strategies in: " + bench_dir.string()).c_str());
+    dpm_con(LOG_INFO, ("Algorithm: " + engine.algorithm() + ", passes: " + std::to_string(repeat) +
+                       ", page cache: " + (warm ? "warm" : "dropped before every read")).c_str());
+    dpm_con(LOG_INFO, "");
+
+    std::stringstream header;
+    header << std::setw(10) << "size";
+    for (ChecksumIoStrategy strategy : IO_BENCH_STRATEGIES) {
+        header << std::setw(12) << checksum_io_strategy_name(strategy);
+    }
+    header << "   fastest (MiB/s)";
+    dpm_con(LOG_INFO, header.str().c_str());
+
+    // throughput of every strategy at each size, used to work out the crossover points
+    std::vector<std::vector<double>> results;
+
+    for (uint64_t size : sizes) {
+        std::filesystem::path file_path = bench_dir / (".dpm-io-bench-" + std::to_string(getpid()) +
+                                                      "-" + std::to_string(size));
+        if (!io_bench_write_file(file_path, size)) {
+            std::filesystem::remove(file_path);
+            return 1;
+        }
+
+        uint64_t iterations = std::max<uint64_t>(1, IO_BENCH_MIN_PASS_BYTES / size);
+
+        std::stringstream row;
+        row << std::setw(10) << io_bench_format_size(size);
+
+        std::vector<double> throughputs;
+        double best_throughput = 0;
+        ChecksumIoStrategy best_strategy = CHECKSUM_IO_READ;
+        for (ChecksumIoStrategy strategy : IO_BENCH_STRATEGIES) {
+            double best_seconds = 0;
+            for (int pass = 0; pass < repeat; pass++) {
+                double seconds = 0;
+                if (!io_bench_time_pass(file_path, strategy, iterations, warm, seconds)) {
+                    std::filesystem::remove(file_path);
+                    return 1;
+                }
+                if (pass == 0 || seconds < best_seconds) {
+                    best_seconds = seconds;
+                }
+            }
+
+            double throughput = best_seconds > 0
+                ? static_cast<double>(size * iterations) / (1024.0 * 1024.0) / best_seconds
+                : 0;
+            if (throughput > best_throughput) {
+                best_throughput = throughput;
+                best_strategy = strategy;
+            }
+
+            throughputs.push_back(throughput);
+            row << std::setw(12) << std::fixed << std::setprecision(1) << throughput;
+        }
+
+        row << "   " << checksum_io_strategy_name(best_strategy);
+        dpm_con(LOG_INFO, row.str().c_str());
+
+        results.push_back(throughputs);
+        std::filesystem::remove(file_path);
+    }
+
+    // whether a strategy kept up with the fastest one at a given size
+    auto competitive = [&](size_t size_index, size_t strategy_index) {
+        const std::vector<double>& row = results[size_index];
+        double best = *std::max_element(row.begin(), row.end());
+        return row[strategy_index] >= best * (1.0 - IO_BENCH_TOLERANCE);
+    };
+
+    // single reads pay off up to the end of the leading run of sizes where they kept up
+    size_t read_run = 0;
+    while (read_run < results.size() && competitive(read_run, 0)) {
+        read_run++;
+    }
+
+    // the memory map pays off from the start of the trailing run of sizes where it kept up
+    size_t mmap_run = results.size();
+    while (mmap_run > read_run && competitive(mmap_run - 1, IO_BENCH_STRATEGY_COUNT - 1)) {
+        mmap_run--;
+    }
+
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, ("Current thresholds: checksum_small_file_max = " + std::to_string(engine.small_file_max()) +
+                       ", checksum_mmap_min = " + std::to_string(engine.mmap_min())).c_str());
+
+    if (read_run > 0) {
+        dpm_con(LOG_INFO, ("Single reads keep up with the fastest strategy up to " + io_bench_format_size(sizes[read_run - 1]) +
+                           ", suggested [build] checksum_small_file_max = " +
+                           std::to_string(sizes[read_run - 1])).c_str());
+    } else {
+        dpm_con(LOG_INFO, "Single reads fell behind at the smallest size benchmarked, try smaller sizes");
+    }
+
+    if (mmap_run < results.size()) {
+        dpm_con(LOG_INFO, ("Memory maps keep up with the fastest strategy from " + io_bench_format_size(sizes[mmap_run]) +
+                           ", suggested [build] checksum_mmap_min = " + std::to_string(sizes[mmap_run])).c_str());
+    } else {
+        dpm_con(LOG_INFO, "Memory maps fell behind at the largest size benchmarked, try larger sizes");
+    }
+
+    return 0;
+}
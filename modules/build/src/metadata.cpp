@@ -12,10 +12,28 @@
 
 #include "metadata.hpp"
 
-// generates the initial entries for the stage - does not populate data!
-bool metadata_generate_skeleton(const std::filesystem::path& stage_dir) {
-    // generates empty files, such as when generating a new stage
-
+// the fields every stage has, empty until they are populated
+static const std::vector<std::string> METADATA_SKELETON_FIELDS = {
+    "NAME",
+    "VERSION",
+    "ARCHITECTURE",
+    "AUTHOR",
+    "MAINTAINER",
+    "DEPENDENCIES",
+    "DESCRIPTION",
+    "CONTENTS_MANIFEST_DIGEST",
+    "LICENSE",
+    "PACKAGE_DIGEST",
+    "HOOKS_DIGEST",
+    "PROVIDES",
+    "REPLACES",
+    "SOURCE",
+    "CHANGELOG"
+};
+
+// checks that the metadata directory of a stage exists and is a directory
+static bool metadata_directory_ready(const std::filesystem::path& stage_dir)
+{
     // determine the path to the metadata directory
     std::filesystem::path metadata_dir = stage_dir / "metadata";
 
@@ -30,32 +48,20 @@ bool metadata_generate_skeleton(const std::filesystem::path& stage_dir) {
         return false;
     }
 
-    try {
-        // Create empty placeholder files for all metadata
-        std::vector<std::string> metadata_files = {
-            "NAME",
-            "VERSION",
-            "ARCHITECTURE",
-            "AUTHOR",
-            "MAINTAINER",
-            "DEPENDENCIES",
-            "DESCRIPTION",
-            "CONTENTS_MANIFEST_DIGEST",
-            "LICENSE",
-            "PACKAGE_DIGEST",
-            "HOOKS_DIGEST",
-            "PROVIDES",
-            "REPLACES",
-            "SOURCE",
-            "CHANGELOG"
-        };
-
-        for (const auto& file_name : metadata_files) {
-            std::ofstream metadata_file(metadata_dir / file_name);
-            metadata_file.close();
-        }
-    } catch (const std::exception& e) {
-        dpm_log(LOG_ERROR, ("Failed to create metadata files: " + std::string(e.what())).c_str());
+    return true;
+}
+
+// generates the initial entries for the stage - does not populate data!
+bool metadata_generate_skeleton(const std::filesystem::path& stage_dir) {
+    // generates empty files, such as when generating a new stage
+    if (!metadata_directory_ready(stage_dir)) {
+        return false;
+    }
+
+    MetadataTransaction transaction(stage_dir);
+    metadata_generate_skeleton(transaction);
+    if (!transaction.commit()) {
+        dpm_log(LOG_ERROR, "Failed to create metadata files");
         return false;
     }
 
@@ -63,6 +69,14 @@ bool metadata_generate_skeleton(const std::filesystem::path& stage_dir) {
     return true;
 }
 
+void metadata_generate_skeleton(MetadataTransaction& transaction)
+{
+    // Empty placeholders for all metadata
+    for (const auto& field : METADATA_SKELETON_FIELDS) {
+        transaction.set(field, "");
+    }
+}
+
 bool metadata_set_simple_value(const std::filesystem::path& stage_dir, const std::string& key, const std::string& value)
 {
     // populates single-line entries
@@ -71,14 +85,7 @@ bool metadata_set_simple_value(const std::filesystem::path& stage_dir, const std
     std::filesystem::path metadata_file_path = stage_dir / "metadata" / key;
 
     // Check if the metadata directory exists
-    std::filesystem::path metadata_dir = stage_dir / "metadata";
-    if (!std::filesystem::exists(metadata_dir)) {
-        dpm_log(LOG_ERROR, ("Metadata directory does not exist: " + metadata_dir.string()).c_str());
-        return false;
-    }
-
-    if (!std::filesystem::is_directory(metadata_dir)) {
-        dpm_log(LOG_ERROR, ("Metadata path exists but is not a directory: " + metadata_dir.string()).c_str());
+    if (!metadata_directory_ready(stage_dir)) {
         return false;
     }
 
@@ -88,24 +95,19 @@ bool metadata_set_simple_value(const std::filesystem::path& stage_dir, const std
         return false;
     }
 
-    try {
-        // Open the file for writing (will overwrite existing content)
-        std::ofstream file(metadata_file_path);
-        if (!file.is_open()) {
-            dpm_log(LOG_ERROR, ("Failed to open metadata file for writing: " + metadata_file_path.string()).c_str());
-            return false;
-        }
-
-        // Write the value to the file
-        file << value;
-        file.close();
-
-        dpm_log(LOG_INFO, ("Set metadata " + key + " to: " + value).c_str());
-        return true;
-    } catch (const std::exception& e) {
-        dpm_log(LOG_ERROR, ("Failed to write metadata value: " + std::string(e.what())).c_str());
+    MetadataTransaction transaction(stage_dir);
+    metadata_set_simple_value(transaction, key, value);
+    if (!transaction.commit()) {
+        dpm_log(LOG_ERROR, ("Failed to write metadata value: " + key).c_str());
         return false;
     }
+    return true;
+}
+
+void metadata_set_simple_value(MetadataTransaction& transaction, const std::string& key, const std::string& value)
+{
+    transaction.set(key, value);
+    dpm_log(LOG_INFO, ("Set metadata " + key + " to: " + value).c_str());
 }
 
 bool metadata_set_initial_known_values(
@@ -114,98 +116,353 @@ bool metadata_set_initial_known_values(
     const std::string& package_version,
     const std::string& architecture
 ) {
-    std::filesystem::path metadata_dir = stage_dir / "metadata";
-
-    std::filesystem::path name_file = metadata_dir / "NAME";
-    std::filesystem::path version_file = metadata_dir / "VERSION";
-    std::filesystem::path architecture_file = metadata_dir / "ARCHITECTURE";
-
-    if (!metadata_set_simple_value( stage_dir, "NAME", package_name ))
-    {
-        dpm_log( LOG_FATAL, "Failed to set 'NAME'." );
+    if (!metadata_directory_ready(stage_dir)) {
         return false;
     }
 
-    if (!metadata_set_simple_value( stage_dir, "VERSION", package_version ))
-    {
-        dpm_log( LOG_FATAL, "Failed to set 'VERSION'." );
+    MetadataTransaction transaction(stage_dir);
+    metadata_set_initial_known_values(transaction, package_name, package_version, architecture);
+    if (!transaction.commit()) {
+        dpm_log( LOG_FATAL, "Failed to set 'NAME', 'VERSION' and 'ARCHITECTURE'." );
         return false;
     }
 
-    if (!metadata_set_simple_value( stage_dir, "ARCHITECTURE", architecture ))
-    {
-        dpm_log( LOG_FATAL, "Failed to set 'ARCHITECTURE'." );
-        return false;
+    return true;
+}
+
+void metadata_set_initial_known_values(
+    MetadataTransaction& transaction,
+    const std::string& package_name,
+    const std::string& package_version,
+    const std::string& architecture
+) {
+    metadata_set_simple_value( transaction, "NAME", package_name );
+    metadata_set_simple_value( transaction, "VERSION", package_version );
+    metadata_set_simple_value( transaction, "ARCHITECTURE", architecture );
+}
+
+/**
+ * @brief Resolves uid/gid pairs to "owner:group" strings, looking each id up only once
+ *
+ * NSS lookups can be slow (for example against LDAP), and a stage usually has
+ * very few distinct owners, so names are cached for the duration of a run.
+ *
+ * @param cache Cache of names resolved so far in this run
+ * @param uid Owner id of the file
+ * @param gid Group id of the file
+ * @return Ownership string, with numeric ids for unknown users or groups
+ */
+static std::string metadata_lookup_ownership(OwnershipNameCache& cache, uid_t uid, gid_t gid)
+{
+    auto user_it = cache.users.find(uid);
+    if (user_it == cache.users.end()) {
+        struct passwd* pw = getpwuid(uid);
+        user_it = cache.users.emplace(uid, pw ? std::string(pw->pw_name) : std::to_string(uid)).first;
     }
 
-    return true;
+    auto group_it = cache.groups.find(gid);
+    if (group_it == cache.groups.end()) {
+        struct group* gr = getgrgid(gid);
+        group_it = cache.groups.emplace(gid, gr ? std::string(gr->gr_name) : std::to_string(gid)).first;
+    }
+
+    return user_it->second + ":" + group_it->second;
+}
+
+/**
+ * @brief Gets the number of worker threads used to hash contents
+ *
+ * Uses the "threads" key in the [build] configuration section, falling back
+ * to the number of threads of the shared worker pool when it is unset or 0.
+ *
+ * @return Number of workers, always at least 1
+ */
+static size_t metadata_worker_count()
+{
+    return build_thread_share(build_config_thread_count("threads", dpm_worker_threads()));
+}
+
+/**
+ * @brief Digests of the additional algorithms for one manifest entry
+ */
+typedef std::pair<std::string, std::vector<std::string>> ExtraDigestRow;
+
+/**
+ * @brief Stages the additional algorithm digests of a stage, or their removal
+ *
+ * With a single configured algorithm any extra digests file left over from
+ * an earlier configuration is removed so it cannot go stale.
+ *
+ * @param transaction Metadata transaction of the package stage
+ * @param algorithms Configured hash algorithms, primary first
+ * @param rows Path and additional digests of each manifest entry, in manifest order
+ */
+static void metadata_write_extra_digests(MetadataTransaction& transaction,
+                                         const std::vector<std::string>& algorithms,
+                                         const std::vector<ExtraDigestRow>& rows)
+{
+    if (algorithms.size() <= 1) {
+        transaction.remove(CONTENTS_EXTRA_DIGESTS_FILENAME);
+        return;
+    }
+
+    // Format: # algorithms: alg2 alg3, then digest2 digest3 /path per entry
+    std::ostringstream extra_file;
+    extra_file << "# algorithms:";
+    for (size_t i = 1; i < algorithms.size(); i++) {
+        extra_file << " " << algorithms[i];
+    }
+    extra_file << "\n";
+
+    for (const auto& [relative_path, digests] : rows) {
+        for (const auto& digest : digests) {
+            extra_file << digest << " ";
+        }
+        extra_file << "/" << relative_path << "\n";
+    }
+
+    transaction.set(CONTENTS_EXTRA_DIGESTS_FILENAME, extra_file.str());
+}
+
+/**
+ * @brief Loads the additional algorithm digests of a stage
+ *
+ * Only digests recorded for exactly the configured additional algorithms
+ * are loaded, anything else is left to be recalculated.
+ *
+ * @param transaction Metadata transaction of the package stage
+ * @param algorithms Configured hash algorithms, primary first
+ * @param digests Receives the additional digests keyed by path relative to the contents directory
+ */
+static void metadata_load_extra_digests(MetadataTransaction& transaction,
+                                        const std::vector<std::string>& algorithms,
+                                        std::unordered_map<std::string, std::vector<std::string>>& digests)
+{
+    digests.clear();
+
+    std::string extra_digests;
+    if (algorithms.size() <= 1 || !transaction.get(CONTENTS_EXTRA_DIGESTS_FILENAME, extra_digests)) {
+        return;
+    }
+    std::istringstream extra_file(extra_digests);
+
+    std::string expected_header = "# algorithms:";
+    for (size_t i = 1; i < algorithms.size(); i++) {
+        expected_header += " " + algorithms[i];
+    }
+
+    std::string line;
+    if (!std::getline(extra_file, line) || line != expected_header) {
+        return;
+    }
+
+    while (std::getline(extra_file, line)) {
+        std::istringstream iss(line);
+        std::vector<std::string> row(algorithms.size() - 1);
+        bool complete = true;
+        for (auto& digest : row) {
+            complete = complete && static_cast<bool>(iss >> digest);
+        }
+
+        std::string file_path;
+        std::getline(iss >> std::ws, file_path);
+        if (!complete || file_path.empty()) {
+            continue;
+        }
+
+        if (file_path[0] == '/') {
+            file_path = file_path.substr(1);
+        }
+        digests[file_path] = row;
+    }
+}
+
+/**
+ * @brief Stages the binary index of the contents manifest, see ManifestIndex.hpp
+ *
+ * A manifest that cannot be indexed, for example because it holds lines
+ * that are not entries, gets no index and readers parse the text instead.
+ *
+ * @param transaction Metadata transaction of the package stage
+ * @param manifest Text of the manifest
+ * @param entries Entries of the manifest, in manifest order
+ * @param algorithm Algorithm of the manifest's checksums
+ * @param indexable Whether every line of the manifest is one of the entries
+ */
+static void metadata_write_manifest_index(MetadataTransaction& transaction, const std::string& manifest,
+                                          const std::vector<ManifestIndexSource>& entries,
+                                          const std::string& algorithm, bool indexable)
+{
+    std::string index;
+    std::string manifest_digest = indexable ? generate_string_checksum(manifest) : "";
+    if (manifest_digest.empty() ||
+        !manifest_index_build(entries, algorithm, manifest.size(), manifest_digest, index)) {
+        dpm_log(LOG_DEBUG, "Contents manifest cannot be indexed, leaving it without a binary index");
+        transaction.remove(CONTENTS_MANIFEST_INDEX_FILENAME);
+        return;
+    }
+
+    transaction.set(CONTENTS_MANIFEST_INDEX_FILENAME, index);
 }
 
+/**
+ * @brief A file queued for hashing while generating the contents manifest
+ */
+struct ManifestGenerationEntry {
+    std::filesystem::path file_path;    ///< Path of the file on disk
+    std::string relative_path;          ///< Path relative to the contents directory
+    std::string permissions;            ///< Octal permission bits
+    std::string ownership;              ///< owner:group
+    std::vector<std::string> checksums; ///< Checksums filled in by a hashing worker, primary first
+    struct stat st;                     ///< Stat of the file from the walk
+    bool prefetched;                    ///< Whether the file is read ahead through io_uring
+};
+
 bool metadata_generate_contents_manifest_digest(const std::filesystem::path& package_dir)
 {
+    MetadataTransaction transaction(package_dir);
+    return metadata_generate_contents_manifest_digest(transaction) && transaction.commit();
+}
+
+bool metadata_generate_contents_manifest_digest(MetadataTransaction& transaction)
+{
+    DpmProfileScope profile("generate_contents_manifest");
+
     try {
+        const std::filesystem::path& package_dir = transaction.stage_dir();
         std::filesystem::path contents_dir = package_dir / "contents";
-        std::filesystem::path manifest_path = package_dir / "metadata" / "CONTENTS_MANIFEST_DIGEST";
 
-        // Log which hash algorithm is being used
-        std::string hash_algorithm = get_configured_hash_algorithm();
+        // Log which hash algorithms are being used
+        std::vector<std::string> hash_algorithms = get_configured_hash_algorithms();
+        std::string hash_algorithm = hash_algorithms.front();
         dpm_log(LOG_INFO, ("Generating contents manifest using " + hash_algorithm + " checksums...").c_str());
+        if (hash_algorithms.size() > 1) {
+            dpm_log(LOG_INFO, ("Also recording " + std::to_string(hash_algorithms.size() - 1) +
+                              " additional digest(s) per file in " + CONTENTS_EXTRA_DIGESTS_FILENAME).c_str());
+        }
 
-        // Open manifest file for writing
-        std::ofstream manifest_file(manifest_path);
-        if (!manifest_file.is_open()) {
-            dpm_log(LOG_ERROR, ("Failed to open manifest file for writing: " + manifest_path.string()).c_str());
+        // The manifest is collected here and written when the transaction is committed
+        std::string manifest;
+
+        // Walk the contents directory first, sorted, so the manifest stays deterministic
+        std::vector<ManifestGenerationEntry> entries;
+        OwnershipNameCache ownership_cache;
+
+        TreeWalk walk;
+        if (!tree_walk(contents_dir, walk, tree_walk_worker_count())) {
+            dpm_log(LOG_FATAL, ("Failed to walk contents directory: " + contents_dir.string()).c_str());
             return false;
         }
 
-        // Process each file in the contents directory recursively
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(contents_dir)) {
+        for (const auto& entry : walk) {
             // Skip directories, we only need to record files
-            if (std::filesystem::is_directory(entry)) {
+            if (entry.is_directory) {
                 continue;
             }
 
             // Get file information
-            std::filesystem::path file_path = entry.path();
-            std::filesystem::path relative_path = std::filesystem::relative(file_path, contents_dir);
-            std::string absolute_path = "/" + relative_path.string();  // Add leading slash
+            std::filesystem::path file_path = contents_dir / entry.relative_path;
 
-            // Get file stats for permissions
-            struct stat file_stat;
-            if (stat(file_path.c_str(), &file_stat) != 0) {
+            // Permissions are those of the file a symlink points to, the walk only has the link's
+            struct stat file_stat = entry.st;
+            if (S_ISLNK(file_stat.st_mode) && stat(file_path.c_str(), &file_stat) != 0) {
                 dpm_log(LOG_FATAL, ("Failed to get file stats for: " + file_path.string()).c_str());
                 return false;
             }
 
             // Format permissions as octal
-            char perms[5];
-            snprintf(perms, sizeof(perms), "%04o", file_stat.st_mode & 07777);
-
-            // Get owner and group information
-            struct passwd* pw = getpwuid(file_stat.st_uid);
-            struct group* gr = getgrgid(file_stat.st_gid);
+            char perms[MANIFEST_PERMISSIONS_LENGTH + 1];
+
+            entries.push_back({
+                file_path,
+                entry.relative_path,
+                std::string(manifest_format_permissions(file_stat.st_mode, perms)),
+                metadata_lookup_ownership(ownership_cache, file_stat.st_uid, file_stat.st_gid),
+                {},
+                file_stat,
+                false
+            });
+        }
 
-            std::string owner;
-            if (pw) {
-                owner = pw->pw_name;
-            } else {
-                owner = std::to_string(file_stat.st_uid);
+        // Small files are read ahead in deep batches where io_uring is available, plain reads stay on the workers
+        std::vector<std::string> prefetch_paths;
+        std::vector<uint64_t> prefetch_sizes;
+        if (UringFileReader::supported()) {
+            for (auto& manifest_entry : entries) {
+                const struct stat& st = manifest_entry.st;
+                if (S_ISREG(st.st_mode) && static_cast<uint64_t>(st.st_size) <= FILE_PREFETCH_MAX_FILE_SIZE) {
+                    manifest_entry.prefetched = true;
+                    prefetch_paths.push_back(manifest_entry.file_path.string());
+                    prefetch_sizes.push_back(static_cast<uint64_t>(st.st_size));
+                }
             }
-
-            std::string group;
-            if (gr) {
-                group = gr->gr_name;
-            } else {
-                group = std::to_string(file_stat.st_gid);
+        }
+        FilePrefetcher prefetcher(std::move(prefetch_paths), std::move(prefetch_sizes), FILE_PREFETCH_MEMORY_LIMIT);
+        std::mutex claim_mutex;
+
+        // Hash on the shared worker pool; each worker records its files in its own stat cache for later refreshes
+        size_t worker_count = std::min(metadata_worker_count(), std::max<size_t>(entries.size(), 1));
+        DPM_LOG(LOG_DEBUG, "Hashing ", entries.size(), " files with ", worker_count, " workers");
+
+        StatCache previous_cache;
+        std::vector<StatCache> worker_caches(worker_count);
+        std::atomic<size_t> next_entry(0);
+
+        dpm_parallel_for_each(0, worker_count, 1, [&](size_t first_worker, size_t last_worker) {
+            for (size_t worker_index = first_worker; worker_index < last_worker; worker_index++) {
+                while (true) {
+                    // prefetched files are handed out in entry order, so they are taken with their entry
+                    size_t i = 0;
+                    PrefetchedFile prefetched = { -1, {} };
+                    {
+                        std::lock_guard<std::mutex> lock(claim_mutex);
+                        i = next_entry++;
+                        if (i >= entries.size()) {
+                            break;
+                        }
+                        if (entries[i].prefetched && !prefetcher.next(prefetched)) {
+                            prefetched.error = -1;
+                        }
+                    }
+
+                    std::vector<std::string> checksums;
+                    try {
+                        if (prefetched.error == 0) {
+                            dpm_metric_add(DPM_METRIC_STAT_CACHE_MISSES, 1);
+                            checksums = generate_buffer_checksums(prefetched.data.data(), prefetched.data.size(),
+                                                                  hash_algorithms);
+                            if (!checksums.empty()) {
+                                worker_caches[worker_index][entries[i].relative_path] =
+                                    stat_cache_make_entry(entries[i].st, hash_algorithms, checksums);
+                            }
+                        } else {
+                            bool reused = false;
+                            checksums = stat_cache_file_checksums(previous_cache, worker_caches[worker_index],
+                                                                  entries[i].relative_path, entries[i].file_path,
+                                                                  hash_algorithms, true, reused);
+                        }
+                    } catch (const std::exception& e) {
+                        dpm_log(LOG_ERROR, ("Error hashing " + entries[i].file_path.string() + ": " + e.what()).c_str());
+                    }
+
+                    // stop handing out work once a file has failed
+                    if (checksums.empty()) {
+                        next_entry = entries.size();
+                    }
+                    entries[i].checksums = std::move(checksums);
+                }
             }
-
-            std::string ownership = owner + ":" + group;
-
-            // Calculate file checksum using the configured algorithm
-            std::string checksum = generate_file_checksum(file_path);
-            if (checksum.empty()) {
-                dpm_log(LOG_FATAL, ("Failed to generate checksum for: " + file_path.string()).c_str());
-                return false;
+        });
+
+        // Write entries in walk order
+        std::vector<ExtraDigestRow> extra_rows;
+        std::vector<ManifestIndexSource> index_entries;
+        bool success = true;
+        for (auto& manifest_entry : entries) {
+            if (manifest_entry.checksums.empty()) {
+                dpm_log(LOG_FATAL, ("Failed to generate checksum for: " + manifest_entry.file_path.string()).c_str());
+                success = false;
+                break;
             }
 
             // By default, mark all files as controlled ('C')
@@ -213,14 +470,42 @@ bool metadata_generate_contents_manifest_digest(const std::filesystem::path& pac
 
             // Write the manifest entry
             // Format: control_designation checksum permissions owner:group /absolute/path
-            manifest_file << control_designation << " "
-                          << checksum << " "
-                          << perms << " "
-                          << ownership << " "
-                          << absolute_path << "\n";
+            manifest_append_line(manifest, control_designation, manifest_entry.checksums.front(),
+                                 manifest_entry.permissions, manifest_entry.ownership, manifest_entry.relative_path);
+            index_entries.push_back({ control_designation, manifest_entry.checksums.front(),
+                                      manifest_entry.permissions, manifest_entry.ownership,
+                                      manifest_entry.relative_path,
+                                      static_cast<uint32_t>(index_entries.size() + 1) });
+
+            if (hash_algorithms.size() > 1) {
+                extra_rows.emplace_back(manifest_entry.relative_path,
+                                        std::vector<std::string>(manifest_entry.checksums.begin() + 1,
+                                                                 manifest_entry.checksums.end()));
+            }
+        }
+
+        if (!success) {
+            return false;
+        }
+        metadata_write_manifest_index(transaction, manifest, index_entries, hash_algorithm, true);
+        transaction.set("CONTENTS_MANIFEST_DIGEST", manifest);
+        metadata_write_extra_digests(transaction, hash_algorithms, extra_rows);
+
+        // Large files additionally get chunk digests so they can be verified in parallel
+        std::vector<std::pair<std::string, bool>> chunk_files;
+        chunk_files.reserve(entries.size());
+        for (const auto& manifest_entry : entries) {
+            chunk_files.emplace_back(manifest_entry.relative_path, false);
+        }
+        if (!chunk_manifest_update(package_dir, hash_algorithm, chunk_files, metadata_worker_count())) {
+            return false;
         }
 
-        manifest_file.close();
+        StatCache stat_cache;
+        for (auto& worker_cache : worker_caches) {
+            stat_cache.merge(worker_cache);
+        }
+        stat_cache_save(package_dir, stat_cache);
         return true;
     }
     catch (const std::exception& e) {
@@ -229,12 +514,25 @@ bool metadata_generate_contents_manifest_digest(const std::filesystem::path& pac
     }
 }
 
-int metadata_refresh_contents_manifest_digest(const std::string& stage_dir, bool force) {
-    dpm_log(LOG_INFO, ("Refreshing package manifest for: " + stage_dir).c_str());
+int metadata_refresh_contents_manifest_digest(const std::string& stage_dir, bool force, bool full_rehash,
+                                              const StatCache* known_digests, const TreeWalk* contents_walk) {
+    MetadataTransaction transaction(stage_dir);
+    int result = metadata_refresh_contents_manifest_digest(transaction, force, full_rehash, known_digests,
+                                                           contents_walk);
+    if (result == 0 && !transaction.commit()) {
+        dpm_log(LOG_ERROR, "Failed to update manifest file");
+        return 1;
+    }
+    return result;
+}
+
+int metadata_refresh_contents_manifest_digest(MetadataTransaction& transaction, bool force, bool full_rehash,
+                                              const StatCache* known_digests, const TreeWalk* contents_walk) {
+    DpmProfileScope profile("refresh_contents_manifest");
+    const std::filesystem::path& package_dir = transaction.stage_dir();
+    dpm_log(LOG_INFO, ("Refreshing package manifest for: " + package_dir.string()).c_str());
 
-    std::filesystem::path package_dir = std::filesystem::path(stage_dir);
     std::filesystem::path contents_dir = package_dir / "contents";
-    std::filesystem::path manifest_path = package_dir / "metadata" / "CONTENTS_MANIFEST_DIGEST";
 
     // Check if contents directory exists
     if (!std::filesystem::exists(contents_dir)) {
@@ -242,136 +540,197 @@ int metadata_refresh_contents_manifest_digest(const std::string& stage_dir, bool
         return 1;
     }
 
-    // Map to track all files in the contents directory
-    std::map<std::filesystem::path, bool> all_content_files;
+    // Every file in the contents directory, and whether the manifest already lists it
+    std::unordered_map<std::string, bool> all_content_files;
 
-    // Populate map with all files in contents directory
-    for (const auto& entry : std::filesystem::recursive_directory_iterator(contents_dir)) {
-        if (!std::filesystem::is_directory(entry)) {
+    // Populate map with all files in contents directory, walking it unless the caller just did
+    TreeWalk own_walk;
+    if (!contents_walk) {
+        if (!tree_walk(contents_dir, own_walk, tree_walk_worker_count())) {
+            dpm_log(LOG_ERROR, ("Failed to walk contents directory: " + contents_dir.string()).c_str());
+            return 1;
+        }
+        contents_walk = &own_walk;
+    }
+    for (const auto& entry : *contents_walk) {
+        if (!entry.is_directory) {
             // Store path relative to contents directory
-            std::filesystem::path relative_path = std::filesystem::relative(entry.path(), contents_dir);
-            all_content_files[relative_path] = false; // Not processed yet
+            all_content_files.emplace(entry.relative_path, false); // Not processed yet
         }
     }
 
-    // Check if manifest file exists
-    bool manifest_exists = std::filesystem::exists(manifest_path);
+    // The existing manifest, if there is one, comes from the transaction
+    std::string previous_manifest;
+    bool manifest_exists = transaction.get("CONTENTS_MANIFEST_DIGEST", previous_manifest);
 
-    // Create a temporary file for the updated manifest
-    std::filesystem::path temp_manifest_path = manifest_path.string() + ".tmp";
-    std::ofstream temp_manifest_file(temp_manifest_path);
-    if (!temp_manifest_file.is_open()) {
-        dpm_log(LOG_ERROR, ("Failed to create temporary manifest file: " + temp_manifest_path.string()).c_str());
-        return 1;
-    }
+    // The updated manifest is collected here and written when the transaction is committed
+    std::string temp_manifest_file;
 
-    // Log which hash algorithm is being used
-    std::string hash_algorithm = get_configured_hash_algorithm();
+    // Log which hash algorithms are being used
+    std::vector<std::string> hash_algorithms = get_configured_hash_algorithms();
+    std::string hash_algorithm = hash_algorithms.front();
     dpm_log(LOG_INFO, ("Refreshing contents manifest using " + hash_algorithm + " checksums...").c_str());
 
+    // Additional digests are rewritten alongside the manifest, in the same order
+    std::unordered_map<std::string, std::vector<std::string>> previous_extra_digests;
+    std::vector<ExtraDigestRow> extra_rows;
+    bool record_extra = hash_algorithms.size() > 1;
+    if (record_extra) {
+        metadata_load_extra_digests(transaction, hash_algorithms, previous_extra_digests);
+    }
+
+    // Files whose stat tuple is unchanged since the last refresh keep their digest
+    StatCache previous_cache;
+    StatCache updated_cache;
+    if (!full_rehash) {
+        stat_cache_load(package_dir, previous_cache);
+    }
+
+    // Digests calculated by the caller take the place of the cached ones
+    StatCache lookup_cache = previous_cache;
+    if (known_digests) {
+        for (const auto& [relative_path, entry] : *known_digests) {
+            lookup_cache[relative_path] = entry;
+        }
+    }
+
+    // The chunk digests of a file are only kept if it is unchanged since the last refresh,
+    // not merely hashed by the caller
+    auto unchanged_since_refresh = [&](const std::string& relative_path, bool reused_digest) {
+        if (!reused_digest || !known_digests) {
+            return reused_digest;
+        }
+        auto known = known_digests->find(relative_path);
+        if (known == known_digests->end()) {
+            return true;
+        }
+        auto previous = previous_cache.find(relative_path);
+        return previous != previous_cache.end() &&
+               previous->second.size == known->second.size &&
+               previous->second.algorithm == known->second.algorithm &&
+               previous->second.digest == known->second.digest;
+    };
+
     int updated_files = 0;
     int new_files = 0;
+    int reused_files = 0;
+    bool reused = false;
+
+    // Files in manifest order, and whether each was unchanged, for the chunk manifest
+    std::vector<std::pair<std::string, bool>> chunk_files;
+    OwnershipNameCache ownership_cache;
+
+    // Entries of the refreshed manifest for its binary index, which only covers a manifest without stray lines
+    std::vector<ManifestIndexSource> index_entries;
+    uint32_t manifest_lines = 0;
+    bool indexable = true;
 
     // First process existing manifest file if it exists
     if (manifest_exists) {
-        std::ifstream manifest_file(manifest_path);
-        if (!manifest_file.is_open()) {
-            dpm_log(LOG_ERROR, ("Failed to open manifest file for reading: " + manifest_path.string()).c_str());
-            temp_manifest_file.close();
-            std::filesystem::remove(temp_manifest_path);
-            return 1;
-        }
-
-        std::string line;
+        std::string_view remaining(previous_manifest);
+        std::string_view line;
         int line_number = 0;
+        size_t digest_length = manifest_digest_length(hash_algorithm);
 
         // Process each line in the manifest
-        while (std::getline(manifest_file, line)) {
+        while (manifest_next_line(remaining, line)) {
             line_number++;
 
             // Skip empty lines
             if (line.empty()) {
-                temp_manifest_file << line << std::endl;
+                temp_manifest_file.push_back('\n');
+                indexable = false;
                 continue;
             }
 
-            // Parse the line into its components
-            std::istringstream iss(line);
-            char control_designation;
-            std::string checksum, permissions, ownership, file_path;
-
-            // Extract components (C checksum permissions owner:group /path/to/file)
-            iss >> control_designation >> checksum >> permissions >> ownership;
-
-            // The file path might contain spaces, so we need to get the rest of the line
-            std::getline(iss >> std::ws, file_path);
+            // Parse the line into its components (C checksum permissions owner:group /path/to/file)
+            ManifestLine manifest_line;
 
             // Skip if we couldn't parse the line correctly
-            if (file_path.empty()) {
-                dpm_log(LOG_WARN, ("Skipping malformed line " + std::to_string(line_number) + ": " + line).c_str());
-                temp_manifest_file << line << std::endl;
+            if (!manifest_parse_line(line, manifest_line, digest_length)) {
+                dpm_log(LOG_WARN, ("Skipping malformed line " + std::to_string(line_number) + ": " +
+                                   std::string(line)).c_str());
+                temp_manifest_file.append(line);
+                temp_manifest_file.push_back('\n');
+                indexable = false;
                 continue;
             }
 
-            // Remove leading slash from file_path if present
-            if (file_path[0] == '/') {
-                file_path = file_path.substr(1);
-            }
+            char control_designation = manifest_line.control;
+            std::string_view checksum = manifest_line.checksum;
+            std::string_view permissions = manifest_line.permissions;
+            std::string_view ownership = manifest_line.ownership;
+            std::string file_path(manifest_relative_path(manifest_line.path));
 
             // Mark this file as processed
-            std::filesystem::path relative_path(file_path);
-            if (all_content_files.find(relative_path) != all_content_files.end()) {
-                all_content_files[relative_path] = true; // Mark as processed
+            auto content_file = all_content_files.find(file_path);
+            if (content_file != all_content_files.end()) {
+                content_file->second = true; // Mark as processed
             }
 
             // Construct the full path to the file in the contents directory
             std::filesystem::path full_file_path = contents_dir / file_path;
 
-            // Check if the file exists
-            if (!std::filesystem::exists(full_file_path)) {
+            // Check if the file exists, the walk already found every file that does
+            if (content_file == all_content_files.end() && !std::filesystem::exists(full_file_path)) {
                 dpm_log(LOG_WARN, ("File not found in contents directory: " + full_file_path.string()).c_str());
                 // Keep the original line
-                temp_manifest_file << control_designation << " "
-                                  << checksum << " "
-                                  << permissions << " "
-                                  << ownership << " "
-                                  << "/" << file_path << std::endl;
+                manifest_append_line(temp_manifest_file, control_designation, checksum, permissions, ownership,
+                                     file_path);
+                index_entries.push_back({ control_designation, std::string(checksum), std::string(permissions),
+                                          std::string(ownership), file_path, static_cast<uint32_t>(line_number) });
+
+                auto previous_extra = previous_extra_digests.find(file_path);
+                if (record_extra && previous_extra != previous_extra_digests.end()) {
+                    extra_rows.emplace_back(file_path, previous_extra->second);
+                }
                 continue;
             }
 
-            // Calculate new checksum
-            std::string new_checksum = generate_file_checksum(full_file_path);
-            if (new_checksum.empty()) {
+            // Calculate new checksums, unless the file is unchanged since it was last hashed
+            std::vector<std::string> new_checksums = stat_cache_file_checksums(lookup_cache, updated_cache, file_path,
+                                                                               full_file_path, hash_algorithms,
+                                                                               full_rehash, reused);
+            if (reused) {
+                reused_files++;
+            }
+            if (new_checksums.empty()) {
                 dpm_log(LOG_ERROR, ("Failed to generate checksum for: " + full_file_path.string()).c_str());
-                manifest_file.close();
-                temp_manifest_file.close();
-                std::filesystem::remove(temp_manifest_path);
                 return 1;
             }
 
+            const std::string& new_checksum = new_checksums.front();
+            chunk_files.emplace_back(file_path, unchanged_since_refresh(file_path, reused));
+            if (record_extra) {
+                extra_rows.emplace_back(file_path, std::vector<std::string>(new_checksums.begin() + 1,
+                                                                            new_checksums.end()));
+            }
+
             // Write updated line to the temporary file
-            temp_manifest_file << control_designation << " "
-                              << new_checksum << " "
-                              << permissions << " "
-                              << ownership << " "
-                              << "/" << file_path << std::endl;
+            manifest_append_line(temp_manifest_file, control_designation, new_checksum, permissions, ownership,
+                                 file_path);
+            index_entries.push_back({ control_designation, new_checksum, std::string(permissions),
+                                      std::string(ownership), file_path, static_cast<uint32_t>(line_number) });
 
             // Count updated files (only if checksum actually changed)
             if (new_checksum != checksum) {
                 updated_files++;
             }
         }
-
-        manifest_file.close();
+        manifest_lines = static_cast<uint32_t>(line_number);
     }
 
-    // Now process any new files not in the manifest
+    // Now process any new files not in the manifest, in path order
+    std::vector<std::filesystem::path> new_content_files;
     for (const auto& [file_path, processed] : all_content_files) {
         // Skip if already processed from manifest
-        if (processed) {
-            continue;
+        if (!processed) {
+            new_content_files.emplace_back(file_path);
         }
+    }
+    std::sort(new_content_files.begin(), new_content_files.end());
 
+    for (const auto& file_path : new_content_files) {
         // This is a new file
         std::filesystem::path full_file_path = contents_dir / file_path;
 
@@ -383,61 +742,58 @@ int metadata_refresh_contents_manifest_digest(const std::string& stage_dir, bool
         }
 
         // Format permissions as octal
-        char perms[5];
-        snprintf(perms, sizeof(perms), "%04o", file_stat.st_mode & 07777);
+        char perms_buffer[MANIFEST_PERMISSIONS_LENGTH + 1];
+        std::string_view perms = manifest_format_permissions(file_stat.st_mode, perms_buffer);
 
         // Get owner and group information
-        struct passwd* pw = getpwuid(file_stat.st_uid);
-        struct group* gr = getgrgid(file_stat.st_gid);
-
-        std::string owner;
-        if (pw) {
-            owner = pw->pw_name;
-        } else {
-            owner = std::to_string(file_stat.st_uid);
+        std::string ownership = metadata_lookup_ownership(ownership_cache, file_stat.st_uid, file_stat.st_gid);
+
+        // Calculate checksums
+        std::vector<std::string> checksums = stat_cache_file_checksums(lookup_cache, updated_cache,
+                                                                       file_path.string(), full_file_path,
+                                                                       hash_algorithms, full_rehash, reused);
+        if (reused) {
+            reused_files++;
         }
-
-        std::string group;
-        if (gr) {
-            group = gr->gr_name;
-        } else {
-            group = std::to_string(file_stat.st_gid);
-        }
-
-        std::string ownership = owner + ":" + group;
-
-        // Calculate checksum
-        std::string checksum = generate_file_checksum(full_file_path);
-        if (checksum.empty()) {
+        if (checksums.empty()) {
             dpm_log(LOG_ERROR, ("Failed to generate checksum for: " + full_file_path.string()).c_str());
             continue;
         }
 
+        const std::string& checksum = checksums.front();
+        chunk_files.emplace_back(file_path.string(), unchanged_since_refresh(file_path.string(), reused));
+        if (record_extra) {
+            extra_rows.emplace_back(file_path.string(), std::vector<std::string>(checksums.begin() + 1,
+                                                                                 checksums.end()));
+        }
+
         // By default, mark new files as controlled ('C')
         char control_designation = 'C';
 
         // Write new line to the temporary file
-        temp_manifest_file << control_designation << " "
-                          << checksum << " "
-                          << perms << " "
-                          << ownership << " "
-                          << "/" << file_path.string() << std::endl;
+        manifest_append_line(temp_manifest_file, control_designation, checksum, perms, ownership,
+                             file_path.string());
+        index_entries.push_back({ control_designation, checksum, std::string(perms), ownership, file_path.string(),
+                                  ++manifest_lines });
 
         new_files++;
     }
 
-    temp_manifest_file.close();
+    // Replace the original manifest when the transaction is committed
+    std::string refreshed_manifest = std::move(temp_manifest_file);
+    metadata_write_manifest_index(transaction, refreshed_manifest, index_entries, hash_algorithm, indexable);
+    transaction.set("CONTENTS_MANIFEST_DIGEST", refreshed_manifest);
+    metadata_write_extra_digests(transaction, hash_algorithms, extra_rows);
 
-    // Replace the original file with the temporary file
-    try {
-        std::filesystem::rename(temp_manifest_path, manifest_path);
-    } catch (const std::filesystem::filesystem_error& e) {
-        dpm_log(LOG_ERROR, ("Failed to update manifest file: " + std::string(e.what())).c_str());
-        std::filesystem::remove(temp_manifest_path);
+    if (!chunk_manifest_update(package_dir, hash_algorithm, chunk_files, metadata_worker_count())) {
         return 1;
     }
 
+    // Entries for files that have since been removed are dropped with the old cache
+    stat_cache_save(package_dir, updated_cache);
+
     // Log results
+    dpm_log(LOG_INFO, ("Reused cached checksums for " + std::to_string(reused_files) + " unchanged file(s).").c_str());
     if (updated_files > 0) {
         dpm_log(LOG_INFO, ("Updated checksums for " + std::to_string(updated_files) + " existing file(s).").c_str());
     }
@@ -448,11 +804,18 @@ int metadata_refresh_contents_manifest_digest(const std::string& stage_dir, bool
     return 0;
 }
 
-bool metadata_generate_hooks_digest(const std::filesystem::path& stage_dir)
+bool metadata_generate_hooks_digest(const std::filesystem::path& stage_dir,
+                                    const std::unordered_map<std::string, std::string>* known_checksums)
+{
+    MetadataTransaction transaction(stage_dir);
+    return metadata_generate_hooks_digest(transaction, known_checksums) && transaction.commit();
+}
+
+bool metadata_generate_hooks_digest(MetadataTransaction& transaction,
+                                    const std::unordered_map<std::string, std::string>* known_checksums)
 {
     try {
-        std::filesystem::path hooks_dir = stage_dir / "hooks";
-        std::filesystem::path digest_path = stage_dir / "metadata" / "HOOKS_DIGEST";
+        std::filesystem::path hooks_dir = transaction.stage_dir() / "hooks";
 
         // Check if hooks directory exists
         if (!std::filesystem::exists(hooks_dir)) {
@@ -464,12 +827,8 @@ bool metadata_generate_hooks_digest(const std::filesystem::path& stage_dir)
         std::string hash_algorithm = get_configured_hash_algorithm();
         dpm_log(LOG_INFO, ("Generating hooks digest using " + hash_algorithm + " checksums...").c_str());
 
-        // Open digest file for writing
-        std::ofstream digest_file(digest_path);
-        if (!digest_file.is_open()) {
-            dpm_log(LOG_ERROR, ("Failed to open hooks digest file for writing: " + digest_path.string()).c_str());
-            return false;
-        }
+        // The digest is collected here and written when the transaction is committed
+        std::string digest_file;
 
         // Process each file in the hooks directory
         for (const auto& entry : std::filesystem::directory_iterator(hooks_dir)) {
@@ -482,8 +841,13 @@ bool metadata_generate_hooks_digest(const std::filesystem::path& stage_dir)
             std::filesystem::path file_path = entry.path();
             std::string filename = entry.path().filename().string();
 
-            // Calculate file checksum using the configured algorithm
-            std::string checksum = generate_file_checksum(file_path);
+            // Calculate file checksum using the configured algorithm, unless the caller already did
+            std::string checksum;
+            if (known_checksums && known_checksums->count(filename) > 0) {
+                checksum = known_checksums->at(filename);
+            } else {
+                checksum = generate_file_checksum(file_path);
+            }
             if (checksum.empty()) {
                 dpm_log(LOG_FATAL, ("Failed to generate checksum for: " + file_path.string()).c_str());
                 return false;
@@ -491,10 +855,10 @@ bool metadata_generate_hooks_digest(const std::filesystem::path& stage_dir)
 
             // Write the digest entry
             // Format: checksum filename
-            digest_file << checksum << " " << filename << "\n";
+            hooks_digest_append_line(digest_file, checksum, filename);
         }
 
-        digest_file.close();
+        transaction.set("HOOKS_DIGEST", digest_file);
         dpm_log(LOG_INFO, "Hooks digest generated successfully");
         return true;
     }
@@ -506,18 +870,25 @@ bool metadata_generate_hooks_digest(const std::filesystem::path& stage_dir)
 
 bool metadata_generate_package_digest(const std::filesystem::path& stage_dir)
 {
-    try {
-        std::filesystem::path contents_manifest_path = stage_dir / "metadata" / "CONTENTS_MANIFEST_DIGEST";
-        std::filesystem::path hooks_digest_path = stage_dir / "metadata" / "HOOKS_DIGEST";
+    MetadataTransaction transaction(stage_dir);
+    return metadata_generate_package_digest(transaction) && transaction.commit();
+}
 
-        // Check if required files exist
-        if (!std::filesystem::exists(contents_manifest_path)) {
-            dpm_log(LOG_ERROR, ("CONTENTS_MANIFEST_DIGEST not found: " + contents_manifest_path.string()).c_str());
+bool metadata_generate_package_digest(MetadataTransaction& transaction)
+{
+    try {
+        // Both digests come from the transaction, so ones generated in it are not read back from disk
+        std::string contents_manifest;
+        if (!transaction.get("CONTENTS_MANIFEST_DIGEST", contents_manifest)) {
+            dpm_log(LOG_ERROR, ("CONTENTS_MANIFEST_DIGEST not found: " +
+                               (transaction.stage_dir() / "metadata" / "CONTENTS_MANIFEST_DIGEST").string()).c_str());
             return false;
         }
 
-        if (!std::filesystem::exists(hooks_digest_path)) {
-            dpm_log(LOG_ERROR, ("HOOKS_DIGEST not found: " + hooks_digest_path.string()).c_str());
+        std::string hooks_digest;
+        if (!transaction.get("HOOKS_DIGEST", hooks_digest)) {
+            dpm_log(LOG_ERROR, ("HOOKS_DIGEST not found: " +
+                               (transaction.stage_dir() / "metadata" / "HOOKS_DIGEST").string()).c_str());
             return false;
         }
 
@@ -525,16 +896,16 @@ bool metadata_generate_package_digest(const std::filesystem::path& stage_dir)
         std::string hash_algorithm = get_configured_hash_algorithm();
         dpm_log(LOG_INFO, ("Generating package digest using " + hash_algorithm + " checksums...").c_str());
 
-        // Calculate checksums of both files
-        std::string contents_manifest_checksum = generate_file_checksum(contents_manifest_path);
+        // Calculate checksums of both digests
+        std::string contents_manifest_checksum = generate_string_checksum(contents_manifest);
         if (contents_manifest_checksum.empty()) {
-            dpm_log(LOG_ERROR, ("Failed to generate checksum for: " + contents_manifest_path.string()).c_str());
+            dpm_log(LOG_ERROR, "Failed to generate checksum for: CONTENTS_MANIFEST_DIGEST");
             return false;
         }
 
-        std::string hooks_digest_checksum = generate_file_checksum(hooks_digest_path);
+        std::string hooks_digest_checksum = generate_string_checksum(hooks_digest);
         if (hooks_digest_checksum.empty()) {
-            dpm_log(LOG_ERROR, ("Failed to generate checksum for: " + hooks_digest_path.string()).c_str());
+            dpm_log(LOG_ERROR, "Failed to generate checksum for: HOOKS_DIGEST");
             return false;
         }
 
@@ -549,10 +920,7 @@ bool metadata_generate_package_digest(const std::filesystem::path& stage_dir)
         }
 
         // Set the package digest in the metadata
-        if (!metadata_set_simple_value(stage_dir, "PACKAGE_DIGEST", package_digest)) {
-            dpm_log(LOG_ERROR, "Failed to set PACKAGE_DIGEST value");
-            return false;
-        }
+        metadata_set_simple_value(transaction, "PACKAGE_DIGEST", package_digest);
 
         dpm_log(LOG_INFO, "Package digest generated successfully");
         return true;
@@ -565,24 +933,30 @@ bool metadata_generate_package_digest(const std::filesystem::path& stage_dir)
 
 // generates the dynamic entries for the stage
 bool metadata_generate_dynamic_files(const std::filesystem::path& stage_dir)
+{
+    MetadataTransaction transaction(stage_dir);
+    return metadata_generate_dynamic_files(transaction) && transaction.commit();
+}
+
+bool metadata_generate_dynamic_files(MetadataTransaction& transaction)
 {
     // Generate contents manifest
     dpm_log(LOG_INFO, "Generating contents manifest digest...");
-    if (!metadata_generate_contents_manifest_digest(stage_dir)) {
+    if (!metadata_generate_contents_manifest_digest(transaction)) {
         dpm_log(LOG_ERROR, "Failed to generate contents manifest digest");
         return false;
     }
 
     // Generate hooks digest
     dpm_log(LOG_INFO, "Generating hooks digest...");
-    if (!metadata_generate_hooks_digest(stage_dir)) {
+    if (!metadata_generate_hooks_digest(transaction)) {
         dpm_log(LOG_ERROR, "Failed to generate hooks digest");
         return false;
     }
 
     // Generate package digest
     dpm_log(LOG_INFO, "Generating package digest...");
-    if (!metadata_generate_package_digest(stage_dir)) {
+    if (!metadata_generate_package_digest(transaction)) {
         dpm_log(LOG_ERROR, "Failed to generate package digest");
         return false;
     }
@@ -592,25 +966,39 @@ bool metadata_generate_dynamic_files(const std::filesystem::path& stage_dir)
 }
 
 // refreshes the dynamic entries for the stage
-bool metadata_refresh_dynamic_files(const std::filesystem::path& stage_dir)
+bool metadata_refresh_dynamic_files(const std::filesystem::path& stage_dir, bool full_rehash)
+{
+    MetadataTransaction transaction(stage_dir);
+    if (!metadata_refresh_dynamic_files(transaction, full_rehash)) {
+        return false;
+    }
+
+    if (!transaction.commit()) {
+        dpm_log(LOG_ERROR, "Failed to write refreshed metadata");
+        return false;
+    }
+    return true;
+}
+
+bool metadata_refresh_dynamic_files(MetadataTransaction& transaction, bool full_rehash)
 {
     // Refresh contents manifest
     dpm_log(LOG_INFO, "Refreshing contents manifest digest...");
-    if (metadata_refresh_contents_manifest_digest(stage_dir, false) != 0) {
+    if (metadata_refresh_contents_manifest_digest(transaction, false, full_rehash) != 0) {
         dpm_log(LOG_ERROR, "Failed to refresh contents manifest digest");
         return false;
     }
 
     // Generate hooks digest
     dpm_log(LOG_INFO, "Regenerating hooks digest...");
-    if (!metadata_generate_hooks_digest(stage_dir)) {
+    if (!metadata_generate_hooks_digest(transaction)) {
         dpm_log(LOG_ERROR, "Failed to regenerate hooks digest");
         return false;
     }
 
     // Generate package digest
     dpm_log(LOG_INFO, "Regenerating package digest...");
-    if (!metadata_generate_package_digest(stage_dir)) {
+    if (!metadata_generate_package_digest(transaction)) {
         dpm_log(LOG_ERROR, "Failed to regenerate package digest");
         return false;
     }
@@ -626,27 +1014,34 @@ bool metadata_generate_new(
     const std::string& architecture
 )
 {
-    // Step 1: Generate metadata skeleton
-    dpm_log(LOG_INFO, "Generating metadata skeleton...");
-    if (!metadata_generate_skeleton(stage_dir)) {
-        dpm_log(LOG_ERROR, "Failed to generate metadata skeleton");
+    if (!metadata_directory_ready(stage_dir)) {
         return false;
     }
 
+    // every field is collected in one transaction and written in one pass at the end
+    MetadataTransaction transaction(stage_dir);
+
+    // Step 1: Generate metadata skeleton
+    dpm_log(LOG_INFO, "Generating metadata skeleton...");
+    metadata_generate_skeleton(transaction);
+
     // Step 2: Set initial known values
     dpm_log(LOG_INFO, "Setting initial metadata values...");
-    if (!metadata_set_initial_known_values(stage_dir, package_name, package_version, architecture)) {
-        dpm_log(LOG_ERROR, "Failed to set initial metadata values");
-        return false;
-    }
+    metadata_set_initial_known_values(transaction, package_name, package_version, architecture);
 
     // Step 3: Generate dynamic files
     dpm_log(LOG_INFO, "Generating dynamic metadata files...");
-    if (!metadata_generate_dynamic_files(stage_dir)) {
+    if (!metadata_generate_dynamic_files(transaction)) {
         dpm_log(LOG_ERROR, "Failed to generate dynamic metadata files");
         return false;
     }
 
+    // Step 4: Write them all
+    if (!transaction.commit()) {
+        dpm_log(LOG_ERROR, "Failed to write metadata files");
+        return false;
+    }
+
     dpm_log(LOG_INFO, "Metadata generation completed successfully");
     return true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,122 @@
+/**
+ * @file metadata_transaction.cpp
+ * @brief Implementation of batched stage metadata writes
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "metadata_transaction.hpp"
+
+MetadataTransaction::MetadataTransaction(const std::filesystem::path& stage_dir)
+    : _stage_dir(stage_dir), _metadata_dir(stage_dir / "metadata")
+{
+}
+
+const std::filesystem::path& MetadataTransaction::stage_dir() const
+{
+    return _stage_dir;
+}
+
+void MetadataTransaction::set(const std::string& key, const std::string& value)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending[key] = value;
+    _removed.erase(key);
+    _model.set(key, value);
+}
+
+void MetadataTransaction::remove(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending.erase(key);
+    _removed.insert(key);
+    _model.remove(key);
+}
+
+bool MetadataTransaction::get(const std::string& key, std::string& value)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_removed.count(key) > 0) {
+        return false;
+    }
+
+    const std::string* field = _model.find(key);
+    if (!field && _model.load_field(_metadata_dir, key)) {
+        field = _model.find(key);
+    }
+    if (!field) {
+        return false;
+    }
+
+    value = *field;
+    return true;
+}
+
+void MetadataTransaction::remove_temporary_files(const std::vector<std::filesystem::path>& temporary_files)
+{
+    for (const auto& temporary_file : temporary_files) {
+        std::error_code ec;
+        std::filesystem::remove(temporary_file, ec);
+    }
+}
+
+bool MetadataTransaction::commit()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::map<std::string, std::string> pending;
+    std::set<std::string> removed;
+    pending.swap(_pending);
+    removed.swap(_removed);
+
+    if (!std::filesystem::is_directory(_metadata_dir)) {
+        dpm_log(LOG_ERROR, ("Metadata directory does not exist: " + _metadata_dir.string()).c_str());
+        return false;
+    }
+
+    // write every field beside its final place before replacing any of them
+    std::vector<std::filesystem::path> temporary_files;
+    for (const auto& [key, value] : pending) {
+        std::filesystem::path temporary_file = _metadata_dir / (key + ".tmp");
+        temporary_files.push_back(temporary_file);
+
+        std::ofstream file(temporary_file, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            dpm_log(LOG_ERROR, ("Failed to open metadata file for writing: " + temporary_file.string()).c_str());
+            remove_temporary_files(temporary_files);
+            return false;
+        }
+
+        file.write(value.data(), static_cast<std::streamsize>(value.size()));
+        file.close();
+        if (!file) {
+            dpm_log(LOG_ERROR, ("Failed to write metadata file: " + temporary_file.string()).c_str());
+            remove_temporary_files(temporary_files);
+            return false;
+        }
+    }
+
+    // then move them all into place
+    size_t renamed = 0;
+    for (const auto& [key, value] : pending) {
+        std::error_code ec;
+        std::filesystem::rename(temporary_files[renamed], _metadata_dir / key, ec);
+        if (ec) {
+            dpm_log(LOG_ERROR, ("Failed to update metadata file " + key + ": " + ec.message()).c_str());
+            remove_temporary_files(std::vector<std::filesystem::path>(temporary_files.begin() + renamed,
+                                                                      temporary_files.end()));
+            return false;
+        }
+        renamed++;
+    }
+
+    for (const auto& key : removed) {
+        std::error_code ec;
+        std::filesystem::remove(_metadata_dir / key, ec);
+    }
+
+    DPM_LOG(LOG_DEBUG, "Wrote ", pending.size(), " metadata field(s) in one pass");
+    return true;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file package_index.cpp
+ * @brief Implementation of the package component index
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "package_index.hpp"
+#include "archive_reader.hpp"
+
+std::string package_index_format(const std::vector<PackageIndexEntry>& entries)
+{
+    std::string index = "DPM_PACKAGE_INDEX 1\n";
+    for (const auto& entry : entries) {
+        char numbers[64];
+        snprintf(numbers, sizeof(numbers), "%020llu %020llu",
+                 static_cast<unsigned long long>(entry.offset), static_cast<unsigned long long>(entry.size));
+        index += entry.component + " " + numbers + " " + entry.codec + " " + entry.algorithm + " " + entry.digest + "\n";
+    }
+    return index;
+}
+
+bool package_index_parse(const unsigned char* data, size_t size, std::vector<PackageIndexEntry>& entries)
+{
+    entries.clear();
+    std::istringstream input(std::string(reinterpret_cast<const char*>(data), size));
+
+    std::string line;
+    if (!std::getline(input, line) || line != "DPM_PACKAGE_INDEX 1") {
+        dpm_log(LOG_DEBUG, "Package index has an unknown version, ignoring it");
+        return false;
+    }
+
+    while (std::getline(input, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        PackageIndexEntry entry;
+        if (!(fields >> entry.component >> entry.offset >> entry.size >> entry.codec >> entry.algorithm >> entry.digest)) {
+            DPM_LOG(LOG_DEBUG, "Malformed package index line: ", line);
+            entries.clear();
+            return false;
+        }
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+bool package_index_find(const unsigned char* prefix, size_t prefix_size, uint64_t package_size,
+                        std::vector<PackageIndexEntry>& entries)
+{
+    entries.clear();
+
+    struct archive* a = archive_read_new();
+    if (!a) {
+        return false;
+    }
+
+    // only a plain tar is indexed, the offsets mean nothing in a compressed one
+    archive_read_support_format_tar(a);
+    if (archive_read_open_memory(a, prefix, prefix_size) != ARCHIVE_OK) {
+        archive_read_free(a);
+        return false;
+    }
+
+    // the stage directory comes first, then the index
+    bool found = false;
+    struct archive_entry* entry;
+    for (int position = 0; position < 2 && !found; position++) {
+        if (archive_read_next_header(a, &entry) != ARCHIVE_OK) {
+            break;
+        }
+        if (archive_entry_filetype(entry) != AE_IFREG) {
+            continue;
+        }
+        if (strcmp(strip_archive_parent(archive_entry_pathname(entry)), PACKAGE_INDEX_MEMBER) != 0) {
+            break;
+        }
+
+        la_int64_t index_size = archive_entry_size(entry);
+        if (index_size <= 0 || static_cast<size_t>(index_size) > prefix_size) {
+            break;
+        }
+        std::vector<unsigned char> index(static_cast<size_t>(index_size));
+        if (archive_read_data(a, index.data(), index.size()) != index_size) {
+            break;
+        }
+        found = package_index_parse(index.data(), index.size(), entries);
+    }
+    archive_read_free(a);
+
+    if (!found) {
+        return false;
+    }
+
+    // an entry pointing outside the package means the index cannot be trusted at all
+    for (const auto& indexed : entries) {
+        if (indexed.offset < 512 || indexed.offset > package_size || indexed.size > package_size - indexed.offset) {
+            dpm_log(LOG_WARN, ("Package index entry for " + indexed.component + " is out of bounds, ignoring the index").c_str());
+            entries.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+const PackageIndexEntry* package_index_lookup(const std::vector<PackageIndexEntry>& entries, const char* component)
+{
+    const char* stripped = strip_archive_parent(component);
+    for (const auto& entry : entries) {
+        if (entry.component == component || entry.component == stripped) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
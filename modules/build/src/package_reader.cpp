@@ -0,0 +1,395 @@
+/**
+ * @file package_reader.cpp
+ * @brief Implementation of memory-mapped, zero-copy package component access
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "package_reader.hpp"
+
+/**
+ * Releases the mapping and descriptor held by a reader and deletes it
+ *
+ * @param reader Reader to destroy
+ */
+static void package_reader_destroy(PackageReader* reader)
+{
+    if (reader->remote) {
+        size_t requests = 0;
+        size_t connections = 0;
+        reader->remote->request_counts(requests, connections);
+        DPM_LOG(LOG_DEBUG, "Fetched ", reader->remote->bytes_received(), " bytes of ", reader->path, " in ",
+                requests, " requests over ", connections, " connections");
+    }
+
+    if (reader->map_base) {
+        munmap(reader->map_base, reader->map_size);
+    }
+
+    if (reader->fd >= 0) {
+        close(reader->fd);
+    }
+
+    delete reader;
+}
+
+/**
+ * Reads the current archive entry into a view
+ *
+ * When the package tar is uncompressed, libarchive hands back data blocks that
+ * point straight into the mapping, so a member made of one contiguous run is
+ * returned as-is.  Anything else (a gzipped outer tar, or data split across
+ * non-adjacent blocks) is copied once into storage owned by the reader.
+ *
+ * @param a Archive positioned at the entry to read
+ * @param reader Reader that will own any copied data
+ * @param view Receives the member view
+ * @return true on success, false on read errors
+ */
+static bool package_reader_load_member(struct archive* a, PackageReader* reader, PackageMemberView& view)
+{
+    const unsigned char* map_end = reader->map_base + reader->map_size;
+    const unsigned char* run_start = nullptr;
+    size_t run_size = 0;
+    bool contiguous = true;
+    std::vector<unsigned char> copy;
+
+    const void* block;
+    size_t block_size;
+    la_int64_t offset;
+    while (true) {
+        int r = archive_read_data_block(a, &block, &block_size, &offset);
+        if (r == ARCHIVE_EOF) {
+            break;
+        }
+        if (r != ARCHIVE_OK) {
+            dpm_log(LOG_ERROR, ("Failed to read package member: " + std::string(archive_error_string(a))).c_str());
+            return false;
+        }
+
+        const unsigned char* block_data = static_cast<const unsigned char*>(block);
+
+        if (contiguous) {
+            bool in_map = block_data >= reader->map_base && block_data + block_size <= map_end;
+            bool adjacent = run_start == nullptr || block_data == run_start + run_size;
+
+            if (in_map && adjacent && (size_t)offset == run_size) {
+                if (!run_start) {
+                    run_start = block_data;
+                }
+                run_size += block_size;
+                continue;
+            }
+
+            // fall back to copying, starting with what has been seen so far
+            contiguous = false;
+            if (run_start) {
+                copy.assign(run_start, run_start + run_size);
+            }
+        }
+
+        if ((size_t)offset > copy.size()) {
+            // sparse hole, filled with zeroes
+            copy.resize(offset, 0);
+        }
+        copy.insert(copy.end(), block_data, block_data + block_size);
+    }
+
+    if (contiguous) {
+        view.data = run_start;
+        view.size = run_size;
+        view.mapped = true;
+        return true;
+    }
+
+    reader->owned.push_back(std::move(copy));
+    view.data = reader->owned.back().data();
+    view.size = reader->owned.back().size();
+    view.mapped = false;
+    return true;
+}
+
+/**
+ * Opens the remote package of a reader and indexes its members
+ *
+ * Only the start of the package is fetched, to find its index; members are
+ * fetched when they are asked for.  A package without an index is
+ * downloaded whole into an anonymous mapping, to be walked like a local one.
+ *
+ * @param reader Reader whose path is the URL of the package
+ * @return 1 if the members were indexed, 0 if the package was loaded into the mapping, -1 on failure
+ */
+static int package_reader_open_remote(PackageReader* reader)
+{
+    reader->remote = std::make_unique<RemotePackage>(reader->path);
+    if (!reader->remote->valid()) {
+        return -1;
+    }
+
+    std::vector<unsigned char> prefix;
+    if (!reader->remote->fetch(0, PACKAGE_INDEX_SEARCH_SIZE, prefix) || prefix.empty()) {
+        dpm_log(LOG_ERROR, ("Failed to fetch package: " + reader->path).c_str());
+        return -1;
+    }
+
+    uint64_t package_size = reader->remote->size();
+    std::vector<PackageIndexEntry> index;
+    if (package_size > 0 && package_index_find(prefix.data(), prefix.size(), package_size, index)) {
+        for (const auto& indexed : index) {
+            PackageMemberView view = { nullptr, static_cast<size_t>(indexed.size), false };
+            view.remote = true;
+            view.offset = indexed.offset;
+            reader->members[indexed.component] = view;
+        }
+        return 1;
+    }
+
+    // older packages have no index, their members are only found by reading all of them
+    dpm_log(LOG_INFO, ("Package has no index, downloading all of it: " + reader->path).c_str());
+    std::vector<unsigned char> rest;
+    if ((package_size == 0 || prefix.size() < package_size) && !reader->remote->fetch(prefix.size(), 0, rest)) {
+        dpm_log(LOG_ERROR, ("Failed to fetch package: " + reader->path).c_str());
+        return -1;
+    }
+
+    reader->map_size = prefix.size() + rest.size();
+    void* mapping = mmap(NULL, reader->map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        dpm_log(LOG_ERROR, ("Failed to allocate memory for package: " + reader->path).c_str());
+        reader->map_size = 0;
+        return -1;
+    }
+    reader->map_base = static_cast<unsigned char*>(mapping);
+    memcpy(reader->map_base, prefix.data(), prefix.size());
+    if (!rest.empty()) {
+        memcpy(reader->map_base + prefix.size(), rest.data(), rest.size());
+    }
+    return 0;
+}
+
+extern "C" void* package_reader_open(const char* package_path)
+{
+    if (!package_path) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to package_reader_open");
+        return NULL;
+    }
+
+    PackageReader* reader = new PackageReader();
+    reader->path = package_path;
+    reader->fd = -1;
+    reader->map_base = nullptr;
+    reader->map_size = 0;
+
+    if (remote_package_is_url(package_path)) {
+        int opened = package_reader_open_remote(reader);
+        if (opened < 0) {
+            package_reader_destroy(reader);
+            return NULL;
+        }
+        if (opened > 0) {
+            DPM_LOG(LOG_DEBUG, "Opened remote package ", reader->path, " with ", reader->members.size(),
+                    " indexed members");
+            return reader;
+        }
+    } else {
+        reader->fd = open(package_path, O_RDONLY | O_CLOEXEC);
+        if (reader->fd < 0) {
+            dpm_log(LOG_ERROR, ("Failed to open package file: " + reader->path + " - " + strerror(errno)).c_str());
+            package_reader_destroy(reader);
+            return NULL;
+        }
+
+        struct stat st;
+        if (fstat(reader->fd, &st) != 0 || st.st_size == 0) {
+            dpm_log(LOG_ERROR, ("Package file is empty or unreadable: " + reader->path).c_str());
+            package_reader_destroy(reader);
+            return NULL;
+        }
+
+        reader->map_size = st.st_size;
+        void* mapping = mmap(NULL, reader->map_size, PROT_READ, MAP_PRIVATE, reader->fd, 0);
+        if (mapping == MAP_FAILED) {
+            dpm_log(LOG_ERROR, ("Failed to map package file: " + reader->path + " - " + strerror(errno)).c_str());
+            reader->map_size = 0;
+            package_reader_destroy(reader);
+            return NULL;
+        }
+        reader->map_base = static_cast<unsigned char*>(mapping);
+        madvise(mapping, reader->map_size, MADV_SEQUENTIAL);
+
+        // A package with an index needs no walk, its members are viewed where the index says
+        std::vector<PackageIndexEntry> index;
+        if (package_index_find(reader->map_base, std::min<size_t>(reader->map_size, PACKAGE_INDEX_SEARCH_SIZE),
+                               reader->map_size, index)) {
+            for (const auto& indexed : index) {
+                reader->members[indexed.component] = { reader->map_base + indexed.offset, indexed.size, true };
+            }
+            DPM_LOG(LOG_DEBUG, "Mapped package ", reader->path, " with ", reader->members.size(),
+                    " indexed members");
+            return reader;
+        }
+
+        // Without an index every member header is visited, so the whole package is read ahead
+        package_memory_readahead(reader->map_base, reader->map_size);
+    }
+
+    // Index the members of the outer tar
+    struct archive* a = archive_read_new();
+    if (!a) {
+        dpm_log(LOG_ERROR, "Failed to create archive object");
+        package_reader_destroy(reader);
+        return NULL;
+    }
+
+    // Current packages are plain tar; older ones are gzipped
+    compression_read_support(a);
+    archive_read_support_format_tar(a);
+
+    if (archive_read_open_memory(a, reader->map_base, reader->map_size) != ARCHIVE_OK) {
+        dpm_log(LOG_ERROR, ("Failed to open package archive: " + reader->path +
+                           " - " + std::string(archive_error_string(a))).c_str());
+        archive_read_free(a);
+        package_reader_destroy(reader);
+        return NULL;
+    }
+
+    bool success = true;
+    struct archive_entry* entry;
+    while (success) {
+        int r = archive_read_next_header(a, &entry);
+        if (r == ARCHIVE_EOF) {
+            break;
+        }
+        if (r != ARCHIVE_OK) {
+            dpm_log(LOG_ERROR, ("Package read error: " + std::string(archive_error_string(a))).c_str());
+            success = false;
+            break;
+        }
+
+        if (archive_entry_filetype(entry) != AE_IFREG) {
+            archive_read_data_skip(a);
+            continue;
+        }
+
+        std::string member_name = strip_archive_parent(archive_entry_pathname(entry));
+        if (member_name.empty()) {
+            member_name = archive_entry_pathname(entry);
+        }
+
+        PackageMemberView view = { nullptr, 0, false };
+        if (!package_reader_load_member(a, reader, view)) {
+            success = false;
+            break;
+        }
+
+        reader->members[member_name] = view;
+    }
+
+    archive_read_free(a);
+
+    if (!success) {
+        package_reader_destroy(reader);
+        return NULL;
+    }
+
+    size_t mapped_members = 0;
+    for (const auto& member : reader->members) {
+        if (member.second.mapped) {
+            mapped_members++;
+        }
+    }
+
+    DPM_LOG(LOG_DEBUG, "Mapped package ", reader->path, " with ", reader->members.size(), " members, ",
+            mapped_members, " viewed in place");
+
+    return reader;
+}
+
+extern "C" bool package_reader_get_member(void* reader, const char* member_name,
+                                          const unsigned char** data, size_t* data_size)
+{
+    if (!reader || !member_name || !data || !data_size) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to package_reader_get_member");
+        return false;
+    }
+
+    *data = NULL;
+    *data_size = 0;
+
+    PackageReader* package = static_cast<PackageReader*>(reader);
+
+    // members of a remote package are fetched on first use, one at a time
+    std::unique_lock<std::mutex> lock;
+    if (package->remote) {
+        lock = std::unique_lock<std::mutex>(package->remote_mutex);
+    }
+
+    auto it = package->members.find(member_name);
+    if (it == package->members.end()) {
+        // allow callers to pass the full "stage/member" path as well
+        it = package->members.find(strip_archive_parent(member_name));
+    }
+
+    if (it == package->members.end()) {
+        dpm_log(LOG_ERROR, ("Member not found in package: " + std::string(member_name)).c_str());
+        return false;
+    }
+
+    PackageMemberView& view = it->second;
+    if (view.remote) {
+        std::vector<unsigned char> fetched;
+        if (!package->remote->fetch(view.offset, view.size, fetched) || fetched.size() != view.size) {
+            dpm_log(LOG_ERROR, ("Failed to fetch " + it->first + " from package: " + package->path).c_str());
+            return false;
+        }
+        DPM_LOG(LOG_DEBUG, "Fetched ", it->first, " (", view.size, " bytes) from ", package->path);
+
+        package->owned.push_back(std::move(fetched));
+        view.data = package->owned.back().data();
+        view.remote = false;
+    }
+
+    // Members viewed in the mapping are faulted in ahead of the caller walking them
+    if (view.mapped) {
+        package_memory_readahead(view.data, view.size);
+    }
+
+    *data = view.data;
+    *data_size = view.size;
+    return true;
+}
+
+extern "C" bool package_reader_get_member_size(void* reader, const char* member_name, size_t* data_size)
+{
+    if (!reader || !member_name || !data_size) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to package_reader_get_member_size");
+        return false;
+    }
+
+    PackageReader* package = static_cast<PackageReader*>(reader);
+    std::unique_lock<std::mutex> lock;
+    if (package->remote) {
+        lock = std::unique_lock<std::mutex>(package->remote_mutex);
+    }
+
+    auto it = package->members.find(member_name);
+    if (it == package->members.end()) {
+        it = package->members.find(strip_archive_parent(member_name));
+    }
+    if (it == package->members.end()) {
+        return false;
+    }
+
+    *data_size = it->second.size;
+    return true;
+}
+
+extern "C" void package_reader_close(void* reader)
+{
+    if (reader) {
+        package_reader_destroy(static_cast<PackageReader*>(reader));
+    }
+}
@@ -0,0 +1,494 @@
+/**
+ * @file parallel_gzip.cpp
+ * @brief Implementation of the block-parallel gzip writer
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "parallel_gzip.hpp"
+
+size_t parallel_gzip_thread_count()
+{
+    return build_thread_share(build_config_thread_count("compression_threads", dpm_worker_threads()));
+}
+
+ParallelGzipWriter::ParallelGzipWriter(const std::string& output_path, size_t thread_count, int level)
+    : _output_path(output_path), _thread_count(std::max<size_t>(thread_count, 1)), _level(level),
+      _fd(-1), _failed(false), _crc(crc32(0L, Z_NULL, 0)), _total_in(0), _member_open(false), _input_offset(0),
+      _written_in(0), _written_out(0), _frame_size(0), _last_cut(0), _cut_count(0), _capturing(false),
+      _stopping(false)
+{
+}
+
+ParallelGzipWriter::ParallelGzipWriter(std::function<bool(const void* data, size_t size)> output, size_t thread_count,
+                                       int level)
+    : _output_path("output stream"), _output(std::move(output)), _thread_count(std::max<size_t>(thread_count, 1)),
+      _level(level), _fd(-1), _failed(false), _crc(crc32(0L, Z_NULL, 0)), _total_in(0), _member_open(false),
+      _input_offset(0), _written_in(0), _written_out(0), _frame_size(0), _last_cut(0), _cut_count(0), _capturing(false),
+      _stopping(false)
+{
+}
+
+ParallelGzipWriter::~ParallelGzipWriter()
+{
+    stop_workers();
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+}
+
+bool ParallelGzipWriter::open()
+{
+    if (!_output) {
+        _fd = ::open(_output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (!_output && _fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to create archive: " + _output_path + ": " + strerror(errno)).c_str());
+        return false;
+    }
+
+    // member headers are written with the first block of each member
+    _current.reserve(PARALLEL_GZIP_BLOCK_SIZE);
+    for (size_t i = 0; i < _thread_count; i++) {
+        _workers.emplace_back(&ParallelGzipWriter::worker_loop, this);
+    }
+
+    return true;
+}
+
+bool ParallelGzipWriter::write(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    while (size > 0 && !_failed) {
+        // a frame ends exactly at the entry that starts the next one
+        if (!_frame_cuts.empty() && _frame_cuts.front() == _input_offset) {
+            _frame_cuts.pop_front();
+            if (!dispatch(true)) {
+                return false;
+            }
+            continue;
+        }
+
+        bool advanced = false;
+        if (!advance_span(advanced)) {
+            return false;
+        }
+        if (advanced) {
+            continue;
+        }
+
+        // data with a stored member in its place is only checked
+        if (!_spans.empty() && _spans.front().started && !_spans.front().member.empty()) {
+            FrameSpan& span = _spans.front();
+            size_t take = static_cast<size_t>(std::min<uint64_t>(size, span.end - _input_offset));
+            span.crc = crc32(span.crc, bytes, static_cast<uInt>(take));
+            bytes += take;
+            size -= take;
+            _input_offset += take;
+            continue;
+        }
+
+        size_t room = PARALLEL_GZIP_BLOCK_SIZE - _current.size();
+        if (!_frame_cuts.empty()) {
+            room = static_cast<size_t>(std::min<uint64_t>(room, _frame_cuts.front() - _input_offset));
+        }
+        if (!_spans.empty()) {
+            uint64_t boundary = _spans.front().started ? _spans.front().end : _spans.front().start;
+            room = static_cast<size_t>(std::min<uint64_t>(room, boundary - _input_offset));
+        }
+        size_t take = std::min(room, size);
+        _current.insert(_current.end(), bytes, bytes + take);
+        bytes += take;
+        size -= take;
+        _input_offset += take;
+
+        if (_current.size() == PARALLEL_GZIP_BLOCK_SIZE && !dispatch(false)) {
+            return false;
+        }
+    }
+
+    return !_failed;
+}
+
+void ParallelGzipWriter::enable_frames(uint64_t frame_size)
+{
+    _frame_size = frame_size;
+}
+
+void ParallelGzipWriter::mark_entry(uint64_t offset, const std::string& path)
+{
+    if (_frame_size == 0 || offset < _last_cut) {
+        return;
+    }
+
+    if (offset - _last_cut >= _frame_size) {
+        _frame_cuts.push_back(offset);
+        _last_cut = offset;
+        _cut_count++;
+    }
+    _frame_index.entries.push_back({ path, _cut_count });
+}
+
+void ParallelGzipWriter::reuse_frame(uint64_t offset, uint64_t size, std::vector<unsigned char> member,
+                                     std::function<void()> mismatch)
+{
+    if (member.size() < 18) {
+        return;
+    }
+    add_span({ offset, offset + size, std::move(member), std::move(mismatch), nullptr, crc32(0L, Z_NULL, 0), false });
+}
+
+void ParallelGzipWriter::capture_frame(uint64_t offset, uint64_t size,
+                                       std::function<void(const std::vector<unsigned char>& member)> capture)
+{
+    add_span({ offset, offset + size, {}, nullptr, std::move(capture), 0, false });
+}
+
+bool ParallelGzipWriter::add_span(FrameSpan span)
+{
+    if (_frame_size == 0 || span.end <= span.start || span.start < _last_cut || span.start < _input_offset) {
+        return false;
+    }
+
+    // the span is one frame and what follows it another, the entry after it starts there
+    _cut_count += 2;
+    _last_cut = span.end;
+    _spans.push_back(std::move(span));
+    return true;
+}
+
+bool ParallelGzipWriter::advance_span(bool& advanced)
+{
+    advanced = false;
+    if (_spans.empty()) {
+        return true;
+    }
+
+    FrameSpan& span = _spans.front();
+    if (!span.started && span.start == _input_offset) {
+        // the data starts a member of its own
+        advanced = true;
+        span.started = true;
+        if (!dispatch(true)) {
+            return false;
+        }
+        if (span.member.empty()) {
+            _captures.push_back({ span.start, span.end, {}, nullptr, span.capture, 0, true });
+        }
+        return true;
+    }
+
+    if (span.started && span.end == _input_offset) {
+        advanced = true;
+        return finish_span();
+    }
+
+    return true;
+}
+
+bool ParallelGzipWriter::finish_span()
+{
+    FrameSpan span = std::move(_spans.front());
+    _spans.pop_front();
+
+    if (span.member.empty()) {
+        return dispatch(true);
+    }
+
+    uLong recorded_crc = 0;
+    for (int i = 0; i < 4; i++) {
+        recorded_crc |= static_cast<uLong>(span.member[span.member.size() - 8 + i]) << (8 * i);
+    }
+    if (recorded_crc != span.crc) {
+        dpm_log(LOG_ERROR, ("Stored frame does not match the data at offset " + std::to_string(span.start) +
+                            " of " + _output_path).c_str());
+        if (span.mismatch) {
+            span.mismatch();
+        }
+        _failed = true;
+        return false;
+    }
+
+    // the member goes out in order behind the blocks still being compressed
+    auto block = std::make_shared<Block>();
+    block->output = std::move(span.member);
+    block->crc = 0;
+    block->last = true;
+    block->done = true;
+    block->failed = false;
+    block->member_size = span.end - span.start;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending.push_back(block);
+    }
+    return write_completed(_thread_count * 2);
+}
+
+bool ParallelGzipWriter::close()
+{
+    // data given a frame of its own may end with the input
+    bool advanced = false;
+    bool success = !_failed && advance_span(advanced);
+
+    // the final block ends the deflate stream, even when it is empty
+    success = success && dispatch(true) && write_completed(0);
+    stop_workers();
+
+    if (success && _frame_size > 0) {
+        std::vector<unsigned char> trailer;
+        success = frame_index_encode(_frame_index, _written_out, trailer) && write_all(trailer.data(), trailer.size());
+        if (success) {
+            DPM_LOG(LOG_DEBUG, "Wrote ", _frame_index.frames.size(), " seekable frames to ", _output_path);
+        }
+    }
+
+    if (_fd >= 0) {
+        if (::close(_fd) != 0 && success) {
+            dpm_log(LOG_ERROR, ("Failed to close archive: " + _output_path + ": " + strerror(errno)).c_str());
+            success = false;
+        }
+        _fd = -1;
+    }
+
+    return success;
+}
+
+void ParallelGzipWriter::worker_loop()
+{
+    while (true) {
+        std::shared_ptr<Block> block;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _work_available.wait(lock, [this] { return _stopping || !_queue.empty(); });
+            if (_queue.empty()) {
+                return;
+            }
+            block = _queue.front();
+            _queue.pop_front();
+        }
+
+        bool compressed = compress_block(*block);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            block->failed = !compressed;
+            block->done = true;
+        }
+        _block_done.notify_all();
+    }
+}
+
+bool ParallelGzipWriter::compress_block(Block& block)
+{
+    DpmProfileScope profile("compress_block");
+    profile.add_bytes(block.input.size());
+
+    block.crc = crc32(0L, block.input.data(), static_cast<uInt>(block.input.size()));
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    // raw deflate, the gzip header and trailer are written around the joined blocks
+    if (deflateInit2(&stream, _level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        dpm_log(LOG_ERROR, "Failed to initialize deflate stream");
+        return false;
+    }
+
+    if (!block.dictionary.empty() &&
+        deflateSetDictionary(&stream, block.dictionary.data(), static_cast<uInt>(block.dictionary.size())) != Z_OK) {
+        dpm_log(LOG_ERROR, "Failed to set deflate dictionary");
+        deflateEnd(&stream);
+        return false;
+    }
+
+    // room for the worst case plus the empty stored block a sync flush appends
+    block.output.resize(deflateBound(&stream, block.input.size()) + 16);
+    stream.next_in = block.input.data();
+    stream.avail_in = static_cast<uInt>(block.input.size());
+    stream.next_out = block.output.data();
+    stream.avail_out = static_cast<uInt>(block.output.size());
+
+    // a sync flush ends all but the last block on a byte boundary without ending the stream
+    int result = deflate(&stream, block.last ? Z_FINISH : Z_SYNC_FLUSH);
+    bool complete = block.last ? result == Z_STREAM_END
+                               : result == Z_OK && stream.avail_in == 0 && stream.avail_out > 0;
+
+    block.output.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (!complete) {
+        dpm_log(LOG_ERROR, ("Failed to compress block for archive: " + _output_path).c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool ParallelGzipWriter::dispatch(bool last)
+{
+    auto block = std::make_shared<Block>();
+    block->input.swap(_current);
+    block->dictionary = _previous_tail;
+    block->crc = 0;
+    block->last = last;
+    block->done = false;
+    block->failed = false;
+    block->member_size = 0;
+
+    // the next block is primed with the end of this one, unless it starts a new member
+    if (!last) {
+        size_t tail = std::min<size_t>(block->input.size(), PARALLEL_GZIP_DICTIONARY_SIZE);
+        _previous_tail.assign(block->input.end() - tail, block->input.end());
+    } else {
+        _previous_tail.clear();
+    }
+    _current.reserve(PARALLEL_GZIP_BLOCK_SIZE);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending.push_back(block);
+        _queue.push_back(block);
+    }
+    _work_available.notify_one();
+
+    // keep every worker busy with a block waiting behind it, but bound the memory used
+    return write_completed(_thread_count * 2);
+}
+
+bool ParallelGzipWriter::write_completed(size_t keep_pending)
+{
+    while (true) {
+        std::shared_ptr<Block> block;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_pending.empty()) {
+                return !_failed;
+            }
+
+            // write whatever has finished in order, and wait only while too much is in flight
+            if (!_pending.front()->done) {
+                if (_pending.size() <= keep_pending) {
+                    return !_failed;
+                }
+                _block_done.wait(lock, [this] { return _pending.front()->done; });
+            }
+
+            block = _pending.front();
+            _pending.pop_front();
+        }
+
+        if (block->failed) {
+            _failed = true;
+            return false;
+        }
+
+        // a stored member is a frame as it is
+        if (block->member_size > 0) {
+            _frame_index.frames.push_back({ _written_out, _written_in });
+            if (!write_all(block->output.data(), block->output.size())) {
+                return false;
+            }
+            _written_in += block->member_size;
+            continue;
+        }
+
+        if (!_member_open) {
+            if (_frame_size > 0) {
+                _frame_index.frames.push_back({ _written_out, _written_in });
+            }
+            if (!_captures.empty() && _captures.front().start == _written_in) {
+                _capturing = true;
+                _capture_buffer.clear();
+            }
+
+            // Header: magic, deflate, no flags, no modification time, no extra flags, Unix
+            const unsigned char header[10] = { 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03 };
+            if (!write_all(header, sizeof(header))) {
+                return false;
+            }
+            _member_open = true;
+        }
+
+        if (!write_all(block->output.data(), block->output.size())) {
+            return false;
+        }
+
+        _crc = crc32_combine(_crc, block->crc, static_cast<z_off_t>(block->input.size()));
+        _total_in += static_cast<uLong>(block->input.size());
+        _written_in += block->input.size();
+
+        if (block->last) {
+            // Trailer: CRC-32 and uncompressed size, both little endian
+            unsigned char trailer[8];
+            for (int i = 0; i < 4; i++) {
+                trailer[i] = static_cast<unsigned char>((_crc >> (8 * i)) & 0xff);
+                trailer[4 + i] = static_cast<unsigned char>((_total_in >> (8 * i)) & 0xff);
+            }
+            if (!write_all(trailer, sizeof(trailer))) {
+                return false;
+            }
+            _crc = crc32(0L, Z_NULL, 0);
+            _total_in = 0;
+            _member_open = false;
+
+            if (_capturing) {
+                _capturing = false;
+                _captures.front().capture(_capture_buffer);
+                _captures.pop_front();
+                _capture_buffer.clear();
+            }
+        }
+    }
+}
+
+bool ParallelGzipWriter::write_all(const void* data, size_t size)
+{
+    _written_out += size;
+    if (_capturing) {
+        const unsigned char* captured = static_cast<const unsigned char*>(data);
+        _capture_buffer.insert(_capture_buffer.end(), captured, captured + size);
+    }
+    if (_output) {
+        if (!_output(data, size)) {
+            dpm_log(LOG_ERROR, ("Failed to write archive: " + _output_path).c_str());
+            _failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(_fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            dpm_log(LOG_ERROR, ("Failed to write archive: " + _output_path + ": " + strerror(errno)).c_str());
+            _failed = true;
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void ParallelGzipWriter::stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        _queue.clear();
+    }
+    _work_available.notify_all();
+
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+}
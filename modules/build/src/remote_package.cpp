@@ -0,0 +1,665 @@
+/**
+ * @file remote_package.cpp
+ * @brief Implementation of byte range access to packages served over HTTP and HTTPS
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "remote_package.hpp"
+
+static std::once_flag g_remote_tls_flag;
+static SSL_CTX* g_remote_tls_context = nullptr;
+
+// one client context for every https package, loaded with the trust store once
+static void remote_tls_init()
+{
+    SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+    if (!context) {
+        return;
+    }
+    SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+    SSL_CTX_set_verify(context, SSL_VERIFY_PEER, nullptr);
+
+    const char* ca_file = dpm_get_config("build", "remote_ca_file");
+    bool loaded = (ca_file && ca_file[0] != '\0')
+                      ? SSL_CTX_load_verify_locations(context, ca_file, nullptr) == 1
+                      : SSL_CTX_set_default_verify_paths(context) == 1;
+    if (!loaded) {
+        dpm_log(LOG_ERROR, ("Failed to load the certificates to verify https packages with" +
+                            std::string(ca_file && ca_file[0] != '\0' ? ": " + std::string(ca_file) : "")).c_str());
+        SSL_CTX_free(context);
+        return;
+    }
+    g_remote_tls_context = context;
+}
+
+static std::string remote_lowercase(std::string value)
+{
+    for (char& c : value) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return value;
+}
+
+static std::string remote_trim(const std::string& value)
+{
+    size_t start = value.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(" \t\r\n");
+    return value.substr(start, end - start + 1);
+}
+
+bool remote_package_is_url(const char* path)
+{
+    return path && (strncmp(path, "http://", 7) == 0 || strncmp(path, "https://", 8) == 0);
+}
+
+RemotePackage::RemotePackage(const std::string& url)
+    : _valid(false), _tls(false), _timeout(REMOTE_PACKAGE_DEFAULT_TIMEOUT), _fd(-1), _ssl(nullptr),
+      _buffer(REMOTE_PACKAGE_BUFFER_SIZE), _buffer_start(0), _buffer_end(0), _size(0), _whole(false),
+      _bytes_received(0), _requests(0), _connections(0)
+{
+    const char* timeout = dpm_get_config("build", "remote_timeout");
+    if (timeout && atoi(timeout) > 0) {
+        _timeout = atoi(timeout);
+    }
+
+    _valid = parse_url(url);
+    if (!_valid) {
+        dpm_log(LOG_ERROR, ("Unsupported package URL: " + url).c_str());
+    }
+}
+
+RemotePackage::~RemotePackage()
+{
+    disconnect();
+}
+
+bool RemotePackage::valid() const
+{
+    return _valid;
+}
+
+uint64_t RemotePackage::size() const
+{
+    return _size;
+}
+
+const std::string& RemotePackage::url() const
+{
+    return _url;
+}
+
+uint64_t RemotePackage::bytes_received() const
+{
+    return _bytes_received;
+}
+
+void RemotePackage::request_counts(size_t& requests, size_t& connections) const
+{
+    requests = _requests;
+    connections = _connections;
+}
+
+bool RemotePackage::parse_url(const std::string& url)
+{
+    size_t authority_start;
+    if (url.compare(0, 7, "http://") == 0) {
+        _tls = false;
+        _port = "80";
+        authority_start = 7;
+    } else if (url.compare(0, 8, "https://") == 0) {
+        _tls = true;
+        _port = "443";
+        authority_start = 8;
+    } else {
+        return false;
+    }
+
+    size_t path_start = url.find_first_of("/?#", authority_start);
+    std::string authority = url.substr(authority_start, path_start == std::string::npos ? std::string::npos
+                                                                                         : path_start - authority_start);
+    if (authority.empty() || authority.find('@') != std::string::npos) {
+        return false;
+    }
+
+    // [::1]:8080 for literal IPv6 addresses
+    size_t port_separator;
+    if (authority[0] == '[') {
+        size_t close = authority.find(']');
+        if (close == std::string::npos) {
+            return false;
+        }
+        _host = authority.substr(1, close - 1);
+        port_separator = authority.find(':', close);
+    } else {
+        port_separator = authority.find(':');
+        _host = authority.substr(0, port_separator);
+    }
+    if (port_separator != std::string::npos) {
+        _port = authority.substr(port_separator + 1);
+        if (_port.empty() || _port.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+    }
+    if (_host.empty()) {
+        return false;
+    }
+
+    _target = path_start == std::string::npos ? "/" : url.substr(path_start);
+    size_t fragment = _target.find('#');
+    if (fragment != std::string::npos) {
+        _target = _target.substr(0, fragment);
+    }
+    if (_target.empty() || _target[0] != '/') {
+        _target = "/" + _target;
+    }
+
+    _url = url;
+    return true;
+}
+
+bool RemotePackage::connect()
+{
+    disconnect();
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* addresses = nullptr;
+    int resolved = getaddrinfo(_host.c_str(), _port.c_str(), &hints, &addresses);
+    if (resolved != 0) {
+        dpm_log(LOG_ERROR, ("Failed to resolve " + _host + ": " + gai_strerror(resolved)).c_str());
+        return false;
+    }
+
+    // the send timeout also bounds connect on Linux
+    struct timeval timeout;
+    timeout.tv_sec = _timeout;
+    timeout.tv_usec = 0;
+
+    int error = 0;
+    for (struct addrinfo* address = addresses; address && _fd < 0; address = address->ai_next) {
+        int fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0) {
+            error = errno;
+            continue;
+        }
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+            error = errno;
+            close(fd);
+            continue;
+        }
+        _fd = fd;
+    }
+    freeaddrinfo(addresses);
+
+    if (_fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to connect to " + _host + ":" + _port + ": " + strerror(error)).c_str());
+        return false;
+    }
+
+    if (_tls) {
+        std::call_once(g_remote_tls_flag, remote_tls_init);
+        if (!g_remote_tls_context) {
+            disconnect();
+            return false;
+        }
+
+        _ssl = SSL_new(g_remote_tls_context);
+        if (!_ssl) {
+            disconnect();
+            return false;
+        }
+        SSL_set_fd(_ssl, _fd);
+
+        // the certificate has to name the host, or carry the address when the URL holds one
+        unsigned char address[sizeof(struct in6_addr)];
+        bool literal = inet_pton(AF_INET, _host.c_str(), address) == 1 || inet_pton(AF_INET6, _host.c_str(), address) == 1;
+        if (literal) {
+            X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(_ssl), _host.c_str());
+        } else {
+            SSL_set_tlsext_host_name(_ssl, _host.c_str());
+            SSL_set1_host(_ssl, _host.c_str());
+        }
+
+        if (SSL_connect(_ssl) != 1) {
+            long verify = SSL_get_verify_result(_ssl);
+            const char* reason = verify != X509_V_OK ? X509_verify_cert_error_string(verify)
+                                                     : ERR_reason_error_string(ERR_get_error());
+            dpm_log(LOG_ERROR, ("TLS connection to " + _host + " failed: " +
+                                std::string(reason ? reason : "handshake failed")).c_str());
+            ERR_clear_error();
+            disconnect();
+            return false;
+        }
+    }
+
+    _connections++;
+    DPM_LOG(LOG_DEBUG, "Connected to ", _host, ":", _port, _tls ? " with TLS" : "");
+    return true;
+}
+
+void RemotePackage::disconnect()
+{
+    if (_ssl) {
+        SSL_free(_ssl);
+        _ssl = nullptr;
+    }
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    _buffer_start = 0;
+    _buffer_end = 0;
+}
+
+bool RemotePackage::send_all(const std::string& data)
+{
+    size_t sent = 0;
+    while (sent < data.size()) {
+        long written;
+        if (_ssl) {
+            written = SSL_write(_ssl, data.data() + sent, static_cast<int>(data.size() - sent));
+        } else {
+            written = send(_fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+        }
+        if (written <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// reads what the connection has, returning the byte count, 0 at the end of the stream or -1 on errors
+long RemotePackage::read_some(char* buffer, size_t size)
+{
+    while (true) {
+        long got;
+        if (_ssl) {
+            got = SSL_read(_ssl, buffer, static_cast<int>(size));
+            if (got <= 0) {
+                int error = SSL_get_error(_ssl, static_cast<int>(got));
+                return error == SSL_ERROR_ZERO_RETURN ? 0 : -1;
+            }
+        } else {
+            got = recv(_fd, buffer, size, 0);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+        }
+        return got;
+    }
+}
+
+bool RemotePackage::fill()
+{
+    if (_buffer_start == _buffer_end) {
+        _buffer_start = 0;
+        _buffer_end = 0;
+    }
+    long got = read_some(_buffer.data() + _buffer_end, _buffer.size() - _buffer_end);
+    if (got <= 0) {
+        return false;
+    }
+    _buffer_end += static_cast<size_t>(got);
+    return true;
+}
+
+bool RemotePackage::read_line(std::string& line)
+{
+    line.clear();
+    while (true) {
+        char* start = _buffer.data() + _buffer_start;
+        char* newline = static_cast<char*>(memchr(start, '\n', _buffer_end - _buffer_start));
+        if (newline) {
+            line.append(start, newline);
+            _buffer_start += static_cast<size_t>(newline - start) + 1;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            return true;
+        }
+
+        line.append(start, _buffer_end - _buffer_start);
+        _buffer_start = _buffer_end;
+        if (line.size() > REMOTE_PACKAGE_BUFFER_SIZE || !fill()) {
+            return false;
+        }
+    }
+}
+
+bool RemotePackage::read_body(uint64_t length, std::vector<unsigned char>& body, uint64_t limit)
+{
+    size_t start = body.size();
+    if (length > limit || start > limit - length) {
+        dpm_log(LOG_ERROR, ("Response from " + _host + " is larger than expected for " + _url).c_str());
+        return false;
+    }
+    body.resize(start + length);
+    size_t done = 0;
+
+    // what is buffered first, then straight into the body
+    size_t buffered = std::min(length, _buffer_end - _buffer_start);
+    memcpy(body.data() + start, _buffer.data() + _buffer_start, buffered);
+    _buffer_start += buffered;
+    done += buffered;
+
+    while (done < length) {
+        long got = read_some(reinterpret_cast<char*>(body.data() + start + done), length - done);
+        if (got <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(got);
+    }
+    _bytes_received += length;
+    return true;
+}
+
+bool RemotePackage::read_chunked(std::vector<unsigned char>& body, uint64_t limit)
+{
+    std::string line;
+    while (true) {
+        if (!read_line(line)) {
+            return false;
+        }
+        char* end = nullptr;
+        errno = 0;
+        unsigned long long chunk = strtoull(line.c_str(), &end, 16);
+        if (end == line.c_str() || errno == ERANGE) {
+            return false;
+        }
+        if (chunk == 0) {
+            // trailers, up to the blank line
+            while (read_line(line)) {
+                if (line.empty()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (!read_body(chunk, body, limit) || !read_line(line) || !line.empty()) {
+            return false;
+        }
+    }
+}
+
+bool RemotePackage::read_to_close(std::vector<unsigned char>& body, uint64_t limit)
+{
+    if (body.size() + (_buffer_end - _buffer_start) > limit) {
+        dpm_log(LOG_ERROR, ("Response from " + _host + " is larger than expected for " + _url).c_str());
+        return false;
+    }
+    body.insert(body.end(), _buffer.begin() + _buffer_start, _buffer.begin() + _buffer_end);
+    _bytes_received += _buffer_end - _buffer_start;
+    _buffer_start = _buffer_end;
+
+    char buffer[REMOTE_PACKAGE_BUFFER_SIZE];
+    long got;
+    while ((got = read_some(buffer, sizeof(buffer))) > 0) {
+        if (body.size() + static_cast<uint64_t>(got) > limit) {
+            dpm_log(LOG_ERROR, ("Response from " + _host + " is larger than expected for " + _url).c_str());
+            return false;
+        }
+        body.insert(body.end(), buffer, buffer + got);
+        _bytes_received += static_cast<uint64_t>(got);
+    }
+    return got == 0;
+}
+
+// sends one request and reads its response; stale is set when a reused connection had been closed
+// a partial content body may be at most range_limit bytes, any other at most whole_limit
+bool RemotePackage::exchange(const std::string& range, uint64_t range_limit, uint64_t whole_limit,
+                             Response& response, std::vector<unsigned char>& body, bool& stale)
+{
+    stale = false;
+    bool reused = _fd >= 0;
+    if (!reused && !connect()) {
+        return false;
+    }
+
+    std::string host = _host.find(':') != std::string::npos ? "[" + _host + "]" : _host;
+    if (_port != (_tls ? "443" : "80")) {
+        host += ":" + _port;
+    }
+    std::string request = "GET " + _target + " HTTP/1.1\r\n"
+                          "Host: " + host + "\r\n"
+                          "User-Agent: dpm\r\n"
+                          "Accept-Encoding: identity\r\n"
+                          "Connection: keep-alive\r\n";
+    if (!range.empty()) {
+        request += "Range: bytes=" + range + "\r\n";
+    }
+    request += "\r\n";
+
+    _requests++;
+    std::string status_line;
+    if (!send_all(request) || !read_line(status_line)) {
+        stale = reused;
+        disconnect();
+        if (!stale) {
+            dpm_log(LOG_ERROR, ("No response from " + _host + " for " + _url).c_str());
+        }
+        return false;
+    }
+
+    // HTTP/1.1 206 Partial Content
+    if (status_line.compare(0, 5, "HTTP/") != 0 || status_line.size() < 12) {
+        dpm_log(LOG_ERROR, ("Malformed response from " + _host + ": " + status_line).c_str());
+        disconnect();
+        return false;
+    }
+    response = Response{};
+    response.status = atoi(status_line.c_str() + 9);
+    response.keep_alive = status_line.compare(0, 8, "HTTP/1.0") != 0;
+
+    std::string line;
+    while (true) {
+        if (!read_line(line)) {
+            dpm_log(LOG_ERROR, ("Truncated response from " + _host + " for " + _url).c_str());
+            disconnect();
+            return false;
+        }
+        if (line.empty()) {
+            break;
+        }
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string name = remote_lowercase(line.substr(0, colon));
+        std::string value = remote_trim(line.substr(colon + 1));
+        if (name == "content-length") {
+            char* end = nullptr;
+            errno = 0;
+            response.has_length = true;
+            response.content_length = strtoull(value.c_str(), &end, 10);
+            if (end == value.c_str() || *end != '\0' || errno == ERANGE) {
+                dpm_log(LOG_ERROR, ("Invalid Content-Length from " + _host + ": " + value).c_str());
+                disconnect();
+                return false;
+            }
+        } else if (name == "transfer-encoding") {
+            response.chunked = remote_lowercase(value).find("chunked") != std::string::npos;
+        } else if (name == "content-range") {
+            response.content_range = value;
+        } else if (name == "location") {
+            response.location = value;
+        } else if (name == "connection") {
+            std::string token = remote_lowercase(value);
+            if (token.find("close") != std::string::npos) {
+                response.keep_alive = false;
+            } else if (token.find("keep-alive") != std::string::npos) {
+                response.keep_alive = true;
+            }
+        }
+    }
+
+    uint64_t limit = response.status == 206 ? range_limit : whole_limit;
+    bool read;
+    if (response.status == 204 || response.status == 304) {
+        read = true;
+    } else if (response.chunked) {
+        read = read_chunked(body, limit);
+    } else if (response.has_length) {
+        read = read_body(response.content_length, body, limit);
+    } else {
+        response.keep_alive = false;
+        read = read_to_close(body, limit);
+    }
+
+    if (!read) {
+        dpm_log(LOG_ERROR, ("Failed to read the response from " + _host + " for " + _url).c_str());
+        disconnect();
+        return false;
+    }
+    if (!response.keep_alive) {
+        disconnect();
+    }
+    return true;
+}
+
+bool RemotePackage::slice(uint64_t offset, uint64_t length, std::vector<unsigned char>& data) const
+{
+    if (offset > _data.size()) {
+        dpm_log(LOG_ERROR, ("Range past the end of package: " + _url).c_str());
+        return false;
+    }
+    uint64_t end = length == 0 ? _data.size() : std::min<uint64_t>(_data.size(), offset + length);
+    data.assign(_data.begin() + offset, _data.begin() + end);
+    return true;
+}
+
+bool RemotePackage::fetch(uint64_t offset, uint64_t length, std::vector<unsigned char>& data)
+{
+    data.clear();
+    if (!_valid) {
+        return false;
+    }
+    if (_whole) {
+        return slice(offset, length, data);
+    }
+
+    std::string range = std::to_string(offset) + "-" + (length == 0 ? "" : std::to_string(offset + length - 1));
+
+    try {
+        return fetch_range(offset, length, range, data);
+    } catch (const std::bad_alloc&) {
+        dpm_log(LOG_ERROR, ("Out of memory fetching " + _url).c_str());
+        disconnect();
+        data.clear();
+        return false;
+    }
+}
+
+bool RemotePackage::fetch_range(uint64_t offset, uint64_t length, const std::string& range,
+                                std::vector<unsigned char>& data)
+{
+    int redirects = 0;
+    bool retried = false;
+    while (true) {
+        Response response;
+        std::vector<unsigned char> body;
+        bool stale = false;
+
+        // a body is never larger than the range asked for, or than the package once its size is known
+        uint64_t whole_limit = _size > 0 ? _size : REMOTE_PACKAGE_MAX_BODY;
+        uint64_t range_limit = length > 0 ? length : (_size > offset ? _size - offset : REMOTE_PACKAGE_MAX_BODY);
+        if (!exchange(range, range_limit, whole_limit, response, body, stale)) {
+            if (stale && !retried) {
+                // the server closed the kept-alive connection, once is worth a new one
+                DPM_LOG(LOG_DEBUG, "Connection to ", _host, " was closed, reconnecting");
+                retried = true;
+                continue;
+            }
+            return false;
+        }
+
+        if (response.status == 206) {
+            // Content-Range: bytes 0-65535/1048576
+            unsigned long long first = 0;
+            unsigned long long last = 0;
+            char total[32] = { 0 };
+            if (sscanf(response.content_range.c_str(), "bytes %llu-%llu/%31s", &first, &last, total) != 3 ||
+                first != offset || body.size() != last - first + 1) {
+                dpm_log(LOG_ERROR, ("Unexpected byte range from " + _host + ": " + response.content_range).c_str());
+                disconnect();
+                return false;
+            }
+            if (total[0] != '*') {
+                _size = strtoull(total, nullptr, 10);
+            }
+            data = std::move(body);
+            return true;
+        }
+
+        if (response.status == 200) {
+            // ranges are not supported, the whole package came back and serves every later fetch
+            DPM_LOG(LOG_DEBUG, "Server ignored the byte range, downloaded all ", body.size(), " bytes of ", _url);
+            _data = std::move(body);
+            _size = _data.size();
+            _whole = true;
+            return slice(offset, length, data);
+        }
+
+        if (response.status == 416 && length == 0 && offset > 0) {
+            // nothing from offset on
+            return true;
+        }
+
+        if ((response.status == 301 || response.status == 302 || response.status == 303 ||
+             response.status == 307 || response.status == 308) && !response.location.empty()) {
+            if (++redirects > REMOTE_PACKAGE_MAX_REDIRECTS) {
+                dpm_log(LOG_ERROR, ("Too many redirects for " + _url).c_str());
+                return false;
+            }
+
+            std::string location = response.location;
+
+            // a redirect must not drop TLS, and with it the certificate check, for the rest of the reads
+            if (_tls && remote_lowercase(location.substr(0, 7)) == "http://") {
+                dpm_log(LOG_ERROR, ("Refusing redirect from HTTPS to HTTP for " + _url + ": " + location).c_str());
+                return false;
+            }
+            if (location[0] == '/') {
+                location = (_tls ? "https://" : "http://") +
+                           (_host.find(':') != std::string::npos ? "[" + _host + "]" : _host) + ":" + _port + location;
+            }
+            std::string host = _host;
+            std::string port = _port;
+            bool tls = _tls;
+            if (!parse_url(location)) {
+                dpm_log(LOG_ERROR, ("Unsupported redirect for " + _url + ": " + location).c_str());
+                return false;
+            }
+
+            // the connection is kept when the redirect stays on the same server
+            if (host != _host || port != _port || tls != _tls) {
+                disconnect();
+            }
+            DPM_LOG(LOG_DEBUG, "Redirected to ", _url);
+            continue;
+        }
+
+        dpm_log(LOG_ERROR, ("HTTP status " + std::to_string(response.status) + " fetching " + _url).c_str());
+        return false;
+    }
+}
@@ -0,0 +1,156 @@
+/**
+ * @file seal_fingerprint.cpp
+ * @brief Implementation of the stage seal fingerprint
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "seal_fingerprint.hpp"
+
+// first line of the record
+static const char* SEAL_FINGERPRINT_HEADER = "DPM_SEAL_FINGERPRINT 1";
+
+static int64_t seal_fingerprint_time_ns(const struct timespec& time)
+{
+    return static_cast<int64_t>(time.tv_sec) * 1000000000LL + time.tv_nsec;
+}
+
+// one line per entry: everything that changes when the entry's type, ownership or content does
+static std::string seal_fingerprint_stat_line(const std::string& path, const struct stat& st)
+{
+    return path + " " + std::to_string(st.st_mode) + " " + std::to_string(st.st_uid) + " " +
+           std::to_string(st.st_gid) + " " + std::to_string(st.st_size) + " " +
+           std::to_string(seal_fingerprint_time_ns(st.st_mtim)) + " " +
+           std::to_string(seal_fingerprint_time_ns(st.st_ctim)) + " " + std::to_string(st.st_ino) + "\n";
+}
+
+bool seal_fingerprint_compute(const std::filesystem::path& stage_path, std::string& fingerprint)
+{
+    fingerprint.clear();
+
+    std::vector<std::string> algorithms = get_configured_hash_algorithms();
+    MultiChecksum checksum({ get_configured_hash_algorithm() });
+    if (!checksum.valid() || !checksum.begin()) {
+        dpm_log(LOG_ERROR, "Failed to initialize the stage fingerprint digest");
+        return false;
+    }
+    auto add = [&](const std::string& text) {
+        return checksum.update(text.data(), text.size());
+    };
+
+    // settings that change the sealed output without touching the stage
+    std::string settings = "algorithms";
+    for (const auto& algorithm : algorithms) {
+        settings += " " + algorithm;
+    }
+    bool added = add(settings + "\n");
+
+    for (const char* component : { "contents", "hooks", "metadata", "signatures" }) {
+        CompressionSettings compression = compression_for_component(component);
+        added = added && add("compression " + std::string(component) + " " + compression_codec_name(compression.codec) +
+                             ":" + std::to_string(compression.level) + "\n");
+
+        std::filesystem::path component_path = stage_path / component;
+        struct stat st;
+        if (lstat(component_path.c_str(), &st) != 0) {
+            added = added && add(std::string(component) + " missing\n");
+            continue;
+        }
+
+        // a sealed component is its archive, an unsealed one everything below it
+        added = added && add(seal_fingerprint_stat_line(component, st));
+        if (S_ISDIR(st.st_mode)) {
+            TreeWalk walk;
+            if (!tree_walk(component_path, walk, tree_walk_worker_count())) {
+                dpm_log(LOG_ERROR, ("Failed to walk stage component: " + component_path.string()).c_str());
+                return false;
+            }
+            for (const auto& entry : walk) {
+                added = added && add(seal_fingerprint_stat_line(std::string(component) + "/" + entry.relative_path,
+                                                                entry.st));
+            }
+        }
+    }
+
+    std::vector<std::string> digests;
+    if (!added || !checksum.finish(digests) || digests.empty()) {
+        dpm_log(LOG_ERROR, "Failed to compute the stage fingerprint");
+        return false;
+    }
+    fingerprint = digests.front();
+    return true;
+}
+
+// the line identifying the package in the record, empty if the package does not exist
+static std::string seal_fingerprint_package_line(const std::filesystem::path& package_path)
+{
+    struct stat st;
+    if (stat(package_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return "";
+    }
+
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(package_path, ec).lexically_normal();
+    return std::to_string(st.st_size) + " " + std::to_string(seal_fingerprint_time_ns(st.st_mtim)) + " " +
+           (ec ? package_path.string() : absolute.string());
+}
+
+bool seal_fingerprint_unchanged(const std::filesystem::path& stage_path, const std::filesystem::path& package_path,
+                                const std::string& seal_kind)
+{
+    std::ifstream record(stage_path / SEAL_FINGERPRINT_FILENAME);
+    if (!record.is_open()) {
+        return false;
+    }
+
+    std::string header, stored_kind, stored_fingerprint, stored_package;
+    if (!std::getline(record, header) || header != SEAL_FINGERPRINT_HEADER || !std::getline(record, stored_kind) ||
+        !std::getline(record, stored_fingerprint) || !std::getline(record, stored_package)) {
+        dpm_log(LOG_DEBUG, "Ignoring malformed seal fingerprint record");
+        return false;
+    }
+
+    if (stored_kind != seal_kind) {
+        DPM_LOG(LOG_DEBUG, "Stage was last sealed by a ", stored_kind, " seal, not a ", seal_kind, " seal");
+        return false;
+    }
+
+    std::string package_line = seal_fingerprint_package_line(package_path);
+    if (package_line.empty() || package_line != stored_package) {
+        DPM_LOG(LOG_DEBUG, "Package changed since the stage was last sealed: ", package_path.string());
+        return false;
+    }
+
+    std::string fingerprint;
+    if (!seal_fingerprint_compute(stage_path, fingerprint) || fingerprint != stored_fingerprint) {
+        dpm_log(LOG_DEBUG, "Stage changed since it was last sealed");
+        return false;
+    }
+    return true;
+}
+
+void seal_fingerprint_store(const std::filesystem::path& stage_path, const std::filesystem::path& package_path,
+                            const std::string& seal_kind)
+{
+    std::filesystem::path record_path = stage_path / SEAL_FINGERPRINT_FILENAME;
+    std::string fingerprint;
+    std::string package_line = seal_fingerprint_package_line(package_path);
+    if (package_line.empty() || !seal_fingerprint_compute(stage_path, fingerprint)) {
+        dpm_log(LOG_WARN, "Could not record the stage fingerprint, the next seal will not be skipped");
+        std::error_code ec;
+        std::filesystem::remove(record_path, ec);
+        return;
+    }
+
+    std::ofstream record(record_path, std::ios::trunc);
+    record << SEAL_FINGERPRINT_HEADER << "\n" << seal_kind << "\n" << fingerprint << "\n" << package_line << "\n";
+    record.close();
+    if (!record) {
+        dpm_log(LOG_WARN, ("Failed to write seal fingerprint record: " + record_path.string()).c_str());
+        return;
+    }
+    DPM_LOG(LOG_DEBUG, "Recorded stage fingerprint ", fingerprint);
+}
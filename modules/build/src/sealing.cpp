@@ -5,107 +5,132 @@
 
 bool file_already_compressed(const std::string& path)
 {
-    // Convert string to filesystem path
-    std::filesystem::path fs_path(path);
-
-    // Check if it's a regular file (not a directory)
-    if (!std::filesystem::is_regular_file(fs_path))
-    {
-        return false;
-    }
-
-    // Open the file and check the magic number
-    std::ifstream file(fs_path, std::ios::binary);
-    if (!file.is_open())
-    {
-        return false;
-    }
-
-    unsigned char header[2];
-    if (!file.read(reinterpret_cast<char*>(header), 2))
-    {
-        file.close();
-        return false;
-    }
+    // any component archive counts, including a plain tar sealed with "none"
+    return compression_detect_file(path) != CompressionCodec::UNKNOWN;
+}
 
-    // Close the file after reading
-    file.close();
+// libarchive client callbacks that hand the tar stream to a block-parallel gzip writer
+static int parallel_gzip_archive_open(struct archive*, void* client_data)
+{
+    return static_cast<ParallelGzipWriter*>(client_data)->open() ? ARCHIVE_OK : ARCHIVE_FATAL;
+}
 
-    // Check for gzip magic number (0x1F 0x8B)
-    return (header[0] == 0x1F && header[1] == 0x8B);
+static la_ssize_t parallel_gzip_archive_write(struct archive*, void* client_data, const void* buffer, size_t length)
+{
+    return static_cast<ParallelGzipWriter*>(client_data)->write(buffer, length) ? static_cast<la_ssize_t>(length) : -1;
 }
 
-// transform a directory at source_dir into a gzipped tarball at output_path
-// source_dir and output_path cannot match
-bool compress_directory( const std::string source_dir, const std::string output_path )
+static int parallel_gzip_archive_close(struct archive*, void* client_data)
 {
-    // Verify source directory exists
-    std::filesystem::path src_path(source_dir);
-    if ( !std::filesystem::exists(src_path) )
-    {
-        // path to compress doesn't exist, so bail
-        dpm_log(LOG_ERROR, ("Source directory does not exist: " + source_dir).c_str());
-        return false;
-    }
+    return static_cast<ParallelGzipWriter*>(client_data)->close() ? ARCHIVE_OK : ARCHIVE_FATAL;
+}
 
-    // Check if source is actually a directory
-    if ( !std::filesystem::is_directory(src_path) )
-    {
-        // it's not a directory, so bail
-        dpm_log(LOG_ERROR, ("Source is not a directory: " + source_dir).c_str());
-        return false;
-    }
+// libarchive client callback that hands the tar stream to an output function
+static la_ssize_t archive_sink_write(struct archive*, void* client_data, const void* buffer, size_t length)
+{
+    return (*static_cast<ArchiveOutputSink*>(client_data))(buffer, length) ? static_cast<la_ssize_t>(length) : -1;
+}
 
-    // Check if source and output paths are the same
-    if ( source_dir == output_path )
+// gives the data of a large file a seekable frame of its own, copied from the content store when
+// it holds the frame already and added to it otherwise; the checksum comes from the stage's stat
+// cache, so a file changed since it was last hashed is compressed as usual
+static void seal_store_frame( const ContentStore& store, const std::string& codec, const StatCache& cache,
+                              ParallelGzipWriter& writer, struct archive* a, const std::string& relative_path,
+                              const struct stat& st )
+{
+    std::string checksum;
+    if ( !stat_cache_lookup( cache, relative_path, st, store.algorithm(), checksum ) )
     {
-        // they match, so bail
-        dpm_log(LOG_ERROR, "Source directory and output path cannot be the same");
-        return false;
+        return;
     }
 
-    // if the output path is empty, bail
-    if ( output_path.empty() )
+    uint64_t offset = static_cast<uint64_t>( archive_filter_bytes(a, 0) );
+    uint64_t size = ( static_cast<uint64_t>(st.st_size) + 511 ) & ~static_cast<uint64_t>(511);
+    std::vector<unsigned char> member;
+    if ( store.load_frame( codec, checksum, size, member ) )
     {
-        dpm_log(LOG_ERROR, "Output path is empty.  Refusing to write a non-existant archive.");
-        return false;
+        DPM_LOG(LOG_DEBUG, "Reusing the stored frame of ", relative_path);
+        writer.reuse_frame( offset, size, std::move(member), [&store, codec, checksum, relative_path] {
+            store.discard_frame( codec, checksum );
+            dpm_log( LOG_ERROR, ("Removed the stored frame of " + relative_path +
+                                 " from the content store, seal again to compress it anew").c_str() );
+        } );
     }
-
-    // convert the output path to a path object
-    std::filesystem::path out_path(output_path);
-
-    // get the parent path directory
-    std::filesystem::path parent_path = out_path.parent_path();
-
-    // if the parent path is not empty and it does not exist
-    if ( !parent_path.empty() && !std::filesystem::exists(parent_path) )
+    else
     {
-        // can't write to output path so bail
-        dpm_log( LOG_ERROR, ( "Output path parent directory does not exist: " + parent_path.string()).c_str() );
-        return false;
+        writer.capture_frame( offset, size, [&store, codec, checksum]( const std::vector<unsigned char>& frame ) {
+            store.save_frame( codec, checksum, frame );
+        } );
     }
+}
 
-    dpm_log( LOG_INFO, ("Compressing directory " + source_dir + " to archive " + out_path.string()).c_str() );
-
+// writes the tarball of src_path to the file output_name, or to sink when it is set
+static bool write_directory_archive( const std::filesystem::path& src_path, const std::string& output_name,
+                                     const CompressionSettings& compression, const ArchiveOutputSink* sink,
+                                     const ArchiveTee* tee )
+{
     // Use libarchive to create a compressed tarball
     struct archive * a;
     struct archive_entry * entry;
-    char buff[8192];
-    int len;
 
     // Create a new archive
     a = archive_write_new();
 
-    // Set the compression format to gzip
-    archive_write_add_filter_gzip(a);
+    // With more than one compression thread the tar stream is gzipped
+    // block-parallel outside libarchive, see parallel_gzip.hpp; seekable gzip
+    // is always written that way since only that writer cuts frames
+    size_t compression_threads = compression.codec == CompressionCodec::NONE ? 1 : parallel_gzip_thread_count();
+    bool seekable = compression.codec == CompressionCodec::GZIP_SEEKABLE;
+
+    // seekable contents share the frames of large files through the content store, see content_store.hpp
+    ContentStore frame_store;
+    StatCache frame_cache;
+    bool store_frames = seekable && src_path.filename() == "contents" && frame_store.open_configured();
+    if ( store_frames )
+    {
+        stat_cache_load( src_path.parent_path(), frame_cache );
+        store_frames = !frame_cache.empty();
+    }
+    std::string frame_codec = "gzip-" + std::to_string( compression.level > 0 ? compression.level : 6 );
+
+    std::unique_ptr<ParallelGzipWriter> gzip_writer;
+    if ( seekable || ( compression.codec == CompressionCodec::GZIP && compression_threads > 1 ) ) {
+        int level = compression.level > 0 ? compression.level : Z_DEFAULT_COMPRESSION;
+        gzip_writer = sink
+            ? std::make_unique<ParallelGzipWriter>( *sink, compression_threads, level )
+            : std::make_unique<ParallelGzipWriter>( output_name, compression_threads, level );
+        if ( seekable ) {
+            gzip_writer->enable_frames( FRAME_INDEX_FRAME_SIZE );
+        }
+        DPM_LOG(LOG_DEBUG, "Compressing with ", compression_threads, " threads");
+    }
+
+    // Set the compression codec, leaving the tar uncompressed for "none" so
+    // that members can be addressed directly in a memory mapped file
+    CompressionSettings filter = gzip_writer ? CompressionSettings{ CompressionCodec::NONE, 0 } : compression;
+    if ( !compression_write_filter( a, filter, compression_threads ) ) {
+        archive_write_free(a);
+        return false;
+    }
 
     // Set the archive format to tar
     archive_write_set_format_pax_restricted(a);
 
-    // Open the output file
-    if ( archive_write_open_filename( a, out_path.string().c_str()) != ARCHIVE_OK )
+    // Open the output file or stream
+    int open_result;
+    if ( gzip_writer ) {
+        open_result = archive_write_open( a, gzip_writer.get(), parallel_gzip_archive_open,
+                                          parallel_gzip_archive_write, parallel_gzip_archive_close );
+    } else if ( sink ) {
+        // a stream has no use for the padding of the last tar block
+        archive_write_set_bytes_in_last_block( a, 1 );
+        open_result = archive_write_open( a, const_cast<ArchiveOutputSink*>(sink), NULL, archive_sink_write, NULL );
+    } else {
+        open_result = archive_write_open_filename( a, output_name.c_str() );
+    }
+    if ( open_result != ARCHIVE_OK )
     {
-        dpm_log( LOG_ERROR, ("Failed to create archive: " + out_path.string()).c_str() );
+        dpm_log( LOG_ERROR, ("Failed to create archive: " + output_name).c_str() );
         archive_write_free(a);
         return false;
     }
@@ -121,36 +146,74 @@ bool compress_directory( const std::string source_dir, const std::string output_
     archive_write_header( a, entry );
     archive_entry_free( entry );
 
-    // Create a vector to store all entries in the directory for proper empty directory handling
-    std::vector<std::filesystem::path> all_entries;
+    // The walk lstats every entry once, which gives both its type and what
+    // goes into the archive; the caller may have walked the directory already
+    TreeWalk own_walk;
+    const TreeWalk* walk = tee ? tee->walk : nullptr;
+    if ( !walk )
+    {
+        if ( !tree_walk( src_path, own_walk, tree_walk_worker_count() ) )
+        {
+            dpm_log(LOG_ERROR, ("Error scanning directory: " + src_path.string()).c_str());
+            archive_write_close(a);
+            archive_write_free(a);
+            return false;
+        }
+        walk = &own_walk;
+    }
 
-    // First collect all entries including empty directories
-    try
+    struct ArchiveWalkEntry {
+        std::string full_path;
+        const TreeWalkEntry* entry;
+    };
+    std::vector<ArchiveWalkEntry> all_entries;
+    all_entries.reserve( walk->size() );
+    for ( const auto& walk_entry : *walk )
     {
-        for ( const auto& dir_entry : std::filesystem::recursive_directory_iterator(src_path) )
+        // the stage's stat cache is local build state, never part of a package
+        if ( walk_entry.relative_path == STAT_CACHE_FILENAME )
         {
-            all_entries.push_back(dir_entry.path());
+            continue;
         }
+        all_entries.push_back( { ( src_path / walk_entry.relative_path ).string(), &walk_entry } );
     }
-    catch (const std::exception& e)
+
+    // small files are read ahead on another thread while the archive is written
+    std::vector<std::string> prefetch_paths;
+    std::vector<uint64_t> prefetch_sizes;
+    for ( const auto& walk_entry : all_entries )
     {
-        dpm_log(LOG_ERROR, ("Error scanning directory: " + std::string(e.what())).c_str());
-        archive_write_close(a);
-        archive_write_free(a);
-        return false;
+        const struct stat& st = walk_entry.entry->st;
+        if ( S_ISREG(st.st_mode) && static_cast<uint64_t>(st.st_size) <= FILE_PREFETCH_MAX_FILE_SIZE )
+        {
+            prefetch_paths.push_back( walk_entry.full_path );
+            prefetch_sizes.push_back( static_cast<uint64_t>(st.st_size) );
+        }
     }
+    FilePrefetcher prefetcher( std::move(prefetch_paths), std::move(prefetch_sizes), FILE_PREFETCH_MEMORY_LIMIT );
+    std::vector<unsigned char> read_buffer;
+    ArchiveFileObserver* observer = tee ? tee->files : nullptr;
 
     // Walk through all collected entries and add them to the archive
     try
     {
-        for ( const auto& full_path : all_entries )
+        for ( const auto& walk_entry : all_entries )
         {
-            // Get the relative path from the component path
-            std::string relative_path = std::filesystem::relative( full_path, src_path ).string();
+            const std::string& full_path = walk_entry.full_path;
+            const std::string& relative_path = walk_entry.entry->relative_path;
+            const struct stat& st = walk_entry.entry->st;
 
             // Path in archive with parent directory
             std::string archive_path_entry = output_parent_dir + "/" + relative_path;
 
+            // a seekable archive may start a new frame here, once the previous
+            // entry's padding is out and the offset is that of this header
+            if ( seekable )
+            {
+                archive_write_finish_entry(a);
+                gzip_writer->mark_entry( static_cast<uint64_t>( archive_filter_bytes(a, 0) ), archive_path_entry );
+            }
+
             // Create a new entry for this file/directory
             entry = archive_entry_new();
 
@@ -158,65 +221,110 @@ bool compress_directory( const std::string source_dir, const std::string output_
             archive_entry_set_pathname(entry, archive_path_entry.c_str());
 
             // Handle different file types
-            if ( std::filesystem::is_symlink(full_path) )
+            if ( S_ISLNK(st.st_mode) )
             {
                 // For symbolic links, set the link target
                 std::filesystem::path target = std::filesystem::read_symlink(full_path);
                 archive_entry_set_symlink(entry, target.c_str());
                 archive_entry_set_filetype(entry, AE_IFLNK);
-
-                // Get file information using lstat for the symlink itself
-                struct stat st;
-                lstat(full_path.string().c_str(), &st);
                 archive_entry_copy_stat(entry, &st);
 
                 // Write the entry header
                 archive_write_header(a, entry);
             }
-            else if ( std::filesystem::is_directory(full_path) )
+            else if ( S_ISDIR(st.st_mode) )
             {
                 // For directories, set the directory type
                 archive_entry_set_filetype(entry, AE_IFDIR);
-
-                // Get file information using stat
-                struct stat st;
-                stat(full_path.string().c_str(), &st);
                 archive_entry_copy_stat(entry, &st);
 
                 // Write the entry header
                 archive_write_header(a, entry);
             }
-            else if ( std::filesystem::is_regular_file(full_path) )
+            else if ( S_ISREG(st.st_mode) )
             {
                 // For regular files, add the file content
                 archive_entry_set_filetype(entry, AE_IFREG);
-
-                // Get file information using stat
-                struct stat st;
-                stat(full_path.string().c_str(), &st);
                 archive_entry_copy_stat(entry, &st);
 
                 // Write the entry header
                 archive_write_header(a, entry);
 
-                // Write file contents
-                std::ifstream file(full_path, std::ios::binary);
-                if (file.is_open())
+                if ( store_frames && static_cast<uint64_t>(st.st_size) >= frame_store.min_size() )
+                {
+                    seal_store_frame( frame_store, frame_codec, frame_cache, *gzip_writer, a, relative_path, st );
+                }
+
+                // Write file contents, handing the same bytes to the observer so they are read once
+                auto write_data = [&]( const void* data, size_t size ) {
+                    archive_write_data( a, data, size );
+                    dpm_metric_add( DPM_METRIC_BYTES_COMPRESSED, size );
+                    if ( observer && !observer->file_data( data, size ) )
+                    {
+                        throw std::runtime_error( "failed to digest " + full_path );
+                    }
+                    return true;
+                };
+
+                int read_error = 0;
+                if ( static_cast<uint64_t>(st.st_size) <= FILE_PREFETCH_MAX_FILE_SIZE )
                 {
-                    while (!file.eof())
+                    PrefetchedFile prefetched;
+                    if ( !prefetcher.next( prefetched ) )
                     {
-                        file.read(buff, sizeof(buff));
-                        len = file.gcount();
-                        if (len > 0)
+                        throw std::runtime_error( "file prefetch list ended before " + full_path );
+                    }
+                    read_error = prefetched.error;
+                    if ( read_error == 0 )
+                    {
+                        if ( observer && !observer->begin_file( relative_path, st ) )
+                        {
+                            throw std::runtime_error( "failed to start digest of " + full_path );
+                        }
+                        if ( !prefetched.data.empty() )
                         {
-                            archive_write_data(a, buff, len);
+                            write_data( prefetched.data.data(), prefetched.data.size() );
                         }
                     }
-                    file.close();
                 }
                 else
                 {
-                    dpm_log(LOG_ERROR, ("Failed to open file for archiving: " + full_path.string()).c_str());
+                    int fd = ::open( full_path.c_str(), O_RDONLY | O_CLOEXEC );
+                    if ( fd < 0 )
+                    {
+                        read_error = errno;
+                    }
+                    else
+                    {
+                        if ( observer && !observer->begin_file( relative_path, st ) )
+                        {
+                            ::close( fd );
+                            throw std::runtime_error( "failed to start digest of " + full_path );
+                        }
+                        try
+                        {
+                            read_error = file_read_sequential( fd, read_buffer, write_data );
+                        }
+                        catch (...)
+                        {
+                            ::close( fd );
+                            throw;
+                        }
+                        ::close( fd );
+                        if ( read_error != 0 )
+                        {
+                            throw std::runtime_error( "failed to read " + full_path + ": " + strerror(read_error) );
+                        }
+                    }
+                }
+
+                if ( read_error != 0 )
+                {
+                    dpm_log(LOG_ERROR, ("Failed to open file for archiving: " + full_path + ": " + strerror(read_error)).c_str());
+                }
+                else if ( observer && !observer->end_file() )
+                {
+                    throw std::runtime_error( "failed to finish digest of " + full_path );
                 }
             }
 
@@ -232,16 +340,145 @@ bool compress_directory( const std::string source_dir, const std::string output_
         return false;
     }
 
-    // Close and free the archive
-    archive_write_close(a);
+    // Close and free the archive; closing flushes the last of the compressed data
+    if ( archive_write_close(a) != ARCHIVE_OK )
+    {
+        dpm_log(LOG_ERROR, ("Failed to finish archive: " + output_name).c_str());
+        archive_write_free(a);
+        return false;
+    }
     archive_write_free(a);
 
+    return true;
+}
+
+// transform a directory at source_dir into a tarball at output_path, compressed as set in compression
+// source_dir and output_path cannot match
+bool compress_directory( const std::string source_dir, const std::string output_path, const CompressionSettings& compression,
+                         const ArchiveTee* tee = nullptr )
+{
+    DpmProfileScope profile("compress_directory");
+
+    // Verify source directory exists
+    std::filesystem::path src_path(source_dir);
+    if ( !std::filesystem::exists(src_path) )
+    {
+        // path to compress doesn't exist, so bail
+        dpm_log(LOG_ERROR, ("Source directory does not exist: " + source_dir).c_str());
+        return false;
+    }
+
+    // Check if source is actually a directory
+    if ( !std::filesystem::is_directory(src_path) )
+    {
+        // it's not a directory, so bail
+        dpm_log(LOG_ERROR, ("Source is not a directory: " + source_dir).c_str());
+        return false;
+    }
+
+    // Check if source and output paths are the same
+    if ( source_dir == output_path )
+    {
+        // they match, so bail
+        dpm_log(LOG_ERROR, "Source directory and output path cannot be the same");
+        return false;
+    }
+
+    // if the output path is empty, bail
+    if ( output_path.empty() )
+    {
+        dpm_log(LOG_ERROR, "Output path is empty.  Refusing to write a non-existant archive.");
+        return false;
+    }
+
+    // convert the output path to a path object
+    std::filesystem::path out_path(output_path);
+
+    // get the parent path directory
+    std::filesystem::path parent_path = out_path.parent_path();
+
+    // if the parent path is not empty and it does not exist
+    if ( !parent_path.empty() && !std::filesystem::exists(parent_path) )
+    {
+        // can't write to output path so bail
+        dpm_log( LOG_ERROR, ( "Output path parent directory does not exist: " + parent_path.string()).c_str() );
+        return false;
+    }
+
+    dpm_log( LOG_INFO, ("Compressing directory " + source_dir + " to archive " + out_path.string()).c_str() );
+
+    bool written;
+    if ( tee && tee->output )
+    {
+        // the archive bytes go to the file and the tee, so write the file ourselves
+        int fd = open( out_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+        if ( fd < 0 )
+        {
+            dpm_log( LOG_ERROR, ("Failed to create archive: " + out_path.string() + ": " + strerror(errno)).c_str() );
+            return false;
+        }
+
+        ArchiveOutputSink sink = [&]( const void* data, size_t size ) {
+            const char* bytes = static_cast<const char*>(data);
+            size_t remaining = size;
+            while ( remaining > 0 ) {
+                ssize_t count = ::write( fd, bytes, remaining );
+                if ( count < 0 && errno == EINTR ) {
+                    continue;
+                }
+                if ( count < 0 ) {
+                    dpm_log( LOG_ERROR, ("Failed to write archive: " + out_path.string() + ": " + strerror(errno)).c_str() );
+                    return false;
+                }
+                bytes += count;
+                remaining -= static_cast<size_t>(count);
+            }
+            return tee->output( data, size );
+        };
+
+        written = write_directory_archive( src_path, out_path.string(), compression, &sink, tee );
+        if ( close(fd) != 0 && written )
+        {
+            dpm_log( LOG_ERROR, ("Failed to close archive: " + out_path.string() + ": " + strerror(errno)).c_str() );
+            written = false;
+        }
+    }
+    else
+    {
+        written = write_directory_archive( src_path, out_path.string(), compression, nullptr, tee );
+    }
+
+    if ( !written )
+    {
+        return false;
+    }
+
     dpm_log(LOG_INFO, ("Archive created at: " + out_path.string()).c_str());
 
     return true;
 }
 
-// Uncompress a gzipped tarball at source_path to a directory at output_dir
+bool compress_directory_to_sink( const std::string& source_dir, const CompressionSettings& compression,
+                                 const ArchiveOutputSink& sink, const ArchiveTee* tee )
+{
+    std::filesystem::path src_path(source_dir);
+    if ( !std::filesystem::is_directory(src_path) )
+    {
+        dpm_log(LOG_ERROR, ("Source is not a directory: " + source_dir).c_str());
+        return false;
+    }
+
+    dpm_log( LOG_INFO, ("Compressing directory " + source_dir + " to a stream").c_str() );
+    if ( tee && tee->output ) {
+        ArchiveOutputSink both = [&]( const void* data, size_t size ) {
+            return sink( data, size ) && tee->output( data, size );
+        };
+        return write_directory_archive( src_path, source_dir, compression, &both, tee );
+    }
+    return write_directory_archive( src_path, source_dir, compression, &sink, tee );
+}
+
+// Uncompress a tarball in any component codec at source_path to a directory at output_dir
 bool uncompress_archive(const std::string& source_path, const std::string& output_dir)
 {
     dpm_log(LOG_INFO, ("Extracting archive " + source_path + " to directory " + output_dir).c_str());
@@ -281,12 +518,15 @@ bool uncompress_archive(const std::string& source_path, const std::string& outpu
 
     a = archive_read_new();
     archive_read_support_format_tar(a);
-    archive_read_support_filter_gzip(a);
+    compression_read_support(a);
 
     ext = archive_write_disk_new();
     archive_write_disk_set_options(ext, flags);
     archive_write_disk_set_standard_lookup(ext);
 
+    // creating files is handed to a pool so it overlaps with the decompression on this thread
+    DiskWritePool pool(disk_write_pool_worker_count(), flags);
+
     // Open the archive
     if ((r = archive_read_open_filename(a, source_path.c_str(), 10240)) != ARCHIVE_OK) {
         dpm_log(LOG_ERROR, ("Failed to open archive: " + source_path).c_str());
@@ -332,6 +572,55 @@ bool uncompress_archive(const std::string& source_path, const std::string& outpu
         std::string full_path = (out_path / entry_path).string();
         archive_entry_set_pathname(entry, full_path.c_str());
 
+        // Small files and symlinks are decompressed here and created by the pool,
+        // everything else is written by this thread as it is read
+        bool hardlink = archive_entry_hardlink(entry) != NULL;
+        bool small_file = archive_entry_filetype(entry) == AE_IFREG &&
+                          archive_entry_size(entry) >= 0 &&
+                          static_cast<uint64_t>(archive_entry_size(entry)) <= DISK_WRITE_POOL_MAX_FILE_SIZE;
+        if (!hardlink && (small_file || archive_entry_filetype(entry) == AE_IFLNK)) {
+            std::vector<unsigned char> data;
+            if (small_file) {
+                data.resize(static_cast<size_t>(archive_entry_size(entry)));
+            }
+
+            const void* buff;
+            size_t size;
+            la_int64_t offset;
+            while (small_file) {
+                r = archive_read_data_block(a, &buff, &size, &offset);
+                if (r == ARCHIVE_EOF) {
+                    break;
+                }
+                if (r != ARCHIVE_OK) {
+                    dpm_log(LOG_ERROR, ("Archive read data error: " + std::string(archive_error_string(a))).c_str());
+                    success = false;
+                    break;
+                }
+                if (offset < 0 || static_cast<uint64_t>(offset) + size > data.size()) {
+                    data.resize(static_cast<size_t>(offset) + size);
+                }
+                if (size > 0) {
+                    memcpy(data.data() + offset, buff, size);
+                }
+            }
+            if (!success) {
+                break;
+            }
+
+            if (!pool.submit(archive_entry_clone(entry), std::move(data))) {
+                success = false;
+                break;
+            }
+            continue;
+        }
+
+        // a hard link needs its target on disk, which may still be queued
+        if (hardlink && !pool.drain()) {
+            success = false;
+            break;
+        }
+
         // Write the entry to disk
         r = archive_write_header(ext, entry);
         if (r != ARCHIVE_OK) {
@@ -378,6 +667,12 @@ bool uncompress_archive(const std::string& source_path, const std::string& outpu
         }
     }
 
+    // the pool's handles are closed first, so the directory fixups done by
+    // closing ext come after every file inside them has been written
+    if (!pool.finish()) {
+        success = false;
+    }
+
     // Clean up
     archive_read_close(a);
     archive_read_free(a);
@@ -390,10 +685,12 @@ bool uncompress_archive(const std::string& source_path, const std::string& outpu
     return success;
 }
 
-// compresses a directory component in a pacakge stage
-bool smart_compress_component( const std::filesystem::path& stage_dir, const std::filesystem::path& component )
+// compresses a directory component of a package stage next to it, as <component>.tmp
+// a component that is already sealed is left alone
+static bool compress_component_archive( const std::filesystem::path& stage_dir, const std::string& component,
+                                        const ArchiveTee* tee )
 {
-    std::filesystem::path component_path = stage_dir / component.string().c_str();
+    std::filesystem::path component_path = stage_dir / component;
 
     // check if it's not a directory
     if ( ! std::filesystem::is_directory(component_path) )
@@ -405,124 +702,634 @@ bool smart_compress_component( const std::filesystem::path& stage_dir, const std
             // that component has already been compressed, so behave idempotently
             dpm_log(LOG_INFO, ( component_path.string() + " is already compressed, nothing to do." ).c_str() );
             return true;
-        } else {
-            // it's not a directory and it's not a compressed archive, so bail
-            dpm_log(LOG_ERROR, ("Component is not a directory and not a compressed archive: " + component_path.string() ).c_str() );
-            return false;
-        }
-    } else {
-        // it's a directory so compress it
-        dpm_log(LOG_INFO, ("Compressing directory: " + component_path.string()).c_str());
-        bool result = compress_directory( component_path, component_path.string() + ".tmp" );
-        if ( ! result ) {
-            dpm_log( LOG_ERROR, ("Failed to compress component directory: " + component_path.string() ).c_str() );
-            return false;
         }
+
+        // it's not a directory and it's not a compressed archive, so bail
+        dpm_log(LOG_ERROR, ("Component is not a directory and not a compressed archive: " + component_path.string() ).c_str() );
+        return false;
+    }
+
+    // it's a directory so compress it with the codec configured for the component
+    CompressionSettings compression = compression_for_component( component );
+    dpm_log(LOG_INFO, ("Compressing directory: " + component_path.string() + " (" +
+                       compression_codec_name(compression.codec) + ")").c_str());
+    bool result = compress_directory( component_path, component_path.string() + ".tmp", compression, tee );
+    if ( ! result ) {
+        dpm_log( LOG_ERROR, ("Failed to compress component directory: " + component_path.string() ).c_str() );
+        std::error_code ec;
+        std::filesystem::remove( component_path.string() + ".tmp", ec );
+        return false;
+    }
+    return true;
+}
+
+// replaces a component directory with the archive compress_component_archive made of it
+static bool place_component_archive( const std::filesystem::path& stage_dir, const std::string& component )
+{
+    std::filesystem::path component_path = stage_dir / component;
+    std::filesystem::path archive_path = component_path.string() + ".tmp";
+
+    // nothing was compressed because the component was already sealed
+    if ( ! std::filesystem::is_directory(component_path) ) {
+        return true;
     }
+
     // clean up the evidence
     try {
         std::filesystem::remove_all(component_path);
-        std::filesystem::rename( component_path.string() + ".tmp", component_path.string() );
+        std::filesystem::rename( archive_path, component_path );
     }
     catch ( const std::exception& e ) {
         dpm_log(LOG_FATAL, ("Error placing new archive: " + std::string(e.what())).c_str());
-        std::filesystem::remove( component_path.string() + ".tmp" );
+        std::filesystem::remove( archive_path );
         return false;
     }
     dpm_log( LOG_INFO, ( "Successfully created archive at: " + component_path.string() ).c_str() ); ;
     return true;
 }
 
+// compresses a directory component in a pacakge stage
+bool smart_compress_component( const std::filesystem::path& stage_dir, const std::filesystem::path& component )
+{
+    return compress_component_archive( stage_dir, component.string(), nullptr ) &&
+           place_component_archive( stage_dir, component.string() );
+}
+
+/**
+ * @brief Digests the files of a component while compress_directory archives them
+ *
+ * Records every file it sees as a stat cache entry, so that the metadata
+ * derived from the component can be written without reading the files again.
+ */
+class ArchiveDigestRecorder : public ArchiveFileObserver {
+public:
+    explicit ArchiveDigestRecorder(const std::vector<std::string>& algorithms)
+        : _algorithms(algorithms), _checksum(algorithms)
+    {
+    }
+
+    bool begin_file(const std::string& relative_path, const struct stat& st) override
+    {
+        _relative_path = relative_path;
+        _stat = st;
+        return _checksum.begin();
+    }
+
+    bool file_data(const void* data, size_t size) override
+    {
+        return _checksum.update(data, size);
+    }
+
+    bool end_file() override
+    {
+        std::vector<std::string> digests;
+        if (!_checksum.finish(digests)) {
+            return false;
+        }
+        _entries[_relative_path] = stat_cache_make_entry(_stat, _algorithms, digests);
+        _primary[_relative_path] = digests.front();
+        return true;
+    }
+
+    // stat tuple and every digest of each file, keyed by path relative to the component
+    const StatCache& entries() const
+    {
+        return _entries;
+    }
+
+    // primary digest of each file, keyed by path relative to the component
+    const std::unordered_map<std::string, std::string>& primary_digests() const
+    {
+        return _primary;
+    }
+
+private:
+    std::vector<std::string> _algorithms;
+    MultiChecksum _checksum;
+    std::string _relative_path;
+    struct stat _stat;
+    StatCache _entries;
+    std::unordered_map<std::string, std::string> _primary;
+};
+
+/**
+ * @brief How the seal graph turns a component into an archive
+ */
+struct ComponentSealer {
+    /// Compresses a component, feeding tee if it is set; an already sealed component is accepted as it is
+    std::function<bool(const std::string& component, const ArchiveTee* tee)> compress;
+    /// Puts the compressed component in its final place once its metadata is written
+    std::function<bool(const std::string& component)> place;
+};
+
+// Refreshes the stage metadata exactly once and seals the components
+// concurrently.  Each component is compressed while the files being
+// archived are hashed, the metadata derived from it is generated from those
+// digests and the same walk of the directory into one metadata transaction,
+// written in one pass with the package digest, and only then do the
+// archives take the directories' places:
+//
+//   compress contents -> contents manifest -+
+//                                            package digest, write metadata -> place contents, place hooks
+//   compress hooks    -> hooks digest ------+
+//   (both places) -> compress metadata -> place metadata
+//   compress signatures -> place signatures
+//
+// A component that is already sealed keeps the metadata recorded when it was sealed.
+static bool run_component_seal_graph( const std::string& stage_dir, const ComponentSealer& sealer )
+{
+    std::filesystem::path stage_path(stage_dir);
+    bool contents_open = std::filesystem::is_directory(stage_path / "contents");
+    bool hooks_open = std::filesystem::is_directory(stage_path / "hooks");
+    bool metadata_open = std::filesystem::is_directory(stage_path / "metadata");
+
+    // the digests of contents and hooks live in metadata, so metadata has to be sealed last
+    if (!metadata_open && (contents_open || hooks_open)) {
+        dpm_con(LOG_ERROR, "Metadata is already sealed but contents or hooks are not.  Unseal the stage components first.");
+        return false;
+    }
+
+    dpm_con(LOG_INFO, "Refreshing metadata and sealing components...");
+    TaskGraph graph;
+    std::vector<size_t> component_digests;
+
+    // the refreshed digests are shared in memory and written together before any component is placed
+    MetadataTransaction transaction(stage_path);
+
+    ArchiveDigestRecorder contents_recorder(get_configured_hash_algorithms());
+    TreeWalk contents_walk;
+    ArchiveTee contents_tee = { nullptr, &contents_recorder, &contents_walk };
+    size_t contents_compress = graph.add("contents compression", [&] {
+        if (!contents_open) {
+            return sealer.compress("contents", nullptr);
+        }
+
+        // one walk of the contents serves both the archive and the manifest refresh
+        return tree_walk(stage_path / "contents", contents_walk, tree_walk_worker_count()) &&
+               sealer.compress("contents", &contents_tee);
+    });
+    std::vector<size_t> contents_place_dependencies = { contents_compress };
+    if (contents_open) {
+        size_t manifest = graph.add("contents manifest refresh", [&] {
+            return metadata_refresh_contents_manifest_digest(transaction, false, false, &contents_recorder.entries(),
+                                                             &contents_walk) == 0;
+        }, { contents_compress });
+        contents_place_dependencies.push_back(manifest);
+        component_digests.push_back(manifest);
+    }
+
+    ArchiveDigestRecorder hooks_recorder({ get_configured_hash_algorithm() });
+    ArchiveTee hooks_tee = { nullptr, &hooks_recorder, nullptr };
+    size_t hooks_compress = graph.add("hooks compression", [&] {
+        return sealer.compress("hooks", hooks_open ? &hooks_tee : nullptr);
+    });
+    std::vector<size_t> hooks_place_dependencies = { hooks_compress };
+    if (hooks_open) {
+        size_t hooks_digest = graph.add("hooks digest", [&] {
+            return metadata_generate_hooks_digest(transaction, &hooks_recorder.primary_digests());
+        }, { hooks_compress });
+        hooks_place_dependencies.push_back(hooks_digest);
+        component_digests.push_back(hooks_digest);
+    }
+
+    // a component only takes its directory's place once the metadata describing it is written
+    if (metadata_open) {
+        size_t package_digest = graph.add("package digest", [&] {
+            return metadata_generate_package_digest(transaction) && transaction.commit();
+        }, component_digests);
+        contents_place_dependencies.push_back(package_digest);
+        hooks_place_dependencies.push_back(package_digest);
+    }
+    size_t contents_place = graph.add("contents seal", [&] {
+        return sealer.place("contents");
+    }, contents_place_dependencies);
+    size_t hooks_place = graph.add("hooks seal", [&] {
+        return sealer.place("hooks");
+    }, hooks_place_dependencies);
+
+    // metadata is also held back until the other components are sealed, so a
+    // failure never leaves sealed metadata next to an unsealed component
+    std::vector<size_t> metadata_dependencies = { contents_place, hooks_place };
+    size_t metadata_compress = graph.add("metadata compression", [&] {
+        return sealer.compress("metadata", nullptr);
+    }, metadata_dependencies);
+    graph.add("metadata seal", [&] { return sealer.place("metadata"); }, { metadata_compress });
+
+    // Handle signatures component - an empty directory is left as it is
+    if (std::filesystem::is_directory(stage_path / "signatures")) {
+        if (std::filesystem::is_empty(stage_path / "signatures")) {
+            dpm_con(LOG_INFO, "Signatures directory is empty, not compressing.");
+        } else {
+            dpm_con(LOG_INFO, "Compressing signatures component.");
+            size_t signatures_compress = graph.add("signatures compression", [&] {
+                return sealer.compress("signatures", nullptr);
+            });
+            graph.add("signatures seal", [&] { return sealer.place("signatures"); }, { signatures_compress });
+        }
+    }
+
+    // one worker for each component, the compressors use their own threads on top
+    return graph.run(4);
+}
 
 extern "C" int seal_stage_components(const std::string& stage_dir, bool force)
 {
     dpm_con(LOG_INFO, ("Sealing package stage: " + stage_dir).c_str());
 
-    // First refresh the metadata to ensure it's up-to-date
-    dpm_con(LOG_INFO, "Refreshing metadata before sealing...");
-    bool metadata_refresh_result = metadata_refresh_dynamic_files(stage_dir);
-    if (!metadata_refresh_result) {
-        dpm_con(LOG_ERROR, "Failed to refresh metadata files before sealing. Aborting.");
+    std::filesystem::path stage_path(stage_dir);
+    ComponentSealer sealer = {
+        [&](const std::string& component, const ArchiveTee* tee) {
+            return compress_component_archive(stage_path, component, tee);
+        },
+        [&](const std::string& component) {
+            return place_component_archive(stage_path, component);
+        }
+    };
+    bool sealed = run_component_seal_graph(stage_dir, sealer);
+    if (!sealed) {
+        dpm_con(LOG_FATAL, ("Failed to seal package stage: " + stage_dir).c_str());
         return 1;
     }
 
-    // Verify the stage directory structure
-    std::filesystem::path stage_path(stage_dir);
+    dpm_con(LOG_INFO, "Package stage sealed successfully.");
+    return 0;
+}
 
-    if (!smart_compress_component(stage_dir, "contents")) {
-        dpm_con(LOG_FATAL, ("Failed to compress contents: " + stage_dir).c_str());
-        return 1;
+// path of the final package for a stage, next to the stage unless output_dir is given
+static std::filesystem::path final_package_path( const std::filesystem::path& stage_path, const std::string& output_dir )
+{
+    if ( output_dir.empty() ) {
+        // the user didn't supply an output directory, so put the dpm next to the stage
+        return stage_path.string() + ".dpm";
     }
 
-    if (!smart_compress_component(stage_dir, "hooks")) {
-        dpm_con(LOG_FATAL, ("Failed to compress hooks: " + stage_dir).c_str());
-        return 1;
+    // the user supplied an output directory so call it stage_name.dpm and prefix the path
+    // with the output dir
+    std::string stage_basename = stage_path.filename().string();
+    return std::filesystem::path(output_dir) / std::filesystem::path(stage_basename + ".dpm");
+}
+
+/**
+ * @brief A component of a streaming seal, compressed but not yet in the package
+ */
+struct StreamedComponent {
+    std::string name;                       ///< Component name, e.g. "contents"
+    std::unique_ptr<SpillBuffer> data;      ///< Compressed component, or NULL if it was already sealed
+    std::string digest;                     ///< Digest of the compressed component
+    CompressionCodec codec;                 ///< Codec the component is compressed with
+};
+
+// compresses one component of a stage into a spill buffer, hashing the compressed stream as it is produced
+static bool stream_seal_component( const std::filesystem::path& stage_path, const std::filesystem::path& spill_dir,
+                                   StreamedComponent& component, const ArchiveTee* tee )
+{
+    std::filesystem::path component_path = stage_path / component.name;
+
+    // a component sealed earlier is copied into the package as it is
+    if ( !std::filesystem::is_directory( component_path ) ) {
+        if ( !file_already_compressed( component_path.string() ) ) {
+            dpm_log( LOG_ERROR, ("Component is not a directory and not a compressed archive: " + component_path.string()).c_str() );
+            return false;
+        }
+        dpm_log( LOG_INFO, (component_path.string() + " is already sealed, adding it as it is.").c_str() );
+        component.digest = generate_file_checksum( component_path );
+        component.codec = compression_detect_file( component_path.string() );
+        return !component.digest.empty();
     }
 
-    if (!smart_compress_component(stage_dir, "metadata")) {
-        dpm_con(LOG_FATAL, ("Failed to compress metadata: " + stage_dir).c_str());
-        return 1;
+    MultiChecksum checksum( { get_configured_hash_algorithm() } );
+    if ( !checksum.valid() || !checksum.begin() ) {
+        dpm_log( LOG_ERROR, "Failed to initialize component digest" );
+        return false;
     }
 
-    // Handle signatures component - check if it's an empty directory
-    if (std::filesystem::is_directory(stage_path / "signatures")) {
-        bool signatures_empty = true;
+    component.data = std::make_unique<SpillBuffer>( spill_dir, spill_buffer_memory_limit() );
+    SpillBuffer& buffer = *component.data;
+    ArchiveOutputSink sink = [&]( const void* data, size_t size ) {
+        return checksum.update( data, size ) && buffer.write( data, size );
+    };
+
+    CompressionSettings compression = compression_for_component( component.name );
+    component.codec = compression.codec;
+    dpm_log( LOG_INFO, ("Compressing component " + component.name + " (" +
+                        compression_codec_name(compression.codec) + ") into the package stream").c_str() );
+    if ( !compress_directory_to_sink( component_path.string(), compression, sink, tee ) ) {
+        dpm_log( LOG_ERROR, ("Failed to compress component directory: " + component_path.string()).c_str() );
+        return false;
+    }
+
+    std::vector<std::string> digests;
+    if ( !checksum.finish( digests ) || digests.empty() ) {
+        dpm_log( LOG_ERROR, ("Failed to finish digest of component: " + component.name).c_str() );
+        return false;
+    }
+    component.digest = digests[0];
+    return true;
+}
 
-        // Check if signatures directory is empty
-        for (const auto& entry : std::filesystem::directory_iterator(stage_path / "signatures")) {
-            signatures_empty = false;
+// writes one finished component as a member of the outer package tar
+static bool stream_write_component( struct archive* package, const std::filesystem::path& stage_path,
+                                    const std::string& stage_name, StreamedComponent& component,
+                                    la_int64_t& data_offset )
+{
+    std::string member_name = stage_name + "/" + component.name;
+    std::filesystem::path sealed_path = stage_path / component.name;
+
+    struct archive_entry* entry = archive_entry_new();
+    archive_entry_set_pathname( entry, member_name.c_str() );
+
+    if ( !component.data ) {
+        // already sealed on disk: take the metadata from the file, as compress_directory does
+        struct stat st;
+        if ( stat( sealed_path.c_str(), &st ) != 0 ) {
+            dpm_log( LOG_ERROR, ("Failed to stat component: " + sealed_path.string()).c_str() );
+            archive_entry_free( entry );
+            return false;
+        }
+        archive_entry_copy_stat( entry, &st );
+    } else {
+        archive_entry_set_filetype( entry, AE_IFREG );
+        archive_entry_set_perm( entry, 0644 );
+        archive_entry_set_size( entry, static_cast<la_int64_t>(component.data->size()) );
+        archive_entry_set_mtime( entry, time(NULL), 0 );
+        archive_entry_set_uid( entry, getuid() );
+        archive_entry_set_gid( entry, getgid() );
+    }
+
+    int header_result = archive_write_header( package, entry );
+    archive_entry_free( entry );
+    if ( header_result != ARCHIVE_OK ) {
+        dpm_log( LOG_ERROR, ("Failed to add component to package: " + component.name + ": " +
+                             std::string(archive_error_string(package))).c_str() );
+        return false;
+    }
+    data_offset = archive_filter_bytes( package, 0 );
+
+    auto write_member = [&]( const void* data, size_t size ) {
+        return archive_write_data( package, data, size ) == static_cast<la_ssize_t>(size);
+    };
+
+    bool written;
+    if ( component.data ) {
+        written = component.data->replay( write_member );
+    } else {
+        std::ifstream file( sealed_path, std::ios::binary );
+        std::vector<char> buffer( 1024 * 1024 );
+        written = file.is_open();
+        while ( written && file ) {
+            file.read( buffer.data(), static_cast<std::streamsize>(buffer.size()) );
+            if ( file.gcount() > 0 ) {
+                written = write_member( buffer.data(), static_cast<size_t>(file.gcount()) );
+            }
+        }
+        written = written && !file.bad();
+    }
+
+    if ( !written ) {
+        dpm_log( LOG_ERROR, ("Failed to write component into package: " + component.name).c_str() );
+        return false;
+    }
+
+    dpm_log( LOG_INFO, ("Added " + component.name + " to package (" + get_configured_hash_algorithm() + " " +
+                        component.digest + ")").c_str() );
+    return true;
+}
+
+// writes the index placeholder, or the real index once the offsets are filled in
+static bool write_package_index( struct archive* package, const std::string& stage_name,
+                                 const std::string& index, la_int64_t& data_offset )
+{
+    struct archive_entry* entry = archive_entry_new();
+    archive_entry_set_pathname( entry, (stage_name + "/" + PACKAGE_INDEX_MEMBER).c_str() );
+    archive_entry_set_filetype( entry, AE_IFREG );
+    archive_entry_set_perm( entry, 0644 );
+    archive_entry_set_size( entry, static_cast<la_int64_t>(index.size()) );
+    archive_entry_set_mtime( entry, time(NULL), 0 );
+    archive_entry_set_uid( entry, getuid() );
+    archive_entry_set_gid( entry, getgid() );
+
+    bool written = archive_write_header( package, entry ) == ARCHIVE_OK;
+    archive_entry_free( entry );
+
+    // with no compression filter the bytes given to the archive so far are the position in the file
+    data_offset = archive_filter_bytes( package, 0 );
+    return written && archive_write_data( package, index.data(), index.size() ) == static_cast<la_ssize_t>(index.size());
+}
+
+// writes the outer package tar of a sealed stage: the stage directory, an
+// index of the components, then the components themselves, through a
+// temporary file that only takes the place of output_path once complete
+static bool write_package_archive( const std::filesystem::path& stage_path, const std::filesystem::path& output_path,
+                                   std::vector<StreamedComponent>& components )
+{
+    std::string stage_name = stage_path.filename().string();
+
+    // everything in the index but the offsets is known before writing
+    std::vector<PackageIndexEntry> index_entries;
+    for ( const auto& component : components ) {
+        std::filesystem::path component_path = stage_path / component.name;
+        if ( !component.data && !std::filesystem::is_regular_file( component_path ) ) {
+            continue;
+        }
+        uint64_t size = component.data ? component.data->size() : std::filesystem::file_size( component_path );
+        index_entries.push_back( { component.name, 0, size, compression_codec_name( component.codec ),
+                                   get_configured_hash_algorithm(), component.digest } );
+    }
+
+    // the components are already compressed, so the outer tar is left uncompressed;
+    // this lets readers mmap the package and use the component members in place
+    dpm_log( LOG_INFO, "Sealing DPM Package." );
+    std::filesystem::path temp_path = output_path.string() + ".tmp";
+    struct archive* package = archive_write_new();
+    archive_write_add_filter_none( package );
+    archive_write_set_format_pax_restricted( package );
+    if ( archive_write_open_filename( package, temp_path.c_str() ) != ARCHIVE_OK ) {
+        dpm_log( LOG_FATAL, ("Failed to create archive: " + temp_path.string()).c_str() );
+        archive_write_free( package );
+        return false;
+    }
+
+    // same layout as compress_directory: the stage directory, then its components
+    struct archive_entry* entry = archive_entry_new();
+    archive_entry_set_pathname( entry, stage_name.c_str() );
+    archive_entry_set_filetype( entry, AE_IFDIR );
+    archive_entry_set_perm( entry, 0755 );
+    bool success = archive_write_header( package, entry ) == ARCHIVE_OK;
+    archive_entry_free( entry );
+
+    la_int64_t index_offset = 0;
+    success = success && write_package_index( package, stage_name, package_index_format( index_entries ), index_offset );
+
+    for ( auto& component : components ) {
+        if ( !success ) {
             break;
         }
 
-        if (signatures_empty) {
-            dpm_con(LOG_INFO, "Signatures directory is empty, not compressing.");
-        } else {
-            dpm_con(LOG_INFO, "Compressing signatures component.");
-            if (!smart_compress_component(stage_dir, "signatures")) {
-                dpm_con(LOG_FATAL, ("Failed to compress signatures: " + stage_dir).c_str());
-                return 1;
+        std::filesystem::path component_path = stage_path / component.name;
+        if ( component.data || std::filesystem::is_regular_file( component_path ) ) {
+            la_int64_t data_offset = 0;
+            success = stream_write_component( package, stage_path, stage_name, component, data_offset );
+            for ( auto& indexed : index_entries ) {
+                if ( indexed.component == component.name ) {
+                    indexed.offset = static_cast<uint64_t>(data_offset);
+                }
             }
+        } else if ( std::filesystem::is_directory( component_path ) ) {
+            // an empty signatures directory stays a directory
+            entry = archive_entry_new();
+            archive_entry_set_pathname( entry, (stage_name + "/" + component.name).c_str() );
+            archive_entry_set_filetype( entry, AE_IFDIR );
+            archive_entry_set_perm( entry, 0755 );
+            success = archive_write_header( package, entry ) == ARCHIVE_OK;
+            archive_entry_free( entry );
         }
     }
 
-    dpm_con(LOG_INFO, "Package stage sealed successfully.");
-    return 0;
+    if ( archive_write_close( package ) != ARCHIVE_OK ) {
+        success = false;
+    }
+    archive_write_free( package );
+
+    // fill the offsets into the index, which keeps its length
+    if ( success ) {
+        std::string index = package_index_format( index_entries );
+        int fd = open( temp_path.c_str(), O_WRONLY | O_CLOEXEC );
+        success = fd >= 0 && pwrite( fd, index.data(), index.size(), index_offset ) == static_cast<ssize_t>(index.size());
+        if ( fd >= 0 && close( fd ) != 0 ) {
+            success = false;
+        }
+        if ( !success ) {
+            dpm_log( LOG_FATAL, ("Failed to write the package index: " + temp_path.string()).c_str() );
+        }
+    }
+
+    if ( !success ) {
+        dpm_log( LOG_FATAL, "Could not create DPM package from stage." );
+        std::filesystem::remove( temp_path );
+        return false;
+    }
+
+    std::error_code rename_error;
+    std::filesystem::rename( temp_path, output_path, rename_error );
+    if ( rename_error ) {
+        dpm_log( LOG_FATAL, ("Error placing package: " + rename_error.message()).c_str() );
+        std::filesystem::remove( temp_path );
+        return false;
+    }
+    return true;
+}
+
+// an unchanged stage already sealed into an unchanged package has nothing to do, unless forced
+static bool final_package_up_to_date( const std::filesystem::path& stage_path, const std::filesystem::path& output_path,
+                                      const std::string& seal_kind, bool force )
+{
+    if ( force || !seal_fingerprint_unchanged( stage_path, output_path, seal_kind ) ) {
+        return false;
+    }
+    dpm_con( LOG_INFO, ("Stage is unchanged since " + output_path.string() +
+                        " was sealed, nothing to do.  Use --force to seal it again.").c_str() );
+    return true;
 }
 
 extern "C" int seal_final_package(const std::string &stage_dir, const std::string &output_dir, bool force)
 {
+    std::filesystem::path stage_path = std::filesystem::path( stage_dir ).lexically_normal();
+    if ( stage_path.filename().empty() ) {
+        stage_path = stage_path.parent_path();
+    }
+    std::filesystem::path output_path = final_package_path( stage_path, output_dir );
+
+    if ( std::filesystem::is_directory( stage_path ) && final_package_up_to_date( stage_path, output_path, "final", force ) ) {
+        return 0;
+    }
+
     int stage_seal_result = seal_stage_components( stage_dir, force );
     if ( stage_seal_result != 0 ) {
         dpm_log( LOG_FATAL, "Component sealing stage failed.  Exiting." );
         return 1;
     }
 
-    std::filesystem::path stage_path( stage_dir );
+    if ( ! std::filesystem::is_directory( stage_path ) ) {
+        dpm_log( LOG_FATAL, "Stage is not a directory.  Refusing to continue.");
+        return 1;
+    }
+
+    // the sealed components are taken from the stage as they are, their digests go into the index
+    std::vector<StreamedComponent> components;
+    for ( const char* name : { "contents", "hooks", "metadata", "signatures" } ) {
+        StreamedComponent component = { name, nullptr, "", CompressionCodec::UNKNOWN };
+        std::filesystem::path component_path = stage_path / name;
+        if ( std::filesystem::is_regular_file( component_path ) ) {
+            component.digest = generate_file_checksum( component_path );
+            component.codec = compression_detect_file( component_path.string() );
+            if ( component.digest.empty() ) {
+                dpm_log( LOG_FATAL, ("Failed to digest component: " + component_path.string()).c_str() );
+                return 1;
+            }
+        }
+        components.push_back( std::move(component) );
+    }
+
+    if ( !write_package_archive( stage_path, output_path, components ) ) {
+        return 1;
+    }
+    seal_fingerprint_store( stage_path, output_path, "final" );
+    dpm_log( LOG_INFO, ("Package written to: " + output_path.string() ).c_str() );
+    return 0;
+}
+
+extern "C" int seal_final_package_streaming(const std::string& stage_dir, const std::string& output_dir, bool force)
+{
+    std::filesystem::path stage_path = std::filesystem::path( stage_dir ).lexically_normal();
+    if ( stage_path.filename().empty() ) {
+        stage_path = stage_path.parent_path();
+    }
 
     if ( ! std::filesystem::is_directory( stage_path ) ) {
         dpm_log( LOG_FATAL, "Stage is not a directory.  Refusing to continue.");
         return 1;
     }
 
-    std::filesystem::path output_path;
-    if ( output_dir.empty() ) {
-        // the user didn't supply an output directory, so put the dpm next to the stage
-        output_path = stage_path.string() + ".dpm";
-    } else {
-        // the user supplied an output directory so call it stage_name.dpm and prefix the path
-        // with the output dir
-        std::string stage_basename = stage_path.filename().string();
+    std::filesystem::path output_path = final_package_path( stage_path, output_dir );
+    std::filesystem::path spill_dir = output_path.parent_path().empty() ? "." : output_path.parent_path();
 
-        // it's here
-        output_path = std::filesystem::path(output_dir) / std::filesystem::path(stage_basename + ".dpm");
+    if ( final_package_up_to_date( stage_path, output_path, "stream", force ) ) {
+        return 0;
     }
 
-    dpm_log( LOG_INFO, "Sealing DPM Package." );
-    bool result = compress_directory( stage_path.string(), output_path.string() );
-    if ( ! result ) {
-        dpm_log( LOG_FATAL, "Could not create DPM package from stage." );
+    dpm_con(LOG_INFO, ("Streaming seal of package stage: " + stage_path.string()).c_str());
+
+    // every component is compressed straight into its own buffer, never into the stage
+    std::vector<StreamedComponent> components;
+    for ( const char* name : { "contents", "hooks", "metadata", "signatures" } ) {
+        components.push_back( { name, nullptr, "", CompressionCodec::UNKNOWN } );
+    }
+
+    // the archives go into the package, never into the stage
+    ComponentSealer sealer = {
+        [&](const std::string& name, const ArchiveTee* tee) {
+            for ( auto& component : components ) {
+                if ( component.name == name ) {
+                    return stream_seal_component( stage_path, spill_dir, component, tee );
+                }
+            }
+            return false;
+        },
+        [](const std::string&) {
+            return true;
+        }
+    };
+    bool sealed = run_component_seal_graph( stage_path.string(), sealer );
+    if ( !sealed ) {
+        dpm_log( LOG_FATAL, "Component sealing stage failed.  Exiting." );
         return 1;
     }
+
+    if ( !write_package_archive( stage_path, output_path, components ) ) {
+        return 1;
+    }
+    seal_fingerprint_store( stage_path, output_path, "stream" );
+
     dpm_log( LOG_INFO, ("Package written to: " + output_path.string() ).c_str() );
     return 0;
 }
@@ -594,6 +1401,10 @@ extern "C" int unseal_package(const std::string& package_filepath, const std::st
         return 1;
     }
 
+    // the index only describes the package file, sealing the stage again writes a new one
+    std::error_code index_error;
+    std::filesystem::remove(output_directory / PACKAGE_INDEX_MEMBER, index_error);
+
     dpm_log(LOG_INFO, ("Package unsealed successfully to: " + output_directory.string()).c_str());
     return 0;
 }
@@ -690,12 +1501,19 @@ extern "C" int unseal_stage_components(const std::filesystem::path& stage_dir)
         return 1;
     }
 
-    // Uncompress each component in order
+    // Uncompress the components concurrently, they are independent of each other
+    TaskGraph graph;
     for (const auto& component : components) {
-        if (!smart_uncompress_component(stage_dir, component)) {
-            dpm_log(LOG_FATAL, ("Failed to uncompress component: " + component.string()).c_str());
-            return 1;
-        }
+        graph.add(component.string() + " extraction", [&stage_dir, component] {
+            if (!smart_uncompress_component(stage_dir, component)) {
+                dpm_log(LOG_FATAL, ("Failed to uncompress component: " + component.string()).c_str());
+                return false;
+            }
+            return true;
+        });
+    }
+    if (!graph.run(components.size())) {
+        return 1;
     }
 
     dpm_log(LOG_INFO, "Package components unsealed successfully");
@@ -1,132 +1,243 @@
 #include "signing.hpp"
 
+// GPGME must be initialised once, before any context is created on any thread
+static std::once_flag g_gpgme_init_flag;
+static bool g_gpgme_ready = false;
+static std::string g_gpgme_home;
+
 /**
- * @brief Signs a component archive using GPGME
- *
- * Creates a detached GPG signature for a component archive
+ * @brief Initialises GPGME and resolves the keyring location for this process
  *
- * @param stage_path Path to the stage directory
- * @param key_id GPG key ID or email to use for signing
- * @param component_name Name of the component to sign (contents, hooks, metadata)
- * @return 0 on success, non-zero on failure
+ * The keyring is the GnuPG home directory named by [cryptography] gpg_home,
+ * or the GnuPG default when that key is not set.
  */
-static int sign_component(const std::filesystem::path& stage_path, const std::string& key_id,
-                          const std::string& component_name) {
-    dpm_log(LOG_INFO, ("Signing " + component_name + " component...").c_str());
-
-    std::filesystem::path component_path = stage_path / component_name;
-    std::filesystem::path signature_path = stage_path / "signatures" / (component_name + ".signature");
+static void gpgme_initialize_once()
+{
+    if (gpgme_check_version(NULL) == NULL) {
+        dpm_log(LOG_ERROR, "Failed to initialize GPGME library");
+        return;
+    }
 
-    // Initialize GPGME
-    gpgme_ctx_t ctx;
-    gpgme_error_t err;
+    gpgme_error_t err = gpgme_engine_check_version(GPGME_PROTOCOL_OpenPGP);
+    if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
+        dpm_log(LOG_ERROR, ("OpenPGP engine is not available: " + std::string(gpgme_strerror(err))).c_str());
+        return;
+    }
 
-    // Initialize GPGME library
-    const char* version = gpgme_check_version(NULL);
-    if (version == NULL) {
-        dpm_log(LOG_ERROR, "Failed to initialize GPGME library");
-        return 1;
+    const char* gpg_home = dpm_get_config("cryptography", "gpg_home");
+    if (gpg_home && strlen(gpg_home) > 0) {
+        g_gpgme_home = gpg_home;
+        DPM_LOG(LOG_DEBUG, "Using GnuPG home directory: ", g_gpgme_home);
     }
 
-    // Create a new GPGME context
-    err = gpgme_new(&ctx);
+    g_gpgme_ready = true;
+}
+
+// creates an OpenPGP context on the configured keyring; a context must only be used by one thread
+static bool gpgme_new_context(gpgme_ctx_t& ctx)
+{
+    gpgme_error_t err = gpgme_new(&ctx);
     if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
         dpm_log(LOG_ERROR, "Failed to create GPGME context");
-        return 1;
+        return false;
     }
 
-    // Set protocol to OpenPGP
     err = gpgme_set_protocol(ctx, GPGME_PROTOCOL_OpenPGP);
     if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
         dpm_log(LOG_ERROR, "Failed to set GPGME protocol");
         gpgme_release(ctx);
-        return 1;
+        return false;
     }
 
-    // Set armor mode (for ASCII-armored output)
-    gpgme_set_armor(ctx, 1);
+    if (!g_gpgme_home.empty()) {
+        err = gpgme_ctx_set_engine_info(ctx, GPGME_PROTOCOL_OpenPGP, NULL, g_gpgme_home.c_str());
+        if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
+            dpm_log(LOG_ERROR, ("Failed to select GnuPG home directory: " + g_gpgme_home).c_str());
+            gpgme_release(ctx);
+            return false;
+        }
+    }
 
-    // Set signing key
-    gpgme_key_t key;
-    err = gpgme_get_key(ctx, key_id.c_str(), &key, 1);
-    if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
+    return true;
+}
+
+SigningSession::SigningSession() : _key(nullptr)
+{
+}
+
+SigningSession::~SigningSession()
+{
+    if (_key) {
+        gpgme_key_unref(_key);
+    }
+}
+
+bool signing_preload()
+{
+    std::call_once(g_gpgme_init_flag, gpgme_initialize_once);
+    return g_gpgme_ready;
+}
+
+bool SigningSession::open(const std::string& key_id)
+{
+    std::call_once(g_gpgme_init_flag, gpgme_initialize_once);
+    if (!g_gpgme_ready) {
+        return false;
+    }
+
+    gpgme_ctx_t ctx;
+    if (!gpgme_new_context(ctx)) {
+        return false;
+    }
+
+    // the only key lookup of the session, which may go through gpg-agent or a smartcard
+    gpgme_key_t key = nullptr;
+    gpgme_error_t err = gpgme_get_key(ctx, key_id.c_str(), &key, 1);
+    gpgme_release(ctx);
+    if (gpgme_err_code(err) != GPG_ERR_NO_ERROR || !key) {
         dpm_log(LOG_ERROR, ("Failed to find signing key: " + key_id).c_str());
-        gpgme_release(ctx);
-        return 1;
+        return false;
     }
 
-    // Add the key to the context
-    gpgme_signers_clear(ctx);
-    err = gpgme_signers_add(ctx, key);
-    gpgme_key_unref(key);
+    if (_key) {
+        gpgme_key_unref(_key);
+    }
+    _key = key;
+    _key_id = key_id;
+    return true;
+}
 
-    if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
-        dpm_log(LOG_ERROR, "Failed to add signing key to context");
-        gpgme_release(ctx);
-        return 1;
+bool SigningSession::sign_buffer(const unsigned char* data, size_t size, std::string& signature)
+{
+    DpmProfileScope profile("sign_component");
+    profile.add_bytes(size);
+    profile.add_files(1);
+
+    signature.clear();
+    if (!_key) {
+        dpm_log(LOG_ERROR, "Signing session has no key");
+        return false;
     }
 
-    // Open the component file
-    FILE* component_file = fopen(component_path.string().c_str(), "rb");
-    if (!component_file) {
-        dpm_log(LOG_ERROR, ("Failed to open component file: " + component_path.string()).c_str());
-        gpgme_release(ctx);
-        return 1;
+    gpgme_ctx_t ctx;
+    if (!gpgme_new_context(ctx)) {
+        return false;
     }
 
-    // Open the signature file
-    FILE* signature_file = fopen(signature_path.string().c_str(), "wb");
-    if (!signature_file) {
-        dpm_log(LOG_ERROR, ("Failed to create signature file: " + signature_path.string()).c_str());
-        fclose(component_file);
+    // Set armor mode (for ASCII-armored output)
+    gpgme_set_armor(ctx, 1);
+
+    // the context takes its own reference to the key resolved by open
+    gpgme_signers_clear(ctx);
+    gpgme_error_t err = gpgme_signers_add(ctx, _key);
+    if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
+        dpm_log(LOG_ERROR, "Failed to add signing key to context");
         gpgme_release(ctx);
-        return 1;
+        return false;
     }
 
-    // Create data objects for input and output
+    // the data is signed in place, without a copy
     gpgme_data_t in_data, out_data;
-    err = gpgme_data_new_from_stream(&in_data, component_file);
+    err = gpgme_data_new_from_mem(&in_data, reinterpret_cast<const char*>(data), size, 0);
     if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
         dpm_log(LOG_ERROR, "Failed to create input data object");
-        fclose(component_file);
-        fclose(signature_file);
         gpgme_release(ctx);
-        return 1;
+        return false;
     }
 
-    err = gpgme_data_new_from_stream(&out_data, signature_file);
+    err = gpgme_data_new(&out_data);
     if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
         dpm_log(LOG_ERROR, "Failed to create output data object");
         gpgme_data_release(in_data);
-        fclose(component_file);
-        fclose(signature_file);
         gpgme_release(ctx);
-        return 1;
+        return false;
     }
 
     // Sign the data
     err = gpgme_op_sign(ctx, in_data, out_data, GPGME_SIG_MODE_DETACH);
+    gpgme_data_release(in_data);
     if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
-        dpm_log(LOG_ERROR, ("Failed to sign component: " + std::string(gpgme_strerror(err))).c_str());
-        gpgme_data_release(in_data);
+        dpm_log(LOG_ERROR, ("Failed to sign data with key " + _key_id + ": " + std::string(gpgme_strerror(err))).c_str());
         gpgme_data_release(out_data);
-        fclose(component_file);
-        fclose(signature_file);
         gpgme_release(ctx);
-        return 1;
+        return false;
     }
 
-    // Clean up
-    gpgme_data_release(in_data);
-    gpgme_data_release(out_data);
-    fclose(component_file);
-    fclose(signature_file);
+    size_t signature_size = 0;
+    char* signature_data = gpgme_data_release_and_get_mem(out_data, &signature_size);
     gpgme_release(ctx);
+    if (!signature_data || signature_size == 0) {
+        dpm_log(LOG_ERROR, "Signing produced no signature");
+        gpgme_free(signature_data);
+        return false;
+    }
 
-    return 0;
+    signature.assign(signature_data, signature_size);
+    gpgme_free(signature_data);
+    return true;
+}
+
+bool SigningSession::sign_file(const std::filesystem::path& path, const std::filesystem::path& signature_path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to open component file: " + path.string()).c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        dpm_log(LOG_ERROR, ("Component is not a sealed archive: " + path.string()).c_str());
+        ::close(fd);
+        return false;
+    }
+
+    // the archive is mapped and handed to GPGME as it is, an empty one has nothing to map
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapped = nullptr;
+    if (size > 0) {
+        mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            dpm_log(LOG_ERROR, ("Failed to map component file: " + path.string() + ": " + strerror(errno)).c_str());
+            ::close(fd);
+            return false;
+        }
+        madvise(mapped, size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+
+    static const unsigned char empty = 0;
+    std::string signature;
+    bool signed_ok = sign_buffer(mapped ? static_cast<const unsigned char*>(mapped) : &empty, size, signature);
+    if (mapped) {
+        munmap(mapped, size);
+    }
+    if (!signed_ok) {
+        return false;
+    }
+
+    std::ofstream signature_file(signature_path, std::ios::binary | std::ios::trunc);
+    signature_file.write(signature.data(), static_cast<std::streamsize>(signature.size()));
+    signature_file.close();
+    if (!signature_file) {
+        dpm_log(LOG_ERROR, ("Failed to write signature file: " + signature_path.string()).c_str());
+        return false;
+    }
+
+    return true;
 }
 
 int sign_stage_directory(const std::string& stage_dir, const std::string& key_id, bool force) {
+    // GPGME is set up and the key looked up once for all the components
+    SigningSession session;
+    if (!session.open(key_id)) {
+        return 1;
+    }
+
+    return sign_stage_directory(stage_dir, session, force);
+}
+
+int sign_stage_directory(const std::string& stage_dir, SigningSession& session, bool force) {
     dpm_log(LOG_INFO, ("Signing package stage: " + stage_dir).c_str());
 
     // Verify the stage directory structure
@@ -163,26 +274,21 @@ int sign_stage_directory(const std::string& stage_dir, const std::string& key_id
         }
     }
 
-    // Sign each component
-    int result = 0;
-
-    // Sign contents
-    if (sign_component(stage_path, key_id, "contents") != 0) {
-        dpm_log(LOG_ERROR, "Failed to sign contents component");
-        result = 1;
-    }
-
-    // Sign hooks
-    if (sign_component(stage_path, key_id, "hooks") != 0) {
-        dpm_log(LOG_ERROR, "Failed to sign hooks component");
-        result = 1;
-    }
-
-    // Sign metadata
-    if (sign_component(stage_path, key_id, "metadata") != 0) {
-        dpm_log(LOG_ERROR, "Failed to sign metadata component");
-        result = 1;
+    // Sign each component concurrently, every signature in a context of its own
+    TaskGraph graph;
+    for (const char* component : { "contents", "hooks", "metadata" }) {
+        std::string component_name = component;
+        graph.add(component_name + " signature", [&session, stage_path, component_name] {
+            dpm_log(LOG_INFO, ("Signing " + component_name + " component...").c_str());
+            if (!session.sign_file(stage_path / component_name,
+                                   stage_path / "signatures" / (component_name + ".signature"))) {
+                dpm_log(LOG_ERROR, ("Failed to sign " + component_name + " component").c_str());
+                return false;
+            }
+            return true;
+        });
     }
+    int result = graph.run(3) ? 0 : 1;
 
     if (result == 0) {
         dpm_log(LOG_INFO, "Package stage signed successfully.");
@@ -192,6 +298,15 @@ int sign_stage_directory(const std::string& stage_dir, const std::string& key_id
 }
 
 int sign_package_file(const std::string& package_path, const std::string& key_id, bool force) {
+    SigningSession session;
+    if (!session.open(key_id)) {
+        return 1;
+    }
+
+    return sign_package_file(package_path, session, force);
+}
+
+int sign_package_file(const std::string& package_path, SigningSession& session, bool force) {
     dpm_log(LOG_INFO, ("Signing package file: " + package_path).c_str());
 
     // Get the temporary stage path by removing .dpm extension
@@ -217,7 +332,7 @@ int sign_package_file(const std::string& package_path, const std::string& key_id
 
     // 2. Sign the stage directory components
     dpm_log(LOG_INFO, "Signing package components...");
-    result = sign_stage_directory(tmp_stage_path, key_id, force);
+    result = sign_stage_directory(tmp_stage_path, session, force);
     if (result != 0) {
         dpm_log(LOG_ERROR, "Failed to sign package components");
         return result;
@@ -253,4 +368,90 @@ int sign_package_file(const std::string& package_path, const std::string& key_id
 
     dpm_log(LOG_INFO, ("Successfully signed package: " + package_path).c_str());
     return 0;
-}
\ No newline at end of file
+}
+
+extern "C" int verify_detached_signature_memory(const unsigned char* data, size_t data_size,
+                                                const unsigned char* signature, size_t signature_size,
+                                                char* signer_fpr, size_t signer_fpr_size)
+{
+    if (!data || !signature || signature_size == 0) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to verify_detached_signature_memory");
+        return 1;
+    }
+
+    if (signer_fpr && signer_fpr_size > 0) {
+        signer_fpr[0] = '\0';
+    }
+
+    std::call_once(g_gpgme_init_flag, gpgme_initialize_once);
+    if (!g_gpgme_ready) {
+        return 1;
+    }
+
+    // Contexts are not thread safe, so every verification gets its own
+    gpgme_ctx_t ctx;
+    if (!gpgme_new_context(ctx)) {
+        return 1;
+    }
+
+    // Wrap the caller's buffers without copying them
+    gpgme_data_t signed_data, signature_data;
+    gpgme_error_t err = gpgme_data_new_from_mem(&signed_data, reinterpret_cast<const char*>(data), data_size, 0);
+    if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
+        dpm_log(LOG_ERROR, "Failed to create signed data object");
+        gpgme_release(ctx);
+        return 1;
+    }
+
+    err = gpgme_data_new_from_mem(&signature_data, reinterpret_cast<const char*>(signature), signature_size, 0);
+    if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
+        dpm_log(LOG_ERROR, "Failed to create signature data object");
+        gpgme_data_release(signed_data);
+        gpgme_release(ctx);
+        return 1;
+    }
+
+    err = gpgme_op_verify(ctx, signature_data, signed_data, NULL);
+    if (gpgme_err_code(err) != GPG_ERR_NO_ERROR) {
+        dpm_log(LOG_ERROR, ("Signature verification failed: " + std::string(gpgme_strerror(err))).c_str());
+        gpgme_data_release(signed_data);
+        gpgme_data_release(signature_data);
+        gpgme_release(ctx);
+        return 1;
+    }
+
+    // Every signature present must be good and none may be revoked or expired
+    int result = 1;
+    gpgme_verify_result_t verify_result = gpgme_op_verify_result(ctx);
+    if (!verify_result || !verify_result->signatures) {
+        dpm_log(LOG_ERROR, "No signatures found in signature data");
+    } else {
+        result = 0;
+        for (gpgme_signature_t sig = verify_result->signatures; sig; sig = sig->next) {
+            std::string fpr = sig->fpr ? sig->fpr : "unknown key";
+
+            if (gpgme_err_code(sig->status) != GPG_ERR_NO_ERROR) {
+                dpm_log(LOG_ERROR, ("Bad signature from " + fpr + ": " + std::string(gpgme_strerror(sig->status))).c_str());
+                result = 1;
+            } else if (sig->summary & (GPGME_SIGSUM_RED | GPGME_SIGSUM_KEY_REVOKED |
+                                       GPGME_SIGSUM_KEY_EXPIRED | GPGME_SIGSUM_SIG_EXPIRED)) {
+                dpm_log(LOG_ERROR, ("Signature from " + fpr + " is revoked or expired").c_str());
+                result = 1;
+            } else {
+                DPM_LOG(LOG_DEBUG, "Good signature from ", fpr);
+            }
+
+            if (signer_fpr && signer_fpr_size > 0 && sig->fpr && signer_fpr[0] == '\0') {
+                strncpy(signer_fpr, sig->fpr, signer_fpr_size - 1);
+                signer_fpr[signer_fpr_size - 1] = '\0';
+            }
+        }
+    }
+
+    // Clean up
+    gpgme_data_release(signed_data);
+    gpgme_data_release(signature_data);
+    gpgme_release(ctx);
+
+    return result;
+}
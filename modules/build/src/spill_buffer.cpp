@@ -0,0 +1,137 @@
+/**
+ * @file spill_buffer.cpp
+ * @brief Implementation of the spilling byte buffer
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "spill_buffer.hpp"
+
+uint64_t spill_buffer_memory_limit()
+{
+    const char* configured = dpm_get_config("build", "stream_seal_memory");
+    if (configured && strlen(configured) > 0) {
+        char* end = nullptr;
+        unsigned long long value = strtoull(configured, &end, 10);
+        if (end != configured && *end == '\0') {
+            return static_cast<uint64_t>(value);
+        }
+        dpm_log(LOG_WARN, ("Ignoring invalid [build] stream_seal_memory value: " + std::string(configured)).c_str());
+    }
+    return SPILL_BUFFER_DEFAULT_MEMORY_LIMIT;
+}
+
+SpillBuffer::SpillBuffer(const std::filesystem::path& spill_dir, uint64_t memory_limit)
+    : _spill_dir(spill_dir), _memory_limit(memory_limit), _size(0), _fd(-1)
+{
+}
+
+SpillBuffer::~SpillBuffer()
+{
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+}
+
+bool SpillBuffer::spill()
+{
+    std::string pattern = (_spill_dir / ".dpm_seal_XXXXXX").string();
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+
+    _fd = mkstemp(name.data());
+    if (_fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to create temporary file in " + _spill_dir.string() + ": " + strerror(errno)).c_str());
+        return false;
+    }
+
+    // the open descriptor keeps the data alive, and nothing is left behind whatever happens next
+    unlink(name.data());
+
+    const unsigned char* bytes = _memory.data();
+    size_t remaining = _memory.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(_fd, bytes, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            dpm_log(LOG_ERROR, ("Failed to write temporary file: " + std::string(strerror(errno))).c_str());
+            return false;
+        }
+        bytes += written;
+        remaining -= static_cast<size_t>(written);
+    }
+
+    std::vector<unsigned char>().swap(_memory);
+    DPM_LOG(LOG_DEBUG, "Spilled ", _size, " buffered bytes to a temporary file");
+    return true;
+}
+
+bool SpillBuffer::write(const void* data, size_t size)
+{
+    if (_fd < 0 && _size + size > _memory_limit && !spill()) {
+        return false;
+    }
+
+    if (_fd < 0) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        _memory.insert(_memory.end(), bytes, bytes + size);
+        _size += size;
+        return true;
+    }
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    size_t remaining = size;
+    while (remaining > 0) {
+        ssize_t written = ::write(_fd, bytes, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            dpm_log(LOG_ERROR, ("Failed to write temporary file: " + std::string(strerror(errno))).c_str());
+            return false;
+        }
+        bytes += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    _size += size;
+    return true;
+}
+
+uint64_t SpillBuffer::size() const
+{
+    return _size;
+}
+
+bool SpillBuffer::replay(const std::function<bool(const void* data, size_t size)>& consume)
+{
+    if (_fd < 0) {
+        return _memory.empty() || consume(_memory.data(), _memory.size());
+    }
+
+    std::vector<unsigned char> buffer(1024 * 1024);
+    uint64_t offset = 0;
+    while (offset < _size) {
+        ssize_t got = pread(_fd, buffer.data(), buffer.size(), static_cast<off_t>(offset));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            dpm_log(LOG_ERROR, ("Failed to read temporary file: " + std::string(strerror(errno))).c_str());
+            return false;
+        }
+        if (got == 0) {
+            dpm_log(LOG_ERROR, "Temporary file is shorter than the data written to it");
+            return false;
+        }
+        if (!consume(buffer.data(), static_cast<size_t>(got))) {
+            return false;
+        }
+        offset += static_cast<uint64_t>(got);
+    }
+    return true;
+}
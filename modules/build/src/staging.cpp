@@ -96,64 +96,43 @@ static bool stage_build_stage_skeleton( const std::filesystem::path& package_dir
 }
 
 
-static bool stage_copy_dir( const std::filesystem::path& source_path, const std::filesystem::path& dest_path )
+static bool stage_copy_dir( const std::filesystem::path& source_path, const std::filesystem::path& dest_path,
+                            TreeCopyMode mode, const ContentStore* store = nullptr )
 {
-    try {
-        dpm_log(LOG_INFO, ("Copying from: " + source_path.string() +
-                 " to: " + dest_path.string()).c_str());
+    DpmProfileScope profile("stage_copy_dir");
 
-        // Check if source exists
-        if (!std::filesystem::exists(source_path)) {
-            dpm_log(LOG_ERROR, ("Source path does not exist: " + source_path.string()).c_str());
-            return false;
-        }
+    dpm_log(LOG_INFO, ("Copying from: " + source_path.string() +
+             " to: " + dest_path.string()).c_str());
 
-        // If the contents source is a directory, copy its contents
-        if (std::filesystem::is_directory(source_path)) {
-            for (const auto& entry : std::filesystem::directory_iterator(source_path)) {
-                // Get the relative path from the source directory
-                std::filesystem::path relative = entry.path().lexically_relative(source_path);
-                std::filesystem::path dest_path_item = dest_path / relative;
-
-                if (entry.is_directory()) {
-                    std::filesystem::create_directories(dest_path_item);
-                    // Copy the directory contents recursively
-                    for (const auto& subentry : std::filesystem::recursive_directory_iterator(entry)) {
-                        std::filesystem::path subrelative = subentry.path().lexically_relative(source_path);
-                        std::filesystem::path subdest_path = dest_path / subrelative;
-
-                        if (subentry.is_directory()) {
-                            std::filesystem::create_directories(subdest_path);
-                        } else {
-                            std::filesystem::copy_file(subentry.path(), subdest_path,
-                                                     std::filesystem::copy_options::overwrite_existing);
-                        }
-                    }
-                } else {
-                    std::filesystem::copy_file(entry.path(), dest_path_item,
-                                             std::filesystem::copy_options::overwrite_existing);
-                }
-            }
-        } else {
-            dpm_log(LOG_ERROR, ("Source is not a directory: " + source_path.string()).c_str());
-            return false;
-        }
+    // Check if source exists
+    if (!std::filesystem::exists(source_path)) {
+        dpm_log(LOG_ERROR, ("Source path does not exist: " + source_path.string()).c_str());
+        return false;
+    }
 
-        return true;
-    } catch (const std::filesystem::filesystem_error& e) {
-        dpm_log(LOG_ERROR, ("Failed to copy: " + std::string(e.what())).c_str());
+    // If the contents source is a directory, copy its contents
+    if (!std::filesystem::is_directory(source_path)) {
+        dpm_log(LOG_ERROR, ("Source is not a directory: " + source_path.string()).c_str());
         return false;
     }
+
+    return tree_copy(source_path, dest_path, mode, tree_copy_worker_count(), store);
 }
 
 static bool stage_populate_contents(
     const std::filesystem::path& package_dir,
-    const std::string& contents_dir
+    const std::string& contents_dir,
+    bool link
 ) {
     std::filesystem::path contents_source = std::filesystem::path(contents_dir);
     std::filesystem::path contents_dest = package_dir / "contents";
 
-    if (!stage_copy_dir(contents_source, contents_dest))
+    // large files shared with other packages are deduplicated through the content store, if one is configured
+    ContentStore store;
+    bool use_store = store.open_configured();
+
+    if (!stage_copy_dir(contents_source, contents_dest, link ? TreeCopyMode::HARDLINK : TreeCopyMode::COPY,
+                        use_store ? &store : nullptr))
     {
         dpm_log( LOG_FATAL, "Failed to copy the contents directory to the package stage.  Exiting." );
         return false;
@@ -223,8 +202,9 @@ static bool stage_populate_hooks(
             return false;
         }
 
-        // Now copy the directory after validation
-        if (!stage_copy_dir(hooks_source, hooks_dest))
+        // Now copy the directory after validation; hooks are always copied
+        // since they are made executable below, which would change linked sources
+        if (!stage_copy_dir(hooks_source, hooks_dest, TreeCopyMode::COPY))
         {
             dpm_log(LOG_FATAL, "Failed to copy the hooks directory to the package stage. Exiting.");
             return false;
@@ -272,7 +252,8 @@ int build_package_stage(
     const std::string& package_version,
     const std::string& architecture,
     const std::string& os,
-    bool force
+    bool force,
+    bool link
 ) {
     // Log start of package staging
     dpm_log(LOG_INFO, "Starting package staging...");
@@ -289,7 +270,7 @@ int build_package_stage(
     }
 
     // copy the contents dir to the contents part of the package stage
-    if (!stage_populate_contents(package_dir, contents_dir))
+    if (!stage_populate_contents(package_dir, contents_dir, link))
     {
         return 1;
     }
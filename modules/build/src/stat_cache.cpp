@@ -0,0 +1,258 @@
+/**
+ * @file stat_cache.cpp
+ * @brief Implementation of the stage stat cache used for incremental manifest refreshes
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "stat_cache.hpp"
+
+// first line of every cache file, bumped whenever the format changes
+static const char* STAT_CACHE_HEADER = "# dpm stat cache v1";
+
+/**
+ * @brief Fills the stat tuple of a cache entry from a stat result
+ *
+ * @param st Result of stat() on the file
+ * @param entry Entry to fill
+ */
+static void stat_cache_fill_tuple(const struct stat& st, StatCacheEntry& entry)
+{
+    entry.size = static_cast<uint64_t>(st.st_size);
+    entry.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    entry.inode = static_cast<uint64_t>(st.st_ino);
+    entry.ctime_ns = static_cast<int64_t>(st.st_ctim.tv_sec) * 1000000000LL + st.st_ctim.tv_nsec;
+}
+
+void stat_cache_load(const std::filesystem::path& stage_dir, StatCache& cache)
+{
+    cache.clear();
+
+    std::filesystem::path cache_path = stage_dir / STAT_CACHE_FILENAME;
+    std::ifstream cache_file(cache_path);
+    if (!cache_file.is_open()) {
+        DPM_LOG(LOG_DEBUG, "No stat cache found in stage: ", stage_dir.string());
+        return;
+    }
+
+    std::string line;
+    if (!std::getline(cache_file, line) || line != STAT_CACHE_HEADER) {
+        dpm_log(LOG_WARN, ("Ignoring stat cache with unknown format: " + cache_path.string()).c_str());
+        return;
+    }
+
+    // Format: size mtime_ns inode ctime_ns algorithm digest path
+    while (std::getline(cache_file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        std::istringstream iss(line);
+        StatCacheEntry entry;
+        std::string relative_path;
+
+        if (!(iss >> entry.size >> entry.mtime_ns >> entry.inode >> entry.ctime_ns >> entry.algorithm >> entry.digest)) {
+            dpm_log(LOG_WARN, ("Ignoring malformed stat cache line: " + line).c_str());
+            continue;
+        }
+
+        // The path may contain spaces, so it takes the rest of the line
+        std::getline(iss >> std::ws, relative_path);
+        if (relative_path.empty()) {
+            continue;
+        }
+
+        cache[relative_path] = entry;
+    }
+
+    DPM_LOG(LOG_DEBUG, "Loaded ", cache.size(), " stat cache entries");
+}
+
+bool stat_cache_save(const std::filesystem::path& stage_dir, const StatCache& cache)
+{
+    std::filesystem::path cache_path = stage_dir / STAT_CACHE_FILENAME;
+    std::filesystem::path temp_path = cache_path.string() + ".tmp." + std::to_string(getpid());
+
+    {
+        std::ofstream cache_file(temp_path, std::ios::trunc);
+        if (!cache_file.is_open()) {
+            dpm_log(LOG_WARN, ("Failed to write stat cache: " + temp_path.string()).c_str());
+            return false;
+        }
+
+        cache_file << STAT_CACHE_HEADER << "\n";
+        for (const auto& [relative_path, entry] : cache) {
+            cache_file << entry.size << " "
+                       << entry.mtime_ns << " "
+                       << entry.inode << " "
+                       << entry.ctime_ns << " "
+                       << entry.algorithm << " "
+                       << entry.digest << " "
+                       << relative_path << "\n";
+        }
+
+        if (!cache_file.good()) {
+            dpm_log(LOG_WARN, ("Failed to write stat cache: " + temp_path.string()).c_str());
+            cache_file.close();
+            std::filesystem::remove(temp_path);
+            return false;
+        }
+    }
+
+    // Replace the previous cache in one step so a crash never leaves half a cache behind
+    std::error_code ec;
+    std::filesystem::rename(temp_path, cache_path, ec);
+    if (ec) {
+        dpm_log(LOG_WARN, ("Failed to replace stat cache: " + ec.message()).c_str());
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Joins strings with commas, the form lists take in the cache file
+ *
+ * @param values Strings to join
+ * @return Comma separated list
+ */
+static std::string stat_cache_join(const std::vector<std::string>& values)
+{
+    std::string joined;
+    for (const auto& value : values) {
+        if (!joined.empty()) {
+            joined += ",";
+        }
+        joined += value;
+    }
+    return joined;
+}
+
+/**
+ * @brief Splits a comma separated list from the cache file
+ *
+ * @param joined Comma separated list
+ * @return The list entries
+ */
+static std::vector<std::string> stat_cache_split(const std::string& joined)
+{
+    std::vector<std::string> values;
+    std::stringstream ss(joined);
+    std::string value;
+    while (std::getline(ss, value, ',')) {
+        values.push_back(value);
+    }
+    return values;
+}
+
+/**
+ * @brief Hashes a file with every algorithm, taking the single algorithm fast path when possible
+ *
+ * @param full_path Path of the file on disk
+ * @param algorithms Hash algorithms, primary first
+ * @return Hexadecimal checksums, or an empty vector on failure
+ */
+static std::vector<std::string> stat_cache_hash_file(const std::filesystem::path& full_path,
+                                                     const std::vector<std::string>& algorithms)
+{
+    if (algorithms.size() == 1) {
+        std::string checksum = generate_file_checksum(full_path);
+        if (checksum.empty()) {
+            return {};
+        }
+        return { checksum };
+    }
+
+    return generate_file_checksums(full_path, algorithms);
+}
+
+StatCacheEntry stat_cache_make_entry(const struct stat& st, const std::vector<std::string>& algorithms,
+                                     const std::vector<std::string>& digests)
+{
+    StatCacheEntry entry;
+    stat_cache_fill_tuple(st, entry);
+    entry.algorithm = stat_cache_join(algorithms);
+    entry.digest = stat_cache_join(digests);
+    return entry;
+}
+
+bool stat_cache_lookup(const StatCache& cache, const std::string& relative_path, const struct stat& st,
+                       const std::string& algorithm, std::string& digest)
+{
+    auto it = cache.find(relative_path);
+    if (it == cache.end()) {
+        return false;
+    }
+
+    StatCacheEntry current;
+    stat_cache_fill_tuple(st, current);
+    if (it->second.size != current.size || it->second.mtime_ns != current.mtime_ns ||
+        it->second.inode != current.inode || it->second.ctime_ns != current.ctime_ns) {
+        return false;
+    }
+
+    std::vector<std::string> algorithms = stat_cache_split(it->second.algorithm);
+    std::vector<std::string> digests = stat_cache_split(it->second.digest);
+    if (algorithms.empty() || algorithms.front() != algorithm || digests.size() != algorithms.size() ||
+        digests.front().empty()) {
+        return false;
+    }
+
+    digest = digests.front();
+    return true;
+}
+
+std::vector<std::string> stat_cache_file_checksums(
+    const StatCache& previous,
+    StatCache& updated,
+    const std::string& relative_path,
+    const std::filesystem::path& full_path,
+    const std::vector<std::string>& algorithms,
+    bool full_rehash,
+    bool& reused)
+{
+    reused = false;
+
+    struct stat st;
+    if (stat(full_path.c_str(), &st) != 0) {
+        // let the hashing report the problem
+        return stat_cache_hash_file(full_path, algorithms);
+    }
+
+    StatCacheEntry current;
+    stat_cache_fill_tuple(st, current);
+    current.algorithm = stat_cache_join(algorithms);
+
+    if (!full_rehash) {
+        auto it = previous.find(relative_path);
+        if (it != previous.end() &&
+            it->second.size == current.size &&
+            it->second.mtime_ns == current.mtime_ns &&
+            it->second.inode == current.inode &&
+            it->second.ctime_ns == current.ctime_ns &&
+            it->second.algorithm == current.algorithm &&
+            !it->second.digest.empty()) {
+            std::vector<std::string> digests = stat_cache_split(it->second.digest);
+            if (digests.size() == algorithms.size()) {
+                current.digest = it->second.digest;
+                updated[relative_path] = current;
+                reused = true;
+                dpm_metric_add(DPM_METRIC_STAT_CACHE_HITS, 1);
+                return digests;
+            }
+        }
+    }
+
+    dpm_metric_add(DPM_METRIC_STAT_CACHE_MISSES, 1);
+    std::vector<std::string> digests = stat_cache_hash_file(full_path, algorithms);
+    if (!digests.empty()) {
+        current.digest = stat_cache_join(digests);
+        updated[relative_path] = current;
+    }
+
+    return digests;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file task_graph.cpp
+ * @brief Implementation of the build task graph
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "task_graph.hpp"
+
+size_t TaskGraph::add(const std::string& name, std::function<bool()> work, const std::vector<size_t>& dependencies)
+{
+    _tasks.push_back({ name, std::move(work), dependencies, State::WAITING });
+    return _tasks.size() - 1;
+}
+
+bool TaskGraph::next_ready(size_t& task_id)
+{
+    // skipping one task can make its dependents skippable too, so repeat until nothing changes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < _tasks.size(); i++) {
+            Task& task = _tasks[i];
+            if (task.state != State::WAITING) {
+                continue;
+            }
+
+            bool ready = true;
+            bool blocked = false;
+            for (size_t dependency : task.dependencies) {
+                State dependency_state = _tasks[dependency].state;
+                if (dependency_state == State::FAILED || dependency_state == State::SKIPPED) {
+                    blocked = true;
+                    break;
+                }
+                if (dependency_state != State::SUCCEEDED) {
+                    ready = false;
+                }
+            }
+
+            if (blocked) {
+                dpm_log(LOG_ERROR, ("Skipping " + task.name + " because a step it depends on failed").c_str());
+                task.state = State::SKIPPED;
+                changed = true;
+                continue;
+            }
+
+            if (ready) {
+                task_id = i;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+std::vector<size_t> TaskGraph::take_ready()
+{
+    std::vector<size_t> ready;
+    size_t task_id = 0;
+    while (_running < _limit && next_ready(task_id)) {
+        _tasks[task_id].state = State::RUNNING;
+        _running++;
+        ready.push_back(task_id);
+    }
+    return ready;
+}
+
+void TaskGraph::launch(const std::vector<size_t>& task_ids)
+{
+    // outside the lock, where there is no core pool the task runs right here
+    for (size_t task_id : task_ids) {
+        dpm_submit_task(_group, &TaskGraph::task_entry, &_entries[task_id]);
+    }
+}
+
+void TaskGraph::task_entry(void* context)
+{
+    auto* entry = static_cast<std::pair<TaskGraph*, size_t>*>(context);
+    entry->first->run_task(entry->second);
+}
+
+void TaskGraph::run_task(size_t task_id)
+{
+    const std::string& name = _tasks[task_id].name;
+    DPM_LOG(LOG_DEBUG, "Starting ", name);
+    bool succeeded = false;
+    try {
+        succeeded = _tasks[task_id].work();
+    } catch (const std::exception& e) {
+        dpm_log(LOG_ERROR, ("Error during " + name + ": " + std::string(e.what())).c_str());
+    }
+
+    std::vector<size_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks[task_id].state = succeeded ? State::SUCCEEDED : State::FAILED;
+        _running--;
+        ready = take_ready();
+    }
+    launch(ready);
+}
+
+bool TaskGraph::run(size_t worker_count)
+{
+    _limit = std::max<size_t>(1, std::min(worker_count, _tasks.size()));
+    _running = 0;
+    _entries.clear();
+    for (size_t i = 0; i < _tasks.size(); i++) {
+        _entries.emplace_back(this, i);
+    }
+
+    // the calling thread runs queued tasks while it waits for the group
+    _group = dpm_task_group_create();
+    std::vector<size_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ready = take_ready();
+    }
+    launch(ready);
+    dpm_task_group_destroy(_group);
+    _group = nullptr;
+
+    for (const auto& task : _tasks) {
+        if (task.state != State::SUCCEEDED) {
+            return false;
+        }
+    }
+    return true;
+}
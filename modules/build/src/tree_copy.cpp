@@ -0,0 +1,254 @@
+/**
+ * @file tree_copy.cpp
+ * @brief Implementation of the stage tree copy
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "tree_copy.hpp"
+
+size_t tree_copy_worker_count()
+{
+    return build_thread_share(build_config_thread_count("stage_threads", dpm_worker_threads()));
+}
+
+/**
+ * @brief How a file ended up in the destination, for the summary log
+ */
+enum class FilePlacement { REFLINK, COPY_RANGE, READ_WRITE, HARDLINK };
+
+// copies the data of in to out, returning 0 or the errno of the failure
+static int tree_copy_data(int in, int out, std::vector<unsigned char>& buffer, FilePlacement& placement)
+{
+    // a reflink shares the extents, so the copy takes no time and no space
+    if (ioctl(out, FICLONE, in) == 0) {
+        placement = FilePlacement::REFLINK;
+        return 0;
+    }
+
+    // copy_file_range keeps the data in the kernel, and may share extents too
+    bool copied_any = false;
+    while (true) {
+        ssize_t copied = copy_file_range(in, NULL, out, NULL, 1024 * 1024 * 1024, 0);
+        if (copied > 0) {
+            copied_any = true;
+            continue;
+        }
+        if (copied == 0) {
+            placement = FilePlacement::COPY_RANGE;
+            return 0;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+
+        // unsupported between these filesystems, fall back to reading and writing
+        if (!copied_any && (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+                            errno == EOPNOTSUPP || errno == EPERM)) {
+            break;
+        }
+        return errno;
+    }
+
+    int write_error = 0;
+    int read_error = file_read_sequential(in, buffer, [&](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        while (size > 0) {
+            ssize_t written = ::write(out, bytes, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                write_error = errno;
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    });
+    placement = FilePlacement::READ_WRITE;
+    return write_error != 0 ? write_error : read_error;
+}
+
+// copies one file with its permissions, returning 0 or the errno of the failure
+static int tree_copy_file(const std::string& source, const std::string& dest, TreeCopyMode mode,
+                          std::vector<unsigned char>& buffer, FilePlacement& placement)
+{
+    if (mode == TreeCopyMode::HARDLINK) {
+        // replace what is there, as a copy would overwrite it
+        if (unlink(dest.c_str()) != 0 && errno != ENOENT) {
+            return errno;
+        }
+        if (linkat(AT_FDCWD, source.c_str(), AT_FDCWD, dest.c_str(), AT_SYMLINK_FOLLOW) == 0) {
+            placement = FilePlacement::HARDLINK;
+            return 0;
+        }
+
+        // across filesystems or past the link limit the file is copied instead
+        if (errno != EXDEV && errno != EMLINK && errno != EPERM) {
+            return errno;
+        }
+    }
+
+    int in = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return errno;
+    }
+
+    struct stat st;
+    if (fstat(in, &st) != 0) {
+        int error = errno;
+        ::close(in);
+        return error;
+    }
+
+    int out = ::open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 07777);
+    if (out < 0) {
+        int error = errno;
+        ::close(in);
+        return error;
+    }
+
+    int error = tree_copy_data(in, out, buffer, placement);
+
+    // the mode given to open is filtered by the umask, the copy keeps the source permissions
+    if (error == 0 && fchmod(out, st.st_mode & 07777) != 0) {
+        error = errno;
+    }
+    if (::close(out) != 0 && error == 0) {
+        error = errno;
+    }
+    ::close(in);
+    return error;
+}
+
+// places a large file through the content store, returning 0 or the errno of the failure
+static int tree_copy_file_through_store(const ContentStore& store, const std::string& source, const std::string& dest,
+                                        TreeCopyMode mode, std::vector<unsigned char>& buffer,
+                                        FilePlacement& placement)
+{
+    struct stat st;
+    if (stat(source.c_str(), &st) != 0) {
+        return errno;
+    }
+
+    std::string checksum = generate_file_checksum(source);
+    if (checksum.empty()) {
+        return EIO;
+    }
+
+    std::filesystem::path object = store.object_path(checksum, st.st_mode);
+    if (access(object.c_str(), F_OK) != 0) {
+        // an object only enters the store once its own data has been hashed, whatever the source does meanwhile
+        std::filesystem::path temporary = store.temporary_path(object);
+        FilePlacement stored_placement;
+        int error = temporary.empty() ? EIO : tree_copy_file(source, temporary.string(), TreeCopyMode::COPY,
+                                                             buffer, stored_placement);
+        if (error == 0 && generate_file_checksum(temporary) != checksum) {
+            error = EAGAIN;
+        }
+        if (error == 0 && rename(temporary.c_str(), object.c_str()) != 0) {
+            error = errno;
+        }
+        if (error != 0) {
+            if (!temporary.empty()) {
+                unlink(temporary.c_str());
+            }
+            dpm_log(LOG_WARN, ("Failed to add " + source + " to the content store: " + strerror(error)).c_str());
+            return tree_copy_file(source, dest, mode, buffer, placement);
+        }
+    }
+
+    return tree_copy_file(object.string(), dest, mode, buffer, placement);
+}
+
+bool tree_copy(const std::filesystem::path& source_path, const std::filesystem::path& dest_path,
+               TreeCopyMode mode, size_t worker_count, const ContentStore* store)
+{
+    // a single walk lists the directories to create, each before its contents, and the files to copy
+    TreeWalk walk;
+    if (!tree_walk(source_path, walk, tree_walk_worker_count())) {
+        return false;
+    }
+
+    struct TreeCopyFile {
+        std::string source;
+        std::string dest;
+        bool through_store;     ///< Large enough to be placed through the content store
+    };
+    std::vector<TreeCopyFile> files;
+    try {
+        for (const auto& entry : walk) {
+            std::filesystem::path dest_item = dest_path / entry.relative_path;
+            if (entry.is_directory) {
+                std::filesystem::create_directories(dest_item);
+            } else {
+                // the walk does not follow symlinks, the store only takes regular files
+                bool through_store = store && S_ISREG(entry.st.st_mode) &&
+                                     static_cast<uint64_t>(entry.st.st_size) >= store->min_size();
+                files.push_back({ (source_path / entry.relative_path).string(), dest_item.string(),
+                                  through_store });
+            }
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        dpm_log(LOG_ERROR, ("Failed to copy: " + std::string(e.what())).c_str());
+        return false;
+    }
+
+    std::atomic<size_t> next_file(0);
+    std::atomic<bool> failed(false);
+    std::mutex counts_mutex;
+    size_t counts[4] = { 0, 0, 0, 0 };
+    size_t stored_count = 0;
+
+    auto worker = [&] {
+        std::vector<unsigned char> buffer;
+        size_t local_counts[4] = { 0, 0, 0, 0 };
+        size_t local_stored = 0;
+        while (!failed) {
+            size_t index = next_file++;
+            if (index >= files.size()) {
+                break;
+            }
+
+            const TreeCopyFile& file = files[index];
+            FilePlacement placement = FilePlacement::READ_WRITE;
+            int error = file.through_store
+                ? tree_copy_file_through_store(*store, file.source, file.dest, mode, buffer, placement)
+                : tree_copy_file(file.source, file.dest, mode, buffer, placement);
+            if (error != 0) {
+                dpm_log(LOG_ERROR, ("Failed to copy " + file.source + " to " + file.dest +
+                                    ": " + strerror(error)).c_str());
+                failed = true;
+                break;
+            }
+            local_counts[static_cast<int>(placement)]++;
+            if (file.through_store) {
+                local_stored++;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(counts_mutex);
+        for (int i = 0; i < 4; i++) {
+            counts[i] += local_counts[i];
+        }
+        stored_count += local_stored;
+    };
+
+    // worker_count copiers run on the shared worker pool, the calling thread among them
+    worker_count = std::max<size_t>(1, std::min(worker_count, files.size()));
+    dpm_parallel_for_each(0, worker_count, 1, [&worker](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            worker();
+        }
+    });
+
+    DPM_LOG(LOG_DEBUG, "Placed ", files.size(), " files with ", worker_count, " workers: ", counts[0],
+            " reflinked, ", counts[1], " copied in kernel, ", counts[2], " copied, ", counts[3],
+            " hard linked, ", stored_count, " through the content store");
+    return !failed;
+}
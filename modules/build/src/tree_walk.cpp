@@ -0,0 +1,215 @@
+/**
+ * @file tree_walk.cpp
+ * @brief Implementation of the parallel directory tree walker
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "tree_walk.hpp"
+
+size_t tree_walk_worker_count()
+{
+    // directory reads wait on the disk, so more threads than CPUs still help
+    return build_thread_share(build_config_thread_count("walk_threads", std::max<size_t>(4, dpm_worker_threads())));
+}
+
+/**
+ * @brief Layout of the records getdents64 fills its buffer with
+ */
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+/**
+ * @brief State shared by the threads of one walk
+ */
+struct TreeWalkState {
+    /// Directories waiting to be read, one queue per thread
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::string> directories;
+    };
+
+    int root_fd;
+    std::vector<Queue> queues;
+    std::vector<TreeWalk> found;
+    /// Directories queued or being read; the walk is over when it drops to zero
+    std::atomic<size_t> pending;
+    std::atomic<bool> failed;
+
+    explicit TreeWalkState(size_t worker_count)
+        : root_fd(-1), queues(worker_count), found(worker_count), pending(0), failed(false)
+    {
+    }
+};
+
+// takes the most recently found directory of this thread, or the oldest one of another
+static bool tree_walk_next(TreeWalkState& state, size_t worker, std::string& directory)
+{
+    {
+        TreeWalkState::Queue& own = state.queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.directories.empty()) {
+            directory = std::move(own.directories.back());
+            own.directories.pop_back();
+            return true;
+        }
+    }
+
+    // the oldest directories are nearest the root, so stealing them takes the most work at once
+    for (size_t offset = 1; offset < state.queues.size(); offset++) {
+        TreeWalkState::Queue& other = state.queues[(worker + offset) % state.queues.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.directories.empty()) {
+            directory = std::move(other.directories.front());
+            other.directories.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// lists one directory, queueing its subdirectories on this thread
+static bool tree_walk_directory(TreeWalkState& state, size_t worker, const std::string& directory)
+{
+    DpmProfileScope profile("walk_directory");
+
+    int dir_fd = openat(state.root_fd, directory.empty() ? "." : directory.c_str(),
+                        O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (dir_fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to open directory " + directory + ": " + strerror(errno)).c_str());
+        return false;
+    }
+
+    std::string prefix = directory.empty() ? "" : directory + "/";
+    alignas(LinuxDirent64) char buffer[64 * 1024];
+    bool success = true;
+
+    while (success) {
+        long got = syscall(SYS_getdents64, dir_fd, buffer, sizeof(buffer));
+        if (got == 0) {
+            break;
+        }
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            dpm_log(LOG_ERROR, ("Failed to read directory " + directory + ": " + strerror(errno)).c_str());
+            success = false;
+            break;
+        }
+
+        for (long position = 0; position < got; ) {
+            const LinuxDirent64* record = reinterpret_cast<const LinuxDirent64*>(buffer + position);
+            position += record->d_reclen;
+
+            const char* name = record->d_name;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                continue;
+            }
+
+            TreeWalkEntry entry;
+            entry.relative_path = prefix + name;
+            if (fstatat(dir_fd, name, &entry.st, AT_SYMLINK_NOFOLLOW) != 0) {
+                dpm_log(LOG_ERROR, ("Failed to stat " + entry.relative_path + ": " + strerror(errno)).c_str());
+                success = false;
+                break;
+            }
+
+            entry.is_directory = S_ISDIR(entry.st.st_mode);
+            if (S_ISLNK(entry.st.st_mode)) {
+                struct stat target;
+                entry.is_directory = fstatat(dir_fd, name, &target, 0) == 0 && S_ISDIR(target.st_mode);
+            }
+
+            if (S_ISDIR(entry.st.st_mode)) {
+                state.pending++;
+                TreeWalkState::Queue& own = state.queues[worker];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.directories.push_back(entry.relative_path);
+            }
+            state.found[worker].push_back(std::move(entry));
+        }
+    }
+
+    ::close(dir_fd);
+    return success;
+}
+
+static void tree_walk_worker(TreeWalkState& state, size_t worker)
+{
+    std::string directory;
+    while (!state.failed) {
+        if (!tree_walk_next(state, worker, directory)) {
+            // nothing queued anywhere: done if nobody is still reading, otherwise wait for more
+            if (state.pending == 0) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+
+        if (!tree_walk_directory(state, worker, directory)) {
+            state.failed = true;
+        }
+        state.pending--;
+    }
+}
+
+bool tree_walk(const std::filesystem::path& root, TreeWalk& walk, size_t worker_count, bool sorted)
+{
+    DpmProfileScope profile("tree_walk");
+    worker_count = std::max<size_t>(1, worker_count);
+    TreeWalkState state(worker_count);
+
+    state.root_fd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (state.root_fd < 0) {
+        dpm_log(LOG_ERROR, ("Failed to open directory " + root.string() + ": " + strerror(errno)).c_str());
+        return false;
+    }
+
+    // the root is the empty relative path
+    state.pending = 1;
+    state.queues[0].directories.push_back("");
+
+    // one walker per queue on the shared worker pool, which the calling thread joins
+    dpm_parallel_for_each(0, worker_count, 1, [&state](size_t begin, size_t end) {
+        for (size_t worker = begin; worker < end; worker++) {
+            tree_walk_worker(state, worker);
+        }
+    });
+    ::close(state.root_fd);
+
+    if (state.failed) {
+        dpm_log(LOG_ERROR, ("Failed to walk directory: " + root.string()).c_str());
+        return false;
+    }
+
+    walk.clear();
+    size_t total = 0;
+    for (const auto& found : state.found) {
+        total += found.size();
+    }
+    walk.reserve(total);
+    for (auto& found : state.found) {
+        std::move(found.begin(), found.end(), std::back_inserter(walk));
+    }
+
+    if (sorted) {
+        std::sort(walk.begin(), walk.end(), [](const TreeWalkEntry& a, const TreeWalkEntry& b) {
+            return a.relative_path < b.relative_path;
+        });
+    }
+
+    DPM_LOG(LOG_DEBUG, "Walked ", walk.size(), " entries of ", root.string(), " with ", worker_count,
+            " threads");
+    profile.add_files(walk.size());
+    return true;
+}
@@ -0,0 +1,388 @@
+/**
+ * @file uring_reader.cpp
+ * @brief Implementation of the io_uring batched file reader
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "uring_reader.hpp"
+
+static std::once_flag g_uring_probe_flag;
+static bool g_uring_supported = false;
+
+static int uring_setup(unsigned int entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int uring_enter(int ring_fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+static int uring_register(int ring_fd, unsigned int opcode, void* arg, unsigned int nr_args)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+// sets up a small ring and asks the kernel which operations it supports
+static void uring_probe_once()
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int ring_fd = uring_setup(4, &params);
+    if (ring_fd < 0) {
+        DPM_LOG(LOG_DEBUG, "io_uring is not available: ", strerror(errno));
+        return;
+    }
+
+    const unsigned int op_count = 256;
+    std::vector<unsigned char> probe_buffer(sizeof(io_uring_probe) + op_count * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probe_buffer.data());
+
+    bool supported = false;
+    if (uring_register(ring_fd, IORING_REGISTER_PROBE, probe, op_count) == 0) {
+        supported = true;
+        for (unsigned int op : { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE }) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                supported = false;
+            }
+        }
+    }
+    ::close(ring_fd);
+
+    if (!supported) {
+        dpm_log(LOG_DEBUG, "io_uring does not support the operations needed to read files");
+        return;
+    }
+    g_uring_supported = true;
+}
+
+bool UringFileReader::supported()
+{
+    const char* configured = dpm_get_config("build", "io_uring");
+    if (configured) {
+        std::string value = configured;
+        if (value == "0" || value == "false" || value == "no" || value == "off") {
+            return false;
+        }
+    }
+
+    std::call_once(g_uring_probe_flag, uring_probe_once);
+    return g_uring_supported;
+}
+
+UringFileReader::UringFileReader(unsigned int depth)
+    : _ring_fd(-1), _depth(std::max(depth, 1u)),
+      _sq_ring(MAP_FAILED), _sq_ring_size(0), _cq_ring(MAP_FAILED), _cq_ring_size(0),
+      _sqes(nullptr), _sqes_size(0),
+      _sq_head(nullptr), _sq_tail(nullptr), _sq_mask(nullptr), _sq_array(nullptr),
+      _cq_head(nullptr), _cq_tail(nullptr), _cq_mask(nullptr), _cqes(nullptr)
+{
+    if (supported() && !setup(_depth)) {
+        teardown();
+    }
+}
+
+UringFileReader::~UringFileReader()
+{
+    teardown();
+}
+
+bool UringFileReader::setup(unsigned int entries)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    _ring_fd = uring_setup(entries, &params);
+    if (_ring_fd < 0) {
+        DPM_LOG(LOG_DEBUG, "Failed to set up an io_uring: ", strerror(errno));
+        return false;
+    }
+
+    _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        _sq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+    }
+
+    _sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    _ring_fd, IORING_OFF_SQ_RING);
+    if (_sq_ring == MAP_FAILED) {
+        return false;
+    }
+
+    if (single_mmap) {
+        _cq_ring = _sq_ring;
+        _cq_ring_size = 0;
+    } else {
+        _cq_ring = mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        _ring_fd, IORING_OFF_CQ_RING);
+        if (_cq_ring == MAP_FAILED) {
+            return false;
+        }
+    }
+
+    _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      _ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+    _sqes = static_cast<io_uring_sqe*>(sqes);
+
+    unsigned char* sq = static_cast<unsigned char*>(_sq_ring);
+    unsigned char* cq = static_cast<unsigned char*>(_cq_ring);
+    _sq_head = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+    _sq_mask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+    _sq_array = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+    _cq_head = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+    _cq_mask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // every file in flight has at most one operation submitted
+    _depth = std::min(_depth, params.sq_entries);
+    return true;
+}
+
+void UringFileReader::teardown()
+{
+    if (_sqes) {
+        munmap(_sqes, _sqes_size);
+        _sqes = nullptr;
+    }
+    if (_cq_ring != MAP_FAILED && _cq_ring != _sq_ring) {
+        munmap(_cq_ring, _cq_ring_size);
+    }
+    _cq_ring = MAP_FAILED;
+    if (_sq_ring != MAP_FAILED) {
+        munmap(_sq_ring, _sq_ring_size);
+        _sq_ring = MAP_FAILED;
+    }
+    if (_ring_fd >= 0) {
+        ::close(_ring_fd);
+        _ring_fd = -1;
+    }
+
+    // with the ring gone nothing is left to complete into these
+    for (int fd : _abandoned_fds) {
+        ::close(fd);
+    }
+    _abandoned_fds.clear();
+    _abandoned_buffers.clear();
+}
+
+bool UringFileReader::active() const
+{
+    return _sqes != nullptr;
+}
+
+unsigned int UringFileReader::depth() const
+{
+    return _depth;
+}
+
+io_uring_sqe* UringFileReader::next_sqe()
+{
+    // only this thread writes the tail, the kernel reads it once submitted
+    unsigned int tail = *_sq_tail;
+    unsigned int index = tail & *_sq_mask;
+    io_uring_sqe* sqe = &_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    _sq_array[index] = index;
+    return sqe;
+}
+
+void UringFileReader::push_sqe()
+{
+    __atomic_store_n(_sq_tail, *_sq_tail + 1, __ATOMIC_RELEASE);
+}
+
+bool UringFileReader::submit(unsigned int to_submit, unsigned int wait_for)
+{
+    while (true) {
+        int result = uring_enter(_ring_fd, to_submit, wait_for, wait_for > 0 ? IORING_ENTER_GETEVENTS : 0);
+        if (result >= 0) {
+            return true;
+        }
+        if (errno != EINTR) {
+            DPM_LOG(LOG_WARN, "io_uring submission failed, reading files without it: ", strerror(errno));
+            return false;
+        }
+    }
+}
+
+enum class UringSlotState { FREE, OPENING, READING, CLOSING };
+
+struct UringSlot {
+    UringSlotState state = UringSlotState::FREE;
+    size_t index = 0;
+    int fd = -1;
+    unsigned int position = 0;  ///< Submission queue position of the slot's operation in flight
+    std::vector<unsigned char> data;
+};
+
+void UringFileReader::abandon_slots(std::vector<UringSlot>& slots)
+{
+    // completions already posted are finished with, those opens leave an fd behind
+    unsigned int head = *_cq_head;
+    unsigned int tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        const io_uring_cqe* cqe = &_cqes[head & *_cq_mask];
+        UringSlot& slot = slots[cqe->user_data];
+        if (slot.state == UringSlotState::OPENING && cqe->res >= 0) {
+            ::close(cqe->res);
+        } else if (slot.state == UringSlotState::READING) {
+            ::close(slot.fd);
+        }
+        slot.state = UringSlotState::FREE;
+    }
+    __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+
+    unsigned int sq_head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    for (auto& slot : slots) {
+        // an operation the kernel never took will not run
+        bool taken = static_cast<int>(slot.position - sq_head) < 0;
+
+        switch (slot.state) {
+        case UringSlotState::READING:
+            if (taken) {
+                // the read may still land in the buffer, so both outlive the ring
+                _abandoned_fds.push_back(slot.fd);
+                _abandoned_buffers.push_back(std::move(slot.data));
+            } else {
+                ::close(slot.fd);
+            }
+            break;
+        case UringSlotState::CLOSING:
+            // once taken the close is the kernel's, closing the number again could hit a reused one
+            if (!taken) {
+                ::close(slot.fd);
+            }
+            break;
+        case UringSlotState::OPENING:
+            if (taken) {
+                DPM_LOG(LOG_DEBUG, "An io_uring open was still in flight when the ring failed");
+            }
+            break;
+        case UringSlotState::FREE:
+            break;
+        }
+        slot.state = UringSlotState::FREE;
+        slot.fd = -1;
+    }
+}
+
+bool UringFileReader::read_files(const std::vector<UringReadRequest>& requests,
+                                 const std::function<void(size_t index, std::vector<unsigned char>& data)>& read)
+{
+    if (!active()) {
+        return false;
+    }
+
+    std::vector<UringSlot> slots(_depth);
+    size_t next_request = 0;
+    size_t in_flight = 0;
+
+    while (true) {
+        // queue an open for every free slot while files are left
+        for (size_t slot_index = 0; slot_index < slots.size() && next_request < requests.size(); slot_index++) {
+            UringSlot& slot = slots[slot_index];
+            if (slot.state != UringSlotState::FREE) {
+                continue;
+            }
+
+            // files too large for one request are left to the caller
+            while (next_request < requests.size() && requests[next_request].size > URING_READER_MAX_FILE_SIZE) {
+                next_request++;
+            }
+            if (next_request >= requests.size()) {
+                break;
+            }
+
+            slot.state = UringSlotState::OPENING;
+            slot.index = next_request++;
+            io_uring_sqe* sqe = next_sqe();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uint64_t>(requests[slot.index].path);
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = slot_index;
+            slot.position = *_sq_tail;
+            push_sqe();
+            in_flight++;
+        }
+
+        if (in_flight == 0) {
+            return true;
+        }
+
+        unsigned int pending = *_sq_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+        if (!submit(pending, 1)) {
+            abandon_slots(slots);
+            teardown();
+            return false;
+        }
+
+        unsigned int head = *_cq_head;
+        unsigned int tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const io_uring_cqe* cqe = &_cqes[head & *_cq_mask];
+            UringSlot& slot = slots[cqe->user_data];
+            int result = cqe->res;
+
+            switch (slot.state) {
+            case UringSlotState::OPENING: {
+                if (result < 0) {
+                    slot.state = UringSlotState::FREE;
+                    in_flight--;
+                    break;
+                }
+
+                // one byte more than expected tells a file that grew from one of the expected size
+                slot.fd = result;
+                slot.data.resize(requests[slot.index].size + 1);
+                slot.state = UringSlotState::READING;
+                io_uring_sqe* sqe = next_sqe();
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = slot.fd;
+                sqe->addr = reinterpret_cast<uint64_t>(slot.data.data());
+                sqe->len = static_cast<uint32_t>(slot.data.size());
+                sqe->off = 0;
+                sqe->user_data = cqe->user_data;
+                slot.position = *_sq_tail;
+                push_sqe();
+                break;
+            }
+            case UringSlotState::READING: {
+                if (result >= 0 && static_cast<uint64_t>(result) == requests[slot.index].size) {
+                    slot.data.resize(static_cast<size_t>(result));
+                    read(slot.index, slot.data);
+                }
+                slot.data.clear();
+
+                slot.state = UringSlotState::CLOSING;
+                io_uring_sqe* sqe = next_sqe();
+                sqe->opcode = IORING_OP_CLOSE;
+                sqe->fd = slot.fd;
+                sqe->user_data = cqe->user_data;
+                slot.position = *_sq_tail;
+                push_sqe();
+                break;
+            }
+            case UringSlotState::CLOSING:
+            case UringSlotState::FREE:
+                slot.state = UringSlotState::FREE;
+                slot.fd = -1;
+                in_flight--;
+                break;
+            }
+        }
+        __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+    }
+}
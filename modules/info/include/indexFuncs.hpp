@@ -0,0 +1,84 @@
+/**
+ * @file indexFuncs.hpp
+ * @brief Header file for the repository index command of the info module
+ *
+ * Defines the functions behind "dpm info index", which catalogs every
+ * package in a repository directory into a RepositoryIndex.  Only the
+ * metadata component of each package is read, located through the package
+ * index where the package has one, and the manifest it holds is skipped
+ * without being copied out.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <sys/stat.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/BuildModuleService.hpp>
+#include <dpmdk/include/RepositoryIndex.hpp>
+#include "packageFuncs.hpp"
+
+/**
+ * @brief Reads the catalog fields of one package
+ *
+ * @param build_module Build module function table
+ * @param package_path Path of the package file
+ * @param package Receives the metadata fields and component sizes, other fields are left as they are
+ * @return true on success, false if the package or its metadata could not be read
+ */
+bool index_read_package(const BuildModuleFunctions* build_module, const std::string& package_path,
+                        RepositoryIndexSource& package);
+
+/**
+ * @brief Writes a repository index catalog of a directory of packages
+ *
+ * Every file ending in .dpm below the directory is cataloged, in parallel
+ * on the shared worker pool.  When updating, packages whose size,
+ * modification time and inode match their record in the existing index are
+ * copied from it without being opened.  The index is written beside its
+ * final name and renamed into place.
+ *
+ * @param repository_dir Directory holding the packages
+ * @param index_path Path of the index to write
+ * @param update Whether to reuse the records of an existing index at index_path
+ * @return 0 on success, non-zero if the index could not be written or a package could not be read
+ */
+int index_generate(const std::filesystem::path& repository_dir, const std::filesystem::path& index_path, bool update);
+
+/**
+ * @brief Prints the packages recorded in a repository index
+ *
+ * @param index_path Path of the index
+ * @return 0 on success, non-zero if the index could not be read
+ */
+int index_list(const std::filesystem::path& index_path);
+
+/**
+ * @brief Handler for the index command
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_index(int argc, char** argv);
+
+/**
+ * @brief Displays the help of the index command
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success
+ */
+int cmd_index_help(int argc, char** argv);
@@ -28,7 +28,9 @@ enum Command {
     CMD_HELP,       /**< Display help information */
     CMD_VERSION,    /**< Display version information */
     CMD_SYSTEM,     /**< Display system information */
-    CMD_CONFIG      /**< Display configuration information */
+    CMD_CONFIG,     /**< Display configuration information */
+    CMD_INDEX,      /**< Write a repository index of a directory of packages */
+    CMD_PACKAGE     /**< Display the metadata and files of a package */
 };
 
 /**
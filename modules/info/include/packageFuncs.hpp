@@ -0,0 +1,83 @@
+/**
+ * @file packageFuncs.hpp
+ * @brief Header file for the package inspection command of the info module
+ *
+ * Defines the functions behind "dpm info package", which prints the
+ * metadata of a package file and lists its contents manifest.  The package
+ * is mapped through the build module's package reader and only its
+ * metadata component is read; the manifest is listed from the binary
+ * CONTENTS_MANIFEST_INDEX where the package has one, so a path prefix is
+ * looked up without parsing the text manifest, and the contents component
+ * is never decompressed.
+ *
+ * The listing is informational.  "dpm verify" is what checks that the
+ * manifest and its index match the package's digests.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/BuildModuleService.hpp>
+#include <dpmdk/include/ManifestIndex.hpp>
+#include <dpmdk/include/ManifestCodec.hpp>
+
+/**
+ * @brief Largest text metadata field, in bytes, printed by the package command
+ */
+#define PACKAGE_INFO_MAX_FIELD_SIZE (64 * 1024)
+
+/**
+ * @brief Metadata of a package read for inspection
+ */
+struct PackageInfo {
+    std::map<std::string, std::string> fields;  ///< Text fields, keyed by name
+    std::string manifest_index;                 ///< CONTENTS_MANIFEST_INDEX, empty if the package has none
+    std::string manifest;                       ///< CONTENTS_MANIFEST_DIGEST, only read when the index is unusable
+    uint64_t manifest_size;                     ///< Size of CONTENTS_MANIFEST_DIGEST in bytes
+    uint64_t contents_size;                     ///< Size of the sealed contents component in bytes
+    uint64_t hooks_size;                        ///< Size of the sealed hooks component in bytes
+    uint64_t metadata_size;                     ///< Size of the sealed metadata component in bytes
+};
+
+/**
+ * @brief Reads the metadata of a package file
+ *
+ * @param build_module Build module function table
+ * @param package_path Path of the package file
+ * @param read_manifest Whether the contents manifest is needed, read from its index where possible
+ * @param info Receives the metadata
+ * @return 0 on success, non-zero if the package or its metadata could not be read
+ */
+int package_info_read(const BuildModuleFunctions* build_module, const std::string& package_path,
+                      bool read_manifest, PackageInfo& info);
+
+/**
+ * @brief Handler for the package command
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_package(int argc, char** argv);
+
+/**
+ * @brief Displays the help of the package command
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success
+ */
+int cmd_package_help(int argc, char** argv);
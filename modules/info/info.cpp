@@ -38,6 +38,8 @@
 #include <sys/utsname.h>
 
 #include "include/infoFuncs.hpp"
+#include "include/indexFuncs.hpp"
+#include "include/packageFuncs.hpp"
 
 /**
  * @def MODULE_VERSION
@@ -100,6 +102,12 @@ extern "C" int dpm_module_execute(const char* command, int argc, char** argv) {
         case CMD_CONFIG:
             return cmd_config(argc, argv);
 
+        case CMD_INDEX:
+            return cmd_index(argc, argv);
+
+        case CMD_PACKAGE:
+            return cmd_package(argc, argv);
+
         case CMD_HELP:
             return cmd_help(argc, argv);
 
@@ -0,0 +1,260 @@
+/**
+ * @file indexFuncs.cpp
+ * @brief Implementation of the repository index command of the info module
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "indexFuncs.hpp"
+
+bool index_read_package(const BuildModuleFunctions* build_module, const std::string& package_path,
+                        RepositoryIndexSource& package)
+{
+    PackageInfo info;
+    if (package_info_read(build_module, package_path, false, info) != 0) {
+        return false;
+    }
+
+    auto field = [&info](const char* name) {
+        auto it = info.fields.find(name);
+        return it == info.fields.end() ? std::string() : it->second;
+    };
+    package.name = field("NAME");
+    package.version = field("VERSION");
+    package.architecture = field("ARCHITECTURE");
+    package.package_digest = field("PACKAGE_DIGEST");
+    package.dependencies = field("DEPENDENCIES");
+    package.contents_size = info.contents_size;
+    package.hooks_size = info.hooks_size;
+    package.metadata_size = info.metadata_size;
+
+    if (package.name.empty() || package.package_digest.empty()) {
+        dpm_log(LOG_ERROR, ("Package has no NAME or PACKAGE_DIGEST: " + package_path).c_str());
+        return false;
+    }
+    return true;
+}
+
+// finds every package below a directory, by path relative to it
+static bool index_collect_packages(const std::filesystem::path& repository_dir, std::vector<std::string>& packages)
+{
+    std::error_code ec;
+    std::filesystem::recursive_directory_iterator it(repository_dir,
+        std::filesystem::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        dpm_log(LOG_ERROR, ("Could not read directory " + repository_dir.string() + ": " + ec.message()).c_str());
+        return false;
+    }
+
+    for (const auto& entry : it) {
+        if (entry.is_regular_file(ec) && entry.path().extension() == ".dpm") {
+            packages.push_back(entry.path().lexically_relative(repository_dir).string());
+        }
+    }
+    std::sort(packages.begin(), packages.end());
+    return true;
+}
+
+int index_generate(const std::filesystem::path& repository_dir, const std::filesystem::path& index_path, bool update)
+{
+    DpmProfileScope profile("repository_index");
+
+    std::vector<std::string> paths;
+    if (!index_collect_packages(repository_dir, paths)) {
+        return 1;
+    }
+
+    RepositoryIndex previous;
+    if (update && !previous.open(index_path)) {
+        std::error_code ec;
+        if (std::filesystem::exists(index_path, ec)) {
+            dpm_log(LOG_WARN, ("Ignoring unreadable repository index: " + index_path.string()).c_str());
+        }
+    }
+
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Build module functions are not available");
+        return 1;
+    }
+
+    std::vector<RepositoryIndexSource> packages(paths.size());
+    std::vector<char> indexed(paths.size(), 0);
+    std::atomic<size_t> read_count(0);
+    std::atomic<size_t> reused_count(0);
+
+    dpm_parallel_for_each(0, paths.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            std::string full_path = (repository_dir / paths[i]).string();
+
+            struct stat st;
+            if (stat(full_path.c_str(), &st) != 0) {
+                dpm_log(LOG_ERROR, ("Failed to stat package " + full_path + ": " + strerror(errno)).c_str());
+                continue;
+            }
+
+            uint64_t mtime_ns = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000ULL +
+                                static_cast<uint64_t>(st.st_mtim.tv_nsec);
+            RepositoryIndexEntry recorded;
+            if (previous.find(paths[i], recorded) && recorded.file_size == static_cast<uint64_t>(st.st_size) &&
+                recorded.mtime_ns == mtime_ns && recorded.inode == static_cast<uint64_t>(st.st_ino)) {
+                packages[i] = recorded.source();
+                indexed[i] = 1;
+                reused_count++;
+                continue;
+            }
+
+            RepositoryIndexSource& package = packages[i];
+            if (!index_read_package(build_module, full_path, package)) {
+                continue;
+            }
+            package.path = paths[i];
+            package.file_size = static_cast<uint64_t>(st.st_size);
+            package.mtime_ns = mtime_ns;
+            package.inode = static_cast<uint64_t>(st.st_ino);
+            indexed[i] = 1;
+            read_count++;
+        }
+    });
+
+    std::vector<RepositoryIndexSource> records;
+    records.reserve(packages.size());
+    for (size_t i = 0; i < packages.size(); i++) {
+        if (indexed[i]) {
+            records.push_back(std::move(packages[i]));
+        }
+    }
+    size_t failed = paths.size() - records.size();
+    profile.add_files(records.size());
+
+    std::string index;
+    if (!repository_index_build(records, index)) {
+        dpm_log(LOG_ERROR, "Failed to build the repository index");
+        return 1;
+    }
+
+    std::filesystem::path temporary = index_path.string() + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(index.data(), static_cast<std::streamsize>(index.size()));
+        if (!file) {
+            dpm_log(LOG_ERROR, ("Failed to write repository index: " + temporary.string()).c_str());
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(temporary, ec);
+            return 1;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporary, index_path, ec);
+    if (ec) {
+        dpm_log(LOG_ERROR, ("Failed to write repository index " + index_path.string() + ": " + ec.message()).c_str());
+        std::filesystem::remove(temporary, ec);
+        return 1;
+    }
+
+    DPM_CON(LOG_INFO, "Indexed ", records.size(), " packages into ", index_path.string(), " (",
+            read_count.load(), " read, ", reused_count.load(), " unchanged, ", failed, " failed)");
+    return failed == 0 ? 0 : 1;
+}
+
+int index_list(const std::filesystem::path& index_path)
+{
+    RepositoryIndex index;
+    if (!index.open(index_path)) {
+        dpm_log(LOG_ERROR, ("Failed to read repository index: " + index_path.string()).c_str());
+        return 1;
+    }
+
+    for (size_t i = 0; i < index.size(); i++) {
+        RepositoryIndexEntry entry = index.entry(i);
+        std::cout << entry.name << " " << entry.version << " " << entry.architecture << " "
+                  << entry.file_size << " " << entry.package_digest << " " << entry.path << "\n";
+    }
+    std::cout.flush();
+    return 0;
+}
+
+int cmd_index_help(int argc, char** argv) {
+    dpm_con(LOG_INFO, "Usage: dpm info index [options] DIR");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Catalogs the name, version, architecture, digest and sizes of every package");
+    dpm_con(LOG_INFO, "below DIR into a repository index, reading only the metadata of each package.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Options:");
+    dpm_con(LOG_INFO, "  -o, --output FILE      Index file to write (default: DIR/" REPOSITORY_INDEX_FILENAME ")");
+    dpm_con(LOG_INFO, "  -u, --update           Only read packages that are new or changed since the index was written");
+    dpm_con(LOG_INFO, "  -l, --list             Print the packages of an existing index instead of writing one");
+    dpm_con(LOG_INFO, "  -v, --verbose          Enable verbose output");
+    dpm_con(LOG_INFO, "  -h, --help             Display this help message");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Packages are read in parallel on [performance] worker_threads threads.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Examples:");
+    dpm_con(LOG_INFO, "  dpm info index /srv/repository");
+    dpm_con(LOG_INFO, "  dpm info index --update /srv/repository");
+    dpm_con(LOG_INFO, "  dpm info index --list /srv/repository");
+    return 0;
+}
+
+int cmd_index(int argc, char** argv) {
+    std::string repository_dir = "";
+    std::string output = "";
+    bool update = false;
+    bool list = false;
+    bool verbose = false;
+    bool show_help = false;
+
+    // Process command-line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-o" || arg == "--output") {
+            if (i + 1 < argc) {
+                output = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-u" || arg == "--update") {
+            update = true;
+        } else if (arg == "-l" || arg == "--list") {
+            list = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "-h" || arg == "--help" || arg == "help") {
+            show_help = true;
+        } else if (!arg.empty() && arg[0] != '-') {
+            repository_dir = arg;
+        }
+    }
+
+    if (show_help) {
+        return cmd_index_help(argc, argv);
+    }
+
+    if (repository_dir.empty()) {
+        dpm_con(LOG_ERROR, "A repository directory must be specified");
+        return cmd_index_help(argc, argv);
+    }
+
+    if (verbose) {
+        dpm_set_logging_level(LOG_DEBUG);
+    }
+
+    std::filesystem::path index_path = output.empty() ? std::filesystem::path(repository_dir) / REPOSITORY_INDEX_FILENAME
+                                                      : std::filesystem::path(output);
+    if (list) {
+        return index_list(index_path);
+    }
+
+    std::error_code ec;
+    if (!std::filesystem::is_directory(repository_dir, ec)) {
+        dpm_con(LOG_ERROR, ("Not a directory: " + repository_dir).c_str());
+        return 1;
+    }
+
+    return index_generate(repository_dir, index_path, update);
+}
@@ -91,6 +91,8 @@ int cmd_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "  version    - Display DPM version information");
     dpm_con(LOG_INFO, "  system     - Display system information");
     dpm_con(LOG_INFO, "  config     - Display configuration information");
+    dpm_con(LOG_INFO, "  index      - Write a repository index of a directory of packages");
+    dpm_con(LOG_INFO, "  package    - Display the metadata and files of a package");
     dpm_con(LOG_INFO, "  help       - Display this help message");
     dpm_con(LOG_INFO, "");
 
@@ -179,6 +181,12 @@ Command parse_command(const char* cmd_str) {
     else if (strcmp(cmd_str, "config") == 0) {
         return CMD_CONFIG;
     }
+    else if (strcmp(cmd_str, "index") == 0) {
+        return CMD_INDEX;
+    }
+    else if (strcmp(cmd_str, "package") == 0) {
+        return CMD_PACKAGE;
+    }
 
     return CMD_UNKNOWN;
 }
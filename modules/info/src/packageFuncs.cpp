@@ -0,0 +1,294 @@
+/**
+ * @file packageFuncs.cpp
+ * @brief Implementation of the package inspection command of the info module
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "packageFuncs.hpp"
+
+// the fields printed for a package, in this order
+static const char* PACKAGE_INFO_FIELDS[] = {
+    "NAME",
+    "VERSION",
+    "ARCHITECTURE",
+    "AUTHOR",
+    "MAINTAINER",
+    "DESCRIPTION",
+    "LICENSE",
+    "SOURCE",
+    "DEPENDENCIES",
+    "PROVIDES",
+    "REPLACES",
+    "PACKAGE_DIGEST"
+};
+
+// strips the line ending metadata fields are written with
+static std::string package_info_trim(const std::string& value)
+{
+    size_t end = value.find_last_not_of(" \t\r\n");
+    return end == std::string::npos ? std::string() : value.substr(0, end + 1);
+}
+
+// reads the current entry of a metadata iterator whole
+static bool package_info_read_entry(const BuildModuleFunctions* build_module, void* iterator, std::string& value)
+{
+    value.clear();
+    char buffer[16384];
+    while (true) {
+        long long got = build_module->archive_iterator_read(iterator, buffer, sizeof(buffer));
+        if (got < 0) {
+            return false;
+        }
+        if (got == 0) {
+            return true;
+        }
+        value.append(buffer, static_cast<size_t>(got));
+    }
+}
+
+// walks the metadata component once, reading the text fields and, when asked, the manifest or its index
+static bool package_info_walk(const BuildModuleFunctions* build_module, const unsigned char* data, size_t size,
+                              bool read_index, bool read_manifest, PackageInfo& info)
+{
+    void* iterator = build_module->archive_iterator_open_memory(data, size);
+    if (!iterator) {
+        return false;
+    }
+
+    bool result = true;
+    ArchiveIteratorEntry entry;
+    int r = 0;
+    while (result && (r = build_module->archive_iterator_next(iterator, &entry)) == 1) {
+        if ((entry.mode & S_IFMT) != S_IFREG) {
+            continue;
+        }
+
+        // the manifest and larger fields are skipped without being copied out
+        if (strcmp(entry.path, "CONTENTS_MANIFEST_DIGEST") == 0) {
+            info.manifest_size = entry.size;
+            if (read_manifest) {
+                result = package_info_read_entry(build_module, iterator, info.manifest);
+            }
+        } else if (strcmp(entry.path, CONTENTS_MANIFEST_INDEX_FILENAME) == 0) {
+            if (read_index) {
+                result = package_info_read_entry(build_module, iterator, info.manifest_index);
+            }
+        } else if (entry.size <= PACKAGE_INFO_MAX_FIELD_SIZE && !read_manifest) {
+            std::string value;
+            result = package_info_read_entry(build_module, iterator, value);
+            info.fields[entry.path] = package_info_trim(value);
+        }
+    }
+    build_module->archive_iterator_close(iterator);
+    return result && r == 0;
+}
+
+int package_info_read(const BuildModuleFunctions* build_module, const std::string& package_path,
+                      bool read_manifest, PackageInfo& info)
+{
+    info = PackageInfo{};
+
+    void* reader = build_module->package_reader_open(package_path.c_str());
+    if (!reader) {
+        dpm_log(LOG_ERROR, ("Failed to open package: " + package_path).c_str());
+        return 1;
+    }
+
+    // Sizes are taken without reading the members, so a remote package only transfers its metadata
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    info.contents_size = build_module->package_reader_get_member_size(reader, "contents", &size) ? size : 0;
+    info.hooks_size = build_module->package_reader_get_member_size(reader, "hooks", &size) ? size : 0;
+    if (!build_module->package_reader_get_member(reader, "metadata", &data, &size) || size == 0) {
+        dpm_log(LOG_ERROR, ("Failed to load the metadata component of package: " + package_path).c_str());
+        build_module->package_reader_close(reader);
+        return 1;
+    }
+    info.metadata_size = size;
+
+    bool result = package_info_walk(build_module, data, size, read_manifest, false, info);
+
+    // the text manifest is only read when there is no index that describes it
+    if (result && read_manifest) {
+        ManifestIndex index;
+        if (!index.attach(info.manifest_index.data(), info.manifest_index.size()) ||
+            index.manifest_size() != info.manifest_size) {
+            if (!info.manifest_index.empty()) {
+                dpm_log(LOG_WARN, "Ignoring a contents manifest index that does not match the manifest");
+            }
+            info.manifest_index.clear();
+            result = package_info_walk(build_module, data, size, false, true, info);
+        }
+    }
+    build_module->package_reader_close(reader);
+
+    if (!result) {
+        dpm_log(LOG_ERROR, ("Failed to read the metadata component of package: " + package_path).c_str());
+        return 1;
+    }
+    return 0;
+}
+
+// prints the manifest entries under a prefix from the binary index, by binary search
+static size_t package_info_list_index(const std::string& index_data, std::string_view prefix)
+{
+    ManifestIndex index;
+    index.attach(index_data.data(), index_data.size());
+
+    if (!prefix.empty() && prefix[0] == '/') {
+        prefix.remove_prefix(1);
+    }
+
+    size_t listed = 0;
+    char mode[MANIFEST_PERMISSIONS_LENGTH + 1];
+    std::string line;
+    for (size_t position = index.lower_bound(prefix); position < index.size(); position++) {
+        ManifestIndexEntry entry = index.entry(position);
+        if (entry.path.compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        line.clear();
+        manifest_append_line(line, entry.control, entry.checksum(), manifest_format_permissions(entry.mode, mode),
+                             entry.ownership, entry.path);
+        std::cout << line;
+        listed++;
+    }
+    return listed;
+}
+
+// prints the manifest lines under a prefix from the text manifest
+static size_t package_info_list_manifest(const std::string& manifest, std::string prefix)
+{
+    if (prefix.empty() || prefix[0] != '/') {
+        prefix = "/" + prefix;
+    }
+
+    size_t listed = 0;
+    size_t digest_length = 0;
+    std::string_view remaining(manifest);
+    std::string_view line;
+    while (manifest_next_line(remaining, line)) {
+        // control checksum permissions owner:group /path
+        ManifestLine entry;
+        if (!manifest_parse_line(line, entry, digest_length)) {
+            continue;
+        }
+        digest_length = entry.checksum.size();
+        if (entry.path.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        std::cout << line << "\n";
+        listed++;
+    }
+    return listed;
+}
+
+int cmd_package_help(int argc, char** argv) {
+    dpm_con(LOG_INFO, "Usage: dpm info package [options] FILE");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Prints the metadata of a package file and lists the files of its contents manifest,");
+    dpm_con(LOG_INFO, "reading only the metadata component.  FILE may be the http(s):// URL of a package, which");
+    dpm_con(LOG_INFO, "is then read by byte range without transferring its contents.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Options:");
+    dpm_con(LOG_INFO, "  -p, --prefix PATH      Only list files whose path starts with PATH");
+    dpm_con(LOG_INFO, "  -m, --metadata-only    Print the metadata without listing the files");
+    dpm_con(LOG_INFO, "  -v, --verbose          Enable verbose output");
+    dpm_con(LOG_INFO, "  -h, --help             Display this help message");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Files are listed as manifest lines: control, checksum, permissions, owner:group and path.");
+    dpm_con(LOG_INFO, "Run \"dpm verify checksum\" to check that the listing matches the package.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Examples:");
+    dpm_con(LOG_INFO, "  dpm info package mypackage-1.0.x86_64.dpm");
+    dpm_con(LOG_INFO, "  dpm info package --prefix /usr/share/doc mypackage-1.0.x86_64.dpm");
+    return 0;
+}
+
+int cmd_package(int argc, char** argv) {
+    std::string package_path = "";
+    std::string prefix = "";
+    bool metadata_only = false;
+    bool verbose = false;
+    bool show_help = false;
+
+    // Process command-line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-p" || arg == "--prefix") {
+            if (i + 1 < argc) {
+                prefix = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-m" || arg == "--metadata-only") {
+            metadata_only = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "-h" || arg == "--help" || arg == "help") {
+            show_help = true;
+        } else if (!arg.empty() && arg[0] != '-') {
+            package_path = arg;
+        }
+    }
+
+    if (show_help) {
+        return cmd_package_help(argc, argv);
+    }
+
+    if (package_path.empty()) {
+        dpm_con(LOG_ERROR, "A package file must be specified");
+        return cmd_package_help(argc, argv);
+    }
+
+    if (verbose) {
+        dpm_set_logging_level(LOG_DEBUG);
+    }
+
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Build module functions are not available");
+        return 1;
+    }
+
+    PackageInfo info;
+    if (package_info_read(build_module, package_path, !metadata_only, info) != 0) {
+        return 1;
+    }
+
+    std::cout << "Package: " << package_path << "\n";
+    for (const char* name : PACKAGE_INFO_FIELDS) {
+        auto field = info.fields.find(name);
+        if (field == info.fields.end() || field->second.empty()) {
+            continue;
+        }
+
+        // multi-line fields such as DEPENDENCIES are printed below their name
+        if (field->second.find('\n') == std::string::npos) {
+            std::cout << "  " << name << ": " << field->second << "\n";
+        } else {
+            std::cout << "  " << name << ":\n";
+            std::istringstream lines(field->second);
+            std::string line;
+            while (std::getline(lines, line)) {
+                std::cout << "    " << line << "\n";
+            }
+        }
+    }
+    std::cout << "  Components: contents " << info.contents_size << " bytes, hooks " << info.hooks_size
+              << " bytes, metadata " << info.metadata_size << " bytes\n";
+
+    if (!metadata_only) {
+        std::cout << "Contents:\n";
+        size_t listed = info.manifest_index.empty() ? package_info_list_manifest(info.manifest, prefix)
+                                                    : package_info_list_index(info.manifest_index, prefix);
+        DPM_LOG(LOG_DEBUG, "Listed ", listed, " files from the ",
+                info.manifest_index.empty() ? "contents manifest" : "contents manifest index");
+    }
+    std::cout.flush();
+    return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file batch.hpp
+ * @brief Checksum verification of many packages in a single run
+ *
+ * Resolves a directory, glob pattern or list file into a set of package
+ * files and verifies them concurrently on a work-stealing pool, writing one
+ * machine-readable result line per package followed by a summary line.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <glob.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include "worker_pool.hpp"
+
+/**
+ * @brief Outcome of verifying one package in a batch
+ */
+struct BatchResult {
+    std::string package_path;   ///< Package that was verified
+    uintmax_t size;             ///< Size of the package file in bytes
+    std::string status;         ///< "ok", "cached", "failed" or "missing"
+    double seconds;             ///< Wall time spent on the package
+};
+
+/**
+ * @brief Resolves a directory or glob pattern into package files
+ *
+ * A directory is searched recursively for files ending in .dpm; anything
+ * else is expanded as a glob(3) pattern, and a plain path matches itself.
+ *
+ * @param source Directory, glob pattern or path
+ * @param packages Receives the matching package paths, sorted
+ * @return 0 on success, non-zero if the source could not be read
+ */
+int collect_batch_packages(const std::string& source, std::vector<std::string>& packages);
+
+/**
+ * @brief Reads package paths from a list file
+ *
+ * One path per line; blank lines and lines starting with '#' are ignored.
+ * A list file of "-" is read from standard input.
+ *
+ * @param list_path Path of the list file, or "-"
+ * @param packages Receives the listed package paths in order
+ * @return 0 on success, non-zero if the list could not be read
+ */
+int read_batch_list(const std::string& list_path, std::vector<std::string>& packages);
+
+/**
+ * @brief Verifies the checksums of many packages concurrently
+ *
+ * Packages are scheduled largest first on a work-stealing pool, and each
+ * package is hashed on the thread that picked it up.  One JSON object per
+ * package is written in input order, followed by a summary object.
+ *
+ * @param packages Package files to verify
+ * @param worker_count Number of packages to verify at once
+ * @param streaming Use the bounded-memory streaming verification for each package
+ * @param summary_path File to write the results to, or empty for standard output
+ * @return 0 if every package passed, non-zero otherwise
+ */
+int verify_checksums_batch(const std::vector<std::string>& packages, size_t worker_count,
+                           bool streaming, const std::string& summary_path);
@@ -14,18 +14,25 @@
 #include <string>
 #include <filesystem>
 #include <dpmdk/include/CommonModuleAPI.hpp>
-#include "checksum.hpp"
+#include <dpmdk/include/BuildModuleService.hpp>
+#include <dpmdk/include/MetadataModel.hpp>
+#include "contents_manifest.hpp"
+#include "worker_pool.hpp"
 
 /**
  * @brief Verify the CONTENTS_MANIFEST_DIGEST file
  *
- * Compares checksums in manifest with actual file checksums
+ * Compares checksums in manifest with actual file checksums.  Files are
+ * hashed in parallel on the verification worker pool and any errors are
+ * reported in manifest order.
  *
  * @param stage_dir Path to the stage directory
- * @param build_module Handle to the loaded build module
+ * @param build_module Resolved build module function table
+ * @param metadata Metadata of the stage already read by the caller, or NULL to read it here
  * @return 0 on success, non-zero on failure
  */
-int checksum_verify_contents_digest(const std::string& stage_dir, void* build_module);
+int checksum_verify_contents_digest(const std::string& stage_dir, const BuildModuleFunctions* build_module,
+                                    const MetadataModel* metadata = nullptr);
 
 /**
  * @brief Verify the HOOKS_DIGEST file
@@ -33,10 +40,12 @@ int checksum_verify_contents_digest(const std::string& stage_dir, void* build_mo
  * Compares checksums in hooks digest with actual file checksums
  *
  * @param stage_dir Path to the stage directory
- * @param build_module Handle to the loaded build module
+ * @param build_module Resolved build module function table
+ * @param metadata Metadata of the stage already read by the caller, or NULL to read it here
  * @return 0 on success, non-zero on failure
  */
-int checksum_verify_hooks_digest(const std::string& stage_dir, void* build_module);
+int checksum_verify_hooks_digest(const std::string& stage_dir, const BuildModuleFunctions* build_module,
+                                 const MetadataModel* metadata = nullptr);
 
 /**
  * @brief Verify the PACKAGE_DIGEST file
@@ -45,7 +54,27 @@ int checksum_verify_hooks_digest(const std::string& stage_dir, void* build_modul
  * and compares it with the value in PACKAGE_DIGEST
  *
  * @param stage_dir Path to the stage directory
- * @param build_module Handle to the loaded build module
+ * @param build_module Resolved build module function table
+ * @param metadata Metadata of the stage already read by the caller, or NULL to read it here
  * @return 0 on success, non-zero on failure
  */
-int checksum_verify_package_digest(const std::string& stage_dir, void* build_module);
+int checksum_verify_package_digest(const std::string& stage_dir, const BuildModuleFunctions* build_module,
+                                   const MetadataModel* metadata = nullptr);
+
+/**
+ * @brief Verify one byte range of a large file in a stage against its chunk digests
+ *
+ * Only the chunks overlapping the range are read, hashed in parallel on the
+ * verification worker pool.  The recorded chunk digests are first checked
+ * against the recorded Merkle root so a range can only pass if the chunks
+ * belong to the tree that was recorded for the file.
+ *
+ * @param stage_dir Path to the stage directory
+ * @param file_path Path of the file relative to the contents directory, with or without a leading slash
+ * @param offset Offset of the first byte to verify
+ * @param length Number of bytes to verify, 0 for the rest of the file
+ * @param build_module Resolved build module function table
+ * @return 0 on success, non-zero on failure
+ */
+int checksum_verify_contents_range(const std::string& stage_dir, const std::string& file_path,
+                                   uint64_t offset, uint64_t length, const BuildModuleFunctions* build_module);
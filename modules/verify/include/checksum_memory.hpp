@@ -14,37 +14,178 @@
 
 #include <string>
 #include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/BuildModuleService.hpp>
 #include "package_operations.hpp"
 #include <filesystem>
 #include <dlfcn.h>
+#include <vector>
+#include "worker_pool.hpp"
+#include "extraction_pool.hpp"
+#include "contents_manifest.hpp"
+#include <unordered_map>
+#include <atomic>
+
+/**
+ * @brief State shared with the contents archive walk callbacks
+ */
+struct ContentsWalkState {
+    ContentsManifestTable* table;                                   ///< Manifest being verified
+    std::vector<std::string> unexpected;                            ///< Archive entries missing from the manifest
+    WorkerPool* pool;                                               ///< Pool used for parallel hashing, if any
+    bool fail_fast;                                                 ///< Stop the walk at the first failure
+    std::atomic<bool> stopped;                                      ///< Set once a failure has stopped the walk
+    std::vector<std::string> algorithms;                            ///< Primary and extra algorithms when checking several
+    const BuildModuleFunctions* build_module;                       ///< Used by pool jobs to hash entries
+    ExtractionBufferPool* buffers;                                  ///< Buffers entries are decompressed into for the pool
+    std::vector<std::string> duplicates;                            ///< Archive entries whose path was already seen
+};
+
+/**
+ * @brief Compares a stored package digest with one calculated from the digest file checksums
+ *
+ * Used when CONTENTS_MANIFEST_DIGEST and HOOKS_DIGEST have already been
+ * hashed, for example while they were decompressed out of the metadata
+ * component, so the files themselves never need to be copied.
+ *
+ * @param stored_package_digest Contents of the PACKAGE_DIGEST file
+ * @param contents_manifest_checksum Hexadecimal checksum of CONTENTS_MANIFEST_DIGEST
+ * @param hooks_digest_checksum Hexadecimal checksum of HOOKS_DIGEST
+ * @param build_module Resolved build module function table
+ * @return 0 if the digests match, non-zero otherwise
+ */
+int compare_package_digest_checksums(
+    const std::string& stored_package_digest,
+    const std::string& contents_manifest_checksum,
+    const std::string& hooks_digest_checksum,
+    const BuildModuleFunctions* build_module);
+
+/**
+ * @brief Compares a stored package digest with one calculated from the metadata files
+ *
+ * The package digest is the checksum of the concatenated checksums of the
+ * CONTENTS_MANIFEST_DIGEST and HOOKS_DIGEST files.
+ *
+ * @param stored_package_digest Contents of the PACKAGE_DIGEST file
+ * @param contents_manifest Raw bytes of the CONTENTS_MANIFEST_DIGEST file
+ * @param hooks_digest Raw bytes of the HOOKS_DIGEST file
+ * @param build_module Resolved build module function table
+ * @return 0 if the digests match, non-zero otherwise
+ */
+int compare_package_digest(
+    const std::string& stored_package_digest,
+    const std::string& contents_manifest,
+    const std::string& hooks_digest,
+    const BuildModuleFunctions* build_module);
+
+/**
+ * @brief Records the checksum of a contents entry hashed by the build module
+ *
+ * Matches the archive_entry_checksum_callback signature so it can be passed
+ * to any of the build module's hashing walks with a ContentsWalkState.
+ *
+ * @param entry_path Path of the entry relative to the contents directory
+ * @param checksum Hexadecimal checksum of the entry, or NULL for non-regular files
+ * @param user_data Pointer to a ContentsWalkState
+ * @return 0 to continue, non-zero to stop the walk at the first failure in fail-fast mode
+ */
+int contents_walk_checksum_callback(const char* entry_path, const char* checksum, void* user_data);
+
+/**
+ * @brief Records the checksums of a contents entry hashed with several algorithms
+ *
+ * Matches the archive_entry_checksums_callback signature, for the build
+ * module's _multi walks, with a ContentsWalkState whose algorithms were
+ * passed to the walk.
+ *
+ * @param entry_path Path of the entry relative to the contents directory
+ * @param checksums Checksums in the order of the state's algorithms, or NULL for non-regular files
+ * @param checksum_count Number of checksums
+ * @param user_data Pointer to a ContentsWalkState
+ * @return 0 to continue, non-zero to stop the walk at the first failure in fail-fast mode
+ */
+int contents_walk_checksums_callback(const char* entry_path, const char* const* checksums,
+                                     size_t checksum_count, void* user_data);
+
+/**
+ * @brief Prepares a walk state to check the extra digests recorded in a package
+ *
+ * Parses CONTENTS_MANIFEST_EXTRA_DIGESTS, when the package has one, into the
+ * state's table and sets the algorithms every contents entry is hashed with.
+ *
+ * @param state Walk state whose table holds the parsed contents manifest
+ * @param extra_digests Contents of CONTENTS_MANIFEST_EXTRA_DIGESTS, empty if the package has none
+ * @param build_module Resolved build module function table
+ */
+void contents_walk_prepare_extra_digests(ContentsWalkState& state, const std::string& extra_digests,
+                                         const BuildModuleFunctions* build_module);
+
+/**
+ * @brief Reports the outcome of a contents archive walk
+ *
+ * When the walk was stopped early in fail-fast mode, only the failures found
+ * so far are reported; entries that were never reached are not treated as
+ * missing.
+ *
+ * @param state Walk state after the contents archive has been visited
+ * @return 0 if every manifest entry was found and matched, non-zero otherwise
+ */
+int report_contents_walk_results(const ContentsWalkState& state);
+
+/**
+ * @brief Records the checksum of each hook file as the hooks archive is walked
+ *
+ * @param entry_path Path of the entry relative to the hooks directory
+ * @param checksum Hexadecimal checksum of the entry, or NULL for non-regular files
+ * @param user_data Pointer to a map of hook filename to checksum
+ * @return Always 0 so the walk continues
+ */
+int hooks_walk_callback(const char* entry_path, const char* checksum, void* user_data);
+
+/**
+ * @brief Compares each line of HOOKS_DIGEST with the checksums calculated for the hooks
+ *
+ * Stops at the first mismatch in fail-fast mode.
+ *
+ * @param stored_hooks_digest Contents of the HOOKS_DIGEST file
+ * @param calculated_checksums Map of hook filename to calculated checksum
+ * @return 0 if every hook matched, non-zero otherwise
+ */
+int compare_hooks_digest(
+    const std::string& stored_hooks_digest,
+    const std::unordered_map<std::string, std::string>& calculated_checksums);
 
 /**
  * @brief Verifies the package digest from in-memory metadata
  *
- * Calculates the package digest from in-memory CONTENTS_MANIFEST_DIGEST and
- * HOOKS_DIGEST files and compares it to the value in PACKAGE_DIGEST.
+ * Calculates the package digest from the CONTENTS_MANIFEST_DIGEST and
+ * HOOKS_DIGEST files, hashed as they are decompressed out of the metadata
+ * component, and compares it to the value in PACKAGE_DIGEST.
  *
  * @param data Pointer to the metadata file data
  * @param data_size Size of the metadata file data
- * @param build_module Handle to the loaded build module
+ * @param build_module Resolved build module function table
  * @return 0 on successful verification, non-zero on failure
  */
 int checksum_verify_package_digest_memory(
     const unsigned char* data,
     size_t data_size,
-    void* build_module);
+    const BuildModuleFunctions* build_module);
 
 /**
  * @brief Verifies the contents manifest digest from in-memory data
  *
- * Compares checksums in the contents manifest with actual file checksums
- * using in-memory data rather than extracting files to disk.
+ * Parses the contents manifest once into a lookup table, then walks the
+ * contents archive a single time, hashing each entry as it streams past and
+ * checking it against the table.  Manifest entries that never appear in the
+ * archive, and archive entries that are absent from the manifest, are both
+ * reported as errors.  When more than one verification worker is configured,
+ * entries are decompressed on the calling thread and hashed in parallel.
  *
  * @param contents_data Pointer to the contents component data
  * @param contents_data_size Size of the contents component data
  * @param metadata_data Pointer to the metadata component data
  * @param metadata_data_size Size of the metadata component data
- * @param build_module Handle to the loaded build module
+ * @param build_module Resolved build module function table
  * @return 0 on successful verification, non-zero on failure
  */
 int checksum_verify_contents_digest_memory(
@@ -52,19 +193,19 @@ int checksum_verify_contents_digest_memory(
     size_t contents_data_size,
     const unsigned char* metadata_data,
     size_t metadata_data_size,
-    void* build_module);
+    const BuildModuleFunctions* build_module);
 
 /**
  * @brief Verifies the hooks digest from in-memory data
  *
- * Calculates the digest of the hooks archive and compares it with the
- * value stored in HOOKS_DIGEST metadata file.
+ * Hashes each hook file in the hooks archive in a single pass and compares
+ * it with the matching line of the HOOKS_DIGEST metadata file.
  *
  * @param hooks_data Pointer to the hooks component data
  * @param hooks_data_size Size of the hooks component data
  * @param metadata_data Pointer to the metadata component data
  * @param metadata_data_size Size of the metadata component data
- * @param build_module Handle to the loaded build module
+ * @param build_module Resolved build module function table
  * @return 0 on successful verification, non-zero on failure
  */
 int checksum_verify_hooks_digest_memory(
@@ -72,4 +213,4 @@ int checksum_verify_hooks_digest_memory(
     size_t hooks_data_size,
     const unsigned char* metadata_data,
     size_t metadata_data_size,
-    void* build_module);
\ No newline at end of file
+    const BuildModuleFunctions* build_module);
\ No newline at end of file
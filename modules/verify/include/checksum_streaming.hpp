@@ -0,0 +1,98 @@
+/**
+ * @file checksum_streaming.hpp
+ * @brief Bounded-memory package checksum verification functions
+ *
+ * Defines functions for verifying the checksums of a DPM package by streaming
+ * its components straight out of the package file, so that peak memory use
+ * does not grow with the size of the package or of the files it contains.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/BuildModuleService.hpp>
+#include "checksum_memory.hpp"
+#include "contents_manifest.hpp"
+
+/**
+ * @brief Largest metadata file that will be buffered while streaming
+ *
+ * Metadata files are plain text whose size depends on the number of files in
+ * the package rather than their size; anything larger than this is treated as
+ * a corrupt package instead of being read into memory.
+ */
+#define STREAMING_METADATA_MAX_SIZE (64 * 1024 * 1024)
+
+/**
+ * @brief The metadata files needed to verify a package's checksums
+ */
+struct StreamingMetadata {
+    std::string package_digest;     ///< Contents of PACKAGE_DIGEST
+    std::string contents_manifest;  ///< Contents of CONTENTS_MANIFEST_DIGEST
+    std::string hooks_digest;       ///< Contents of HOOKS_DIGEST
+    std::string extra_digests;      ///< Contents of CONTENTS_MANIFEST_EXTRA_DIGESTS, empty if the package has none
+    std::string manifest_index;     ///< Contents of CONTENTS_MANIFEST_INDEX, empty if the package has none
+    bool has_package_digest;        ///< Set once PACKAGE_DIGEST has been read
+    bool has_contents_manifest;     ///< Set once CONTENTS_MANIFEST_DIGEST has been read
+    bool has_hooks_digest;          ///< Set once HOOKS_DIGEST has been read
+};
+
+/**
+ * @brief Reads the digest files from a package's metadata component
+ *
+ * @param package_path Path to the package file
+ * @param metadata Receives the digest files
+ * @param build_module Resolved build module function table
+ * @return 0 on success, non-zero if the component or any digest file could not be read
+ */
+int read_streaming_metadata(
+    const std::string& package_path,
+    StreamingMetadata& metadata,
+    const BuildModuleFunctions* build_module);
+
+/**
+ * @brief Verifies the package digest from streamed metadata
+ *
+ * @param metadata Digest files read by read_streaming_metadata
+ * @param build_module Resolved build module function table
+ * @return 0 on successful verification, non-zero on failure
+ */
+int checksum_verify_package_digest_streaming(
+    const StreamingMetadata& metadata,
+    const BuildModuleFunctions* build_module);
+
+/**
+ * @brief Verifies the contents manifest digest by streaming the contents component
+ *
+ * Every file is hashed inline as it is decompressed through a fixed-size
+ * buffer, so no file is ever held in memory.  Results are reported exactly as
+ * by checksum_verify_contents_digest_memory.
+ *
+ * @param package_path Path to the package file
+ * @param metadata Digest files read by read_streaming_metadata
+ * @param build_module Resolved build module function table
+ * @return 0 on successful verification, non-zero on failure
+ */
+int checksum_verify_contents_digest_streaming(
+    const std::string& package_path,
+    const StreamingMetadata& metadata,
+    const BuildModuleFunctions* build_module);
+
+/**
+ * @brief Verifies the hooks digest by streaming the hooks component
+ *
+ * @param package_path Path to the package file
+ * @param metadata Digest files read by read_streaming_metadata
+ * @param build_module Resolved build module function table
+ * @return 0 on successful verification, non-zero on failure
+ */
+int checksum_verify_hooks_digest_streaming(
+    const std::string& package_path,
+    const StreamingMetadata& metadata,
+    const BuildModuleFunctions* build_module);
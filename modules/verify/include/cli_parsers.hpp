@@ -11,7 +11,9 @@ enum Command {
     CMD_HELP,        /**< Display help information */
     CMD_CHECKSUM,    /**< Verify package checksums */
     CMD_SIGNATURE,   /**< Verify package signatures */
-    CMD_CHECK        /**< Check build module integration */
+    CMD_CHECK,       /**< Check build module integration */
+    CMD_CACHE_PRUNE, /**< Prune the verification cache */
+    CMD_RANGE        /**< Verify a byte range of a chunked file */
 };
 
 /**
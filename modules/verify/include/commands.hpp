@@ -18,8 +18,15 @@
 #include <dlfcn.h>
 #include <sys/stat.h>
 #include <filesystem>
+#include <chrono>
+#include "checksum.hpp"
 #include "checksum_memory.hpp"
+#include "checksum_streaming.hpp"
+#include "verify_cache.hpp"
+#include "batch.hpp"
 #include "package_operations.hpp"
+#include <dpmdk/include/BuildModuleService.hpp>
+#include "worker_pool.hpp"
 
 /**
  * @brief Handler for the checksum command
@@ -111,16 +118,6 @@ int cmd_check_help(int argc, char** argv);
  */
 int cmd_unknown(const char* command, int argc, char** argv);
 
-/**
- * @brief Helper function to check and load the build module
- *
- * Checks if the build module exists and can be loaded.
- *
- * @param module_handle Reference to a void pointer that will hold the module handle
- * @return 0 on success, non-zero on failure
- */
-int check_and_load_build_module(void*& module_handle);
-
 /**
  * @brief Verifies checksums for a package file
  *
@@ -146,10 +143,11 @@ int verify_checksums_stage(const std::string& stage_dir);
  *
  * Checks the signatures of a package file.
  *
- * @param package_path Path to the package file
+ * @param package_path Path or http(s):// URL of the package file
+ * @param metadata_only Whether to check only the signature of the metadata component
  * @return 0 on success, non-zero on failure
  */
-int verify_signature_package(const std::string& package_path);
+int verify_signature_package(const std::string& package_path, bool metadata_only);
 
 /**
  * @brief Verifies signatures for a package stage directory
@@ -161,6 +159,64 @@ int verify_signature_package(const std::string& package_path);
  */
 int verify_signature_stage(const std::string& stage_dir);
 
+/**
+ * @brief Handler for the cache-prune command
+ *
+ * Removes stale entries from the verification cache.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_cache_prune(int argc, char** argv);
+
+/**
+ * @brief Help handler for the cache-prune command
+ *
+ * Displays help information for the cache-prune command.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_cache_prune_help(int argc, char** argv);
+
+/**
+ * @brief Handler for the range command
+ *
+ * Verifies one byte range of a large file in a stage against its chunk digests.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_range(int argc, char** argv);
+
+/**
+ * @brief Help handler for the range command
+ *
+ * Displays help information for the range command.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of arguments
+ * @return 0 on success, non-zero on failure
+ */
+int cmd_range_help(int argc, char** argv);
+
+/**
+ * @brief Verifies checksums of a package file, consulting the verification cache
+ *
+ * When the cache is enabled and holds an entry for the package with the same
+ * file identity and PACKAGE_DIGEST, verification is skipped.  Otherwise the
+ * package is verified and, on success, recorded in the cache.
+ *
+ * @param package_path Path to the package file
+ * @param streaming Use the bounded-memory streaming verification
+ * @param cache_hit Optional, set to true when the result came from the cache
+ * @return 0 on success, non-zero on failure
+ */
+int verify_checksums_package_cached(const std::string& package_path, bool streaming, bool* cache_hit = nullptr);
+
 /**
  * @brief Verifies checksums of a package file in memory
  *
@@ -173,13 +229,14 @@ int verify_signature_stage(const std::string& stage_dir);
 int verify_checksums_package_memory(const std::string& package_path);
 
 /**
- * @brief Converts binary data to a C++ string
+ * @brief Verifies checksums of a package file with bounded memory use
  *
- * Takes a buffer of binary data and its size, creates a properly
- * null-terminated string, and returns it as an std::string.
+ * Streams each component out of the package file through a fixed-size buffer
+ * and hashes entries as they are decompressed, so peak memory stays small no
+ * matter how large the package is.  Passes and fails on exactly the same
+ * packages as verify_checksums_package_memory.
  *
- * @param data Pointer to the binary data
- * @param data_size Size of the binary data
- * @return std::string containing the data, or empty string on error
+ * @param package_path Path to the package file
+ * @return 0 on success, non-zero on failure
  */
-std::string binary_to_string(const unsigned char* data, size_t data_size);
\ No newline at end of file
+int verify_checksums_package_streaming(const std::string& package_path);
\ No newline at end of file
@@ -0,0 +1,198 @@
+/**
+ * @file contents_manifest.hpp
+ * @brief Parsed representation of CONTENTS_MANIFEST_DIGEST used during verification
+ *
+ * Defines a lookup table built from the contents manifest so that files can be
+ * matched against their recorded checksums in constant time, along with
+ * deterministic reporting of the verification results.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/ManifestIndex.hpp>
+#include <dpmdk/include/ManifestCodec.hpp>
+
+/**
+ * @brief A single parsed line of CONTENTS_MANIFEST_DIGEST
+ */
+struct ContentsManifestEntry {
+    std::string path;               ///< Path relative to the contents directory
+    std::string expected_checksum;  ///< Checksum recorded in the manifest
+    int line_number;                ///< Line in the manifest, used for reporting
+    bool seen;                      ///< Set once the entry has been found
+    bool failed;                    ///< Set if the entry could not be hashed
+    bool no_data;                   ///< Set if the archive entry is a symlink, device or fifo, with no data to hash
+    std::string actual_checksum;    ///< Checksum computed during verification, empty if not hashed
+    std::vector<std::string> expected_extra;    ///< Recorded digests of the table's extra algorithms
+    std::vector<std::string> actual_extra;      ///< Digests of the extra algorithms computed during verification
+};
+
+/**
+ * @brief Parsed contents manifest with constant-time lookup by path
+ */
+struct ContentsManifestTable {
+    std::vector<ContentsManifestEntry> entries;             ///< Entries in manifest order
+    std::unordered_map<std::string, size_t> index;          ///< Path to position in entries
+    std::vector<std::string> extra_algorithms;              ///< Additional algorithms to verify, see parse_contents_extra_digests
+};
+
+/**
+ * @brief Name of the metadata file holding contents digests for additional algorithms
+ */
+#define CONTENTS_EXTRA_DIGESTS_FILENAME "CONTENTS_MANIFEST_EXTRA_DIGESTS"
+
+/**
+ * @brief Name of the metadata file holding the chunk digests of large contents files
+ */
+#define CONTENTS_CHUNKS_FILENAME "CONTENTS_MANIFEST_CHUNKS"
+
+/**
+ * @brief Chunk digests recorded for a single large contents file
+ */
+struct ContentsChunkRecord {
+    std::string path;                           ///< Path relative to the contents directory
+    uint64_t file_size;                         ///< Size of the file when it was chunked
+    std::string expected_root;                  ///< Recorded Merkle root over the chunk digests
+    std::vector<std::string> expected_chunks;   ///< Recorded digest of every chunk, in file order
+    std::vector<std::string> actual_chunks;     ///< Chunk digests computed during verification
+};
+
+/**
+ * @brief Parsed CONTENTS_MANIFEST_CHUNKS with constant-time lookup by path
+ */
+struct ContentsChunkTable {
+    std::string algorithm;                              ///< Algorithm of every digest in the file
+    uint64_t chunk_size = 0;                            ///< Size of every chunk but the last, in bytes
+    std::vector<ContentsChunkRecord> records;           ///< Records in file order
+    std::unordered_map<std::string, size_t> index;      ///< Path to position in records
+};
+
+/**
+ * @brief Parses CONTENTS_MANIFEST_DIGEST into a path lookup table
+ *
+ * Each well-formed line is recorded under its path (without the leading slash)
+ * so that archive entries can be matched against it in constant time.  The order
+ * of the manifest is preserved in the entries vector for deterministic reporting.
+ *
+ * @param manifest_str Contents of the CONTENTS_MANIFEST_DIGEST file
+ * @param table Lookup table to populate
+ * @return Number of malformed lines that were skipped
+ */
+int parse_contents_manifest(const std::string& manifest_str, ContentsManifestTable& table);
+
+/**
+ * @brief Fills a manifest lookup table, from the binary manifest index when it can
+ *
+ * The index is only used when it was built from exactly this manifest,
+ * which is checked against the size and checksum it records; otherwise,
+ * or without an index, the text is parsed by parse_contents_manifest.
+ * Either way the table is the same.
+ *
+ * @param manifest_str Contents of the CONTENTS_MANIFEST_DIGEST file
+ * @param index_data Contents of the CONTENTS_MANIFEST_INDEX file, or NULL if there is none
+ * @param generate_string_checksum Checksums a string with the algorithm of the manifest
+ * @param table Lookup table to populate
+ * @return Number of malformed lines that were skipped
+ */
+int load_contents_manifest(const std::string& manifest_str, const std::string* index_data,
+                           std::string (*generate_string_checksum)(const std::string&),
+                           ContentsManifestTable& table);
+
+/**
+ * @brief Adds the digests of additional algorithms to a parsed manifest table
+ *
+ * Packages built with several checksum algorithms carry the digests of all
+ * but the first in CONTENTS_MANIFEST_EXTRA_DIGESTS.  Every algorithm listed
+ * there that this system supports is added to the table's extra_algorithms
+ * and its digests to the matching entries; unsupported algorithms are
+ * skipped.
+ *
+ * @param extra_digests_str Contents of the CONTENTS_MANIFEST_EXTRA_DIGESTS file
+ * @param table Table already populated by parse_contents_manifest
+ * @param algorithm_supported Returns whether an algorithm can be used on this system
+ * @return Number of malformed lines that were skipped
+ */
+int parse_contents_extra_digests(const std::string& extra_digests_str, ContentsManifestTable& table,
+                                 bool (*algorithm_supported)(const std::string&));
+
+/**
+ * @brief Parses CONTENTS_MANIFEST_CHUNKS into a path lookup table
+ *
+ * The file is written by the build module for files of at least its
+ * configured minimum size; see chunk_manifest.hpp there for the format and
+ * the construction of the Merkle tree.
+ *
+ * @param chunks_str Contents of the CONTENTS_MANIFEST_CHUNKS file
+ * @param table Lookup table to populate
+ * @return true if the file was well-formed, false otherwise (the table is left empty)
+ */
+bool parse_contents_chunks(const std::string& chunks_str, ContentsChunkTable& table);
+
+/**
+ * @brief Gets the algorithms each contents file is hashed with during verification
+ *
+ * @param table Parsed manifest table
+ * @param primary_algorithm Algorithm of the checksums in CONTENTS_MANIFEST_DIGEST
+ * @return The primary algorithm followed by the table's extra algorithms
+ */
+std::vector<std::string> contents_manifest_algorithms(const ContentsManifestTable& table,
+                                                      const std::string& primary_algorithm);
+
+/**
+ * @brief Checks whether a hashed entry matched every digest recorded for it
+ *
+ * @param table Table the entry belongs to
+ * @param entry Entry with its actual checksums filled in
+ * @return true if the entry matched, false on a mismatch, a hashing failure, or an entry
+ *         without data where the manifest records a checksum
+ */
+bool contents_manifest_entry_matches(const ContentsManifestTable& table, const ContentsManifestEntry& entry);
+
+/**
+ * @brief Reports the outcome of a contents verification in manifest order
+ *
+ * Logs missing files, hashing failures and checksum mismatches in the order
+ * the entries appear in the manifest, regardless of the order in which they
+ * were processed.  Digests of the table's extra algorithms are checked
+ * along with the primary checksum.
+ *
+ * @param table Manifest table populated during verification
+ * @param missing_message Text used for entries that were never seen
+ * @param report_missing False when verification stopped early, so unseen entries are not reported as missing
+ * @return Number of errors reported
+ */
+int report_contents_manifest_results(const ContentsManifestTable& table, const std::string& missing_message,
+                                     bool report_missing = true);
+
+/**
+ * @brief Selects between fail-fast and full-report verification
+ *
+ * Used by the --fail-fast and --full-report command line options.  A
+ * negative value clears the override so the configured value is used again.
+ *
+ * @param fail_fast 1 to stop at the first failure, 0 to report every failure
+ */
+void set_verify_fail_fast(int fail_fast);
+
+/**
+ * @brief Checks whether verification should stop at the first failure
+ *
+ * Resolves, in order of precedence, the --fail-fast/--full-report override
+ * and the "fail_fast" key in the [verify] configuration section.  Full-report
+ * is the default.
+ *
+ * @return true to stop at the first failure, false to collect every failure
+ */
+bool verify_fail_fast();
@@ -0,0 +1,88 @@
+/**
+ * @file extraction_pool.hpp
+ * @brief Size-class buffer pool for the entries extracted while verifying a package
+ *
+ * Verifying a package with many small files used to malloc a buffer for
+ * every extracted entry and free it as soon as the entry was hashed.  A
+ * pool lives for one verification instead: entries are decompressed into
+ * buffers rounded up to a power of two, a buffer handed back is reused for
+ * the next entry of its size class, and every buffer is released at once
+ * when the pool is destroyed.  Entries larger than the biggest class are
+ * allocated and freed on their own so that a single large file is not kept
+ * for the rest of the package, and a buffer that is never handed back is
+ * still freed with the pool.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+
+/**
+ * @brief Size of the smallest buffer the pool hands out, in bytes
+ */
+#define EXTRACTION_POOL_MIN_CLASS (4 * 1024)
+
+/**
+ * @brief Size of the largest buffer the pool keeps for reuse, in bytes
+ */
+#define EXTRACTION_POOL_MAX_CLASS (16 * 1024 * 1024)
+
+/**
+ * @brief Pool of extraction buffers released all at once
+ *
+ * Buffers may be acquired and released from any thread.
+ */
+class ExtractionBufferPool {
+public:
+    ExtractionBufferPool();
+
+    /**
+     * @brief Frees every buffer the pool has allocated
+     *
+     * Buffers still acquired must no longer be in use.
+     */
+    ~ExtractionBufferPool();
+
+    ExtractionBufferPool(const ExtractionBufferPool&) = delete;
+    ExtractionBufferPool& operator=(const ExtractionBufferPool&) = delete;
+
+    /**
+     * @brief Gets a buffer of at least the given size
+     *
+     * @param size Number of bytes needed
+     * @return The buffer, or NULL if it could not be allocated
+     */
+    unsigned char* acquire(size_t size);
+
+    /**
+     * @brief Hands a buffer back for reuse
+     *
+     * @param buffer Buffer returned by acquire, may be NULL
+     * @param size Size the buffer was acquired with
+     */
+    void release(unsigned char* buffer, size_t size);
+
+    /**
+     * @brief ArchiveEntryAllocator drawing from a pool
+     *
+     * @param size Number of bytes needed
+     * @param pool Pointer to the ExtractionBufferPool
+     * @return The buffer, or NULL if it could not be allocated
+     */
+    static unsigned char* allocate(size_t size, void* pool);
+
+private:
+    static size_t size_class(size_t size);
+
+    std::mutex _mutex;
+    std::vector<std::vector<unsigned char*>> _free;     ///< Released buffers by size class
+    std::vector<unsigned char*> _owned;                 ///< Every pooled buffer, freed with the pool
+};
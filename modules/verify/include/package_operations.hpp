@@ -13,14 +13,17 @@
 
 #include <string>
 #include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/BuildModuleService.hpp>
 #include "commands.hpp"
 #include <filesystem>
+#include <cstring>
 
 /**
  * @brief Extracts a component from a package file
  *
  * Loads a component (metadata, contents, hooks, signatures) from a package file
- * by calling into the build module's get_file_from_package_file function.
+ * by calling into the build module's get_file_from_package_file function through
+ * the shared build module service.
  *
  * @param package_path Path to the package file
  * @param component_name Name of the component to extract (metadata, contents, hooks, signatures)
@@ -34,20 +37,19 @@ int get_component_from_package(const std::string& package_path,
                               size_t* data_size);
 
 /**
- * @brief Extracts a file from a component archive
+ * @brief Extracts a text file from a component archive
  *
  * Extracts a specific file from a component archive that has already been loaded into memory.
- * Uses the build module's get_file_from_memory_loaded_archive function.
+ * Uses the build module's get_file_from_memory_loaded_archive_into function to decompress
+ * the file directly into the string, so it is neither allocated nor copied separately.
  *
  * @param component_data Pointer to the component archive data in memory
  * @param component_size Size of the component archive in memory
  * @param filename Name of the file to extract from the component
- * @param data Pointer to a pointer that will be populated with the file data
- * @param data_size Pointer to a size_t that will be populated with the size of the file data
- * @return 0 on success, non-zero on failure
+ * @param text Receives the file, up to its first NUL byte
+ * @return 0 on success, non-zero on failure or if the file is empty
  */
 int get_file_from_component(const unsigned char* component_data,
                            size_t component_size,
                            const std::string& filename,
-                           unsigned char** data,
-                           size_t* data_size);
+                           std::string& text);
@@ -0,0 +1,52 @@
+/**
+ * @file signature_memory.hpp
+ * @brief In-memory, concurrent verification of component signatures
+ *
+ * Checks the detached signatures of the contents, hooks and metadata
+ * components against buffers already in memory, one GPGME context per
+ * component and all three at once.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/BuildModuleService.hpp>
+#include "worker_pool.hpp"
+
+/**
+ * @brief Size of the buffer receiving a signer fingerprint
+ */
+#define SIGNER_FINGERPRINT_SIZE 128
+
+/**
+ * @brief A component and its detached signature, and the outcome of checking it
+ */
+struct ComponentSignatureCheck {
+    std::string component;                  ///< Component name, e.g. "contents"
+    const unsigned char* data;              ///< Component archive data
+    size_t data_size;                       ///< Size of the component archive data
+    const unsigned char* signature;         ///< Detached signature data
+    size_t signature_size;                  ///< Size of the signature data
+    int result;                             ///< 0 if the signature is good, set by verification
+    char signer[SIGNER_FINGERPRINT_SIZE];   ///< Fingerprint of the signing key, set by verification
+};
+
+/**
+ * @brief Verifies every component signature concurrently
+ *
+ * Each check runs on its own worker with its own GPGME context; results are
+ * reported afterwards in the order the checks were given.
+ *
+ * @param checks Components to verify, updated with their results
+ * @param build_module Resolved build module function table
+ * @return 0 if every signature is good, non-zero otherwise
+ */
+int verify_component_signatures(std::vector<ComponentSignatureCheck>& checks,
+                                const BuildModuleFunctions* build_module);
@@ -17,6 +17,8 @@
 #include <dpmdk/include/CommonModuleAPI.hpp>
 #include "commands.hpp"
 #include "checksum.hpp"
+#include "signature_memory.hpp"
+#include <fstream>
 
 /**
  * @brief Verifies checksums for a package file
@@ -41,17 +43,23 @@ int verify_checksums_stage(const std::string& stage_dir);
 /**
  * @brief Verifies signatures for a package file
  *
- * Checks the signatures of a package file.
+ * Maps the package and checks the detached signature of each component
+ * against the mapped component data, verifying all three concurrently.
+ * A remote package is read by byte range, so with metadata_only nothing
+ * but its metadata is transferred.
  *
- * @param package_path Path to the package file
+ * @param package_path Path or http(s):// URL of the package file
+ * @param metadata_only Whether to check only the signature of the metadata component
  * @return 0 on success, non-zero on failure
  */
-int verify_signature_package(const std::string& package_path);
+int verify_signature_package(const std::string& package_path, bool metadata_only);
 
 /**
  * @brief Verifies signatures for a package stage directory
  *
- * Checks the signatures of a package stage directory.
+ * Reads the sealed components and their signatures into memory and checks
+ * all three concurrently.  The components must already be sealed, since that
+ * is the form in which they were signed.
  *
  * @param stage_dir Path to the stage directory
  * @return 0 on success, non-zero on failure
@@ -0,0 +1,120 @@
+/**
+ * @file verify_cache.hpp
+ * @brief Persistent cache of successful package verifications
+ *
+ * Records packages that have passed checksum verification, keyed by the
+ * identity of the package file (device, inode, size and modification time)
+ * together with its PACKAGE_DIGEST and the hash algorithm in use, so that an
+ * unchanged package can be accepted again with a stat and a lookup instead
+ * of a full walk of its contents.  Only successful results are cached.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <ctime>
+#include <thread>
+#include <functional>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+#include <dpmdk/include/BuildModuleService.hpp>
+
+/**
+ * @brief Default location of the verification cache
+ */
+#define VERIFY_CACHE_DEFAULT_DIR "/var/cache/dpm/verify"
+
+/**
+ * @brief Identity of a package file at the time it was verified
+ */
+struct VerifyCacheKey {
+    std::string package_path;       ///< Absolute path of the package file
+    unsigned long long device;      ///< Device holding the package file
+    unsigned long long inode;       ///< Inode of the package file
+    long long size;                 ///< Size of the package file in bytes
+    long long mtime_sec;            ///< Modification time, seconds
+    long long mtime_nsec;           ///< Modification time, nanoseconds
+    std::string algorithm;          ///< Hash algorithm the package was verified with
+    std::string package_digest;     ///< PACKAGE_DIGEST recorded in the package
+};
+
+/**
+ * @brief Disables the cache for this process regardless of configuration
+ *
+ * Used by the --no-cache command line option.
+ *
+ * @param disabled true to bypass the cache entirely
+ */
+void set_verify_cache_disabled(bool disabled);
+
+/**
+ * @brief Checks whether verification results should be cached
+ *
+ * The cache is opt-in through the [verify] cache configuration key and can be
+ * bypassed for a single run with set_verify_cache_disabled.
+ *
+ * @return true if the cache should be consulted and updated
+ */
+bool verify_cache_enabled();
+
+/**
+ * @brief Gets the directory holding cache entries
+ *
+ * @return The [verify] cache_dir configuration value, or VERIFY_CACHE_DEFAULT_DIR
+ */
+std::string verify_cache_dir();
+
+/**
+ * @brief Builds the cache key for a package file
+ *
+ * Stats the package and reads PACKAGE_DIGEST from its metadata component; the
+ * rest of the package is not touched.
+ *
+ * @param package_path Path to the package file
+ * @param key Receives the package identity
+ * @param build_module Resolved build module function table
+ * @return true if a key could be built, false otherwise
+ */
+bool verify_cache_make_key(const std::string& package_path, VerifyCacheKey& key,
+                           const BuildModuleFunctions* build_module);
+
+/**
+ * @brief Looks for a previous successful verification of a package
+ *
+ * @param key Identity of the package as it is now
+ * @return true if an entry with an identical key exists
+ */
+bool verify_cache_lookup(const VerifyCacheKey& key);
+
+/**
+ * @brief Records a successful verification of a package
+ *
+ * Failures to write the cache are logged and otherwise ignored; the cache is
+ * an optimisation and never affects the verification result.
+ *
+ * @param key Identity of the package that was verified
+ */
+void verify_cache_store(const VerifyCacheKey& key);
+
+/**
+ * @brief Removes cache entries that can no longer produce a hit
+ *
+ * An entry is stale when its package no longer exists or no longer has the
+ * recorded identity.  Entries older than max_age_days are also removed when a
+ * maximum age is given.
+ *
+ * @param remove_all Remove every entry regardless of whether it is stale
+ * @param max_age_days Remove entries older than this many days, or 0 for no age limit
+ * @return Number of entries removed, or -1 if the cache directory could not be read
+ */
+int verify_cache_prune(bool remove_all, int max_age_days);
@@ -0,0 +1,160 @@
+/**
+ * @file worker_pool.hpp
+ * @brief Fixed-size worker pool used for parallel checksum verification
+ *
+ * Provides a small thread pool with a bounded job queue so that a single
+ * producer (reading files or decompressing an archive) can feed many hashing
+ * workers without buffering an unbounded amount of data.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dpmdk/include/CommonModuleAPI.hpp>
+
+/**
+ * @brief Fixed-size pool of worker threads with a bounded job queue
+ *
+ * Jobs should record their results and leave reporting to the thread that
+ * submitted them, so that problems are reported in a deterministic order.
+ */
+class WorkerPool {
+public:
+    /**
+     * @brief Starts the worker threads
+     *
+     * @param worker_count Number of worker threads to start (at least one)
+     * @param max_queued Maximum number of pending jobs before submit blocks
+     */
+    WorkerPool(size_t worker_count, size_t max_queued);
+
+    /**
+     * @brief Waits for outstanding jobs and joins the worker threads
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Queues a job, blocking while the queue is full
+     *
+     * @param job Work to run on one of the worker threads
+     */
+    void submit(std::function<void()> job);
+
+    /**
+     * @brief Blocks until every submitted job has finished
+     */
+    void wait();
+
+    /**
+     * @brief Discards queued jobs and ignores any submitted afterwards
+     *
+     * Jobs that are already running are left to finish.  Safe to call from
+     * inside a job.
+     */
+    void cancel();
+
+    /**
+     * @brief Checks whether cancel has been called
+     *
+     * @return true once the pool has been cancelled
+     */
+    bool cancelled();
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _job_available;
+    std::condition_variable _space_available;
+    std::condition_variable _all_done;
+    size_t _max_queued;
+    size_t _active;
+    bool _stopping;
+    bool _cancelled;
+};
+
+/**
+ * @brief Pool that runs a known set of jobs with per-worker queues and work stealing
+ *
+ * Jobs are dealt out round-robin, in the order given, to one queue per worker.
+ * Each worker runs jobs from the front of its own queue and, once that is
+ * empty, steals from the back of another worker's queue, so a worker stuck on
+ * one large job never leaves the rest of its share waiting.  Giving the jobs
+ * largest first keeps the tail of the run short.  The workers run as tasks
+ * on the DPM core's shared worker pool rather than on threads of their own,
+ * so at most as many run at once as that pool has threads.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @brief Prepares a pool of the given size
+     *
+     * @param worker_count Number of workers to use (at least one)
+     */
+    explicit WorkStealingPool(size_t worker_count);
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief Runs every job and blocks until all of them have finished
+     *
+     * @param jobs Work to run, ideally ordered from most to least expensive
+     */
+    void run(std::vector<std::function<void()>>& jobs);
+
+private:
+    /**
+     * @brief A worker's own queue of jobs
+     */
+    struct WorkerQueue {
+        std::deque<std::function<void()>*> jobs;
+        std::mutex mutex;
+    };
+
+    static void worker_task(void* context);
+    void worker_loop(size_t worker_index);
+    std::function<void()>* take_job(size_t worker_index);
+
+    size_t _worker_count;
+    std::vector<std::unique_ptr<WorkerQueue>> _queues;
+};
+
+/**
+ * @brief Overrides the number of verification worker threads
+ *
+ * Used by the --jobs command line option.  A value of 0 clears the override
+ * so the configured or detected value is used again.
+ *
+ * @param worker_count Number of workers to use
+ */
+void set_verify_worker_count(int worker_count);
+
+/**
+ * @brief Gets the number of worker threads to use for verification
+ *
+ * Resolves, in order of precedence, the --jobs override, the "threads" key
+ * in the [verify] configuration section, and the number of hardware threads.
+ *
+ * @return Number of workers, always at least 1
+ */
+size_t get_verify_worker_count();
@@ -0,0 +1,236 @@
+/**
+ * @file batch.cpp
+ * @brief Implementation of batch checksum verification
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "batch.hpp"
+#include "commands.hpp"
+
+/**
+ * @brief Escapes a string for use inside a JSON string literal
+ *
+ * @param value Raw string
+ * @return Escaped string, without surrounding quotes
+ */
+static std::string json_escape(const std::string& value)
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    escaped += buffer;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+
+    return escaped;
+}
+
+int collect_batch_packages(const std::string& source, std::vector<std::string>& packages)
+{
+    std::error_code ec;
+
+    if (std::filesystem::is_directory(source, ec)) {
+        std::filesystem::recursive_directory_iterator it(source,
+            std::filesystem::directory_options::skip_permission_denied, ec);
+        if (ec) {
+            dpm_log(LOG_ERROR, ("Could not read directory " + source + ": " + ec.message()).c_str());
+            return 1;
+        }
+
+        std::vector<std::string> found;
+        for (const auto& entry : it) {
+            if (entry.is_regular_file(ec) && entry.path().extension() == ".dpm") {
+                found.push_back(entry.path().string());
+            }
+        }
+
+        std::sort(found.begin(), found.end());
+        packages.insert(packages.end(), found.begin(), found.end());
+        return 0;
+    }
+
+    glob_t matches;
+    int result = glob(source.c_str(), 0, nullptr, &matches);
+    if (result == GLOB_NOMATCH) {
+        globfree(&matches);
+        dpm_log(LOG_ERROR, ("No packages match: " + source).c_str());
+        return 1;
+    }
+    if (result != 0) {
+        globfree(&matches);
+        dpm_log(LOG_ERROR, ("Could not expand package pattern: " + source).c_str());
+        return 1;
+    }
+
+    // glob(3) already returns its matches sorted
+    for (size_t i = 0; i < matches.gl_pathc; i++) {
+        packages.push_back(matches.gl_pathv[i]);
+    }
+    globfree(&matches);
+
+    return 0;
+}
+
+int read_batch_list(const std::string& list_path, std::vector<std::string>& packages)
+{
+    std::ifstream list_file;
+    std::istream* input = &std::cin;
+
+    if (list_path != "-") {
+        list_file.open(list_path);
+        if (!list_file.is_open()) {
+            dpm_log(LOG_ERROR, ("Could not open package list: " + list_path).c_str());
+            return 1;
+        }
+        input = &list_file;
+    }
+
+    std::string line;
+    while (std::getline(*input, line)) {
+        // Trim surrounding whitespace
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos) {
+            continue;
+        }
+        size_t end = line.find_last_not_of(" \t\r");
+        line = line.substr(start, end - start + 1);
+
+        if (line[0] == '#') {
+            continue;
+        }
+
+        packages.push_back(line);
+    }
+
+    return 0;
+}
+
+int verify_checksums_batch(const std::vector<std::string>& packages, size_t worker_count,
+                           bool streaming, const std::string& summary_path)
+{
+    if (packages.empty()) {
+        dpm_log(LOG_ERROR, "No packages to verify");
+        return 1;
+    }
+
+    std::ofstream summary_file;
+    std::ostream* summary = &std::cout;
+    if (!summary_path.empty()) {
+        summary_file.open(summary_path, std::ios::trunc);
+        if (!summary_file.is_open()) {
+            dpm_log(LOG_ERROR, ("Could not open summary file for writing: " + summary_path).c_str());
+            return 1;
+        }
+        summary = &summary_file;
+    }
+
+    // Load the build module up front rather than racing to do it from every worker
+    if (!dpm_build_module()) {
+        dpm_log(LOG_ERROR, "Failed to load build module");
+        return 1;
+    }
+
+    std::vector<BatchResult> results(packages.size());
+    for (size_t i = 0; i < packages.size(); i++) {
+        std::error_code ec;
+        results[i].package_path = packages[i];
+        results[i].size = std::filesystem::file_size(packages[i], ec);
+        if (ec) {
+            results[i].size = 0;
+        }
+        results[i].seconds = 0;
+    }
+
+    // Largest packages first so no worker is left with a big one at the end
+    std::vector<size_t> order(packages.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&results](size_t a, size_t b) {
+        return results[a].size > results[b].size;
+    });
+
+    std::vector<std::function<void()>> jobs;
+    jobs.reserve(order.size());
+    for (size_t index : order) {
+        BatchResult* result = &results[index];
+        jobs.push_back([result, streaming]() {
+            auto started = std::chrono::steady_clock::now();
+
+            std::error_code ec;
+            if (!std::filesystem::is_regular_file(result->package_path, ec)) {
+                dpm_log(LOG_ERROR, ("Package file not found: " + result->package_path).c_str());
+                result->status = "missing";
+            } else {
+                bool cache_hit = false;
+                int rc = verify_checksums_package_cached(result->package_path, streaming, &cache_hit);
+                result->status = rc != 0 ? "failed" : (cache_hit ? "cached" : "ok");
+                if (rc != 0) {
+                    dpm_log(LOG_ERROR, ("Verification failed: " + result->package_path).c_str());
+                }
+            }
+
+            result->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        });
+    }
+
+    size_t total_workers = std::max<size_t>(1, std::min(worker_count, packages.size()));
+    DPM_LOG(LOG_DEBUG, "Verifying ", packages.size(), " packages with ", total_workers, " workers");
+
+    auto started = std::chrono::steady_clock::now();
+    WorkStealingPool pool(total_workers);
+    pool.run(jobs);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    // Report in input order so successive runs can be diffed
+    size_t passed = 0, cached = 0, failed = 0, missing = 0;
+    for (const auto& result : results) {
+        if (result.status == "ok") {
+            passed++;
+        } else if (result.status == "cached") {
+            cached++;
+        } else if (result.status == "missing") {
+            missing++;
+        } else {
+            failed++;
+        }
+
+        char seconds[32];
+        snprintf(seconds, sizeof(seconds), "%.6f", result.seconds);
+        *summary << "{\"package\":\"" << json_escape(result.package_path) << "\","
+                 << "\"status\":\"" << result.status << "\","
+                 << "\"size\":" << result.size << ","
+                 << "\"seconds\":" << seconds << "}\n";
+    }
+
+    char elapsed_str[32];
+    snprintf(elapsed_str, sizeof(elapsed_str), "%.6f", elapsed);
+    *summary << "{\"summary\":{\"total\":" << results.size()
+             << ",\"ok\":" << passed
+             << ",\"cached\":" << cached
+             << ",\"failed\":" << failed
+             << ",\"missing\":" << missing
+             << ",\"workers\":" << total_workers
+             << ",\"seconds\":" << elapsed_str << "}}\n";
+    summary->flush();
+
+    return (failed == 0 && missing == 0) ? 0 : 1;
+}
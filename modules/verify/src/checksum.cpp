@@ -13,101 +13,220 @@
 #include "checksum.hpp"
 #include <fstream>
 #include <sstream>
-#include <dlfcn.h>
 
-int checksum_verify_contents_digest(const std::string& stage_dir, void* build_module) {
+// the stage metadata to verify against, read here unless the caller already did
+static const MetadataModel* checksum_stage_metadata(const std::string& stage_dir, const MetadataModel* metadata,
+                                                    MetadataModel& own_metadata)
+{
+    if (!metadata) {
+        // a directory that cannot be read leaves the model empty, so every field is reported missing
+        own_metadata.load(std::filesystem::path(stage_dir) / "metadata");
+        metadata = &own_metadata;
+    }
+    return metadata;
+}
+
+int checksum_verify_contents_digest(const std::string& stage_dir, const BuildModuleFunctions* build_module,
+                                    const MetadataModel* metadata) {
+    DpmProfileScope profile("verify_contents_digest");
+
     dpm_log(LOG_INFO, "Verifying contents manifest digest...");
-    std::filesystem::path manifest_file = std::filesystem::path(stage_dir) / "metadata" / "CONTENTS_MANIFEST_DIGEST";
+    MetadataModel own_metadata;
+    metadata = checksum_stage_metadata(stage_dir, metadata, own_metadata);
+    const std::string* manifest = metadata->find("CONTENTS_MANIFEST_DIGEST");
 
-    if (!std::filesystem::exists(manifest_file)) {
+    if (!manifest) {
         dpm_log(LOG_ERROR, "CONTENTS_MANIFEST_DIGEST file not found");
         return 1;
     }
 
-    // Get the generate_file_checksum function from the build module
-    typedef std::string (*FileChecksumFunc)(const std::filesystem::path&);
-    dlerror(); // Clear any previous error
-    FileChecksumFunc generate_checksum = (FileChecksumFunc)dlsym(build_module, "generate_file_checksum");
-
-    const char* dlsym_error = dlerror();
-    if (dlsym_error) {
-        dpm_log(LOG_ERROR, ("Failed to find generate_file_checksum function: " +
-                           std::string(dlsym_error)).c_str());
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Build module functions are not available");
         return 1;
     }
 
+    auto generate_checksum = build_module->generate_file_checksum;
+    auto generate_checksums = build_module->generate_file_checksums;
+
     try {
-        std::ifstream manifest(manifest_file);
-        if (!manifest.is_open()) {
-            dpm_log(LOG_ERROR, ("Failed to open manifest file: " + manifest_file.string()).c_str());
-            return 1;
+        ContentsManifestTable table;
+        load_contents_manifest(*manifest, metadata->find(CONTENTS_MANIFEST_INDEX_FILENAME),
+                               build_module->generate_string_checksum, table);
+
+        // Digests of additional algorithms are checked in the same read of each file
+        const std::string* extra_digests = metadata->find(CONTENTS_EXTRA_DIGESTS_FILENAME);
+        if (extra_digests) {
+            parse_contents_extra_digests(*extra_digests, table, build_module->hash_algorithm_supported);
+        }
+        std::vector<std::string> algorithms = contents_manifest_algorithms(table,
+                                                                           build_module->get_configured_hash_algorithm());
+        bool multi = algorithms.size() > 1;
+        const ContentsManifestTable* table_ptr = &table;
+
+        // Large files with recorded chunk digests are hashed one chunk per job across the workers
+        ContentsChunkTable chunk_table;
+        bool use_chunks = false;
+        const std::string* chunks = metadata->find(CONTENTS_CHUNKS_FILENAME);
+        if (chunks) {
+            // additional algorithms need a read of the whole file anyway
+            if (multi) {
+                dpm_log(LOG_DEBUG, "Verifying large files whole because additional digest algorithms are recorded");
+            } else if (parse_contents_chunks(*chunks, chunk_table)) {
+                use_chunks = chunk_table.algorithm == algorithms.front();
+                if (!use_chunks) {
+                    DPM_LOG(LOG_DEBUG, "Ignoring chunk digests recorded with ", chunk_table.algorithm);
+                }
+            }
+        }
+        auto generate_chunk_checksum = build_module->generate_file_chunk_checksum;
+        std::vector<std::pair<ContentsManifestEntry*, ContentsChunkRecord*>> chunked_entries;
+
+        std::filesystem::path contents_dir = std::filesystem::path(stage_dir) / "contents";
+        size_t worker_count = get_verify_worker_count();
+        DPM_LOG(LOG_DEBUG, "Hashing contents with ", worker_count, " workers");
+
+        // Each job only touches its own manifest entry; results are reported afterwards in manifest order
+        bool fail_fast = verify_fail_fast();
+        bool stopped = false;
+        {
+            WorkerPool pool(worker_count, worker_count * 4);
+            WorkerPool* pool_ptr = &pool;
+            for (auto& manifest_entry : table.entries) {
+                if (pool.cancelled()) {
+                    break;
+                }
+
+                ContentsManifestEntry* entry = &manifest_entry;
+
+                auto chunk_record = use_chunks ? chunk_table.index.find(entry->path) : chunk_table.index.end();
+                if (chunk_record != chunk_table.index.end()) {
+                    ContentsChunkRecord* record = &chunk_table.records[chunk_record->second];
+                    std::filesystem::path full_file_path = contents_dir / entry->path;
+
+                    // a file that changed size cannot match its chunks, hash it whole to report it
+                    std::error_code ec;
+                    uint64_t file_size = std::filesystem::file_size(full_file_path, ec);
+                    if (!ec && file_size == record->file_size) {
+                        record->actual_chunks.assign(record->expected_chunks.size(), "");
+                        chunked_entries.emplace_back(entry, record);
+
+                        uint64_t chunk_size = chunk_table.chunk_size;
+                        const std::string* chunk_algorithm = &chunk_table.algorithm;
+                        for (size_t chunk = 0; chunk < record->expected_chunks.size(); chunk++) {
+                            pool.submit([record, chunk, full_file_path, chunk_size, chunk_algorithm,
+                                         generate_chunk_checksum, fail_fast, pool_ptr]() {
+                                uint64_t offset = static_cast<uint64_t>(chunk) * chunk_size;
+                                uint64_t length = std::min<uint64_t>(chunk_size, record->file_size - offset);
+                                record->actual_chunks[chunk] = generate_chunk_checksum(full_file_path, offset, length,
+                                                                                       *chunk_algorithm);
+
+                                if (fail_fast && record->actual_chunks[chunk] != record->expected_chunks[chunk]) {
+                                    pool_ptr->cancel();
+                                }
+                            });
+                        }
+                        continue;
+                    }
+                }
+
+                pool.submit([entry, &contents_dir, &algorithms, generate_checksum, generate_checksums, multi,
+                             table_ptr, fail_fast, pool_ptr]() {
+                    std::filesystem::path full_file_path = contents_dir / entry->path;
+
+                    std::error_code ec;
+                    if (!std::filesystem::exists(full_file_path, ec)) {
+                        if (fail_fast) {
+                            pool_ptr->cancel();
+                        }
+                        return;
+                    }
+
+                    entry->seen = true;
+                    if (multi) {
+                        std::vector<std::string> checksums = generate_checksums(full_file_path, algorithms);
+                        if (!checksums.empty()) {
+                            entry->actual_checksum = checksums.front();
+                            entry->actual_extra.assign(checksums.begin() + 1, checksums.end());
+                        }
+                    } else {
+                        entry->actual_checksum = generate_checksum(full_file_path);
+                    }
+                    entry->failed = entry->actual_checksum.empty();
+
+                    // The first failure cancels the hashing still queued
+                    if (fail_fast && !contents_manifest_entry_matches(*table_ptr, *entry)) {
+                        pool_ptr->cancel();
+                    }
+                });
+            }
+            pool.wait();
+            stopped = pool.cancelled();
         }
 
-        std::string line;
-        int line_number = 0;
-        int errors = 0;
-
-        while (std::getline(manifest, line)) {
-            line_number++;
-
-            // Skip empty lines
-            if (line.empty()) continue;
-
-            // Parse the line: control_designation checksum permissions owner:group /path/to/file
-            std::istringstream iss(line);
-            char control_designation;
-            std::string checksum, permissions, ownership, file_path;
-
-            if (!(iss >> control_designation >> checksum >> permissions >> ownership)) {
-                dpm_log(LOG_WARN, ("Malformed manifest line " + std::to_string(line_number) +
-                                  ": " + line).c_str());
+        // A chunked file matches when its chunks rebuild the recorded Merkle root
+        int chunk_errors = 0;
+        for (auto& [entry, record] : chunked_entries) {
+            bool complete = std::none_of(record->actual_chunks.begin(), record->actual_chunks.end(),
+                                         [](const std::string& chunk) { return chunk.empty(); });
+            if (!complete && stopped) {
                 continue;
             }
 
-            // Get the rest of the line as the file path
-            std::getline(iss >> std::ws, file_path);
-
-            if (file_path.empty()) {
-                dpm_log(LOG_WARN, ("Missing file path in manifest line " +
-                                  std::to_string(line_number)).c_str());
+            entry->seen = true;
+            if (!complete) {
+                entry->failed = true;
                 continue;
             }
 
-            // Remove leading slash if present
-            if (file_path[0] == '/') {
-                file_path = file_path.substr(1);
+            std::string root = build_module->generate_chunk_merkle_root(record->actual_chunks, chunk_table.algorithm);
+            if (!root.empty() && root == record->expected_root) {
+                // the verified chunk tree stands in for the whole-file digest
+                entry->actual_checksum = entry->expected_checksum;
+                continue;
             }
 
-            // Build the full path to the file in the contents directory
-            std::filesystem::path full_file_path = std::filesystem::path(stage_dir) / "contents" / file_path;
-
-            // Check if the file exists
-            if (!std::filesystem::exists(full_file_path)) {
-                dpm_log(LOG_ERROR, ("File not found: " + full_file_path.string()).c_str());
-                errors++;
-                continue;
+            for (size_t chunk = 0; chunk < record->actual_chunks.size(); chunk++) {
+                if (record->actual_chunks[chunk] != record->expected_chunks[chunk]) {
+                    uint64_t offset = static_cast<uint64_t>(chunk) * chunk_table.chunk_size;
+                    uint64_t end = std::min<uint64_t>(offset + chunk_table.chunk_size, record->file_size);
+                    dpm_log(LOG_ERROR, ("Chunk mismatch for " + entry->path + " at bytes " + std::to_string(offset) +
+                                       "-" + std::to_string(end - 1)).c_str());
+                }
             }
+            dpm_log(LOG_ERROR, ("Merkle root mismatch for " + entry->path +
+                               "\n  Expected: " + record->expected_root +
+                               "\n  Actual:   " + root).c_str());
 
-            // Calculate the checksum of the file and compare with the manifest
-            std::string calculated_checksum = generate_checksum(full_file_path);
+            // hash the whole file so the manifest checksum is reported as usual
+            entry->actual_checksum = generate_checksum(contents_dir / entry->path);
+            entry->failed = entry->actual_checksum.empty();
 
-            if (calculated_checksum.empty()) {
-                dpm_log(LOG_ERROR, ("Failed to calculate checksum for: " +
-                                   full_file_path.string()).c_str());
-                errors++;
-                continue;
+            // a file matching its manifest checksum but not its chunks is only caught here
+            if (entry->actual_checksum == entry->expected_checksum) {
+                chunk_errors++;
             }
+        }
 
-            if (calculated_checksum != checksum) {
-                dpm_log(LOG_ERROR, ("Checksum mismatch for " + full_file_path.string() +
-                                   "\n  Expected: " + checksum +
-                                   "\n  Actual:   " + calculated_checksum).c_str());
-                errors++;
+        int errors = chunk_errors +
+                     report_contents_manifest_results(table, "File not found in contents directory", !stopped);
+
+        if (stopped) {
+            // a missing file is the one failure that leaves no seen entry behind to report
+            for (const auto& manifest_entry : table.entries) {
+                std::error_code ec;
+                if (errors > 0) {
+                    break;
+                }
+                if (!manifest_entry.seen && !std::filesystem::exists(contents_dir / manifest_entry.path, ec)) {
+                    dpm_log(LOG_ERROR, ("File not found in contents directory (manifest line " +
+                                       std::to_string(manifest_entry.line_number) + "): " + manifest_entry.path).c_str());
+                    errors++;
+                }
             }
+            dpm_log(LOG_ERROR, "Contents verification stopped at the first failure (fail-fast)");
+            return 1;
         }
 
-        manifest.close();
-
         if (errors > 0) {
             dpm_log(LOG_ERROR, (std::to_string(errors) + " checksum errors found in contents manifest").c_str());
             return 1;
@@ -122,48 +241,45 @@ int checksum_verify_contents_digest(const std::string& stage_dir, void* build_mo
     }
 }
 
-int checksum_verify_hooks_digest(const std::string& stage_dir, void* build_module) {
+int checksum_verify_hooks_digest(const std::string& stage_dir, const BuildModuleFunctions* build_module,
+                                 const MetadataModel* metadata) {
+    DpmProfileScope profile("verify_hooks_digest");
+
     dpm_log(LOG_INFO, "Verifying hooks digest...");
-    std::filesystem::path hooks_digest_file = std::filesystem::path(stage_dir) / "metadata" / "HOOKS_DIGEST";
+    MetadataModel own_metadata;
+    metadata = checksum_stage_metadata(stage_dir, metadata, own_metadata);
+    const std::string* hooks_digest_content = metadata->find("HOOKS_DIGEST");
 
-    if (!std::filesystem::exists(hooks_digest_file)) {
+    if (!hooks_digest_content) {
         dpm_log(LOG_ERROR, "HOOKS_DIGEST file not found");
         return 1;
     }
 
-    // Get the generate_file_checksum function from the build module
-    typedef std::string (*FileChecksumFunc)(const std::filesystem::path&);
-    dlerror(); // Clear any previous error
-    FileChecksumFunc generate_checksum = (FileChecksumFunc)dlsym(build_module, "generate_file_checksum");
-
-    const char* dlsym_error = dlerror();
-    if (dlsym_error) {
-        dpm_log(LOG_ERROR, ("Failed to find generate_file_checksum function: " +
-                           std::string(dlsym_error)).c_str());
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Build module functions are not available");
         return 1;
     }
 
-    try {
-        std::ifstream hooks_digest(hooks_digest_file);
-        if (!hooks_digest.is_open()) {
-            dpm_log(LOG_ERROR, ("Failed to open hooks digest file: " +
-                               hooks_digest_file.string()).c_str());
-            return 1;
-        }
+    auto generate_checksum = build_module->generate_file_checksum;
 
-        std::string line;
+    try {
+        std::string_view remaining(*hooks_digest_content);
+        std::string_view line;
         int errors = 0;
+        bool fail_fast = verify_fail_fast();
+
+        while (manifest_next_line(remaining, line)) {
+            if (errors > 0 && fail_fast) {
+                break;
+            }
 
-        while (std::getline(hooks_digest, line)) {
             // Skip empty lines
             if (line.empty()) continue;
 
             // Parse the line: checksum filename
-            std::istringstream iss(line);
-            std::string checksum, filename;
-
-            if (!(iss >> checksum >> filename)) {
-                dpm_log(LOG_WARN, ("Malformed hooks digest line: " + line).c_str());
+            std::string_view checksum, filename;
+            if (!hooks_digest_parse_line(line, checksum, filename)) {
+                dpm_log(LOG_WARN, ("Malformed hooks digest line: " + std::string(line)).c_str());
                 continue;
             }
 
@@ -189,14 +305,12 @@ int checksum_verify_hooks_digest(const std::string& stage_dir, void* build_modul
 
             if (calculated_checksum != checksum) {
                 dpm_log(LOG_ERROR, ("Checksum mismatch for " + hook_path.string() +
-                                   "\n  Expected: " + checksum +
+                                   "\n  Expected: " + std::string(checksum) +
                                    "\n  Actual:   " + calculated_checksum).c_str());
                 errors++;
             }
         }
 
-        hooks_digest.close();
-
         if (errors > 0) {
             dpm_log(LOG_ERROR, (std::to_string(errors) + " checksum errors found in hooks digest").c_str());
             return 1;
@@ -211,68 +325,45 @@ int checksum_verify_hooks_digest(const std::string& stage_dir, void* build_modul
     }
 }
 
-int checksum_verify_package_digest(const std::string& stage_dir, void* build_module) {
+int checksum_verify_package_digest(const std::string& stage_dir, const BuildModuleFunctions* build_module,
+                                   const MetadataModel* metadata) {
+    DpmProfileScope profile("verify_package_digest");
+
     dpm_log(LOG_INFO, "Verifying package digest...");
-    std::filesystem::path metadata_dir = std::filesystem::path(stage_dir) / "metadata";
-    std::filesystem::path package_digest_file = metadata_dir / "PACKAGE_DIGEST";
-    std::filesystem::path manifest_file = metadata_dir / "CONTENTS_MANIFEST_DIGEST";
-    std::filesystem::path hooks_digest_file = metadata_dir / "HOOKS_DIGEST";
+    MetadataModel own_metadata;
+    metadata = checksum_stage_metadata(stage_dir, metadata, own_metadata);
+    const std::string* package_digest_content = metadata->find("PACKAGE_DIGEST");
+    const std::string* manifest = metadata->find("CONTENTS_MANIFEST_DIGEST");
+    const std::string* hooks_digest = metadata->find("HOOKS_DIGEST");
 
-    if (!std::filesystem::exists(package_digest_file)) {
+    if (!package_digest_content) {
         dpm_log(LOG_ERROR, "PACKAGE_DIGEST file not found");
         return 1;
     }
 
-    if (!std::filesystem::exists(manifest_file)) {
+    if (!manifest) {
         dpm_log(LOG_ERROR, "CONTENTS_MANIFEST_DIGEST file not found");
         return 1;
     }
 
-    if (!std::filesystem::exists(hooks_digest_file)) {
+    if (!hooks_digest) {
         dpm_log(LOG_ERROR, "HOOKS_DIGEST file not found");
         return 1;
     }
 
-    // Get the checksum functions from the build module
-    typedef std::string (*FileChecksumFunc)(const std::filesystem::path&);
-    typedef std::string (*StringChecksumFunc)(const std::string&);
-
-    dlerror(); // Clear any previous error
-    FileChecksumFunc generate_file_checksum = (FileChecksumFunc)dlsym(build_module, "generate_file_checksum");
-    const char* dlsym_error = dlerror();
-    if (dlsym_error) {
-        dpm_log(LOG_ERROR, ("Failed to find generate_file_checksum function: " +
-                           std::string(dlsym_error)).c_str());
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Build module functions are not available");
         return 1;
     }
 
-    dlerror(); // Clear any previous error
-    StringChecksumFunc generate_string_checksum = (StringChecksumFunc)dlsym(build_module, "generate_string_checksum");
-    dlsym_error = dlerror();
-    if (dlsym_error) {
-        dpm_log(LOG_ERROR, ("Failed to find generate_string_checksum function: " +
-                           std::string(dlsym_error)).c_str());
-        return 1;
-    }
+    auto generate_string_checksum = build_module->generate_string_checksum;
 
-    // Read the package digest from the file
-    std::string package_digest;
-    try {
-        std::ifstream digest_file(package_digest_file);
-        if (!digest_file.is_open()) {
-            dpm_log(LOG_ERROR, ("Failed to open digest file: " + package_digest_file.string()).c_str());
-            return 1;
-        }
-        std::getline(digest_file, package_digest);
-        digest_file.close();
-    } catch (const std::exception& e) {
-        dpm_log(LOG_ERROR, ("Error reading package digest: " + std::string(e.what())).c_str());
-        return 1;
-    }
+    // The package digest is the first line of its file
+    std::string package_digest = package_digest_content->substr(0, package_digest_content->find('\n'));
 
-    // Calculate checksums of the digest files
-    std::string contents_manifest_checksum = generate_file_checksum(manifest_file);
-    std::string hooks_digest_checksum = generate_file_checksum(hooks_digest_file);
+    // Calculate checksums of the digest files, already in memory
+    std::string contents_manifest_checksum = generate_string_checksum(*manifest);
+    std::string hooks_digest_checksum = generate_string_checksum(*hooks_digest);
 
     if (contents_manifest_checksum.empty() || hooks_digest_checksum.empty()) {
         dpm_log(LOG_ERROR, "Failed to calculate checksums for digest files");
@@ -299,3 +390,111 @@ int checksum_verify_package_digest(const std::string& stage_dir, void* build_mod
     return 0;
 }
 
+
+int checksum_verify_contents_range(const std::string& stage_dir, const std::string& file_path,
+                                   uint64_t offset, uint64_t length, const BuildModuleFunctions* build_module) {
+    std::filesystem::path chunks_file = std::filesystem::path(stage_dir) / "metadata" / CONTENTS_CHUNKS_FILENAME;
+
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Build module functions are not available");
+        return 1;
+    }
+
+    if (!std::filesystem::exists(chunks_file)) {
+        dpm_log(LOG_ERROR, (std::string(CONTENTS_CHUNKS_FILENAME) + " file not found, the stage has no chunked files").c_str());
+        return 1;
+    }
+
+    std::ifstream chunks(chunks_file);
+    std::stringstream chunks_buffer;
+    chunks_buffer << chunks.rdbuf();
+
+    ContentsChunkTable chunk_table;
+    if (!parse_contents_chunks(chunks_buffer.str(), chunk_table)) {
+        dpm_log(LOG_ERROR, ("Failed to parse " + chunks_file.string()).c_str());
+        return 1;
+    }
+
+    std::string relative_path = (!file_path.empty() && file_path[0] == '/') ? file_path.substr(1) : file_path;
+    auto found = chunk_table.index.find(relative_path);
+    if (found == chunk_table.index.end()) {
+        dpm_log(LOG_ERROR, ("No chunk digests recorded for: " + relative_path).c_str());
+        return 1;
+    }
+    ContentsChunkRecord& record = chunk_table.records[found->second];
+
+    // The recorded chunks must rebuild the recorded root before any of them is trusted
+    std::string recorded_root = build_module->generate_chunk_merkle_root(record.expected_chunks, chunk_table.algorithm);
+    if (recorded_root.empty() || recorded_root != record.expected_root) {
+        dpm_log(LOG_ERROR, ("Recorded chunk digests do not match the recorded Merkle root for: " + relative_path).c_str());
+        return 1;
+    }
+
+    std::filesystem::path full_file_path = std::filesystem::path(stage_dir) / "contents" / relative_path;
+    std::error_code ec;
+    uint64_t file_size = std::filesystem::file_size(full_file_path, ec);
+    if (ec) {
+        dpm_log(LOG_ERROR, ("File not found in contents directory: " + relative_path).c_str());
+        return 1;
+    }
+    if (file_size != record.file_size) {
+        dpm_log(LOG_ERROR, ("File size changed for " + relative_path + ": recorded " +
+                           std::to_string(record.file_size) + ", found " + std::to_string(file_size)).c_str());
+        return 1;
+    }
+    if (offset >= file_size) {
+        dpm_log(LOG_ERROR, ("Offset " + std::to_string(offset) + " is past the end of " + relative_path).c_str());
+        return 1;
+    }
+
+    uint64_t end = (length == 0 || length > file_size - offset) ? file_size : offset + length;
+    size_t first_chunk = static_cast<size_t>(offset / chunk_table.chunk_size);
+    size_t last_chunk = static_cast<size_t>((end - 1) / chunk_table.chunk_size);
+
+    dpm_log(LOG_INFO, ("Verifying bytes " + std::to_string(offset) + "-" + std::to_string(end - 1) + " of " +
+                      relative_path + " (" + std::to_string(last_chunk - first_chunk + 1) + " chunks)...").c_str());
+
+    record.actual_chunks.assign(record.expected_chunks.size(), "");
+    {
+        size_t worker_count = get_verify_worker_count();
+        WorkerPool pool(worker_count, worker_count * 4);
+        auto generate_chunk_checksum = build_module->generate_file_chunk_checksum;
+        for (size_t chunk = first_chunk; chunk <= last_chunk; chunk++) {
+            ContentsChunkRecord* record_ptr = &record;
+            uint64_t chunk_size = chunk_table.chunk_size;
+            const std::string* algorithm = &chunk_table.algorithm;
+            pool.submit([record_ptr, chunk, chunk_size, algorithm, &full_file_path, generate_chunk_checksum]() {
+                uint64_t chunk_offset = static_cast<uint64_t>(chunk) * chunk_size;
+                uint64_t chunk_length = std::min<uint64_t>(chunk_size, record_ptr->file_size - chunk_offset);
+                record_ptr->actual_chunks[chunk] = generate_chunk_checksum(full_file_path, chunk_offset, chunk_length,
+                                                                           *algorithm);
+            });
+        }
+        pool.wait();
+    }
+
+    int errors = 0;
+    for (size_t chunk = first_chunk; chunk <= last_chunk; chunk++) {
+        uint64_t chunk_offset = static_cast<uint64_t>(chunk) * chunk_table.chunk_size;
+        uint64_t chunk_end = std::min<uint64_t>(chunk_offset + chunk_table.chunk_size, record.file_size);
+        std::string range = std::to_string(chunk_offset) + "-" + std::to_string(chunk_end - 1);
+
+        if (record.actual_chunks[chunk].empty()) {
+            dpm_log(LOG_ERROR, ("Failed to calculate checksum for " + relative_path + " at bytes " + range).c_str());
+            errors++;
+        } else if (record.actual_chunks[chunk] != record.expected_chunks[chunk]) {
+            dpm_log(LOG_ERROR, ("Chunk mismatch for " + relative_path + " at bytes " + range +
+                               "\n  Expected: " + record.expected_chunks[chunk] +
+                               "\n  Actual:   " + record.actual_chunks[chunk]).c_str());
+            errors++;
+        }
+    }
+
+    if (errors > 0) {
+        dpm_log(LOG_ERROR, (std::to_string(errors) + " chunk errors found in " + relative_path).c_str());
+        return 1;
+    }
+
+    dpm_log(LOG_INFO, "Range checksum verification successful");
+    return 0;
+}
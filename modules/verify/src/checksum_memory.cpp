@@ -14,54 +14,142 @@
 #include "checksum_memory.hpp"
 
 /**
- * @brief Converts binary data to a C++ string
+ * @brief Calculates the package digest from the checksums of the two digest files
  *
- * Takes a buffer of binary data and its size, creates a properly
- * null-terminated string, and returns it as an std::string.
- *
- * @param data Pointer to the binary data
- * @param data_size Size of the binary data
- * @return std::string containing the data, or empty string on error
+ * @param contents_manifest_checksum Hexadecimal checksum of CONTENTS_MANIFEST_DIGEST
+ * @param hooks_digest_checksum Hexadecimal checksum of HOOKS_DIGEST
+ * @param build_module Resolved build module function table
+ * @return Hexadecimal package digest, or an empty string on failure
  */
-std::string binary_to_string(const unsigned char* data, size_t data_size) {
-    if (!data || data_size == 0) {
-        return std::string();
+static std::string calculate_package_digest(
+    const std::string& contents_manifest_checksum,
+    const std::string& hooks_digest_checksum,
+    const BuildModuleFunctions* build_module)
+{
+    // Combine both checksums in a single allocation
+    std::string combined_checksums;
+    combined_checksums.reserve(contents_manifest_checksum.size() + hooks_digest_checksum.size());
+    combined_checksums.append(contents_manifest_checksum);
+    combined_checksums.append(hooks_digest_checksum);
+
+    return build_module->generate_string_checksum(combined_checksums);
+}
+
+int compare_package_digest_checksums(
+    const std::string& stored_package_digest,
+    const std::string& contents_manifest_checksum,
+    const std::string& hooks_digest_checksum,
+    const BuildModuleFunctions* build_module)
+{
+    // Only the first line of PACKAGE_DIGEST holds the digest
+    size_t digest_length = stored_package_digest.find_first_of("\r\n");
+    if (digest_length == std::string::npos) {
+        digest_length = stored_package_digest.size();
     }
 
-    // Create a temporary C-string with null termination
-    char* temp = (char*)malloc(data_size + 1);
-    if (!temp) {
-        return std::string();
+    if (contents_manifest_checksum.empty()) {
+        dpm_log(LOG_ERROR, "Failed to calculate checksum for contents manifest");
+        return 1;
+    }
+
+    if (hooks_digest_checksum.empty()) {
+        dpm_log(LOG_ERROR, "Failed to calculate checksum for hooks digest");
+        return 1;
     }
 
-    memcpy(temp, data, data_size);
-    temp[data_size] = '\0';
+    std::string calculated_package_digest = calculate_package_digest(contents_manifest_checksum,
+                                                                     hooks_digest_checksum, build_module);
+    if (calculated_package_digest.empty()) {
+        dpm_log(LOG_ERROR, "Failed to calculate package digest");
+        return 1;
+    }
+
+    // Compare with the stored package digest
+    if (stored_package_digest.compare(0, digest_length, calculated_package_digest) != 0) {
+        dpm_log(LOG_ERROR, ("Package digest mismatch\n  Expected: " + stored_package_digest.substr(0, digest_length) +
+                           "\n  Actual:   " + calculated_package_digest).c_str());
+        return 1;
+    }
+
+    dpm_log(LOG_INFO, "Package digest verification successful");
+    return 0;
+}
+
+/**
+ * @brief Compares a stored package digest with one calculated from the metadata files
+ *
+ * @param stored_package_digest Contents of the PACKAGE_DIGEST file
+ * @param contents_manifest Raw bytes of the CONTENTS_MANIFEST_DIGEST file
+ * @param hooks_digest Raw bytes of the HOOKS_DIGEST file
+ * @param build_module Resolved build module function table
+ * @return 0 if the digests match, non-zero otherwise
+ */
+int compare_package_digest(
+    const std::string& stored_package_digest,
+    const std::string& contents_manifest,
+    const std::string& hooks_digest,
+    const BuildModuleFunctions* build_module)
+{
+    // Hash the raw file bytes so the result matches generate_file_checksum on disk
+    return compare_package_digest_checksums(stored_package_digest,
+                                            build_module->generate_string_checksum(contents_manifest),
+                                            build_module->generate_string_checksum(hooks_digest),
+                                            build_module);
+}
 
-    // Create std::string from the C-string
-    std::string result(temp);
+/**
+ * @brief Checksums of the digest files, taken while walking the metadata component
+ */
+struct MetadataDigestChecksums {
+    std::string contents_manifest_checksum;     ///< Checksum of CONTENTS_MANIFEST_DIGEST
+    std::string hooks_digest_checksum;          ///< Checksum of HOOKS_DIGEST
+};
 
-    // Free the temporary buffer
-    free(temp);
+/**
+ * @brief Records the checksums of the digest files as the metadata archive is walked
+ *
+ * @param entry_path Path of the entry relative to the metadata directory
+ * @param checksum Hexadecimal checksum of the entry, or NULL for non-regular files
+ * @param user_data Pointer to a MetadataDigestChecksums
+ * @return Always 0 so the walk continues
+ */
+static int metadata_digest_walk_callback(const char* entry_path, const char* checksum, void* user_data)
+{
+    MetadataDigestChecksums* checksums = static_cast<MetadataDigestChecksums*>(user_data);
+
+    if (!checksum) {
+        return 0;
+    }
 
-    return result;
+    if (strcmp(entry_path, "CONTENTS_MANIFEST_DIGEST") == 0) {
+        checksums->contents_manifest_checksum = checksum;
+    } else if (strcmp(entry_path, "HOOKS_DIGEST") == 0) {
+        checksums->hooks_digest_checksum = checksum;
+    }
+
+    return 0;
 }
 
 /**
  * @brief Verifies the package digest from in-memory metadata
  *
- * Calculates the package digest from in-memory CONTENTS_MANIFEST_DIGEST and
- * HOOKS_DIGEST files and compares it to the value in PACKAGE_DIGEST.
+ * The digest files are hashed as they are decompressed out of the metadata
+ * component, so neither is ever copied out of the archive; only the short
+ * PACKAGE_DIGEST file itself is extracted.
  *
  * @param package_data Pointer to the metadata component data
  * @param package_data_size Size of the metadata component data
- * @param build_module Handle to the loaded build module
+ * @param build_module Resolved build module function table
  * @return 0 on successful verification, non-zero on failure
  */
 int checksum_verify_package_digest_memory(
     const unsigned char* package_data,
     size_t package_data_size,
-    void* build_module)
+    const BuildModuleFunctions* build_module)
 {
+    DpmProfileScope profile("verify_package_digest");
+    profile.add_bytes(package_data_size);
+
     // Validate input parameters
     if (!package_data || package_data_size == 0 || !build_module) {
         dpm_log(LOG_ERROR, "Invalid parameters passed to checksum_verify_package_digest_memory");
@@ -70,142 +158,296 @@ int checksum_verify_package_digest_memory(
 
     dpm_log(LOG_INFO, "Verifying package digest from in-memory data...");
 
-    // First, extract PACKAGE_DIGEST, CONTENTS_MANIFEST_DIGEST, and HOOKS_DIGEST from the metadata component
-    unsigned char* package_digest_data = nullptr;
-    size_t package_digest_size = 0;
-    unsigned char* contents_manifest_data = nullptr;
-    size_t contents_manifest_size = 0;
-    unsigned char* hooks_digest_data = nullptr;
-    size_t hooks_digest_size = 0;
-
     // Get PACKAGE_DIGEST from the metadata component
-    int result = get_file_from_component(
-        package_data,
-        package_data_size,
-        "PACKAGE_DIGEST",
-        &package_digest_data,
-        &package_digest_size
-    );
-
-    if (result != 0 || !package_digest_data || package_digest_size == 0) {
+    std::string package_digest_str;
+    if (get_file_from_component(package_data, package_data_size, "PACKAGE_DIGEST", package_digest_str) != 0) {
         dpm_log(LOG_ERROR, "Failed to extract PACKAGE_DIGEST from metadata component");
         return 1;
     }
 
-    // Get CONTENTS_MANIFEST_DIGEST from the metadata component
-    result = get_file_from_component(
-        package_data,
-        package_data_size,
-        "CONTENTS_MANIFEST_DIGEST",
-        &contents_manifest_data,
-        &contents_manifest_size
-    );
+    // Hash CONTENTS_MANIFEST_DIGEST and HOOKS_DIGEST in one pass over the metadata component
+    MetadataDigestChecksums checksums;
+    if (!build_module->checksum_memory_loaded_archive_entries(package_data, package_data_size,
+                                                              metadata_digest_walk_callback, &checksums)) {
+        dpm_log(LOG_ERROR, "Failed to read metadata component archive");
+        return 1;
+    }
 
-    if (result != 0 || !contents_manifest_data || contents_manifest_size == 0) {
+    if (checksums.contents_manifest_checksum.empty()) {
         dpm_log(LOG_ERROR, "Failed to extract CONTENTS_MANIFEST_DIGEST from metadata component");
-        free(package_digest_data);
         return 1;
     }
 
-    // Get HOOKS_DIGEST from the metadata component
-    result = get_file_from_component(
-        package_data,
-        package_data_size,
-        "HOOKS_DIGEST",
-        &hooks_digest_data,
-        &hooks_digest_size
-    );
-
-    if (result != 0 || !hooks_digest_data || hooks_digest_size == 0) {
+    if (checksums.hooks_digest_checksum.empty()) {
         dpm_log(LOG_ERROR, "Failed to extract HOOKS_DIGEST from metadata component");
-        free(package_digest_data);
-        free(contents_manifest_data);
         return 1;
     }
 
-    // Convert binary data to strings using our utility function
-    std::string package_digest_str = binary_to_string(package_digest_data, package_digest_size);
-    std::string contents_manifest_str = binary_to_string(contents_manifest_data, contents_manifest_size);
-    std::string hooks_digest_str = binary_to_string(hooks_digest_data, hooks_digest_size);
+    return compare_package_digest_checksums(package_digest_str, checksums.contents_manifest_checksum,
+                                            checksums.hooks_digest_checksum, build_module);
+}
 
-    // Check if any conversion failed
-    if (package_digest_str.empty() || contents_manifest_str.empty() || hooks_digest_str.empty()) {
-        dpm_log(LOG_ERROR, "Failed to convert binary data to strings");
-        free(package_digest_data);
-        free(contents_manifest_data);
-        free(hooks_digest_data);
-        return 1;
+/**
+ * @brief Looks up an archive entry in the manifest table and marks it seen
+ *
+ * Runs on the thread walking the archive, so a path that appears twice is
+ * caught here, before a second job could be handed the same manifest entry.
+ *
+ * @param state Walk state holding the manifest table
+ * @param entry_path Path of the entry relative to the contents directory
+ * @param has_data Whether the archive entry is a regular file with data to hash
+ * @return The matching manifest entry, or nullptr if it is not in the manifest or was already seen
+ */
+static ContentsManifestEntry* contents_walk_lookup(ContentsWalkState* state, const char* entry_path, bool has_data)
+{
+    auto it = state->table->index.find(entry_path);
+    if (it == state->table->index.end()) {
+        state->unexpected.push_back(entry_path);
+        return nullptr;
     }
 
-    // Calculate checksums using the build module's functions through dpm_execute_symbol
-    std::string contents_manifest_checksum;
-    result = dpm_execute_symbol(build_module, "generate_string_checksum",
-                              contents_manifest_str, &contents_manifest_checksum);
+    ContentsManifestEntry* manifest_entry = &state->table->entries[it->second];
+    if (manifest_entry->seen) {
+        state->duplicates.push_back(entry_path);
+        return nullptr;
+    }
+    manifest_entry->seen = true;
+    manifest_entry->no_data = !has_data;
+    return manifest_entry;
+}
 
-    if (result != 0 || contents_manifest_checksum.empty()) {
-        dpm_log(LOG_ERROR, "Failed to calculate checksum for contents manifest");
-        free(package_digest_data);
-        free(contents_manifest_data);
-        free(hooks_digest_data);
+/**
+ * @brief Records the checksum of an entry hashed by the build module during the walk
+ *
+ * @param entry_path Path of the entry relative to the contents directory
+ * @param checksum Hexadecimal checksum of the entry, or NULL for non-regular files
+ * @param user_data Pointer to a ContentsWalkState
+ * @return 0 to continue, non-zero to stop the walk at the first failure in fail-fast mode
+ */
+int contents_walk_checksum_callback(const char* entry_path, const char* checksum, void* user_data)
+{
+    ContentsWalkState* state = static_cast<ContentsWalkState*>(user_data);
+
+    ContentsManifestEntry* manifest_entry = contents_walk_lookup(state, entry_path, checksum != nullptr);
+    if (manifest_entry && checksum) {
+        manifest_entry->actual_checksum = checksum;
+    }
+
+    if (!state->fail_fast) {
+        return 0;
+    }
+
+    // Unexpected entries and mismatches end the walk straight away
+    if (!manifest_entry || !contents_manifest_entry_matches(*state->table, *manifest_entry)) {
+        state->stopped = true;
         return 1;
     }
 
-    std::string hooks_digest_checksum;
-    result = dpm_execute_symbol(build_module, "generate_string_checksum",
-                              hooks_digest_str, &hooks_digest_checksum);
+    return 0;
+}
 
-    if (result != 0 || hooks_digest_checksum.empty()) {
-        dpm_log(LOG_ERROR, "Failed to calculate checksum for hooks digest");
-        free(package_digest_data);
-        free(contents_manifest_data);
-        free(hooks_digest_data);
+int contents_walk_checksums_callback(const char* entry_path, const char* const* checksums,
+                                     size_t checksum_count, void* user_data)
+{
+    ContentsWalkState* state = static_cast<ContentsWalkState*>(user_data);
+
+    ContentsManifestEntry* manifest_entry = contents_walk_lookup(state, entry_path, checksums != nullptr);
+    if (manifest_entry && checksums && checksum_count > 0) {
+        manifest_entry->actual_checksum = checksums[0];
+        manifest_entry->actual_extra.assign(checksums + 1, checksums + checksum_count);
+    }
+
+    if (!state->fail_fast) {
+        return 0;
+    }
+
+    if (!manifest_entry || !contents_manifest_entry_matches(*state->table, *manifest_entry)) {
+        state->stopped = true;
         return 1;
     }
 
-    // Combine checksums and calculate package digest
-    std::string combined_checksums = contents_manifest_checksum + hooks_digest_checksum;
-    std::string calculated_package_digest;
+    return 0;
+}
 
-    result = dpm_execute_symbol(build_module, "generate_string_checksum",
-                              combined_checksums, &calculated_package_digest);
+void contents_walk_prepare_extra_digests(ContentsWalkState& state, const std::string& extra_digests,
+                                         const BuildModuleFunctions* build_module)
+{
+    state.build_module = build_module;
+    state.algorithms.clear();
 
-    if (result != 0 || calculated_package_digest.empty()) {
-        dpm_log(LOG_ERROR, "Failed to calculate package digest");
-        free(package_digest_data);
-        free(contents_manifest_data);
-        free(hooks_digest_data);
+    if (extra_digests.empty()) {
+        return;
+    }
+
+    parse_contents_extra_digests(extra_digests, *state.table, build_module->hash_algorithm_supported);
+    if (state.table->extra_algorithms.empty()) {
+        return;
+    }
+
+    state.algorithms = contents_manifest_algorithms(*state.table, build_module->get_configured_hash_algorithm());
+}
+
+/**
+ * @brief Hands a decompressed entry to the worker pool for hashing
+ *
+ * The build module decompresses the entry into a buffer from the state's
+ * extraction pool, which the job hashes where it lies and hands back, so
+ * the entry data is never copied.  A path is only handed to a job the first
+ * time it appears in the archive, so each job writes only to its own
+ * manifest entry and no further synchronisation is needed.  In fail-fast
+ * mode the first job to find a mismatch cancels the jobs still queued, and
+ * the walk stops at the next entry.
+ *
+ * @param entry_path Path of the entry relative to the contents directory
+ * @param data Entry data in a buffer of the extraction pool, or NULL for non-regular files
+ * @param data_size Size of the entry data
+ * @param user_data Pointer to a ContentsWalkState
+ * @return 0 to continue, non-zero to stop the walk at the first failure in fail-fast mode
+ */
+static int contents_walk_data_callback(const char* entry_path, unsigned char* data,
+                                       size_t data_size, void* user_data)
+{
+    ContentsWalkState* state = static_cast<ContentsWalkState*>(user_data);
+
+    // handed back with the job, or here if the entry is not hashed
+    ExtractionBufferPool* buffers = state->buffers;
+    std::shared_ptr<unsigned char> file_data(data, [buffers, data_size](unsigned char* buffer) {
+        buffers->release(buffer, data_size);
+    });
+
+    if (state->stopped) {
         return 1;
     }
 
-    // Compare with the stored package digest
-    bool match = (calculated_package_digest == package_digest_str);
+    ContentsManifestEntry* manifest_entry = contents_walk_lookup(state, entry_path, data != nullptr);
+    if (!manifest_entry || (!data && !contents_manifest_entry_matches(*state->table, *manifest_entry))) {
+        if (state->fail_fast) {
+            state->stopped = true;
+            state->pool->cancel();
+            return 1;
+        }
+        return 0;
+    }
 
-    // Clean up
-    free(package_digest_data);
-    free(contents_manifest_data);
-    free(hooks_digest_data);
+    if (!data) {
+        return 0;
+    }
 
-    if (!match) {
-        dpm_log(LOG_ERROR, ("Package digest mismatch\n  Expected: " + package_digest_str +
-                           "\n  Actual:   " + calculated_package_digest).c_str());
+    state->pool->submit([state, manifest_entry, file_data, data_size]() {
+        DpmProfileScope profile("hash_entry");
+        profile.add_bytes(data_size);
+        profile.add_files(1);
+
+        if (state->algorithms.empty()) {
+            manifest_entry->actual_checksum = dpm_digest_buffer_hex(state->build_module, file_data.get(), data_size);
+        } else {
+            // Several algorithms are computed over the one copy of the data
+            std::vector<std::string> checksums = state->build_module->generate_buffer_checksums(
+                file_data.get(), data_size, state->algorithms);
+            if (!checksums.empty()) {
+                manifest_entry->actual_checksum = checksums.front();
+                manifest_entry->actual_extra.assign(checksums.begin() + 1, checksums.end());
+            }
+        }
+        manifest_entry->failed = manifest_entry->actual_checksum.empty();
+
+        if (state->fail_fast && !contents_manifest_entry_matches(*state->table, *manifest_entry)) {
+            state->stopped = true;
+            state->pool->cancel();
+        }
+    });
+
+    return 0;
+}
+
+/**
+ * @brief The optional metadata files read alongside the contents manifest
+ */
+struct OptionalManifestFiles {
+    std::string extra_digests;      ///< CONTENTS_MANIFEST_EXTRA_DIGESTS, empty if absent
+    std::string manifest_index;     ///< CONTENTS_MANIFEST_INDEX, empty if absent
+    bool has_extra_digests;         ///< Set once the extra digests file has been found
+    bool has_manifest_index;        ///< Set once the index has been found
+};
+
+/**
+ * @brief Captures the optional manifest files as the metadata component is walked
+ *
+ * @param entry_path Path of the entry relative to the metadata directory
+ * @param data Entry data, or NULL for non-regular files
+ * @param data_size Size of the entry data
+ * @param user_data Pointer to the OptionalManifestFiles receiving the files
+ * @return 0 to continue, 1 once both files have been found
+ */
+static int optional_manifest_files_walk_callback(const char* entry_path, const unsigned char* data,
+                                                 size_t data_size, void* user_data)
+{
+    OptionalManifestFiles* files = static_cast<OptionalManifestFiles*>(user_data);
+    if (!data) {
+        return 0;
+    }
+
+    if (strcmp(entry_path, CONTENTS_EXTRA_DIGESTS_FILENAME) == 0) {
+        files->extra_digests.assign(reinterpret_cast<const char*>(data), data_size);
+        files->has_extra_digests = true;
+    } else if (strcmp(entry_path, CONTENTS_MANIFEST_INDEX_FILENAME) == 0) {
+        files->manifest_index.assign(reinterpret_cast<const char*>(data), data_size);
+        files->has_manifest_index = true;
+    }
+    return files->has_extra_digests && files->has_manifest_index ? 1 : 0;
+}
+
+/**
+ * @brief Reports the outcome of a contents archive walk
+ *
+ * @param state Walk state after the contents archive has been visited
+ * @return 0 if every manifest entry was found and matched, non-zero otherwise
+ */
+int report_contents_walk_results(const ContentsWalkState& state)
+{
+    bool stopped = state.stopped;
+    int errors = report_contents_manifest_results(*state.table, "File listed in manifest is missing from contents archive",
+                                                  !stopped);
+
+    for (const auto& entry_path : state.unexpected) {
+        dpm_log(LOG_ERROR, ("File in contents archive is not listed in manifest: " + entry_path).c_str());
+        errors++;
+    }
+
+    for (const auto& entry_path : state.duplicates) {
+        dpm_log(LOG_ERROR, ("Contents entry appears more than once: " + entry_path).c_str());
+        errors++;
+    }
+
+    if (stopped) {
+        dpm_log(LOG_ERROR, "Contents verification stopped at the first failure (fail-fast)");
         return 1;
     }
 
-    dpm_log(LOG_INFO, "Package digest verification successful");
+    if (errors > 0) {
+        dpm_log(LOG_ERROR, (std::to_string(errors) + " checksum errors found in contents manifest").c_str());
+        return 1;
+    }
+
+    dpm_log(LOG_INFO, "Contents manifest checksum verification successful");
     return 0;
 }
 
 /**
  * @brief Verifies the contents manifest digest from in-memory data
  *
- * Compares checksums in the contents manifest with actual file checksums
- * using in-memory data rather than extracting files to disk.
+ * Parses the contents manifest once into a lookup table, then walks the
+ * contents archive a single time, hashing each entry as it streams past and
+ * checking it against the table.  Manifest entries that never appear in the
+ * archive, and archive entries that are absent from the manifest, are both
+ * reported as errors.  When more than one verification worker is configured,
+ * entries are decompressed on the calling thread and hashed in parallel.
  *
  * @param contents_data Pointer to the contents component data
  * @param contents_data_size Size of the contents component data
  * @param metadata_data Pointer to the metadata component data
  * @param metadata_data_size Size of the metadata component data
- * @param build_module Handle to the loaded build module
+ * @param build_module Resolved build module function table
  * @return 0 on successful verification, non-zero on failure
  */
 int checksum_verify_contents_digest_memory(
@@ -213,8 +455,11 @@ int checksum_verify_contents_digest_memory(
     size_t contents_data_size,
     const unsigned char* metadata_data,
     size_t metadata_data_size,
-    void* build_module)
+    const BuildModuleFunctions* build_module)
 {
+    DpmProfileScope profile("verify_contents_digest");
+    profile.add_bytes(contents_data_size);
+
     // Validate input parameters
     if (!contents_data || contents_data_size == 0 ||
         !metadata_data || metadata_data_size == 0 || !build_module) {
@@ -225,136 +470,150 @@ int checksum_verify_contents_digest_memory(
     dpm_log(LOG_INFO, "Verifying contents manifest digest from in-memory data...");
 
     // Extract CONTENTS_MANIFEST_DIGEST from the metadata component
-    unsigned char* manifest_data = nullptr;
-    size_t manifest_size = 0;
-
-    int result = get_file_from_component(
-        metadata_data,
-        metadata_data_size,
-        "CONTENTS_MANIFEST_DIGEST",
-        &manifest_data,
-        &manifest_size
-    );
-
-    if (result != 0 || !manifest_data || manifest_size == 0) {
+    std::string manifest_str;
+    if (get_file_from_component(metadata_data, metadata_data_size, "CONTENTS_MANIFEST_DIGEST", manifest_str) != 0) {
         dpm_log(LOG_ERROR, "Failed to extract CONTENTS_MANIFEST_DIGEST from metadata component");
         return 1;
     }
 
-    // Convert binary data to string
-    std::string manifest_str = binary_to_string(manifest_data, manifest_size);
-    if (manifest_str.empty()) {
-        dpm_log(LOG_ERROR, "Failed to convert manifest data to string");
-        free(manifest_data);
+    // The extra digests and the index are optional; the walk stops early once both have been found
+    OptionalManifestFiles optional_files = { "", "", false, false };
+    build_module->read_memory_loaded_archive_entries(metadata_data, metadata_data_size,
+                                                     optional_manifest_files_walk_callback, &optional_files);
+    const std::string& extra_digests = optional_files.extra_digests;
+
+    // Build the lookup table before touching the contents archive
+    ContentsManifestTable table;
+    load_contents_manifest(manifest_str, optional_files.has_manifest_index ? &optional_files.manifest_index : nullptr,
+                           build_module->generate_string_checksum, table);
+
+    ContentsWalkState state = { &table, {}, nullptr };
+    state.fail_fast = verify_fail_fast();
+    contents_walk_prepare_extra_digests(state, extra_digests, build_module);
+    size_t worker_count = get_verify_worker_count();
+    bool walked = false;
+
+    if (worker_count <= 1 && !state.algorithms.empty()) {
+        // Hash every algorithm inline in one pass over each entry
+        walked = build_module->checksum_memory_loaded_archive_entries_multi(contents_data, contents_data_size,
+                                                                            state.algorithms,
+                                                                            contents_walk_checksums_callback, &state);
+    } else if (worker_count <= 1) {
+        // Hash inline while decompressing, without copying any entry data
+        walked = build_module->checksum_memory_loaded_archive_entries(contents_data, contents_data_size,
+                                                                      contents_walk_checksum_callback, &state);
+    } else {
+        // Decompress on this thread into buffers the worker pool hashes in place
+        state.build_module = build_module;
+
+        DPM_LOG(LOG_DEBUG, "Hashing contents with ", worker_count, " workers");
+
+        // every buffer is released at once when the package is done, after the pool has stopped
+        ExtractionBufferPool buffers;
+        state.buffers = &buffers;
+        WorkerPool pool(worker_count, worker_count * 4);
+        state.pool = &pool;
+        walked = build_module->take_memory_loaded_archive_entries_into(contents_data, contents_data_size,
+                                                                       ExtractionBufferPool::allocate, &buffers,
+                                                                       contents_walk_data_callback, &state);
+        pool.wait();
+    }
+
+    // A walk stopped by fail-fast is reported as a verification failure, not a read error
+    if (!walked && !state.stopped) {
+        dpm_log(LOG_ERROR, "Failed to read contents component archive");
         return 1;
     }
 
-    // Parse the manifest lines
-    std::istringstream manifest_stream(manifest_str);
-    std::string line;
-    int errors = 0;
-    int line_number = 0;
+    profile.add_files(state.table->entries.size());
+    return report_contents_walk_results(state);
+}
 
-    // Process each line in the manifest
-    while (std::getline(manifest_stream, line)) {
-        line_number++;
+/**
+ * @brief Records the checksum of each hook file as the hooks archive is walked
+ *
+ * @param entry_path Path of the entry relative to the hooks directory
+ * @param checksum Hexadecimal checksum of the entry, or NULL for non-regular files
+ * @param user_data Pointer to a map of hook filename to checksum
+ * @return Always 0 so the walk continues
+ */
+int hooks_walk_callback(const char* entry_path, const char* checksum, void* user_data)
+{
+    auto* calculated_checksums = static_cast<std::unordered_map<std::string, std::string>*>(user_data);
 
-        // Skip empty lines
-        if (line.empty()) {
-            continue;
-        }
+    if (checksum) {
+        (*calculated_checksums)[entry_path] = checksum;
+    }
 
-        // Parse the line into its components
-        std::istringstream iss(line);
-        char control_designation;
-        std::string expected_checksum, permissions, ownership, file_path;
+    return 0;
+}
 
-        // Extract components (C checksum permissions owner:group /path/to/file)
-        if (!(iss >> control_designation >> expected_checksum >> permissions >> ownership)) {
-            dpm_log(LOG_WARN, ("Malformed manifest line " + std::to_string(line_number) +
-                              ": " + line).c_str());
-            continue;
-        }
+/**
+ * @brief Compares each line of HOOKS_DIGEST with the checksums calculated for the hooks
+ *
+ * Stops at the first mismatch in fail-fast mode.
+ *
+ * @param stored_hooks_digest Contents of the HOOKS_DIGEST file
+ * @param calculated_checksums Map of hook filename to calculated checksum
+ * @return 0 if every hook matched, non-zero otherwise
+ */
+int compare_hooks_digest(
+    const std::string& stored_hooks_digest,
+    const std::unordered_map<std::string, std::string>& calculated_checksums)
+{
+    // Compare each line of HOOKS_DIGEST (checksum filename) with what was found
+    std::string_view remaining(stored_hooks_digest);
+    std::string_view line;
+    int errors = 0;
+    bool fail_fast = verify_fail_fast();
 
-        // Get the rest of the line as the file path
-        std::getline(iss >> std::ws, file_path);
+    while (manifest_next_line(remaining, line)) {
+        // Skip empty lines
+        if (line.empty()) continue;
 
-        if (file_path.empty()) {
-            dpm_log(LOG_WARN, ("Missing file path in manifest line " +
-                              std::to_string(line_number)).c_str());
+        std::string_view checksum, name;
+        if (!hooks_digest_parse_line(line, checksum, name)) {
+            dpm_log(LOG_WARN, ("Malformed hooks digest line: " + std::string(line)).c_str());
             continue;
         }
+        std::string filename(name);
 
-        // Remove leading slash if present
-        if (file_path[0] == '/') {
-            file_path = file_path.substr(1);
-        }
-
-        // Extract the file from the contents component
-        unsigned char* file_data = nullptr;
-        size_t file_size = 0;
-
-        result = get_file_from_component(
-            contents_data,
-            contents_data_size,
-            file_path,
-            &file_data,
-            &file_size
-        );
-
-        if (result != 0 || !file_data) {
-            dpm_log(LOG_ERROR, ("Failed to extract file from contents: " + file_path).c_str());
+        auto it = calculated_checksums.find(filename);
+        if (it == calculated_checksums.end()) {
+            dpm_log(LOG_ERROR, ("Hook file not found in hooks archive: " + filename).c_str());
             errors++;
-            continue;
-        }
-
-        // Calculate the checksum of the file data
-        std::string calculated_checksum;
-        result = dpm_execute_symbol(build_module, "generate_string_checksum",
-                                  std::string(reinterpret_cast<char*>(file_data), file_size),
-                                  &calculated_checksum);
-
-        // Free the file data now that we're done with it
-        free(file_data);
-
-        if (result != 0 || calculated_checksum.empty()) {
-            dpm_log(LOG_ERROR, ("Failed to calculate checksum for file: " + file_path).c_str());
+        } else if (it->second != checksum) {
+            dpm_log(LOG_ERROR, ("Checksum mismatch for hook " + filename +
+                               "\n  Expected: " + std::string(checksum) +
+                               "\n  Actual:   " + it->second).c_str());
             errors++;
-            continue;
         }
 
-        // Compare with the expected checksum
-        if (calculated_checksum != expected_checksum) {
-            dpm_log(LOG_ERROR, ("Checksum mismatch for " + file_path +
-                               "\n  Expected: " + expected_checksum +
-                               "\n  Actual:   " + calculated_checksum).c_str());
-            errors++;
+        if (errors > 0 && fail_fast) {
+            break;
         }
     }
 
-    // Clean up
-    free(manifest_data);
-
     if (errors > 0) {
-        dpm_log(LOG_ERROR, (std::to_string(errors) + " checksum errors found in contents manifest").c_str());
+        dpm_log(LOG_ERROR, (std::to_string(errors) + " checksum errors found in hooks digest").c_str());
         return 1;
     }
 
-    dpm_log(LOG_INFO, "Contents manifest checksum verification successful");
+    dpm_log(LOG_INFO, "Hooks digest verification successful");
     return 0;
 }
 
 /**
  * @brief Verifies the hooks digest from in-memory data
  *
- * Calculates the digest of the hooks archive and compares it with the
- * value stored in HOOKS_DIGEST metadata file.
+ * Hashes each hook file in the hooks archive in a single pass and compares
+ * it with the matching line of the HOOKS_DIGEST metadata file.
  *
  * @param hooks_data Pointer to the hooks component data
  * @param hooks_data_size Size of the hooks component data
  * @param metadata_data Pointer to the metadata component data
  * @param metadata_data_size Size of the metadata component data
- * @param build_module Handle to the loaded build module
+ * @param build_module Resolved build module function table
  * @return 0 on successful verification, non-zero on failure
  */
 int checksum_verify_hooks_digest_memory(
@@ -362,8 +621,11 @@ int checksum_verify_hooks_digest_memory(
     size_t hooks_data_size,
     const unsigned char* metadata_data,
     size_t metadata_data_size,
-    void* build_module)
+    const BuildModuleFunctions* build_module)
 {
+    DpmProfileScope profile("verify_hooks_digest");
+    profile.add_bytes(hooks_data_size);
+
     // Validate input parameters
     if (!hooks_data || hooks_data_size == 0 ||
         !metadata_data || metadata_data_size == 0 || !build_module) {
@@ -374,54 +636,19 @@ int checksum_verify_hooks_digest_memory(
     dpm_log(LOG_INFO, "Verifying hooks digest from in-memory data...");
 
     // Extract HOOKS_DIGEST from the metadata component
-    unsigned char* hooks_digest_data = nullptr;
-    size_t hooks_digest_size = 0;
-
-    int result = get_file_from_component(
-        metadata_data,
-        metadata_data_size,
-        "HOOKS_DIGEST",
-        &hooks_digest_data,
-        &hooks_digest_size
-    );
-
-    if (result != 0 || !hooks_digest_data || hooks_digest_size == 0) {
+    std::string stored_hooks_digest;
+    if (get_file_from_component(metadata_data, metadata_data_size, "HOOKS_DIGEST", stored_hooks_digest) != 0) {
         dpm_log(LOG_ERROR, "Failed to extract HOOKS_DIGEST from metadata component");
         return 1;
     }
 
-    // Convert binary data to string
-    std::string stored_hooks_digest = binary_to_string(hooks_digest_data, hooks_digest_size);
-    if (stored_hooks_digest.empty()) {
-        dpm_log(LOG_ERROR, "Failed to convert hooks digest data to string");
-        free(hooks_digest_data);
+    // Hash every hook in a single pass over the hooks archive
+    std::unordered_map<std::string, std::string> calculated_checksums;
+    if (!build_module->checksum_memory_loaded_archive_entries(hooks_data, hooks_data_size,
+                                                              hooks_walk_callback, &calculated_checksums)) {
+        dpm_log(LOG_ERROR, "Failed to read hooks component archive");
         return 1;
     }
 
-    // Trim whitespace and newlines
-    stored_hooks_digest = stored_hooks_digest.substr(0, stored_hooks_digest.find_first_of("\r\n"));
-
-    // Calculate the checksum for the hooks archive data
-    std::string calculated_hooks_digest;
-    result = dpm_execute_symbol(build_module, "generate_string_checksum",
-                              std::string(reinterpret_cast<const char*>(hooks_data), hooks_data_size),
-                              &calculated_hooks_digest);
-
-    // Clean up
-    free(hooks_digest_data);
-
-    if (result != 0 || calculated_hooks_digest.empty()) {
-        dpm_log(LOG_ERROR, "Failed to calculate hooks digest");
-        return 1;
-    }
-
-    // Compare with the stored digest
-    if (calculated_hooks_digest != stored_hooks_digest) {
-        dpm_log(LOG_ERROR, ("Hooks digest mismatch\n  Expected: " + stored_hooks_digest +
-                           "\n  Actual:   " + calculated_hooks_digest).c_str());
-        return 1;
-    }
-
-    dpm_log(LOG_INFO, "Hooks digest verification successful");
-    return 0;
+    return compare_hooks_digest(stored_hooks_digest, calculated_checksums);
 }
\ No newline at end of file
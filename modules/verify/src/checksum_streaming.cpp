@@ -0,0 +1,176 @@
+/**
+ * @file checksum_streaming.cpp
+ * @brief Implementation of bounded-memory package checksum verification functions
+ *
+ * Streams each component out of the package file through the build module
+ * and reuses the comparison and reporting logic of the in-memory path, so both
+ * modes pass and fail on exactly the same packages.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "checksum_streaming.hpp"
+
+/**
+ * @brief Captures the digest files as the metadata component is streamed
+ *
+ * @param entry_path Path of the entry relative to the metadata directory
+ * @param data Entry data, or NULL for non-regular files
+ * @param data_size Size of the entry data
+ * @param user_data Pointer to a StreamingMetadata
+ * @return Always 0 so the walk continues
+ */
+static int metadata_stream_callback(const char* entry_path, const unsigned char* data,
+                                    size_t data_size, void* user_data)
+{
+    StreamingMetadata* metadata = static_cast<StreamingMetadata*>(user_data);
+
+    if (!data) {
+        return 0;
+    }
+
+    std::string name = entry_path;
+    std::string value(reinterpret_cast<const char*>(data), data_size);
+
+    if (name == "PACKAGE_DIGEST") {
+        metadata->package_digest = value;
+        metadata->has_package_digest = true;
+    } else if (name == "CONTENTS_MANIFEST_DIGEST") {
+        metadata->contents_manifest = value;
+        metadata->has_contents_manifest = true;
+    } else if (name == "HOOKS_DIGEST") {
+        metadata->hooks_digest = value;
+        metadata->has_hooks_digest = true;
+    } else if (name == CONTENTS_EXTRA_DIGESTS_FILENAME) {
+        metadata->extra_digests = value;
+    } else if (name == CONTENTS_MANIFEST_INDEX_FILENAME) {
+        metadata->manifest_index = value;
+    }
+
+    return 0;
+}
+
+int read_streaming_metadata(
+    const std::string& package_path,
+    StreamingMetadata& metadata,
+    const BuildModuleFunctions* build_module)
+{
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to read_streaming_metadata");
+        return 1;
+    }
+
+    metadata = StreamingMetadata{};
+
+    if (!build_module->read_package_component_entries(package_path.c_str(), "metadata",
+                                                      STREAMING_METADATA_MAX_SIZE,
+                                                      metadata_stream_callback, &metadata)) {
+        dpm_log(LOG_ERROR, "Failed to read metadata component");
+        return 1;
+    }
+
+    if (!metadata.has_package_digest || metadata.package_digest.empty()) {
+        dpm_log(LOG_ERROR, "Failed to extract PACKAGE_DIGEST from metadata component");
+        return 1;
+    }
+
+    if (!metadata.has_contents_manifest || metadata.contents_manifest.empty()) {
+        dpm_log(LOG_ERROR, "Failed to extract CONTENTS_MANIFEST_DIGEST from metadata component");
+        return 1;
+    }
+
+    if (!metadata.has_hooks_digest || metadata.hooks_digest.empty()) {
+        dpm_log(LOG_ERROR, "Failed to extract HOOKS_DIGEST from metadata component");
+        return 1;
+    }
+
+    return 0;
+}
+
+int checksum_verify_package_digest_streaming(
+    const StreamingMetadata& metadata,
+    const BuildModuleFunctions* build_module)
+{
+    DpmProfileScope profile("verify_package_digest");
+
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to checksum_verify_package_digest_streaming");
+        return 1;
+    }
+
+    dpm_log(LOG_INFO, "Verifying package digest from streamed metadata...");
+
+    return compare_package_digest(metadata.package_digest, metadata.contents_manifest,
+                                  metadata.hooks_digest, build_module);
+}
+
+int checksum_verify_contents_digest_streaming(
+    const std::string& package_path,
+    const StreamingMetadata& metadata,
+    const BuildModuleFunctions* build_module)
+{
+    DpmProfileScope profile("verify_contents_digest");
+
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to checksum_verify_contents_digest_streaming");
+        return 1;
+    }
+
+    dpm_log(LOG_INFO, "Verifying contents manifest digest by streaming the contents component...");
+
+    // Build the lookup table before touching the contents archive
+    ContentsManifestTable table;
+    load_contents_manifest(metadata.contents_manifest,
+                           metadata.manifest_index.empty() ? nullptr : &metadata.manifest_index,
+                           build_module->generate_string_checksum, table);
+
+    // Always hash inline: handing entries to a worker pool would mean buffering them
+    ContentsWalkState state = { &table, {}, nullptr };
+    state.fail_fast = verify_fail_fast();
+    contents_walk_prepare_extra_digests(state, metadata.extra_digests, build_module);
+
+    bool walked;
+    if (state.algorithms.empty()) {
+        walked = build_module->checksum_package_component_entries(package_path.c_str(), "contents",
+                                                                  contents_walk_checksum_callback, &state);
+    } else {
+        walked = build_module->checksum_package_component_entries_multi(package_path.c_str(), "contents",
+                                                                        state.algorithms,
+                                                                        contents_walk_checksums_callback, &state);
+    }
+
+    if (!walked && !state.stopped) {
+        dpm_log(LOG_ERROR, "Failed to read contents component archive");
+        return 1;
+    }
+
+    profile.add_files(state.table->entries.size());
+    return report_contents_walk_results(state);
+}
+
+int checksum_verify_hooks_digest_streaming(
+    const std::string& package_path,
+    const StreamingMetadata& metadata,
+    const BuildModuleFunctions* build_module)
+{
+    DpmProfileScope profile("verify_hooks_digest");
+
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to checksum_verify_hooks_digest_streaming");
+        return 1;
+    }
+
+    dpm_log(LOG_INFO, "Verifying hooks digest by streaming the hooks component...");
+
+    std::unordered_map<std::string, std::string> calculated_checksums;
+    if (!build_module->checksum_package_component_entries(package_path.c_str(), "hooks",
+                                                          hooks_walk_callback, &calculated_checksums)) {
+        dpm_log(LOG_ERROR, "Failed to read hooks component archive");
+        return 1;
+    }
+
+    return compare_hooks_digest(metadata.hooks_digest, calculated_checksums);
+}
@@ -17,6 +17,12 @@ Command parse_command(const char* cmd_str) {
     else if (strcmp(cmd_str, "check") == 0) {
         return CMD_CHECK;
     }
+    else if (strcmp(cmd_str, "cache-prune") == 0) {
+        return CMD_CACHE_PRUNE;
+    }
+    else if (strcmp(cmd_str, "range") == 0) {
+        return CMD_RANGE;
+    }
 
     return CMD_UNKNOWN;
 }
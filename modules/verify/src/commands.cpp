@@ -12,23 +12,6 @@
 
 #include "commands.hpp"
 
-int check_and_load_build_module(void*& module_handle) {
-    // Check if build module exists
-    if (!dpm_module_exists("build")) {
-        dpm_log(LOG_ERROR, "Build module not found");
-        return 1;
-    }
-
-    // Load the build module
-    int result = dpm_load_module("build", &module_handle);
-    if (result != 0) {
-        dpm_log(LOG_ERROR, "Failed to load build module");
-        return result;
-    }
-
-    return 0;
-}
-
 int cmd_checksum_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "Usage: dpm verify checksum [options]");
     dpm_con(LOG_INFO, "");
@@ -37,14 +20,31 @@ int cmd_checksum_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "Options:");
     dpm_con(LOG_INFO, "  -p, --package PATH     Path to a package file (.dpm)");
     dpm_con(LOG_INFO, "  -s, --stage DIR        Path to a package stage directory");
+    dpm_con(LOG_INFO, "  -b, --batch SOURCE     Verify every package in a directory or matching a glob");
+    dpm_con(LOG_INFO, "  -l, --list FILE        Verify every package listed in FILE (\"-\" for stdin)");
+    dpm_con(LOG_INFO, "  -o, --summary FILE     Write the batch results to FILE instead of stdout");
+    dpm_con(LOG_INFO, "  -j, --jobs N           Number of worker threads used for hashing");
+    dpm_con(LOG_INFO, "                         (defaults to [verify] threads, or all cores)");
+    dpm_con(LOG_INFO, "  -S, --streaming        Stream components from the package with bounded memory");
+    dpm_con(LOG_INFO, "                         (package mode only, hashes on a single thread)");
+    dpm_con(LOG_INFO, "  -n, --no-cache         Ignore and do not update the verification cache");
+    dpm_con(LOG_INFO, "  -f, --fail-fast        Stop at the first mismatch and cancel outstanding hashing");
+    dpm_con(LOG_INFO, "  -F, --full-report      Run every check and report every mismatch (default,");
+    dpm_con(LOG_INFO, "                         overrides [verify] fail_fast)");
     dpm_con(LOG_INFO, "  -v, --verbose          Enable verbose output");
     dpm_con(LOG_INFO, "  -h, --help             Display this help message");
     dpm_con(LOG_INFO, "");
-    dpm_con(LOG_INFO, "Note: --package and --stage are mutually exclusive options.");
+    dpm_con(LOG_INFO, "Note: --package, --stage and batch mode (--batch/--list) are mutually exclusive.");
+    dpm_con(LOG_INFO, "The package digest and hooks digest are checked before the contents are hashed.");
+    dpm_con(LOG_INFO, "In batch mode --jobs sets how many packages are verified at once, and one");
+    dpm_con(LOG_INFO, "JSON object per package is written, followed by a summary object.");
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Examples:");
     dpm_con(LOG_INFO, "  dpm verify checksum --package=mypackage-1.0.x86_64.dpm");
-    dpm_con(LOG_INFO, "  dpm verify checksum --stage=./mypackage-1.0.x86_64");
+    dpm_con(LOG_INFO, "  dpm verify checksum --stage=./mypackage-1.0.x86_64 --jobs 16");
+    dpm_con(LOG_INFO, "  dpm verify checksum --package=mypackage-1.0.x86_64.dpm --streaming");
+    dpm_con(LOG_INFO, "  dpm verify checksum --package=mypackage-1.0.x86_64.dpm --fail-fast");
+    dpm_con(LOG_INFO, "  dpm verify checksum --batch /srv/mirror --jobs 32 --summary results.jsonl");
     return 0;
 }
 
@@ -52,6 +52,14 @@ int cmd_checksum(int argc, char** argv) {
     // Parse command line arguments
     std::string package_path = "";
     std::string stage_dir = "";
+    std::vector<std::string> batch_sources;
+    std::vector<std::string> batch_lists;
+    std::string summary_path = "";
+    int jobs = 0;
+    bool streaming = false;
+    bool no_cache = false;
+    bool fail_fast = false;
+    bool full_report = false;
     bool verbose = false;
     bool show_help = false;
 
@@ -69,6 +77,34 @@ int cmd_checksum(int argc, char** argv) {
                 stage_dir = argv[i + 1];
                 i++; // Skip the next argument
             }
+        } else if (arg == "-b" || arg == "--batch") {
+            if (i + 1 < argc) {
+                batch_sources.push_back(argv[i + 1]);
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-l" || arg == "--list") {
+            if (i + 1 < argc) {
+                batch_lists.push_back(argv[i + 1]);
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-o" || arg == "--summary") {
+            if (i + 1 < argc) {
+                summary_path = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 < argc) {
+                jobs = atoi(argv[i + 1]);
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-S" || arg == "--streaming") {
+            streaming = true;
+        } else if (arg == "-n" || arg == "--no-cache") {
+            no_cache = true;
+        } else if (arg == "-f" || arg == "--fail-fast") {
+            fail_fast = true;
+        } else if (arg == "-F" || arg == "--full-report") {
+            full_report = true;
         } else if (arg == "-v" || arg == "--verbose") {
             verbose = true;
         } else if (arg == "-h" || arg == "--help" || arg == "help") {
@@ -81,11 +117,55 @@ int cmd_checksum(int argc, char** argv) {
         return cmd_checksum_help(argc, argv);
     }
 
+    if (jobs < 0) {
+        dpm_con(LOG_ERROR, "--jobs must be a positive number");
+        return cmd_checksum_help(argc, argv);
+    }
+    if (fail_fast && full_report) {
+        dpm_con(LOG_ERROR, "Cannot specify both --fail-fast and --full-report");
+        return cmd_checksum_help(argc, argv);
+    }
+
+    set_verify_worker_count(jobs);
+    set_verify_cache_disabled(no_cache);
+    set_verify_fail_fast(fail_fast ? 1 : (full_report ? 0 : -1));
+
     // Set verbose logging if requested
     if (verbose) {
         dpm_set_logging_level(LOG_DEBUG);
     }
 
+    bool batch = !batch_sources.empty() || !batch_lists.empty();
+    if (batch) {
+        if (!package_path.empty() || !stage_dir.empty()) {
+            dpm_con(LOG_ERROR, "Cannot combine batch mode with --package or --stage");
+            return cmd_checksum_help(argc, argv);
+        }
+
+        std::vector<std::string> packages;
+        for (const auto& source : batch_sources) {
+            if (collect_batch_packages(source, packages) != 0) {
+                return 1;
+            }
+        }
+        for (const auto& list : batch_lists) {
+            if (read_batch_list(list, packages) != 0) {
+                return 1;
+            }
+        }
+
+        // Parallelism moves to the package level; each package is hashed on its own worker
+        size_t worker_count = get_verify_worker_count();
+        set_verify_worker_count(1);
+
+        // Keep per-package progress out of the results unless asked for
+        if (!verbose) {
+            dpm_set_logging_level(LOG_WARN);
+        }
+
+        return verify_checksums_batch(packages, worker_count, streaming, summary_path);
+    }
+
     // Validate that either package_path or stage_dir is provided, but not both
     if (package_path.empty() && stage_dir.empty()) {
         dpm_con(LOG_ERROR, "Either --package or --stage must be specified");
@@ -97,12 +177,21 @@ int cmd_checksum(int argc, char** argv) {
         return cmd_checksum_help(argc, argv);
     }
 
+    if (streaming && package_path.empty()) {
+        dpm_con(LOG_ERROR, "--streaming can only be used with --package");
+        return cmd_checksum_help(argc, argv);
+    }
+
     // Call the appropriate verification function
     if (!package_path.empty()) {
-        return verify_checksums_package(package_path);
-    } else {
-        return verify_checksums_stage(stage_dir);
+        return verify_checksums_package_cached(package_path, streaming);
+    }
+
+    int result = verify_checksums_stage(stage_dir);
+    if (result != 0) {
+        dpm_metric_add(DPM_METRIC_VERIFY_FAILURES, 1);
     }
+    return result;
 }
 
 int cmd_signature_help(int argc, char** argv) {
@@ -111,16 +200,20 @@ int cmd_signature_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "Verifies the signatures of packages or package stage directories.");
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Options:");
-    dpm_con(LOG_INFO, "  -p, --package PATH     Path to a package file (.dpm)");
+    dpm_con(LOG_INFO, "  -p, --package PATH     Path or http(s):// URL of a package file (.dpm)");
     dpm_con(LOG_INFO, "  -s, --stage DIR        Path to a package stage directory");
+    dpm_con(LOG_INFO, "  -m, --metadata-only    Only verify the signature of the metadata component of a package");
     dpm_con(LOG_INFO, "  -v, --verbose          Enable verbose output");
     dpm_con(LOG_INFO, "  -h, --help             Display this help message");
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Note: --package and --stage are mutually exclusive options.");
+    dpm_con(LOG_INFO, "The metadata records the digests of the other components, so a remote package");
+    dpm_con(LOG_INFO, "checked with --metadata-only is checked without transferring its contents.");
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Examples:");
     dpm_con(LOG_INFO, "  dpm verify signature --package=mypackage-1.0.x86_64.dpm");
     dpm_con(LOG_INFO, "  dpm verify signature --stage=./mypackage-1.0.x86_64");
+    dpm_con(LOG_INFO, "  dpm verify signature -m -p https://repo.example.org/mypackage-1.0.x86_64.dpm");
     return 0;
 }
 
@@ -128,6 +221,7 @@ int cmd_signature(int argc, char** argv) {
     // Parse command line arguments
     std::string package_path = "";
     std::string stage_dir = "";
+    bool metadata_only = false;
     bool verbose = false;
     bool show_help = false;
 
@@ -145,6 +239,8 @@ int cmd_signature(int argc, char** argv) {
                 stage_dir = argv[i + 1];
                 i++; // Skip the next argument
             }
+        } else if (arg == "-m" || arg == "--metadata-only") {
+            metadata_only = true;
         } else if (arg == "-v" || arg == "--verbose") {
             verbose = true;
         } else if (arg == "-h" || arg == "--help" || arg == "help") {
@@ -173,12 +269,193 @@ int cmd_signature(int argc, char** argv) {
         return cmd_signature_help(argc, argv);
     }
 
+    if (metadata_only && !stage_dir.empty()) {
+        dpm_con(LOG_ERROR, "--metadata-only can only be used with --package");
+        return cmd_signature_help(argc, argv);
+    }
+
     // Call the appropriate verification function
-    if (!package_path.empty()) {
-        return verify_signature_package(package_path);
-    } else {
-        return verify_signature_stage(stage_dir);
+    int result = !package_path.empty() ? verify_signature_package(package_path, metadata_only)
+                                       : verify_signature_stage(stage_dir);
+    if (result != 0) {
+        dpm_metric_add(DPM_METRIC_VERIFY_FAILURES, 1);
+    }
+    return result;
+}
+
+int cmd_cache_prune_help(int argc, char** argv) {
+    dpm_con(LOG_INFO, "Usage: dpm verify cache-prune [options]");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Removes entries from the verification cache whose packages have been");
+    dpm_con(LOG_INFO, "removed or modified since they were verified.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Options:");
+    dpm_con(LOG_INFO, "  -a, --all              Remove every entry in the cache");
+    dpm_con(LOG_INFO, "  -m, --max-age DAYS     Also remove entries verified more than DAYS days ago");
+    dpm_con(LOG_INFO, "  -v, --verbose          Enable verbose output");
+    dpm_con(LOG_INFO, "  -h, --help             Display this help message");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "The cache is stored in [verify] cache_dir (default " VERIFY_CACHE_DEFAULT_DIR ").");
+    return 0;
+}
+
+int cmd_cache_prune(int argc, char** argv) {
+    // Parse command line arguments
+    bool remove_all = false;
+    int max_age_days = 0;
+    bool verbose = false;
+    bool show_help = false;
+
+    // Process command-line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-a" || arg == "--all") {
+            remove_all = true;
+        } else if (arg == "-m" || arg == "--max-age") {
+            if (i + 1 < argc) {
+                max_age_days = atoi(argv[i + 1]);
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "-h" || arg == "--help" || arg == "help") {
+            show_help = true;
+        }
+    }
+
+    // If help was requested, show it and return
+    if (show_help) {
+        return cmd_cache_prune_help(argc, argv);
+    }
+
+    if (max_age_days < 0) {
+        dpm_con(LOG_ERROR, "--max-age must be a positive number of days");
+        return cmd_cache_prune_help(argc, argv);
+    }
+
+    // Set verbose logging if requested
+    if (verbose) {
+        dpm_set_logging_level(LOG_DEBUG);
+    }
+
+    int removed = verify_cache_prune(remove_all, max_age_days);
+    if (removed < 0) {
+        return 1;
+    }
+
+    dpm_con(LOG_INFO, ("Removed " + std::to_string(removed) + " verification cache entries from " +
+                      verify_cache_dir()).c_str());
+    return 0;
+}
+
+int cmd_range_help(int argc, char** argv) {
+    dpm_con(LOG_INFO, "Usage: dpm verify range [options]");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Verifies part of a large file in a package stage directory against the chunk");
+    dpm_con(LOG_INFO, "digests recorded for it, reading only the chunks that overlap the range.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Options:");
+    dpm_con(LOG_INFO, "  -s, --stage DIR        Path to a package stage directory");
+    dpm_con(LOG_INFO, "  -f, --file PATH        Path of the file as listed in the contents manifest");
+    dpm_con(LOG_INFO, "  -o, --offset BYTES     Offset of the first byte to verify (default 0)");
+    dpm_con(LOG_INFO, "  -l, --length BYTES     Number of bytes to verify (default: to the end of the file)");
+    dpm_con(LOG_INFO, "  -j, --jobs N           Number of worker threads used for hashing");
+    dpm_con(LOG_INFO, "                         (defaults to [verify] threads, or all cores)");
+    dpm_con(LOG_INFO, "  -v, --verbose          Enable verbose output");
+    dpm_con(LOG_INFO, "  -h, --help             Display this help message");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Only files of at least [build] contents_chunk_min bytes have chunk digests.");
+    dpm_con(LOG_INFO, "");
+    dpm_con(LOG_INFO, "Examples:");
+    dpm_con(LOG_INFO, "  dpm verify range --stage ./mypackage-1.0.x86_64 --file /usr/share/big.img");
+    dpm_con(LOG_INFO, "  dpm verify range --stage ./mypackage-1.0.x86_64 --file /usr/share/big.img --offset 1073741824 --length 4194304");
+    return 0;
+}
+
+int cmd_range(int argc, char** argv) {
+    // Parse command line arguments
+    std::string stage_dir = "";
+    std::string file_path = "";
+    std::string offset_arg = "0";
+    std::string length_arg = "0";
+    int jobs = 0;
+    bool verbose = false;
+    bool show_help = false;
+
+    // Process command-line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-s" || arg == "--stage") {
+            if (i + 1 < argc) {
+                stage_dir = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-f" || arg == "--file") {
+            if (i + 1 < argc) {
+                file_path = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-o" || arg == "--offset") {
+            if (i + 1 < argc) {
+                offset_arg = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-l" || arg == "--length") {
+            if (i + 1 < argc) {
+                length_arg = argv[i + 1];
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 < argc) {
+                jobs = atoi(argv[i + 1]);
+                i++; // Skip the next argument
+            }
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "-h" || arg == "--help" || arg == "help") {
+            show_help = true;
+        }
+    }
+
+    // If help was requested, show it and return
+    if (show_help) {
+        return cmd_range_help(argc, argv);
+    }
+
+    if (stage_dir.empty() || file_path.empty()) {
+        dpm_con(LOG_ERROR, "Both --stage and --file must be specified");
+        return cmd_range_help(argc, argv);
+    }
+
+    if (offset_arg.find_first_not_of("0123456789") != std::string::npos ||
+        length_arg.find_first_not_of("0123456789") != std::string::npos ||
+        offset_arg.empty() || length_arg.empty()) {
+        dpm_con(LOG_ERROR, "--offset and --length must be numbers of bytes");
+        return cmd_range_help(argc, argv);
+    }
+
+    if (jobs < 0) {
+        dpm_con(LOG_ERROR, "--jobs must be a positive number");
+        return cmd_range_help(argc, argv);
+    }
+
+    set_verify_worker_count(jobs);
+
+    // Set verbose logging if requested
+    if (verbose) {
+        dpm_set_logging_level(LOG_DEBUG);
+    }
+
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Failed to load build module");
+        return 1;
     }
+
+    return checksum_verify_contents_range(stage_dir, file_path, std::stoull(offset_arg), std::stoull(length_arg),
+                                          build_module);
 }
 
 int cmd_check_help(int argc, char** argv) {
@@ -197,10 +474,12 @@ int cmd_help(int argc, char** argv) {
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Available commands:");
     dpm_con(LOG_INFO, "");
-    dpm_con(LOG_INFO, "  checksum   - Verify checksums of package files or stage directories");
-    dpm_con(LOG_INFO, "  signature  - Verify signatures of package files or stage directories");
-    dpm_con(LOG_INFO, "  check      - Check build module integration");
-    dpm_con(LOG_INFO, "  help       - Display this help message");
+    dpm_con(LOG_INFO, "  checksum    - Verify checksums of package files or stage directories");
+    dpm_con(LOG_INFO, "  signature   - Verify signatures of package files or stage directories");
+    dpm_con(LOG_INFO, "  check       - Check build module integration");
+    dpm_con(LOG_INFO, "  cache-prune - Remove stale entries from the verification cache");
+    dpm_con(LOG_INFO, "  range       - Verify a byte range of a large file in a stage directory");
+    dpm_con(LOG_INFO, "  help        - Display this help message");
     dpm_con(LOG_INFO, "");
     dpm_con(LOG_INFO, "Usage: dpm verify <command>");
     dpm_con(LOG_INFO, "");
@@ -245,30 +524,22 @@ int cmd_check(int argc, char** argv) {
 
     dpm_log(LOG_INFO, "Checking build module integration...");
 
-    void* module_handle = nullptr;
-    int result = check_and_load_build_module(module_handle);
-
-    if (result != 0) {
+    // Loading through the service also resolves every symbol verify depends on
+    if (!dpm_build_module()) {
         dpm_log(LOG_ERROR, "Failed to load build module.");
         return 1;
     }
 
-    dpm_log(LOG_INFO, "Successfully loaded build module.");
+    dpm_log(LOG_INFO, "Successfully loaded build module and resolved its functions.");
 
     // Check if the dpm_module_execute symbol exists
-    if (!dpm_symbol_exists(module_handle, "dpm_module_execute")) {
+    if (!dpm_symbol_exists(BuildModuleService::instance().handle(), "dpm_module_execute")) {
         dpm_log(LOG_ERROR, "Symbol 'dpm_module_execute' not found in build module.");
-        dpm_unload_module(module_handle);
         return 1;
     }
 
     dpm_log(LOG_INFO, "Symbol 'dpm_module_execute' found in build module.");
 
-    // Clean up
-    if (module_handle) {
-        dpm_unload_module(module_handle);
-    }
-
     return 0;
 }
 
@@ -282,74 +553,93 @@ int cmd_check(int argc, char** argv) {
  * @return 0 on success, non-zero on failure
  */
 int verify_checksums_package_memory(const std::string& package_path) {
-    // Check if the package file exists
-    if (!std::filesystem::exists(package_path)) {
+    // Check if the package file exists, remote packages are fetched by the build module
+    if (!dpm_package_is_url(package_path) && !std::filesystem::exists(package_path)) {
         dpm_log(LOG_ERROR, ("Package file not found: " + package_path).c_str());
         return 1;
     }
 
     dpm_log(LOG_INFO, ("Verifying checksums for package in memory: " + package_path).c_str());
 
-    // Load the build module
-    void* build_module = nullptr;
-    int result = check_and_load_build_module(build_module);
-    if (result != 0 || build_module == nullptr) {
+    // Get the shared build module function table
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
         dpm_log(LOG_ERROR, "Failed to load build module");
         return 1;
     }
 
-    // Extract package components into memory
-    unsigned char* metadata_data = nullptr;
+    // Map the package once; components are viewed in place rather than copied
+    void* reader = build_module->package_reader_open(package_path.c_str());
+    if (!reader) {
+        dpm_log(LOG_ERROR, ("Failed to open package: " + package_path).c_str());
+        return 1;
+    }
+
+    const unsigned char* metadata_data = nullptr;
     size_t metadata_data_size = 0;
-    unsigned char* contents_data = nullptr;
+    const unsigned char* contents_data = nullptr;
     size_t contents_data_size = 0;
-    unsigned char* hooks_data = nullptr;
+    const unsigned char* hooks_data = nullptr;
     size_t hooks_data_size = 0;
 
-    // Load metadata component
-    dpm_log(LOG_INFO, "Loading metadata component...");
-    result = get_component_from_package(package_path, "metadata", &metadata_data, &metadata_data_size);
-    if (result != 0 || !metadata_data || metadata_data_size == 0) {
+    // Locate the components
+    if (!build_module->package_reader_get_member(reader, "metadata", &metadata_data, &metadata_data_size) ||
+        metadata_data_size == 0) {
         dpm_log(LOG_ERROR, "Failed to load metadata component");
-        dpm_unload_module(build_module);
+        build_module->package_reader_close(reader);
         return 1;
     }
 
-    // Load contents component
-    dpm_log(LOG_INFO, "Loading contents component...");
-    result = get_component_from_package(package_path, "contents", &contents_data, &contents_data_size);
-    if (result != 0 || !contents_data || contents_data_size == 0) {
+    if (!build_module->package_reader_get_member(reader, "contents", &contents_data, &contents_data_size) ||
+        contents_data_size == 0) {
         dpm_log(LOG_ERROR, "Failed to load contents component");
-        free(metadata_data);
-        dpm_unload_module(build_module);
+        build_module->package_reader_close(reader);
         return 1;
     }
 
-    // Load hooks component
-    dpm_log(LOG_INFO, "Loading hooks component...");
-    result = get_component_from_package(package_path, "hooks", &hooks_data, &hooks_data_size);
-    if (result != 0 || !hooks_data || hooks_data_size == 0) {
+    if (!build_module->package_reader_get_member(reader, "hooks", &hooks_data, &hooks_data_size) ||
+        hooks_data_size == 0) {
         dpm_log(LOG_ERROR, "Failed to load hooks component");
-        free(metadata_data);
-        free(contents_data);
-        dpm_unload_module(build_module);
+        build_module->package_reader_close(reader);
         return 1;
     }
 
+    // Cheapest checks first so a bad package is rejected before its contents are hashed
+    bool fail_fast = verify_fail_fast();
+    int failures = 0;
+
     // Verify package digest
     dpm_log(LOG_INFO, "Verifying package digest...");
-    result = checksum_verify_package_digest_memory(
+    int result = checksum_verify_package_digest_memory(
         metadata_data,
         metadata_data_size,
         build_module
     );
     if (result != 0) {
         dpm_log(LOG_ERROR, "Package digest verification failed");
-        free(metadata_data);
-        free(contents_data);
-        free(hooks_data);
-        dpm_unload_module(build_module);
-        return 1;
+        failures++;
+        if (fail_fast) {
+            build_module->package_reader_close(reader);
+            return 1;
+        }
+    }
+
+    // Verify hooks digest
+    dpm_log(LOG_INFO, "Verifying hooks digest...");
+    result = checksum_verify_hooks_digest_memory(
+        hooks_data,
+        hooks_data_size,
+        metadata_data,
+        metadata_data_size,
+        build_module
+    );
+    if (result != 0) {
+        dpm_log(LOG_ERROR, "Hooks digest verification failed");
+        failures++;
+        if (fail_fast) {
+            build_module->package_reader_close(reader);
+            return 1;
+        }
     }
 
     // Verify contents manifest digest
@@ -363,37 +653,120 @@ int verify_checksums_package_memory(const std::string& package_path) {
     );
     if (result != 0) {
         dpm_log(LOG_ERROR, "Contents manifest verification failed");
-        free(metadata_data);
-        free(contents_data);
-        free(hooks_data);
-        dpm_unload_module(build_module);
+        failures++;
+    }
+
+    build_module->package_reader_close(reader);
+
+    if (failures > 0) {
+        dpm_log(LOG_ERROR, (std::to_string(failures) + " of 3 checksum checks failed").c_str());
+        return 1;
+    }
+
+    dpm_log(LOG_INFO, "All in-memory checksums verified successfully");
+    return 0;
+}
+
+int verify_checksums_package_streaming(const std::string& package_path) {
+    // Check if the package file exists, remote packages are fetched by the build module
+    if (!dpm_package_is_url(package_path) && !std::filesystem::exists(package_path)) {
+        dpm_log(LOG_ERROR, ("Package file not found: " + package_path).c_str());
         return 1;
     }
 
+    dpm_log(LOG_INFO, ("Verifying checksums for package by streaming: " + package_path).c_str());
+
+    // Get the shared build module function table
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Failed to load build module");
+        return 1;
+    }
+
+    // Only the small digest files are ever buffered
+    dpm_log(LOG_INFO, "Reading metadata component...");
+    StreamingMetadata metadata;
+    if (read_streaming_metadata(package_path, metadata, build_module) != 0) {
+        dpm_log(LOG_ERROR, "Failed to load metadata component");
+        return 1;
+    }
+
+    // Cheapest checks first so a bad package is rejected before its contents are streamed
+    bool fail_fast = verify_fail_fast();
+    int failures = 0;
+
+    // Verify package digest
+    dpm_log(LOG_INFO, "Verifying package digest...");
+    if (checksum_verify_package_digest_streaming(metadata, build_module) != 0) {
+        dpm_log(LOG_ERROR, "Package digest verification failed");
+        failures++;
+        if (fail_fast) {
+            return 1;
+        }
+    }
+
     // Verify hooks digest
     dpm_log(LOG_INFO, "Verifying hooks digest...");
-    result = checksum_verify_hooks_digest_memory(
-        hooks_data,
-        hooks_data_size,
-        metadata_data,
-        metadata_data_size,
-        build_module
-    );
-    if (result != 0) {
+    if (checksum_verify_hooks_digest_streaming(package_path, metadata, build_module) != 0) {
         dpm_log(LOG_ERROR, "Hooks digest verification failed");
-        free(metadata_data);
-        free(contents_data);
-        free(hooks_data);
-        dpm_unload_module(build_module);
-        return 1;
+        failures++;
+        if (fail_fast) {
+            return 1;
+        }
+    }
+
+    // Verify contents manifest digest
+    dpm_log(LOG_INFO, "Verifying contents manifest digest...");
+    if (checksum_verify_contents_digest_streaming(package_path, metadata, build_module) != 0) {
+        dpm_log(LOG_ERROR, "Contents manifest verification failed");
+        failures++;
     }
 
-    // Clean up
-    free(metadata_data);
-    free(contents_data);
-    free(hooks_data);
-    dpm_unload_module(build_module);
+    if (failures > 0) {
+        dpm_log(LOG_ERROR, (std::to_string(failures) + " of 3 checksum checks failed").c_str());
+        return 1;
+    }
 
-    dpm_log(LOG_INFO, "All in-memory checksums verified successfully");
+    dpm_log(LOG_INFO, "All streamed checksums verified successfully");
     return 0;
-}
\ No newline at end of file
+}
+
+int verify_checksums_package_cached(const std::string& package_path, bool streaming, bool* cache_hit) {
+    VerifyCacheKey cache_key;
+    bool cacheable = false;
+
+    if (cache_hit) {
+        *cache_hit = false;
+    }
+
+    // The key is taken before verifying so a package modified mid-run can never produce a hit later
+    if (verify_cache_enabled()) {
+        const BuildModuleFunctions* build_module = dpm_build_module();
+        cacheable = build_module && verify_cache_make_key(package_path, cache_key, build_module);
+
+        if (cacheable && verify_cache_lookup(cache_key)) {
+            dpm_log(LOG_INFO, ("Package unchanged since last successful verification, skipping: " + package_path).c_str());
+            dpm_metric_add(DPM_METRIC_VERIFY_CACHE_HITS, 1);
+            if (cache_hit) {
+                *cache_hit = true;
+            }
+            return 0;
+        }
+        dpm_metric_add(DPM_METRIC_VERIFY_CACHE_MISSES, 1);
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    int result = streaming ? verify_checksums_package_streaming(package_path)
+                           : verify_checksums_package_memory(package_path);
+    dpm_metric_observe(DPM_METRIC_VERIFY_SECONDS,
+                       std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+
+    if (result != 0) {
+        dpm_metric_add(DPM_METRIC_VERIFY_FAILURES, 1);
+    }
+    if (result == 0 && cacheable) {
+        verify_cache_store(cache_key);
+    }
+
+    return result;
+}
@@ -0,0 +1,398 @@
+/**
+ * @file contents_manifest.cpp
+ * @brief Implementation of CONTENTS_MANIFEST_DIGEST parsing and result reporting
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "contents_manifest.hpp"
+
+// Fail-fast mode requested on the command line, -1 when not set
+static int g_verify_fail_fast_override = -1;
+
+/**
+ * @brief Parses CONTENTS_MANIFEST_DIGEST into a path lookup table
+ *
+ * Each well-formed line is recorded under its path (without the leading slash)
+ * so that archive entries can be matched against it in constant time.  The order
+ * of the manifest is preserved in the entries vector for deterministic reporting.
+ *
+ * @param manifest_str Contents of the CONTENTS_MANIFEST_DIGEST file
+ * @param table Lookup table to populate
+ * @return Number of malformed lines that were skipped
+ */
+int parse_contents_manifest(const std::string& manifest_str, ContentsManifestTable& table)
+{
+    std::string_view remaining(manifest_str);
+    std::string_view line;
+    int malformed = 0;
+    int line_number = 0;
+
+    // every checksum has the length of the first, which lets the rest be split at fixed offsets
+    size_t digest_length = 0;
+
+    while (manifest_next_line(remaining, line)) {
+        line_number++;
+
+        // Skip empty lines
+        if (line.empty()) {
+            continue;
+        }
+
+        // Split the line into its components (C checksum permissions owner:group /path/to/file)
+        ManifestLine entry;
+        if (!manifest_parse_line(line, entry, digest_length)) {
+            dpm_log(LOG_WARN, ("Malformed manifest line " + std::to_string(line_number) +
+                              ": " + std::string(line)).c_str());
+            malformed++;
+            continue;
+        }
+        if (digest_length == 0) {
+            digest_length = entry.checksum.size();
+        }
+
+        // Remove leading slash if present
+        std::string file_path(manifest_relative_path(entry.path));
+        if (file_path.empty()) {
+            dpm_log(LOG_WARN, ("Missing file path in manifest line " +
+                              std::to_string(line_number)).c_str());
+            malformed++;
+            continue;
+        }
+
+        if (table.index.find(file_path) != table.index.end()) {
+            dpm_log(LOG_WARN, ("Duplicate manifest entry on line " + std::to_string(line_number) +
+                              ": " + file_path).c_str());
+            malformed++;
+            continue;
+        }
+
+        table.index[file_path] = table.entries.size();
+        table.entries.push_back({file_path, std::string(entry.checksum), line_number, false, false, false, "", {}, {}});
+    }
+
+    return malformed;
+}
+
+int load_contents_manifest(const std::string& manifest_str, const std::string* index_data,
+                           std::string (*generate_string_checksum)(const std::string&),
+                           ContentsManifestTable& table)
+{
+    ManifestIndex index;
+    if (!index_data || !index.attach(index_data->data(), index_data->size()) ||
+        !index.matches(manifest_str.size(), generate_string_checksum(manifest_str))) {
+        if (index_data) {
+            dpm_log(LOG_DEBUG, "Contents manifest index does not match the manifest, parsing the manifest");
+        }
+        return parse_contents_manifest(manifest_str, table);
+    }
+
+    // the index is in path order, the table keeps manifest order for reporting
+    std::vector<size_t> order(index.size());
+    for (size_t position = 0; position < order.size(); position++) {
+        order[position] = position;
+    }
+    std::sort(order.begin(), order.end(), [&index](size_t a, size_t b) {
+        return index.entry(a).line_number < index.entry(b).line_number;
+    });
+
+    table.entries.reserve(table.entries.size() + order.size());
+    table.index.reserve(table.index.size() + order.size());
+    for (size_t position : order) {
+        ManifestIndexEntry entry = index.entry(position);
+        std::string path(entry.path);
+        table.index[path] = table.entries.size();
+        table.entries.push_back({path, entry.checksum(), static_cast<int>(entry.line_number), false, false, false, "", {}, {}});
+    }
+
+    DPM_LOG(LOG_DEBUG, "Loaded ", order.size(), " manifest entries from the binary index");
+    return 0;
+}
+
+bool parse_contents_chunks(const std::string& chunks_str, ContentsChunkTable& table)
+{
+    std::istringstream chunks_stream(chunks_str);
+    std::string line;
+
+    table = ContentsChunkTable();
+
+    const std::string algorithm_prefix = "# algorithm: ";
+    const std::string chunk_size_prefix = "# chunk_size: ";
+    if (!std::getline(chunks_stream, line) || line != "# dpm chunk manifest v1" ||
+        !std::getline(chunks_stream, line) || line.compare(0, algorithm_prefix.size(), algorithm_prefix) != 0) {
+        dpm_log(LOG_WARN, "Ignoring chunk manifest with unknown format");
+        return false;
+    }
+    table.algorithm = line.substr(algorithm_prefix.size());
+
+    if (!std::getline(chunks_stream, line) || line.compare(0, chunk_size_prefix.size(), chunk_size_prefix) != 0) {
+        dpm_log(LOG_WARN, "Ignoring chunk manifest without a chunk size");
+        table = ContentsChunkTable();
+        return false;
+    }
+    table.chunk_size = strtoull(line.c_str() + chunk_size_prefix.size(), nullptr, 10);
+
+    // Records: root size chunk_count /path, followed by chunk_count digest lines
+    while (std::getline(chunks_stream, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        std::istringstream iss(line);
+        ContentsChunkRecord record;
+        size_t chunk_count = 0;
+        bool complete = static_cast<bool>(iss >> record.expected_root >> record.file_size >> chunk_count);
+        std::getline(iss >> std::ws, record.path);
+        if (!record.path.empty() && record.path[0] == '/') {
+            record.path = record.path.substr(1);
+        }
+
+        // the chunks of a record must cover exactly the recorded size
+        complete = complete && !record.path.empty() && table.chunk_size > 0 &&
+                   chunk_count == (record.file_size + table.chunk_size - 1) / table.chunk_size;
+
+        record.expected_chunks.resize(complete ? chunk_count : 0);
+        for (auto& chunk : record.expected_chunks) {
+            complete = complete && std::getline(chunks_stream, chunk) && !chunk.empty();
+        }
+
+        if (!complete) {
+            dpm_log(LOG_WARN, ("Ignoring malformed chunk manifest near: " + line).c_str());
+            table = ContentsChunkTable();
+            return false;
+        }
+
+        table.index[record.path] = table.records.size();
+        table.records.push_back(std::move(record));
+    }
+
+    return true;
+}
+
+int parse_contents_extra_digests(const std::string& extra_digests_str, ContentsManifestTable& table,
+                                 bool (*algorithm_supported)(const std::string&))
+{
+    std::istringstream extra_stream(extra_digests_str);
+    std::string line;
+    int malformed = 0;
+
+    // Header: # algorithms: alg2 alg3
+    const std::string header_prefix = "# algorithms:";
+    if (!std::getline(extra_stream, line) || line.compare(0, header_prefix.size(), header_prefix) != 0) {
+        dpm_log(LOG_WARN, "Ignoring extra digests file without an algorithms header");
+        return 1;
+    }
+
+    std::vector<std::string> listed_algorithms;
+    std::istringstream header(line.substr(header_prefix.size()));
+    std::string algorithm;
+    while (header >> algorithm) {
+        listed_algorithms.push_back(algorithm);
+    }
+
+    // Columns of the algorithms this system can check
+    std::vector<size_t> columns;
+    table.extra_algorithms.clear();
+    for (size_t i = 0; i < listed_algorithms.size(); i++) {
+        if (!algorithm_supported(listed_algorithms[i])) {
+            dpm_log(LOG_WARN, ("Skipping unsupported digest algorithm recorded in package: " +
+                              listed_algorithms[i]).c_str());
+            continue;
+        }
+        columns.push_back(i);
+        table.extra_algorithms.push_back(listed_algorithms[i]);
+    }
+
+    if (columns.empty()) {
+        return 0;
+    }
+
+    std::string extra_list;
+    for (const auto& name : table.extra_algorithms) {
+        extra_list += (extra_list.empty() ? "" : ", ") + name;
+    }
+    dpm_log(LOG_INFO, ("Also verifying " + extra_list + " contents digests").c_str());
+
+    int line_number = 1;
+    while (std::getline(extra_stream, line)) {
+        line_number++;
+
+        if (line.empty()) {
+            continue;
+        }
+
+        std::istringstream iss(line);
+        std::vector<std::string> digests(listed_algorithms.size());
+        bool complete = true;
+        for (auto& digest : digests) {
+            complete = complete && static_cast<bool>(iss >> digest);
+        }
+
+        std::string file_path;
+        std::getline(iss >> std::ws, file_path);
+        if (!complete || file_path.empty()) {
+            dpm_log(LOG_WARN, ("Malformed extra digests line " + std::to_string(line_number) + ": " + line).c_str());
+            malformed++;
+            continue;
+        }
+
+        if (file_path[0] == '/') {
+            file_path = file_path.substr(1);
+        }
+
+        auto it = table.index.find(file_path);
+        if (it == table.index.end()) {
+            dpm_log(LOG_WARN, ("Extra digests line " + std::to_string(line_number) +
+                              " names a file missing from the manifest: " + file_path).c_str());
+            malformed++;
+            continue;
+        }
+
+        ContentsManifestEntry& entry = table.entries[it->second];
+        entry.expected_extra.clear();
+        for (size_t column : columns) {
+            entry.expected_extra.push_back(digests[column]);
+        }
+    }
+
+    return malformed;
+}
+
+std::vector<std::string> contents_manifest_algorithms(const ContentsManifestTable& table,
+                                                      const std::string& primary_algorithm)
+{
+    std::vector<std::string> algorithms;
+    algorithms.push_back(primary_algorithm);
+    algorithms.insert(algorithms.end(), table.extra_algorithms.begin(), table.extra_algorithms.end());
+    return algorithms;
+}
+
+bool contents_manifest_entry_matches(const ContentsManifestTable& table, const ContentsManifestEntry& entry)
+{
+    // an entry without data only matches one the manifest records without a checksum
+    if (entry.no_data) {
+        return entry.expected_checksum.empty();
+    }
+
+    if (entry.failed || entry.actual_checksum != entry.expected_checksum) {
+        return false;
+    }
+
+    if (table.extra_algorithms.empty()) {
+        return true;
+    }
+
+    return entry.expected_extra.size() == table.extra_algorithms.size() &&
+           entry.actual_extra == entry.expected_extra;
+}
+
+/**
+ * @brief Reports the outcome of a contents verification in manifest order
+ *
+ * Logs missing files, hashing failures and checksum mismatches in the order
+ * the entries appear in the manifest, regardless of the order in which they
+ * were processed.
+ *
+ * @param table Manifest table populated during verification
+ * @param missing_message Text used for entries that were never seen
+ * @param report_missing False when verification stopped early, so unseen entries are not reported as missing
+ * @return Number of errors reported
+ */
+int report_contents_manifest_results(const ContentsManifestTable& table, const std::string& missing_message,
+                                     bool report_missing)
+{
+    int errors = 0;
+
+    for (const auto& manifest_entry : table.entries) {
+        if (!manifest_entry.seen) {
+            if (!report_missing) {
+                continue;
+            }
+
+            dpm_log(LOG_ERROR, (missing_message + " (manifest line " + std::to_string(manifest_entry.line_number) +
+                               "): " + manifest_entry.path).c_str());
+            errors++;
+            continue;
+        }
+
+        if (manifest_entry.failed) {
+            dpm_log(LOG_ERROR, ("Failed to calculate checksum for: " + manifest_entry.path).c_str());
+            errors++;
+            continue;
+        }
+
+        // Symlinks and other special files have no data of their own to hash, which only the manifest may allow
+        if (manifest_entry.no_data) {
+            if (manifest_entry.expected_checksum.empty()) {
+                DPM_LOG(LOG_DEBUG, "Skipped content check for non-regular file: ", manifest_entry.path);
+                continue;
+            }
+
+            dpm_log(LOG_ERROR, ("Checksum mismatch for " + manifest_entry.path +
+                               ": the manifest records a regular file but the archive entry has no data").c_str());
+            errors++;
+            continue;
+        }
+
+        // hashing still queued when verification stopped early never ran
+        if (manifest_entry.actual_checksum.empty() && !report_missing) {
+            continue;
+        }
+
+        if (manifest_entry.actual_checksum != manifest_entry.expected_checksum) {
+            dpm_log(LOG_ERROR, ("Checksum mismatch for " + manifest_entry.path +
+                               "\n  Expected: " + manifest_entry.expected_checksum +
+                               "\n  Actual:   " + manifest_entry.actual_checksum).c_str());
+            errors++;
+            continue;
+        }
+
+        if (table.extra_algorithms.empty()) {
+            continue;
+        }
+
+        if (manifest_entry.expected_extra.size() != table.extra_algorithms.size()) {
+            dpm_log(LOG_ERROR, ("No additional digests recorded for: " + manifest_entry.path).c_str());
+            errors++;
+            continue;
+        }
+
+        for (size_t i = 0; i < table.extra_algorithms.size(); i++) {
+            const std::string actual = i < manifest_entry.actual_extra.size() ? manifest_entry.actual_extra[i] : "";
+            if (actual != manifest_entry.expected_extra[i]) {
+                dpm_log(LOG_ERROR, ("Checksum mismatch (" + table.extra_algorithms[i] + ") for " + manifest_entry.path +
+                                   "\n  Expected: " + manifest_entry.expected_extra[i] +
+                                   "\n  Actual:   " + actual).c_str());
+                errors++;
+                break;
+            }
+        }
+    }
+
+    return errors;
+}
+
+void set_verify_fail_fast(int fail_fast)
+{
+    g_verify_fail_fast_override = fail_fast < 0 ? -1 : (fail_fast > 0 ? 1 : 0);
+}
+
+bool verify_fail_fast()
+{
+    // command line takes precedence
+    if (g_verify_fail_fast_override >= 0) {
+        return g_verify_fail_fast_override == 1;
+    }
+
+    // then the [verify] fail_fast configuration key
+    const char* configured = dpm_get_config("verify", "fail_fast");
+    if (!configured) {
+        return false;
+    }
+
+    std::string value = configured;
+    return value == "1" || value == "true" || value == "yes" || value == "on";
+}
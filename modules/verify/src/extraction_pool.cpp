@@ -0,0 +1,83 @@
+/**
+ * @file extraction_pool.cpp
+ * @brief Implementation of the extraction buffer pool
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "extraction_pool.hpp"
+
+ExtractionBufferPool::ExtractionBufferPool()
+    : _free(size_class(EXTRACTION_POOL_MAX_CLASS) + 1)
+{
+}
+
+ExtractionBufferPool::~ExtractionBufferPool()
+{
+    for (unsigned char* buffer : _owned) {
+        free(buffer);
+    }
+}
+
+size_t ExtractionBufferPool::size_class(size_t size)
+{
+    size_t index = 0;
+    for (size_t capacity = EXTRACTION_POOL_MIN_CLASS; capacity < size; capacity <<= 1) {
+        index++;
+    }
+    return index;
+}
+
+unsigned char* ExtractionBufferPool::acquire(size_t size)
+{
+    if (size > EXTRACTION_POOL_MAX_CLASS) {
+        // still owned until released, so one that never is goes with the pool
+        unsigned char* buffer = static_cast<unsigned char*>(malloc(size));
+        if (buffer) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _owned.push_back(buffer);
+        }
+        return buffer;
+    }
+
+    size_t index = size_class(size);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_free[index].empty()) {
+        unsigned char* buffer = _free[index].back();
+        _free[index].pop_back();
+        return buffer;
+    }
+
+    unsigned char* buffer = static_cast<unsigned char*>(malloc(static_cast<size_t>(EXTRACTION_POOL_MIN_CLASS) << index));
+    if (buffer) {
+        _owned.push_back(buffer);
+    }
+    return buffer;
+}
+
+void ExtractionBufferPool::release(unsigned char* buffer, size_t size)
+{
+    if (!buffer) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (size > EXTRACTION_POOL_MAX_CLASS) {
+        auto owned = std::find(_owned.begin(), _owned.end(), buffer);
+        if (owned != _owned.end()) {
+            _owned.erase(owned);
+        }
+        free(buffer);
+        return;
+    }
+
+    _free[size_class(size)].push_back(buffer);
+}
+
+unsigned char* ExtractionBufferPool::allocate(size_t size, void* pool)
+{
+    return static_cast<ExtractionBufferPool*>(pool)->acquire(size);
+}
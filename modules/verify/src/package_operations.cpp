@@ -34,23 +34,18 @@ int get_component_from_package(const std::string& package_path,
         return 1;
     }
 
-    // Load the build module
-    void* build_module = nullptr;
-    int result = check_and_load_build_module(build_module);
-    if (result != 0 || build_module == nullptr) {
+    // The build module is loaded once and shared by every caller
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
         dpm_log(LOG_ERROR, "Failed to load build module");
         return 1;
     }
 
-    dpm_log(LOG_DEBUG, ("Extracting " + component_name + " from package: " + package_path).c_str());
+    DPM_LOG(LOG_DEBUG, "Extracting ", component_name, " from package: ", package_path);
 
     // Call the function from the build module
-    bool success = dpm_execute_symbol(build_module, "get_file_from_package_file",
-                                    package_path.c_str(), component_name.c_str(),
-                                    data, data_size);
-
-    // Unload the build module
-    dpm_unload_module(build_module);
+    bool success = build_module->get_file_from_package_file(package_path.c_str(), component_name.c_str(),
+                                                            data, data_size);
 
     // Check if the function call was successful
     if (!success || *data == nullptr || *data_size == 0) {
@@ -58,68 +53,78 @@ int get_component_from_package(const std::string& package_path,
         return 1;
     }
 
-    dpm_log(LOG_DEBUG, ("Successfully extracted " + component_name + " (" +
-            std::to_string(*data_size) + " bytes)").c_str());
+    DPM_LOG(LOG_DEBUG, "Successfully extracted ", component_name, " (", *data_size, " bytes)");
 
     return 0;
 }
 
 /**
- * @brief Extracts a file from a component archive
+ * @brief ArchiveEntryAllocator that extracts a file straight into a std::string
+ *
+ * @param size Size of the file
+ * @param text Pointer to the std::string receiving the file
+ * @return The string's buffer, sized to hold the file
+ */
+static unsigned char* text_file_allocator(size_t size, void* text)
+{
+    std::string* target = static_cast<std::string*>(text);
+    target->resize(size);
+    return reinterpret_cast<unsigned char*>(target->data());
+}
+
+/**
+ * @brief Extracts a text file from a component archive
  *
- * Extracts a specific file from a component archive that has already been loaded into memory.
- * Uses the build module's get_file_from_memory_loaded_archive function.
+ * Extracts a specific file from a component archive that has already been loaded
+ * into memory, decompressing it directly into the caller's string.
  *
  * @param component_data Pointer to the component archive data in memory
  * @param component_size Size of the component archive in memory
  * @param filename Name of the file to extract from the component
- * @param data Pointer to a pointer that will be populated with the file data
- * @param data_size Pointer to a size_t that will be populated with the size of the file data
+ * @param text Receives the file, up to its first NUL byte
  * @return 0 on success, non-zero on failure
  */
 int get_file_from_component(const unsigned char* component_data,
                            size_t component_size,
                            const std::string& filename,
-                           unsigned char** data,
-                           size_t* data_size)
+                           std::string& text)
 {
     // Validate input parameters
-    if (!component_data || component_size == 0 || filename.empty() || !data || !data_size) {
+    if (!component_data || component_size == 0 || filename.empty()) {
         dpm_log(LOG_ERROR, "Invalid parameters passed to get_file_from_component");
         return 1;
     }
 
-    // Initialize output parameters
-    *data = nullptr;
-    *data_size = 0;
+    text.clear();
 
-    // Load the build module
-    void* build_module = nullptr;
-    int result = check_and_load_build_module(build_module);
-    if (result != 0 || build_module == nullptr) {
+    // The build module is loaded once and shared by every caller
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
         dpm_log(LOG_ERROR, "Failed to load build module");
         return 1;
     }
 
-    dpm_log(LOG_DEBUG, ("Extracting file '" + filename + "' from component archive").c_str());
+    DPM_LOG(LOG_DEBUG, "Extracting file '", filename, "' from component archive");
 
-    // Call the function from the build module
-    bool success = dpm_execute_symbol(build_module, "get_file_from_memory_loaded_archive",
-                                    component_data, component_size,
-                                    filename.c_str(),
-                                    data, data_size);
+    unsigned char* data = nullptr;
+    size_t data_size = 0;
+    bool success = build_module->get_file_from_memory_loaded_archive_into(component_data, component_size,
+                                                                          filename.c_str(),
+                                                                          text_file_allocator, &text,
+                                                                          &data, &data_size);
 
-    // Unload the build module
-    dpm_unload_module(build_module);
+    // The digest files are plain text, so anything after a NUL byte is not part of them
+    if (success) {
+        text.resize(strnlen(text.data(), text.size()));
+    }
 
-    // Check if the function call was successful
-    if (!success || *data == nullptr || *data_size == 0) {
+    if (!success || text.empty()) {
         dpm_log(LOG_ERROR, ("Failed to extract file '" + filename + "' from component archive").c_str());
+        text.clear();
         return 1;
     }
 
-    dpm_log(LOG_DEBUG, ("Successfully extracted file '" + filename + "' (" +
-            std::to_string(*data_size) + " bytes)").c_str());
+    DPM_LOG(LOG_DEBUG, "Successfully extracted file '", filename, "' (", data_size, " bytes)");
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+/**
+ * @file signature_memory.cpp
+ * @brief Implementation of in-memory, concurrent component signature verification
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "signature_memory.hpp"
+
+int verify_component_signatures(std::vector<ComponentSignatureCheck>& checks,
+                                const BuildModuleFunctions* build_module)
+{
+    DpmProfileScope profile("verify_component_signatures");
+
+    if (checks.empty() || !build_module) {
+        dpm_log(LOG_ERROR, "Invalid parameters passed to verify_component_signatures");
+        return 1;
+    }
+
+    auto verify_signature = build_module->verify_detached_signature_memory;
+
+    std::vector<std::function<void()>> jobs;
+    for (auto& check : checks) {
+        check.result = 1;
+        check.signer[0] = '\0';
+
+        ComponentSignatureCheck* target = &check;
+        jobs.push_back([target, verify_signature]() {
+            target->result = verify_signature(target->data, target->data_size,
+                                              target->signature, target->signature_size,
+                                              target->signer, sizeof(target->signer));
+        });
+    }
+
+    WorkStealingPool pool(checks.size());
+    pool.run(jobs);
+
+    int errors = 0;
+    for (const auto& check : checks) {
+        if (check.result != 0) {
+            dpm_log(LOG_ERROR, ("Signature verification failed for " + check.component + " component").c_str());
+            errors++;
+            continue;
+        }
+
+        std::string signer = check.signer[0] ? check.signer : "unknown key";
+        dpm_log(LOG_INFO, ("Good signature on " + check.component + " component from " + signer).c_str());
+    }
+
+    return errors == 0 ? 0 : 1;
+}
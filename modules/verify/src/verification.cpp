@@ -21,10 +21,9 @@ int verify_checksums_package(const std::string& package_path) {
 
     dpm_log(LOG_INFO, ("Verifying checksums for package: " + package_path).c_str());
 
-    // Load the build module to access functions
-    void* build_module = nullptr;
-    int result = check_and_load_build_module(build_module);
-    if (result != 0 || build_module == nullptr) {
+    // Get the shared build module function table
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
         dpm_log(LOG_ERROR, "Failed to load build module");
         return 1;
     }
@@ -38,7 +37,6 @@ int verify_checksums_package(const std::string& package_path) {
             std::filesystem::remove_all(temp_dir);
         } catch (const std::filesystem::filesystem_error& e) {
             dpm_log(LOG_ERROR, ("Failed to clean up existing temp directory: " + std::string(e.what())).c_str());
-            dpm_unload_module(build_module);
             return 1;
         }
     }
@@ -48,20 +46,18 @@ int verify_checksums_package(const std::string& package_path) {
         std::filesystem::create_directory(temp_dir);
     } catch (const std::filesystem::filesystem_error& e) {
         dpm_log(LOG_ERROR, ("Failed to create temp directory: " + std::string(e.what())).c_str());
-        dpm_unload_module(build_module);
         return 1;
     }
 
-    // Unseal the package to the temp directory using dpm_execute_symbol
+    // Unseal the package to the temp directory
     dpm_log(LOG_INFO, "Unsealing package to temporary directory for verification...");
     std::string output_dir = temp_dir.string();
     bool force = true; // Force overwrite if directory exists
 
-    result = dpm_execute_symbol(build_module, "unseal_package", package_path, output_dir, force);
+    int result = build_module->unseal_package(package_path, output_dir, force);
 
     if (result != 0) {
         dpm_log(LOG_ERROR, "Failed to unseal package for verification");
-        dpm_unload_module(build_module);
 
         // Clean up temp directory
         try {
@@ -100,9 +96,6 @@ int verify_checksums_package(const std::string& package_path) {
         // Continue execution - this is just a cleanup warning
     }
 
-    // Clean up module handle
-    dpm_unload_module(build_module);
-
     if (result == 0) {
         dpm_log(LOG_INFO, "Package checksum verification completed successfully");
     } else {
@@ -130,65 +123,159 @@ int verify_checksums_stage(const std::string& stage_dir) {
     // First, ensure the components are unsealed (uncompressed)
     dpm_log(LOG_INFO, "Ensuring stage components are unsealed...");
 
-    // Load the build module to access functions
-    void* build_module = nullptr;
-    int result = check_and_load_build_module(build_module);
-    if (result != 0 || build_module == nullptr) {
+    // Get the shared build module function table
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
         dpm_log(LOG_ERROR, "Failed to load build module");
         return 1;
     }
 
-    // Use dpm_execute_symbol to call the unseal_stage_components function
+    // Make sure the components are plain directories before hashing them
     std::filesystem::path stage_path(stage_dir);
-    result = dpm_execute_symbol(build_module, "unseal_stage_components", stage_path);
+    int result = build_module->unseal_stage_components(stage_path);
 
     if (result != 0) {
         dpm_log(LOG_ERROR, "Failed to unseal stage components");
-        dpm_unload_module(build_module);
         return 1;
     }
 
-    // Verify checksums
-    result = checksum_verify_package_digest(stage_dir, build_module);
-    if (result != 0) {
-        dpm_log(LOG_ERROR, "Package digest verification failed");
-        dpm_unload_module(build_module);
+    // Read the metadata once for all three checks
+    MetadataModel metadata;
+    if (!metadata.load(stage_path / "metadata")) {
+        dpm_log(LOG_ERROR, "Failed to read stage metadata");
         return 1;
     }
 
-    result = checksum_verify_contents_digest(stage_dir, build_module);
+    // Verify checksums, cheapest first so a bad stage is rejected before its contents are hashed
+    bool fail_fast = verify_fail_fast();
+    int failures = 0;
+
+    result = checksum_verify_package_digest(stage_dir, build_module, &metadata);
     if (result != 0) {
-        dpm_log(LOG_ERROR, "Contents manifest verification failed");
-        dpm_unload_module(build_module);
-        return 1;
+        dpm_log(LOG_ERROR, "Package digest verification failed");
+        failures++;
+        if (fail_fast) {
+            return 1;
+        }
     }
 
-    result = checksum_verify_hooks_digest(stage_dir, build_module);
+    result = checksum_verify_hooks_digest(stage_dir, build_module, &metadata);
     if (result != 0) {
         dpm_log(LOG_ERROR, "Hooks digest verification failed");
-        dpm_unload_module(build_module);
-        return 1;
+        failures++;
+        if (fail_fast) {
+            return 1;
+        }
+    }
+
+    result = checksum_verify_contents_digest(stage_dir, build_module, &metadata);
+    if (result != 0) {
+        dpm_log(LOG_ERROR, "Contents manifest verification failed");
+        failures++;
     }
 
-    // Clean up
-    dpm_unload_module(build_module);
+    if (failures > 0) {
+        dpm_log(LOG_ERROR, (std::to_string(failures) + " of 3 checksum checks failed").c_str());
+        return 1;
+    }
 
     dpm_log(LOG_INFO, "All checksums verified successfully");
     return 0;
 }
 
-int verify_signature_package(const std::string& package_path) {
-    // Check if the package file exists
-    if (!std::filesystem::exists(package_path)) {
+/**
+ * @brief Names of the signed components, in reporting order
+ */
+static const char* SIGNED_COMPONENTS[] = { "contents", "hooks", "metadata" };
+
+int verify_signature_package(const std::string& package_path, bool metadata_only) {
+    // Check if the package file exists, remote packages are fetched by the build module
+    if (!dpm_package_is_url(package_path) && !std::filesystem::exists(package_path)) {
         dpm_log(LOG_ERROR, ("Package file not found: " + package_path).c_str());
         return 1;
     }
 
-    // Placeholder implementation
     dpm_log(LOG_INFO, ("Verifying signatures for package: " + package_path).c_str());
-    dpm_log(LOG_INFO, "Package signature verification not yet implemented");
 
-    return 0;
+    // Get the shared build module function table
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Failed to load build module");
+        return 1;
+    }
+
+    // Map the package; components and signatures are checked in place
+    void* reader = build_module->package_reader_open(package_path.c_str());
+    if (!reader) {
+        dpm_log(LOG_ERROR, ("Failed to open package: " + package_path).c_str());
+        return 1;
+    }
+
+    // The metadata alone is enough to trust the digests it records for the other components
+    std::vector<const char*> components(std::begin(SIGNED_COMPONENTS), std::end(SIGNED_COMPONENTS));
+    if (metadata_only) {
+        components = { "metadata" };
+    }
+
+    std::vector<ComponentSignatureCheck> checks;
+    for (const char* component : components) {
+        ComponentSignatureCheck check = {};
+        check.component = component;
+
+        std::string signature_member = std::string("signatures/") + component + ".signature";
+
+        if (!build_module->package_reader_get_member(reader, component, &check.data, &check.data_size)) {
+            dpm_log(LOG_ERROR, ("Package is missing its " + std::string(component) + " component").c_str());
+            build_module->package_reader_close(reader);
+            return 1;
+        }
+
+        if (!build_module->package_reader_get_member(reader, signature_member.c_str(),
+                                                     &check.signature, &check.signature_size) ||
+            check.signature_size == 0) {
+            dpm_log(LOG_ERROR, ("Package is not signed: no signature for the " + std::string(component) + " component").c_str());
+            build_module->package_reader_close(reader);
+            return 1;
+        }
+
+        checks.push_back(check);
+    }
+
+    int result = verify_component_signatures(checks, build_module);
+
+    build_module->package_reader_close(reader);
+
+    if (result == 0) {
+        dpm_log(LOG_INFO, "Package signature verification completed successfully");
+    } else {
+        dpm_log(LOG_ERROR, "Package signature verification failed");
+    }
+
+    return result;
+}
+
+/**
+ * @brief Reads a whole file into a buffer
+ *
+ * @param path File to read
+ * @param buffer Receives the file contents
+ * @return true on success, false if the file could not be read
+ */
+static bool read_file_to_buffer(const std::filesystem::path& path, std::vector<unsigned char>& buffer)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::streamsize size = file.tellg();
+    if (size < 0) {
+        return false;
+    }
+    file.seekg(0, std::ios::beg);
+
+    buffer.resize(static_cast<size_t>(size));
+    return size == 0 || static_cast<bool>(file.read(reinterpret_cast<char*>(buffer.data()), size));
 }
 
 int verify_signature_stage(const std::string& stage_dir) {
@@ -204,9 +291,62 @@ int verify_signature_stage(const std::string& stage_dir) {
         return 1;
     }
 
-    // Placeholder implementation
     dpm_log(LOG_INFO, ("Verifying signatures for stage directory: " + stage_dir).c_str());
-    dpm_log(LOG_INFO, "Stage directory signature verification not yet implemented");
 
-    return 0;
+    // Get the shared build module function table
+    const BuildModuleFunctions* build_module = dpm_build_module();
+    if (!build_module) {
+        dpm_log(LOG_ERROR, "Failed to load build module");
+        return 1;
+    }
+
+    std::filesystem::path stage_path(stage_dir);
+
+    // Kept alive until the checks have run
+    std::vector<std::vector<unsigned char>> buffers;
+    buffers.reserve(2 * (sizeof(SIGNED_COMPONENTS) / sizeof(SIGNED_COMPONENTS[0])));
+
+    std::vector<ComponentSignatureCheck> checks;
+    for (const char* component : SIGNED_COMPONENTS) {
+        std::filesystem::path component_path = stage_path / component;
+        std::filesystem::path signature_path = stage_path / "signatures" / (std::string(component) + ".signature");
+
+        // Signatures cover the sealed component archives
+        if (std::filesystem::is_directory(component_path)) {
+            dpm_log(LOG_ERROR, ("Component is not sealed, signatures cannot be checked: " + component_path.string()).c_str());
+            return 1;
+        }
+
+        buffers.emplace_back();
+        if (!read_file_to_buffer(component_path, buffers.back())) {
+            dpm_log(LOG_ERROR, ("Failed to read component: " + component_path.string()).c_str());
+            return 1;
+        }
+        const std::vector<unsigned char>& component_data = buffers.back();
+
+        buffers.emplace_back();
+        if (!read_file_to_buffer(signature_path, buffers.back()) || buffers.back().empty()) {
+            dpm_log(LOG_ERROR, ("Stage is not signed: missing " + signature_path.string()).c_str());
+            return 1;
+        }
+        const std::vector<unsigned char>& signature_data = buffers.back();
+
+        ComponentSignatureCheck check = {};
+        check.component = component;
+        check.data = component_data.data();
+        check.data_size = component_data.size();
+        check.signature = signature_data.data();
+        check.signature_size = signature_data.size();
+        checks.push_back(check);
+    }
+
+    int result = verify_component_signatures(checks, build_module);
+
+    if (result == 0) {
+        dpm_log(LOG_INFO, "Stage signature verification completed successfully");
+    } else {
+        dpm_log(LOG_ERROR, "Stage signature verification failed");
+    }
+
+    return result;
 }
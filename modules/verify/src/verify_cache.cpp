@@ -0,0 +1,347 @@
+/**
+ * @file verify_cache.cpp
+ * @brief Implementation of the persistent verification result cache
+ *
+ * Each entry is a small key=value text file named after the device and inode
+ * of the package it describes.  Entries are written to a temporary file and
+ * renamed into place so that concurrent verifications never see a partial
+ * entry.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "verify_cache.hpp"
+
+// Set by --no-cache
+static bool g_verify_cache_disabled = false;
+
+void set_verify_cache_disabled(bool disabled)
+{
+    g_verify_cache_disabled = disabled;
+}
+
+bool verify_cache_enabled()
+{
+    if (g_verify_cache_disabled) {
+        return false;
+    }
+
+    const char* configured = dpm_get_config("verify", "cache");
+    if (!configured) {
+        return false;
+    }
+
+    std::string value = configured;
+    return value == "1" || value == "true" || value == "yes" || value == "on";
+}
+
+std::string verify_cache_dir()
+{
+    const char* configured = dpm_get_config("verify", "cache_dir");
+    if (configured && strlen(configured) > 0) {
+        return configured;
+    }
+
+    return VERIFY_CACHE_DEFAULT_DIR;
+}
+
+/**
+ * @brief Gets the path of the cache entry for a package identity
+ *
+ * @param device Device holding the package file
+ * @param inode Inode of the package file
+ * @return Path of the entry file within the cache directory
+ */
+static std::filesystem::path verify_cache_entry_path(unsigned long long device, unsigned long long inode)
+{
+    return std::filesystem::path(verify_cache_dir()) /
+           (std::to_string(device) + "-" + std::to_string(inode) + ".entry");
+}
+
+/**
+ * @brief Fills in the file identity fields of a key from stat(2)
+ *
+ * @param package_path Path to the package file
+ * @param key Key to fill in
+ * @return true on success, false if the file could not be stat'ed
+ */
+static bool verify_cache_stat_key(const std::string& package_path, VerifyCacheKey& key)
+{
+    struct stat st;
+    if (stat(package_path.c_str(), &st) != 0) {
+        return false;
+    }
+
+    key.device = st.st_dev;
+    key.inode = st.st_ino;
+    key.size = st.st_size;
+    key.mtime_sec = st.st_mtim.tv_sec;
+    key.mtime_nsec = st.st_mtim.tv_nsec;
+    return true;
+}
+
+/**
+ * @brief Serialises a key into the entry file format
+ *
+ * @param key Key to serialise
+ * @return Entry file contents, excluding the verification timestamp
+ */
+static std::string verify_cache_format_key(const VerifyCacheKey& key)
+{
+    std::ostringstream out;
+    out << "path=" << key.package_path << "\n";
+    out << "device=" << key.device << "\n";
+    out << "inode=" << key.inode << "\n";
+    out << "size=" << key.size << "\n";
+    out << "mtime=" << key.mtime_sec << "." << key.mtime_nsec << "\n";
+    out << "algorithm=" << key.algorithm << "\n";
+    out << "package_digest=" << key.package_digest << "\n";
+    return out.str();
+}
+
+/**
+ * @brief Reads an entry file back into a key
+ *
+ * @param entry_path Path of the entry file
+ * @param key Receives the recorded key
+ * @param verified_at Receives the time the entry was written
+ * @return true if the entry was well formed, false otherwise
+ */
+static bool verify_cache_read_entry(const std::filesystem::path& entry_path, VerifyCacheKey& key, time_t& verified_at)
+{
+    std::ifstream entry_file(entry_path);
+    if (!entry_file.is_open()) {
+        return false;
+    }
+
+    key = VerifyCacheKey{};
+    verified_at = 0;
+    int fields = 0;
+
+    std::string line;
+    while (std::getline(entry_file, line)) {
+        size_t separator = line.find('=');
+        if (separator == std::string::npos) {
+            continue;
+        }
+
+        std::string name = line.substr(0, separator);
+        std::string value = line.substr(separator + 1);
+
+        if (name == "path") {
+            key.package_path = value;
+        } else if (name == "device") {
+            key.device = strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "inode") {
+            key.inode = strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "size") {
+            key.size = strtoll(value.c_str(), nullptr, 10);
+        } else if (name == "mtime") {
+            size_t dot = value.find('.');
+            key.mtime_sec = strtoll(value.substr(0, dot).c_str(), nullptr, 10);
+            key.mtime_nsec = dot == std::string::npos ? 0 : strtoll(value.substr(dot + 1).c_str(), nullptr, 10);
+        } else if (name == "algorithm") {
+            key.algorithm = value;
+        } else if (name == "package_digest") {
+            key.package_digest = value;
+        } else if (name == "verified") {
+            verified_at = strtoll(value.c_str(), nullptr, 10);
+        } else {
+            continue;
+        }
+
+        fields++;
+    }
+
+    return fields == 8 && !key.package_digest.empty();
+}
+
+/**
+ * @brief Compares two keys for an exact match
+ */
+static bool verify_cache_keys_match(const VerifyCacheKey& a, const VerifyCacheKey& b)
+{
+    return a.device == b.device &&
+           a.inode == b.inode &&
+           a.size == b.size &&
+           a.mtime_sec == b.mtime_sec &&
+           a.mtime_nsec == b.mtime_nsec &&
+           a.algorithm == b.algorithm &&
+           a.package_digest == b.package_digest;
+}
+
+bool verify_cache_make_key(const std::string& package_path, VerifyCacheKey& key,
+                           const BuildModuleFunctions* build_module)
+{
+    if (!build_module) {
+        return false;
+    }
+
+    key = VerifyCacheKey{};
+
+    std::error_code ec;
+    std::filesystem::path absolute_path = std::filesystem::absolute(package_path, ec);
+    key.package_path = ec ? package_path : absolute_path.lexically_normal().string();
+
+    if (!verify_cache_stat_key(package_path, key)) {
+        DPM_LOG(LOG_DEBUG, "Could not stat package for verification cache: ", package_path);
+        return false;
+    }
+
+    key.algorithm = build_module->get_configured_hash_algorithm();
+
+    // Only the metadata member is read to pick up PACKAGE_DIGEST
+    void* reader = build_module->package_reader_open(package_path.c_str());
+    if (!reader) {
+        return false;
+    }
+
+    const unsigned char* metadata_data = nullptr;
+    size_t metadata_data_size = 0;
+    unsigned char* digest_data = nullptr;
+    size_t digest_size = 0;
+
+    bool found = build_module->package_reader_get_member(reader, "metadata", &metadata_data, &metadata_data_size) &&
+                 build_module->get_file_from_memory_loaded_archive(metadata_data, metadata_data_size, "PACKAGE_DIGEST",
+                                                                   &digest_data, &digest_size);
+
+    if (found && digest_data) {
+        std::string digest(reinterpret_cast<const char*>(digest_data), digest_size);
+        key.package_digest = digest.substr(0, digest.find_first_of("\r\n"));
+    }
+
+    free(digest_data);
+    build_module->package_reader_close(reader);
+
+    return !key.package_digest.empty();
+}
+
+bool verify_cache_lookup(const VerifyCacheKey& key)
+{
+    VerifyCacheKey cached;
+    time_t verified_at;
+
+    if (!verify_cache_read_entry(verify_cache_entry_path(key.device, key.inode), cached, verified_at)) {
+        DPM_LOG(LOG_DEBUG, "No verification cache entry for ", key.package_path);
+        return false;
+    }
+
+    if (!verify_cache_keys_match(key, cached)) {
+        DPM_LOG(LOG_DEBUG, "Verification cache entry for ", key.package_path, " is stale");
+        return false;
+    }
+
+    return true;
+}
+
+void verify_cache_store(const VerifyCacheKey& key)
+{
+    std::filesystem::path entry_path = verify_cache_entry_path(key.device, key.inode);
+
+    std::error_code ec;
+    std::filesystem::create_directories(entry_path.parent_path(), ec);
+    if (ec) {
+        dpm_log(LOG_WARN, ("Could not create verification cache directory " +
+                          entry_path.parent_path().string() + ": " + ec.message()).c_str());
+        return;
+    }
+
+    // Write beside the final entry and rename so readers never see a partial file
+    std::filesystem::path temp_path = entry_path;
+    temp_path += ".tmp." + std::to_string(getpid()) + "." +
+                 std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+    {
+        std::ofstream entry_file(temp_path, std::ios::trunc);
+        if (!entry_file.is_open()) {
+            dpm_log(LOG_WARN, ("Could not write verification cache entry: " + temp_path.string()).c_str());
+            return;
+        }
+
+        entry_file << verify_cache_format_key(key);
+        entry_file << "verified=" << time(nullptr) << "\n";
+
+        if (!entry_file.good()) {
+            entry_file.close();
+            std::filesystem::remove(temp_path, ec);
+            dpm_log(LOG_WARN, ("Could not write verification cache entry: " + temp_path.string()).c_str());
+            return;
+        }
+    }
+
+    std::filesystem::rename(temp_path, entry_path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        dpm_log(LOG_WARN, ("Could not store verification cache entry: " + entry_path.string()).c_str());
+        return;
+    }
+
+    DPM_LOG(LOG_DEBUG, "Stored verification cache entry ", entry_path.string());
+}
+
+int verify_cache_prune(bool remove_all, int max_age_days)
+{
+    std::filesystem::path cache_dir = verify_cache_dir();
+
+    std::error_code ec;
+    if (!std::filesystem::exists(cache_dir, ec)) {
+        return 0;
+    }
+
+    std::filesystem::directory_iterator entries(cache_dir, ec);
+    if (ec) {
+        dpm_log(LOG_ERROR, ("Could not read verification cache directory " + cache_dir.string() +
+                           ": " + ec.message()).c_str());
+        return -1;
+    }
+
+    time_t now = time(nullptr);
+    int removed = 0;
+
+    for (const auto& entry : entries) {
+        if (!entry.is_regular_file(ec)) {
+            continue;
+        }
+
+        std::string name = entry.path().filename().string();
+        bool is_entry = entry.path().extension() == ".entry";
+        bool is_leftover = name.find(".entry.tmp.") != std::string::npos;
+        if (!is_entry && !is_leftover) {
+            continue;
+        }
+
+        bool remove = remove_all || is_leftover;
+
+        if (!remove) {
+            VerifyCacheKey cached;
+            time_t verified_at;
+
+            if (!verify_cache_read_entry(entry.path(), cached, verified_at)) {
+                remove = true;
+            } else if (max_age_days > 0 && now - verified_at > (time_t)max_age_days * 24 * 60 * 60) {
+                remove = true;
+            } else {
+                // the package must still exist with exactly the recorded identity
+                VerifyCacheKey current = cached;
+                remove = !verify_cache_stat_key(cached.package_path, current) ||
+                         !verify_cache_keys_match(current, cached);
+            }
+        }
+
+        if (remove) {
+            std::filesystem::remove(entry.path(), ec);
+            if (ec) {
+                dpm_log(LOG_WARN, ("Could not remove verification cache entry " + entry.path().string() +
+                                  ": " + ec.message()).c_str());
+                continue;
+            }
+            DPM_LOG(LOG_DEBUG, "Removed verification cache entry ", entry.path().string());
+            removed++;
+        }
+    }
+
+    return removed;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file worker_pool.cpp
+ * @brief Implementation of the fixed-size worker pool used for parallel verification
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "worker_pool.hpp"
+
+// Worker count requested on the command line, 0 when not set
+static int g_verify_worker_override = 0;
+
+WorkerPool::WorkerPool(size_t worker_count, size_t max_queued)
+    : _max_queued(max_queued > 0 ? max_queued : 1), _active(0), _stopping(false), _cancelled(false)
+{
+    if (worker_count == 0) {
+        worker_count = 1;
+    }
+
+    for (size_t i = 0; i < worker_count; i++) {
+        _workers.emplace_back(&WorkerPool::worker_loop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _job_available.notify_all();
+
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> job)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _space_available.wait(lock, [this] { return _cancelled || _jobs.size() < _max_queued; });
+    if (_cancelled) {
+        return;
+    }
+    _jobs.push_back(std::move(job));
+    lock.unlock();
+    _job_available.notify_one();
+}
+
+void WorkerPool::wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _all_done.wait(lock, [this] { return _jobs.empty() && _active == 0; });
+}
+
+void WorkerPool::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cancelled = true;
+        _jobs.clear();
+        if (_active == 0) {
+            _all_done.notify_all();
+        }
+    }
+    _space_available.notify_all();
+}
+
+bool WorkerPool::cancelled()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _cancelled;
+}
+
+void WorkerPool::worker_loop()
+{
+    while (true) {
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _job_available.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+
+            if (_jobs.empty()) {
+                // only reachable once stopping has been requested
+                return;
+            }
+
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+            _active++;
+        }
+        _space_available.notify_one();
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _active--;
+            if (_jobs.empty() && _active == 0) {
+                _all_done.notify_all();
+            }
+        }
+    }
+}
+
+WorkStealingPool::WorkStealingPool(size_t worker_count)
+    : _worker_count(worker_count > 0 ? worker_count : 1)
+{
+    for (size_t i = 0; i < _worker_count; i++) {
+        _queues.push_back(std::make_unique<WorkerQueue>());
+    }
+}
+
+void WorkStealingPool::run(std::vector<std::function<void()>>& jobs)
+{
+    if (jobs.empty()) {
+        return;
+    }
+
+    // Deal the jobs out so every worker starts with a mix of large and small ones
+    for (size_t i = 0; i < jobs.size(); i++) {
+        _queues[i % _worker_count]->jobs.push_back(&jobs[i]);
+    }
+
+    // Each worker is a task on the shared pool, the waiting thread runs them too
+    size_t task_count = std::min(_worker_count, jobs.size());
+    std::vector<std::pair<WorkStealingPool*, size_t>> workers;
+    for (size_t i = 0; i < task_count; i++) {
+        workers.emplace_back(this, i);
+    }
+
+    dpm_task_group* group = dpm_task_group_create();
+    for (auto& worker : workers) {
+        dpm_submit_task(group, &WorkStealingPool::worker_task, &worker);
+    }
+    dpm_task_group_destroy(group);
+}
+
+void WorkStealingPool::worker_task(void* context)
+{
+    auto* worker = static_cast<std::pair<WorkStealingPool*, size_t>*>(context);
+    worker->first->worker_loop(worker->second);
+}
+
+std::function<void()>* WorkStealingPool::take_job(size_t worker_index)
+{
+    // Own queue first, oldest job first
+    {
+        WorkerQueue& own = *_queues[worker_index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            std::function<void()>* job = own.jobs.front();
+            own.jobs.pop_front();
+            return job;
+        }
+    }
+
+    // Then steal from the far end of the other queues
+    for (size_t offset = 1; offset < _worker_count; offset++) {
+        WorkerQueue& victim = *_queues[(worker_index + offset) % _worker_count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            std::function<void()>* job = victim.jobs.back();
+            victim.jobs.pop_back();
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+void WorkStealingPool::worker_loop(size_t worker_index)
+{
+    // No new jobs arrive once run() has dealt them out, so an empty sweep means we are done
+    while (std::function<void()>* job = take_job(worker_index)) {
+        (*job)();
+    }
+}
+
+void set_verify_worker_count(int worker_count)
+{
+    g_verify_worker_override = worker_count > 0 ? worker_count : 0;
+}
+
+size_t get_verify_worker_count()
+{
+    // command line takes precedence
+    if (g_verify_worker_override > 0) {
+        return static_cast<size_t>(g_verify_worker_override);
+    }
+
+    // then the [verify] threads configuration key
+    const char* configured = dpm_get_config("verify", "threads");
+    if (configured && strlen(configured) > 0) {
+        int value = atoi(configured);
+        if (value > 0) {
+            return static_cast<size_t>(value);
+        }
+
+        // 0 explicitly asks for automatic detection
+        if (strcmp(configured, "0") != 0) {
+            dpm_log(LOG_WARN, ("Ignoring invalid [verify] threads value: " + std::string(configured)).c_str());
+        }
+    }
+
+    // otherwise the width of the core's pool the hashing runs on
+    return dpm_worker_threads();
+}
@@ -89,6 +89,12 @@ extern "C" int dpm_module_execute(const char* command, int argc, char** argv) {
         case CMD_CHECK:
             return cmd_check(argc, argv);
 
+        case CMD_CACHE_PRUNE:
+            return cmd_cache_prune(argc, argv);
+
+        case CMD_RANGE:
+            return cmd_range(argc, argv);
+
         case CMD_HELP:
             return cmd_help(argc, argv);
 
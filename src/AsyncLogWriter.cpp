@@ -0,0 +1,329 @@
+/**
+ * @file AsyncLogWriter.cpp
+ * @brief Implementation of the background log file writer
+ *
+ * Keeps the log file open, queues records in a bounded ring and appends
+ * them from a single writer thread.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+ */
+
+#include "AsyncLogWriter.hpp"
+
+// the writer that follows its process across fork(), the logger's
+static AsyncLogWriter* s_fork_writer = nullptr;
+static std::once_flag s_fork_handlers;
+
+// records taken from the ring before they are written at once
+static const size_t LOG_BATCH_RECORDS = 256;
+
+static const char* log_level_label(LoggingLevels level)
+{
+    switch (level) {
+        case LoggingLevels::FATAL:
+            return "FATAL";
+        case LoggingLevels::ERROR:
+            return "ERROR";
+        case LoggingLevels::WARN:
+            return "WARN";
+        case LoggingLevels::INFO:
+            return "INFO";
+        case LoggingLevels::DEBUG:
+            return "DEBUG";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+AsyncLogWriter::AsyncLogWriter()
+    : _ring(new Record[DPM_LOG_RING_CAPACITY]),
+      _head(0),
+      _tail(0),
+      _written(0),
+      _fd(-1),
+      _running(false),
+      _stopping(false),
+      _cached_second(-1)
+{
+    static_assert((DPM_LOG_RING_CAPACITY & (DPM_LOG_RING_CAPACITY - 1)) == 0,
+                  "DPM_LOG_RING_CAPACITY must be a power of two");
+    _cached_timestamp[0] = '\0';
+    reset_ring();
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+    close();
+    if (s_fork_writer == this) {
+        s_fork_writer = nullptr;
+    }
+}
+
+void AsyncLogWriter::reset_ring()
+{
+    for (size_t i = 0; i < DPM_LOG_RING_CAPACITY; i++) {
+        _ring[i].sequence.store(i, std::memory_order_relaxed);
+        _ring[i].message.clear();
+    }
+    _head.store(0, std::memory_order_relaxed);
+    _tail = 0;
+    _written.store(0, std::memory_order_release);
+}
+
+bool AsyncLogWriter::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    _fd.store(fd, std::memory_order_release);
+    return true;
+}
+
+bool AsyncLogWriter::is_open() const
+{
+    return _fd.load(std::memory_order_acquire) >= 0;
+}
+
+void AsyncLogWriter::close()
+{
+    std::unique_ptr<std::thread> writer;
+    {
+        std::lock_guard<std::mutex> start_lock(_writer_mutex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_writer) {
+                _stopping = true;
+                _wake.notify_one();
+            }
+        }
+        writer = std::move(_writer);
+        if (writer) {
+            writer->join();
+        }
+        _running.store(false, std::memory_order_release);
+        _stopping = false;
+    }
+
+    int fd = _fd.exchange(-1, std::memory_order_acq_rel);
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool AsyncLogWriter::try_push(LoggingLevels level, std::time_t timestamp, std::string& message)
+{
+    size_t position = _head.load(std::memory_order_relaxed);
+    for (;;) {
+        Record& cell = _ring[position & (DPM_LOG_RING_CAPACITY - 1)];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0) {
+            if (_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell.level = level;
+                cell.timestamp = timestamp;
+                cell.message = std::move(message);
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            // the writer has not yet taken the record a full ring ago
+            return false;
+        } else {
+            position = _head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void AsyncLogWriter::submit(LoggingLevels level, std::time_t timestamp, std::string message)
+{
+    if (!is_open()) {
+        return;
+    }
+
+    ensure_writer();
+    while (!try_push(level, timestamp, message)) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _wake.notify_one();
+        }
+        std::this_thread::yield();
+    }
+}
+
+void AsyncLogWriter::flush()
+{
+    if (!_running.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    size_t target = _head.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_written.load(std::memory_order_acquire) >= target) {
+        return;
+    }
+    _wake.notify_one();
+    _drained.wait(lock, [&] {
+        return _written.load(std::memory_order_acquire) >= target || !_running.load(std::memory_order_acquire);
+    });
+}
+
+void AsyncLogWriter::ensure_writer()
+{
+    if (_running.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::call_once(s_fork_handlers, [] {
+        pthread_atfork(&AsyncLogWriter::prepare_fork, &AsyncLogWriter::parent_after_fork,
+                       &AsyncLogWriter::child_after_fork);
+    });
+
+    std::lock_guard<std::mutex> start_lock(_writer_mutex);
+    if (_running.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (!s_fork_writer) {
+        s_fork_writer = this;
+    }
+    _writer = std::make_unique<std::thread>(&AsyncLogWriter::writer_loop, this);
+    _running.store(true, std::memory_order_release);
+}
+
+void AsyncLogWriter::format(const Record& record, std::string& batch)
+{
+    if (record.timestamp != _cached_second) {
+        struct tm local;
+        localtime_r(&record.timestamp, &local);
+        std::strftime(_cached_timestamp, sizeof(_cached_timestamp), "%Y-%m-%d %H:%M:%S", &local);
+        _cached_second = record.timestamp;
+    }
+
+    batch += _cached_timestamp;
+    batch += " [";
+    batch += log_level_label(record.level);
+    batch += "] ";
+    batch += record.message;
+    batch += '\n';
+}
+
+size_t AsyncLogWriter::drain(std::string& batch)
+{
+    size_t count = 0;
+    while (count < LOG_BATCH_RECORDS) {
+        Record& cell = _ring[_tail & (DPM_LOG_RING_CAPACITY - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != _tail + 1) {
+            break;
+        }
+
+        format(cell, batch);
+        cell.message.clear();
+        cell.sequence.store(_tail + DPM_LOG_RING_CAPACITY, std::memory_order_release);
+        _tail++;
+        count++;
+    }
+    return count;
+}
+
+void AsyncLogWriter::writer_loop()
+{
+    std::string batch;
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;) {
+        lock.unlock();
+        size_t count = drain(batch);
+
+        const char* data = batch.data();
+        size_t remaining = batch.size();
+        while (remaining > 0) {
+            int fd = _fd.load(std::memory_order_acquire);
+            if (fd < 0) {
+                break;
+            }
+            ssize_t written = ::write(fd, data, remaining);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                // don't error out the program just for log file issues, stop writing to it
+                std::cerr << "Warning: Failed to write to log file: " << strerror(errno) << std::endl;
+                int failed = _fd.exchange(-1, std::memory_order_acq_rel);
+                if (failed >= 0) {
+                    ::close(failed);
+                }
+                break;
+            }
+            data += written;
+            remaining -= static_cast<size_t>(written);
+        }
+        batch.clear();
+        lock.lock();
+
+        if (count > 0) {
+            _written.store(_tail, std::memory_order_release);
+            _drained.notify_all();
+            continue;
+        }
+        if (_stopping) {
+            break;
+        }
+        // producers only wake the writer when they wait on it, otherwise it batches what arrives
+        _wake.wait_for(lock, std::chrono::milliseconds(50));
+    }
+    _drained.notify_all();
+}
+
+void AsyncLogWriter::prepare_fork()
+{
+    if (s_fork_writer) {
+        s_fork_writer->_writer_mutex.lock();
+        s_fork_writer->_mutex.lock();
+    }
+}
+
+void AsyncLogWriter::parent_after_fork()
+{
+    if (s_fork_writer) {
+        s_fork_writer->_mutex.unlock();
+        s_fork_writer->_writer_mutex.unlock();
+    }
+}
+
+void AsyncLogWriter::child_after_fork()
+{
+    AsyncLogWriter* writer = s_fork_writer;
+    if (!writer) {
+        return;
+    }
+
+    // the writer thread stayed in the parent, which also writes what was queued before the fork
+    (void) writer->_writer.release();
+    writer->_running.store(false, std::memory_order_relaxed);
+    writer->_stopping = false;
+    writer->reset_ring();
+
+    // the parent's writer may have been waiting on these, the child has no such waiter
+    new (&writer->_wake) std::condition_variable();
+    new (&writer->_drained) std::condition_variable();
+    writer->_mutex.unlock();
+    writer->_writer_mutex.unlock();
+}
\ No newline at end of file
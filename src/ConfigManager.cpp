@@ -85,14 +85,32 @@ bool ConfigManager::configDirExists() const
 bool ConfigManager::loadConfigurations()
 {
     // Clear existing configuration data
-    _config_data.clear();
+    _index.clear();
+    _entries.clear();
+    _sections.clear();
+    _storage.clear();
+    _snapshot.close();
+
+    // a current snapshot of the directory replaces parsing it, its strings are used in place
+    if (_snapshot.open(_config_dir)) {
+        for (const auto& value : _snapshot.values()) {
+            _entries.push_back(ConfigEntry{value.section, value.key, value.value});
+            ConfigEntry& entry = _entries.back();
+            _index[ConfigKeyView{entry.section, entry.key}] = &entry;
+        }
+        refreshSlots();
+        return true;
+    }
 
-    // Ensure DEFAULT_SECTION exists in the configuration data
-    _config_data[DEFAULT_SECTION] = std::map<std::string, std::string>();
+    // the directory is stat'ed before it is read, so a change while reading it invalidates the snapshot
+    struct stat directory_stat;
+    bool have_directory_stat = stat(_config_dir.c_str(), &directory_stat) == 0;
+    std::vector<ConfigSnapshotFile> parsed_files;
 
     // Check if the configuration directory exists
     if (!configDirExists()) {
         std::cerr << "Warning: Configuration directory does not exist: " << _config_dir << std::endl;
+        refreshSlots();
         return false;
     }
 
@@ -100,6 +118,7 @@ bool ConfigManager::loadConfigurations()
     DIR* dir = opendir(_config_dir.c_str());
     if (!dir) {
         std::cerr << "Error: Failed to open configuration directory: " << _config_dir << std::endl;
+        refreshSlots();
         return false;
     }
 
@@ -120,14 +139,30 @@ bool ConfigManager::loadConfigurations()
             filename.substr(filename.length() - 5) == ".conf") {
 
             std::string filepath = _config_dir + filename;
-            if (!parseConfigFile(filepath)) {
+            struct stat file_stat;
+            if (stat(filepath.c_str(), &file_stat) != 0 || !parseConfigFile(filepath)) {
                 std::cerr << "Warning: Failed to parse config file: " << filepath << std::endl;
                 success = false;
+                continue;
             }
+            parsed_files.push_back(ConfigSnapshotFile{filename, ConfigSnapshot::mtimeOf(file_stat),
+                                                      static_cast<uint64_t>(file_stat.st_size)});
         }
     }
 
     closedir(dir);
+    refreshSlots();
+
+    // the snapshot is only a cache, so failing to write it changes nothing
+    if (success && have_directory_stat) {
+        std::vector<ConfigSnapshotValue> values;
+        values.reserve(_entries.size());
+        for (const auto& entry : _entries) {
+            values.push_back(ConfigSnapshotValue{entry.section, entry.key, entry.value});
+        }
+        ConfigSnapshot::write(_config_dir, ConfigSnapshot::mtimeOf(directory_stat), parsed_files, values);
+    }
+
     return success;
 }
 
@@ -140,7 +175,7 @@ bool ConfigManager::parseConfigFile(const std::filesystem::path& config_file)
     }
 
     std::string line;
-    std::string current_section = DEFAULT_SECTION;
+    std::string_view current_section = internSection(DEFAULT_SECTION);
 
     // Process each line in the file
     while (std::getline(file, line)) {
@@ -154,20 +189,15 @@ bool ConfigManager::parseConfigFile(const std::filesystem::path& config_file)
 
         // Check for section header
         if (line[0] == '[' && line.back() == ']') {
-            current_section = line.substr(1, line.length() - 2);
-
             // Trim whitespace from section name
-            current_section = trimWhitespace(current_section);
+            std::string section_name = trimWhitespace(line.substr(1, line.length() - 2));
 
             // Skip empty section names, use default instead
-            if (current_section.empty()) {
-                current_section = DEFAULT_SECTION;
+            if (section_name.empty()) {
+                section_name = DEFAULT_SECTION;
             }
 
-            // Ensure section exists in the map
-            if (_config_data.find(current_section) == _config_data.end()) {
-                _config_data[current_section] = std::map<std::string, std::string>();
-            }
+            current_section = internSection(section_name);
 
             continue;
         }
@@ -183,8 +213,8 @@ bool ConfigManager::parseConfigFile(const std::filesystem::path& config_file)
                 continue;
             }
 
-            // Store in configuration map
-            _config_data[current_section][key] = value;
+            // Store in the configuration table
+            setConfigValue(current_section, key, value);
         }
     }
 
@@ -192,33 +222,85 @@ bool ConfigManager::parseConfigFile(const std::filesystem::path& config_file)
     return true;
 }
 
-std::optional<std::reference_wrapper<const std::string>> ConfigManager::findConfigValue(
-    const std::string& section, const std::string& key) const
+std::string_view ConfigManager::internSection(std::string_view section)
 {
-    // Check if section exists
-    auto section_it = _config_data.find(section);
-    if (section_it != _config_data.end()) {
-        // Check if key exists in section
-        auto key_it = section_it->second.find(key);
-        if (key_it != section_it->second.end()) {
-            return key_it->second;
+    for (const auto& interned : _sections) {
+        if (interned == section) {
+            return interned;
         }
     }
 
+    _sections.emplace_back(section);
+    return _sections.back();
+}
+
+void ConfigManager::setConfigValue(std::string_view section, const std::string& key, const std::string& value)
+{
+    // values are kept NUL-terminated, so they can be handed out as C strings
+    _storage.push_back(value);
+    std::string_view stored_value = _storage.back();
+
+    auto it = _index.find(ConfigKeyView{section, key});
+    if (it != _index.end()) {
+        it->second->value = stored_value;
+        return;
+    }
+
+    // the index views the stored strings, which do not move
+    _storage.push_back(key);
+    _entries.push_back(ConfigEntry{section, _storage.back(), stored_value});
+    ConfigEntry& entry = _entries.back();
+    _index.emplace(ConfigKeyView{entry.section, entry.key}, &entry);
+}
+
+const char* ConfigManager::findConfigValue(std::string_view section, std::string_view key) const
+{
+    // Check if key exists in section
+    auto it = _index.find(ConfigKeyView{section, key});
+    if (it != _index.end()) {
+        return it->second->value.data();
+    }
+
     // If section is not DEFAULT_SECTION and key was not found,
     // try looking in the DEFAULT_SECTION
     if (section != DEFAULT_SECTION) {
-        auto default_section_it = _config_data.find(DEFAULT_SECTION);
-        if (default_section_it != _config_data.end()) {
-            auto default_key_it = default_section_it->second.find(key);
-            if (default_key_it != default_section_it->second.end()) {
-                return default_key_it->second;
-            }
+        auto default_it = _index.find(ConfigKeyView{DEFAULT_SECTION, key});
+        if (default_it != _index.end()) {
+            return default_it->second->value.data();
         }
     }
 
     // Key not found in specified section or DEFAULT_SECTION
-    return std::nullopt;
+    return nullptr;
+}
+
+const char* const* ConfigManager::resolveConfigValue(const char* section, const char* key)
+{
+    if (!key) {
+        return nullptr;
+    }
+
+    std::string_view section_view = section ? section : DEFAULT_SECTION;
+    std::lock_guard<std::mutex> lock(_slot_mutex);
+
+    auto it = _slot_index.find(ConfigKeyView{section_view, key});
+    if (it != _slot_index.end()) {
+        return &it->second->value;
+    }
+
+    _slots.push_back(ConfigSlot{std::string(section_view), key, nullptr});
+    ConfigSlot& slot = _slots.back();
+    slot.value = findConfigValue(slot.section, slot.key);
+    _slot_index.emplace(ConfigKeyView{slot.section, slot.key}, &slot);
+    return &slot.value;
+}
+
+void ConfigManager::refreshSlots()
+{
+    std::lock_guard<std::mutex> lock(_slot_mutex);
+    for (auto& slot : _slots) {
+        slot.value = findConfigValue(slot.section, slot.key);
+    }
 }
 
 bool ConfigManager::hasConfigKey(const char* section, const char* key) const
@@ -228,10 +310,7 @@ bool ConfigManager::hasConfigKey(const char* section, const char* key) const
     }
 
     // Use the default section if none is provided
-    std::string section_str = section ? section : DEFAULT_SECTION;
-    std::string key_str(key);
-
-    return findConfigValue(section_str, key_str).has_value();
+    return findConfigValue(section ? section : DEFAULT_SECTION, key) != nullptr;
 }
 
 const char* ConfigManager::getConfigValue(const char* section, const char* key) const
@@ -241,15 +320,7 @@ const char* ConfigManager::getConfigValue(const char* section, const char* key)
     }
 
     // Use the default section if none is provided
-    std::string section_str = section ? section : DEFAULT_SECTION;
-    std::string key_str(key);
-
-    auto value_opt = findConfigValue(section_str, key_str);
-    if (value_opt.has_value()) {
-        return value_opt.value().get().c_str();
-    }
-
-    return nullptr;
+    return findConfigValue(section ? section : DEFAULT_SECTION, key);
 }
 
 std::string ConfigManager::getConfigString(const char* section, const char* key, const std::string& defaultValue) const
@@ -0,0 +1,322 @@
+/**
+ * @file ConfigSnapshot.cpp
+ * @brief Implementation of compiled configuration snapshots
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+ */
+
+#include "ConfigSnapshot.hpp"
+
+ConfigSnapshot::~ConfigSnapshot()
+{
+    close();
+}
+
+std::string ConfigSnapshot::pathFor(const std::string& config_dir)
+{
+    // FNV-1a of the directory path, so each configuration directory has its own snapshot
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : config_dir) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "config-%016llx.snapshot", static_cast<unsigned long long>(hash));
+    return std::string(DPMDefaults::CONFIG_SNAPSHOT_DIR) + name;
+}
+
+int64_t ConfigSnapshot::mtimeOf(const struct stat& st)
+{
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+bool ConfigSnapshot::stringAt(uint32_t offset, std::string_view& value) const
+{
+    if (offset >= _strings_size) {
+        return false;
+    }
+
+    const void* end = memchr(_strings + offset, '\0', _strings_size - offset);
+    if (!end) {
+        return false;
+    }
+
+    value = std::string_view(_strings + offset, static_cast<const char*>(end) - (_strings + offset));
+    return true;
+}
+
+bool ConfigSnapshot::open(const std::string& config_dir)
+{
+    close();
+
+    int fd = ::open(pathFor(config_dir).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ConfigSnapshotHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    _mapping_size = static_cast<size_t>(st.st_size);
+    _mapping = mmap(nullptr, _mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (_mapping == MAP_FAILED) {
+        _mapping = nullptr;
+        _mapping_size = 0;
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(_mapping);
+    ConfigSnapshotHeader header;
+    memcpy(&header, base, sizeof(header));
+
+    size_t files_size = static_cast<size_t>(header.file_count) * sizeof(ConfigSnapshotFileRecord);
+    size_t entries_size = static_cast<size_t>(header.entry_count) * sizeof(ConfigSnapshotEntryRecord);
+    if (memcmp(header.magic, CONFIG_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        sizeof(header) + files_size + entries_size + header.strings_size != _mapping_size) {
+        close();
+        return false;
+    }
+
+    const char* files = base + sizeof(header);
+    const char* entries = files + files_size;
+    _strings = entries + entries_size;
+    _strings_size = header.strings_size;
+
+    // the snapshot must have been compiled from this very directory, as it is now
+    std::string_view directory;
+    struct stat directory_stat;
+    if (!stringAt(header.directory_offset, directory) || directory != config_dir ||
+        stat(config_dir.c_str(), &directory_stat) != 0 || mtimeOf(directory_stat) != header.directory_mtime) {
+        close();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.file_count; i++) {
+        ConfigSnapshotFileRecord record;
+        memcpy(&record, files + i * sizeof(record), sizeof(record));
+
+        std::string_view name;
+        struct stat file_stat;
+        if (!stringAt(record.name_offset, name) ||
+            stat((config_dir + std::string(name)).c_str(), &file_stat) != 0 ||
+            mtimeOf(file_stat) != record.mtime || static_cast<uint64_t>(file_stat.st_size) != record.size) {
+            close();
+            return false;
+        }
+    }
+
+    _values.reserve(header.entry_count);
+    for (uint32_t i = 0; i < header.entry_count; i++) {
+        ConfigSnapshotEntryRecord record;
+        memcpy(&record, entries + i * sizeof(record), sizeof(record));
+
+        ConfigSnapshotValue value;
+        if (!stringAt(record.section_offset, value.section) || !stringAt(record.key_offset, value.key) ||
+            !stringAt(record.value_offset, value.value)) {
+            close();
+            return false;
+        }
+        _values.push_back(value);
+    }
+
+    return true;
+}
+
+void ConfigSnapshot::close()
+{
+    if (_mapping) {
+        munmap(_mapping, _mapping_size);
+    }
+    _mapping = nullptr;
+    _mapping_size = 0;
+    _strings = nullptr;
+    _strings_size = 0;
+    _values.clear();
+}
+
+const std::vector<ConfigSnapshotValue>& ConfigSnapshot::values() const
+{
+    return _values;
+}
+
+bool ConfigSnapshot::write(const std::string& config_dir, int64_t directory_mtime,
+                           const std::vector<ConfigSnapshotFile>& files,
+                           const std::vector<ConfigSnapshotValue>& values)
+{
+    // strings are written once each, sections in particular repeat for every key
+    std::string strings;
+    std::map<std::string_view, uint32_t> offsets;
+    auto add_string = [&](std::string_view value) -> uint32_t {
+        auto it = offsets.find(value);
+        if (it != offsets.end()) {
+            return it->second;
+        }
+        uint32_t offset = static_cast<uint32_t>(strings.size());
+        strings.append(value);
+        strings.push_back('\0');
+        offsets.emplace(value, offset);
+        return offset;
+    };
+
+    ConfigSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CONFIG_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.file_count = static_cast<uint32_t>(files.size());
+    header.entry_count = static_cast<uint32_t>(values.size());
+    header.directory_mtime = directory_mtime;
+    header.directory_offset = add_string(config_dir);
+
+    std::vector<ConfigSnapshotFileRecord> file_records;
+    for (const auto& file : files) {
+        ConfigSnapshotFileRecord record;
+        memset(&record, 0, sizeof(record));
+        record.mtime = file.mtime;
+        record.size = file.size;
+        record.name_offset = add_string(file.name);
+        file_records.push_back(record);
+    }
+
+    std::vector<ConfigSnapshotEntryRecord> entry_records;
+    for (const auto& value : values) {
+        ConfigSnapshotEntryRecord record;
+        memset(&record, 0, sizeof(record));
+        record.section_offset = add_string(value.section);
+        record.key_offset = add_string(value.key);
+        record.value_offset = add_string(value.value);
+        entry_records.push_back(record);
+    }
+    header.strings_size = static_cast<uint32_t>(strings.size());
+
+    std::string path = pathFor(config_dir);
+    mkdir(DPMDefaults::CONFIG_SNAPSHOT_DIR, 0755);
+    std::string temporary = path + ".tmp." + std::to_string(getpid());
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    std::string image;
+    image.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    image.append(reinterpret_cast<const char*>(file_records.data()), file_records.size() * sizeof(ConfigSnapshotFileRecord));
+    image.append(reinterpret_cast<const char*>(entry_records.data()), entry_records.size() * sizeof(ConfigSnapshotEntryRecord));
+    image.append(strings);
+
+    bool written = ::write(fd, image.data(), image.size()) == static_cast<ssize_t>(image.size());
+    ::close(fd);
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    removeStale(config_dir, path);
+    return true;
+}
+
+bool ConfigSnapshot::directoryOf(const std::string& path, std::string& config_dir)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    ConfigSnapshotHeader header;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+        memcmp(header.magic, CONFIG_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.directory_offset >= header.strings_size) {
+        ::close(fd);
+        return false;
+    }
+
+    uint64_t strings_start = sizeof(header) +
+                             static_cast<uint64_t>(header.file_count) * sizeof(ConfigSnapshotFileRecord) +
+                             static_cast<uint64_t>(header.entry_count) * sizeof(ConfigSnapshotEntryRecord);
+    if (strings_start + header.strings_size != static_cast<uint64_t>(st.st_size)) {
+        ::close(fd);
+        return false;
+    }
+
+    // the directory is a path, so no more than PATH_MAX of the table needs reading
+    size_t length = std::min<size_t>(header.strings_size - header.directory_offset, PATH_MAX + 1);
+    std::string directory(length, '\0');
+    ssize_t got = pread(fd, directory.data(), length, static_cast<off_t>(strings_start + header.directory_offset));
+    ::close(fd);
+    if (got != static_cast<ssize_t>(length)) {
+        return false;
+    }
+
+    size_t end = directory.find('\0');
+    if (end == std::string::npos) {
+        return false;
+    }
+    directory.resize(end);
+    config_dir = directory;
+    return true;
+}
+
+void ConfigSnapshot::removeStale(const std::string& config_dir, const std::string& current)
+{
+    DIR* directory = opendir(DPMDefaults::CONFIG_SNAPSHOT_DIR);
+    if (!directory) {
+        return;
+    }
+
+    char resolved[PATH_MAX];
+    std::string canonical = realpath(config_dir.c_str(), resolved) ? resolved : config_dir;
+
+    while (struct dirent* entry = readdir(directory)) {
+        std::string_view name = entry->d_name;
+        if (name.substr(0, 7) != "config-") {
+            continue;
+        }
+        std::string path = std::string(DPMDefaults::CONFIG_SNAPSHOT_DIR) + entry->d_name;
+
+        // a temporary file is only left behind by a writer that is gone
+        size_t temporary = name.find(".snapshot.tmp.");
+        if (temporary != std::string_view::npos) {
+            pid_t pid = static_cast<pid_t>(atol(entry->d_name + temporary + 14));
+            if (pid > 0 && pid != getpid() && kill(pid, 0) != 0 && errno == ESRCH) {
+                unlink(path.c_str());
+            }
+            continue;
+        }
+
+        if (name.size() < 9 || name.substr(name.size() - 9) != ".snapshot" || path == current) {
+            continue;
+        }
+
+        // snapshots of this directory under another path, and of directories that are gone
+        std::string recorded;
+        if (!directoryOf(path, recorded)) {
+            continue;
+        }
+        bool gone = !realpath(recorded.c_str(), resolved) && (errno == ENOENT || errno == ENOTDIR);
+        if (gone || canonical == resolved) {
+            unlink(path.c_str());
+        }
+    }
+
+    closedir(directory);
+}
@@ -12,6 +12,8 @@ Logger::Logger()
 
 Logger::~Logger()
 {
+    std::cout.flush();
+    file_writer.close();
 }
 
 void Logger::setLogFile(const std::string& new_log_file)
@@ -40,18 +42,9 @@ void Logger::setLogFile(const std::string& new_log_file)
             }
         }
 
-        // Verify we can write to the log file
-        try {
-            std::ofstream test_log_file(log_file, std::ios::app);
-            if (!test_log_file.is_open()) {
-                std::cerr << "Warning: Cannot open log file for writing: " << log_file << std::endl;
-                // Continue execution, just disable file logging
-                log_to_file = false;
-                return;
-            }
-            test_log_file.close();
-        } catch (const std::exception& e) {
-            std::cerr << "Warning: Error validating log file access: " << e.what() << std::endl;
+        // Open the log file, which stays open for as long as it is logged to
+        if (!file_writer.open(log_file)) {
+            std::cerr << "Warning: Cannot open log file for writing: " << log_file << std::endl;
             // Continue execution, just disable file logging
             log_to_file = false;
             return;
@@ -62,6 +55,23 @@ void Logger::setLogFile(const std::string& new_log_file)
 void Logger::setWriteToLog(bool new_write_to_log)
 {
     log_to_file = new_write_to_log;
+
+    // the file is opened by setLogFile, or by the first message logged to it
+    if (!log_to_file) {
+        file_writer.close();
+    }
+}
+
+bool Logger::isEnabled(LoggingLevels level) const
+{
+    return level <= log_level;
+}
+
+void Logger::flush()
+{
+    std::cout.flush();
+    std::cerr.flush();
+    file_writer.flush();
 }
 
 void Logger::setLogLevel(LoggingLevels new_log_level)
@@ -109,36 +119,25 @@ void Logger::log(LoggingLevels message_level, const std::string& message)
 {
     // Only process if the message level is less than or equal to the configured level
     if (message_level <= log_level) {
-        // Convert log level to string
-        std::string level_str = LogLevelToString(message_level);
-
-        // Console output without timestamp
-        if (message_level == LoggingLevels::FATAL ||
-            message_level == LoggingLevels::ERROR ||
-            message_level == LoggingLevels::WARN) {
-            // Send to stderr
-            std::cerr << level_str << ": " << message << std::endl;
-        } else {
-            // Send to stdout
-            std::cout << message << std::endl;
-        }
+        bool queue_to_file = false;
+        {
+            std::lock_guard<std::mutex> lock(log_mutex);
+
+            // Console output without timestamp
+            if (message_level == LoggingLevels::FATAL ||
+                message_level == LoggingLevels::ERROR ||
+                message_level == LoggingLevels::WARN) {
+                // Send to stderr, after whatever stdout still holds so the two stay in order
+                std::cout.flush();
+                std::cerr << LogLevelToString(message_level) << ": " << message << '\n';
+            } else {
+                // Send to stdout, which is flushed by the next error, a FATAL message or exit
+                std::cout << message << '\n';
+            }
 
-        // Write to log file if enabled (with timestamp)
-        if (log_to_file) {
-            try {
-                // Get current time for timestamp (only for log file)
-                std::time_t now = std::time(nullptr);
-                char timestamp[32];
-                std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
-
-                // Full formatted message with timestamp for log file
-                std::string formatted_message = std::string(timestamp) + " [" + level_str + "] " + message;
-
-                std::ofstream log_stream(log_file, std::ios::app);
-                if (log_stream.is_open()) {
-                    log_stream << formatted_message << std::endl;
-                    log_stream.close();
-                } else {
+            // Open the log file on the first message if setLogFile has not
+            if (log_to_file && !file_writer.is_open()) {
+                if (!file_writer.open(log_file)) {
                     // Just log to console, don't error out the program just for log file issues
                     if (message_level != LoggingLevels::FATAL && message_level != LoggingLevels::ERROR) {
                         std::cerr << "Warning: Failed to write to log file: " << log_file << std::endl;
@@ -146,14 +145,17 @@ void Logger::log(LoggingLevels message_level, const std::string& message)
                     // Disable file logging for future messages
                     log_to_file = false;
                 }
-            } catch (const std::exception& e) {
-                // Just log to console, don't error out the program just for log file issues
-                if (message_level != LoggingLevels::FATAL && message_level != LoggingLevels::ERROR) {
-                    std::cerr << "Warning: Error writing to log file: " << e.what() << std::endl;
-                }
-                // Disable file logging for future messages
-                log_to_file = false;
             }
+            queue_to_file = log_to_file;
+        }
+
+        // Queue for the log file, the timestamp is formatted by the writer
+        if (queue_to_file) {
+            file_writer.submit(message_level, std::time(nullptr), message);
+        }
+
+        if (message_level == LoggingLevels::FATAL) {
+            flush();
         }
     }
 }
@@ -162,6 +164,8 @@ void Logger::log_console(LoggingLevels level, const std::string& message)
 {
     // Only process if the message level is less than or equal to the configured level
     if (level <= log_level) {
+        std::lock_guard<std::mutex> lock(log_mutex);
+
         // Convert log level to string
         std::string level_str = LogLevelToString(level);
 
@@ -169,11 +173,12 @@ void Logger::log_console(LoggingLevels level, const std::string& message)
         if (level == LoggingLevels::FATAL ||
             level == LoggingLevels::ERROR ||
             level == LoggingLevels::WARN) {
-            // Send to stderr
-            std::cerr << level_str << ": " << message << std::endl;
+            // Send to stderr, after whatever stdout still holds so the two stay in order
+            std::cout.flush();
+            std::cerr << level_str << ": " << message << '\n';
             } else {
                 // Send to stdout
-                std::cout << message << std::endl;
+                std::cout << message << '\n';
             }
     }
 }
\ No newline at end of file
@@ -0,0 +1,219 @@
+/**
+ * @file Metrics.cpp
+ * @brief Implementation of the metrics shared with modules
+ *
+ * Records into slots kept for each thread that records, and adds the
+ * slots together when the metrics are written as Prometheus text or JSON.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+ */
+
+#include "Metrics.hpp"
+
+// Global metrics instance
+Metrics g_metrics;
+
+Metrics::Metrics()
+    : _kinds(),
+      _count(0),
+      _full_warned(false),
+      _enabled(false)
+{
+}
+
+Metrics::ThreadSlots& Metrics::thread_slots()
+{
+    // the slots outlive their thread, so what it recorded is still written out after it exits
+    thread_local ThreadSlots* slots = nullptr;
+    if (!slots) {
+        slots = new ThreadSlots();
+        std::lock_guard<std::mutex> lock(g_metrics._mutex);
+        g_metrics._threads.push_back(slots);
+    }
+    return *slots;
+}
+
+void Metrics::enable()
+{
+    _enabled.store(true, std::memory_order_release);
+}
+
+bool Metrics::enabled() const
+{
+    return _enabled.load(std::memory_order_relaxed);
+}
+
+int Metrics::find(ThreadSlots& slots, const char* name, Kind kind)
+{
+    auto known = slots.known.find(name);
+    if (known != slots.known.end() && _names[known->second] == name) {
+        return _kinds[known->second] == kind ? known->second : -1;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t index = 0;
+    while (index < _count && _names[index] != name) {
+        index++;
+    }
+
+    if (index == _count) {
+        if (_count == METRICS_MAX) {
+            if (!_full_warned) {
+                _full_warned = true;
+                g_logger.log(LoggingLevels::WARN, "Too many metrics recorded, ignoring " + std::string(name));
+            }
+            return -1;
+        }
+        _names[index] = name;
+        _kinds[index] = kind;
+        _count++;
+    }
+
+    slots.known[name] = static_cast<int>(index);
+    return _kinds[index] == kind ? static_cast<int>(index) : -1;
+}
+
+void Metrics::add(const char* name, uint64_t value)
+{
+    if (!enabled() || !name) {
+        return;
+    }
+
+    ThreadSlots& slots = thread_slots();
+    int index = find(slots, name, COUNTER);
+    if (index < 0) {
+        return;
+    }
+
+    // only this thread writes its slots, the atomics let writers of the metrics read them meanwhile
+    Slot& slot = slots.slots[index];
+    slot.count.store(slot.count.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void Metrics::observe(const char* name, double value)
+{
+    if (!enabled() || !name) {
+        return;
+    }
+
+    ThreadSlots& slots = thread_slots();
+    int index = find(slots, name, OBSERVATION);
+    if (index < 0) {
+        return;
+    }
+
+    Slot& slot = slots.slots[index];
+    uint64_t count = slot.count.load(std::memory_order_relaxed);
+    slot.count.store(count + 1, std::memory_order_relaxed);
+    slot.sum.store(slot.sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    if (count == 0 || value > slot.max.load(std::memory_order_relaxed)) {
+        slot.max.store(value, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::collect(std::vector<Total>& totals)
+{
+    totals.assign(_count, Total());
+    for (const ThreadSlots* thread : _threads) {
+        for (size_t i = 0; i < _count; i++) {
+            totals[i].count += thread->slots[i].count.load(std::memory_order_relaxed);
+            totals[i].sum += thread->slots[i].sum.load(std::memory_order_relaxed);
+            totals[i].max = std::max(totals[i].max, thread->slots[i].max.load(std::memory_order_relaxed));
+        }
+    }
+}
+
+void Metrics::write_prometheus(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<Total> totals;
+    collect(totals);
+
+    char value[64];
+    for (size_t i = 0; i < _count; i++) {
+        const std::string& name = _names[i];
+        if (_kinds[i] == COUNTER) {
+            out << "# TYPE " << name << " counter\n"
+                << name << " " << totals[i].count << "\n";
+            continue;
+        }
+
+        out << "# TYPE " << name << " summary\n";
+        snprintf(value, sizeof(value), "%.9g", totals[i].sum);
+        out << name << "_sum " << value << "\n"
+            << name << "_count " << totals[i].count << "\n";
+        snprintf(value, sizeof(value), "%.9g", totals[i].max);
+        out << "# TYPE " << name << "_max gauge\n"
+            << name << "_max " << value << "\n";
+    }
+    out.flush();
+}
+
+void Metrics::write_json(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<Total> totals;
+    collect(totals);
+
+    // metric names are Prometheus names, which need no escaping
+    char value[64];
+    out << "{\n  \"counters\": {";
+    bool first = true;
+    for (size_t i = 0; i < _count; i++) {
+        if (_kinds[i] != COUNTER) {
+            continue;
+        }
+        out << (first ? "\n" : ",\n") << "    \"" << _names[i] << "\": " << totals[i].count;
+        first = false;
+    }
+    out << (first ? "},\n" : "\n  },\n");
+
+    out << "  \"observations\": {";
+    first = true;
+    for (size_t i = 0; i < _count; i++) {
+        if (_kinds[i] != OBSERVATION) {
+            continue;
+        }
+        out << (first ? "\n" : ",\n") << "    \"" << _names[i] << "\": {\"count\": " << totals[i].count;
+        snprintf(value, sizeof(value), "%.9g", totals[i].sum);
+        out << ", \"sum\": " << value;
+        snprintf(value, sizeof(value), "%.9g", totals[i].max);
+        out << ", \"max\": " << value << "}";
+        first = false;
+    }
+    out << (first ? "}\n" : "\n  }\n") << "}\n";
+    out.flush();
+}
+
+bool Metrics::write_file(const std::string& path)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    if (json) {
+        write_json(file);
+    } else {
+        write_prometheus(file);
+    }
+    return static_cast<bool>(file);
+}
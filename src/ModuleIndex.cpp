@@ -0,0 +1,201 @@
+/**
+ * @file ModuleIndex.cpp
+ * @brief Implementation of the persistent module metadata index
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+ */
+
+#include "ModuleIndex.hpp"
+
+ModuleIndex::ModuleIndex(std::string index_path)
+    : _index_path(std::move(index_path))
+{
+}
+
+std::string ModuleIndex::sanitize(const std::string& value)
+{
+    std::string result = value;
+    for (char& c : result) {
+        if (c == '\t' || c == '\n' || c == '\r') {
+            c = ' ';
+        }
+    }
+    return result;
+}
+
+bool ModuleIndex::load(const std::string& module_path)
+{
+    _module_path = module_path;
+    _entries.clear();
+    _changed = false;
+
+    std::ifstream file(_index_path);
+    if (!file.is_open()) {
+        _changed = true;
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line != MODULE_INDEX_HEADER ||
+        !std::getline(file, line) || line != "# module_path: " + module_path) {
+        _changed = true;
+        return false;
+    }
+
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, '\t')) {
+            fields.push_back(field);
+        }
+        if (!line.empty() && line.back() == '\t') {
+            fields.push_back("");
+        }
+
+        // a malformed line only costs loading that module again
+        if (fields.size() != 8) {
+            _changed = true;
+            continue;
+        }
+
+        ModuleIndexEntry entry;
+        entry.name = fields[0];
+        entry.path = fields[1];
+        try {
+            entry.mtime = std::stoll(fields[2]);
+            entry.size = std::stoull(fields[3]);
+        } catch (const std::exception&) {
+            _changed = true;
+            continue;
+        }
+        entry.valid = fields[4] == "1";
+
+        std::istringstream symbols(fields[5]);
+        std::string symbol;
+        while (std::getline(symbols, symbol, ',')) {
+            if (!symbol.empty()) {
+                entry.symbols.push_back(symbol);
+            }
+        }
+
+        entry.version = fields[6];
+        entry.description = fields[7];
+        _entries[entry.name] = std::move(entry);
+    }
+
+    return true;
+}
+
+const ModuleIndexEntry* ModuleIndex::find(const std::string& name, const std::string& path,
+                                          int64_t mtime, uint64_t size) const
+{
+    auto it = _entries.find(name);
+    if (it == _entries.end()) {
+        return nullptr;
+    }
+
+    const ModuleIndexEntry& entry = it->second;
+    if (entry.path != path || entry.mtime != mtime || entry.size != size) {
+        return nullptr;
+    }
+    return &entry;
+}
+
+void ModuleIndex::update(const ModuleIndexEntry& entry)
+{
+    ModuleIndexEntry recorded = entry;
+    recorded.version = sanitize(entry.version);
+    recorded.description = sanitize(entry.description);
+    _entries[recorded.name] = std::move(recorded);
+    _changed = true;
+}
+
+void ModuleIndex::retain(const std::vector<std::string>& names)
+{
+    std::map<std::string, ModuleIndexEntry> retained;
+    for (const auto& name : names) {
+        auto it = _entries.find(name);
+        if (it != _entries.end()) {
+            retained.emplace(name, std::move(it->second));
+        }
+    }
+
+    if (retained.size() != _entries.size()) {
+        _changed = true;
+    }
+    _entries = std::move(retained);
+}
+
+bool ModuleIndex::save()
+{
+    if (!_changed) {
+        return true;
+    }
+
+    std::error_code ec;
+    std::filesystem::path index_path(_index_path);
+    if (index_path.has_parent_path()) {
+        std::filesystem::create_directories(index_path.parent_path(), ec);
+        if (ec) {
+            return false;
+        }
+    }
+
+    std::string temporary = _index_path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        file << MODULE_INDEX_HEADER << "\n";
+        file << "# module_path: " << _module_path << "\n";
+        for (const auto& [name, entry] : _entries) {
+            std::string symbols;
+            for (size_t i = 0; i < entry.symbols.size(); i++) {
+                symbols += (i == 0 ? "" : ",") + entry.symbols[i];
+            }
+
+            file << entry.name << '\t' << entry.path << '\t' << entry.mtime << '\t' << entry.size << '\t'
+                 << (entry.valid ? "1" : "0") << '\t' << symbols << '\t' << entry.version << '\t'
+                 << entry.description << "\n";
+        }
+
+        if (!file) {
+            file.close();
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, _index_path, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+
+    _changed = false;
+    return true;
+}
@@ -101,123 +101,53 @@ DPMErrorCategory ModuleLoader::list_available_modules(std::vector<std::string>&
         return path_check;
     }
 
-    // prepare to iterate the directory
-    DIR* dir = opendir(_module_path.c_str());
-    if (!dir) {
-        // Check errno to determine the cause of the failure
-        switch (errno) {
-            case EACCES:
-                return DPMErrorCategory::PERMISSION_DENIED;
-            case ENOENT:
-                return DPMErrorCategory::PATH_NOT_FOUND;
-            case ENOTDIR:
-                return DPMErrorCategory::PATH_NOT_DIRECTORY;
-            default:
-                return DPMErrorCategory::UNDEFINED_ERROR;
-        }
-    }
-
-    // read each entry
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != NULL) {
-        // skip . and ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-
-        // build the full path
-        std::string full_path = _module_path + entry->d_name;
-
-        // verify it's a file or a symlink
-        struct stat st;
-        if (stat(full_path.c_str(), &st) == -1) {
-            continue;
-        }
-
-        // Skip if not a regular file or a symlink
-        if (!S_ISREG(st.st_mode) && !S_ISLNK(st.st_mode)) {
-            continue;
-        }
-
-        // get length of filename for boundary checking
-        size_t name_len = strlen(entry->d_name);
-
-        // skip if filename too short to be .so
-        if (name_len <= 3) {
-            continue;
-        }
-
-        // verify file ends in .so
-        if (strcmp(entry->d_name + name_len - 3, ".so") != 0) {
-            continue;
-        }
-
-        // calculate the module name length
-        size_t module_name_len = name_len - 3;
-
-        // create space for the module name
-        char * module_name = (char*) malloc(module_name_len + 1);
-        if (!module_name) {
-            closedir(dir);
-            return DPMErrorCategory::UNDEFINED_ERROR;
-        }
-
-        // copy the name without .so
-        strncpy(module_name, entry->d_name, module_name_len);
-        module_name[module_name_len] = '\0';
-
-        // add to our list
-        modules.push_back(std::string(module_name));
-
-        // clean up
-        free(module_name);
+    // the directory is read once per run, later listings come from the registry
+    DPMErrorCategory scan_error = g_module_registry.scan(_module_path);
+    if (scan_error != DPMErrorCategory::SUCCESS) {
+        return scan_error;
     }
 
-    // clean up
-    closedir(dir);
+    modules = g_module_registry.names();
 
     return DPMErrorCategory::SUCCESS;
 }
 
 DPMErrorCategory ModuleLoader::load_module(const std::string& module_name, void*& module_handle) const
 {
-    // First check if the module exists in the list of available modules
-    std::vector<std::string> available_modules;
-    DPMErrorCategory list_error = list_available_modules( available_modules );
-
-    // if there was a listing error, return that
-    if ( list_error != DPMErrorCategory::SUCCESS ) {
-        return list_error;
-    }
-
-    // Check if the requested module is in the list of available modules
-    bool module_found = false;
-    for ( size_t i = 0; i < available_modules.size(); i++ ) {
-        if ( available_modules[i] == module_name ) {
-            module_found = true;
-            break;
-        }
+    // First check if the module exists in the module path, which is only read the first time
+    DPMErrorCategory scan_error = g_module_registry.scan(_module_path);
+    if (scan_error != DPMErrorCategory::SUCCESS) {
+        return scan_error;
     }
 
-    // if the supplied module isn't in the list of available modules, return the error
-    if ( !module_found ) {
+    // if the supplied module isn't in the registry, return the error
+    ModuleRegistryEntry* entry = g_module_registry.find(module_name);
+    if (!entry) {
         return DPMErrorCategory::MODULE_NOT_FOUND;
     }
 
-    // construct the path to load the module from based on supplied identifier
-    // DPM uses whatever the file name is
-    std::string module_so_path = _module_path + module_name + ".so";
+    // a module is opened and validated once per run, later loads share the result
+    if (entry->attempted) {
+        module_handle = entry->handle;
+        return entry->status;
+    }
+    entry->attempted = true;
 
     // go ahead and open the module
-    module_handle = dlopen(module_so_path.c_str(), RTLD_LAZY);
+    // DPM uses whatever the file name is
+    module_handle = dlopen(entry->path.c_str(), RTLD_LAZY);
     if (!module_handle) {
-        return DPMErrorCategory::MODULE_LOAD_FAILED;
+        entry->status = DPMErrorCategory::MODULE_LOAD_FAILED;
+        return entry->status;
     }
 
     // if there was a loading error, return that
     const char * load_error = dlerror();
     if ( load_error != nullptr ) {
-        return DPMErrorCategory::MODULE_LOAD_FAILED;
+        dlclose( module_handle );
+        module_handle = nullptr;
+        entry->status = DPMErrorCategory::MODULE_LOAD_FAILED;
+        return entry->status;
     }
 
     // validate the module's exposed API
@@ -227,14 +157,48 @@ DPMErrorCategory ModuleLoader::load_module(const std::string& module_name, void*
     if ( validate_error != DPMErrorCategory::SUCCESS ) {
         // we failed to validate the interface, so close the module handle since we won't use it
         dlclose( module_handle );
-        return validate_error;
+        module_handle = nullptr;
+        entry->status = validate_error;
+        return entry->status;
+    }
+
+    // keep the handle for the rest of the run
+    entry->handle = module_handle;
+    entry->status = DPMErrorCategory::SUCCESS;
+    g_metrics.add("dpm_modules_loaded_total", 1);
+    return entry->status;
+}
+
+DPMErrorCategory ModuleLoader::acquire_module(const std::string& module_name, void*& module_handle) const
+{
+    void* registered_handle = nullptr;
+    DPMErrorCategory load_error = load_module(module_name, registered_handle);
+    if (load_error != DPMErrorCategory::SUCCESS) {
+        return load_error;
     }
 
-    // return what's going to be a success
-    return validate_error;
+    // take a reference on the already loaded module, which yields the registered handle
+    module_handle = dlopen(g_module_registry.find(module_name)->path.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+    if (!module_handle) {
+        return DPMErrorCategory::MODULE_LOAD_FAILED;
+    }
+
+    return DPMErrorCategory::SUCCESS;
 }
 
 DPMErrorCategory ModuleLoader::execute_module(const std::string& module_name, const std::string& command) const {
+    // Split the command by spaces to get arguments
+    std::vector<std::string> args;
+    std::string arg;
+    std::istringstream iss(command);
+    while (iss >> arg) {
+        args.push_back(arg);
+    }
+
+    return execute_module(module_name, args);
+}
+
+DPMErrorCategory ModuleLoader::execute_module(const std::string& module_name, const std::vector<std::string>& args) const {
     // declare a module_handle
     void * module_handle;
 
@@ -247,7 +211,6 @@ DPMErrorCategory ModuleLoader::execute_module(const std::string& module_name, co
     // Clear any previous error state and handle any residual failure
     const char* pre_error = dlerror();
     if (pre_error != nullptr) {
-        dlclose(module_handle);
         return DPMErrorCategory::UNDEFINED_ERROR;
     }
 
@@ -260,29 +223,20 @@ DPMErrorCategory ModuleLoader::execute_module(const std::string& module_name, co
     // do basic error handling to detect if the symbol look up was successful
     const char * dlsym_error = dlerror();
     if (dlsym_error != nullptr) {
-        dlclose(module_handle);
         return DPMErrorCategory::SYMBOL_NOT_FOUND;
     }
 
     // check if the void pointer was populated
     if (execute_fn == nullptr) {
-        dlclose(module_handle);
         return DPMErrorCategory::SYMBOL_NOT_FOUND;
     }
 
-    // Split the command by spaces to get arguments
-    std::vector<std::string> args;
-    std::string arg;
-    std::istringstream iss(command);
-    while (iss >> arg) {
-        args.push_back(arg);
-    }
-
-    // Create argc and argv for all arguments
+    // Create argc and argv for all arguments, pointing at the caller's strings
+    // modules may reorder argv, as getopt does, but do not write to the strings
     int argc = args.size();
-    char** argv = new char*[argc];
+    std::vector<char*> argv(argc + 1, nullptr);
     for (int i = 0; i < argc; i++) {
-        argv[i] = strdup(args[i].c_str());
+        argv[i] = const_cast<char*>(args[i].c_str());
     }
 
     // Get the first argument as the command (or empty string if no arguments)
@@ -292,16 +246,9 @@ DPMErrorCategory ModuleLoader::execute_module(const std::string& module_name, co
     }
 
     // execute the function with all arguments
-    int exec_error = execute_fn(cmd, argc, argv);
-
-    // Clean up
-    for (int i = 0; i < argc; i++) {
-        free(argv[i]);
-    }
-    delete[] argv;
+    int exec_error = execute_fn(cmd, argc, argv.data());
 
-    // irregardless of result, this is the time to close the module handle
-    dlclose(module_handle);
+    // the handle stays open in the registry, modules may still be used by other modules
 
     // if the result of execution was not 0, return an error
     if (exec_error != 0) {
@@ -0,0 +1,129 @@
+/**
+ * @file ModuleRegistry.cpp
+ * @brief Implementation of the in-process module registry
+ *
+ * Scans the module path once per run and keeps the entries and loaded
+ * handles of the modules found there.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+ */
+
+#include "ModuleRegistry.hpp"
+
+// Global module registry instance
+ModuleRegistry g_module_registry;
+
+DPMErrorCategory ModuleRegistry::scan(const std::string& module_path)
+{
+    if (_scanned && module_path == _module_path) {
+        return DPMErrorCategory::SUCCESS;
+    }
+
+    // prepare to iterate the directory
+    DIR* dir = opendir(module_path.c_str());
+    if (!dir) {
+        // Check errno to determine the cause of the failure
+        switch (errno) {
+            case EACCES:
+                return DPMErrorCategory::PERMISSION_DENIED;
+            case ENOENT:
+                return DPMErrorCategory::PATH_NOT_FOUND;
+            case ENOTDIR:
+                return DPMErrorCategory::PATH_NOT_DIRECTORY;
+            default:
+                return DPMErrorCategory::UNDEFINED_ERROR;
+        }
+    }
+
+    std::vector<std::string> names;
+    std::unordered_map<std::string, ModuleRegistryEntry> entries;
+
+    // read each entry
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        // skip . and ..
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        // get length of filename for boundary checking
+        size_t name_len = strlen(entry->d_name);
+
+        // skip if filename too short to be .so, or doesn't end in .so
+        if (name_len <= 3 || strcmp(entry->d_name + name_len - 3, ".so") != 0) {
+            continue;
+        }
+
+        // build the full path
+        std::string full_path = module_path + entry->d_name;
+
+        // verify it's a file or a symlink
+        struct stat st;
+        if (stat(full_path.c_str(), &st) == -1) {
+            continue;
+        }
+
+        // Skip if not a regular file or a symlink
+        if (!S_ISREG(st.st_mode) && !S_ISLNK(st.st_mode)) {
+            continue;
+        }
+
+        // the module name is the file name without .so
+        std::string module_name(entry->d_name, name_len - 3);
+        names.push_back(module_name);
+        ModuleRegistryEntry& registered = entries[module_name];
+        registered.path = full_path;
+        registered.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        registered.size = static_cast<uint64_t>(st.st_size);
+    }
+
+    // clean up
+    closedir(dir);
+
+    // carry over the handles of modules that are still at the same path
+    for (auto& [name, registered] : entries) {
+        auto previous = _entries.find(name);
+        if (previous != _entries.end() && previous->second.path == registered.path &&
+            previous->second.mtime == registered.mtime && previous->second.size == registered.size) {
+            registered = previous->second;
+        }
+    }
+
+    _module_path = module_path;
+    _names = std::move(names);
+    _entries = std::move(entries);
+    _scanned = true;
+
+    return DPMErrorCategory::SUCCESS;
+}
+
+const std::vector<std::string>& ModuleRegistry::names() const
+{
+    return _names;
+}
+
+ModuleRegistryEntry* ModuleRegistry::find(const std::string& module_name)
+{
+    auto it = _entries.find(module_name);
+    if (it == _entries.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
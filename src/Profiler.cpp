@@ -0,0 +1,240 @@
+/**
+ * @file Profiler.cpp
+ * @brief Implementation of the per-phase profiler
+ *
+ * Keeps a stack of open phases per thread and adds the time and counts
+ * of each phase to its node in the tree when it closes, and to the trace
+ * buffer of the thread when tracing.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+ */
+
+#include "Profiler.hpp"
+
+// Global profiler instance
+Profiler g_profiler;
+
+thread_local std::vector<Profiler::Frame> Profiler::_stack;
+thread_local std::map<std::pair<const Profiler::Node*, const char*>, Profiler::Node*> Profiler::_known;
+
+Profiler::Profiler()
+    : _enabled(false),
+      _tracing(false)
+{
+}
+
+void Profiler::enable()
+{
+    if (enabled()) {
+        return;
+    }
+    _started = std::chrono::steady_clock::now();
+    _enabled.store(true, std::memory_order_release);
+}
+
+void Profiler::enable_trace()
+{
+    enable();
+    _tracing.store(true, std::memory_order_release);
+}
+
+Profiler::TraceBuffer& Profiler::trace_buffer()
+{
+    // the buffers outlive their threads, so the events of a thread that exited are still written
+    thread_local TraceBuffer* buffer = nullptr;
+    if (!buffer) {
+        buffer = new TraceBuffer();
+        std::lock_guard<std::mutex> lock(_mutex);
+        buffer->thread = _traces.size() + 1;
+        _traces.push_back(buffer);
+    }
+    return *buffer;
+}
+
+bool Profiler::enabled() const
+{
+    return _enabled.load(std::memory_order_relaxed);
+}
+
+Profiler::Node* Profiler::child(Node* parent, const char* name)
+{
+    // a name seen under this parent before is found without the lock, as long as it still reads the same
+    auto key = std::make_pair(static_cast<const Node*>(parent), name);
+    auto known = _known.find(key);
+    if (known != _known.end() && known->second->name == name) {
+        return known->second;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    Node* found = nullptr;
+    for (Node* candidate : parent->children) {
+        if (candidate->name == name) {
+            found = candidate;
+            break;
+        }
+    }
+    if (!found) {
+        _nodes.push_back(std::make_unique<Node>());
+        found = _nodes.back().get();
+        found->name = name;
+        parent->children.push_back(found);
+    }
+
+    _known[key] = found;
+    return found;
+}
+
+int Profiler::begin(const char* name)
+{
+    if (!enabled() || !name) {
+        return -1;
+    }
+
+    Node* parent = _stack.empty() ? &_root : _stack.back().node;
+    Node* node = child(parent, name);
+    _stack.push_back({node, std::chrono::steady_clock::now()});
+    return static_cast<int>(_stack.size() - 1);
+}
+
+void Profiler::end(int scope, uint64_t bytes, uint64_t files)
+{
+    if (scope < 0 || static_cast<size_t>(scope) >= _stack.size()) {
+        return;
+    }
+
+    _stack[scope].node->bytes.fetch_add(bytes, std::memory_order_relaxed);
+    _stack[scope].node->files.fetch_add(files, std::memory_order_relaxed);
+
+    // phases left open inside this one are closed with it
+    auto now = std::chrono::steady_clock::now();
+    bool tracing = _tracing.load(std::memory_order_relaxed);
+    while (_stack.size() > static_cast<size_t>(scope)) {
+        Frame frame = _stack.back();
+        _stack.pop_back();
+
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - frame.start).count();
+        frame.node->calls.fetch_add(1, std::memory_order_relaxed);
+        frame.node->nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+
+        if (tracing) {
+            bool closed = _stack.size() == static_cast<size_t>(scope);
+            TraceEvent event = {
+                frame.node,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(frame.start - _started).count(),
+                static_cast<int64_t>(elapsed),
+                closed ? bytes : 0,
+                closed ? files : 0
+            };
+            TraceBuffer& buffer = trace_buffer();
+            std::lock_guard<std::mutex> lock(buffer.mutex);
+            buffer.events.push_back(event);
+        }
+    }
+}
+
+void Profiler::report_node(std::ostream& out, const Node* node, int depth)
+{
+    uint64_t total = node->nanoseconds.load(std::memory_order_relaxed);
+    uint64_t children = 0;
+    for (const Node* child_node : node->children) {
+        children += child_node->nanoseconds.load(std::memory_order_relaxed);
+    }
+    // children run on worker threads can add up to more than their parent
+    uint64_t self = total > children ? total - children : 0;
+
+    char line[512];
+    snprintf(line, sizeof(line), "%10llu %12.3f %12.3f %12.3f %10llu  %*s%s\n",
+             static_cast<unsigned long long>(node->calls.load(std::memory_order_relaxed)),
+             total / 1e6, self / 1e6,
+             node->bytes.load(std::memory_order_relaxed) / (1024.0 * 1024.0),
+             static_cast<unsigned long long>(node->files.load(std::memory_order_relaxed)),
+             depth * 2, "", node->name.c_str());
+    out << line;
+
+    for (const Node* child_node : node->children) {
+        report_node(out, child_node, depth + 1);
+    }
+}
+
+void Profiler::report(std::ostream& out)
+{
+    if (!enabled()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _started).count();
+    char line[512];
+    snprintf(line, sizeof(line), "DPM profile: %.3f ms wall time\n", wall);
+    out << line;
+
+    snprintf(line, sizeof(line), "%10s %12s %12s %12s %10s  %s\n",
+             "CALLS", "TOTAL MS", "SELF MS", "MB", "FILES", "PHASE");
+    out << line;
+
+    for (const Node* node : _root.children) {
+        report_node(out, node, 0);
+    }
+    out.flush();
+}
+
+void Profiler::write_trace(std::ostream& out)
+{
+    if (!_tracing.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    long pid = static_cast<long>(getpid());
+    char line[768];
+    bool first = true;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (TraceBuffer* buffer : _traces) {
+        snprintf(line, sizeof(line),
+                 "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%zu,"
+                 "\"args\":{\"name\":\"dpm thread %zu\"}}",
+                 first ? "" : ",\n", pid, buffer->thread, buffer->thread);
+        out << line;
+        first = false;
+
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        for (const TraceEvent& event : buffer->events) {
+            // phase names are identifiers and module names, only quotes and backslashes need escaping
+            std::string name;
+            for (char c : event.node->name) {
+                if (c == '"' || c == '\\') {
+                    name += '\\';
+                }
+                name += c;
+            }
+
+            snprintf(line, sizeof(line),
+                     ",\n{\"name\":\"%s\",\"cat\":\"dpm\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                     "\"pid\":%ld,\"tid\":%zu,\"args\":{\"bytes\":%llu,\"files\":%llu}}",
+                     name.c_str(), event.start / 1e3, event.duration / 1e3, pid, buffer->thread,
+                     static_cast<unsigned long long>(event.bytes), static_cast<unsigned long long>(event.files));
+            out << line;
+        }
+    }
+    out << "\n]}\n";
+    out.flush();
+}
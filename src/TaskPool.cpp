@@ -0,0 +1,388 @@
+/**
+ * @file TaskPool.cpp
+ * @brief Implementation of the worker thread pool shared with modules
+ *
+ * Starts the worker threads on first use and runs tasks from per-worker
+ * queues, stealing between them when a worker runs dry.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+ */
+
+#include "TaskPool.hpp"
+
+// Global task pool instance
+TaskPool g_task_pool;
+
+// the pool and queue of the worker running on this thread, if it is one
+static thread_local TaskPool* t_pool = nullptr;
+static thread_local size_t t_worker_index = 0;
+
+static std::once_flag s_fork_handlers;
+
+/**
+ * @brief One part of a dpm_parallel_for range, run as a task
+ */
+struct ParallelForPart {
+    dpm_range_function function;
+    void* context;
+    size_t begin;
+    size_t end;
+};
+
+static void parallel_for_part(void* context)
+{
+    ParallelForPart* part = static_cast<ParallelForPart*>(context);
+    part->function(part->context, part->begin, part->end);
+}
+
+TaskPool::TaskPool()
+    : _queued(0),
+      _started(false),
+      _worker_count(0),
+      _stopping(false)
+{
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _task_available.notify_all();
+
+    for (auto& worker : _workers) {
+        // exit() may be called from a task, which cannot join its own thread
+        if (worker->get_id() == std::this_thread::get_id()) {
+            worker->detach();
+        } else {
+            worker->join();
+        }
+    }
+}
+
+size_t TaskPool::available_cpus()
+{
+    size_t cpus = 0;
+    cpu_set_t affinity;
+    CPU_ZERO(&affinity);
+    if (sched_getaffinity(0, sizeof(affinity), &affinity) == 0) {
+        cpus = static_cast<size_t>(CPU_COUNT(&affinity));
+    }
+    if (cpus == 0) {
+        cpus = std::max<unsigned int>(1, std::thread::hardware_concurrency());
+    }
+
+    // a cgroup CPU quota caps how many of those CPUs the process can keep busy
+    long long quota = -1;
+    long long period = 0;
+    std::string cgroup_path;
+    std::ifstream cgroup_file("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(cgroup_file, line)) {
+        if (line.rfind("0::", 0) == 0) {
+            cgroup_path = line.substr(3);
+            break;
+        }
+    }
+
+    std::ifstream cpu_max("/sys/fs/cgroup" + cgroup_path + "/cpu.max");
+    std::string quota_text;
+    if (cpu_max >> quota_text >> period) {
+        // cgroup v2: "<quota> <period>", or "max <period>" when unlimited
+        if (quota_text != "max") {
+            quota = atoll(quota_text.c_str());
+        }
+    } else {
+        // cgroup v1 keeps the quota and period in files of their own
+        std::ifstream quota_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+        std::ifstream period_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+        if (!(quota_file >> quota) || !(period_file >> period)) {
+            quota = -1;
+        }
+    }
+
+    if (quota > 0 && period > 0) {
+        size_t quota_cpus = static_cast<size_t>((quota + period - 1) / period);
+        cpus = std::min(cpus, std::max<size_t>(1, quota_cpus));
+    }
+    return cpus;
+}
+
+size_t TaskPool::configured_count()
+{
+    const char* configured = g_config_manager.getConfigValue("performance", "worker_threads");
+    if (configured && strlen(configured) > 0) {
+        int value = atoi(configured);
+        if (value > 0) {
+            return static_cast<size_t>(value);
+        }
+
+        // 0 explicitly asks for automatic detection
+        if (strcmp(configured, "0") != 0) {
+            g_logger.log(LoggingLevels::WARN, "Ignoring invalid [performance] worker_threads value: " +
+                                              std::string(configured));
+        }
+    }
+    return available_cpus();
+}
+
+size_t TaskPool::worker_count()
+{
+    if (_started.load(std::memory_order_acquire)) {
+        return _worker_count;
+    }
+    return configured_count();
+}
+
+void TaskPool::start()
+{
+    if (_started.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::call_once(s_fork_handlers, [] {
+        pthread_atfork(&TaskPool::prepare_fork, &TaskPool::parent_after_fork, &TaskPool::child_after_fork);
+    });
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_started.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    _worker_count = configured_count();
+    _queues.clear();
+    for (size_t i = 0; i < _worker_count; i++) {
+        _queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    _workers.clear();
+    for (size_t i = 0; i < _worker_count; i++) {
+        _workers.push_back(std::make_unique<std::thread>(&TaskPool::worker_loop, this, i));
+    }
+    g_logger.log(LoggingLevels::DEBUG, "Started " + std::to_string(_worker_count) + " shared worker threads");
+    _started.store(true, std::memory_order_release);
+}
+
+void TaskPool::submit(dpm_task_group* group, dpm_task_function function, void* context)
+{
+    if (!function) {
+        return;
+    }
+
+    start();
+    if (group) {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->outstanding.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Task task{function, context, group};
+    if (t_pool == this) {
+        // nested work stays on the worker that made it
+        WorkerQueue& own = *_queues[t_worker_index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.tasks.push_back(task);
+    } else {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _shared.push_back(task);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queued.fetch_add(1, std::memory_order_release);
+    }
+    _task_available.notify_one();
+}
+
+bool TaskPool::take(Task& task)
+{
+    if (_queued.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    // own queue first, newest task first
+    if (t_pool == this) {
+        WorkerQueue& own = *_queues[t_worker_index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            _queued.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    // then what other threads submitted
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_shared.empty()) {
+            task = _shared.front();
+            _shared.pop_front();
+            _queued.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    // then steal the oldest task of another worker
+    size_t first = t_pool == this ? t_worker_index + 1 : 0;
+    for (size_t offset = 0; offset < _queues.size(); offset++) {
+        WorkerQueue& victim = *_queues[(first + offset) % _queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            _queued.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TaskPool::run(const Task& task)
+{
+    task.function(task.context);
+
+    if (task.group) {
+        // decremented under the lock, so a waiter that sees zero knows the group is let go of
+        std::lock_guard<std::mutex> lock(task.group->mutex);
+        if (task.group->outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            task.group->finished.notify_all();
+        }
+    }
+}
+
+void TaskPool::worker_loop(size_t worker_index)
+{
+    t_pool = this;
+    t_worker_index = worker_index;
+
+    for (;;) {
+        Task task;
+        if (take(task)) {
+            run(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _task_available.wait(lock, [this] {
+            return _stopping || _queued.load(std::memory_order_acquire) > 0;
+        });
+        if (_stopping && _queued.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void TaskPool::wait(dpm_task_group* group)
+{
+    if (!group) {
+        return;
+    }
+
+    while (group->outstanding.load(std::memory_order_acquire) > 0) {
+        // help with whatever is queued, which includes the group's own tasks
+        Task task;
+        if (take(task)) {
+            run(task);
+            continue;
+        }
+
+        // the group's last tasks are running elsewhere, and may still queue more to help with
+        std::unique_lock<std::mutex> lock(group->mutex);
+        group->finished.wait_for(lock, std::chrono::milliseconds(1), [group] {
+            return group->outstanding.load(std::memory_order_acquire) == 0;
+        });
+    }
+
+    std::lock_guard<std::mutex> lock(group->mutex);
+}
+
+void TaskPool::parallel_for(size_t begin, size_t end, size_t grain, dpm_range_function function, void* context)
+{
+    if (!function || end <= begin) {
+        return;
+    }
+
+    // a few parts per worker, so that stealing evens out parts that take longer
+    size_t count = end - begin;
+    size_t max_parts = worker_count() * 4;
+    if (grain == 0) {
+        grain = std::max<size_t>(1, count / max_parts);
+    }
+    size_t parts = std::min(max_parts, (count + grain - 1) / grain);
+    if (parts <= 1) {
+        function(context, begin, end);
+        return;
+    }
+
+    std::vector<ParallelForPart> ranges;
+    ranges.reserve(parts);
+    size_t part_size = count / parts;
+    size_t remainder = count % parts;
+    size_t next = begin;
+    for (size_t i = 0; i < parts; i++) {
+        size_t size = part_size + (i < remainder ? 1 : 0);
+        ranges.push_back(ParallelForPart{function, context, next, next + size});
+        next += size;
+    }
+
+    // the calling thread takes the first part itself
+    dpm_task_group group;
+    for (size_t i = 1; i < parts; i++) {
+        submit(&group, &parallel_for_part, &ranges[i]);
+    }
+    parallel_for_part(&ranges[0]);
+    wait(&group);
+}
+
+void TaskPool::prepare_fork()
+{
+    g_task_pool._mutex.lock();
+    for (auto& queue : g_task_pool._queues) {
+        queue->mutex.lock();
+    }
+}
+
+void TaskPool::parent_after_fork()
+{
+    for (auto& queue : g_task_pool._queues) {
+        queue->mutex.unlock();
+    }
+    g_task_pool._mutex.unlock();
+}
+
+void TaskPool::child_after_fork()
+{
+    // the workers stayed in the parent, the child starts its own on first use
+    for (auto& worker : g_task_pool._workers) {
+        (void) worker.release();
+    }
+    g_task_pool._workers.clear();
+
+    for (auto& queue : g_task_pool._queues) {
+        queue->tasks.clear();
+        queue->mutex.unlock();
+    }
+    g_task_pool._shared.clear();
+    g_task_pool._queued.store(0, std::memory_order_relaxed);
+    g_task_pool._started.store(false, std::memory_order_relaxed);
+    new (&g_task_pool._task_available) std::condition_variable();
+    g_task_pool._mutex.unlock();
+}
\ No newline at end of file
@@ -39,6 +39,7 @@
 #include "Logger.hpp"
 #include "LoggingLevels.hpp"
 #include "module_interface.hpp"
+#include "dpm_daemon.hpp"
 
 /*
  *   DPM serves three functions:
@@ -47,13 +48,6 @@
  *       3. Provide a module-agnostic unified interface for modules.
  */
 
-// the default behaviour if dpm is executed without being told to do anything
-int default_behavior(const ModuleLoader& loader)
-{
-    return main_show_help();
-}
-
-
 /**
  * @brief Entry point for the DPM utility
  *
@@ -71,120 +65,46 @@ int main( int argc, char* argv[] )
     // processing
     CommandArgs args = parse_args( argc, argv );
 
-    // Set the configuration directory path (CLI argument takes precedence over defaults)
-    if ( !args.config_dir.empty() )
-    {
-        // args.config_dir was supplied so set it
-        g_config_manager.setConfigDir( args.config_dir );
-    } else {
-        // args.config_dir was not supplied, so fall back to default path
-        g_config_manager.setConfigDir( DPMDefaults::CONFIG_DIR );
-    }
-
-    // Load configuration files
-    bool config_loaded = g_config_manager.loadConfigurations();
-    if (!config_loaded)
-    {
-        // failed to load any configuration files, so alert the user
-        dpm_con( ERROR, ("Warning: No configuration files present or loaded from '" + g_config_manager.getConfigDir() + "*.conf', reverting to defaults.").c_str());
+    // a running dpmd serves the invocation with its configuration and modules already loaded,
+    // unless it is profiled, traced or exports metrics, which measure the work of this process
+    bool measured = args.profile || !args.trace_file.empty() || !args.metrics_file.empty();
+    int forwarded_code = 0;
+    if (!args.daemon && !measured && dpmd_forward(argc, argv, forwarded_code)) {
+        return forwarded_code;
     }
 
-    // Configure logger (CLI args > config > defaults)
-    // Check configuration for log settings
-    bool config_write_to_log = g_config_manager.getConfigBool("logging", "write_to_log", DPMDefaults::write_to_log);
-    std::string config_log_file = g_config_manager.getConfigString("logging", "log_file", DPMDefaults::LOG_FILE);
+    // load the configuration and configure the logger
+    main_configure(args);
 
-    // Parse log_level from config using the new method
-    std::string log_level_str = g_config_manager.getConfigString("logging", "log_level", "INFO");
-    LoggingLevels config_log_level = Logger::stringToLogLevel(log_level_str, DPMDefaults::LOG_LEVEL);
-
-    // Configure global logger instance
-    g_logger.setLogLevel(config_log_level);
-    g_logger.setWriteToLog(config_write_to_log);
-    g_logger.setLogFile(config_log_file);
-
-    // If help is requested, show it and exit - handle this early before any logging is needed
-    if (args.show_help) {
-        return main_show_help();
+    // run as the daemon if asked to
+    if (args.daemon) {
+        return dpmd_serve(args);
     }
 
-    // If list modules is requested, handle it early too
-    if (args.list_modules) {
-        // Determine the module path (CLI arg > config > default)
-        std::string module_path;
-
-        // If CLI argument was provided, use it
-        if (!args.module_path.empty())
-        {
-            module_path = args.module_path;
-        } else {
-            // Otherwise, check configuration file
-            const char* config_module_path = g_config_manager.getConfigValue("modules", "module_path");
-            if (config_module_path)
-            {
-                module_path = config_module_path;
-            } else {
-                // use default if nothing else is available
-                module_path = DPMDefaults::MODULE_PATH;
-            }
-        }
-
-        // create a module loader object with the determined path
-        ModuleLoader loader(module_path);
-
-        // check the module path for the loader object
-        int path_check_result = main_check_module_path(loader);
-        if (path_check_result != 0)
-        {
-            // exit if there's an error and ensure
-            // it has an appropriate return code
-            return path_check_result;
-        }
-
-        return main_list_modules(loader);
+    if (!measured) {
+        return main_dispatch(args);
     }
 
-    // Determine the module path (CLI arg > config > default)
-    std::string module_path;
-
-    // If CLI argument was provided, use it
-    if (!args.module_path.empty())
-    {
-        module_path = args.module_path;
-    } else {
-        // Otherwise, check configuration file
-        const char* config_module_path = g_config_manager.getConfigValue("modules", "module_path");
-        if (config_module_path)
-        {
-            module_path = config_module_path;
-        } else {
-            // use default if nothing else is available
-            module_path = DPMDefaults::MODULE_PATH;
-        }
+    if (args.profile) {
+        g_profiler.enable();
     }
-
-    g_config_manager.setModulePath(module_path.c_str());
-
-    // create a module loader object with the determined path
-    ModuleLoader loader(module_path);
-
-    // check the module path for the loader object
-    int path_check_result = main_check_module_path(loader);
-    if (path_check_result != 0)
-    {
-        // exit if there's an error and ensure
-        // it has an appropriate return code
-        return path_check_result;
+    if (!args.trace_file.empty()) {
+        g_profiler.enable_trace();
     }
-
-    // if no module is provided to execute, then trigger the default
-    // behaviour (show help)
-    if (args.module_name.empty()) {
-        return default_behavior(loader);
+    if (!args.metrics_file.empty()) {
+        g_metrics.enable();
     }
 
-    // execute the module
-    int return_code = main_execute_module(loader, args.module_name, args.command);
+    int result = main_dispatch(args);
 
-    return return_code;
+    if (args.profile) {
+        main_write_profile(args);
+    }
+    if (!args.trace_file.empty()) {
+        main_write_trace(args);
+    }
+    if (!args.metrics_file.empty()) {
+        main_write_metrics(args);
+    }
+    return result;
 }
\ No newline at end of file
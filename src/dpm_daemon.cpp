@@ -0,0 +1,472 @@
+/**
+ * @file dpm_daemon.cpp
+ * @brief Implementation of dpmd and of handing invocations to it
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+ */
+
+#include "dpm_daemon.hpp"
+
+// set by the signal handler to stop the accept loop
+static volatile sig_atomic_t g_dpmd_stop = 0;
+
+static void dpmd_handle_stop(int)
+{
+    g_dpmd_stop = 1;
+}
+
+static bool dpmd_write_all(int fd, const void* data, size_t size)
+{
+    const char* cursor = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, cursor, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        cursor += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+static bool dpmd_read_all(int fd, void* data, size_t size)
+{
+    char* cursor = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t got = read(fd, cursor, size);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        cursor += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+// fills a socket address, false if the path does not fit
+static bool dpmd_socket_address(const std::string& path, struct sockaddr_un& address)
+{
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+std::string dpmd_socket_path()
+{
+    const char* configured = getenv("DPMD_SOCKET");
+    if (configured) {
+        return configured;
+    }
+    return DPMDefaults::DAEMON_SOCKET;
+}
+
+bool dpmd_forward(int argc, char* argv[], int& exit_code)
+{
+    struct sockaddr_un address;
+    if (!dpmd_socket_address(dpmd_socket_path(), address)) {
+        return false;
+    }
+
+    // no daemon is the common case, and costs one failed stat
+    struct stat st;
+    if (stat(address.sun_path, &st) != 0 || !S_ISSOCK(st.st_mode)) {
+        return false;
+    }
+
+    int connection = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connection < 0) {
+        return false;
+    }
+    if (connect(connection, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        close(connection);
+        return false;
+    }
+
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        close(connection);
+        return false;
+    }
+
+    std::string payload(cwd);
+    payload.push_back('\0');
+    for (int i = 1; i < argc; i++) {
+        payload.append(argv[i]);
+        payload.push_back('\0');
+    }
+    // the invocation runs with our environment, as it would have in this process
+    for (char** variable = environ; *variable; variable++) {
+        payload.append(*variable);
+        payload.push_back('\0');
+    }
+    if (payload.size() > DPMD_MAX_PAYLOAD) {
+        close(connection);
+        return false;
+    }
+
+    DpmdRequestHeader header;
+    header.version = DPMD_PROTOCOL_VERSION;
+    header.payload_size = static_cast<uint32_t>(payload.size());
+    header.argument_count = static_cast<uint32_t>(argc > 1 ? argc - 1 : 0);
+    mode_t mask = umask(0);
+    umask(mask);
+    header.umask = static_cast<uint32_t>(mask);
+
+    // the header carries our standard streams, which the invocation uses as its own
+    int streams[3] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+    char control[CMSG_SPACE(sizeof(streams))];
+    memset(control, 0, sizeof(control));
+
+    struct iovec iov;
+    iov.iov_base = &header;
+    iov.iov_len = sizeof(header);
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(streams));
+    memcpy(CMSG_DATA(cmsg), streams, sizeof(streams));
+
+    // until the payload is sent the daemon runs nothing, so we can still run the invocation ourselves
+    if (sendmsg(connection, &message, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(header)) ||
+        !dpmd_write_all(connection, payload.data(), payload.size())) {
+        close(connection);
+        return false;
+    }
+
+    int32_t code = 0;
+    if (!dpmd_read_all(connection, &code, sizeof(code))) {
+        std::cerr << "Error: dpmd closed the connection before the invocation finished" << std::endl;
+        code = 1;
+    }
+    close(connection);
+
+    exit_code = code;
+    return true;
+}
+
+// receives a request and its standard streams, false if it is not a valid request
+static bool dpmd_receive_request(int connection, DpmdRequest& request)
+{
+    int* streams = request.streams;
+    DpmdRequestHeader header;
+    char control[CMSG_SPACE(sizeof(int) * 3)];
+
+    struct iovec iov;
+    iov.iov_base = &header;
+    iov.iov_len = sizeof(header);
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t got = recvmsg(connection, &message, MSG_CMSG_CLOEXEC);
+    bool have_streams = false;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+            cmsg->cmsg_len == CMSG_LEN(sizeof(int) * 3)) {
+            memcpy(streams, CMSG_DATA(cmsg), sizeof(int) * 3);
+            have_streams = true;
+        }
+    }
+
+    if (!have_streams) {
+        return false;
+    }
+
+    if (got != static_cast<ssize_t>(sizeof(header)) || header.version != DPMD_PROTOCOL_VERSION ||
+        header.payload_size == 0 || header.payload_size > DPMD_MAX_PAYLOAD) {
+        for (int i = 0; i < 3; i++) {
+            close(streams[i]);
+        }
+        return false;
+    }
+
+    std::string payload(header.payload_size, '\0');
+    if (!dpmd_read_all(connection, payload.data(), payload.size()) || payload.back() != '\0') {
+        for (int i = 0; i < 3; i++) {
+            close(streams[i]);
+        }
+        return false;
+    }
+
+    // the working directory, then each argument, then the environment
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (start < payload.size()) {
+        size_t end = payload.find('\0', start);
+        fields.push_back(payload.substr(start, end - start));
+        start = end + 1;
+    }
+    if (fields.size() < 1 + static_cast<size_t>(header.argument_count)) {
+        for (int i = 0; i < 3; i++) {
+            close(streams[i]);
+        }
+        return false;
+    }
+
+    request.working_directory = fields[0];
+    request.arguments.assign(fields.begin() + 1, fields.begin() + 1 + header.argument_count);
+    request.environment.assign(fields.begin() + 1 + header.argument_count, fields.end());
+    request.umask = static_cast<mode_t>(header.umask & 0777);
+    return true;
+}
+
+// replaces our environment and umask with the client's
+static void dpmd_apply_client_environment(const DpmdRequest& request)
+{
+    clearenv();
+    for (const auto& variable : request.environment) {
+        size_t separator = variable.find('=');
+        if (separator == std::string::npos || separator == 0) {
+            continue;
+        }
+        setenv(variable.substr(0, separator).c_str(), variable.c_str() + separator + 1, 1);
+    }
+    umask(request.umask);
+}
+
+// receives and runs one invocation in the forked process, and never returns
+[[noreturn]] static void dpmd_run_request(int connection)
+{
+    // modules wait on their own children, and write to pipes that may close
+    signal(SIGCHLD, SIG_DFL);
+    signal(SIGPIPE, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+
+    // a client that stalls before its request is complete is dropped rather than waited on forever
+    struct timeval timeout;
+    timeout.tv_sec = DPMD_REQUEST_TIMEOUT;
+    timeout.tv_usec = 0;
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    DpmdRequest request;
+    if (!dpmd_receive_request(connection, request)) {
+        _exit(1);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        dup2(request.streams[i], i);
+        close(request.streams[i]);
+    }
+
+    dpmd_apply_client_environment(request);
+
+    int32_t code = 1;
+    if (chdir(request.working_directory.c_str()) != 0) {
+        std::cerr << "Error: dpmd could not enter the working directory " << request.working_directory << ": "
+                  << strerror(errno) << std::endl;
+    } else {
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>("dpm"));
+        for (const auto& argument : request.arguments) {
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        CommandArgs args = parse_args(static_cast<int>(argv.size() - 1), argv.data());
+        if (args.daemon) {
+            std::cerr << "Error: dpmd is already running on " << dpmd_socket_path() << std::endl;
+        } else {
+            // the daemon's configuration is reused unless the invocation names another one
+            std::string config_dir = args.config_dir.empty() ? DPMDefaults::CONFIG_DIR : args.config_dir;
+            if (!config_dir.empty() && config_dir.back() != '/') {
+                config_dir += '/';
+            }
+            if (config_dir != g_config_manager.getConfigDir()) {
+                main_configure(args);
+            }
+
+            code = main_dispatch(args);
+        }
+    }
+
+    // _exit skips the logger's destructor, which would wait for the log file
+    g_logger.flush();
+    fflush(nullptr);
+
+    dpmd_write_all(connection, &code, sizeof(code));
+    _exit(code);
+}
+
+// loads every module of the module path and lets each prepare what it keeps between invocations
+static void dpmd_preload_modules(const CommandArgs& args)
+{
+    std::string module_path = main_resolve_module_path(args);
+    g_config_manager.setModulePath(module_path.c_str());
+
+    ModuleLoader loader(module_path);
+    std::vector<std::string> modules;
+    if (loader.list_available_modules(modules) != DPMErrorCategory::SUCCESS) {
+        dpm_log(LoggingLevels::WARN, ("dpmd could not list the modules in " + module_path).c_str());
+        return;
+    }
+
+    size_t loaded = 0;
+    for (const auto& module_name : modules) {
+        void* module_handle;
+        if (loader.load_module(module_name, module_handle) != DPMErrorCategory::SUCCESS) {
+            dpm_log(LoggingLevels::WARN, ("dpmd could not load module " + module_name).c_str());
+            continue;
+        }
+        loaded++;
+
+        typedef int (*PreloadFn)();
+        dlerror();
+        PreloadFn preload_fn = (PreloadFn) dlsym(module_handle, module_interface::preload_symbol);
+        if (dlerror() == nullptr && preload_fn != nullptr && preload_fn() != 0) {
+            dpm_log(LoggingLevels::WARN, ("Module " + module_name + " failed to preload").c_str());
+        }
+    }
+
+    dpm_log(LoggingLevels::INFO, ("dpmd loaded " + std::to_string(loaded) + " module(s) from " + module_path).c_str());
+}
+
+int dpmd_serve(const CommandArgs& args)
+{
+    std::string socket_path = dpmd_socket_path();
+    struct sockaddr_un address;
+    if (!dpmd_socket_address(socket_path, address)) {
+        dpm_con(LoggingLevels::FATAL, ("Invalid dpmd socket path: '" + socket_path + "'").c_str());
+        return 1;
+    }
+
+    // a socket left behind by a daemon that is gone is replaced, a live one is not
+    struct stat st;
+    if (lstat(address.sun_path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            dpm_con(LoggingLevels::FATAL, ("Refusing to replace non-socket file: " + socket_path).c_str());
+            return 1;
+        }
+
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 &&
+                    connect(probe, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            close(probe);
+        }
+        if (live) {
+            dpm_con(LoggingLevels::FATAL, ("dpmd is already running on " + socket_path).c_str());
+            return 1;
+        }
+        unlink(address.sun_path);
+    }
+
+    std::error_code ec;
+    std::filesystem::path socket_directory = std::filesystem::path(socket_path).parent_path();
+    if (!socket_directory.empty()) {
+        std::filesystem::create_directories(socket_directory, ec);
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        dpm_con(LoggingLevels::FATAL, ("Failed to create dpmd socket: " + std::string(strerror(errno))).c_str());
+        return 1;
+    }
+
+    // only our own user may connect
+    mode_t previous_umask = umask(0077);
+    int bound = bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+    umask(previous_umask);
+    if (bound != 0 || listen(listener, SOMAXCONN) != 0) {
+        dpm_con(LoggingLevels::FATAL, ("Failed to listen on " + socket_path + ": " + strerror(errno)).c_str());
+        close(listener);
+        return 1;
+    }
+
+    dpmd_preload_modules(args);
+
+    // finished invocations are reaped by the kernel, and stop signals interrupt accept
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction stop_action;
+    memset(&stop_action, 0, sizeof(stop_action));
+    stop_action.sa_handler = dpmd_handle_stop;
+    sigemptyset(&stop_action.sa_mask);
+    sigaction(SIGTERM, &stop_action, nullptr);
+    sigaction(SIGINT, &stop_action, nullptr);
+
+    dpm_log(LoggingLevels::INFO, ("dpmd serving on " + socket_path).c_str());
+
+    while (!g_dpmd_stop) {
+        int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0) {
+            if (errno != EINTR) {
+                dpm_log(LoggingLevels::ERROR, ("dpmd failed to accept a connection: " + std::string(strerror(errno))).c_str());
+            }
+            continue;
+        }
+
+        // invocations run with our credentials, so serve only our own user
+        struct ucred peer;
+        socklen_t peer_size = sizeof(peer);
+        if (getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &peer, &peer_size) != 0 || peer.uid != geteuid()) {
+            dpm_log(LoggingLevels::WARN, "dpmd refused a connection from another user");
+            close(connection);
+            continue;
+        }
+
+        // nothing buffered before the fork may be written twice
+        std::cout.flush();
+        std::cerr.flush();
+        fflush(nullptr);
+
+        // the request is read after the fork, so a client that stalls only holds up its own process
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(listener);
+            dpmd_run_request(connection);
+        }
+
+        if (pid < 0) {
+            dpm_log(LoggingLevels::ERROR, ("dpmd could not start an invocation: " + std::string(strerror(errno))).c_str());
+            int32_t code = 1;
+            dpmd_write_all(connection, &code, sizeof(code));
+        }
+
+        close(connection);
+    }
+
+    close(listener);
+    unlink(address.sun_path);
+    dpm_log(LoggingLevels::INFO, "dpmd stopped");
+    return 0;
+}
@@ -96,59 +96,84 @@ int main_list_modules(const ModuleLoader& loader) {
         return 0;
     }
 
-    // First pass: Identify valid modules
+    // modules whose files are unchanged since the last listing are described by the index,
+    // the others are loaded once and recorded in it again
+    std::string index_path = g_config_manager.getConfigString("modules", "index_path", DPMDefaults::MODULE_INDEX_PATH);
+    ModuleIndex index(index_path);
+    if (!index_path.empty()) {
+        index.load(path);
+    }
+
     std::vector<std::string> valid_modules;
+    std::vector<std::string> versions;
+    std::vector<std::string> descriptions;
+    size_t max_name_length = 0;
+    size_t max_version_length = 0;
+
     for (int i = 0; i < modules.size(); i++) {
-        void* handle;
-        DPMErrorCategory load_error = loader.load_module(modules[i], handle);
-        if (load_error != DPMErrorCategory::SUCCESS) {
+        const ModuleRegistryEntry* registered = g_module_registry.find(modules[i]);
+        if (!registered) {
             continue;
         }
 
-        std::vector<std::string> missing_symbols;
-        DPMErrorCategory validate_error = loader.validate_module_interface(handle, missing_symbols);
-        if (validate_error == DPMErrorCategory::SUCCESS) {
-            valid_modules.push_back(modules[i]);
-        }
-        dlclose(handle);
-    }
+        ModuleIndexEntry entry;
+        const ModuleIndexEntry* indexed = index.find(modules[i], registered->path, registered->mtime, registered->size);
+        if (indexed) {
+            entry = *indexed;
+        } else {
+            entry.name = modules[i];
+            entry.path = registered->path;
+            entry.mtime = registered->mtime;
+            entry.size = registered->size;
+            entry.version = "unknown";
+            entry.description = "unknown";
 
-    if (valid_modules.empty()) {
-        dpm_con(LoggingLevels::FATAL, "No valid DPM commands available.");
-        return 0;
-    }
+            // load_module validates the module's interface, and the registry keeps the handle
+            void* module_handle;
+            DPMErrorCategory load_error = loader.load_module(modules[i], module_handle);
+            if (load_error == DPMErrorCategory::SUCCESS) {
+                entry.valid = true;
+                entry.symbols = module_interface::required_symbols;
 
-    // Second pass: Collect module information and calculate column widths
-    size_t max_name_length = 0;
-    size_t max_version_length = 0;
-    std::vector<std::string> versions(valid_modules.size(), "unknown");
-    std::vector<std::string> descriptions(valid_modules.size(), "unknown");
+                // Get version
+                std::string version;
+                if (loader.get_module_version(module_handle, version) == DPMErrorCategory::SUCCESS) {
+                    entry.version = version;
+                }
 
-    for (int i = 0; i < valid_modules.size(); i++) {
-        void* module_handle;
-        max_name_length = std::max(max_name_length, valid_modules[i].length());
-
-        DPMErrorCategory load_error = loader.load_module(valid_modules[i], module_handle);
-        if (load_error == DPMErrorCategory::SUCCESS) {
-            // Get version
-            std::string version = "unknown";
-            DPMErrorCategory version_error = loader.get_module_version(module_handle, version);
-            if (version_error == DPMErrorCategory::SUCCESS) {
-                versions[i] = version;
-                max_version_length = std::max(max_version_length, version.length());
+                // Get description
+                std::string description;
+                if (loader.get_module_description(module_handle, description) == DPMErrorCategory::SUCCESS) {
+                    entry.description = description;
+                }
             }
+            index.update(entry);
+        }
 
-            // Get description
-            std::string description = "unknown";
-            DPMErrorCategory desc_error = loader.get_module_description(module_handle, description);
-            if (desc_error == DPMErrorCategory::SUCCESS) {
-                descriptions[i] = description;
-            }
+        if (!entry.valid) {
+            continue;
+        }
+
+        valid_modules.push_back(modules[i]);
+        versions.push_back(entry.version);
+        descriptions.push_back(entry.description);
+        max_name_length = std::max(max_name_length, modules[i].length());
+        max_version_length = std::max(max_version_length, entry.version.length());
+    }
 
-            dlclose(module_handle);
+    // the index is only a cache, so failing to write it leaves listing as it was
+    if (!index_path.empty()) {
+        index.retain(modules);
+        if (!index.save()) {
+            dpm_log(LoggingLevels::DEBUG, ("Could not write the module index: " + index_path).c_str());
         }
     }
 
+    if (valid_modules.empty()) {
+        dpm_con(LoggingLevels::FATAL, "No valid DPM commands available.");
+        return 0;
+    }
+
     const int column_spacing = 4;
 
     // Print header with proper spacing
@@ -188,13 +213,32 @@ int main_show_help() {
               << "  -m, --module-path PATH   Path to DPM modules (overrides modules.modules_path in config)\n"
               << "  -c, --config-dir PATH    Path to DPM configuration directory\n"
               << "  -l, --list-modules       List available modules\n"
+              << "  -b, --batch FILE         Run the module invocations in FILE, one per line, in one process\n"
+              << "                           (\"-\" reads them from stdin)\n"
+              << "  -d, --daemon             Run as dpmd, serving dpm invocations over a Unix socket\n"
+              << "      --profile            Report the time, bytes and files of each phase on stderr at exit\n"
+              << "      --profile-file FILE  Write the --profile report to FILE instead\n"
+              << "      --metrics-file FILE  Export counters of the work done to FILE at exit, as JSON when\n"
+              << "                           FILE ends in .json and as Prometheus text otherwise\n"
+              << "      --trace-file FILE    Write each profiled phase of each thread to FILE as Chrome\n"
+              << "                           trace-event JSON, for Perfetto or chrome://tracing\n"
               << "  -h, --help               Show this help message\n\n"
-              << "For module-specific help, use: dpm <module-name> help\n\n";
+              << "For module-specific help, use: dpm <module-name> help\n\n"
+              << "When dpmd is running, dpm hands each invocation to it. The socket is\n"
+              << "DPMD_SOCKET, or " << DPMDefaults::DAEMON_SOCKET << " when unset; an empty DPMD_SOCKET\n"
+              << "runs every invocation in-process. Profiled and traced invocations,\n"
+              << "and those exporting metrics, always run in-process.\n\n";
     return 0;
 }
 
-int main_execute_module( const ModuleLoader& loader, std::string module_name, std::string command ) {
-    DPMErrorCategory execute_error = loader.execute_module(module_name, command);
+int main_execute_module( const ModuleLoader& loader, std::string module_name, const std::vector<std::string>& args ) {
+    // each module run is the outermost phase of whatever it profiles
+    int profile_scope = g_profiler.begin(module_name.c_str());
+    auto started = std::chrono::steady_clock::now();
+    DPMErrorCategory execute_error = loader.execute_module(module_name, args);
+    g_metrics.observe("dpm_module_run_seconds",
+                      std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+    g_profiler.end(profile_scope, 0, 0);
     if (execute_error != DPMErrorCategory::SUCCESS) {
         // get the absolute module path
         std::string absolute_module_path = "";
@@ -210,4 +254,184 @@ int main_execute_module( const ModuleLoader& loader, std::string module_name, st
     } else {
         return 0;
     }
-}
\ No newline at end of file
+}
+
+int main_execute_batch(const ModuleLoader& loader, const std::string& batch_file)
+{
+    std::ifstream file;
+    if (batch_file != "-") {
+        file.open(batch_file);
+        if (!file.is_open()) {
+            dpm_con(LoggingLevels::FATAL, ("Cannot open batch file: " + batch_file).c_str());
+            return 1;
+        }
+    }
+    std::istream& input = batch_file == "-" ? std::cin : file;
+    std::string source = batch_file == "-" ? "stdin" : batch_file;
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(input, line)) {
+        line_number++;
+
+        std::vector<std::string> words;
+        std::string split_error;
+        if (!split_batch_line(line, words, split_error)) {
+            dpm_con(LoggingLevels::FATAL, ("Line " + std::to_string(line_number) + " of " + source + ": " + split_error).c_str());
+            return 1;
+        }
+        if (words.empty()) {
+            continue;
+        }
+
+        // the first word names the module, the rest reach it as they are
+        std::string module_name = words[0];
+        words.erase(words.begin());
+
+        int result = main_execute_module(loader, module_name, words);
+
+        // modules are written for one invocation per process, so their output is flushed between them
+        std::cout.flush();
+        if (result != 0) {
+            dpm_con(LoggingLevels::ERROR, ("Batch stopped at line " + std::to_string(line_number) + " of " + source).c_str());
+            return result;
+        }
+    }
+
+    return 0;
+}
+
+void main_configure(const CommandArgs& args)
+{
+    // Set the configuration directory path (CLI argument takes precedence over defaults)
+    if ( !args.config_dir.empty() )
+    {
+        // args.config_dir was supplied so set it
+        g_config_manager.setConfigDir( args.config_dir );
+    } else {
+        // args.config_dir was not supplied, so fall back to default path
+        g_config_manager.setConfigDir( DPMDefaults::CONFIG_DIR );
+    }
+
+    // Load configuration files
+    bool config_loaded = g_config_manager.loadConfigurations();
+    if (!config_loaded)
+    {
+        // failed to load any configuration files, so alert the user
+        dpm_con( ERROR, ("Warning: No configuration files present or loaded from '" + g_config_manager.getConfigDir() + "*.conf', reverting to defaults.").c_str());
+    }
+
+    // Configure logger (CLI args > config > defaults)
+    // Check configuration for log settings
+    bool config_write_to_log = g_config_manager.getConfigBool("logging", "write_to_log", DPMDefaults::write_to_log);
+    std::string config_log_file = g_config_manager.getConfigString("logging", "log_file", DPMDefaults::LOG_FILE);
+
+    // Parse log_level from config using the new method
+    std::string log_level_str = g_config_manager.getConfigString("logging", "log_level", "INFO");
+    LoggingLevels config_log_level = Logger::stringToLogLevel(log_level_str, DPMDefaults::LOG_LEVEL);
+
+    // Configure global logger instance
+    g_logger.setLogLevel(config_log_level);
+    g_logger.setWriteToLog(config_write_to_log);
+    g_logger.setLogFile(config_log_file);
+}
+
+std::string main_resolve_module_path(const CommandArgs& args)
+{
+    // If CLI argument was provided, use it
+    if (!args.module_path.empty())
+    {
+        return args.module_path;
+    }
+
+    // Otherwise, check configuration file
+    const char* config_module_path = g_config_manager.getConfigValue("modules", "module_path");
+    if (config_module_path)
+    {
+        return config_module_path;
+    }
+
+    // use default if nothing else is available
+    return DPMDefaults::MODULE_PATH;
+}
+
+int main_dispatch(const CommandArgs& args)
+{
+    // If help is requested, show it and exit - handle this early before any logging is needed
+    if (args.show_help) {
+        return main_show_help();
+    }
+
+    // Determine the module path (CLI arg > config > default)
+    std::string module_path = main_resolve_module_path(args);
+
+    // an executed module reads the module path back through dpm_get_module_path
+    if (!args.list_modules) {
+        g_config_manager.setModulePath(module_path.c_str());
+    }
+
+    // create a module loader object with the determined path
+    ModuleLoader loader(module_path);
+
+    // check the module path for the loader object
+    int path_check_result = main_check_module_path(loader);
+    if (path_check_result != 0)
+    {
+        // exit if there's an error and ensure
+        // it has an appropriate return code
+        return path_check_result;
+    }
+
+    if (args.list_modules) {
+        return main_list_modules(loader);
+    }
+
+    // run a batch of invocations if one is given
+    if (!args.batch_file.empty()) {
+        return main_execute_batch(loader, args.batch_file);
+    }
+
+    // if no module is provided to execute, then the default behaviour is to show help
+    if (args.module_name.empty()) {
+        return main_show_help();
+    }
+
+    // execute the module
+    return main_execute_module(loader, args.module_name, args.module_args);
+}
+
+int main_write_profile(const CommandArgs& args)
+{
+    if (args.profile_file.empty()) {
+        g_profiler.report(std::cerr);
+        return 0;
+    }
+
+    std::ofstream file(args.profile_file, std::ios::trunc);
+    if (!file.is_open()) {
+        dpm_con(LoggingLevels::ERROR, ("Cannot write profile report: " + args.profile_file).c_str());
+        return 1;
+    }
+    g_profiler.report(file);
+    return 0;
+}
+
+int main_write_metrics(const CommandArgs& args)
+{
+    if (!g_metrics.write_file(args.metrics_file)) {
+        dpm_con(LoggingLevels::ERROR, ("Cannot write metrics file: " + args.metrics_file).c_str());
+        return 1;
+    }
+    return 0;
+}
+
+int main_write_trace(const CommandArgs& args)
+{
+    std::ofstream file(args.trace_file, std::ios::trunc);
+    if (!file.is_open()) {
+        dpm_con(LoggingLevels::ERROR, ("Cannot write trace file: " + args.trace_file).c_str());
+        return 1;
+    }
+    g_profiler.write_trace(file);
+    return 0;
+}
@@ -37,12 +37,20 @@ CommandArgs parse_args(int argc, char* argv[])
     args.config_dir = "";
     args.list_modules = false;
     args.show_help = false;
+    args.daemon = false;
+    args.profile = false;
 
     static struct option long_options[] = {
         {"module-path", required_argument, 0, 'm'},
         {"config-dir", required_argument, 0, 'c'},
         {"list-modules", no_argument, 0, 'l'},
+        {"batch", required_argument, 0, 'b'},
         {"help", no_argument, 0, 'h'},
+        {"daemon", no_argument, 0, 'd'},
+        {"profile", no_argument, 0, 0},
+        {"profile-file", required_argument, 0, 0},
+        {"metrics-file", required_argument, 0, 0},
+        {"trace-file", required_argument, 0, 0},
         {0, 0, 0, 0}
     };
 
@@ -67,9 +75,34 @@ CommandArgs parse_args(int argc, char* argv[])
         else if (strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "--list-modules") == 0) {
             args.list_modules = true;
         }
+        else if ((strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--batch") == 0) &&
+                 i + 1 < argc) {
+            args.batch_file = argv[i + 1];
+            i++;  // Skip the argument value
+        }
         else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             args.show_help = true;
         }
+        else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--daemon") == 0) {
+            args.daemon = true;
+        }
+        else if (strcmp(argv[i], "--profile") == 0) {
+            args.profile = true;
+        }
+        else if (strcmp(argv[i], "--profile-file") == 0 && i + 1 < argc) {
+            // naming a report file asks for the report
+            args.profile = true;
+            args.profile_file = argv[i + 1];
+            i++;  // Skip the argument value
+        }
+        else if (strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) {
+            args.metrics_file = argv[i + 1];
+            i++;  // Skip the argument value
+        }
+        else if (strcmp(argv[i], "--trace-file") == 0 && i + 1 < argc) {
+            args.trace_file = argv[i + 1];
+            i++;  // Skip the argument value
+        }
     }
 
     // If we found a module name
@@ -85,6 +118,8 @@ CommandArgs parse_args(int argc, char* argv[])
             }
 
             std::string arg = argv[i];
+            args.module_args.push_back(arg);
+
             // Quote arguments with spaces
             if (arg.find(' ') != std::string::npos) {
                 args.command += "\"" + arg + "\"";
@@ -96,4 +131,75 @@ CommandArgs parse_args(int argc, char* argv[])
     }
 
     return args;
+}
+
+bool split_batch_line(const std::string& line, std::vector<std::string>& words, std::string& error)
+{
+    words.clear();
+
+    std::string word;
+    bool in_word = false;
+    size_t i = 0;
+    while (i < line.size()) {
+        char c = line[i];
+
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            if (in_word) {
+                words.push_back(word);
+                word.clear();
+                in_word = false;
+            }
+            i++;
+        }
+        else if (c == '#' && !in_word) {
+            // the rest of the line is a comment
+            break;
+        }
+        else if (c == '\'') {
+            size_t end = line.find('\'', i + 1);
+            if (end == std::string::npos) {
+                error = "unterminated single quote";
+                return false;
+            }
+            word += line.substr(i + 1, end - i - 1);
+            in_word = true;
+            i = end + 1;
+        }
+        else if (c == '"') {
+            i++;
+            bool closed = false;
+            while (i < line.size()) {
+                if (line[i] == '"') {
+                    closed = true;
+                    i++;
+                    break;
+                }
+                if (line[i] == '\\' && i + 1 < line.size() && (line[i + 1] == '"' || line[i + 1] == '\\')) {
+                    i++;
+                }
+                word += line[i];
+                i++;
+            }
+            if (!closed) {
+                error = "unterminated double quote";
+                return false;
+            }
+            in_word = true;
+        }
+        else if (c == '\\' && i + 1 < line.size()) {
+            word += line[i + 1];
+            in_word = true;
+            i += 2;
+        }
+        else {
+            word += c;
+            in_word = true;
+            i++;
+        }
+    }
+
+    if (in_word) {
+        words.push_back(word);
+    }
+    return true;
 }
\ No newline at end of file
@@ -28,11 +28,16 @@
 */
 
 #include "module_interface.hpp"
+#include "ModuleLoader.hpp"
 
 extern "C" const char* dpm_get_config(const char* section, const char* key) {
     return g_config_manager.getConfigValue(section, key);
 }
 
+extern "C" const char* const* dpm_config_resolve(const char* section, const char* key) {
+    return g_config_manager.resolveConfigValue(section, key);
+}
+
 extern "C" void dpm_log(int level, const char* message) {
     if (!message) {
         return;
@@ -95,6 +100,14 @@ extern "C" void dpm_con(int level, const char* message) {
     g_logger.log_console(log_level, message);
 }
 
+extern "C" int dpm_log_enabled(int level) {
+    // levels past DEBUG are logged as INFO by dpm_log and dpm_con
+    if (level < 0 || level > 4) {
+        level = 3;
+    }
+    return g_logger.isEnabled(static_cast<LoggingLevels>(level)) ? 1 : 0;
+}
+
 extern "C" void dpm_set_logging_level(int level) {
     // Convert integer level to LoggingLevels enum
     LoggingLevels log_level;
@@ -126,4 +139,68 @@ extern "C" const char* dpm_get_module_path(void) {
     static const char * module_path;
     module_path = g_config_manager.getModulePath();
     return module_path;
+}
+
+extern "C" int dpm_acquire_module(const char* module_name, void** module_handle) {
+    if (!module_name || !module_handle) {
+        return 1;
+    }
+
+    ModuleLoader loader(g_config_manager.getModulePath());
+    void* handle = nullptr;
+    if (loader.acquire_module(module_name, handle) != DPMErrorCategory::SUCCESS) {
+        return 1;
+    }
+
+    *module_handle = handle;
+    return 0;
+}
+
+extern "C" dpm_task_group* dpm_task_group_create(void) {
+    return new dpm_task_group();
+}
+
+extern "C" void dpm_task_group_destroy(dpm_task_group* group) {
+    if (!group) {
+        return;
+    }
+
+    g_task_pool.wait(group);
+    delete group;
+}
+
+extern "C" void dpm_submit_task(dpm_task_group* group, dpm_task_function function, void* context) {
+    g_task_pool.submit(group, function, context);
+}
+
+extern "C" void dpm_wait_group(dpm_task_group* group) {
+    g_task_pool.wait(group);
+}
+
+extern "C" void dpm_parallel_for(size_t begin, size_t end, size_t grain, dpm_range_function function, void* context) {
+    g_task_pool.parallel_for(begin, end, grain, function, context);
+}
+
+extern "C" size_t dpm_worker_threads(void) {
+    return g_task_pool.worker_count();
+}
+
+extern "C" int dpm_profile_enabled(void) {
+    return g_profiler.enabled() ? 1 : 0;
+}
+
+extern "C" int dpm_profile_begin(const char* name) {
+    return g_profiler.begin(name);
+}
+
+extern "C" void dpm_profile_end(int scope, uint64_t bytes, uint64_t files) {
+    g_profiler.end(scope, bytes, files);
+}
+
+extern "C" void dpm_metric_add(const char* name, uint64_t value) {
+    g_metrics.add(name, value);
+}
+
+extern "C" void dpm_metric_observe(const char* name, double value) {
+    g_metrics.observe(name, value);
 }
\ No newline at end of file
@@ -0,0 +1,284 @@
+/**
+ * @file dpm_bench.cpp
+ * @brief dpm-bench, the benchmark suite for the dpm package pipeline
+ *
+ * Generates synthetic package trees of several shapes, runs each through
+ * stage, metadata generation and refresh, stage verification, seal,
+ * package verification and unseal with the dpm binary from the same build,
+ * and writes the throughput, peak RSS and syscall counts of every phase as
+ * JSON, so results can be kept and compared between releases and between
+ * configurations.  Given a baseline from an earlier run it also fails when
+ * a phase has lost more throughput than the tolerance allows, so a CI job
+ * can keep releases from getting slower unnoticed.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * For bug reports or contributions, please contact the dhlp-contributors
+ * mailing list at: https://lists.darkhorselinux.org/mailman/listinfo/dhlp-contributors
+ */
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <getopt.h>
+#include <cstdlib>
+#include <climits>
+
+#include "include/bench_shapes.hpp"
+#include "include/bench_runner.hpp"
+#include "include/bench_baseline.hpp"
+
+#ifndef DPM_BENCH_CONFIG_DIR
+#define DPM_BENCH_CONFIG_DIR "/etc/dpm/conf.d"
+#endif
+
+static void print_usage()
+{
+    std::cout << "Usage: dpm-bench [options]\n\n"
+              << "Times the dpm package pipeline over synthetic package trees and writes the results as JSON.\n\n"
+              << "Options:\n"
+              << "  -s, --shapes LIST      Comma separated shapes to run (default: " << BENCH_DEFAULT_SHAPES << ")\n"
+              << "  -x, --scale N          Multiply the file count of every shape by N (default: 1)\n"
+              << "  -r, --repeat N         Run the pipeline N times per shape and keep the fastest\n"
+              << "                         run of each phase (default: 1)\n"
+              << "  -o, --output FILE      Write the JSON results to FILE instead of stdout\n"
+              << "  -w, --work DIR         Directory to generate trees and packages in\n"
+              << "                         (default: a new directory under $TMPDIR or /tmp)\n"
+              << "  -k, --keep             Keep the work directory afterwards\n"
+              << "  -d, --dpm PATH         dpm binary to benchmark (default: dpm beside dpm-bench)\n"
+              << "  -m, --modules DIR      Module directory (default: modules beside the dpm binary)\n"
+              << "  -c, --config DIR       Configuration directory (default: " << DPM_BENCH_CONFIG_DIR << ")\n"
+              << "  -b, --baseline FILE    Compare the results with those of an earlier run, written with\n"
+              << "                         --output at the same scale, and exit with status 2 if a phase\n"
+              << "                         lost more throughput than the tolerance allows\n"
+              << "  -t, --tolerance PCT    Throughput a phase may lose against the baseline, in percent\n"
+              << "                         (default: " << BENCH_BASELINE_DEFAULT_TOLERANCE << ")\n"
+              << "  -h, --help             Display this help message\n\n"
+              << "Shapes:\n";
+    for (const auto& shape : bench_shapes()) {
+        std::cout << "  " << shape.name << std::string(shape.name.size() < 10 ? 10 - shape.name.size() : 1, ' ')
+                  << shape.description << "\n";
+    }
+    std::cout << "\nPhases: stage, metadata, metadata-refresh, metadata-refresh-full, verify-stage,\n"
+              << "seal, verify-package, unseal.  Progress, failures and the baseline comparison\n"
+              << "are reported on stderr.\n";
+}
+
+static bool parse_count(const char* text, unsigned int& value)
+{
+    char* end = nullptr;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed < 1 || parsed > INT_MAX) {
+        return false;
+    }
+    value = static_cast<unsigned int>(parsed);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    options.scale = 1;
+    options.repeat = 1;
+    options.config_dir = DPM_BENCH_CONFIG_DIR;
+
+    std::string shape_list = BENCH_DEFAULT_SHAPES;
+    std::string output_path;
+    std::string baseline_path;
+    double tolerance = BENCH_BASELINE_DEFAULT_TOLERANCE;
+    bool keep = false;
+
+    static struct option long_options[] = {
+        {"shapes", required_argument, 0, 's'},
+        {"scale", required_argument, 0, 'x'},
+        {"repeat", required_argument, 0, 'r'},
+        {"output", required_argument, 0, 'o'},
+        {"work", required_argument, 0, 'w'},
+        {"keep", no_argument, 0, 'k'},
+        {"dpm", required_argument, 0, 'd'},
+        {"modules", required_argument, 0, 'm'},
+        {"config", required_argument, 0, 'c'},
+        {"baseline", required_argument, 0, 'b'},
+        {"tolerance", required_argument, 0, 't'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:x:r:o:w:kd:m:c:b:t:h", long_options, nullptr)) != -1) {
+        switch (opt) {
+            case 's':
+                shape_list = optarg;
+                break;
+            case 'x':
+                if (!parse_count(optarg, options.scale)) {
+                    std::cerr << "dpm-bench: invalid scale: " << optarg << std::endl;
+                    return 1;
+                }
+                break;
+            case 'r':
+                if (!parse_count(optarg, options.repeat)) {
+                    std::cerr << "dpm-bench: invalid repeat count: " << optarg << std::endl;
+                    return 1;
+                }
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            case 'w':
+                options.work_dir = optarg;
+                break;
+            case 'k':
+                keep = true;
+                break;
+            case 'd':
+                options.dpm_path = optarg;
+                break;
+            case 'm':
+                options.module_path = optarg;
+                break;
+            case 'c':
+                options.config_dir = optarg;
+                break;
+            case 'b':
+                baseline_path = optarg;
+                break;
+            case 't': {
+                char* end = nullptr;
+                tolerance = strtod(optarg, &end);
+                if (end == optarg || *end != '\0' || tolerance < 0.0 || tolerance >= 100.0) {
+                    std::cerr << "dpm-bench: invalid tolerance: " << optarg << std::endl;
+                    return 1;
+                }
+                break;
+            }
+            case 'h':
+                print_usage();
+                return 0;
+            default:
+                print_usage();
+                return 1;
+        }
+    }
+
+    std::istringstream shapes(shape_list);
+    std::string shape_name;
+    while (std::getline(shapes, shape_name, ',')) {
+        if (shape_name.empty()) {
+            continue;
+        }
+        if (!bench_find_shape(shape_name)) {
+            std::cerr << "dpm-bench: unknown shape: " << shape_name << std::endl;
+            return 1;
+        }
+        options.shapes.push_back(shape_name);
+    }
+
+    // a missing or unreadable baseline is reported before spending time on the runs
+    BenchBaseline baseline;
+    if (!baseline_path.empty()) {
+        std::string error;
+        if (!bench_load_baseline(baseline_path, baseline, error)) {
+            std::cerr << "dpm-bench: " << error << std::endl;
+            return 1;
+        }
+        if (baseline.scale != options.scale) {
+            std::cerr << "dpm-bench: the baseline was run at scale " << baseline.scale
+                      << ", pass --scale " << baseline.scale << " to compare with it" << std::endl;
+            return 1;
+        }
+    }
+
+    // the dpm binary and its modules default to the build directory dpm-bench was built in
+    std::error_code ec;
+    if (options.dpm_path.empty()) {
+        options.dpm_path = std::filesystem::read_symlink("/proc/self/exe", ec).parent_path() / "dpm";
+    }
+    if (options.module_path.empty()) {
+        options.module_path = options.dpm_path.parent_path() / "modules";
+    }
+    options.dpm_path = std::filesystem::absolute(options.dpm_path, ec);
+    options.module_path = std::filesystem::absolute(options.module_path, ec);
+    options.config_dir = std::filesystem::absolute(options.config_dir, ec);
+
+    if (access(options.dpm_path.c_str(), X_OK) != 0) {
+        std::cerr << "dpm-bench: dpm binary not found: " << options.dpm_path.string() << std::endl;
+        return 1;
+    }
+
+    bool created_work_dir = false;
+    if (options.work_dir.empty()) {
+        const char* tmpdir = getenv("TMPDIR");
+        std::string work_template = std::string(tmpdir && *tmpdir ? tmpdir : "/tmp") + "/dpm-bench.XXXXXX";
+        if (!mkdtemp(work_template.data())) {
+            std::cerr << "dpm-bench: failed to create a work directory: " << strerror(errno) << std::endl;
+            return 1;
+        }
+        options.work_dir = work_template;
+        created_work_dir = true;
+    } else {
+        std::filesystem::create_directories(options.work_dir, ec);
+    }
+    options.work_dir = std::filesystem::absolute(options.work_dir, ec);
+
+    std::vector<BenchShapeResult> results;
+    bool success = true;
+    for (const auto& name : options.shapes) {
+        BenchShapeResult result;
+        if (!bench_run_shape(options, *bench_find_shape(name), result)) {
+            success = false;
+        }
+        results.push_back(result);
+
+        // the next shape does not need this one's trees and packages
+        if (!keep && result.completed) {
+            std::filesystem::remove_all(options.work_dir / name, ec);
+        }
+    }
+
+    if (output_path.empty()) {
+        bench_write_json(std::cout, options, results);
+    } else {
+        std::ofstream output(output_path, std::ios::trunc);
+        bench_write_json(output, options, results);
+        if (!output) {
+            std::cerr << "dpm-bench: failed to write " << output_path << std::endl;
+            success = false;
+        }
+    }
+
+    bool regressed = false;
+    if (success && !baseline_path.empty()) {
+        regressed = !bench_compare_baseline(baseline, options, results, tolerance, std::cerr);
+    }
+
+    if (keep || !success) {
+        std::cerr << "dpm-bench: work directory kept at " << options.work_dir.string() << std::endl;
+    } else if (created_work_dir) {
+        std::filesystem::remove_all(options.work_dir, ec);
+    }
+
+    if (!success) {
+        return 1;
+    }
+    return regressed ? 2 : 0;
+}
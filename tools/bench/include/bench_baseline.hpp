@@ -0,0 +1,80 @@
+/**
+ * @file bench_baseline.hpp
+ * @brief Comparison of dpm-bench results with a recorded baseline
+ *
+ * A baseline is the JSON written by an earlier run of dpm-bench, kept with
+ * the tree or beside the CI job that runs it.  Every phase of every shape
+ * that appears in both is compared by wall time, which for the same shape
+ * and scale is the inverse of its throughput:
+ *
+ *     relative throughput = baseline wall_seconds / current wall_seconds
+ *
+ * A phase regresses when its relative throughput falls below
+ * 1 - tolerance / 100.  Phases the baseline ran in under
+ * BENCH_BASELINE_MIN_SECONDS are reported but never regress, as their
+ * timings are mostly process start-up and noise.  Shapes and phases
+ * missing from either side are reported and skipped.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
+#include "bench_runner.hpp"
+
+/**
+ * @brief Tolerance applied when none is given, in percent
+ */
+#define BENCH_BASELINE_DEFAULT_TOLERANCE 10.0
+
+/**
+ * @brief Shortest baseline wall time a phase must have to be able to regress, in seconds
+ */
+#define BENCH_BASELINE_MIN_SECONDS 0.05
+
+/**
+ * @brief Phase timings read back from a baseline
+ */
+struct BenchBaseline {
+    unsigned int scale;                                                 ///< Scale the baseline was run at
+    std::map<std::pair<std::string, std::string>, double> wall_seconds; ///< Wall time by shape and phase name
+};
+
+/**
+ * @brief Reads a baseline written by dpm-bench
+ *
+ * Only phases that succeeded are kept.
+ *
+ * @param path Baseline JSON file
+ * @param baseline Receives the timings
+ * @param error Receives a description of the problem on failure
+ * @return true if the file was read, false if it is missing or not dpm-bench results
+ */
+bool bench_load_baseline(const std::filesystem::path& path, BenchBaseline& baseline, std::string& error);
+
+/**
+ * @brief Compares results with a baseline and reports every phase compared
+ *
+ * @param baseline Baseline timings
+ * @param options Options of the current run, whose scale must match the baseline's
+ * @param results Results of the current run
+ * @param tolerance Allowed drop in throughput, in percent
+ * @param report Stream the comparison table is written to
+ * @return true if no phase regressed, false on a regression or a scale mismatch
+ */
+bool bench_compare_baseline(const BenchBaseline& baseline, const BenchOptions& options,
+                            const std::vector<BenchShapeResult>& results, double tolerance, std::ostream& report);
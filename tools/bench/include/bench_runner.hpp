@@ -0,0 +1,132 @@
+/**
+ * @file bench_runner.hpp
+ * @brief Timing of the dpm pipeline over the synthetic package trees
+ *
+ * Every phase is a separate dpm invocation, so what is measured is exactly
+ * what a user running the command would see, module loading included.  The
+ * child is left as a zombie until its counters have been read:
+ *
+ *     wall_seconds              time from spawning the command until it exited
+ *     user_seconds, system_seconds, peak_rss_kb, context switches
+ *                               from the rusage of the command
+ *     read_syscalls, write_syscalls, read_bytes, written_bytes
+ *                               syscr, syscw, rchar and wchar from /proc/<pid>/io,
+ *                               so only the read and write families of syscalls
+ *                               are counted; null when the file is unreadable
+ *
+ * With several repeats the whole pipeline is run again from a fresh output
+ * directory, and each phase keeps the run with the shortest wall time.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include "bench_shapes.hpp"
+
+/**
+ * @brief How dpm-bench was asked to run
+ */
+struct BenchOptions {
+    std::filesystem::path dpm_path;     ///< dpm binary to benchmark
+    std::filesystem::path module_path;  ///< Module directory passed to dpm with -m
+    std::filesystem::path config_dir;   ///< Configuration directory passed to dpm with -c
+    std::filesystem::path work_dir;     ///< Directory the trees and packages are written to
+    std::vector<std::string> shapes;    ///< Names of the shapes to run
+    unsigned int scale;                 ///< Multiplier applied to the file count of every shape
+    unsigned int repeat;                ///< Number of runs of the pipeline per shape
+};
+
+/**
+ * @brief Cost of one dpm command
+ */
+struct BenchMeasurement {
+    int status;                 ///< Exit status, -1 if the command could not be run or was killed
+    double wall_seconds;        ///< Elapsed time
+    double user_seconds;        ///< CPU time in user mode
+    double system_seconds;      ///< CPU time in the kernel
+    long peak_rss_kb;           ///< Peak resident set size
+    long voluntary_switches;    ///< Voluntary context switches
+    long involuntary_switches;  ///< Involuntary context switches
+    int64_t read_syscalls;      ///< read family syscalls, -1 if unavailable
+    int64_t write_syscalls;     ///< write family syscalls, -1 if unavailable
+    int64_t read_bytes;         ///< Bytes read through syscalls, -1 if unavailable
+    int64_t written_bytes;      ///< Bytes written through syscalls, -1 if unavailable
+};
+
+/**
+ * @brief Best measurement of one phase of the pipeline
+ */
+struct BenchPhaseResult {
+    std::string name;               ///< Name of the phase, e.g. "seal"
+    BenchMeasurement measurement;   ///< Run with the shortest wall time, or the failed run
+};
+
+/**
+ * @brief Results of running the pipeline over one shape
+ */
+struct BenchShapeResult {
+    std::string name;                       ///< Name of the shape
+    std::string description;                ///< Description of the shape
+    BenchTreeStats tree;                    ///< What the generated tree holds
+    uint64_t package_bytes;                 ///< Size of the sealed package, 0 if it was not sealed
+    bool completed;                         ///< Whether every phase succeeded
+    std::vector<BenchPhaseResult> phases;   ///< Phases in the order they ran
+};
+
+/**
+ * @brief Runs one dpm command and measures it
+ *
+ * The command's output goes to the log file rather than the terminal.
+ *
+ * @param options Benchmark options naming the dpm binary, modules and configuration
+ * @param arguments Arguments following the global dpm options, e.g. {"build", "seal", ...}
+ * @param log_path File the command's output is appended to
+ * @param measurement Receives the cost of the command
+ * @return true if the command ran and exited with status 0
+ */
+bool bench_run_command(const BenchOptions& options, const std::vector<std::string>& arguments,
+                       const std::filesystem::path& log_path, BenchMeasurement& measurement);
+
+/**
+ * @brief Generates a shape's tree and runs the pipeline over it
+ *
+ * The phases are stage, metadata, metadata-refresh, metadata-refresh-full,
+ * verify-stage, seal, verify-package and unseal.  A failed phase ends the
+ * shape; its output is in <work>/<shape>/dpm.log.
+ *
+ * @param options Benchmark options
+ * @param shape Shape to benchmark
+ * @param result Receives the results
+ * @return true if every phase succeeded
+ */
+bool bench_run_shape(const BenchOptions& options, const BenchShape& shape, BenchShapeResult& result);
+
+/**
+ * @brief Writes the results as one JSON document
+ *
+ * @param out Stream to write to
+ * @param options Benchmark options the results were produced with
+ * @param results Results of every shape that was run
+ */
+void bench_write_json(std::ostream& out, const BenchOptions& options, const std::vector<BenchShapeResult>& results);
@@ -0,0 +1,90 @@
+/**
+ * @file bench_shapes.hpp
+ * @brief Synthetic package source trees generated by dpm-bench
+ *
+ * Each shape stands for a kind of package whose cost is dominated by a
+ * different part of the pipeline: many tiny files stress per-file overhead
+ * such as directory walking, metadata and syscalls, a few huge files stress
+ * hashing and compression throughput, deep trees stress path handling, and
+ * the mixed shape resembles an ordinary application package.  Trees are
+ * generated from a fixed seed, so every run of a shape and scale produces
+ * the same files.
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+
+/**
+ * @brief Shapes generated when none are given
+ */
+#define BENCH_DEFAULT_SHAPES "tiny,huge,deep,mixed"
+
+/**
+ * @brief A set of similar files within a shape
+ */
+struct BenchFileGroup {
+    std::string name;           ///< Directory the group is generated under
+    uint64_t count;             ///< Number of files, multiplied by the scale
+    uint64_t min_size;          ///< Smallest file, in bytes
+    uint64_t max_size;          ///< Largest file, in bytes
+    unsigned int directories;   ///< Number of directory chains the files are spread over
+    unsigned int depth;         ///< Number of levels in each chain
+    bool compressible;          ///< Whether the data compresses like text or is random
+};
+
+/**
+ * @brief A named package source tree
+ */
+struct BenchShape {
+    std::string name;                   ///< Name used on the command line and in the results
+    std::string description;            ///< One line description
+    std::vector<BenchFileGroup> groups; ///< Files making up the tree
+};
+
+/**
+ * @brief What a generated tree holds
+ */
+struct BenchTreeStats {
+    uint64_t files;             ///< Number of regular files
+    uint64_t directories;       ///< Number of directories the files were generated in
+    uint64_t bytes;             ///< Total size of the files
+};
+
+/**
+ * @brief Gets every shape dpm-bench knows
+ *
+ * @return The shapes, in the order they are listed
+ */
+const std::vector<BenchShape>& bench_shapes();
+
+/**
+ * @brief Looks up a shape by name
+ *
+ * @param name Name of the shape
+ * @return The shape, or nullptr if there is none of that name
+ */
+const BenchShape* bench_find_shape(const std::string& name);
+
+/**
+ * @brief Generates the source tree of a shape
+ *
+ * @param shape Shape to generate
+ * @param scale Multiplier applied to the file count of every group
+ * @param root Directory to generate the tree in, created if missing
+ * @param stats Receives what was generated
+ * @return true on success, false if the tree could not be written
+ */
+bool bench_generate_tree(const BenchShape& shape, unsigned int scale, const std::filesystem::path& root,
+                         BenchTreeStats& stats);
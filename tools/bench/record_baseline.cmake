@@ -0,0 +1,24 @@
+# Records the dpm-bench baseline of one shape for its performance test, unless
+# one is already there.
+#
+# Expects BENCH (the dpm-bench binary), SHAPE, REPEAT and BASELINE (the file
+# to write) to be set with -D.
+
+if(EXISTS "${BASELINE}")
+    message(STATUS "Using the ${SHAPE} baseline ${BASELINE}")
+    return()
+endif()
+
+get_filename_component(baseline_dir "${BASELINE}" DIRECTORY)
+file(MAKE_DIRECTORY "${baseline_dir}")
+
+message(STATUS "Recording the ${SHAPE} baseline ${BASELINE}")
+execute_process(
+        COMMAND "${BENCH}" --shapes "${SHAPE}" --repeat "${REPEAT}" --output "${BASELINE}.tmp"
+        RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    file(REMOVE "${BASELINE}.tmp")
+    message(FATAL_ERROR "dpm-bench could not record the ${SHAPE} baseline (status ${result})")
+endif()
+file(RENAME "${BASELINE}.tmp" "${BASELINE}")
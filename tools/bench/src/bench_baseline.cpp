@@ -0,0 +1,282 @@
+/**
+ * @file bench_baseline.cpp
+ * @brief Implementation of the baseline comparison
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "bench_baseline.hpp"
+
+namespace {
+
+/**
+ * @brief A parsed JSON value, as much of JSON as dpm-bench writes
+ */
+struct BenchJson {
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT } type = NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<BenchJson> items;
+    std::vector<std::pair<std::string, BenchJson>> members;
+
+    const BenchJson* member(const std::string& name) const
+    {
+        for (const auto& entry : members) {
+            if (entry.first == name) {
+                return &entry.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class BenchJsonParser {
+public:
+    explicit BenchJsonParser(const std::string& text) : _text(text), _position(0) {}
+
+    bool parse(BenchJson& value)
+    {
+        return parse_value(value, 0) && (skip_blanks(), _position == _text.size());
+    }
+
+private:
+    void skip_blanks()
+    {
+        while (_position < _text.size() && isspace(static_cast<unsigned char>(_text[_position]))) {
+            _position++;
+        }
+    }
+
+    bool consume(char expected)
+    {
+        skip_blanks();
+        if (_position < _text.size() && _text[_position] == expected) {
+            _position++;
+            return true;
+        }
+        return false;
+    }
+
+    bool parse_literal(const char* literal)
+    {
+        size_t length = strlen(literal);
+        if (_text.compare(_position, length, literal) != 0) {
+            return false;
+        }
+        _position += length;
+        return true;
+    }
+
+    bool parse_string(std::string& out)
+    {
+        if (!consume('"')) {
+            return false;
+        }
+        out.clear();
+        while (_position < _text.size()) {
+            char c = _text[_position++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (_position >= _text.size()) {
+                return false;
+            }
+            char escaped = _text[_position++];
+            switch (escaped) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u':
+                    // dpm-bench only escapes control characters, which fit in one byte
+                    if (_position + 4 > _text.size()) {
+                        return false;
+                    }
+                    out += static_cast<char>(strtol(_text.substr(_position, 4).c_str(), nullptr, 16));
+                    _position += 4;
+                    break;
+                default: out += escaped; break;
+            }
+        }
+        return false;
+    }
+
+    bool parse_value(BenchJson& value, int depth)
+    {
+        if (depth > 32) {
+            return false;
+        }
+        skip_blanks();
+        if (_position >= _text.size()) {
+            return false;
+        }
+
+        char c = _text[_position];
+        if (c == '{') {
+            value.type = BenchJson::OBJECT;
+            _position++;
+            if (consume('}')) {
+                return true;
+            }
+            do {
+                std::pair<std::string, BenchJson> entry;
+                if (!parse_string(entry.first) || !consume(':') || !parse_value(entry.second, depth + 1)) {
+                    return false;
+                }
+                value.members.push_back(std::move(entry));
+            } while (consume(','));
+            return consume('}');
+        }
+        if (c == '[') {
+            value.type = BenchJson::ARRAY;
+            _position++;
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                value.items.emplace_back();
+                if (!parse_value(value.items.back(), depth + 1)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        }
+        if (c == '"') {
+            value.type = BenchJson::STRING;
+            return parse_string(value.text);
+        }
+        if (c == 't' || c == 'f') {
+            value.type = BenchJson::BOOLEAN;
+            value.boolean = c == 't';
+            return parse_literal(c == 't' ? "true" : "false");
+        }
+        if (c == 'n') {
+            value.type = BenchJson::NUL;
+            return parse_literal("null");
+        }
+
+        const char* start = _text.c_str() + _position;
+        char* end = nullptr;
+        value.type = BenchJson::NUMBER;
+        value.number = strtod(start, &end);
+        if (end == start) {
+            return false;
+        }
+        _position += static_cast<size_t>(end - start);
+        return true;
+    }
+
+    const std::string& _text;
+    size_t _position;
+};
+
+} // namespace
+
+bool bench_load_baseline(const std::filesystem::path& path, BenchBaseline& baseline, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot open " + path.string();
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+
+    BenchJson root;
+    std::string text = contents.str();
+    if (!BenchJsonParser(text).parse(root) || root.type != BenchJson::OBJECT) {
+        error = path.string() + " is not valid JSON";
+        return false;
+    }
+
+    const BenchJson* benchmark = root.member("benchmark");
+    const BenchJson* scale = root.member("scale");
+    const BenchJson* shapes = root.member("shapes");
+    if (!benchmark || benchmark->text != "dpm-bench" || !scale || scale->type != BenchJson::NUMBER ||
+        !shapes || shapes->type != BenchJson::ARRAY) {
+        error = path.string() + " does not hold dpm-bench results";
+        return false;
+    }
+
+    baseline.scale = static_cast<unsigned int>(scale->number);
+    baseline.wall_seconds.clear();
+    for (const auto& shape : shapes->items) {
+        const BenchJson* shape_name = shape.member("name");
+        const BenchJson* phases = shape.member("phases");
+        if (!shape_name || !phases) {
+            continue;
+        }
+        for (const auto& phase : phases->items) {
+            const BenchJson* phase_name = phase.member("name");
+            const BenchJson* status = phase.member("status");
+            const BenchJson* wall = phase.member("wall_seconds");
+            if (!phase_name || !status || !wall || status->number != 0 || wall->number <= 0.0) {
+                continue;
+            }
+            baseline.wall_seconds[{shape_name->text, phase_name->text}] = wall->number;
+        }
+    }
+    return true;
+}
+
+bool bench_compare_baseline(const BenchBaseline& baseline, const BenchOptions& options,
+                            const std::vector<BenchShapeResult>& results, double tolerance, std::ostream& report)
+{
+    if (baseline.scale != options.scale) {
+        report << "dpm-bench: the baseline was run at scale " << baseline.scale << ", this run at scale "
+               << options.scale << "; the results cannot be compared" << std::endl;
+        return false;
+    }
+
+    double floor = 1.0 - tolerance / 100.0;
+    bool passed = true;
+    report << std::fixed << std::setprecision(3);
+    report << "dpm-bench: comparing with the baseline, tolerance " << tolerance << "%\n";
+    report << std::left << std::setw(10) << "SHAPE" << std::setw(24) << "PHASE"
+           << std::right << std::setw(12) << "BASELINE S" << std::setw(12) << "CURRENT S"
+           << std::setw(12) << "RELATIVE" << "  RESULT\n";
+
+    for (const auto& shape : results) {
+        for (const auto& phase : shape.phases) {
+            report << std::left << std::setw(10) << shape.name << std::setw(24) << phase.name << std::right;
+
+            auto recorded = baseline.wall_seconds.find({shape.name, phase.name});
+            if (recorded == baseline.wall_seconds.end()) {
+                report << std::setw(12) << "-" << std::setw(12) << phase.measurement.wall_seconds
+                       << std::setw(12) << "-" << "  not in baseline\n";
+                continue;
+            }
+            if (phase.measurement.status != 0 || phase.measurement.wall_seconds <= 0.0) {
+                report << std::setw(12) << recorded->second << std::setw(12) << "-"
+                       << std::setw(12) << "-" << "  FAILED\n";
+                passed = false;
+                continue;
+            }
+
+            double relative = recorded->second / phase.measurement.wall_seconds;
+            const char* verdict = "ok";
+            if (relative < floor) {
+                if (recorded->second < BENCH_BASELINE_MIN_SECONDS) {
+                    verdict = "slower, too short to judge";
+                } else {
+                    verdict = "REGRESSED";
+                    passed = false;
+                }
+            }
+            report << std::setw(12) << recorded->second << std::setw(12) << phase.measurement.wall_seconds
+                   << std::setw(12) << relative << "  " << verdict << "\n";
+        }
+    }
+
+    report.flush();
+    return passed;
+}
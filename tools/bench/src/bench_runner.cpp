@@ -0,0 +1,307 @@
+/**
+ * @file bench_runner.cpp
+ * @brief Implementation of the dpm pipeline timing
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "bench_runner.hpp"
+
+extern char** environ;
+
+// reads the I/O counters of a child that has exited but not been reaped
+static void bench_read_io_counters(pid_t pid, BenchMeasurement& measurement)
+{
+    std::ifstream io("/proc/" + std::to_string(pid) + "/io");
+    std::string key;
+    int64_t value;
+    while (io >> key >> value) {
+        if (key == "syscr:") {
+            measurement.read_syscalls = value;
+        } else if (key == "syscw:") {
+            measurement.write_syscalls = value;
+        } else if (key == "rchar:") {
+            measurement.read_bytes = value;
+        } else if (key == "wchar:") {
+            measurement.written_bytes = value;
+        }
+    }
+}
+
+static double bench_seconds(const struct timeval& time)
+{
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1e6;
+}
+
+bool bench_run_command(const BenchOptions& options, const std::vector<std::string>& arguments,
+                       const std::filesystem::path& log_path, BenchMeasurement& measurement)
+{
+    measurement = { -1, 0.0, 0.0, 0.0, 0, 0, 0, -1, -1, -1, -1 };
+
+    std::vector<std::string> command = {
+        options.dpm_path.string(), "-m", options.module_path.string(), "-c", options.config_dir.string()
+    };
+    command.insert(command.end(), arguments.begin(), arguments.end());
+
+    std::vector<char*> argv;
+    for (auto& argument : command) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    int spawn_error = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (spawn_error != 0) {
+        std::cerr << "dpm-bench: failed to run " << command[0] << ": " << strerror(spawn_error) << std::endl;
+        return false;
+    }
+
+    // wait without reaping, so /proc/<pid>/io still describes the command
+    siginfo_t info;
+    while (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) != 0 && errno == EINTR) {
+    }
+    measurement.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bench_read_io_counters(pid, measurement);
+
+    int status = 0;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage) < 0) {
+        if (errno != EINTR) {
+            std::cerr << "dpm-bench: failed to wait for " << command[0] << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    measurement.status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    measurement.user_seconds = bench_seconds(usage.ru_utime);
+    measurement.system_seconds = bench_seconds(usage.ru_stime);
+    measurement.peak_rss_kb = usage.ru_maxrss;
+    measurement.voluntary_switches = usage.ru_nvcsw;
+    measurement.involuntary_switches = usage.ru_nivcsw;
+    return measurement.status == 0;
+}
+
+// finds the single stage directory a stage command wrote to the output directory
+static std::filesystem::path bench_find_stage(const std::filesystem::path& output_dir)
+{
+    for (const auto& entry : std::filesystem::directory_iterator(output_dir)) {
+        if (entry.is_directory()) {
+            return entry.path();
+        }
+    }
+    return {};
+}
+
+static std::filesystem::path bench_find_package(const std::filesystem::path& output_dir)
+{
+    for (const auto& entry : std::filesystem::directory_iterator(output_dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".dpm") {
+            return entry.path();
+        }
+    }
+    return {};
+}
+
+// keeps the faster of two runs of a phase
+static void bench_record_phase(BenchShapeResult& result, size_t index, const std::string& name,
+                               const BenchMeasurement& measurement)
+{
+    if (index == result.phases.size()) {
+        result.phases.push_back({ name, measurement });
+        return;
+    }
+
+    BenchMeasurement& best = result.phases[index].measurement;
+    if (measurement.status != 0 || measurement.wall_seconds < best.wall_seconds) {
+        best = measurement;
+    }
+}
+
+// runs the pipeline once from a fresh output directory
+static bool bench_run_pipeline(const BenchOptions& options, const BenchShape& shape,
+                               const std::filesystem::path& source_dir, const std::filesystem::path& shape_dir,
+                               BenchShapeResult& result)
+{
+    std::filesystem::path output_dir = shape_dir / "out";
+    std::filesystem::path unseal_dir = shape_dir / "unsealed";
+    std::filesystem::path log_path = shape_dir / "dpm.log";
+    std::error_code ec;
+    std::filesystem::remove_all(output_dir, ec);
+    std::filesystem::remove_all(unseal_dir, ec);
+    std::filesystem::create_directories(output_dir);
+
+    const std::string name = "bench-" + shape.name;
+    const std::string version = "1.0";
+    const std::string architecture = "x86_64";
+    size_t phase = 0;
+    BenchMeasurement measurement;
+
+    auto run = [&](const std::string& phase_name, const std::vector<std::string>& arguments) {
+        std::cerr << "dpm-bench: " << shape.name << ": " << phase_name << std::endl;
+        bool success = bench_run_command(options, arguments, log_path, measurement);
+        bench_record_phase(result, phase++, phase_name, measurement);
+        if (!success) {
+            std::cerr << "dpm-bench: " << shape.name << ": " << phase_name << " failed, see "
+                      << log_path.string() << std::endl;
+        }
+        return success;
+    };
+
+    if (!run("stage", { "build", "stage", "-o", output_dir.string(), "-c", source_dir.string(),
+                        "-n", name, "-V", version, "-a", architecture, "-f" })) {
+        return false;
+    }
+
+    std::filesystem::path stage_dir = bench_find_stage(output_dir);
+    if (stage_dir.empty()) {
+        std::cerr << "dpm-bench: " << shape.name << ": no stage directory in " << output_dir.string() << std::endl;
+        return false;
+    }
+
+    if (!run("metadata", { "build", "metadata", "-s", stage_dir.string(),
+                           "-n", name, "-V", version, "-a", architecture, "-f" }) ||
+        !run("metadata-refresh", { "build", "metadata", "-s", stage_dir.string(), "--refresh" }) ||
+        !run("metadata-refresh-full", { "build", "metadata", "-s", stage_dir.string(), "--refresh", "--full" }) ||
+        !run("verify-stage", { "verify", "checksum", "-s", stage_dir.string(), "-n" }) ||
+        !run("seal", { "build", "seal", "-s", stage_dir.string(), "-z", "-f" })) {
+        return false;
+    }
+
+    std::filesystem::path package_path = bench_find_package(output_dir);
+    if (package_path.empty()) {
+        std::cerr << "dpm-bench: " << shape.name << ": no package in " << output_dir.string() << std::endl;
+        return false;
+    }
+    result.package_bytes = std::filesystem::file_size(package_path);
+
+    return run("verify-package", { "verify", "checksum", "-p", package_path.string(), "-n" }) &&
+           run("unseal", { "build", "unseal", "-i", package_path.string(), "-o", unseal_dir.string(), "-f" });
+}
+
+bool bench_run_shape(const BenchOptions& options, const BenchShape& shape, BenchShapeResult& result)
+{
+    result = { shape.name, shape.description, { 0, 0, 0 }, 0, false, {} };
+
+    std::filesystem::path shape_dir = options.work_dir / shape.name;
+    std::filesystem::path source_dir = shape_dir / "src";
+
+    std::cerr << "dpm-bench: " << shape.name << ": generating " << shape.description << std::endl;
+    if (!bench_generate_tree(shape, options.scale, source_dir, result.tree)) {
+        return false;
+    }
+
+    try {
+        for (unsigned int run = 0; run < options.repeat; run++) {
+            if (!bench_run_pipeline(options, shape, source_dir, shape_dir, result)) {
+                return false;
+            }
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "dpm-bench: " << shape.name << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    result.completed = true;
+    return true;
+}
+
+static std::string bench_json_string(const std::string& value)
+{
+    std::ostringstream out;
+    out << '"';
+    for (unsigned char c : value) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+static std::string bench_json_counter(int64_t value)
+{
+    return value < 0 ? "null" : std::to_string(value);
+}
+
+static double bench_rate(double amount, double seconds)
+{
+    return seconds > 0.0 ? amount / seconds : 0.0;
+}
+
+void bench_write_json(std::ostream& out, const BenchOptions& options, const std::vector<BenchShapeResult>& results)
+{
+    char timestamp[32];
+    time_t now = time(nullptr);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+    struct utsname host;
+    std::string kernel = uname(&host) == 0 ? std::string(host.release) : "";
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"benchmark\": \"dpm-bench\",\n";
+    out << "  \"format\": 1,\n";
+    out << "  \"timestamp\": " << bench_json_string(timestamp) << ",\n";
+    out << "  \"dpm\": " << bench_json_string(options.dpm_path.string()) << ",\n";
+    out << "  \"host\": { \"cpus\": " << sysconf(_SC_NPROCESSORS_ONLN) << ", \"kernel\": "
+        << bench_json_string(kernel) << " },\n";
+    out << "  \"scale\": " << options.scale << ",\n";
+    out << "  \"repeat\": " << options.repeat << ",\n";
+    out << "  \"shapes\": [";
+
+    for (size_t s = 0; s < results.size(); s++) {
+        const BenchShapeResult& shape = results[s];
+        out << (s > 0 ? "," : "") << "\n    {\n";
+        out << "      \"name\": " << bench_json_string(shape.name) << ",\n";
+        out << "      \"description\": " << bench_json_string(shape.description) << ",\n";
+        out << "      \"files\": " << shape.tree.files << ",\n";
+        out << "      \"directories\": " << shape.tree.directories << ",\n";
+        out << "      \"bytes\": " << shape.tree.bytes << ",\n";
+        out << "      \"package_bytes\": " << shape.package_bytes << ",\n";
+        out << "      \"completed\": " << (shape.completed ? "true" : "false") << ",\n";
+        out << "      \"phases\": [";
+
+        for (size_t p = 0; p < shape.phases.size(); p++) {
+            const BenchPhaseResult& phase = shape.phases[p];
+            const BenchMeasurement& m = phase.measurement;
+            out << (p > 0 ? "," : "") << "\n        { ";
+            out << "\"name\": " << bench_json_string(phase.name) << ", ";
+            out << "\"status\": " << m.status << ", ";
+            out << "\"wall_seconds\": " << m.wall_seconds << ", ";
+            out << "\"user_seconds\": " << m.user_seconds << ", ";
+            out << "\"system_seconds\": " << m.system_seconds << ", ";
+            out << "\"mb_per_second\": " << bench_rate(static_cast<double>(shape.tree.bytes) / 1e6, m.wall_seconds) << ", ";
+            out << "\"files_per_second\": " << bench_rate(static_cast<double>(shape.tree.files), m.wall_seconds) << ", ";
+            out << "\"peak_rss_kb\": " << m.peak_rss_kb << ", ";
+            out << "\"read_syscalls\": " << bench_json_counter(m.read_syscalls) << ", ";
+            out << "\"write_syscalls\": " << bench_json_counter(m.write_syscalls) << ", ";
+            out << "\"read_bytes\": " << bench_json_counter(m.read_bytes) << ", ";
+            out << "\"written_bytes\": " << bench_json_counter(m.written_bytes) << ", ";
+            out << "\"voluntary_context_switches\": " << m.voluntary_switches << ", ";
+            out << "\"involuntary_context_switches\": " << m.involuntary_switches << " }";
+        }
+
+        out << (shape.phases.empty() ? "]\n" : "\n      ]\n");
+        out << "    }";
+    }
+
+    out << (results.empty() ? "]\n" : "\n  ]\n");
+    out << "}\n";
+}
@@ -0,0 +1,130 @@
+/**
+ * @file bench_shapes.cpp
+ * @brief Implementation of the synthetic package source trees
+ *
+ * @copyright Copyright (c) 2025 SILO GROUP LLC
+ * @author Chris Punches <chris.punches@silogroup.org>
+ *
+ * Part of the Dark Horse Linux Package Manager (DPM)
+ */
+
+#include "bench_shapes.hpp"
+
+// Size of the buffer file data is generated into
+static const size_t BENCH_WRITE_BLOCK_SIZE = 1024 * 1024;
+
+const std::vector<BenchShape>& bench_shapes()
+{
+    static const std::vector<BenchShape> shapes = {
+        { "tiny", "many tiny files spread over a wide tree", {
+            { "usr/share/tiny", 20000, 64, 2048, 200, 1, true },
+        } },
+        { "huge", "a few huge files", {
+            { "usr/lib/huge", 4, 64 * 1024 * 1024, 64 * 1024 * 1024, 1, 1, false },
+        } },
+        { "deep", "small files in deeply nested directories", {
+            { "usr/share/deep", 4000, 512, 8192, 8, 64, true },
+        } },
+        { "mixed", "an application with small, medium and large files", {
+            { "usr/share/doc", 5000, 128, 4096, 50, 3, true },
+            { "usr/lib", 500, 16 * 1024, 1024 * 1024, 10, 2, false },
+            { "usr/bin", 2, 32 * 1024 * 1024, 32 * 1024 * 1024, 1, 1, false },
+        } },
+    };
+    return shapes;
+}
+
+const BenchShape* bench_find_shape(const std::string& name)
+{
+    for (const auto& shape : bench_shapes()) {
+        if (shape.name == name) {
+            return &shape;
+        }
+    }
+    return nullptr;
+}
+
+// fills a buffer with data that compresses roughly like text, or not at all
+static void bench_fill(std::mt19937_64& random, std::vector<char>& buffer, size_t size, bool compressible)
+{
+    static const char alphabet[] = "etaoinshrdlu \n";
+    buffer.resize(size);
+
+    size_t i = 0;
+    while (i < size) {
+        uint64_t value = random();
+        for (int byte = 0; byte < 8 && i < size; byte++, i++) {
+            unsigned char bits = static_cast<unsigned char>(value >> (byte * 8));
+            buffer[i] = compressible ? alphabet[bits % (sizeof(alphabet) - 1)] : static_cast<char>(bits);
+        }
+    }
+}
+
+static bool bench_write_file(const std::filesystem::path& path, uint64_t size, bool compressible,
+                             std::mt19937_64& random, std::vector<char>& buffer)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "dpm-bench: failed to create " << path.string() << std::endl;
+        return false;
+    }
+
+    uint64_t remaining = size;
+    while (remaining > 0) {
+        size_t block = static_cast<size_t>(std::min<uint64_t>(remaining, BENCH_WRITE_BLOCK_SIZE));
+        bench_fill(random, buffer, block, compressible);
+        file.write(buffer.data(), static_cast<std::streamsize>(block));
+        remaining -= block;
+    }
+
+    if (!file) {
+        std::cerr << "dpm-bench: failed to write " << path.string() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool bench_generate_tree(const BenchShape& shape, unsigned int scale, const std::filesystem::path& root,
+                         BenchTreeStats& stats)
+{
+    stats = { 0, 0, 0 };
+    std::mt19937_64 random(0x64706d2d62656e63ULL);
+    std::vector<char> buffer;
+
+    try {
+        std::filesystem::create_directories(root);
+
+        for (const auto& group : shape.groups) {
+            uint64_t count = group.count * (scale > 0 ? scale : 1);
+            unsigned int directories = group.directories > 0 ? group.directories : 1;
+            unsigned int depth = group.depth > 0 ? group.depth : 1;
+            std::uniform_int_distribution<uint64_t> sizes(group.min_size, group.max_size);
+
+            for (uint64_t i = 0; i < count; i++) {
+                // file i goes in chain i % directories, at a level that cycles through the depth
+                std::filesystem::path directory = root / group.name / ("d" + std::to_string(i % directories));
+                uint64_t level = (i / directories) % depth;
+                for (uint64_t l = 1; l <= level; l++) {
+                    directory /= "l" + std::to_string(l);
+                }
+
+                if (std::filesystem::create_directories(directory)) {
+                    stats.directories++;
+                }
+
+                uint64_t size = sizes(random);
+                if (!bench_write_file(directory / ("f" + std::to_string(i)), size, group.compressible,
+                                      random, buffer)) {
+                    return false;
+                }
+                stats.files++;
+                stats.bytes += size;
+            }
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "dpm-bench: failed to generate the " << shape.name << " tree: " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}